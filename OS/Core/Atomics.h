@@ -96,6 +96,12 @@ static inline uint64_t tfrg_atomic64_store_release(tfrg_atomic64_t* pVar, uint64
 	return tfrg_atomic64_store_relaxed(pVar, val);
 }
 
+static inline uint64_t tfrg_atomic64_add_release(tfrg_atomic64_t* pVar, int64_t val)
+{
+	tfrg_memorybarrier_release();
+	return tfrg_atomic64_add_relaxed(pVar, val);
+}
+
 static inline uint64_t tfrg_atomic64_max_relaxed(tfrg_atomic64_t* dst, uint64_t val)
 {
 	uint64_t prev_val = val;
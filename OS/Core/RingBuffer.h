@@ -28,6 +28,7 @@
 #include "../../Renderer/Include/IRenderer.h"
 #include "../../Renderer/Include/IResourceLoader.h"
 #include "../Interfaces/ILog.h"
+#include "Atomics.h"
 
 #define IMEMORY_FROM_HEADER
 #include "../../OS/Interfaces/IMemory.h"
@@ -104,6 +105,7 @@ static inline void resetGPURingBuffer(GPURingBuffer* pRingBuffer)
 	pRingBuffer->mCurrentBufferOffset = 0;
 }
 
+// Wraps around without knowing whether the GPU still reads the old data, see TransientBuffer for per-frame data
 static inline GPURingBufferOffset getGPURingBufferOffset(GPURingBuffer* pRingBuffer, uint32_t memoryRequirement, uint32_t alignment = 0)
 {
 	uint32_t alignedSize = round_up(memoryRequirement, alignment ? alignment : pRingBuffer->mBufferAlignment);
@@ -124,3 +126,424 @@ static inline GPURingBufferOffset getGPURingBufferOffset(GPURingBuffer* pRingBuf
 
 	return ret;
 }
+
+/************************************************************************/
+/* TRANSIENT BUFFER MANAGEMENT										  */
+/************************************************************************/
+// Linear allocator for data the CPU writes once and the GPU reads in the same frame (uniforms, dynamic vertices / indices).
+// Unlike GPURingBuffer nothing is overwritten while the GPU may still read it: every frame owns the pages it allocated from
+// and they are only reused once the fence of that frame has signaled. If a frame runs out of pages more are created.
+// Every slot (see CmdRingDesc) bumps through its own chunk without synchronization. Chunks are claimed from the current page
+// with a single atomic add, only switching to the next page takes a lock.
+typedef struct TransientBufferDesc
+{
+	/// Usage of the pages (DESCRIPTOR_TYPE_UNIFORM_BUFFER, DESCRIPTOR_TYPE_VERTEX_BUFFER, ...)
+	DescriptorType mDescriptors;
+	/// Size of the persistently mapped pages chunks are carved from
+	uint64_t mPageSize;
+	/// Size a slot claims from a page at once. Larger allocations get a chunk of their own
+	uint32_t mChunkSize;
+	/// Number of frames in flight
+	uint32_t mFrameCount;
+	/// Number of slots that can allocate concurrently
+	uint32_t mSlotCount;
+	/// Number of pages created up front
+	uint32_t mInitialPageCount;
+} TransientBufferDesc;
+
+typedef struct TransientBufferPage
+{
+	Buffer* pBuffer;
+	uint64_t mSize;
+	/// Start of the next chunk. Can go past mSize when several slots find the page full at the same time
+	tfrg_atomic64_t mOffset;
+	struct TransientBufferPage* pNext;
+} TransientBufferPage;
+
+typedef struct DEFINE_ALIGNED(TransientBufferSlot, 64)
+{
+	TransientBufferPage* pPage;
+	uint64_t mOffset;
+	uint64_t mEnd;
+	uint64_t mBytesAllocated;
+} TransientBufferSlot;
+
+typedef struct TransientBufferFrame
+{
+	Fence* pFence;
+	/// Submission of pFence that ends the frame, see vk_isFenceSubmitComplete
+	uint32_t mSubmitCount;
+	TransientBufferPage* pPages;
+} TransientBufferFrame;
+
+typedef struct TransientBufferStats
+{
+	/// Bytes allocated by the last finished frame and the maximum over all frames
+	uint64_t mFrameBytes;
+	uint64_t mPeakFrameBytes;
+	/// Page memory used by the last finished frame and the maximum over all frames
+	uint64_t mFramePageBytes;
+	uint64_t mPeakFramePageBytes;
+	/// Memory of all pages, in use or free
+	uint64_t mPageBytes;
+	uint32_t mPageCount;
+	/// Pages created after addTransientBuffer because no free page was left
+	uint32_t mOverflowPageCount;
+} TransientBufferStats;
+
+typedef struct TransientBuffer
+{
+	Renderer* pRenderer;
+	TransientBufferDesc mDesc;
+	uint32_t mAlignment;
+	uint32_t mFrameIndex;
+	tfrg_atomicptr_t mCurrentPage;
+	Mutex mPageMutex;
+	TransientBufferPage* pFreePages;
+	TransientBufferFrame* pFrames;
+	TransientBufferSlot* pSlots;
+	/// Counters behind getTransientBufferStats, atomic so the stats can be read while other threads allocate
+	tfrg_atomic64_t mFrameBytes;
+	tfrg_atomic64_t mPeakFrameBytes;
+	tfrg_atomic64_t mFramePageBytes;
+	tfrg_atomic64_t mPeakFramePageBytes;
+	tfrg_atomic64_t mPageBytes;
+	tfrg_atomic32_t mPageCount;
+	tfrg_atomic32_t mOverflowPageCount;
+} TransientBuffer;
+
+typedef struct TransientAllocation
+{
+	Buffer* pBuffer;
+	uint64_t mOffset;
+	/// CPU address of mOffset
+	void* pData;
+} TransientAllocation;
+
+static inline TransientBufferPage* addTransientBufferPage(TransientBuffer* pTransientBuffer, uint64_t size)
+{
+	TransientBufferPage* pPage = (TransientBufferPage*)tf_calloc(1, sizeof(TransientBufferPage));
+	pPage->mSize = size;
+
+	BufferDesc bufferDesc = {};
+	bufferDesc.mDescriptors = pTransientBuffer->mDesc.mDescriptors;
+	bufferDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+	bufferDesc.mFlags = BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT | BUFFER_CREATION_FLAG_NO_DESCRIPTOR_VIEW_CREATION;
+	bufferDesc.mSize = size;
+	bufferDesc.pName = "TransientBufferPage";
+	vk_addBuffer(pTransientBuffer->pRenderer, &bufferDesc, &pPage->pBuffer);
+	ASSERT(pPage->pBuffer->pCpuMappedAddress);
+
+	tfrg_atomic32_add_relaxed(&pTransientBuffer->mPageCount, 1);
+	tfrg_atomic64_add_relaxed(&pTransientBuffer->mPageBytes, size);
+	return pPage;
+}
+
+static inline void removeTransientBufferPages(TransientBuffer* pTransientBuffer, TransientBufferPage* pPage)
+{
+	while (pPage)
+	{
+		TransientBufferPage* pNext = pPage->pNext;
+		vk_removeBuffer(pTransientBuffer->pRenderer, pPage->pBuffer);
+		tf_free(pPage);
+		pPage = pNext;
+	}
+}
+
+static inline void addTransientBuffer(Renderer* pRenderer, const TransientBufferDesc* pDesc, TransientBuffer** ppTransientBuffer)
+{
+	ASSERT(pDesc->mPageSize && pDesc->mChunkSize && pDesc->mFrameCount && pDesc->mSlotCount);
+
+	TransientBuffer* pTransientBuffer = (TransientBuffer*)tf_calloc(1, sizeof(TransientBuffer));
+	pTransientBuffer->pRenderer = pRenderer;
+	pTransientBuffer->mDesc = *pDesc;
+	pTransientBuffer->mAlignment = (pDesc->mDescriptors & DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+									   ? max((uint32_t)pRenderer->pActiveGpuSettings->mUniformBufferAlignment, (uint32_t)sizeof(float[4]))
+									   : (uint32_t)sizeof(float[4]);
+	pTransientBuffer->mDesc.mChunkSize = (uint32_t)round_up_64(pDesc->mChunkSize, pTransientBuffer->mAlignment);
+	pTransientBuffer->mDesc.mPageSize = round_up_64(max(pDesc->mPageSize, (uint64_t)pTransientBuffer->mDesc.mChunkSize), pTransientBuffer->mAlignment);
+	// The first beginTransientBufferFrame moves to frame 0
+	pTransientBuffer->mFrameIndex = pDesc->mFrameCount - 1;
+	pTransientBuffer->pFrames = (TransientBufferFrame*)tf_calloc(pDesc->mFrameCount, sizeof(TransientBufferFrame));
+	pTransientBuffer->pSlots = (TransientBufferSlot*)tf_calloc_memalign(pDesc->mSlotCount, alignof(TransientBufferSlot), sizeof(TransientBufferSlot));
+	initMutex(&pTransientBuffer->mPageMutex);
+
+	for (uint32_t i = 0; i < pDesc->mInitialPageCount; ++i)
+	{
+		TransientBufferPage* pPage = addTransientBufferPage(pTransientBuffer, pTransientBuffer->mDesc.mPageSize);
+		pPage->pNext = pTransientBuffer->pFreePages;
+		pTransientBuffer->pFreePages = pPage;
+	}
+
+	*ppTransientBuffer = pTransientBuffer;
+}
+
+// The GPU must be done with every frame that allocated from the buffer
+static inline void removeTransientBuffer(TransientBuffer* pTransientBuffer)
+{
+	for (uint32_t i = 0; i < pTransientBuffer->mDesc.mFrameCount; ++i)
+	{
+		removeTransientBufferPages(pTransientBuffer, pTransientBuffer->pFrames[i].pPages);
+	}
+	removeTransientBufferPages(pTransientBuffer, pTransientBuffer->pFreePages);
+
+	destroyMutex(&pTransientBuffer->mPageMutex);
+	tf_free(pTransientBuffer->pSlots);
+	tf_free(pTransientBuffer->pFrames);
+	tf_free(pTransientBuffer);
+}
+
+static inline void retireTransientBufferFrame(TransientBuffer* pTransientBuffer, TransientBufferFrame* pFrame)
+{
+	while (pFrame->pPages)
+	{
+		TransientBufferPage* pPage = pFrame->pPages;
+		pFrame->pPages = pPage->pNext;
+		tfrg_atomic64_store_relaxed(&pPage->mOffset, 0);
+		pPage->pNext = pTransientBuffer->pFreePages;
+		pTransientBuffer->pFreePages = pPage;
+	}
+	pFrame->pFence = NULL;
+}
+
+// Starts the next frame. pFence is the fence the frame's one fenced submission will signal; if it is NULL the caller guarantees that
+// the GPU is done with the frame that allocated mFrameCount frames ago.
+// Fences are only observed through vk_isFenceSubmitComplete, which leaves their state to the application's own frame loop.
+// Must not be called while any slot is allocating.
+static inline void beginTransientBufferFrame(TransientBuffer* pTransientBuffer, Fence* pFence)
+{
+	Renderer* pRenderer = pTransientBuffer->pRenderer;
+	TransientBufferFrame* pPrevFrame = &pTransientBuffer->pFrames[pTransientBuffer->mFrameIndex];
+
+	// High-water marks of the frame that just finished recording
+	uint64_t frameBytes = 0;
+	for (uint32_t slot = 0; slot < pTransientBuffer->mDesc.mSlotCount; ++slot)
+	{
+		frameBytes += pTransientBuffer->pSlots[slot].mBytesAllocated;
+		memset(&pTransientBuffer->pSlots[slot], 0, sizeof(TransientBufferSlot));
+	}
+	uint64_t framePageBytes = 0;
+	for (TransientBufferPage* pPage = pPrevFrame->pPages; pPage; pPage = pPage->pNext)
+	{
+		framePageBytes += pPage->mSize;
+	}
+	tfrg_atomic64_store_relaxed(&pTransientBuffer->mFrameBytes, frameBytes);
+	tfrg_atomic64_max_relaxed(&pTransientBuffer->mPeakFrameBytes, frameBytes);
+	tfrg_atomic64_store_relaxed(&pTransientBuffer->mFramePageBytes, framePageBytes);
+	tfrg_atomic64_max_relaxed(&pTransientBuffer->mPeakFramePageBytes, framePageBytes);
+
+	pTransientBuffer->mFrameIndex = (pTransientBuffer->mFrameIndex + 1) % pTransientBuffer->mDesc.mFrameCount;
+
+	// Take back the pages of frames that already completed so the new frame does not need to create any
+	for (uint32_t i = 0; i < pTransientBuffer->mDesc.mFrameCount; ++i)
+	{
+		TransientBufferFrame* pFrame = &pTransientBuffer->pFrames[i];
+		if (i == pTransientBuffer->mFrameIndex)
+		{
+			// Waiting resets the fence, the application's vk_getFenceStatus then reports it as not submitted and doesn't wait either
+			if (pFrame->pFence && !vk_isFenceSubmitComplete(pRenderer, pFrame->pFence, pFrame->mSubmitCount))
+			{
+				vk_waitForFences(pRenderer, 1, &pFrame->pFence);
+			}
+			retireTransientBufferFrame(pTransientBuffer, pFrame);
+		}
+		else if (pFrame->pFence && pFrame->pPages && vk_isFenceSubmitComplete(pRenderer, pFrame->pFence, pFrame->mSubmitCount))
+		{
+			retireTransientBufferFrame(pTransientBuffer, pFrame);
+		}
+	}
+
+	TransientBufferFrame* pFrame = &pTransientBuffer->pFrames[pTransientBuffer->mFrameIndex];
+	pFrame->pFence = pFence;
+	pFrame->mSubmitCount = pFence ? vk_getFenceSubmitCount(pFence) + 1 : 0;
+	tfrg_atomicptr_store_release(&pTransientBuffer->mCurrentPage, 0);
+}
+
+static inline void claimTransientBufferChunk(TransientBuffer* pTransientBuffer, TransientBufferSlot* pSlot, uint64_t minSize)
+{
+	const uint64_t chunkSize = round_up_64(max((uint64_t)pTransientBuffer->mDesc.mChunkSize, minSize), pTransientBuffer->mAlignment);
+
+	for (;;)
+	{
+		TransientBufferPage* pPage = (TransientBufferPage*)tfrg_atomicptr_load_acquire(&pTransientBuffer->mCurrentPage);
+		if (pPage)
+		{
+			const uint64_t offset = tfrg_atomic64_add_relaxed(&pPage->mOffset, chunkSize);
+			if (offset + chunkSize <= pPage->mSize)
+			{
+				pSlot->pPage = pPage;
+				pSlot->mOffset = offset;
+				pSlot->mEnd = offset + chunkSize;
+				return;
+			}
+		}
+
+		// Page is full: the first slot to get here installs the next one, the others retry on it
+		acquireMutex(&pTransientBuffer->mPageMutex);
+		if ((TransientBufferPage*)tfrg_atomicptr_load_relaxed(&pTransientBuffer->mCurrentPage) == pPage)
+		{
+			TransientBufferPage** ppFree = &pTransientBuffer->pFreePages;
+			while (*ppFree && (*ppFree)->mSize < chunkSize)
+			{
+				ppFree = &(*ppFree)->pNext;
+			}
+
+			TransientBufferPage* pNewPage = *ppFree;
+			if (pNewPage)
+			{
+				*ppFree = pNewPage->pNext;
+			}
+			else
+			{
+				pNewPage = addTransientBufferPage(pTransientBuffer, max(pTransientBuffer->mDesc.mPageSize, chunkSize));
+				tfrg_atomic32_add_relaxed(&pTransientBuffer->mOverflowPageCount, 1);
+			}
+
+			TransientBufferFrame* pFrame = &pTransientBuffer->pFrames[pTransientBuffer->mFrameIndex];
+			pNewPage->pNext = pFrame->pPages;
+			pFrame->pPages = pNewPage;
+			tfrg_atomicptr_store_release(&pTransientBuffer->mCurrentPage, (uintptr_t)pNewPage);
+		}
+		releaseMutex(&pTransientBuffer->mPageMutex);
+	}
+}
+
+// Only one thread may allocate from a slot at a time, different slots can allocate concurrently.
+// The memory stays valid until the fence passed to beginTransientBufferFrame for this frame has signaled.
+static inline TransientAllocation allocTransientBuffer(TransientBuffer* pTransientBuffer, uint32_t slot, uint64_t size, uint32_t alignment = 0)
+{
+	ASSERT(slot < pTransientBuffer->mDesc.mSlotCount);
+	ASSERT(!alignment || !(alignment & (alignment - 1)));
+
+	TransientBufferSlot* pSlot = &pTransientBuffer->pSlots[slot];
+	const uint64_t align = max((uint64_t)alignment, (uint64_t)pTransientBuffer->mAlignment);
+	uint64_t offset = round_up_64(pSlot->mOffset, align);
+	if (!pSlot->pPage || offset + size > pSlot->mEnd)
+	{
+		// Chunks start at mAlignment, the extra bytes cover a stricter alignment
+		claimTransientBufferChunk(pTransientBuffer, pSlot, size + align - pTransientBuffer->mAlignment);
+		offset = round_up_64(pSlot->mOffset, align);
+	}
+
+	pSlot->mOffset = offset + size;
+	pSlot->mBytesAllocated += size;
+
+	TransientAllocation ret = { pSlot->pPage->pBuffer, offset, (uint8_t*)pSlot->pPage->pBuffer->pCpuMappedAddress + offset };
+	return ret;
+}
+
+// Can be called from any thread
+static inline void getTransientBufferStats(TransientBuffer* pTransientBuffer, TransientBufferStats* pStats)
+{
+	pStats->mFrameBytes = tfrg_atomic64_load_relaxed(&pTransientBuffer->mFrameBytes);
+	pStats->mPeakFrameBytes = tfrg_atomic64_load_relaxed(&pTransientBuffer->mPeakFrameBytes);
+	pStats->mFramePageBytes = tfrg_atomic64_load_relaxed(&pTransientBuffer->mFramePageBytes);
+	pStats->mPeakFramePageBytes = tfrg_atomic64_load_relaxed(&pTransientBuffer->mPeakFramePageBytes);
+	pStats->mPageBytes = tfrg_atomic64_load_relaxed(&pTransientBuffer->mPageBytes);
+	pStats->mPageCount = tfrg_atomic32_load_relaxed(&pTransientBuffer->mPageCount);
+	pStats->mOverflowPageCount = tfrg_atomic32_load_relaxed(&pTransientBuffer->mOverflowPageCount);
+}
+
+/************************************************************************/
+/* COMMAND RING MANAGEMENT											  */
+/************************************************************************/
+// One CmdPool per frame in flight and per recording slot. A slot is the unit of work recorded by a single thread at a time
+// (for example one chunk of a parallel for), so slots can be recorded concurrently without any locking.
+typedef struct CmdRingDesc
+{
+	Queue* pQueue;
+	/// Number of frames in flight
+	uint32_t mPoolCount;
+	/// Number of slots that can be recorded concurrently
+	uint32_t mSlotCount;
+	/// Number of Cmds allocated from every pool
+	uint32_t mCmdPerPoolCount;
+	/// Allocate secondary Cmds (vk_beginSecondaryCmd / vk_cmdExecuteCmds)
+	bool mSecondary;
+} CmdRingDesc;
+
+typedef struct CmdRing
+{
+	CmdPool** ppCmdPools;
+	Cmd** ppCmds;
+	uint32_t mPoolCount;
+	uint32_t mSlotCount;
+	uint32_t mCmdPerPoolCount;
+} CmdRing;
+
+typedef struct CmdRingElement
+{
+	CmdPool* pCmdPool;
+	Cmd** pCmds;
+} CmdRingElement;
+
+static inline void addCmdRing(Renderer* pRenderer, const CmdRingDesc* pDesc, CmdRing** ppCmdRing)
+{
+	ASSERT(pDesc->pQueue);
+	ASSERT(pDesc->mPoolCount && pDesc->mSlotCount && pDesc->mCmdPerPoolCount);
+
+	const uint32_t poolCount = pDesc->mPoolCount * pDesc->mSlotCount;
+	const uint32_t cmdCount = poolCount * pDesc->mCmdPerPoolCount;
+
+	CmdRing* pCmdRing = (CmdRing*)tf_calloc(1, sizeof(CmdRing) + poolCount * sizeof(CmdPool*) + cmdCount * sizeof(Cmd*));
+	pCmdRing->ppCmdPools = (CmdPool**)(pCmdRing + 1);
+	pCmdRing->ppCmds = (Cmd**)(pCmdRing->ppCmdPools + poolCount);
+	pCmdRing->mPoolCount = pDesc->mPoolCount;
+	pCmdRing->mSlotCount = pDesc->mSlotCount;
+	pCmdRing->mCmdPerPoolCount = pDesc->mCmdPerPoolCount;
+
+	CmdPoolDesc poolDesc = {};
+	poolDesc.pQueue = pDesc->pQueue;
+	poolDesc.mTransient = true;
+
+	for (uint32_t pool = 0; pool < poolCount; ++pool)
+	{
+		vk_addCmdPool(pRenderer, &poolDesc, &pCmdRing->ppCmdPools[pool]);
+
+		CmdDesc cmdDesc = {};
+		cmdDesc.pPool = pCmdRing->ppCmdPools[pool];
+		cmdDesc.mSecondary = pDesc->mSecondary;
+		for (uint32_t cmd = 0; cmd < pDesc->mCmdPerPoolCount; ++cmd)
+		{
+			vk_addCmd(pRenderer, &cmdDesc, &pCmdRing->ppCmds[pool * pDesc->mCmdPerPoolCount + cmd]);
+		}
+	}
+
+	*ppCmdRing = pCmdRing;
+}
+
+static inline void removeCmdRing(Renderer* pRenderer, CmdRing* pCmdRing)
+{
+	const uint32_t poolCount = pCmdRing->mPoolCount * pCmdRing->mSlotCount;
+	for (uint32_t pool = 0; pool < poolCount; ++pool)
+	{
+		for (uint32_t cmd = 0; cmd < pCmdRing->mCmdPerPoolCount; ++cmd)
+		{
+			vk_removeCmd(pRenderer, pCmdRing->ppCmds[pool * pCmdRing->mCmdPerPoolCount + cmd]);
+		}
+		vk_removeCmdPool(pRenderer, pCmdRing->ppCmdPools[pool]);
+	}
+
+	tf_free(pCmdRing);
+}
+
+// Resets the pools of all slots of a frame. The fence of the last submission of that frame must have completed
+static inline void resetCmdRing(Renderer* pRenderer, CmdRing* pCmdRing, uint32_t frameIndex)
+{
+	ASSERT(frameIndex < pCmdRing->mPoolCount);
+
+	for (uint32_t slot = 0; slot < pCmdRing->mSlotCount; ++slot)
+	{
+		vk_resetCmdPool(pRenderer, pCmdRing->ppCmdPools[frameIndex * pCmdRing->mSlotCount + slot]);
+	}
+}
+
+static inline CmdRingElement getCmdRingElement(CmdRing* pCmdRing, uint32_t frameIndex, uint32_t slot)
+{
+	ASSERT(frameIndex < pCmdRing->mPoolCount);
+	ASSERT(slot < pCmdRing->mSlotCount);
+
+	const uint32_t pool = frameIndex * pCmdRing->mSlotCount + slot;
+	CmdRingElement ret = { pCmdRing->ppCmdPools[pool], &pCmdRing->ppCmds[pool * pCmdRing->mCmdPerPoolCount] };
+	return ret;
+}
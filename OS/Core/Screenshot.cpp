@@ -88,6 +88,8 @@ void mapRenderTarget(
 		copy.imageExtent.width = width;
 		copy.imageExtent.height = height;
 		copy.imageExtent.depth = depth;
+		// The copy is recorded directly, so the queued transition has to be recorded first
+		vk_cmdFlushBarriers(pCmd);
 		vkCmdCopyImageToBuffer(
 			pCmd->mVulkan.pVkCmdBuf, pRenderTarget->pTexture->mVulkan.pVkImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
 			buffer->mVulkan.pVkBuffer, 1, &copy);
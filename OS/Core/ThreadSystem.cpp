@@ -27,174 +27,415 @@
 
 #include "../Math/MathTypes.h"
 
+#include "Atomics.h"
 #include "ThreadSystem.h"
 #include "../Interfaces/IMemory.h"
 
 struct ThreadedTask
 {
-	TaskFunc  mTask;
+	union
+	{
+		TaskFunc      mTask;
+		RangeTaskFunc mRangeTask;
+	};
 	void* mUser;
 	uintptr_t mStart;
 	uintptr_t mEnd;
+	// Zero for per-index tasks. Otherwise [mStart, mEnd) is taken out of the queue as a whole and split until it is not larger than this
+	uintptr_t      mGrainSize;
+	ThreadCounter* pCounter;
 };
 
-struct ThreadSystem
+struct ThreadSystem;
+
+// Growable ring of tasks owned by one worker thread.
+// The owner pushes and pops at the tail, other threads steal from the head.
+struct ALIGNAS(64) ThreadQueue
 {
-	ThreadHandle      mThread[MAX_LOAD_THREADS];
-	ThreadedTask      mLoadTask[MAX_SYSTEM_TASKS];
-	uint32_t          mBegin, mEnd;
-	ConditionVariable mQueueCond;
 	Mutex             mQueueMutex;
+	ThreadedTask*     pTasks;
+	uint32_t          mCapacity;    // Always a power of two
+	volatile uint32_t mHead;
+	volatile uint32_t mTail;
+	ThreadSystem*     pThreadSystem;
+};
+
+struct ThreadSystem
+{
+	ThreadQueue       mQueues[MAX_SYSTEM_THREADS];
+	ThreadHandle      mThread[MAX_SYSTEM_THREADS];
+	// Number of task indices waiting in the queues
+	tfrg_atomic64_t   mNumQueuedTasks;
+	// Number of task indices which have not finished executing yet (queued + running)
+	tfrg_atomic64_t   mNumPendingTasks;
+	tfrg_atomic32_t   mNumSleepingLoaders;
+	// Number of threads blocked in waitThreadCounter
+	tfrg_atomic32_t   mNumCounterWaiters;
+	tfrg_atomic32_t   mNextQueue;
+	Mutex             mSleepMutex;
+	ConditionVariable mSleepCond;
+	Mutex             mIdleMutex;
 	ConditionVariable mIdleCond;
+	Mutex             mCounterMutex;
+	ConditionVariable mCounterCond;
 	uint32_t          mNumLoaders;
-	uint32_t          mNumIdleLoaders;
 	volatile bool     mRun;
 };
 
-bool assistThreadSystemTasks(ThreadSystem* pThreadSystem, uint32_t* pIds, size_t count)
+// Queue owned by the calling thread, only valid when the calling thread is a worker of pCurrentThreadSystem
+static THREAD_LOCAL ThreadSystem* pCurrentThreadSystem = NULL;
+static THREAD_LOCAL uint32_t      gCurrentQueueIndex = 0;
+
+static void initThreadQueue(ThreadSystem* pThreadSystem, ThreadQueue* pQueue)
 {
-	acquireMutex(&pThreadSystem->mQueueMutex);
-	if (pThreadSystem->mBegin == pThreadSystem->mEnd)
+	initMutex(&pQueue->mQueueMutex);
+	pQueue->pTasks = (ThreadedTask*)tf_malloc(MAX_SYSTEM_TASKS * sizeof(ThreadedTask));
+	pQueue->mCapacity = MAX_SYSTEM_TASKS;
+	pQueue->mHead = 0;
+	pQueue->mTail = 0;
+	pQueue->pThreadSystem = pThreadSystem;
+}
+
+static void exitThreadQueue(ThreadQueue* pQueue)
+{
+	tf_free(pQueue->pTasks);
+	destroyMutex(&pQueue->mQueueMutex);
+}
+
+// Must be called with the queue mutex held
+static void growThreadQueue(ThreadQueue* pQueue)
+{
+	const uint32_t oldCapacity = pQueue->mCapacity;
+	const uint32_t newCapacity = oldCapacity * 2;
+	ThreadedTask*  pTasks = (ThreadedTask*)tf_malloc(newCapacity * sizeof(ThreadedTask));
+
+	const uint32_t count = pQueue->mTail - pQueue->mHead;
+	for (uint32_t i = 0; i < count; ++i)
 	{
-		releaseMutex(&pThreadSystem->mQueueMutex);
-		return false;
+		pTasks[i] = pQueue->pTasks[(pQueue->mHead + i) & (oldCapacity - 1)];
 	}
 
-	uint32_t taskSize = pThreadSystem->mBegin >= pThreadSystem->mEnd ? pThreadSystem->mBegin - pThreadSystem->mEnd
-		: MAX_SYSTEM_TASKS - (pThreadSystem->mEnd - pThreadSystem->mBegin);
-	ThreadedTask resourceTask;
-	bool         found = false;
+	tf_free(pQueue->pTasks);
+	pQueue->pTasks = pTasks;
+	pQueue->mCapacity = newCapacity;
+	pQueue->mHead = 0;
+	pQueue->mTail = count;
+}
 
-	for (uint32_t i = 0; i < taskSize; ++i)
+static void wakeThreadSystemLoaders(ThreadSystem* pThreadSystem, uintptr_t count)
+{
+	// The atomic add on mNumQueuedTasks done by the caller acts as a full barrier, so either we see the sleeping
+	// loader here or the loader sees the new tasks before it goes to sleep
+	uint32_t numSleeping = tfrg_atomic32_load_relaxed(&pThreadSystem->mNumSleepingLoaders);
+	if (!numSleeping)
 	{
-		uint32_t index = (pThreadSystem->mEnd + i) % MAX_SYSTEM_TASKS;
-		resourceTask = pThreadSystem->mLoadTask[index];
+		return;
+	}
 
-		for (size_t j = 0; j < count; ++j)
+	acquireMutex(&pThreadSystem->mSleepMutex);
+	if (count >= numSleeping)
+	{
+		wakeAllConditionVariable(&pThreadSystem->mSleepCond);
+	}
+	else
+	{
+		for (uintptr_t i = 0; i < count; ++i)
 		{
-			if (pIds[j] == resourceTask.mStart)
-			{
-				found = true;
-				break;
-			}
+			wakeOneConditionVariable(&pThreadSystem->mSleepCond);
 		}
+	}
+	releaseMutex(&pThreadSystem->mSleepMutex);
+}
 
-		if (found)
-		{
-			if (resourceTask.mStart + 1 == resourceTask.mEnd)
-			{
-				pThreadSystem->mLoadTask[index] = pThreadSystem->mLoadTask[pThreadSystem->mEnd];
-				++pThreadSystem->mEnd;
-				pThreadSystem->mEnd = pThreadSystem->mEnd % MAX_SYSTEM_TASKS;
-			}
-			else
-			{
-				++pThreadSystem->mLoadTask[index].mStart;
-			}
-			break;
-		}
+// Called after a counter reached zero or new tasks were queued. The atomic operation done by the caller acts as a
+// full barrier, so either we see the waiter here or the waiter sees the change before it goes to sleep.
+static void wakeThreadCounterWaiters(ThreadSystem* pThreadSystem)
+{
+	if (!tfrg_atomic32_load_relaxed(&pThreadSystem->mNumCounterWaiters))
+	{
+		return;
 	}
 
-	releaseMutex(&pThreadSystem->mQueueMutex);
+	acquireMutex(&pThreadSystem->mCounterMutex);
+	wakeAllConditionVariable(&pThreadSystem->mCounterCond);
+	releaseMutex(&pThreadSystem->mCounterMutex);
+}
 
-	if (!found)
+static void pushThreadSystemTask(ThreadSystem* pThreadSystem, const ThreadedTask& task)
+{
+	if (task.mEnd <= task.mStart)
+	{
+		return;
+	}
+	// Range tasks occupy a single entry no matter how many iterations they cover
+	const uintptr_t count = task.mGrainSize ? 1 : task.mEnd - task.mStart;
+
+	uint32_t queueIndex = 0;
+	if (pCurrentThreadSystem == pThreadSystem)
+	{
+		queueIndex = gCurrentQueueIndex;
+	}
+	else
+	{
+		queueIndex = tfrg_atomic32_add_relaxed(&pThreadSystem->mNextQueue, 1) % pThreadSystem->mNumLoaders;
+	}
+
+	// Pending first so waitThreadSystemIdle never observes zero while this task is in flight.
+	// Queued before the push so a stealer never decrements below zero.
+	tfrg_atomic64_add_relaxed(&pThreadSystem->mNumPendingTasks, count);
+	tfrg_atomic64_add_relaxed(&pThreadSystem->mNumQueuedTasks, count);
+
+	ThreadQueue* pQueue = &pThreadSystem->mQueues[queueIndex];
+	acquireMutex(&pQueue->mQueueMutex);
+	if (pQueue->mTail - pQueue->mHead == pQueue->mCapacity)
+	{
+		growThreadQueue(pQueue);
+	}
+	pQueue->pTasks[pQueue->mTail & (pQueue->mCapacity - 1)] = task;
+	++pQueue->mTail;
+	releaseMutex(&pQueue->mQueueMutex);
+
+	wakeThreadSystemLoaders(pThreadSystem, count);
+	// Threads waiting on a counter can help with the new tasks
+	wakeThreadCounterWaiters(pThreadSystem);
+}
+
+// Takes a single index out of the queue. The owner takes from the tail, everyone else from the head.
+static bool popThreadQueueTask(ThreadQueue* pQueue, bool fromTail, ThreadedTask* pOutTask)
+{
+	// Cheap early out so idle stealers don't hammer the mutex of empty queues
+	if (pQueue->mHead == pQueue->mTail)
 	{
 		return false;
 	}
 
-	resourceTask.mTask(resourceTask.mUser, resourceTask.mStart);
+	acquireMutex(&pQueue->mQueueMutex);
+	if (pQueue->mHead == pQueue->mTail)
+	{
+		releaseMutex(&pQueue->mQueueMutex);
+		return false;
+	}
+
+	const uint32_t mask = pQueue->mCapacity - 1;
+	ThreadedTask*  pTask = &pQueue->pTasks[(fromTail ? pQueue->mTail - 1 : pQueue->mHead) & mask];
+	*pOutTask = *pTask;
+	if (pTask->mGrainSize || pTask->mStart + 1 == pTask->mEnd)
+	{
+		if (fromTail)
+			--pQueue->mTail;
+		else
+			++pQueue->mHead;
+	}
+	else
+	{
+		++pTask->mStart;
+	}
+	releaseMutex(&pQueue->mQueueMutex);
 	return true;
 }
 
-bool assistThreadSystem(ThreadSystem* pThreadSystem)
+static bool popThreadSystemTask(ThreadSystem* pThreadSystem, ThreadedTask* pOutTask)
 {
-	acquireMutex(&pThreadSystem->mQueueMutex);
-	if (pThreadSystem->mBegin != pThreadSystem->mEnd)
+	const uint32_t numQueues = pThreadSystem->mNumLoaders;
+	uint32_t       firstQueue = 0;
+	if (pCurrentThreadSystem == pThreadSystem)
 	{
-		ThreadedTask resourceTask = pThreadSystem->mLoadTask[pThreadSystem->mEnd];
-		if (resourceTask.mStart + 1 == resourceTask.mEnd)
+		firstQueue = gCurrentQueueIndex;
+		if (popThreadQueueTask(&pThreadSystem->mQueues[firstQueue], true, pOutTask))
 		{
-			++pThreadSystem->mEnd;
-			pThreadSystem->mEnd = pThreadSystem->mEnd % MAX_SYSTEM_TASKS;
+			tfrg_atomic64_add_relaxed(&pThreadSystem->mNumQueuedTasks, -1);
+			return true;
 		}
-		else
+		++firstQueue;
+	}
+
+	for (uint32_t i = 0; i < numQueues; ++i)
+	{
+		if (popThreadQueueTask(&pThreadSystem->mQueues[(firstQueue + i) % numQueues], false, pOutTask))
+		{
+			tfrg_atomic64_add_relaxed(&pThreadSystem->mNumQueuedTasks, -1);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void runThreadSystemTask(ThreadSystem* pThreadSystem, const ThreadedTask& task)
+{
+	if (task.mGrainSize)
+	{
+		// Keep the left half and hand the right half to the queue until the range is small enough.
+		// Stealers take from the head of the queue so they pick up the largest remaining halves.
+		ThreadedTask split = task;
+		while (split.mEnd - split.mStart > split.mGrainSize)
 		{
-			++pThreadSystem->mLoadTask[pThreadSystem->mEnd].mStart;
+			const uintptr_t middle = split.mStart + (split.mEnd - split.mStart) / 2;
+			ThreadedTask right = split;
+			right.mStart = middle;
+			pushThreadSystemTask(pThreadSystem, right);
+			split.mEnd = middle;
 		}
-		releaseMutex(&pThreadSystem->mQueueMutex);
-		resourceTask.mTask(resourceTask.mUser, resourceTask.mStart);
 
-		return true;
+		task.mRangeTask(task.mUser, split.mStart, split.mEnd);
+		if (task.pCounter)
+		{
+			const uint64_t count = split.mEnd - split.mStart;
+			if (tfrg_atomic64_add_release(&task.pCounter->mValue, -(int64_t)count) == count)
+			{
+				wakeThreadCounterWaiters(pThreadSystem);
+			}
+		}
 	}
 	else
 	{
-		releaseMutex(&pThreadSystem->mQueueMutex);
-		return false;
+		task.mTask(task.mUser, task.mStart);
+	}
+
+	if (tfrg_atomic64_add_relaxed(&pThreadSystem->mNumPendingTasks, -1) == 1)
+	{
+		acquireMutex(&pThreadSystem->mIdleMutex);
+		wakeAllConditionVariable(&pThreadSystem->mIdleCond);
+		releaseMutex(&pThreadSystem->mIdleMutex);
 	}
 }
 
-static void taskThreadFunc(void* pThreadData)
+bool assistThreadSystemTasks(ThreadSystem* pThreadSystem, uint32_t* pIds, size_t count)
 {
-	ThreadSystem* pThreadSystem = (ThreadSystem*)pThreadData;
-	while (pThreadSystem->mRun)
+	ThreadedTask resourceTask;
+	bool         found = false;
+
+	for (uint32_t q = 0; q < pThreadSystem->mNumLoaders && !found; ++q)
 	{
-		acquireMutex(&pThreadSystem->mQueueMutex);
-		++pThreadSystem->mNumIdleLoaders;
-		while (pThreadSystem->mRun && pThreadSystem->mBegin == pThreadSystem->mEnd)
+		ThreadQueue* pQueue = &pThreadSystem->mQueues[q];
+		if (pQueue->mHead == pQueue->mTail)
 		{
-			wakeAllConditionVariable(&pThreadSystem->mIdleCond);
-			waitConditionVariable(&pThreadSystem->mQueueCond, &pThreadSystem->mQueueMutex, TIMEOUT_INFINITE);
+			continue;
 		}
-		--pThreadSystem->mNumIdleLoaders;
-		if (pThreadSystem->mBegin != pThreadSystem->mEnd)
+
+		acquireMutex(&pQueue->mQueueMutex);
+		const uint32_t mask = pQueue->mCapacity - 1;
+		for (uint32_t i = pQueue->mHead; i != pQueue->mTail && !found; ++i)
 		{
-			ThreadedTask resourceTask = pThreadSystem->mLoadTask[pThreadSystem->mEnd];    // pThreadSystem->mLoadQueue.front();
-			if (resourceTask.mStart + 1 == resourceTask.mEnd)
+			ThreadedTask* pTask = &pQueue->pTasks[i & mask];
+			if (pTask->mGrainSize)
+			{
+				continue;
+			}
+
+			for (size_t j = 0; j < count; ++j)
 			{
-				++pThreadSystem->mEnd;
-				pThreadSystem->mEnd = pThreadSystem->mEnd % MAX_SYSTEM_TASKS;
+				if (pIds[j] == pTask->mStart)
+				{
+					found = true;
+					break;
+				}
 			}
-			else
+
+			if (found)
 			{
-				++pThreadSystem->mLoadTask[pThreadSystem->mEnd].mStart;
+				resourceTask = *pTask;
+				if (pTask->mStart + 1 == pTask->mEnd)
+				{
+					*pTask = pQueue->pTasks[pQueue->mHead & mask];
+					++pQueue->mHead;
+				}
+				else
+				{
+					++pTask->mStart;
+				}
 			}
-			releaseMutex(&pThreadSystem->mQueueMutex);
-			resourceTask.mTask(resourceTask.mUser, resourceTask.mStart);
 		}
-		else
+		releaseMutex(&pQueue->mQueueMutex);
+	}
+
+	if (!found)
+	{
+		return false;
+	}
+
+	tfrg_atomic64_add_relaxed(&pThreadSystem->mNumQueuedTasks, -1);
+	runThreadSystemTask(pThreadSystem, resourceTask);
+	return true;
+}
+
+bool assistThreadSystem(ThreadSystem* pThreadSystem)
+{
+	ThreadedTask resourceTask;
+	if (!popThreadSystemTask(pThreadSystem, &resourceTask))
+	{
+		return false;
+	}
+
+	runThreadSystemTask(pThreadSystem, resourceTask);
+	return true;
+}
+
+static void taskThreadFunc(void* pThreadData)
+{
+	ThreadQueue*  pQueue = (ThreadQueue*)pThreadData;
+	ThreadSystem* pThreadSystem = pQueue->pThreadSystem;
+	pCurrentThreadSystem = pThreadSystem;
+	gCurrentQueueIndex = (uint32_t)(pQueue - pThreadSystem->mQueues);
+
+	while (pThreadSystem->mRun)
+	{
+		ThreadedTask resourceTask;
+		if (popThreadSystemTask(pThreadSystem, &resourceTask))
 		{
-			releaseMutex(&pThreadSystem->mQueueMutex);
+			runThreadSystemTask(pThreadSystem, resourceTask);
+			continue;
 		}
+
+		acquireMutex(&pThreadSystem->mSleepMutex);
+		tfrg_atomic32_add_relaxed(&pThreadSystem->mNumSleepingLoaders, 1);
+		while (pThreadSystem->mRun && (int64_t)tfrg_atomic64_load_relaxed(&pThreadSystem->mNumQueuedTasks) <= 0)
+		{
+			waitConditionVariable(&pThreadSystem->mSleepCond, &pThreadSystem->mSleepMutex, TIMEOUT_INFINITE);
+		}
+		tfrg_atomic32_add_relaxed(&pThreadSystem->mNumSleepingLoaders, -1);
+		releaseMutex(&pThreadSystem->mSleepMutex);
 	}
-	acquireMutex(&pThreadSystem->mQueueMutex);
-	++pThreadSystem->mNumIdleLoaders;
-	wakeAllConditionVariable(&pThreadSystem->mIdleCond);
-	releaseMutex(&pThreadSystem->mQueueMutex);
+
+	pCurrentThreadSystem = NULL;
 }
 
 void initThreadSystem(
 	ThreadSystem** ppThreadSystem, uint32_t numRequestedThreads, uint32_t* affinityMasks, const char* threadName)
 {
-	ThreadSystem* pThreadSystem = tf_new(ThreadSystem);
+	// The queues are cache line aligned so the system has to be as well
+	ThreadSystem* pThreadSystem = (ThreadSystem*)tf_memalign(alignof(ThreadSystem), sizeof(ThreadSystem));
+	ASSERT(pThreadSystem);
+	tf_placement_new<ThreadSystem>(pThreadSystem);
 
 	uint32_t numThreads = max<uint32_t>(getNumCPUCores() - 1, 1);
-	uint32_t numLoaders = min<uint32_t>(numThreads, min<uint32_t>(numRequestedThreads, MAX_LOAD_THREADS));
+	uint32_t numLoaders = min<uint32_t>(numThreads, min<uint32_t>(numRequestedThreads, MAX_SYSTEM_THREADS));
 
-	initMutex(&pThreadSystem->mQueueMutex);
-	initConditionVariable(&pThreadSystem->mQueueCond);
+	initMutex(&pThreadSystem->mSleepMutex);
+	initConditionVariable(&pThreadSystem->mSleepCond);
+	initMutex(&pThreadSystem->mIdleMutex);
 	initConditionVariable(&pThreadSystem->mIdleCond);
+	initMutex(&pThreadSystem->mCounterMutex);
+	initConditionVariable(&pThreadSystem->mCounterCond);
 
 	pThreadSystem->mRun = true;
-	pThreadSystem->mNumIdleLoaders = 0;
-	pThreadSystem->mBegin = 0;
-	pThreadSystem->mEnd = 0;
+	pThreadSystem->mNumQueuedTasks = 0;
+	pThreadSystem->mNumPendingTasks = 0;
+	pThreadSystem->mNumSleepingLoaders = 0;
+	pThreadSystem->mNumCounterWaiters = 0;
+	pThreadSystem->mNextQueue = 0;
+	pThreadSystem->mNumLoaders = numLoaders;
+
+	for (uint32_t i = 0; i < numLoaders; ++i)
+	{
+		initThreadQueue(pThreadSystem, &pThreadSystem->mQueues[i]);
+	}
 
 	if (!threadName || *threadName == 0)
 		threadName = "TaskThread";
 
 	ThreadDesc threadDesc = {};
 	threadDesc.pFunc = taskThreadFunc;
-	threadDesc.pData = pThreadSystem;
 
 	for (unsigned i = 0; i < numLoaders; ++i)
 	{
@@ -204,66 +445,75 @@ void initThreadSystem(
 			threadDesc.mAffinityMask = affinityMasks[i];
 		}
 
+		threadDesc.pData = &pThreadSystem->mQueues[i];
 		snprintf(threadDesc.mThreadName, sizeof(threadDesc.mThreadName), "%s%u", threadName, i);
 		initThread(&threadDesc, &pThreadSystem->mThread[i]);
 	}
-	pThreadSystem->mNumLoaders = numLoaders;
 
 	*ppThreadSystem = pThreadSystem;
 }
 
 void addThreadSystemTask(ThreadSystem* pThreadSystem, TaskFunc task, void* user, uintptr_t index)
 {
-	acquireMutex(&pThreadSystem->mQueueMutex);
-	pThreadSystem->mLoadTask[pThreadSystem->mBegin++] = ThreadedTask{ task, user, index, index + 1 };
-	pThreadSystem->mBegin = pThreadSystem->mBegin % MAX_SYSTEM_TASKS;
-	LOGF_IF(
-		LogLevel::eERROR, pThreadSystem->mBegin == pThreadSystem->mEnd,
-		"Maximum amount of thread task reached: mBegin (%d), mEnd(%d), Max(%d)", pThreadSystem->mBegin, pThreadSystem->mEnd,
-		MAX_SYSTEM_TASKS);
-	ASSERT(pThreadSystem->mBegin != pThreadSystem->mEnd);
-	releaseMutex(&pThreadSystem->mQueueMutex);
-	wakeAllConditionVariable(&pThreadSystem->mQueueCond);
+	pushThreadSystemTask(pThreadSystem, ThreadedTask{ { task }, user, index, index + 1, 0, NULL });
 }
 
 uint32_t getThreadSystemThreadCount(ThreadSystem* pThreadSystem) { return pThreadSystem->mNumLoaders; }
 
 void addThreadSystemRangeTask(ThreadSystem* pThreadSystem, TaskFunc task, void* user, uintptr_t count)
 {
-	acquireMutex(&pThreadSystem->mQueueMutex);
-	pThreadSystem->mLoadTask[pThreadSystem->mBegin++] = ThreadedTask{ task, user, 0, count };
-	pThreadSystem->mBegin = pThreadSystem->mBegin % MAX_SYSTEM_TASKS;
-	LOGF_IF(
-		LogLevel::eERROR, pThreadSystem->mBegin == pThreadSystem->mEnd,
-		"Maximum amount of thread task reached: mBegin (%d), mEnd(%d), Max(%d)", pThreadSystem->mBegin, pThreadSystem->mEnd,
-		MAX_SYSTEM_TASKS);
-	ASSERT(pThreadSystem->mBegin != pThreadSystem->mEnd);
-	releaseMutex(&pThreadSystem->mQueueMutex);
-	wakeAllConditionVariable(&pThreadSystem->mQueueCond);
+	pushThreadSystemTask(pThreadSystem, ThreadedTask{ { task }, user, 0, count, 0, NULL });
 }
 
 void addThreadSystemRangeTask(ThreadSystem* pThreadSystem, TaskFunc task, void* user, uintptr_t start, uintptr_t end)
 {
-	acquireMutex(&pThreadSystem->mQueueMutex);
-	pThreadSystem->mLoadTask[pThreadSystem->mBegin++] = ThreadedTask{ task, user, start, end };
-	pThreadSystem->mBegin = pThreadSystem->mBegin % MAX_SYSTEM_TASKS;
-	LOGF_IF(
-		LogLevel::eERROR, pThreadSystem->mBegin == pThreadSystem->mEnd,
-		"Maximum amount of thread task reached: mBegin (%d), mEnd(%d), Max(%d)", pThreadSystem->mBegin, pThreadSystem->mEnd,
-		MAX_SYSTEM_TASKS);
-	ASSERT(pThreadSystem->mBegin != pThreadSystem->mEnd);
-	releaseMutex(&pThreadSystem->mQueueMutex);
-	wakeAllConditionVariable(&pThreadSystem->mQueueCond);
+	pushThreadSystemTask(pThreadSystem, ThreadedTask{ { task }, user, start, end, 0, NULL });
+}
+
+void addThreadSystemParallelForTask(
+	ThreadSystem* pThreadSystem, RangeTaskFunc task, void* user, uintptr_t start, uintptr_t end, uintptr_t grainSize,
+	ThreadCounter* pCounter)
+{
+	if (end <= start)
+	{
+		return;
+	}
+
+	if (!grainSize)
+	{
+		// Enough chunks for every worker plus the calling thread to steal several times
+		grainSize = max<uintptr_t>((end - start) / (8 * (pThreadSystem->mNumLoaders + 1)), 1);
+	}
+
+	if (pCounter)
+	{
+		addThreadCounter(pCounter, end - start);
+	}
+
+	ThreadedTask rangeTask = {};
+	rangeTask.mRangeTask = task;
+	rangeTask.mUser = user;
+	rangeTask.mStart = start;
+	rangeTask.mEnd = end;
+	rangeTask.mGrainSize = grainSize;
+	rangeTask.pCounter = pCounter;
+	pushThreadSystemTask(pThreadSystem, rangeTask);
 }
 
 void exitThreadSystem(ThreadSystem* pThreadSystem)
 {
-	acquireMutex(&pThreadSystem->mQueueMutex);
+	acquireMutex(&pThreadSystem->mSleepMutex);
 	pThreadSystem->mRun = false;
-	releaseMutex(&pThreadSystem->mQueueMutex);
-	wakeAllConditionVariable(&pThreadSystem->mQueueCond);
-	pThreadSystem->mBegin = 0;
-	pThreadSystem->mEnd = 0;
+	wakeAllConditionVariable(&pThreadSystem->mSleepCond);
+	releaseMutex(&pThreadSystem->mSleepMutex);
+
+	acquireMutex(&pThreadSystem->mIdleMutex);
+	wakeAllConditionVariable(&pThreadSystem->mIdleCond);
+	releaseMutex(&pThreadSystem->mIdleMutex);
+
+	acquireMutex(&pThreadSystem->mCounterMutex);
+	wakeAllConditionVariable(&pThreadSystem->mCounterCond);
+	releaseMutex(&pThreadSystem->mCounterMutex);
 
 	uint32_t numLoaders = pThreadSystem->mNumLoaders;
 	for (uint32_t i = 0; i < numLoaders; ++i)
@@ -271,26 +521,275 @@ void exitThreadSystem(ThreadSystem* pThreadSystem)
 		joinThread(pThreadSystem->mThread[i]);
 	}
 
-	destroyConditionVariable(&pThreadSystem->mQueueCond);
+	for (uint32_t i = 0; i < numLoaders; ++i)
+	{
+		exitThreadQueue(&pThreadSystem->mQueues[i]);
+	}
+
+	destroyConditionVariable(&pThreadSystem->mSleepCond);
+	destroyMutex(&pThreadSystem->mSleepMutex);
 	destroyConditionVariable(&pThreadSystem->mIdleCond);
-	destroyMutex(&pThreadSystem->mQueueMutex);
-	tf_delete(pThreadSystem);
+	destroyMutex(&pThreadSystem->mIdleMutex);
+	destroyConditionVariable(&pThreadSystem->mCounterCond);
+	destroyMutex(&pThreadSystem->mCounterMutex);
+	pThreadSystem->~ThreadSystem();
+	tf_free(pThreadSystem);
 }
 
 bool isThreadSystemIdle(ThreadSystem* pThreadSystem)
 {
-	acquireMutex(&pThreadSystem->mQueueMutex);
-	bool idle = (pThreadSystem->mBegin == pThreadSystem->mEnd && pThreadSystem->mNumIdleLoaders == pThreadSystem->mNumLoaders) ||
-		!pThreadSystem->mRun;
-	releaseMutex(&pThreadSystem->mQueueMutex);
-	return idle;
+	return tfrg_atomic64_load_acquire(&pThreadSystem->mNumPendingTasks) == 0 || !pThreadSystem->mRun;
 }
 
 void waitThreadSystemIdle(ThreadSystem* pThreadSystem)
 {
-	acquireMutex(&pThreadSystem->mQueueMutex);
-	while ((pThreadSystem->mBegin != pThreadSystem->mEnd || pThreadSystem->mNumIdleLoaders < pThreadSystem->mNumLoaders) &&
-		pThreadSystem->mRun)
-		waitConditionVariable(&pThreadSystem->mIdleCond, &pThreadSystem->mQueueMutex, TIMEOUT_INFINITE);
-	releaseMutex(&pThreadSystem->mQueueMutex);
+	acquireMutex(&pThreadSystem->mIdleMutex);
+	while (tfrg_atomic64_load_acquire(&pThreadSystem->mNumPendingTasks) != 0 && pThreadSystem->mRun)
+		waitConditionVariable(&pThreadSystem->mIdleCond, &pThreadSystem->mIdleMutex, TIMEOUT_INFINITE);
+	releaseMutex(&pThreadSystem->mIdleMutex);
+}
+
+void waitThreadCounter(ThreadSystem* pThreadSystem, ThreadCounter* pCounter)
+{
+	while (!isThreadCounterDone(pCounter))
+	{
+		if (assistThreadSystem(pThreadSystem))
+		{
+			continue;
+		}
+
+		// The remaining work is already running on other threads. Sleep until it finishes or more tasks get queued.
+		acquireMutex(&pThreadSystem->mCounterMutex);
+		tfrg_atomic32_add_relaxed(&pThreadSystem->mNumCounterWaiters, 1);
+		while (pThreadSystem->mRun && !isThreadCounterDone(pCounter) &&
+			   (int64_t)tfrg_atomic64_load_relaxed(&pThreadSystem->mNumQueuedTasks) <= 0)
+		{
+			waitConditionVariable(&pThreadSystem->mCounterCond, &pThreadSystem->mCounterMutex, TIMEOUT_INFINITE);
+		}
+		tfrg_atomic32_add_relaxed(&pThreadSystem->mNumCounterWaiters, -1);
+		releaseMutex(&pThreadSystem->mCounterMutex);
+	}
+}
+
+/************************************************************************/
+// Task graph
+/************************************************************************/
+struct ThreadTaskGraphNode
+{
+	TaskFunc         mTask;
+	void*            pUser;
+	uintptr_t        mStart;
+	uintptr_t        mEnd;
+	ThreadTaskGraph* pGraph;
+	uint32_t         mNumDependencies;
+	uint32_t         mFirstSuccessor;
+	uint32_t         mNumSuccessors;
+	tfrg_atomic32_t  mRemainingDependencies;
+	// Number of indices of this task that have not finished yet
+	ThreadCounter    mCounter;
+};
+
+struct ThreadTaskGraph
+{
+	ThreadSystem*        pThreadSystem;
+	ThreadTaskGraphNode* pNodes;
+	uint32_t             mNodeCount;
+	uint32_t             mNodeCapacity;
+	// Pairs of (dependsOn, task)
+	uint32_t*            pDependencies;
+	uint32_t             mDependencyCount;
+	uint32_t             mDependencyCapacity;
+	// Successors of every node, indexed by ThreadTaskGraphNode::mFirstSuccessor
+	uint32_t*            pSuccessors;
+	bool                 mDirty;
+	// Number of nodes that have not finished yet
+	ThreadCounter        mCounter;
+};
+
+static void queueThreadTaskGraphNode(ThreadTaskGraphNode* pNode);
+
+static void completeThreadTaskGraphNode(ThreadTaskGraphNode* pNode)
+{
+	ThreadTaskGraph* pGraph = pNode->pGraph;
+	ThreadSystem*    pThreadSystem = pGraph->pThreadSystem;
+	for (uint32_t i = 0; i < pNode->mNumSuccessors; ++i)
+	{
+		ThreadTaskGraphNode* pSuccessor = &pGraph->pNodes[pGraph->pSuccessors[pNode->mFirstSuccessor + i]];
+		if (tfrg_atomic32_add_relaxed(&pSuccessor->mRemainingDependencies, -1) == 1)
+		{
+			queueThreadTaskGraphNode(pSuccessor);
+		}
+	}
+
+	// The graph can be reset or destroyed as soon as this reaches zero
+	decrementThreadCounter(&pGraph->mCounter);
+	// Wakes waiters of this node as well as of the whole graph
+	wakeThreadCounterWaiters(pThreadSystem);
+}
+
+static void threadTaskGraphNodeFunc(void* pUser, uintptr_t index)
+{
+	ThreadTaskGraphNode* pNode = (ThreadTaskGraphNode*)pUser;
+	pNode->mTask(pNode->pUser, index);
+
+	if (decrementThreadCounter(&pNode->mCounter))
+	{
+		completeThreadTaskGraphNode(pNode);
+	}
+}
+
+static void queueThreadTaskGraphNode(ThreadTaskGraphNode* pNode)
+{
+	addThreadSystemRangeTask(pNode->pGraph->pThreadSystem, threadTaskGraphNodeFunc, pNode, pNode->mStart, pNode->mEnd);
+}
+
+static void buildThreadTaskGraphSuccessors(ThreadTaskGraph* pGraph)
+{
+	for (uint32_t i = 0; i < pGraph->mNodeCount; ++i)
+	{
+		pGraph->pNodes[i].mNumSuccessors = 0;
+	}
+	for (uint32_t i = 0; i < pGraph->mDependencyCount; ++i)
+	{
+		++pGraph->pNodes[pGraph->pDependencies[i * 2]].mNumSuccessors;
+	}
+
+	uint32_t offset = 0;
+	for (uint32_t i = 0; i < pGraph->mNodeCount; ++i)
+	{
+		pGraph->pNodes[i].mFirstSuccessor = offset;
+		offset += pGraph->pNodes[i].mNumSuccessors;
+		pGraph->pNodes[i].mNumSuccessors = 0;
+	}
+
+	pGraph->pSuccessors = (uint32_t*)tf_realloc(pGraph->pSuccessors, max<uint32_t>(offset, 1) * sizeof(uint32_t));
+	for (uint32_t i = 0; i < pGraph->mDependencyCount; ++i)
+	{
+		ThreadTaskGraphNode* pNode = &pGraph->pNodes[pGraph->pDependencies[i * 2]];
+		pGraph->pSuccessors[pNode->mFirstSuccessor + pNode->mNumSuccessors++] = pGraph->pDependencies[i * 2 + 1];
+	}
+
+	pGraph->mDirty = false;
+}
+
+void initThreadTaskGraph(ThreadSystem* pThreadSystem, ThreadTaskGraph** ppGraph)
+{
+	ASSERT(pThreadSystem);
+	ASSERT(ppGraph);
+
+	ThreadTaskGraph* pGraph = (ThreadTaskGraph*)tf_calloc(1, sizeof(ThreadTaskGraph));
+	pGraph->pThreadSystem = pThreadSystem;
+	initThreadCounter(&pGraph->mCounter, 0);
+
+	*ppGraph = pGraph;
+}
+
+void exitThreadTaskGraph(ThreadTaskGraph* pGraph)
+{
+	ASSERT(isThreadTaskGraphDone(pGraph));
+
+	tf_free(pGraph->pNodes);
+	tf_free(pGraph->pDependencies);
+	tf_free(pGraph->pSuccessors);
+	tf_free(pGraph);
+}
+
+ThreadTaskHandle addThreadTaskGraphTask(ThreadTaskGraph* pGraph, TaskFunc task, void* user, uintptr_t start, uintptr_t end)
+{
+	ASSERT(isThreadTaskGraphDone(pGraph));
+	ASSERT(task);
+	ASSERT(end > start);
+
+	if (pGraph->mNodeCount == pGraph->mNodeCapacity)
+	{
+		pGraph->mNodeCapacity = max<uint32_t>(pGraph->mNodeCapacity * 2, MAX_SYSTEM_TASKS);
+		pGraph->pNodes = (ThreadTaskGraphNode*)tf_realloc(pGraph->pNodes, pGraph->mNodeCapacity * sizeof(ThreadTaskGraphNode));
+	}
+
+	ThreadTaskGraphNode* pNode = &pGraph->pNodes[pGraph->mNodeCount];
+	memset(pNode, 0, sizeof(ThreadTaskGraphNode));
+	pNode->mTask = task;
+	pNode->pUser = user;
+	pNode->mStart = start;
+	pNode->mEnd = end;
+	pNode->pGraph = pGraph;
+
+	pGraph->mDirty = true;
+	return pGraph->mNodeCount++;
+}
+
+ThreadTaskHandle addThreadTaskGraphTask(ThreadTaskGraph* pGraph, TaskFunc task, void* user, uintptr_t index)
+{
+	return addThreadTaskGraphTask(pGraph, task, user, index, index + 1);
+}
+
+void addThreadTaskGraphDependency(ThreadTaskGraph* pGraph, ThreadTaskHandle task, ThreadTaskHandle dependsOn)
+{
+	ASSERT(isThreadTaskGraphDone(pGraph));
+	ASSERT(task < pGraph->mNodeCount && dependsOn < pGraph->mNodeCount);
+	ASSERT(task != dependsOn);
+
+	if (pGraph->mDependencyCount == pGraph->mDependencyCapacity)
+	{
+		pGraph->mDependencyCapacity = max<uint32_t>(pGraph->mDependencyCapacity * 2, MAX_SYSTEM_TASKS);
+		pGraph->pDependencies = (uint32_t*)tf_realloc(pGraph->pDependencies, pGraph->mDependencyCapacity * 2 * sizeof(uint32_t));
+	}
+
+	pGraph->pDependencies[pGraph->mDependencyCount * 2] = dependsOn;
+	pGraph->pDependencies[pGraph->mDependencyCount * 2 + 1] = task;
+	++pGraph->mDependencyCount;
+	++pGraph->pNodes[task].mNumDependencies;
+
+	pGraph->mDirty = true;
+}
+
+void resetThreadTaskGraph(ThreadTaskGraph* pGraph)
+{
+	ASSERT(isThreadTaskGraphDone(pGraph));
+
+	pGraph->mNodeCount = 0;
+	pGraph->mDependencyCount = 0;
+	pGraph->mDirty = true;
+}
+
+void runThreadTaskGraph(ThreadTaskGraph* pGraph)
+{
+	ASSERT(isThreadTaskGraphDone(pGraph));
+
+	if (!pGraph->mNodeCount)
+	{
+		return;
+	}
+
+	if (pGraph->mDirty)
+	{
+		buildThreadTaskGraphSuccessors(pGraph);
+	}
+
+	// Everything has to be armed before the first task is queued since tasks complete concurrently with this loop
+	for (uint32_t i = 0; i < pGraph->mNodeCount; ++i)
+	{
+		ThreadTaskGraphNode* pNode = &pGraph->pNodes[i];
+		pNode->mRemainingDependencies = pNode->mNumDependencies;
+		initThreadCounter(&pNode->mCounter, pNode->mEnd - pNode->mStart);
+	}
+	initThreadCounter(&pGraph->mCounter, pGraph->mNodeCount);
+
+	for (uint32_t i = 0; i < pGraph->mNodeCount; ++i)
+	{
+		if (!pGraph->pNodes[i].mNumDependencies)
+		{
+			queueThreadTaskGraphNode(&pGraph->pNodes[i]);
+		}
+	}
+}
+
+bool isThreadTaskGraphDone(ThreadTaskGraph* pGraph) { return isThreadCounterDone(&pGraph->mCounter); }
+
+void waitThreadTaskGraph(ThreadTaskGraph* pGraph) { waitThreadCounter(pGraph->pThreadSystem, &pGraph->mCounter); }
+
+void waitThreadTaskGraphTask(ThreadTaskGraph* pGraph, ThreadTaskHandle task)
+{
+	ASSERT(task < pGraph->mNodeCount);
+	waitThreadCounter(pGraph->pThreadSystem, &pGraph->pNodes[task].mCounter);
 }
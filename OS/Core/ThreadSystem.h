@@ -24,8 +24,10 @@
 */
 
 #include "Config.h"
+#include "Atomics.h"
 
 typedef void (*TaskFunc)(void* user, uintptr_t arg);
+typedef void (*RangeTaskFunc)(void* user, uintptr_t start, uintptr_t end);
 
 template <class T, void (T::* callback)(size_t)>
 static void memberTaskFunc(void* userData, size_t arg)
@@ -44,11 +46,16 @@ static void memberTaskFunc0(void* userData, size_t)
 enum
 {
 	MAX_LOAD_THREADS = 16,
+	MAX_SYSTEM_THREADS = 64,
+	// Initial capacity of each worker queue, queues grow on demand
 	MAX_SYSTEM_TASKS = 128
 };
 
 struct ThreadSystem;
+struct ThreadCounter;
 
+// Every worker owns a task queue. Tasks added from a worker go to its own queue, tasks added from any other thread are
+// distributed round robin. Workers that run out of work steal from the other queues before going to sleep.
 // If affinityMasks is not null it must point to an array of size numRequestedThreads, each elements indicates the affinityMask for that thread
 void initThreadSystem(ThreadSystem** ppThreadSystem, uint32_t numRequestedThreads = MAX_LOAD_THREADS, uint32_t* affinityMasks = NULL, const char* threadName = "");
 
@@ -57,6 +64,13 @@ void exitThreadSystem(ThreadSystem* pThreadSystem);
 void addThreadSystemRangeTask(ThreadSystem* pThreadSystem, TaskFunc task, void* user, uintptr_t count);
 void addThreadSystemRangeTask(ThreadSystem* pThreadSystem, TaskFunc task, void* user, uintptr_t start, uintptr_t end);
 void addThreadSystemTask(ThreadSystem* pThreadSystem, TaskFunc task, void* user, uintptr_t index = 0);
+// Parallel for over [start, end). The range is queued as a single task and split in halves by the workers executing it
+// until the pieces are not larger than grainSize, task is then called once per piece.
+// grainSize = 0 picks a size based on the number of threads.
+// If pCounter is not null it is incremented by the number of iterations and reaches zero again once all of them ran.
+void addThreadSystemParallelForTask(
+	ThreadSystem* pThreadSystem, RangeTaskFunc task, void* user, uintptr_t start, uintptr_t end, uintptr_t grainSize = 0,
+	ThreadCounter* pCounter = NULL);
 
 uint32_t getThreadSystemThreadCount(ThreadSystem* pThreadSystem);
 
@@ -66,3 +80,52 @@ bool assistThreadSystem(ThreadSystem* pThreadSystem);
 
 bool isThreadSystemIdle(ThreadSystem* pThreadSystem);
 void waitThreadSystemIdle(ThreadSystem* pThreadSystem);
+
+/************************************************************************/
+// Counters
+/************************************************************************/
+// A counter reaches zero when the work it tracks has finished. Waiting on a counter executes queued
+// tasks of the thread system in the meantime, so it is safe to wait from inside a task.
+typedef struct ThreadCounter
+{
+	tfrg_atomic64_t mValue;
+} ThreadCounter;
+
+static inline void initThreadCounter(ThreadCounter* pCounter, uint64_t value) { tfrg_atomic64_store_release(&pCounter->mValue, value); }
+static inline void addThreadCounter(ThreadCounter* pCounter, uint64_t value) { tfrg_atomic64_add_relaxed(&pCounter->mValue, value); }
+// Returns true when this call brought the counter to zero
+static inline bool decrementThreadCounter(ThreadCounter* pCounter) { return tfrg_atomic64_add_release(&pCounter->mValue, -1) == 1; }
+static inline bool isThreadCounterDone(ThreadCounter* pCounter) { return tfrg_atomic64_load_acquire(&pCounter->mValue) == 0; }
+
+// Helps with queued tasks until the counter reaches zero and blocks while the remaining work runs on other threads.
+// Only counters decremented by tasks of pThreadSystem wake the waiter.
+void waitThreadCounter(ThreadSystem* pThreadSystem, ThreadCounter* pCounter);
+
+/************************************************************************/
+// Task graph
+/************************************************************************/
+// Tasks are added once, linked with dependencies and the graph can then be run any number of times (once per frame for example).
+// A task starts as soon as all the tasks it depends on have finished, so independent branches of the graph overlap.
+// The graph must be acyclic and must not be modified while it is running.
+struct ThreadTaskGraph;
+typedef uint32_t ThreadTaskHandle;
+
+#define INVALID_THREAD_TASK_HANDLE UINT32_MAX
+
+void initThreadTaskGraph(ThreadSystem* pThreadSystem, ThreadTaskGraph** ppGraph);
+void exitThreadTaskGraph(ThreadTaskGraph* pGraph);
+
+// Adds a task which is executed once for every index in [start, end)
+ThreadTaskHandle addThreadTaskGraphTask(ThreadTaskGraph* pGraph, TaskFunc task, void* user, uintptr_t start, uintptr_t end);
+ThreadTaskHandle addThreadTaskGraphTask(ThreadTaskGraph* pGraph, TaskFunc task, void* user, uintptr_t index = 0);
+// task will not start before dependsOn has finished
+void addThreadTaskGraphDependency(ThreadTaskGraph* pGraph, ThreadTaskHandle task, ThreadTaskHandle dependsOn);
+// Removes all tasks and dependencies
+void resetThreadTaskGraph(ThreadTaskGraph* pGraph);
+
+// Queues the tasks without dependencies and returns immediately
+void runThreadTaskGraph(ThreadTaskGraph* pGraph);
+bool isThreadTaskGraphDone(ThreadTaskGraph* pGraph);
+// Waits for the whole graph / a single task of the graph while assisting the thread system
+void waitThreadTaskGraph(ThreadTaskGraph* pGraph);
+void waitThreadTaskGraphTask(ThreadTaskGraph* pGraph, ThreadTaskHandle task);
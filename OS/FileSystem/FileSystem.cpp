@@ -10,6 +10,8 @@
 #define STREAM_FIND_BUFFER_SIZE 1024
 
 bool PlatformOpenFile(ResourceDirectory resourceDir, const char* fileName, FileMode mode, FileStream* pOut);
+bool PlatformMapFile(ResourceDirectory resourceDir, const char* fileName, void** ppData, size_t* pSize);
+void PlatformUnmapFile(void* pData, size_t size);
 
 typedef struct ResourceDirectoryInfo
 {
@@ -158,6 +160,21 @@ static bool MemoryStreamIsAtEnd(const FileStream* pStream)
 	return (ssize_t)pStream->mMemory.mCursor == pStream->mSize;
 }
 
+/************************************************************************/
+// Mapped Stream Functions
+/************************************************************************/
+static bool MappedStreamClose(FileStream* pStream)
+{
+	PlatformUnmapFile(pStream->mMemory.pBuffer, pStream->mMemory.mCapacity);
+	return true;
+}
+
+static size_t MappedStreamWrite(FileStream*, const void*, size_t)
+{
+	LOGF(LogLevel::eWARNING, "Attempting to write to a read-only mapped stream.");
+	return 0;
+}
+
 /***********************************/
 // File stream Functions
 /***********************************/
@@ -581,6 +598,19 @@ static IFileSystem gMemoryFileIO =
 	MemoryStreamIsAtEnd
 };
 
+static IFileSystem gMappedFileIO =
+{
+	NULL,
+	MappedStreamClose,
+	MemoryStreamRead,
+	MappedStreamWrite,
+	MemoryStreamSeek,
+	MemoryStreamGetSeekPosition,
+	MemoryStreamGetSize,
+	MemoryStreamFlush,
+	MemoryStreamIsAtEnd
+};
+
 static IFileSystem gSystemFileIO =
 {
 	FileStreamOpen,
@@ -648,6 +678,60 @@ bool fsOpenStreamFromPath(const ResourceDirectory resourceDir, const char* fileN
 
 
 
+bool fsOpenMappedStreamFromPath(const ResourceDirectory resourceDir, const char* fileName, const char* password, FileStream* pOut)
+{
+	// Only plain system files can be mapped, bundled or encrypted resources go through their IO and get read into memory
+	void*  data = NULL;
+	size_t size = 0;
+	if (!password && gResourceDirectories[resourceDir].pIO == pSystemFileIO && PlatformMapFile(resourceDir, fileName, &data, &size))
+	{
+		FileStream stream = {};
+		stream.pIO = &gMappedFileIO;
+		stream.mMemory.pBuffer = (uint8_t*)data;
+		stream.mMemory.mCursor = 0;
+		stream.mMemory.mCapacity = size;
+		stream.mMemory.mOwner = false;
+		stream.mSize = (ssize_t)size;
+		stream.mMode = FM_READ_BINARY;
+		stream.mMount = fsGetResourceDirectoryMount(resourceDir);
+		*pOut = stream;
+		return true;
+	}
+
+	FileStream file = {};
+	if (!fsOpenStreamFromPath(resourceDir, fileName, FM_READ_BINARY, password, &file))
+	{
+		return false;
+	}
+
+	ssize_t fileSize = fsGetStreamFileSize(&file);
+	if (fileSize < 0)
+	{
+		fsCloseStream(&file);
+		return false;
+	}
+
+	void* buffer = fileSize ? tf_malloc(fileSize) : NULL;
+	size_t bytesRead = fileSize ? fsReadFromStream(&file, buffer, fileSize) : 0;
+	fsCloseStream(&file);
+	if (bytesRead != (size_t)fileSize)
+	{
+		tf_free(buffer);
+		return false;
+	}
+
+	return fsOpenStreamFromMemory(buffer, fileSize, FM_READ_BINARY, true, pOut);
+}
+
+const void* fsGetStreamBufferIfPresent(const FileStream* pStream)
+{
+	if (pStream->pIO == &gMemoryFileIO || pStream->pIO == &gMappedFileIO)
+	{
+		return pStream->mMemory.pBuffer;
+	}
+	return NULL;
+}
+
 /// Closes and invalidates the file stream.
 bool fsCloseStream(FileStream* pStream)
 {
@@ -232,14 +232,16 @@ public:
 		pipelineDesc.mGraphicsDesc.mSampleCount = pRts[0]->mSampleCount;
 		pipelineDesc.mGraphicsDesc.mSampleQuality = pRts[0]->mSampleQuality;
 		pipelineDesc.mGraphicsDesc.pColorFormats = &pRts[0]->mFormat;
+		SyncToken token = {};
 		for (uint32_t i = 0; i < min(count, 2U); ++i)
 		{
 			pipelineDesc.mGraphicsDesc.mDepthStencilFormat = (i > 0) ? pRts[1]->mFormat : TinyImageFormat_UNDEFINED;
 			pipelineDesc.mGraphicsDesc.pShaderProgram = pShaders[i];
 			pipelineDesc.mGraphicsDesc.pDepthState = &depthStateDesc[i];
 			pipelineDesc.mGraphicsDesc.pRasterizerState = &rasterizerStateDesc[i];
-			vk_addPipeline(pRenderer, &pipelineDesc, &pPipelines[i]);
+			addPipeline(pRenderer, &pipelineDesc, &pPipelines[i], &token);
 		}
+		waitForToken(&token);
 
 		mScaleBias = { 2.0f / (float)pRts[0]->mWidth, -2.0f / (float)pRts[0]->mHeight };
 
@@ -252,7 +254,7 @@ public:
 		for (uint32_t i = 0; i < 2; ++i)
 		{
 			if (pPipelines[i])
-				vk_removePipeline(pRenderer, pPipelines[i]);
+				removePipeline(pRenderer, pPipelines[i]);
 
 			pPipelines[i] = {};
 		}
@@ -297,7 +297,9 @@ bool addVirtualJoystickPipeline(void* pScreenRenderTarget)
 		pipelineDesc.pRootSignature = pVirtualJoystick->pRootSignature;
 		pipelineDesc.pShaderProgram = pVirtualJoystick->pShader;
 		pipelineDesc.pVertexLayout = &vertexLayout;
-		addPipeline(pVirtualJoystick->pRenderer, &desc, &pVirtualJoystick->pPipeline);
+		SyncToken token = {};
+		addPipeline(pVirtualJoystick->pRenderer, &desc, &pVirtualJoystick->pPipeline, &token);
+		waitForToken(&token);
 
 		pVirtualJoystick->mRenderSize[0] = (float)pScreenRT->mWidth;
 		pVirtualJoystick->mRenderSize[1] = (float)pScreenRT->mHeight;
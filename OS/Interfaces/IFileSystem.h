@@ -213,6 +213,15 @@ extern "C"
 	/// Opens a memory buffer as a FileStream, returning a stream that must be closed with `fsCloseStream`.
 	bool fsOpenStreamFromMemory(const void* buffer, size_t bufferSize, FileMode mode, bool owner, FileStream* pOut);
 
+	/// Opens the file at `fileName` for reading as a memory-mapped stream whose contents can be accessed
+	/// in place through `fsGetStreamBufferIfPresent`. Falls back to reading the whole file into an owned
+	/// memory stream when the file cannot be mapped (bundled or encrypted resources, empty files).
+	bool fsOpenMappedStreamFromPath(const ResourceDirectory resourceDir, const char* fileName, const char* password, FileStream* pOut);
+
+	/// Returns the backing memory of a memory or mapped stream, or NULL for streams that are not memory backed.
+	/// The pointer stays valid until the stream is closed.
+	const void* fsGetStreamBufferIfPresent(const FileStream* stream);
+
 	/// Closes and invalidates the file stream.
 	bool fsCloseStream(FileStream* stream);
 
@@ -55,6 +55,9 @@ extern "C"
 	void* tf_realloc_internal(void* ptr, size_t size, const char* f, int l, const char* sf);
 	void  tf_free_internal(void* ptr, const char* f, int l, const char* sf);
 
+	// Bytes and number of allocations made by the calling thread since it started
+	void tf_get_thread_alloc_counters(uint64_t* pBytes, uint64_t* pCount);
+
 #ifdef __cplusplus
 }    // extern "C"
 #endif
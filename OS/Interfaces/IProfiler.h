@@ -74,6 +74,100 @@ void dumpProfileData(const char* appName = "", uint32_t nMaxFrames = 64);
 // Dump benchmark data to "benchmark-(data).txt" of recorded frames
 void dumpBenchmarkData(IApp::Settings* pSettings, const char* outFilename = "", const char* appName = "");
 
+typedef struct BenchmarkDesc
+{
+	/// Frames flipped before sampling starts (pipeline compilation, streaming)
+	uint32_t mWarmupFrames = 120;
+	/// Frames sampled, the report is written after the last one
+	uint32_t mSampleFrames = 1000;
+	/// Set IApp::Settings::mQuit once the report is written
+	bool mQuitWhenDone = true;
+	const char* pAppName = "";
+	/// Report written to the log directory. Empty for "(appName)Benchmark-(date).json"
+	const char* pReportFileName = "";
+} BenchmarkDesc;
+
+typedef struct BenchmarkCompareDesc
+{
+	/// Relative increase of the mean, p50, p90 or p99 of a timer that counts as a regression
+	float mTolerance = 0.05f;
+	/// Timers with a baseline p50 below this are too noisy to compare
+	float mMinTimeMs = 0.05f;
+} BenchmarkCompareDesc;
+
+// Sample the frame time, every gpu queue and every cpu / gpu timer for a fixed number of frames after a warm-up, then write
+// a json report with mean, standard deviation, min, max, p50 / p90 / p99 / p99.9 and a histogram per timer
+void startBenchmark(IApp::Settings* pSettings, const BenchmarkDesc* pDesc);
+bool isBenchmarkRunning();
+// Compare two reports written by startBenchmark, log every regression beyond the tolerance and return the number of
+// timers that regressed. UINT32_MAX if a report could not be read
+uint32_t compareBenchmarkReports(const char* baselineFileName, const char* fileName, const BenchmarkCompareDesc* pDesc);
+
+// Stream every profiled frame to "(appName)Trace-(date).json" in Chrome trace event format (chrome://tracing, ui.perfetto.dev)
+// until stopProfileTrace. Frames are handed to a writer thread as they are flipped, so captures can run for any length of time.
+// A non empty fileName replaces the default name
+void startProfileTrace(const char* appName = "", const char* fileName = "");
+void stopProfileTrace();
+bool isProfileTraceActive();
+
+typedef struct ProfileCaptureFrame
+{
+	uint32_t mFrameIndex;
+	float    mCpuMs;
+	/// Longest span of top level scopes on any gpu queue
+	float mGpuMs;
+	/// Cpu scope with the most exclusive time in the frame
+	char  mLongestScope[64];
+	float mLongestScopeMs;
+} ProfileCaptureFrame;
+
+// Stream every profiled frame to the binary capture file "fileName" in the log directory until stopProfileCapture.
+// Memory use is fixed, frames are dropped (and reported on stop) if the disk can not keep up
+void startProfileCapture(const char* fileName);
+void stopProfileCapture();
+// Read a capture written by startProfileCapture and return up to maxFrames of its slowest frames by cpu time, slowest first
+uint32_t getProfileCaptureWorstFrames(const char* fileName, ProfileCaptureFrame* pFrames, uint32_t maxFrames);
+
+typedef struct ProfileHitch
+{
+	uint32_t mFrameIndex;
+	float    mCpuMs;
+	float    mGpuMs;
+	float    mCpuThresholdMs;
+	float    mGpuThresholdMs;
+	/// Hitches since the previous dump that were not dumped because of mMinDumpIntervalSec
+	uint64_t mRateLimitedCount;
+	/// Profile dump and json summary (frame times and counters) in the log directory
+	const char* pTimelineFileName;
+	const char* pSummaryFileName;
+} ProfileHitch;
+
+typedef void (*ProfileHitchCallback)(const ProfileHitch* pHitch, void* pUserData);
+
+typedef struct ProfileHitchDesc
+{
+	/// Frames with a cpu / gpu time above the largest enabled threshold are hitches. 0 disables the fixed threshold
+	float mCpuThresholdMs = 0.0f;
+	float mGpuThresholdMs = 0.0f;
+	/// Percentile (0..1) of the last 256 frame times, scaled by mPercentileScale. 0 disables
+	float mPercentile = 0.99f;
+	float mPercentileScale = 1.5f;
+	/// Frames dumped before and after the hitch frame
+	uint32_t mFramesBefore = 32;
+	uint32_t mFramesAfter = 8;
+	/// Hitches within this many seconds of the last dump are only counted
+	float mMinDumpIntervalSec = 10.0f;
+	/// Prefix of the dumped file names
+	const char* pAppName = "";
+	/// Called from flipProfiler after the files were written
+	ProfileHitchCallback pCallback = NULL;
+	void*                pUserData = NULL;
+} ProfileHitchDesc;
+
+// Detect frame time spikes in flipProfiler and dump the frames around them to the log directory.
+// NULL disables detection
+void setProfileHitchDetection(const ProfileHitchDesc* pDesc);
+
 //------ Profiler UI Widget --------//
 
 // Call once per frame before AppUI.Draw, draw requested Gpu profiler timers
@@ -55,6 +55,30 @@
 #define MTUNER_FREE(_handle, _ptr)
 #endif
 
+// Per thread allocation totals, read by the profiler to attribute allocations to the active scope.
+// Reallocations count as a new allocation of the full size.
+#if defined(_WINDOWS) || defined(XBOX)
+#define MEM_THREAD_LOCAL __declspec(thread)
+#else
+#define MEM_THREAD_LOCAL __thread
+#endif
+
+static MEM_THREAD_LOCAL uint64_t gThreadAllocBytes = 0;
+static MEM_THREAD_LOCAL uint64_t gThreadAllocCount = 0;
+
+#define COUNT_ALLOC(_size)                \
+	do                                    \
+	{                                     \
+		gThreadAllocBytes += (_size);     \
+		++gThreadAllocCount;              \
+	} while (0)
+
+void tf_get_thread_alloc_counters(uint64_t* pBytes, uint64_t* pCount)
+{
+	*pBytes = gThreadAllocBytes;
+	*pCount = gThreadAllocCount;
+}
+
 #if defined(ENABLE_MEMORY_TRACKING)
 
 #define _CRT_SECURE_NO_WARNINGS 1
@@ -75,6 +99,7 @@ void* tf_calloc_internal(size_t count, size_t size, const char* f, int l, const
 void* tf_memalign_internal(size_t align, size_t size, const char* f, int l, const char* sf)
 {
 	void* pMemAlign = mmgrAllocator(f, l, sf, m_alloc_malloc, align, size);
+	COUNT_ALLOC(size);
 
 	// If using MTuner, report allocation to rmem.
 	MTUNER_ALIGNED_ALLOC(0, pMemAlign, size, 0, align);
@@ -88,6 +113,7 @@ void* tf_calloc_memalign_internal(size_t count, size_t align, size_t size, const
 	size = ALIGN_TO(size, align);
 
 	void* pMemAlign = mmgrAllocator(f, l, sf, m_alloc_calloc, align, size * count);
+	COUNT_ALLOC(size * count);
 
 	// If using MTuner, report allocation to rmem.
 	MTUNER_ALIGNED_ALLOC(0, pMemAlign, size, 0, align);
@@ -99,6 +125,7 @@ void* tf_calloc_memalign_internal(size_t count, size_t align, size_t size, const
 void* tf_realloc_internal(void* ptr, size_t size, const char* f, int l, const char* sf)
 {
 	void* pRealloc = mmgrReallocator(f, l, sf, m_alloc_realloc, size, ptr);
+	COUNT_ALLOC(size);
 
 	// If using MTuner, report reallocation to rmem.
 	MTUNER_REALLOC(0, pRealloc, size, 0, ptr);
@@ -139,6 +166,7 @@ void* tf_malloc(size_t size)
 	void* ptr = malloc(size);
 	MTUNER_ALLOC(0, ptr, size, 0);
 #endif
+	COUNT_ALLOC(size);
 
 	return ptr;
 }
@@ -152,6 +180,7 @@ void* tf_calloc(size_t count, size_t size)
 #else
 	void* ptr = calloc(count, size);
 	MTUNER_ALLOC(0, ptr, count * size, 0);
+	COUNT_ALLOC(count * size);
 #endif
 
 	return ptr;
@@ -171,6 +200,7 @@ void* tf_memalign(size_t alignment, size_t size)
 #endif
 
 	MTUNER_ALIGNED_ALLOC(0, ptr, size, 0, alignment);
+	COUNT_ALLOC(size);
 
 	return ptr;
 }
@@ -195,6 +225,7 @@ void* tf_realloc(void* ptr, size_t size)
 #endif
 
 	MTUNER_REALLOC(0, reallocPtr, size, 0, ptr);
+	COUNT_ALLOC(size);
 
 	return reallocPtr;
 }
@@ -963,13 +963,14 @@ void profileDrawPlotMode(Profile& S)
 void profileDrawTimerMode(Profile& S)
 {
 #ifdef ENABLE_FORGE_UI
-	const char* headerNames[10] = { "Group/Timer",  "Time",       "Average Time",   "Max Time",          "Min Time",
-									"Call Average", "Call Count", "Exclusive Time", "Exclusive Average", "Exclusive Max Time" };
+	const char* headerNames[12] = { "Group/Timer",       "Time",                "Average Time",   "Max Time",          "Min Time",
+									"Call Average",      "Call Count",          "Exclusive Time", "Exclusive Average", "Exclusive Max Time",
+									"Allocated Average", "Alloc Count Average" };
 
 	// Create the table header.
 	eastl::vector<UIWidget*> header;
 
-	for (uint32_t i = 0; i < 10; ++i)
+	for (uint32_t i = 0; i < 12; ++i)
 	{
 		UIWidget* pLabel = (UIWidget*)tf_calloc(1, sizeof(UIWidget));
 		pLabel->mType = WIDGET_TYPE_COLOR_LABEL;
@@ -1016,8 +1017,8 @@ void profileDrawTimerMode(Profile& S)
 				eastl::vector<char*>   timeRowData;
 				eastl::vector<float4*> timeColorData;
 
-				// There are 9 time categories in the header above.
-				for (uint32_t i = 0; i < 9; ++i)
+				// There are 11 data categories in the header above.
+				for (uint32_t i = 0; i < 11; ++i)
 				{
 					char* timeResult = (char*)tf_calloc(MAX_TIME_STR_LEN, sizeof(char));
 					sprintf(timeResult, "-");
@@ -1070,6 +1071,8 @@ void profileResetTimerModeData(uint32_t tableLocation)
 	sprintf(timeCol[6], "-");
 	sprintf(timeCol[7], "-");
 	sprintf(timeCol[8], "-");
+	sprintf(timeCol[9], "-");
+	sprintf(timeCol[10], "-");
 	*timeColor[0] = gNormalColor;
 	*timeColor[1] = gNormalColor;
 	*timeColor[2] = gNormalColor;
@@ -1079,6 +1082,8 @@ void profileResetTimerModeData(uint32_t tableLocation)
 	*timeColor[6] = gNormalColor;
 	*timeColor[7] = gNormalColor;
 	*timeColor[8] = gNormalColor;
+	*timeColor[9] = gNormalColor;
+	*timeColor[10] = gNormalColor;
 }
 
 /// Get data for timer mode functionality.
@@ -1151,6 +1156,18 @@ void profileUpdateTimerModeData(Profile& S, uint32_t groupIndex, uint32_t timerI
 		profileUtilTrimFloatString(floatStr, timeCol[8]);
 	}
 
+	// Allocations made directly in the scope, not in its children. Only CPU scopes allocate.
+	uint64_t nAllocBytesAverage = 0;
+	uint64_t nAllocCountAverage = 0;
+	if (!bGpu && S.nAllocMetaBars)
+	{
+		nAllocBytesAverage = S.MetaCounters[S.nAllocBytesMeta].nAggregate[timerIndex] / nAggregateFrames;
+		nAllocCountAverage = S.MetaCounters[S.nAllocCountMeta].nAggregate[timerIndex] / nAggregateFrames;
+
+		ProfileFormatCounter(PROFILE_COUNTER_FORMAT_BYTES, (int64_t)nAllocBytesAverage, timeCol[9], MAX_TIME_STR_LEN);
+		ProfileFormatCounter(PROFILE_COUNTER_FORMAT_DEFAULT, (int64_t)nAllocCountAverage, timeCol[10], MAX_TIME_STR_LEN);
+	}
+
 	// Also add color coding to the times relative to the current selected reference time.
 	float          criticalTime = CRITICAL_COLOR_THRESHOLD * profileUtilReferenceTimeFromEnum(gReferenceTime);
 	float          warnTime = WARNING_COLOR_THRESHOLD * profileUtilReferenceTimeFromEnum(gReferenceTime);
@@ -1167,6 +1184,8 @@ void profileUpdateTimerModeData(Profile& S, uint32_t groupIndex, uint32_t timerI
 	fFrameMsExclusive > warnTime ? *timeColor[6] = gWarningColor : *timeColor[6] = gNormalColor;
 	fAverageExclusive > warnTime ? *timeColor[7] = gWarningColor : *timeColor[7] = gNormalColor;
 	fMaxExclusive > warnTime ? *timeColor[8] = gWarningColor : *timeColor[8] = gNormalColor;
+	nAllocCountAverage > 0 ? *timeColor[9] = gWarningColor : *timeColor[9] = gNormalColor;
+	nAllocCountAverage > 0 ? *timeColor[10] = gWarningColor : *timeColor[10] = gNormalColor;
 
 	fTime > criticalTime ? *timeColor[0] = gCriticalColor : float4(0.0f);
 	fAverage > criticalTime ? *timeColor[1] = gCriticalColor : float4(0.0f);
@@ -1177,6 +1196,8 @@ void profileUpdateTimerModeData(Profile& S, uint32_t groupIndex, uint32_t timerI
 	fFrameMsExclusive > criticalTime ? *timeColor[6] = gCriticalColor : float4(0.0f);
 	fAverageExclusive > criticalTime ? *timeColor[7] = gCriticalColor : float4(0.0f);
 	fMaxExclusive > criticalTime ? *timeColor[8] = gCriticalColor : float4(0.0f);
+	nAllocCountAverage > criticalCount ? *timeColor[9] = gCriticalColor : float4(0.0f);
+	nAllocCountAverage > criticalCount ? *timeColor[10] = gCriticalColor : float4(0.0f);
 }
 
 void resetProfilerUI()
@@ -1791,6 +1812,24 @@ void ProfileInit()
 		releaseMutex(&mutex);
 }
 
+// Every CPU scope reports what it allocated through tf_malloc & co. as the "Alloc Bytes" / "Alloc Count" meta counters
+void ProfileInitAllocationCounters()
+{
+	Profile& S = g_Profile;
+	ProfileToken nBytes = ProfileGetMetaToken("Alloc Bytes");
+	ProfileToken nCount = ProfileGetMetaToken("Alloc Count");
+	if (nBytes >= PROFILE_META_MAX || nCount >= PROFILE_META_MAX)
+	{
+		LOGF(LogLevel::eWARNING, "Profiler: out of meta counters, allocation counters disabled");
+		return;
+	}
+
+	MutexLock lock(ProfileMutex());
+	S.nAllocBytesMeta = nBytes;
+	S.nAllocCountMeta = nCount;
+	S.nAllocMetaBars = (P_DRAW_META_FIRST << nBytes) | (P_DRAW_META_FIRST << nCount);
+}
+
 void initProfiler(ProfilerDesc* pDesc)
 {
 	// PROFILER BASE
@@ -1798,6 +1837,7 @@ void initProfiler(ProfilerDesc* pDesc)
 #ifdef ENABLE_PROFILER
 	ProfileInit();
 	ProfileSetEnableAllGroups(true);
+	ProfileInitAllocationCounters();
 	ProfileWebServerStart();
 
 #ifdef ENABLE_GPU_PROFILER
@@ -1888,6 +1928,9 @@ void exitCpuProfiler()
 {
 	MutexLock lock(ProfileMutex());
 
+	stopProfileTrace();
+	stopProfileCapture();
+
 	ProfileOnThreadExit();
 	ProfileWebServerStop();
 	ProfileContextSwitchTraceStop();
@@ -2017,6 +2060,8 @@ ProfileThreadLog* ProfileCreateThreadLog(const char* pName)
 	memcpy(&pLog->ThreadName[0], pName, len);
 	pLog->ThreadName[len] = '\0';
 	pLog->nThreadId = getCurrentThreadID();
+	// Start counting from here, otherwise the first scope of the thread is charged with everything allocated before it
+	tf_get_thread_alloc_counters(&pLog->nAllocBytes, &pLog->nAllocCount);
 	return pLog;
 }
 
@@ -2389,6 +2434,21 @@ inline void ProfileLogPut(ProfileToken nToken_, uint64_t nTick, uint64_t nBegin,
 	}
 }
 
+// Logs what the thread allocated since its last scope enter / leave as meta counts of the innermost open scope.
+inline void ProfileLogAllocations(ProfileThreadLog* pLog)
+{
+	Profile& S = g_Profile;
+	uint64_t nBytes, nCount;
+	tf_get_thread_alloc_counters(&nBytes, &nCount);
+	if (nCount != pLog->nAllocCount && (S.nAllocMetaBars & S.nActiveBars))
+	{
+		ProfileLogPut(S.nAllocBytesMeta, nBytes - pLog->nAllocBytes, P_LOG_META, pLog);
+		ProfileLogPut(S.nAllocCountMeta, nCount - pLog->nAllocCount, P_LOG_META, pLog);
+	}
+	pLog->nAllocBytes = nBytes;
+	pLog->nAllocCount = nCount;
+}
+
 uint64_t cpuProfileEnter(ProfileToken nToken_)
 {
 	Profile& S = g_Profile;
@@ -2397,6 +2457,7 @@ uint64_t cpuProfileEnter(ProfileToken nToken_)
 	{
 		if (ProfileThreadLog* pLog = ProfileGetOrCreateThreadLog())
 		{
+			ProfileLogAllocations(pLog);
 			uint64_t nTick = P_TICK();
 			ProfileLogPut(nToken_, nTick, P_LOG_ENTER, pLog);
 			return nTick;
@@ -2592,6 +2653,7 @@ void cpuProfileLeave(ProfileToken nToken_, uint64_t nTickStart)
 	{
 		if (ProfileThreadLog* pLog = ProfileGetOrCreateThreadLog())
 		{
+			ProfileLogAllocations(pLog);
 			uint64_t nTick = P_TICK();
 			ProfileLogPut(nToken_, nTick, P_LOG_LEAVE, pLog);
 		}
@@ -2637,6 +2699,10 @@ void ProfileGetRange(uint32_t nPut, uint32_t nGet, uint32_t nRange[2][2])
 }
 
 void ProfileDumpToFile(Renderer* pRenderer);
+void ProfileTraceFlip();
+void ProfileCaptureFlip();
+void ProfileHitchFlip();
+void ProfileBenchmarkFlip();
 
 void ProfileFlipCpu()
 {
@@ -2735,6 +2801,9 @@ void ProfileFlipCpu()
 			}
 		}
 
+		ProfileTraceFlip();
+		ProfileCaptureFlip();
+
 		if (S.nRunning)
 		{
 			uint64_t* pFrameGroup = &S.FrameGroup[0];
@@ -3062,6 +3131,8 @@ void ProfileFlipCpu()
 			}
 		}
 	}
+	if (S.nRunning || S.nForceEnable)
+		nNewActiveBars |= S.nAllocMetaBars;
 	if (nNewActiveBars != S.nActiveBars)
 		S.nActiveBars = nNewActiveBars;
 }
@@ -3071,6 +3142,8 @@ void flipProfiler()
 	PROFILER_SET_CPU_SCOPE("Profile", "ProfileFlip", 0x3355ee);
 
 	ProfileFlipCpu();
+	ProfileHitchFlip();
+	ProfileBenchmarkFlip();
 }
 
 void ProfileSetForceEnable(bool bEnable)
@@ -4226,6 +4299,1853 @@ void dumpBenchmarkData(IApp::Settings* pSettings, const char* outFilename, const
 	}
 }
 
+// Writer thread shared by the trace export and the continuous capture, running while either of them is active.
+// ProfileFlipCpu only fills memory buffers and hands them over, all file io happens here.
+struct ProfileWriter
+{
+	ThreadHandle      mThread;
+	Mutex             mMutex;
+	// Wakes the writer when work is queued or on exit
+	ConditionVariable mCond;
+	// Signaled every time the writer finished a buffer
+	ConditionVariable mDoneCond;
+	// Protected by the profile mutex
+	uint32_t nUsers;
+	bool     bExit;
+};
+
+static ProfileWriter gProfileWriter = {};
+
+static void ProfileWriterThread(void* pUserData);
+
+// Called with the profile mutex held
+static void ProfileWriterStart()
+{
+	ProfileWriter& W = gProfileWriter;
+	if (W.nUsers++)
+		return;
+
+	initMutex(&W.mMutex);
+	initConditionVariable(&W.mCond);
+	initConditionVariable(&W.mDoneCond);
+	W.bExit = false;
+	ThreadDesc threadDesc = {};
+	threadDesc.pFunc = ProfileWriterThread;
+	strncpy(threadDesc.mThreadName, "ProfileWriter", sizeof(threadDesc.mThreadName));
+	initThread(&threadDesc, &W.mThread);
+}
+
+// Called with the profile mutex held, once the user's queue is empty
+static void ProfileWriterStop()
+{
+	ProfileWriter& W = gProfileWriter;
+	P_ASSERT(W.nUsers);
+	if (--W.nUsers)
+		return;
+
+	acquireMutex(&W.mMutex);
+	W.bExit = true;
+	wakeAllConditionVariable(&W.mCond);
+	releaseMutex(&W.mMutex);
+	joinThread(W.mThread);
+
+	destroyConditionVariable(&W.mDoneCond);
+	destroyConditionVariable(&W.mCond);
+	destroyMutex(&W.mMutex);
+}
+
+// Chrome trace event export (chrome://tracing, ui.perfetto.dev).
+// Every frame is written by ProfileFlipCpu once it becomes S.nFrameCurrent, i.e. after its gpu timers resolved.
+// Events go into a small ring of buffers the writer thread empties, so memory use does not depend on the length of the
+// capture. The frame only waits if the writer is PROFILE_TRACE_BUFFER_COUNT buffers behind.
+#define PROFILE_TRACE_BUFFER_SIZE (64 << 10)
+#define PROFILE_TRACE_BUFFER_COUNT 4
+
+struct ProfileTraceBuffer
+{
+	char*    pData;
+	uint32_t nSize;
+};
+
+struct ProfileTrace
+{
+	FileStream         mFile;
+	ProfileTraceBuffer mBuffers[PROFILE_TRACE_BUFFER_COUNT];
+	// Submitted buffers in order, protected by the writer mutex
+	uint32_t nQueue[PROFILE_TRACE_BUFFER_COUNT];
+	uint32_t nQueueGet;
+	uint32_t nQueueCount;
+	uint32_t nFreeMask;
+	// Buffer ProfileTraceWrite appends to, -1 if none
+	int32_t    nFillBuffer;
+	bool       bActive;
+	bool       bBaseSet;
+	int64_t    nBaseTickCpu;
+	// Gpu logs are aligned to the cpu timeline once, on the first frame they show up in
+	int64_t  nBaseTickGpu[PROFILE_MAX_THREADS];
+	double   fBaseUsGpu[PROFILE_MAX_THREADS];
+	uint32_t nDepth[PROFILE_MAX_THREADS];
+	// Allocations of the open scopes, written as args of their end events
+	uint64_t nAllocBytes[PROFILE_MAX_THREADS][PROFILE_STACK_MAX];
+	uint64_t nAllocCount[PROFILE_MAX_THREADS][PROFILE_STACK_MAX];
+	double   fLastUs[PROFILE_MAX_THREADS];
+	bool     bThreadSeen[PROFILE_MAX_THREADS];
+};
+
+static ProfileTrace gProfileTrace = {};
+
+static void ProfileTraceAcquireBuffer()
+{
+	ProfileTrace&  T = gProfileTrace;
+	ProfileWriter& W = gProfileWriter;
+	acquireMutex(&W.mMutex);
+	while (!T.nFreeMask)
+	{
+		waitConditionVariable(&W.mDoneCond, &W.mMutex, TIMEOUT_INFINITE);
+	}
+	for (uint32_t i = 0; i < PROFILE_TRACE_BUFFER_COUNT; ++i)
+	{
+		if (T.nFreeMask & (1u << i))
+		{
+			T.nFreeMask &= ~(1u << i);
+			T.nFillBuffer = (int32_t)i;
+			T.mBuffers[i].nSize = 0;
+			break;
+		}
+	}
+	releaseMutex(&W.mMutex);
+}
+
+static void ProfileTraceSubmitBuffer()
+{
+	ProfileTrace&  T = gProfileTrace;
+	ProfileWriter& W = gProfileWriter;
+	if (T.nFillBuffer < 0)
+		return;
+
+	acquireMutex(&W.mMutex);
+	T.nQueue[(T.nQueueGet + T.nQueueCount) % PROFILE_TRACE_BUFFER_COUNT] = (uint32_t)T.nFillBuffer;
+	T.nQueueCount++;
+	wakeOneConditionVariable(&W.mCond);
+	releaseMutex(&W.mMutex);
+	T.nFillBuffer = -1;
+}
+
+static void ProfileTraceWrite(void* Handle, size_t nSize, const char* pData)
+{
+	(void)Handle;
+	ProfileTrace& T = gProfileTrace;
+	while (nSize)
+	{
+		if (T.nFillBuffer < 0)
+			ProfileTraceAcquireBuffer();
+
+		ProfileTraceBuffer& B = T.mBuffers[T.nFillBuffer];
+		const uint32_t      nCopy = (uint32_t)ProfileMin<size_t>(nSize, PROFILE_TRACE_BUFFER_SIZE - B.nSize);
+		memcpy(B.pData + B.nSize, pData, nCopy);
+		B.nSize += nCopy;
+		pData += nCopy;
+		nSize -= nCopy;
+		if (B.nSize == PROFILE_TRACE_BUFFER_SIZE)
+			ProfileTraceSubmitBuffer();
+	}
+}
+
+// Writer thread side, pops one submitted buffer and writes it. Returns false if none was queued
+static bool ProfileTraceWriteQueued()
+{
+	ProfileTrace&  T = gProfileTrace;
+	ProfileWriter& W = gProfileWriter;
+	acquireMutex(&W.mMutex);
+	if (!T.nQueueCount)
+	{
+		releaseMutex(&W.mMutex);
+		return false;
+	}
+	const uint32_t nBuffer = T.nQueue[T.nQueueGet];
+	releaseMutex(&W.mMutex);
+
+	fsWriteToStream(&T.mFile, T.mBuffers[nBuffer].pData, T.mBuffers[nBuffer].nSize);
+
+	acquireMutex(&W.mMutex);
+	T.nQueueGet = (T.nQueueGet + 1) % PROFILE_TRACE_BUFFER_COUNT;
+	T.nQueueCount--;
+	T.nFreeMask |= 1u << nBuffer;
+	wakeAllConditionVariable(&W.mDoneCond);
+	releaseMutex(&W.mMutex);
+	return true;
+}
+
+static void ProfileWriteJsonString(ProfileWriteCallback CB, void* Handle, const char* pString)
+{
+	char     buffer[2 * PROFILE_NAME_MAX_LEN + 8];
+	uint32_t nLen = 0;
+	buffer[nLen++] = '"';
+	for (const char* p = pString ? pString : ""; *p; ++p)
+	{
+		if (nLen + 8 > sizeof(buffer))
+		{
+			CB(Handle, nLen, buffer);
+			nLen = 0;
+		}
+		unsigned char c = (unsigned char)*p;
+		if (c == '"' || c == '\\')
+		{
+			buffer[nLen++] = '\\';
+			buffer[nLen++] = (char)c;
+		}
+		else if (c < 0x20)
+		{
+			nLen += snprintf(&buffer[nLen], 7, "\\u%04x", c);
+		}
+		else
+		{
+			buffer[nLen++] = (char)c;
+		}
+	}
+	buffer[nLen++] = '"';
+	CB(Handle, nLen, buffer);
+}
+
+static void ProfileTraceCounterName(int nCounter, char* pOut, size_t nSize)
+{
+	Profile& S = g_Profile;
+	int      nParent = S.CounterInfo[nCounter].nParent;
+	pOut[0] = '\0';
+	if (nParent >= 0)
+	{
+		ProfileTraceCounterName(nParent, pOut, nSize);
+		strncat(pOut, "/", nSize - strlen(pOut) - 1);
+	}
+	strncat(pOut, S.CounterInfo[nCounter].pName, nSize - strlen(pOut) - 1);
+}
+
+static void ProfileTraceClose()
+{
+	ProfileTrace& T = gProfileTrace;
+	if (!T.bActive)
+		return;
+
+	// Close scopes that were still open in the last written frame
+	for (uint32_t j = 0; j < PROFILE_MAX_THREADS; ++j)
+	{
+		for (; T.nDepth[j]; --T.nDepth[j])
+		{
+			ProfilePrintf(ProfileTraceWrite, NULL, ",\n{\"ph\":\"E\",\"pid\":0,\"tid\":%u,\"ts\":%.3f}", j, T.fLastUs[j]);
+		}
+	}
+	ProfilePrintString(ProfileTraceWrite, NULL, "\n]}\n");
+	ProfileTraceSubmitBuffer();
+
+	// Only stopping waits for the file to be written
+	ProfileWriter& W = gProfileWriter;
+	acquireMutex(&W.mMutex);
+	while (T.nQueueCount)
+	{
+		waitConditionVariable(&W.mDoneCond, &W.mMutex, TIMEOUT_INFINITE);
+	}
+	releaseMutex(&W.mMutex);
+	ProfileWriterStop();
+
+	fsCloseStream(&T.mFile);
+	for (uint32_t i = 0; i < PROFILE_TRACE_BUFFER_COUNT; ++i)
+	{
+		tf_free(T.mBuffers[i].pData);
+	}
+	memset(&T, 0, sizeof(T));
+}
+
+// Called from ProfileFlipCpu with the profile mutex held
+void ProfileTraceFlip()
+{
+	ProfileTrace& T = gProfileTrace;
+	if (!T.bActive)
+		return;
+
+	Profile&                 S = g_Profile;
+	const uint32_t           nFrame = S.nFrameCurrent;
+	const uint32_t           nFrameNext = (nFrame + 1) % PROFILE_MAX_FRAME_HISTORY;
+	const ProfileFrameState& Frame = S.Frames[nFrame];
+	const ProfileFrameState& FrameNext = S.Frames[nFrameNext];
+
+	if (!T.bBaseSet)
+	{
+		T.nBaseTickCpu = Frame.nFrameStartCpu;
+		T.bBaseSet = true;
+	}
+
+	const double fToUsCpu = 1000000.0 / (double)ProfileTicksPerSecondCpu();
+	const double fFrameUs = ProfileLogTickDifference(T.nBaseTickCpu, Frame.nFrameStartCpu) * fToUsCpu;
+	const double fFrameEndUs = ProfileLogTickDifference(T.nBaseTickCpu, FrameNext.nFrameStartCpu) * fToUsCpu;
+
+	ProfilePrintf(
+		ProfileTraceWrite, NULL, ",\n{\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"name\":\"Frame %u\",\"cat\":\"Frame\",\"ts\":%.3f,\"dur\":%.3f}",
+		(uint32_t)PROFILE_MAX_THREADS, S.nFrameCurrentIndex, fFrameUs, fFrameEndUs - fFrameUs);
+
+	for (uint32_t j = 0; j < PROFILE_MAX_THREADS; ++j)
+	{
+		ProfileThreadLog* pLog = S.Pool[j];
+		if (!pLog || !pLog->Log)
+			continue;
+
+		const uint32_t nLogStart = Frame.nLogStart[j];
+		const uint32_t nLogEnd = FrameNext.nLogStart[j];
+		if (nLogStart == nLogEnd)
+			continue;
+
+		if (!T.bThreadSeen[j])
+		{
+			T.bThreadSeen[j] = true;
+			T.fLastUs[j] = fFrameUs;
+			ProfilePrintf(ProfileTraceWrite, NULL, ",\n{\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":", j);
+			ProfileWriteJsonString(ProfileTraceWrite, NULL, pLog->ThreadName);
+			ProfilePrintString(ProfileTraceWrite, NULL, "}}");
+			ProfilePrintf(
+				ProfileTraceWrite, NULL, ",\n{\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"name\":\"thread_sort_index\",\"args\":{\"sort_index\":%u}}",
+				j, pLog->nGpu ? (uint32_t)PROFILE_MAX_THREADS + j : j);
+			if (pLog->nGpu)
+			{
+				T.nBaseTickGpu[j] = Frame.nFrameStartGpu[j];
+				T.fBaseUsGpu[j] = fFrameUs;
+			}
+		}
+
+		double fToUs = fToUsCpu;
+		int64_t nBaseTick = T.nBaseTickCpu;
+		double fBaseUs = 0.0;
+		if (pLog->nGpu)
+		{
+			fToUs = 1000000.0 / (double)getGpuProfileTicksPerSecond(pLog->nGpuToken);
+			nBaseTick = T.nBaseTickGpu[j];
+			fBaseUs = T.fBaseUsGpu[j];
+		}
+
+		for (uint32_t k = nLogStart; k != nLogEnd; k = (k + 1) % PROFILE_BUFFER_SIZE)
+		{
+			const ProfileLogEntry LE = pLog->Log[k];
+			const uint32_t        nType = (uint32_t)ProfileLogType(LE);
+
+			if (nType == P_LOG_ENTER || nType == P_LOG_LEAVE)
+			{
+				const uint32_t nTimer = (uint32_t)ProfileLogTimerIndex(LE);
+				const double   fUs = fBaseUs + ProfileLogTickDifference(nBaseTick, LE) * fToUs;
+				T.fLastUs[j] = fUs;
+				if (nType == P_LOG_ENTER)
+				{
+					if (T.nDepth[j] < PROFILE_STACK_MAX)
+					{
+						T.nAllocBytes[j][T.nDepth[j]] = 0;
+						T.nAllocCount[j][T.nDepth[j]] = 0;
+					}
+					T.nDepth[j]++;
+					ProfilePrintf(ProfileTraceWrite, NULL, ",\n{\"ph\":\"B\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"name\":", j, fUs);
+					ProfileWriteJsonString(ProfileTraceWrite, NULL, S.TimerInfo[nTimer].pName);
+					ProfilePrintString(ProfileTraceWrite, NULL, ",\"cat\":");
+					ProfileWriteJsonString(ProfileTraceWrite, NULL, S.GroupInfo[S.TimerInfo[nTimer].nGroupIndex].pName);
+					ProfilePrintString(ProfileTraceWrite, NULL, "}");
+				}
+				else if (T.nDepth[j])
+				{
+					// Leaves of scopes entered before the capture started are dropped
+					T.nDepth[j]--;
+					ProfilePrintf(ProfileTraceWrite, NULL, ",\n{\"ph\":\"E\",\"pid\":0,\"tid\":%u,\"ts\":%.3f", j, fUs);
+					if (T.nDepth[j] < PROFILE_STACK_MAX && T.nAllocCount[j][T.nDepth[j]])
+					{
+						ProfilePrintf(
+							ProfileTraceWrite, NULL, ",\"args\":{\"alloc_bytes\":%llu,\"alloc_count\":%llu}",
+							(unsigned long long)T.nAllocBytes[j][T.nDepth[j]], (unsigned long long)T.nAllocCount[j][T.nDepth[j]]);
+					}
+					ProfilePrintString(ProfileTraceWrite, NULL, "}");
+				}
+			}
+			else if (nType == P_LOG_META)
+			{
+				// Allocation counts are exclusive to the innermost open scope
+				const uint32_t nDepth = T.nDepth[j];
+				const uint64_t nMeta = ProfileLogTimerIndex(LE);
+				if (S.nAllocMetaBars && nDepth && nDepth <= PROFILE_STACK_MAX)
+				{
+					if (nMeta == S.nAllocBytesMeta)
+						T.nAllocBytes[j][nDepth - 1] += ProfileLogGetTick(LE);
+					else if (nMeta == S.nAllocCountMeta)
+						T.nAllocCount[j][nDepth - 1] += ProfileLogGetTick(LE);
+				}
+			}
+			else if (nType == P_LOG_LABEL || nType == P_LOG_LABEL_LITERAL)
+			{
+				// Labels carry no timestamp, they belong to the entry logged before them
+				const char* pLabel = ProfileGetLabel(nType, ProfileLogGetTick(LE));
+				if (pLabel)
+				{
+					ProfilePrintf(ProfileTraceWrite, NULL, ",\n{\"ph\":\"i\",\"s\":\"t\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"name\":", j, T.fLastUs[j]);
+					ProfileWriteJsonString(ProfileTraceWrite, NULL, pLabel);
+					ProfilePrintString(ProfileTraceWrite, NULL, "}");
+				}
+			}
+		}
+	}
+
+	for (uint32_t i = 0; i < S.nNumCounters; ++i)
+	{
+		if (!(S.CounterInfo[i].nFlags & PROFILE_COUNTER_FLAG_LEAF))
+			continue;
+
+		char name[PROFILE_NAME_MAX_LEN * 4];
+		ProfileTraceCounterName((int)i, name, sizeof(name));
+		ProfilePrintString(ProfileTraceWrite, NULL, ",\n{\"ph\":\"C\",\"pid\":0,\"name\":");
+		ProfileWriteJsonString(ProfileTraceWrite, NULL, name);
+		ProfilePrintf(
+			ProfileTraceWrite, NULL, ",\"ts\":%.3f,\"args\":{\"value\":%lld}}", fFrameUs,
+			(long long)tfrg_atomic64_load_relaxed(&S.Counters[i]));
+	}
+}
+
+void startProfileTrace(const char* appName, const char* fileName)
+{
+	MutexLock lock(ProfileMutex());
+	ProfileTraceClose();
+
+	char name[128] = {};
+	if (fileName && fileName[0])
+	{
+		strncpy(name, fileName, sizeof(name) - 1);
+	}
+	else
+	{
+		time_t t = time(0);
+
+		char tempName[128];
+		snprintf(tempName, sizeof(tempName), "%sTrace-%%Y-%%m-%%d-%%H.%%M.%%S.json", appName);
+		strftime(name, sizeof(name), tempName, localtime(&t));
+	}
+
+	ProfileTrace& T = gProfileTrace;
+	if (!fsOpenStreamFromPath(RD_LOG, name, FM_WRITE, NULL, &T.mFile))
+	{
+		LOGF(LogLevel::eERROR, "Failed to open profile trace file %s", name);
+		return;
+	}
+
+	for (uint32_t i = 0; i < PROFILE_TRACE_BUFFER_COUNT; ++i)
+	{
+		T.mBuffers[i].pData = (char*)tf_malloc(PROFILE_TRACE_BUFFER_SIZE);
+	}
+	T.nFreeMask = (1u << PROFILE_TRACE_BUFFER_COUNT) - 1;
+	T.nFillBuffer = -1;
+	T.bActive = true;
+	ProfileWriterStart();
+
+	ProfilePrintString(ProfileTraceWrite, NULL, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	ProfilePrintString(ProfileTraceWrite, NULL, "{\"ph\":\"M\",\"pid\":0,\"name\":\"process_name\",\"args\":{\"name\":");
+	ProfileWriteJsonString(ProfileTraceWrite, NULL, appName[0] ? appName : "Profile");
+	ProfilePrintString(ProfileTraceWrite, NULL, "}}");
+	ProfilePrintf(
+		ProfileTraceWrite, NULL, ",\n{\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":\"Frames\"}}",
+		(uint32_t)PROFILE_MAX_THREADS);
+	ProfilePrintf(
+		ProfileTraceWrite, NULL, ",\n{\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"name\":\"thread_sort_index\",\"args\":{\"sort_index\":-1}}",
+		(uint32_t)PROFILE_MAX_THREADS);
+}
+
+void stopProfileTrace()
+{
+	MutexLock lock(ProfileMutex());
+	ProfileTraceClose();
+}
+
+bool isProfileTraceActive() { return gProfileTrace.bActive; }
+
+// Continuous capture to disk.
+// ProfileFlipCpu copies every frame's log entries into fixed size staging chunks and a writer thread delta encodes them
+// into the capture file, so captures can run for hours with bounded memory. If the writer falls behind and every chunk
+// is in use, frames are dropped instead of stalling the frame.
+#ifndef PROFILE_CAPTURE_CHUNK_SIZE
+#define PROFILE_CAPTURE_CHUNK_SIZE (2 << 20)
+#endif
+#ifndef PROFILE_CAPTURE_CHUNK_COUNT
+#define PROFILE_CAPTURE_CHUNK_COUNT 4
+#endif
+#define PROFILE_CAPTURE_MAGIC 0x43504654    // "TFPC"
+#define PROFILE_CAPTURE_VERSION 1
+#define PROFILE_CAPTURE_IO_BUFFER_SIZE (64 << 10)
+
+// Record types, the same in the staging chunks and the file.
+// Staging records use fixed size fields, the file uses LEB128 varints, zigzag encoded deltas for ticks
+// and length prefixed strings.
+enum ProfileCaptureRecord
+{
+	PROFILE_CAPTURE_RECORD_TIMER = 1,    // timer index, gpu, group name, timer name
+	PROFILE_CAPTURE_RECORD_THREAD,       // thread index, gpu, ticks per second, thread name
+	PROFILE_CAPTURE_RECORD_FRAME,        // frame index, start tick, end tick, thread count, per thread log entries
+	PROFILE_CAPTURE_RECORD_END,          // dropped frame count
+};
+
+struct ProfileCaptureChunk
+{
+	uint8_t* pData;
+	uint32_t nSize;
+};
+
+struct ProfileCapture
+{
+	FileStream          mFile;
+	ProfileCaptureChunk mChunks[PROFILE_CAPTURE_CHUNK_COUNT];
+	// Submitted chunks in order, protected by the writer mutex
+	uint32_t nQueue[PROFILE_CAPTURE_CHUNK_COUNT];
+	uint32_t nQueueGet;
+	uint32_t nQueueCount;
+	uint32_t nFreeMask;
+	bool     bActive;
+
+	// Staging state, only used by ProfileFlipCpu
+	int32_t  nFillChunk;
+	uint32_t nTimersStaged;
+	bool     bThreadStaged[PROFILE_MAX_THREADS];
+	uint64_t nFrames;
+	uint64_t nDroppedFrames;
+
+	// Encoding state, only used by the writer thread
+	uint8_t* pOut;
+	uint32_t nOutPut;
+	uint32_t nPrevFrameIndex;
+	int64_t  nPrevFrameStart;
+	int64_t  nPrevTick[PROFILE_MAX_THREADS];
+};
+
+static ProfileCapture gProfileCapture = {};
+
+static bool ProfileCaptureStage(ProfileCaptureChunk* pChunk, const void* pData, size_t nSize)
+{
+	if (pChunk->nSize + nSize > PROFILE_CAPTURE_CHUNK_SIZE)
+		return false;
+	memcpy(pChunk->pData + pChunk->nSize, pData, nSize);
+	pChunk->nSize += (uint32_t)nSize;
+	return true;
+}
+
+template<typename T> static bool ProfileCaptureStageValue(ProfileCaptureChunk* pChunk, T value)
+{
+	return ProfileCaptureStage(pChunk, &value, sizeof(value));
+}
+
+static bool ProfileCaptureStageString(ProfileCaptureChunk* pChunk, const char* pString)
+{
+	uint16_t nLen = pString ? (uint16_t)min(strlen(pString), (size_t)UINT16_MAX) : 0;
+	return ProfileCaptureStageValue(pChunk, nLen) && ProfileCaptureStage(pChunk, pString, nLen);
+}
+
+static bool ProfileCaptureStageFrame(ProfileCaptureChunk* pChunk)
+{
+	ProfileCapture& C = gProfileCapture;
+	Profile&        S = g_Profile;
+	const uint32_t  nChunkStart = pChunk->nSize;
+	bool            bOk = true;
+
+	// Timers and threads that showed up since the last staged frame
+	for (uint32_t i = C.nTimersStaged; bOk && i < S.nTotalTimers; ++i)
+	{
+		const ProfileGroupInfo& Group = S.GroupInfo[S.TimerInfo[i].nGroupIndex];
+		bOk = ProfileCaptureStageValue<uint8_t>(pChunk, PROFILE_CAPTURE_RECORD_TIMER) && ProfileCaptureStageValue<uint32_t>(pChunk, i) &&
+			  ProfileCaptureStageValue<uint8_t>(pChunk, Group.Type == ProfileTokenTypeGpu) && ProfileCaptureStageString(pChunk, Group.pName) &&
+			  ProfileCaptureStageString(pChunk, S.TimerInfo[i].pName);
+	}
+
+	bool bThreadNew[PROFILE_MAX_THREADS] = {};
+	for (uint32_t j = 0; bOk && j < PROFILE_MAX_THREADS; ++j)
+	{
+		ProfileThreadLog* pLog = S.Pool[j];
+		if (!pLog || !pLog->Log || C.bThreadStaged[j])
+			continue;
+		uint64_t nTicksPerSecond = pLog->nGpu ? getGpuProfileTicksPerSecond(pLog->nGpuToken) : (uint64_t)ProfileTicksPerSecondCpu();
+		bOk = ProfileCaptureStageValue<uint8_t>(pChunk, PROFILE_CAPTURE_RECORD_THREAD) && ProfileCaptureStageValue<uint32_t>(pChunk, j) &&
+			  ProfileCaptureStageValue<uint8_t>(pChunk, pLog->nGpu != 0) && ProfileCaptureStageValue<uint64_t>(pChunk, nTicksPerSecond) &&
+			  ProfileCaptureStageString(pChunk, pLog->ThreadName);
+		bThreadNew[j] = true;
+	}
+
+	const uint32_t           nFrame = S.nFrameCurrent;
+	const ProfileFrameState& Frame = S.Frames[nFrame];
+	const ProfileFrameState& FrameNext = S.Frames[(nFrame + 1) % PROFILE_MAX_FRAME_HISTORY];
+
+	bOk = bOk && ProfileCaptureStageValue<uint8_t>(pChunk, PROFILE_CAPTURE_RECORD_FRAME) &&
+		  ProfileCaptureStageValue<uint32_t>(pChunk, S.nFrameCurrentIndex) && ProfileCaptureStageValue<int64_t>(pChunk, Frame.nFrameStartCpu) &&
+		  ProfileCaptureStageValue<int64_t>(pChunk, FrameNext.nFrameStartCpu);
+	const uint32_t nThreadCountOffset = pChunk->nSize;
+	uint32_t       nThreadCount = 0;
+	bOk = bOk && ProfileCaptureStageValue<uint32_t>(pChunk, nThreadCount);
+
+	for (uint32_t j = 0; bOk && j < PROFILE_MAX_THREADS; ++j)
+	{
+		ProfileThreadLog* pLog = S.Pool[j];
+		if (!pLog || !pLog->Log || !(C.bThreadStaged[j] || bThreadNew[j]))
+			continue;
+
+		const uint32_t nLogStart = Frame.nLogStart[j];
+		const uint32_t nLogEnd = FrameNext.nLogStart[j];
+		if (nLogStart == nLogEnd)
+			continue;
+
+		uint32_t nRange[2][2] = {
+			{ 0, 0 },
+			{ 0, 0 },
+		};
+		ProfileGetRange(nLogEnd, nLogStart, nRange);
+		const uint32_t nCount = (nRange[0][1] - nRange[0][0]) + (nRange[1][1] - nRange[1][0]);
+
+		bOk = ProfileCaptureStageValue<uint32_t>(pChunk, j) && ProfileCaptureStageValue<uint32_t>(pChunk, nCount);
+		for (uint32_t r = 0; bOk && r < 2; ++r)
+		{
+			bOk = ProfileCaptureStage(pChunk, &pLog->Log[nRange[r][0]], (nRange[r][1] - nRange[r][0]) * sizeof(ProfileLogEntry));
+		}
+		// Label text is resolved now, the label buffer wraps before the writer gets to it
+		for (uint32_t k = nLogStart; bOk && k != nLogEnd; k = (k + 1) % PROFILE_BUFFER_SIZE)
+		{
+			const uint32_t nType = (uint32_t)ProfileLogType(pLog->Log[k]);
+			if (nType == P_LOG_LABEL || nType == P_LOG_LABEL_LITERAL)
+			{
+				bOk = ProfileCaptureStageString(pChunk, ProfileGetLabel(nType, ProfileLogGetTick(pLog->Log[k])));
+			}
+		}
+		++nThreadCount;
+	}
+
+	if (!bOk)
+	{
+		pChunk->nSize = nChunkStart;
+		return false;
+	}
+
+	memcpy(pChunk->pData + nThreadCountOffset, &nThreadCount, sizeof(nThreadCount));
+	C.nTimersStaged = S.nTotalTimers;
+	for (uint32_t j = 0; j < PROFILE_MAX_THREADS; ++j)
+	{
+		C.bThreadStaged[j] = C.bThreadStaged[j] || bThreadNew[j];
+	}
+	return true;
+}
+
+static bool ProfileCaptureAcquireChunk()
+{
+	ProfileCapture& C = gProfileCapture;
+	ProfileWriter&  W = gProfileWriter;
+	acquireMutex(&W.mMutex);
+	for (uint32_t i = 0; i < PROFILE_CAPTURE_CHUNK_COUNT; ++i)
+	{
+		if (C.nFreeMask & (1u << i))
+		{
+			C.nFreeMask &= ~(1u << i);
+			C.nFillChunk = (int32_t)i;
+			C.mChunks[i].nSize = 0;
+			break;
+		}
+	}
+	releaseMutex(&W.mMutex);
+	return C.nFillChunk >= 0;
+}
+
+static void ProfileCaptureSubmitChunk()
+{
+	ProfileCapture& C = gProfileCapture;
+	ProfileWriter&  W = gProfileWriter;
+	if (C.nFillChunk < 0)
+		return;
+
+	acquireMutex(&W.mMutex);
+	C.nQueue[(C.nQueueGet + C.nQueueCount) % PROFILE_CAPTURE_CHUNK_COUNT] = (uint32_t)C.nFillChunk;
+	C.nQueueCount++;
+	wakeOneConditionVariable(&W.mCond);
+	releaseMutex(&W.mMutex);
+	C.nFillChunk = -1;
+}
+
+// Called from ProfileFlipCpu with the profile mutex held
+void ProfileCaptureFlip()
+{
+	ProfileCapture& C = gProfileCapture;
+	if (!C.bActive)
+		return;
+
+	for (uint32_t nAttempt = 0; nAttempt < 2; ++nAttempt)
+	{
+		if (C.nFillChunk < 0 && !ProfileCaptureAcquireChunk())
+			break;
+		if (ProfileCaptureStageFrame(&C.mChunks[C.nFillChunk]))
+		{
+			++C.nFrames;
+			return;
+		}
+		// Frame does not fit in an empty chunk
+		if (!C.mChunks[C.nFillChunk].nSize)
+			break;
+		ProfileCaptureSubmitChunk();
+	}
+	++C.nDroppedFrames;
+}
+
+static void ProfileCaptureFlushOut()
+{
+	ProfileCapture& C = gProfileCapture;
+	if (C.nOutPut)
+	{
+		fsWriteToStream(&C.mFile, C.pOut, C.nOutPut);
+		C.nOutPut = 0;
+	}
+}
+
+static void ProfileCaptureReserve(uint32_t nSize)
+{
+	ProfileCapture& C = gProfileCapture;
+	P_ASSERT(nSize <= PROFILE_CAPTURE_IO_BUFFER_SIZE);
+	if (C.nOutPut + nSize > PROFILE_CAPTURE_IO_BUFFER_SIZE)
+		ProfileCaptureFlushOut();
+}
+
+static void ProfileCapturePutVarint(uint64_t nValue)
+{
+	ProfileCapture& C = gProfileCapture;
+	ProfileCaptureReserve(10);
+	while (nValue >= 0x80)
+	{
+		C.pOut[C.nOutPut++] = (uint8_t)(nValue | 0x80);
+		nValue >>= 7;
+	}
+	C.pOut[C.nOutPut++] = (uint8_t)nValue;
+}
+
+static inline uint64_t ProfileCaptureZigZag(int64_t nValue) { return ((uint64_t)nValue << 1) ^ (uint64_t)(nValue >> 63); }
+
+static void ProfileCapturePutString(const char* pString, uint32_t nLen)
+{
+	ProfileCapture& C = gProfileCapture;
+	ProfileCapturePutVarint(nLen);
+	ProfileCaptureReserve(nLen);
+	memcpy(C.pOut + C.nOutPut, pString, nLen);
+	C.nOutPut += nLen;
+}
+
+template<typename T> static T ProfileCaptureTake(const uint8_t*& pData)
+{
+	T value;
+	memcpy(&value, pData, sizeof(T));
+	pData += sizeof(T);
+	return value;
+}
+
+static void ProfileCaptureTakeString(const uint8_t*& pData)
+{
+	uint16_t nLen = ProfileCaptureTake<uint16_t>(pData);
+	ProfileCapturePutString((const char*)pData, nLen);
+	pData += nLen;
+}
+
+static void ProfileCaptureEncodeChunk(const ProfileCaptureChunk* pChunk)
+{
+	ProfileCapture& C = gProfileCapture;
+	const uint8_t*  pData = pChunk->pData;
+	const uint8_t*  pEnd = pChunk->pData + pChunk->nSize;
+	while (pData < pEnd)
+	{
+		const uint8_t nRecord = ProfileCaptureTake<uint8_t>(pData);
+		ProfileCapturePutVarint(nRecord);
+		if (nRecord == PROFILE_CAPTURE_RECORD_TIMER)
+		{
+			ProfileCapturePutVarint(ProfileCaptureTake<uint32_t>(pData));
+			ProfileCapturePutVarint(ProfileCaptureTake<uint8_t>(pData));
+			ProfileCaptureTakeString(pData);
+			ProfileCaptureTakeString(pData);
+		}
+		else if (nRecord == PROFILE_CAPTURE_RECORD_THREAD)
+		{
+			ProfileCapturePutVarint(ProfileCaptureTake<uint32_t>(pData));
+			ProfileCapturePutVarint(ProfileCaptureTake<uint8_t>(pData));
+			ProfileCapturePutVarint(ProfileCaptureTake<uint64_t>(pData));
+			ProfileCaptureTakeString(pData);
+		}
+		else
+		{
+			P_ASSERT(nRecord == PROFILE_CAPTURE_RECORD_FRAME);
+			const uint32_t nFrameIndex = ProfileCaptureTake<uint32_t>(pData);
+			const int64_t  nFrameStart = ProfileCaptureTake<int64_t>(pData);
+			const int64_t  nFrameEnd = ProfileCaptureTake<int64_t>(pData);
+			const uint32_t nThreadCount = ProfileCaptureTake<uint32_t>(pData);
+			ProfileCapturePutVarint(nFrameIndex - C.nPrevFrameIndex);
+			ProfileCapturePutVarint(ProfileCaptureZigZag(nFrameStart - C.nPrevFrameStart));
+			ProfileCapturePutVarint(ProfileCaptureZigZag(nFrameEnd - nFrameStart));
+			ProfileCapturePutVarint(nThreadCount);
+			C.nPrevFrameIndex = nFrameIndex;
+			C.nPrevFrameStart = nFrameStart;
+
+			for (uint32_t t = 0; t < nThreadCount; ++t)
+			{
+				const uint32_t nThread = ProfileCaptureTake<uint32_t>(pData);
+				const uint32_t nCount = ProfileCaptureTake<uint32_t>(pData);
+				ProfileCapturePutVarint(nThread);
+				ProfileCapturePutVarint(nCount);
+
+				const uint8_t* pEntries = pData;
+				pData += nCount * sizeof(ProfileLogEntry);
+				for (uint32_t k = 0; k < nCount; ++k)
+				{
+					const ProfileLogEntry LE = ProfileCaptureTake<ProfileLogEntry>(pEntries);
+					const uint64_t        nType = ProfileLogType(LE);
+					ProfileCapturePutVarint(nType | (ProfileLogTimerIndex(LE) << 3));
+					if (nType == P_LOG_ENTER || nType == P_LOG_LEAVE || nType == P_LOG_GPU_EXTRA)
+					{
+						// Ticks are 48 bit, consecutive entries of one thread are close to each other
+						const int64_t nTick = ProfileLogGetTick(LE);
+						ProfileCapturePutVarint(ProfileCaptureZigZag(ProfileLogTickDifference(C.nPrevTick[nThread], nTick)));
+						C.nPrevTick[nThread] = nTick;
+					}
+					else if (nType == P_LOG_META)
+					{
+						ProfileCapturePutVarint(ProfileLogGetTick(LE));
+					}
+					else
+					{
+						// Label strings follow the entries in the order of the label entries
+						ProfileCaptureTakeString(pData);
+					}
+				}
+			}
+		}
+	}
+}
+
+// Writer thread side, pops one submitted chunk and encodes it. Returns false if none was queued
+static bool ProfileCaptureWriteQueued()
+{
+	ProfileCapture& C = gProfileCapture;
+	ProfileWriter&  W = gProfileWriter;
+	acquireMutex(&W.mMutex);
+	if (!C.nQueueCount)
+	{
+		releaseMutex(&W.mMutex);
+		return false;
+	}
+	const uint32_t nChunk = C.nQueue[C.nQueueGet];
+	releaseMutex(&W.mMutex);
+
+	ProfileCaptureEncodeChunk(&C.mChunks[nChunk]);
+	ProfileCaptureFlushOut();
+
+	acquireMutex(&W.mMutex);
+	C.nQueueGet = (C.nQueueGet + 1) % PROFILE_CAPTURE_CHUNK_COUNT;
+	C.nQueueCount--;
+	C.nFreeMask |= 1u << nChunk;
+	wakeAllConditionVariable(&W.mDoneCond);
+	releaseMutex(&W.mMutex);
+	return true;
+}
+
+static void ProfileWriterThread(void* pUserData)
+{
+	(void)pUserData;
+	ProfileWriter&  W = gProfileWriter;
+	ProfileTrace&   T = gProfileTrace;
+	ProfileCapture& C = gProfileCapture;
+	for (;;)
+	{
+		acquireMutex(&W.mMutex);
+		while (!T.nQueueCount && !C.nQueueCount && !W.bExit)
+		{
+			waitConditionVariable(&W.mCond, &W.mMutex, TIMEOUT_INFINITE);
+		}
+		const bool bExit = !T.nQueueCount && !C.nQueueCount;
+		releaseMutex(&W.mMutex);
+		if (bExit)
+			break;
+
+		ProfileTraceWriteQueued();
+		ProfileCaptureWriteQueued();
+	}
+}
+
+void startProfileCapture(const char* pFileName)
+{
+	MutexLock lock(ProfileMutex());
+	ProfileCapture& C = gProfileCapture;
+	if (C.bActive)
+	{
+		LOGF(LogLevel::eWARNING, "Profile capture already running, %s not started", pFileName);
+		return;
+	}
+
+	memset(&C, 0, sizeof(C));
+	if (!fsOpenStreamFromPath(RD_LOG, pFileName, FM_WRITE_BINARY, NULL, &C.mFile))
+	{
+		LOGF(LogLevel::eERROR, "Failed to open profile capture file %s", pFileName);
+		return;
+	}
+
+	for (uint32_t i = 0; i < PROFILE_CAPTURE_CHUNK_COUNT; ++i)
+	{
+		C.mChunks[i].pData = (uint8_t*)tf_malloc(PROFILE_CAPTURE_CHUNK_SIZE);
+	}
+	C.nFreeMask = (1u << PROFILE_CAPTURE_CHUNK_COUNT) - 1;
+	C.nFillChunk = -1;
+	C.pOut = (uint8_t*)tf_malloc(PROFILE_CAPTURE_IO_BUFFER_SIZE);
+
+	const uint32_t nHeader[2] = { PROFILE_CAPTURE_MAGIC, PROFILE_CAPTURE_VERSION };
+	fsWriteToStream(&C.mFile, nHeader, sizeof(nHeader));
+	ProfileCapturePutVarint((uint64_t)ProfileTicksPerSecondCpu());
+
+	C.bActive = true;
+	ProfileWriterStart();
+}
+
+void stopProfileCapture()
+{
+	ProfileCapture& C = gProfileCapture;
+	{
+		MutexLock lock(ProfileMutex());
+		if (!C.bActive)
+			return;
+		C.bActive = false;
+		ProfileCaptureSubmitChunk();
+	}
+
+	// The writer may keep running for the trace, wait for our chunks only
+	ProfileWriter& W = gProfileWriter;
+	acquireMutex(&W.mMutex);
+	while (C.nQueueCount)
+	{
+		waitConditionVariable(&W.mDoneCond, &W.mMutex, TIMEOUT_INFINITE);
+	}
+	releaseMutex(&W.mMutex);
+	{
+		MutexLock lock(ProfileMutex());
+		ProfileWriterStop();
+	}
+
+	ProfileCapturePutVarint(PROFILE_CAPTURE_RECORD_END);
+	ProfileCapturePutVarint(C.nDroppedFrames);
+	ProfileCaptureFlushOut();
+	fsCloseStream(&C.mFile);
+
+	if (C.nDroppedFrames)
+	{
+		LOGF(
+			LogLevel::eWARNING, "Profile capture dropped %llu of %llu frames, the writer could not keep up", (unsigned long long)C.nDroppedFrames,
+			(unsigned long long)(C.nFrames + C.nDroppedFrames));
+	}
+
+	for (uint32_t i = 0; i < PROFILE_CAPTURE_CHUNK_COUNT; ++i)
+	{
+		tf_free(C.mChunks[i].pData);
+	}
+	tf_free(C.pOut);
+	memset(&C, 0, sizeof(C));
+}
+
+// Capture reader. Streams the file through a fixed buffer, memory use does not depend on the capture length.
+struct ProfileCaptureReader
+{
+	FileStream mFile;
+	uint8_t*   pBuffer;
+	uint32_t   nPos;
+	uint32_t   nSize;
+	bool       bEof;
+};
+
+struct ProfileCaptureScope
+{
+	uint32_t nTimer;
+	int64_t  nStart;
+	int64_t  nChildTicks;
+};
+
+struct ProfileCaptureReaderThread
+{
+	uint64_t            nTicksPerSecond;
+	int64_t             nPrevTick;
+	bool                bGpu;
+	uint32_t            nStackPos;
+	ProfileCaptureScope Stack[PROFILE_STACK_MAX];
+};
+
+static bool ProfileCaptureReadByte(ProfileCaptureReader* pReader, uint8_t* pOut)
+{
+	if (pReader->nPos == pReader->nSize)
+	{
+		pReader->nPos = 0;
+		pReader->nSize = pReader->bEof ? 0 : (uint32_t)fsReadFromStream(&pReader->mFile, pReader->pBuffer, PROFILE_CAPTURE_IO_BUFFER_SIZE);
+		if (!pReader->nSize)
+		{
+			pReader->bEof = true;
+			return false;
+		}
+	}
+	*pOut = pReader->pBuffer[pReader->nPos++];
+	return true;
+}
+
+static uint64_t ProfileCaptureReadVarint(ProfileCaptureReader* pReader)
+{
+	uint64_t nValue = 0;
+	uint8_t  nByte = 0;
+	for (uint32_t nShift = 0; nShift < 64 && ProfileCaptureReadByte(pReader, &nByte); nShift += 7)
+	{
+		nValue |= (uint64_t)(nByte & 0x7f) << nShift;
+		if (!(nByte & 0x80))
+			break;
+	}
+	return nValue;
+}
+
+static inline int64_t ProfileCaptureReadZigZag(ProfileCaptureReader* pReader)
+{
+	uint64_t nValue = ProfileCaptureReadVarint(pReader);
+	return (int64_t)(nValue >> 1) ^ -(int64_t)(nValue & 1);
+}
+
+static void ProfileCaptureReadString(ProfileCaptureReader* pReader, char* pOut, uint32_t nOutSize)
+{
+	uint64_t nLen = ProfileCaptureReadVarint(pReader);
+	uint32_t nPut = 0;
+	for (uint64_t i = 0; i < nLen; ++i)
+	{
+		uint8_t c = 0;
+		if (!ProfileCaptureReadByte(pReader, &c))
+			break;
+		if (pOut && nPut + 1 < nOutSize)
+			pOut[nPut++] = (char)c;
+	}
+	if (pOut)
+		pOut[nPut] = '\0';
+}
+
+uint32_t getProfileCaptureWorstFrames(const char* pFileName, ProfileCaptureFrame* pFrames, uint32_t maxFrames)
+{
+	ProfileCaptureReader reader = {};
+	if (!fsOpenStreamFromPath(RD_LOG, pFileName, FM_READ_BINARY, NULL, &reader.mFile))
+	{
+		LOGF(LogLevel::eERROR, "Failed to open profile capture file %s", pFileName);
+		return 0;
+	}
+
+	uint32_t nHeader[2] = {};
+	fsReadFromStream(&reader.mFile, nHeader, sizeof(nHeader));
+	if (nHeader[0] != PROFILE_CAPTURE_MAGIC || nHeader[1] != PROFILE_CAPTURE_VERSION)
+	{
+		LOGF(LogLevel::eERROR, "%s is not a version %u profile capture", pFileName, PROFILE_CAPTURE_VERSION);
+		fsCloseStream(&reader.mFile);
+		return 0;
+	}
+
+	typedef char TimerName[PROFILE_NAME_MAX_LEN];
+	reader.pBuffer = (uint8_t*)tf_malloc(PROFILE_CAPTURE_IO_BUFFER_SIZE);
+	TimerName*                  pTimerNames = (TimerName*)tf_calloc(PROFILE_MAX_TIMERS, sizeof(TimerName));
+	ProfileCaptureReaderThread* pThreads = (ProfileCaptureReaderThread*)tf_calloc(PROFILE_MAX_THREADS, sizeof(ProfileCaptureReaderThread));
+
+	const double fToMsCpu = 1000.0 / (double)ProfileCaptureReadVarint(&reader);
+	uint32_t     nFrameIndex = 0;
+	int64_t      nFrameStart = 0;
+	uint32_t     nFrameCount = 0;
+
+	while (!reader.bEof)
+	{
+		const uint64_t nRecord = ProfileCaptureReadVarint(&reader);
+		if (reader.bEof || nRecord == PROFILE_CAPTURE_RECORD_END)
+			break;
+
+		if (nRecord == PROFILE_CAPTURE_RECORD_TIMER)
+		{
+			const uint64_t nTimer = ProfileCaptureReadVarint(&reader);
+			ProfileCaptureReadVarint(&reader);
+			ProfileCaptureReadString(&reader, NULL, 0);
+			ProfileCaptureReadString(&reader, nTimer < PROFILE_MAX_TIMERS ? pTimerNames[nTimer] : NULL, sizeof(TimerName));
+			continue;
+		}
+		if (nRecord == PROFILE_CAPTURE_RECORD_THREAD)
+		{
+			const uint64_t              nThread = ProfileCaptureReadVarint(&reader);
+			ProfileCaptureReaderThread* pThread = &pThreads[nThread % PROFILE_MAX_THREADS];
+			pThread->bGpu = ProfileCaptureReadVarint(&reader) != 0;
+			pThread->nTicksPerSecond = ProfileCaptureReadVarint(&reader);
+			ProfileCaptureReadString(&reader, NULL, 0);
+			continue;
+		}
+		if (nRecord != PROFILE_CAPTURE_RECORD_FRAME)
+		{
+			LOGF(LogLevel::eERROR, "Unknown record %llu in profile capture %s", (unsigned long long)nRecord, pFileName);
+			break;
+		}
+
+		ProfileCaptureFrame frame = {};
+		nFrameIndex += (uint32_t)ProfileCaptureReadVarint(&reader);
+		nFrameStart += ProfileCaptureReadZigZag(&reader);
+		frame.mFrameIndex = nFrameIndex;
+		frame.mCpuMs = (float)(ProfileCaptureReadZigZag(&reader) * fToMsCpu);
+
+		uint32_t nLongestTimer = UINT32_MAX;
+		int64_t  nLongestTicks = 0;
+		double   fLongestToMs = 0.0;
+
+		const uint64_t nThreadCount = ProfileCaptureReadVarint(&reader);
+		for (uint64_t t = 0; t < nThreadCount && !reader.bEof; ++t)
+		{
+			ProfileCaptureReaderThread* pThread = &pThreads[ProfileCaptureReadVarint(&reader) % PROFILE_MAX_THREADS];
+			const double                fToMs = pThread->nTicksPerSecond ? 1000.0 / (double)pThread->nTicksPerSecond : 0.0;
+			int64_t                     nGpuStart = 0;
+			int64_t                     nGpuEnd = 0;
+			bool                        bGpuStarted = false;
+
+			const uint64_t nCount = ProfileCaptureReadVarint(&reader);
+			for (uint64_t k = 0; k < nCount && !reader.bEof; ++k)
+			{
+				const uint64_t nTypeTimer = ProfileCaptureReadVarint(&reader);
+				const uint64_t nType = nTypeTimer & 7;
+				const uint32_t nTimer = (uint32_t)(nTypeTimer >> 3);
+				if (nType == P_LOG_META)
+				{
+					ProfileCaptureReadVarint(&reader);
+					continue;
+				}
+				if (nType == P_LOG_LABEL || nType == P_LOG_LABEL_LITERAL)
+				{
+					ProfileCaptureReadString(&reader, NULL, 0);
+					continue;
+				}
+
+				const int64_t nTick = (int64_t)(((uint64_t)pThread->nPrevTick + (uint64_t)ProfileCaptureReadZigZag(&reader)) & P_LOG_TICK_MASK);
+				pThread->nPrevTick = nTick;
+				if (nType == P_LOG_ENTER)
+				{
+					if (pThread->bGpu && !pThread->nStackPos && !bGpuStarted)
+					{
+						nGpuStart = nTick;
+						bGpuStarted = true;
+					}
+					if (pThread->nStackPos < PROFILE_STACK_MAX)
+					{
+						ProfileCaptureScope* pScope = &pThread->Stack[pThread->nStackPos];
+						pScope->nTimer = nTimer;
+						pScope->nStart = nTick;
+						pScope->nChildTicks = 0;
+					}
+					pThread->nStackPos++;
+				}
+				else if (nType == P_LOG_LEAVE && pThread->nStackPos)
+				{
+					pThread->nStackPos--;
+					if (pThread->nStackPos >= PROFILE_STACK_MAX)
+						continue;
+
+					const ProfileCaptureScope* pScope = &pThread->Stack[pThread->nStackPos];
+					const int64_t              nTicks = ProfileLogTickDifference(pScope->nStart, nTick);
+					if (pThread->nStackPos)
+						pThread->Stack[pThread->nStackPos - 1].nChildTicks += nTicks;
+					if (pThread->bGpu)
+					{
+						if (!pThread->nStackPos)
+							nGpuEnd = nTick;
+					}
+					else if ((nTicks - pScope->nChildTicks) * fToMs > nLongestTicks * fLongestToMs)
+					{
+						nLongestTimer = pScope->nTimer;
+						nLongestTicks = nTicks - pScope->nChildTicks;
+						fLongestToMs = fToMs;
+					}
+				}
+			}
+
+			if (bGpuStarted)
+			{
+				frame.mGpuMs = max(frame.mGpuMs, (float)(ProfileLogTickDifference(nGpuStart, nGpuEnd) * fToMs));
+			}
+		}
+
+		if (nLongestTimer < PROFILE_MAX_TIMERS)
+		{
+			strncpy(frame.mLongestScope, pTimerNames[nLongestTimer], sizeof(frame.mLongestScope) - 1);
+			frame.mLongestScopeMs = (float)(nLongestTicks * fLongestToMs);
+		}
+
+		// Keep the slowest frames sorted, slowest first
+		uint32_t nInsert = nFrameCount;
+		while (nInsert && pFrames[nInsert - 1].mCpuMs < frame.mCpuMs)
+		{
+			--nInsert;
+		}
+		if (nInsert < maxFrames)
+		{
+			const uint32_t nMove = min(nFrameCount, maxFrames - 1) - nInsert;
+			memmove(&pFrames[nInsert + 1], &pFrames[nInsert], nMove * sizeof(ProfileCaptureFrame));
+			pFrames[nInsert] = frame;
+			nFrameCount = min(nFrameCount + 1, maxFrames);
+		}
+	}
+
+	tf_free(pThreads);
+	tf_free(pTimerNames);
+	tf_free(reader.pBuffer);
+	fsCloseStream(&reader.mFile);
+	return nFrameCount;
+}
+
+// Hitch detection. flipProfiler compares every frame against the thresholds of setProfileHitchDetection and,
+// mFramesAfter frames after a hitch, dumps the surrounding frames while they are still in the frame history.
+#define PROFILE_HITCH_HISTORY 256
+#define PROFILE_HITCH_PERCENTILE_INTERVAL 16
+
+struct ProfileHitchDetector
+{
+	ProfileHitchDesc mDesc;
+	char             AppName[64];
+	bool             bEnabled;
+	uint32_t         nLastFrameIndex;
+
+	// Frame times of the last PROFILE_HITCH_HISTORY frames
+	uint32_t nFrameIndex[PROFILE_HITCH_HISTORY];
+	float    fCpuMs[PROFILE_HITCH_HISTORY];
+	float    fGpuMs[PROFILE_HITCH_HISTORY];
+	uint32_t nHistoryPut;
+	uint32_t nHistoryCount;
+	float    fCpuPercentileMs;
+	float    fGpuPercentileMs;
+
+	// Hitch waiting for its following frames
+	bool         bPending;
+	uint32_t     nDumpCountdown;
+	ProfileHitch mHitch;
+	int64_t      nHitchCounters[PROFILE_MAX_COUNTERS];
+	char         TimelineFileName[160];
+	char         SummaryFileName[160];
+
+	int64_t  nLastDumpTick;
+	uint32_t nSuppressFrames;
+	uint64_t nRateLimitedCount;
+};
+
+static ProfileHitchDetector gProfileHitch = {};
+
+static float ProfileHitchPercentile(const float* pValues, uint32_t nCount, float fPercentile)
+{
+	float sorted[PROFILE_HITCH_HISTORY];
+	memcpy(sorted, pValues, nCount * sizeof(float));
+	eastl::sort(sorted, sorted + nCount);
+	return sorted[min((uint32_t)(fPercentile * nCount), nCount - 1)];
+}
+
+// Largest of the enabled thresholds, 0 if none is enabled yet
+static float ProfileHitchThreshold(float fFixedMs, float fPercentileMs)
+{
+	const ProfileHitchDesc& D = gProfileHitch.mDesc;
+	float                   fThreshold = max(fFixedMs, 0.0f);
+	if (D.mPercentile > 0.0f && fPercentileMs > 0.0f)
+		fThreshold = max(fThreshold, fPercentileMs * D.mPercentileScale);
+	return fThreshold;
+}
+
+static void ProfileHitchDump(uint32_t nFrames)
+{
+	ProfileHitchDetector& H = gProfileHitch;
+	Profile&              S = g_Profile;
+
+	FileStream fh = {};
+	if (fsOpenStreamFromPath(RD_LOG, H.TimelineFileName, FM_WRITE, NULL, &fh))
+	{
+		ProfileDumpHtml(ProfileWriteFile, &fh, nFrames, 0);
+		fsCloseStream(&fh);
+	}
+
+	if (!fsOpenStreamFromPath(RD_LOG, H.SummaryFileName, FM_WRITE, NULL, &fh))
+	{
+		LOGF(LogLevel::eERROR, "Failed to open hitch summary %s", H.SummaryFileName);
+		return;
+	}
+
+	const ProfileHitch& Hitch = H.mHitch;
+	ProfilePrintf(
+		ProfileWriteFile, &fh, "{\n\"Frame\": %u,\n\"CpuMs\": %.4f,\n\"GpuMs\": %.4f,\n\"CpuThresholdMs\": %.4f,\n\"GpuThresholdMs\": %.4f,\n",
+		Hitch.mFrameIndex, Hitch.mCpuMs, Hitch.mGpuMs, Hitch.mCpuThresholdMs, Hitch.mGpuThresholdMs);
+	ProfilePrintString(ProfileWriteFile, &fh, "\"Timeline\": ");
+	ProfileWriteJsonString(ProfileWriteFile, &fh, H.TimelineFileName);
+
+	ProfilePrintString(ProfileWriteFile, &fh, ",\n\"Frames\": [");
+	const uint32_t nHistoryFrames = min(nFrames, H.nHistoryCount);
+	for (uint32_t i = 0; i < nHistoryFrames; ++i)
+	{
+		const uint32_t nIndex = (H.nHistoryPut + PROFILE_HITCH_HISTORY - nHistoryFrames + i) % PROFILE_HITCH_HISTORY;
+		ProfilePrintf(
+			ProfileWriteFile, &fh, "%s\n{ \"Frame\": %u, \"CpuMs\": %.4f, \"GpuMs\": %.4f }", i ? "," : "", H.nFrameIndex[nIndex], H.fCpuMs[nIndex],
+			H.fGpuMs[nIndex]);
+	}
+
+	// Counter values when the hitch was detected and now, after the following frames
+	ProfilePrintString(ProfileWriteFile, &fh, "\n],\n\"Counters\": [");
+	bool bFirst = true;
+	for (uint32_t i = 0; i < S.nNumCounters; ++i)
+	{
+		if (!(S.CounterInfo[i].nFlags & PROFILE_COUNTER_FLAG_LEAF))
+			continue;
+
+		char name[PROFILE_NAME_MAX_LEN * 4];
+		ProfileTraceCounterName((int)i, name, sizeof(name));
+		ProfilePrintString(ProfileWriteFile, &fh, bFirst ? "\n{ \"Name\": " : ",\n{ \"Name\": ");
+		ProfileWriteJsonString(ProfileWriteFile, &fh, name);
+		ProfilePrintf(
+			ProfileWriteFile, &fh, ", \"AtHitch\": %lld, \"AfterHitch\": %lld }", (long long)H.nHitchCounters[i],
+			(long long)tfrg_atomic64_load_relaxed(&S.Counters[i]));
+		bFirst = false;
+	}
+	ProfilePrintString(ProfileWriteFile, &fh, "\n]\n}\n");
+	fsCloseStream(&fh);
+}
+
+// Called from flipProfiler after ProfileFlipCpu
+void ProfileHitchFlip()
+{
+	ProfileHitchDetector& H = gProfileHitch;
+	if (!H.bEnabled)
+		return;
+
+	ProfileHitch         hitch = {};
+	ProfileHitchCallback pCallback = NULL;
+	void*                pUserData = NULL;
+	{
+		MutexLock lock(ProfileMutex());
+		Profile&  S = g_Profile;
+		if (!H.bEnabled || S.nFrameCurrentIndex == H.nLastFrameIndex)
+			return;
+		H.nLastFrameIndex = S.nFrameCurrentIndex;
+
+		const ProfileHitchDesc& D = H.mDesc;
+		const float             fCpuMs = ProfileTickToMsMultiplier(ProfileTicksPerSecondCpu()) * S.nFlipTicks;
+		float                   fGpuMs = -1.0f;
+		for (uint32_t i = 0; i < S.nGroupCount; ++i)
+		{
+			if (S.GroupInfo[i].Type == ProfileTokenTypeGpu)
+				fGpuMs = max(fGpuMs, getGpuProfileTime(S.GroupInfo[i].nGpuProfileToken));
+		}
+
+		if (H.bPending)
+		{
+			if (H.nDumpCountdown)
+				--H.nDumpCountdown;
+		}
+		else if (H.nSuppressFrames)
+		{
+			// Frames right after a dump include the dump itself
+			--H.nSuppressFrames;
+		}
+		else
+		{
+			const float fCpuThreshold = ProfileHitchThreshold(D.mCpuThresholdMs, H.fCpuPercentileMs);
+			const float fGpuThreshold = ProfileHitchThreshold(D.mGpuThresholdMs, H.fGpuPercentileMs);
+			const bool  bHitch = (fCpuThreshold > 0.0f && fCpuMs > fCpuThreshold) || (fGpuThreshold > 0.0f && fGpuMs > fGpuThreshold);
+			if (bHitch)
+			{
+				const int64_t nTick = P_TICK();
+				if (H.nLastDumpTick && ProfileTickToMsMultiplier(ProfileTicksPerSecondCpu()) * (nTick - H.nLastDumpTick) <
+										   D.mMinDumpIntervalSec * 1000.0f)
+				{
+					H.nRateLimitedCount++;
+				}
+				else
+				{
+					H.bPending = true;
+					H.nDumpCountdown = D.mFramesAfter;
+					H.mHitch.mFrameIndex = S.nFrameCurrentIndex;
+					H.mHitch.mCpuMs = fCpuMs;
+					H.mHitch.mGpuMs = fGpuMs;
+					H.mHitch.mCpuThresholdMs = fCpuThreshold;
+					H.mHitch.mGpuThresholdMs = fGpuThreshold;
+					H.mHitch.mRateLimitedCount = H.nRateLimitedCount;
+					H.nRateLimitedCount = 0;
+					for (uint32_t i = 0; i < S.nNumCounters; ++i)
+					{
+						H.nHitchCounters[i] = tfrg_atomic64_load_relaxed(&S.Counters[i]);
+					}
+				}
+			}
+		}
+
+		H.nFrameIndex[H.nHistoryPut] = S.nFrameCurrentIndex;
+		H.fCpuMs[H.nHistoryPut] = fCpuMs;
+		H.fGpuMs[H.nHistoryPut] = fGpuMs;
+		H.nHistoryPut = (H.nHistoryPut + 1) % PROFILE_HITCH_HISTORY;
+		H.nHistoryCount = min(H.nHistoryCount + 1, (uint32_t)PROFILE_HITCH_HISTORY);
+		// Percentile thresholds start once the window is full and are refreshed every few frames
+		if (D.mPercentile > 0.0f && H.nHistoryCount == PROFILE_HITCH_HISTORY && !(H.nHistoryPut % PROFILE_HITCH_PERCENTILE_INTERVAL))
+		{
+			H.fCpuPercentileMs = ProfileHitchPercentile(H.fCpuMs, PROFILE_HITCH_HISTORY, D.mPercentile);
+			H.fGpuPercentileMs = ProfileHitchPercentile(H.fGpuMs, PROFILE_HITCH_HISTORY, D.mPercentile);
+		}
+
+		if (H.bPending && !H.nDumpCountdown)
+		{
+			const uint32_t nMaxFrames = PROFILE_MAX_FRAME_HISTORY - PROFILE_GPU_FRAME_DELAY - 3;
+			const uint32_t nFrames = min(D.mFramesBefore + 1 + D.mFramesAfter, nMaxFrames);
+
+			time_t t = time(0);
+			char   tempName[128];
+			char   dateName[128] = {};
+			snprintf(tempName, sizeof(tempName), "%sHitch-%%Y-%%m-%%d-%%H.%%M.%%S", H.AppName);
+			strftime(dateName, sizeof(dateName), tempName, localtime(&t));
+			snprintf(H.TimelineFileName, sizeof(H.TimelineFileName), "%s-%u.html", dateName, H.mHitch.mFrameIndex);
+			snprintf(H.SummaryFileName, sizeof(H.SummaryFileName), "%s-%u.json", dateName, H.mHitch.mFrameIndex);
+			H.mHitch.pTimelineFileName = H.TimelineFileName;
+			H.mHitch.pSummaryFileName = H.SummaryFileName;
+
+			ProfileHitchDump(nFrames);
+
+			H.bPending = false;
+			H.nLastDumpTick = P_TICK();
+			H.nSuppressFrames = PROFILE_GPU_FRAME_DELAY + 3;
+			S.nAutoClearFrames = PROFILE_GPU_FRAME_DELAY + 3;    //hide spike from dumping webpage
+
+			hitch = H.mHitch;
+			pCallback = D.pCallback;
+			pUserData = D.pUserData;
+		}
+	}
+
+	// Outside of the profiler lock so the callback can use the profiler
+	if (pCallback)
+		pCallback(&hitch, pUserData);
+}
+
+void setProfileHitchDetection(const ProfileHitchDesc* pDesc)
+{
+	MutexLock             lock(ProfileMutex());
+	ProfileHitchDetector& H = gProfileHitch;
+	H = {};
+	if (!pDesc)
+		return;
+
+	H.mDesc = *pDesc;
+	strncpy(H.AppName, pDesc->pAppName ? pDesc->pAppName : "", sizeof(H.AppName) - 1);
+	H.mDesc.pAppName = H.AppName;
+	H.nLastFrameIndex = g_Profile.nFrameCurrentIndex;
+	H.bEnabled = true;
+}
+
+// Benchmark runs. After the warm-up frames flipProfiler stores one sample per frame for the cpu frame time,
+// every gpu queue, every cpu timer (S.Frame) and every gpu timer (summed from the gpu logs).
+// The report holds distributions, not just the aggregates dumpBenchmarkData writes.
+#define PROFILE_BENCHMARK_HISTOGRAM_BUCKETS 32
+
+struct ProfileBenchmark
+{
+	BenchmarkDesc   mDesc;
+	IApp::Settings* pSettings;
+	char            AppName[64];
+	bool            bRunning;
+	uint32_t        nLastFrameIndex;
+	uint32_t        nFlips;
+	uint32_t        nSampled;
+
+	// mSampleFrames samples each, 0 for frames the timer did not run in. Allocated on first use
+	float*  pFrameSamples;
+	float*  pGroupSamples[PROFILE_MAX_GROUPS];
+	float*  pTimerSamples[PROFILE_MAX_TIMERS];
+};
+
+static ProfileBenchmark gProfileBenchmark = {};
+
+struct ProfileBenchmarkStats
+{
+	uint32_t nFrames;
+	float    fMean;
+	float    fStdDev;
+	float    fMin;
+	float    fMax;
+	float    fP50;
+	float    fP90;
+	float    fP99;
+	float    fP999;
+	uint32_t nHistogram[PROFILE_BENCHMARK_HISTOGRAM_BUCKETS];
+};
+
+static void ProfileBenchmarkAddSample(float** ppSamples, float fMs)
+{
+	ProfileBenchmark& B = gProfileBenchmark;
+	if (!*ppSamples)
+		*ppSamples = (float*)tf_calloc(B.mDesc.mSampleFrames, sizeof(float));
+	(*ppSamples)[B.nSampled] += fMs;
+}
+
+// Statistics over the frames the timer ran in, nearest rank percentiles
+static void ProfileBenchmarkComputeStats(const float* pSamples, uint32_t nCount, float* pScratch, ProfileBenchmarkStats* pStats)
+{
+	memset(pStats, 0, sizeof(*pStats));
+	uint32_t nFrames = 0;
+	double   fSum = 0.0;
+	for (uint32_t i = 0; i < nCount; ++i)
+	{
+		if (pSamples[i] > 0.0f)
+		{
+			pScratch[nFrames++] = pSamples[i];
+			fSum += pSamples[i];
+		}
+	}
+	if (!nFrames)
+		return;
+
+	eastl::sort(pScratch, pScratch + nFrames);
+	const double fMean = fSum / nFrames;
+	double       fVariance = 0.0;
+	for (uint32_t i = 0; i < nFrames; ++i)
+	{
+		fVariance += (pScratch[i] - fMean) * (pScratch[i] - fMean);
+	}
+
+	pStats->nFrames = nFrames;
+	pStats->fMean = (float)fMean;
+	pStats->fStdDev = (float)sqrt(fVariance / nFrames);
+	pStats->fMin = pScratch[0];
+	pStats->fMax = pScratch[nFrames - 1];
+	const float fPercentiles[] = { 0.5f, 0.9f, 0.99f, 0.999f };
+	float*      pOut[] = { &pStats->fP50, &pStats->fP90, &pStats->fP99, &pStats->fP999 };
+	for (uint32_t p = 0; p < 4; ++p)
+	{
+		uint32_t nRank = (uint32_t)ceil(fPercentiles[p] * nFrames);
+		*pOut[p] = pScratch[max(nRank, 1u) - 1];
+	}
+
+	const float fBucketWidth = (pStats->fMax - pStats->fMin) / PROFILE_BENCHMARK_HISTOGRAM_BUCKETS;
+	for (uint32_t i = 0; i < nFrames; ++i)
+	{
+		uint32_t nBucket = fBucketWidth > 0.0f ? (uint32_t)((pScratch[i] - pStats->fMin) / fBucketWidth) : 0;
+		pStats->nHistogram[min(nBucket, (uint32_t)PROFILE_BENCHMARK_HISTOGRAM_BUCKETS - 1)]++;
+	}
+}
+
+// One line per timer, compareBenchmarkReports depends on it
+static void ProfileBenchmarkWriteTimer(
+	FileStream* pFile, bool bFirst, const char* pGroup, const char* pName, const char* pType, const float* pSamples, float* pScratch)
+{
+	ProfileBenchmark&     B = gProfileBenchmark;
+	ProfileBenchmarkStats stats;
+	ProfileBenchmarkComputeStats(pSamples, B.nSampled, pScratch, &stats);
+	if (!stats.nFrames)
+		return;
+
+	ProfilePrintString(ProfileWriteFile, pFile, bFirst ? "\n{ \"Group\": " : ",\n{ \"Group\": ");
+	ProfileWriteJsonString(ProfileWriteFile, pFile, pGroup);
+	ProfilePrintString(ProfileWriteFile, pFile, ", \"Name\": ");
+	ProfileWriteJsonString(ProfileWriteFile, pFile, pName);
+	ProfilePrintf(
+		ProfileWriteFile, pFile,
+		", \"Type\": \"%s\", \"Frames\": %u, \"Mean\": %.4f, \"StdDev\": %.4f, \"Min\": %.4f, \"Max\": %.4f, \"P50\": %.4f, \"P90\": %.4f, "
+		"\"P99\": %.4f, \"P999\": %.4f, \"HistogramMin\": %.4f, \"HistogramBucketWidth\": %.4f, \"Histogram\": [",
+		pType, stats.nFrames, stats.fMean, stats.fStdDev, stats.fMin, stats.fMax, stats.fP50, stats.fP90, stats.fP99, stats.fP999, stats.fMin,
+		(stats.fMax - stats.fMin) / PROFILE_BENCHMARK_HISTOGRAM_BUCKETS);
+	for (uint32_t i = 0; i < PROFILE_BENCHMARK_HISTOGRAM_BUCKETS; ++i)
+	{
+		ProfilePrintf(ProfileWriteFile, pFile, i ? ",%u" : "%u", stats.nHistogram[i]);
+	}
+	ProfilePrintString(ProfileWriteFile, pFile, "] }");
+}
+
+static void ProfileBenchmarkWriteReport()
+{
+	ProfileBenchmark& B = gProfileBenchmark;
+	Profile&          S = g_Profile;
+
+	char name[256] = {};
+	if (B.mDesc.pReportFileName && B.mDesc.pReportFileName[0])
+	{
+		strncpy(name, B.mDesc.pReportFileName, sizeof(name) - 1);
+	}
+	else
+	{
+		time_t t = time(0);
+		char   tempName[128];
+		snprintf(tempName, sizeof(tempName), "%sBenchmark-%%Y-%%m-%%d-%%H.%%M.%%S.json", B.AppName);
+		strftime(name, sizeof(name), tempName, localtime(&t));
+	}
+
+	FileStream fh = {};
+	if (!fsOpenStreamFromPath(RD_LOG, name, FM_WRITE, NULL, &fh))
+	{
+		LOGF(LogLevel::eERROR, "Failed to open benchmark report %s", name);
+		return;
+	}
+
+	ProfilePrintString(ProfileWriteFile, &fh, "{\n\"Application\": ");
+	ProfileWriteJsonString(ProfileWriteFile, &fh, B.AppName);
+	if (B.pSettings)
+		ProfilePrintf(ProfileWriteFile, &fh, ",\n\"Width\": %d,\n\"Height\": %d", B.pSettings->mWidth, B.pSettings->mHeight);
+	if (S.pGpuSettings)
+	{
+		ProfilePrintString(ProfileWriteFile, &fh, ",\n\"GpuName\": ");
+		ProfileWriteJsonString(ProfileWriteFile, &fh, S.pGpuSettings->mGpuVendorPreset.mGpuName);
+		ProfilePrintString(ProfileWriteFile, &fh, ",\n\"VendorID\": ");
+		ProfileWriteJsonString(ProfileWriteFile, &fh, S.pGpuSettings->mGpuVendorPreset.mVendorId);
+		ProfilePrintString(ProfileWriteFile, &fh, ",\n\"ModelID\": ");
+		ProfileWriteJsonString(ProfileWriteFile, &fh, S.pGpuSettings->mGpuVendorPreset.mModelId);
+	}
+	ProfilePrintf(
+		ProfileWriteFile, &fh, ",\n\"WarmupFrames\": %u,\n\"Frames\": %u,\n\"Timers\": [", B.mDesc.mWarmupFrames, B.nSampled);
+
+	float* pScratch = (float*)tf_malloc(B.mDesc.mSampleFrames * sizeof(float));
+	bool   bFirst = true;
+	if (B.pFrameSamples)
+	{
+		ProfileBenchmarkWriteTimer(&fh, bFirst, "Frame", "Cpu", "Frame", B.pFrameSamples, pScratch);
+		bFirst = false;
+	}
+	for (uint32_t i = 0; i < S.nGroupCount; ++i)
+	{
+		if (B.pGroupSamples[i])
+		{
+			ProfileBenchmarkWriteTimer(&fh, bFirst, "Frame", S.GroupInfo[i].pName, "Frame", B.pGroupSamples[i], pScratch);
+			bFirst = false;
+		}
+	}
+	for (uint32_t i = 0; i < S.nTotalTimers; ++i)
+	{
+		if (B.pTimerSamples[i])
+		{
+			const ProfileGroupInfo& Group = S.GroupInfo[S.TimerInfo[i].nGroupIndex];
+			ProfileBenchmarkWriteTimer(
+				&fh, bFirst, Group.pName, S.TimerInfo[i].pName, Group.Type == ProfileTokenTypeGpu ? "Gpu" : "Cpu", B.pTimerSamples[i], pScratch);
+			bFirst = false;
+		}
+	}
+	tf_free(pScratch);
+
+	ProfilePrintString(ProfileWriteFile, &fh, "\n]\n}\n");
+	fsCloseStream(&fh);
+	LOGF(LogLevel::eINFO, "Benchmark report of %u frames written to %s", B.nSampled, name);
+}
+
+static void ProfileBenchmarkRelease()
+{
+	ProfileBenchmark& B = gProfileBenchmark;
+	tf_free(B.pFrameSamples);
+	for (uint32_t i = 0; i < PROFILE_MAX_GROUPS; ++i)
+	{
+		tf_free(B.pGroupSamples[i]);
+	}
+	for (uint32_t i = 0; i < PROFILE_MAX_TIMERS; ++i)
+	{
+		tf_free(B.pTimerSamples[i]);
+	}
+	B = {};
+}
+
+// Adds the inclusive gpu time of every timer in the current frame to its sample
+static void ProfileBenchmarkSampleGpuLogs()
+{
+	ProfileBenchmark&        B = gProfileBenchmark;
+	Profile&                 S = g_Profile;
+	const ProfileFrameState& Frame = S.Frames[S.nFrameCurrent];
+	const ProfileFrameState& FrameNext = S.Frames[(S.nFrameCurrent + 1) % PROFILE_MAX_FRAME_HISTORY];
+
+	for (uint32_t j = 0; j < PROFILE_MAX_THREADS; ++j)
+	{
+		ProfileThreadLog* pLog = S.Pool[j];
+		if (!pLog || !pLog->Log || !pLog->nGpu)
+			continue;
+
+		const float fToMs = ProfileTickToMsMultiplier(getGpuProfileTicksPerSecond(pLog->nGpuToken));
+		uint32_t    nStack[PROFILE_STACK_MAX];
+		uint32_t    nStackPos = 0;
+		for (uint32_t k = Frame.nLogStart[j]; k != FrameNext.nLogStart[j]; k = (k + 1) % PROFILE_BUFFER_SIZE)
+		{
+			const ProfileLogEntry LE = pLog->Log[k];
+			const uint64_t        nType = ProfileLogType(LE);
+			if (nType == P_LOG_ENTER)
+			{
+				if (nStackPos < PROFILE_STACK_MAX)
+					nStack[nStackPos] = k;
+				nStackPos++;
+			}
+			else if (nType == P_LOG_LEAVE && nStackPos)
+			{
+				nStackPos--;
+				if (nStackPos >= PROFILE_STACK_MAX)
+					continue;
+				const uint32_t nTimer = (uint32_t)ProfileLogTimerIndex(LE);
+				const int64_t  nTicks = ProfileLogTickDifference(pLog->Log[nStack[nStackPos]], LE);
+				if (nTicks > 0 && nTimer < PROFILE_MAX_TIMERS)
+					ProfileBenchmarkAddSample(&B.pTimerSamples[nTimer], fToMs * nTicks);
+			}
+		}
+	}
+}
+
+// Called from flipProfiler after ProfileFlipCpu
+void ProfileBenchmarkFlip()
+{
+	ProfileBenchmark& B = gProfileBenchmark;
+	if (!B.bRunning)
+		return;
+
+	MutexLock lock(ProfileMutex());
+	Profile&  S = g_Profile;
+	if (!B.bRunning || S.nFrameCurrentIndex == B.nLastFrameIndex)
+		return;
+	B.nLastFrameIndex = S.nFrameCurrentIndex;
+
+	if (++B.nFlips <= B.mDesc.mWarmupFrames)
+		return;
+
+	const float fToMsCpu = ProfileTickToMsMultiplier(ProfileTicksPerSecondCpu());
+	ProfileBenchmarkAddSample(&B.pFrameSamples, fToMsCpu * S.nFlipTicks);
+	for (uint32_t i = 0; i < S.nGroupCount; ++i)
+	{
+		if (S.GroupInfo[i].Type != ProfileTokenTypeGpu)
+			continue;
+		const float fGpuMs = getGpuProfileTime(S.GroupInfo[i].nGpuProfileToken);
+		if (fGpuMs > 0.0f)
+			ProfileBenchmarkAddSample(&B.pGroupSamples[i], fGpuMs);
+	}
+	for (uint32_t i = 0; i < S.nTotalTimers; ++i)
+	{
+		if (S.GroupInfo[S.TimerInfo[i].nGroupIndex].Type != ProfileTokenTypeGpu && S.Frame[i].nTicks)
+			ProfileBenchmarkAddSample(&B.pTimerSamples[i], fToMsCpu * S.Frame[i].nTicks);
+	}
+	ProfileBenchmarkSampleGpuLogs();
+
+	if (++B.nSampled == B.mDesc.mSampleFrames)
+	{
+		ProfileBenchmarkWriteReport();
+		if (B.mDesc.mQuitWhenDone && B.pSettings)
+			B.pSettings->mQuit = true;
+		ProfileBenchmarkRelease();
+	}
+}
+
+void startBenchmark(IApp::Settings* pSettings, const BenchmarkDesc* pDesc)
+{
+	MutexLock         lock(ProfileMutex());
+	ProfileBenchmark& B = gProfileBenchmark;
+	ProfileBenchmarkRelease();
+	if (!pDesc->mSampleFrames)
+		return;
+
+	B.mDesc = *pDesc;
+	B.pSettings = pSettings;
+	strncpy(B.AppName, pDesc->pAppName ? pDesc->pAppName : "", sizeof(B.AppName) - 1);
+	B.mDesc.pAppName = B.AppName;
+	B.nLastFrameIndex = g_Profile.nFrameCurrentIndex;
+	B.bRunning = true;
+}
+
+bool isBenchmarkRunning() { return gProfileBenchmark.bRunning; }
+
+// Report parsing for compareBenchmarkReports. Only reads the one line per timer format ProfileBenchmarkWriteTimer writes.
+struct ProfileBenchmarkEntry
+{
+	char  Key[PROFILE_NAME_MAX_LEN * 3];
+	float fMean;
+	float fP50;
+	float fP90;
+	float fP99;
+};
+
+static bool ProfileBenchmarkParseString(const char* pLine, const char* pKey, char* pOut, size_t nOutSize)
+{
+	const char* p = strstr(pLine, pKey);
+	if (!p)
+		return false;
+	p += strlen(pKey);
+	size_t nLen = 0;
+	for (; *p && *p != '"' && nLen + 1 < nOutSize; ++p)
+	{
+		if (*p == '\\' && p[1])
+			pOut[nLen++] = *p++;
+		if (nLen + 1 < nOutSize)
+			pOut[nLen++] = *p;
+	}
+	pOut[nLen] = '\0';
+	return true;
+}
+
+static float ProfileBenchmarkParseFloat(const char* pLine, const char* pKey)
+{
+	const char* p = strstr(pLine, pKey);
+	return p ? (float)strtod(p + strlen(pKey), NULL) : 0.0f;
+}
+
+static bool ProfileBenchmarkLoadReport(const char* pFileName, eastl::vector<ProfileBenchmarkEntry>& entries)
+{
+	FileStream fh = {};
+	if (!fsOpenStreamFromPath(RD_LOG, pFileName, FM_READ, NULL, &fh))
+	{
+		LOGF(LogLevel::eERROR, "Failed to open benchmark report %s", pFileName);
+		return false;
+	}
+
+	const ssize_t nSize = max(fsGetStreamFileSize(&fh), (ssize_t)0);
+	char*         pData = (char*)tf_malloc(nSize + 1);
+	pData[fsReadFromStream(&fh, pData, nSize)] = '\0';
+	fsCloseStream(&fh);
+
+	for (char* pLine = pData; pLine && *pLine;)
+	{
+		char* pLineEnd = strchr(pLine, '\n');
+		if (pLineEnd)
+			*pLineEnd = '\0';
+
+		ProfileBenchmarkEntry entry = {};
+		char                  group[PROFILE_NAME_MAX_LEN * 2];
+		char                  name[PROFILE_NAME_MAX_LEN * 2];
+		char                  type[16];
+		if (ProfileBenchmarkParseString(pLine, "\"Group\": \"", group, sizeof(group)) &&
+			ProfileBenchmarkParseString(pLine, "\"Name\": \"", name, sizeof(name)) &&
+			ProfileBenchmarkParseString(pLine, "\"Type\": \"", type, sizeof(type)))
+		{
+			snprintf(entry.Key, sizeof(entry.Key), "%s/%s (%s)", group, name, type);
+			entry.fMean = ProfileBenchmarkParseFloat(pLine, "\"Mean\": ");
+			entry.fP50 = ProfileBenchmarkParseFloat(pLine, "\"P50\": ");
+			entry.fP90 = ProfileBenchmarkParseFloat(pLine, "\"P90\": ");
+			entry.fP99 = ProfileBenchmarkParseFloat(pLine, "\"P99\": ");
+			entries.push_back(entry);
+		}
+		pLine = pLineEnd ? pLineEnd + 1 : NULL;
+	}
+
+	tf_free(pData);
+	return true;
+}
+
+uint32_t compareBenchmarkReports(const char* pBaselineFileName, const char* pFileName, const BenchmarkCompareDesc* pDesc)
+{
+	eastl::vector<ProfileBenchmarkEntry> baseline;
+	eastl::vector<ProfileBenchmarkEntry> current;
+	if (!ProfileBenchmarkLoadReport(pBaselineFileName, baseline) || !ProfileBenchmarkLoadReport(pFileName, current))
+		return UINT32_MAX;
+
+	uint32_t nRegressions = 0;
+	for (const ProfileBenchmarkEntry& cur : current)
+	{
+		const ProfileBenchmarkEntry* pBase = NULL;
+		for (const ProfileBenchmarkEntry& base : baseline)
+		{
+			if (!strcmp(base.Key, cur.Key))
+			{
+				pBase = &base;
+				break;
+			}
+		}
+		// New timers and timers too short to measure reliably are not compared
+		if (!pBase || pBase->fP50 < pDesc->mMinTimeMs)
+			continue;
+
+		const char*  pStatNames[] = { "Mean", "P50", "P90", "P99" };
+		const float  fBase[] = { pBase->fMean, pBase->fP50, pBase->fP90, pBase->fP99 };
+		const float  fCur[] = { cur.fMean, cur.fP50, cur.fP90, cur.fP99 };
+		bool         bRegressed = false;
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			if (fCur[i] > fBase[i] * (1.0f + pDesc->mTolerance))
+			{
+				LOGF(
+					LogLevel::eWARNING, "Benchmark regression %s %s: %.4fms -> %.4fms (+%.1f%%)", cur.Key, pStatNames[i], fBase[i], fCur[i],
+					100.0f * (fCur[i] / fBase[i] - 1.0f));
+				bRegressed = true;
+			}
+		}
+		nRegressions += bRegressed ? 1 : 0;
+	}
+	return nRegressions;
+}
+
 #ifdef ENABLE_PROFILER_WEBSERVER
 uint32_t ProfileWebServerPort()
 {
@@ -4899,6 +6819,16 @@ void exitProfiler() {}
 void flipProfiler() {}
 void dumpProfileData(const char* appName, uint32_t nMaxFrames) {}
 void dumpBenchmarkData(IApp::Settings* pSettings, const char* outFilename, const char* appName) {}
+void startProfileTrace(const char* appName, const char* fileName) {}
+void stopProfileTrace() {}
+bool isProfileTraceActive() { return false; }
+void setProfileHitchDetection(const ProfileHitchDesc* pDesc) {}
+void startBenchmark(IApp::Settings* pSettings, const BenchmarkDesc* pDesc) {}
+bool isBenchmarkRunning() { return false; }
+uint32_t compareBenchmarkReports(const char* pBaselineFileName, const char* pFileName, const BenchmarkCompareDesc* pDesc) { return 0; }
+void startProfileCapture(const char* pFileName) {}
+void stopProfileCapture() {}
+uint32_t getProfileCaptureWorstFrames(const char* pFileName, ProfileCaptureFrame* pFrames, uint32_t maxFrames) { return 0; }
 void setAggregateFrames(uint32_t nFrames) {}
 float getCpuProfileTime(const char* pGroup, const char* pName, ThreadID* pThreadID) { return -1.0f; }
 float getCpuProfileAvgTime(const char* pGroup, const char* pName, ThreadID* pThreadID) { return -1.0f; }
@@ -379,6 +379,7 @@ PROFILE_API void ProfileSetForceMetaCounters(bool bEnable);
 PROFILE_API bool ProfileGetForceMetaCounters();
 PROFILE_API void ProfileEnableMetaCounter(const char* pMet);
 PROFILE_API void ProfileDisableMetaCounter(const char* pMet);
+PROFILE_API void ProfileInitAllocationCounters(); //"Alloc Bytes" / "Alloc Count" meta counters of every cpu scope, called by initProfiler
 PROFILE_API int ProfileGetAggregateFrames();
 PROFILE_API int ProfileGetCurrentAggregateFrames();
 PROFILE_API Profile* ProfileGet();
@@ -658,6 +659,10 @@ struct ProfileThreadLog
 	uint8_t					nGroupStackPos[PROFILE_MAX_GROUPS];
 	int64_t 				nGroupTicks[PROFILE_MAX_GROUPS];
 	int64_t 				nAggregateGroupTicks[PROFILE_MAX_GROUPS];
+
+	// tf_get_thread_alloc_counters at the last scope enter / leave of the thread
+	uint64_t				nAllocBytes;
+	uint64_t				nAllocCount;
 	enum
 	{
 		THREAD_MAX_LEN = 64,
@@ -694,6 +699,10 @@ struct Profile
 
 	uint32_t nForceEnable;
 	uint32_t nForceMetaCounters;
+	// Meta counters fed by tf_get_thread_alloc_counters
+	ProfileToken nAllocBytesMeta;
+	ProfileToken nAllocCountMeta;
+	uint32_t nAllocMetaBars;
 	uint64_t nForceEnableGroup;
 	uint64_t nForceDisableGroup;
 
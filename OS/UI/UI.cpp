@@ -29,6 +29,7 @@
 #include "../Interfaces/IInput.h"
 #include "../Interfaces/IFileSystem.h"
 #include "../Renderer/Include/IResourceLoader.h"
+#include "../Core/RingBuffer.h"
 
 // TODO(Alex): Delete this? Seems these files no longer exist.
 #ifdef ENABLE_UI_PRECOMPILED_SHADERS
@@ -95,14 +96,17 @@ typedef struct UserInterface
 	RootSignature* pRootSignatureTextured = NULL;
 	DescriptorSet* pDescriptorSetUniforms = NULL;
 	DescriptorSet* pDescriptorSetTexture = NULL;
+	DescriptorUpdatePlan* pDescriptorUpdatePlanTexture = NULL;
 	Pipeline* pPipelineTextured = NULL;
-	Buffer* pVertexBuffer = NULL;
-	Buffer* pIndexBuffer = NULL;
+	/// Vertices and indices of the frames in flight
+	TransientBuffer* pTransientBuffer = NULL;
 	Buffer* pUniformBuffer[MAX_FRAMES] = { NULL };
 	/// Default states
 	Sampler* pDefaultSampler = NULL;
 	VertexLayout     mVertexLayoutTextured = {};
 	uint32_t         mDynamicUIUpdates = 0;
+	eastl::vector<uint32_t>       mDynamicSetIndices;
+	eastl::vector<DescriptorData> mDynamicSetParams;
 	float            mNavInputs[ImGuiNavInput_COUNT] = { 0.0f };
 	const float2* pMovePosition = NULL;
 	uint32_t         mLastUpdateCount = 0;
@@ -350,6 +354,7 @@ bool addImguiFont(void* pFontBuffer, uint32_t fontBufferSize, void* pFontGlyphRa
 // MARK: - Static Value Definitions
 /****************************************************************************/
 
+// Initial page size of the transient buffer, frames drawing more add pages
 static const uint64_t VERTEX_BUFFER_SIZE = 1024 * 64 * sizeof(ImDrawVert);
 static const uint64_t INDEX_BUFFER_SIZE = 128 * 1024 * sizeof(ImDrawIdx);
 
@@ -2470,22 +2475,22 @@ void initUserInterface(UserInterfaceDesc* pDesc)
 
 	DescriptorSetDesc setDesc = { pUserInterface->pRootSignatureTextured, DESCRIPTOR_UPDATE_FREQ_PER_BATCH, 1 + (pDesc->maxDynamicUIUpdatesPerBatch * MAX_FRAMES) };
 	vk_addDescriptorSet(pUserInterface->pRenderer, &setDesc, &pUserInterface->pDescriptorSetTexture);
+	DescriptorData textureLayout[1] = {};
+	textureLayout[0].pName = "uTex";
+	DescriptorUpdatePlanDesc planDesc = { pUserInterface->pRootSignatureTextured, DESCRIPTOR_UPDATE_FREQ_PER_BATCH, textureLayout, 1 };
+	vk_addDescriptorUpdatePlan(pUserInterface->pRenderer, &planDesc, &pUserInterface->pDescriptorUpdatePlanTexture);
 	setDesc = { pUserInterface->pRootSignatureTextured, DESCRIPTOR_UPDATE_FREQ_NONE, MAX_FRAMES };
 	vk_addDescriptorSet(pUserInterface->pRenderer, &setDesc, &pUserInterface->pDescriptorSetUniforms);
 
-	BufferLoadDesc vbDesc = {};
-	vbDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_VERTEX_BUFFER;
-	vbDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
-	vbDesc.mDesc.mSize = VERTEX_BUFFER_SIZE * MAX_FRAMES;
-	vbDesc.mDesc.mFlags = BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
-	vbDesc.ppBuffer = &pUserInterface->pVertexBuffer;
-	addResource(&vbDesc, NULL);
-
-	BufferLoadDesc ibDesc = vbDesc;
-	ibDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_INDEX_BUFFER;
-	ibDesc.mDesc.mSize = INDEX_BUFFER_SIZE * MAX_FRAMES;
-	ibDesc.ppBuffer = &pUserInterface->pIndexBuffer;
-	addResource(&ibDesc, NULL);
+	// The UI is recorded by one thread and recycles its frames after MAX_FRAMES, like the uniform buffers below
+	TransientBufferDesc transientDesc = {};
+	transientDesc.mDescriptors = (DescriptorType)(DESCRIPTOR_TYPE_VERTEX_BUFFER | DESCRIPTOR_TYPE_INDEX_BUFFER);
+	transientDesc.mPageSize = VERTEX_BUFFER_SIZE + INDEX_BUFFER_SIZE;
+	transientDesc.mChunkSize = 64 * 1024;
+	transientDesc.mFrameCount = MAX_FRAMES;
+	transientDesc.mSlotCount = 1;
+	transientDesc.mInitialPageCount = MAX_FRAMES;
+	addTransientBuffer(pUserInterface->pRenderer, &transientDesc, &pUserInterface->pTransientBuffer);
 
 	BufferLoadDesc ubDesc = {};
 	ubDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_UNIFORM_BUFFER;
@@ -2531,11 +2536,11 @@ void exitUserInterface()
 #ifdef ENABLE_FORGE_UI
 	vk_removeSampler(pUserInterface->pRenderer, pUserInterface->pDefaultSampler);
 	vk_removeShader(pUserInterface->pRenderer, pUserInterface->pShaderTextured);
+	vk_removeDescriptorUpdatePlan(pUserInterface->pRenderer, pUserInterface->pDescriptorUpdatePlanTexture);
 	vk_removeDescriptorSet(pUserInterface->pRenderer, pUserInterface->pDescriptorSetTexture);
 	vk_removeDescriptorSet(pUserInterface->pRenderer, pUserInterface->pDescriptorSetUniforms);
 	vk_removeRootSignature(pUserInterface->pRenderer, pUserInterface->pRootSignatureTextured);
-	removeResource(pUserInterface->pVertexBuffer);
-	removeResource(pUserInterface->pIndexBuffer);
+	removeTransientBuffer(pUserInterface->pTransientBuffer);
 	for (uint32_t i = 0; i < MAX_FRAMES; ++i)
 		removeResource(pUserInterface->pUniformBuffer[i]);
 
@@ -2588,7 +2593,9 @@ bool addUserInterfacePipelines(void* pRenderTarget)
 	pipelineDesc.pVertexLayout = &pUserInterface->mVertexLayoutTextured;
 	pipelineDesc.mPrimitiveTopo = PRIMITIVE_TOPO_TRI_LIST;
 	pipelineDesc.mVRFoveatedRendering = true;
-	vk_addPipeline(pUserInterface->pRenderer, &desc, &pUserInterface->pPipelineTextured);
+	SyncToken token = {};
+	addPipeline(pUserInterface->pRenderer, &desc, &pUserInterface->pPipelineTextured, &token);
+	waitForToken(&token);
 
 #if TOUCH_INPUT
 	extern bool addVirtualJoystickPipeline(void* pScreenRenderTarget);
@@ -2607,7 +2614,7 @@ void removeUserInterfacePipelines()
 	removeVirtualJoystickPipeline();
 #endif
 
-	vk_removePipeline(pUserInterface->pRenderer, pUserInterface->pPipelineTextured);
+	removePipeline(pUserInterface->pRenderer, pUserInterface->pPipelineTextured);
 #endif
 }
 
@@ -2642,26 +2649,17 @@ void cmdDrawUserInterface(void* pCmd)
 			iSize += (int)(cmd_list->IdxBuffer.size() * sizeof(ImDrawIdx));
 		}
 
-		vSize = min<uint32_t>(vSize, VERTEX_BUFFER_SIZE);
-		iSize = min<uint32_t>(iSize, INDEX_BUFFER_SIZE);
-
 		// Copy and convert all vertices into a single contiguous buffer
-		uint64_t vOffset = pUserInterface->frameIdx * VERTEX_BUFFER_SIZE;
-		uint64_t iOffset = pUserInterface->frameIdx * INDEX_BUFFER_SIZE;
-		uint64_t vtx_dst = vOffset;
-		uint64_t idx_dst = iOffset;
+		beginTransientBufferFrame(pUserInterface->pTransientBuffer, NULL);
+		TransientAllocation vertices = allocTransientBuffer(pUserInterface->pTransientBuffer, 0, vSize);
+		TransientAllocation indices = allocTransientBuffer(pUserInterface->pTransientBuffer, 0, iSize);
+		uint8_t* vtx_dst = (uint8_t*)vertices.pData;
+		uint8_t* idx_dst = (uint8_t*)indices.pData;
 		for (int n = 0; n < draw_data->CmdListsCount; n++)
 		{
 			const ImDrawList* cmd_list = draw_data->CmdLists[n];
-			BufferUpdateDesc  update = { pUserInterface->pVertexBuffer, vtx_dst };
-			beginUpdateResource(&update);
-			memcpy(update.pMappedData, cmd_list->VtxBuffer.data(), cmd_list->VtxBuffer.size() * sizeof(ImDrawVert));
-			endUpdateResource(&update, NULL);
-
-			update = { pUserInterface->pIndexBuffer, idx_dst };
-			beginUpdateResource(&update);
-			memcpy(update.pMappedData, cmd_list->IdxBuffer.data(), cmd_list->IdxBuffer.size() * sizeof(ImDrawIdx));
-			endUpdateResource(&update, NULL);
+			memcpy(vtx_dst, cmd_list->VtxBuffer.data(), cmd_list->VtxBuffer.size() * sizeof(ImDrawVert));
+			memcpy(idx_dst, cmd_list->IdxBuffer.data(), cmd_list->IdxBuffer.size() * sizeof(ImDrawIdx));
 
 			vtx_dst += (cmd_list->VtxBuffer.size() * sizeof(ImDrawVert));
 			idx_dst += (cmd_list->IdxBuffer.size() * sizeof(ImDrawIdx));
@@ -2689,11 +2687,39 @@ void cmdDrawUserInterface(void* pCmd)
 			cmd, (uint32_t)draw_data->DisplayPos.x, (uint32_t)draw_data->DisplayPos.y, (uint32_t)draw_data->DisplaySize.x,
 			(uint32_t)draw_data->DisplaySize.y);
 		vk_cmdBindPipeline(cmd, pPipeline);
-		vk_cmdBindIndexBuffer(cmd, pUserInterface->pIndexBuffer, INDEX_TYPE_UINT16, iOffset);
-		vk_cmdBindVertexBuffer(cmd, 1, &pUserInterface->pVertexBuffer, &vertexStride, &vOffset);
+		vk_cmdBindIndexBuffer(cmd, indices.pBuffer, INDEX_TYPE_UINT16, indices.mOffset);
+		vk_cmdBindVertexBuffer(cmd, 1, &vertices.pBuffer, &vertexStride, &vertices.mOffset);
 
 		vk_cmdBindDescriptorSet(cmd, pUserInterface->frameIdx, pUserInterface->pDescriptorSetUniforms);
 
+		// Update the sets of all dynamic textures in one batched call, the draw loop below only binds them
+		const uint32_t dynamicSetStart =
+			(uint32_t)pUserInterface->mFontTextures.size() + pUserInterface->frameIdx * pUserInterface->mMaxDynamicUIUpdatesPerBatch;
+		pUserInterface->mDynamicSetIndices.clear();
+		pUserInterface->mDynamicSetParams.clear();
+		for (int n = 0; n < draw_data->CmdListsCount; n++)
+		{
+			const ImDrawList* cmd_list = draw_data->CmdLists[n];
+			for (uint32_t cmd_i = 0; cmd_i < cmd_list->CmdBuffer.size(); cmd_i++)
+			{
+				const ImDrawCmd* pcmd = &cmd_list->CmdBuffer[cmd_i];
+				if (!pcmd->UserCallback && (size_t)pcmd->TextureId >= pUserInterface->mFontTextures.size())
+				{
+					DescriptorData param = {};
+					param.ppTextures = (Texture**)&pcmd->TextureId;
+					pUserInterface->mDynamicSetIndices.push_back(dynamicSetStart + (uint32_t)pUserInterface->mDynamicSetIndices.size());
+					pUserInterface->mDynamicSetParams.push_back(param);
+				}
+			}
+		}
+		if (!pUserInterface->mDynamicSetIndices.empty())
+		{
+			vk_updateDescriptorSetsWithPlan(
+				pUserInterface->pRenderer, pUserInterface->pDescriptorUpdatePlanTexture, pUserInterface->pDescriptorSetTexture,
+				(uint32_t)pUserInterface->mDynamicSetIndices.size(), pUserInterface->mDynamicSetIndices.data(),
+				pUserInterface->mDynamicSetParams.data());
+		}
+
 		// Render command lists
 		int    vtx_offset = 0;
 		int    idx_offset = 0;
@@ -2721,11 +2747,7 @@ void cmdDrawUserInterface(void* pCmd)
 					size_t id = (size_t)pcmd->TextureId;
 					if (id >= pUserInterface->mFontTextures.size())
 					{
-						uint32_t setIndex = (uint32_t)pUserInterface->mFontTextures.size() + (pUserInterface->frameIdx * pUserInterface->mMaxDynamicUIUpdatesPerBatch + pUserInterface->mDynamicUIUpdates);
-						DescriptorData params[1] = {};
-						params[0].pName = "uTex";
-						params[0].ppTextures = (Texture**)&pcmd->TextureId;
-						vk_updateDescriptorSet(pUserInterface->pRenderer, setIndex, pUserInterface->pDescriptorSetTexture, 1, params);
+						uint32_t setIndex = dynamicSetStart + pUserInterface->mDynamicUIUpdates;
 						vk_cmdBindDescriptorSet(cmd, setIndex, pUserInterface->pDescriptorSetTexture);
 						++pUserInterface->mDynamicUIUpdates;
 					}
@@ -50,6 +50,11 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
+#if defined(NULL_RENDERER)
+// Renderer/Null/NullDriver.h, not included here since it pulls in volk after the prototype based vulkan.h
+extern VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL nullVkGetInstanceProcAddr(VkInstance instance, const char* pName);
+#endif
+
 IApp* glWindowAppRef = NULL;
 
 WindowDesc* glWindow = nullptr;
@@ -283,6 +288,10 @@ void initGLWindowClass()
 {
 	if (!glWindowClassInitialized)
 	{
+#if defined(NULL_RENDERER)
+		// Window surfaces are created through the null Vulkan driver
+		glfwInitVulkanLoader(nullVkGetInstanceProcAddr);
+#endif
 		int success = glfwInit();
 		ASSERT(success);
 		glWindowClassInitialized = true;
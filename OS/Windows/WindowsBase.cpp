@@ -8,6 +8,7 @@
 #include "../Interfaces/ITime.h"
 #include "../Interfaces/IScripting.h"
 #include "../Interfaces/IUI.h"
+#include "../Interfaces/IProfiler.h"
 #include "../Interfaces/IMemory.h"
 
 
@@ -341,6 +342,13 @@ int WindowsMain(int argc, char** argv, IApp* app)
 			return EXIT_FAILURE;
 		LOGF(LogLevel::eINFO, "Application Init+Load %f", getTimerMSec(&t, false) / 1000.0f);
 
+		// Fixed length run, flipProfiler writes the report and requests quit when it is done
+		if (pSettings->mBenchmarking)
+		{
+			BenchmarkDesc benchmarkDesc;
+			benchmarkDesc.pAppName = pApp->GetName();
+			startBenchmark(pSettings, &benchmarkDesc);
+		}
 	}
 	bool quit = false;
 	int64_t lastCounter = getUSec(false);
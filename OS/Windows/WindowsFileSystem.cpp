@@ -188,3 +188,60 @@ bool PlatformOpenFile(ResourceDirectory resourceDir, const char* fileName, FileM
 	return false;
 }
 
+bool PlatformMapFile(ResourceDirectory resourceDir, const char* fileName, void** ppData, size_t* pSize)
+{
+	const char* resourcePath = fsGetResourceDirectory(resourceDir);
+	char filePath[FS_MAX_PATH] = {};
+	fsAppendPathComponent(resourcePath, fileName, filePath);
+
+	// Path utf-16 conversion
+	size_t filePathLen = strlen(filePath);
+	wchar_t* pathStr = (wchar_t*)alloca((filePathLen + 1) * sizeof(wchar_t));
+	size_t pathStrLength =
+		MultiByteToWideChar(CP_UTF8, 0, filePath, (int)filePathLen, pathStr, (int)filePathLen);
+	pathStr[pathStrLength] = 0;
+
+	HANDLE file = CreateFileW(pathStr, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize = {};
+	// Zero sized files cannot be mapped, let the caller fall back to regular IO
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0 || (uint64_t)fileSize.QuadPart > (uint64_t)SIZE_MAX)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	void*  data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+
+	// The view keeps the mapping and the file alive, so the handles can be closed right away
+	if (mapping)
+	{
+		CloseHandle(mapping);
+	}
+	CloseHandle(file);
+
+	if (!data)
+	{
+		LOGF(LogLevel::eWARNING, "Failed to map file: %s (error: %u)", filePath, (uint32_t)GetLastError());
+		return false;
+	}
+
+	*ppData = data;
+	*pSize = (size_t)fileSize.QuadPart;
+	return true;
+}
+
+void PlatformUnmapFile(void* pData, size_t size)
+{
+	UNREF_PARAM(size);
+	if (pData)
+	{
+		UnmapViewOfFile(pData);
+	}
+}
+
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2017-2022 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "RendererConfig.h"
+
+#include "IRenderer.h"
+
+// Frame graph on top of the renderer API.
+// Passes declare which render targets they read and write, compileRenderGraph culls passes whose results are never used,
+// orders the remaining ones, derives every resource barrier and load / store action, and places transient render targets
+// with disjoint lifetimes in the same memory (vk_getRenderTargetSizeAlign / vk_addResourceHeap).
+// executeRenderGraph then only records what was derived, so the compiled graph can be executed every frame.
+
+#define RENDER_GRAPH_INVALID_RESOURCE 0xFFFFFFFF
+#define RENDER_GRAPH_MAX_PASS_ACCESSES 16
+
+typedef struct RenderGraph     RenderGraph;
+typedef struct RenderGraphPass RenderGraphPass;
+typedef uint32_t               RenderGraphResource;
+
+typedef enum RenderGraphPassType
+{
+	/// Color / depth writes are bound as render targets around the execute callback
+	RENDER_GRAPH_PASS_GRAPHICS = 0,
+	RENDER_GRAPH_PASS_COMPUTE,
+} RenderGraphPassType;
+
+/// Records the commands of a pass. Render targets, viewport and scissor are already bound for graphics passes.
+typedef void (*RenderGraphExecuteFn)(Cmd* pCmd, const RenderGraph* pGraph, void* pUserData);
+
+typedef struct RenderGraphDesc
+{
+	/// Give every transient render target its own allocation (debugging aid for aliasing issues)
+	bool mDisableAliasing;
+} RenderGraphDesc;
+
+typedef struct RenderGraphStats
+{
+	uint32_t mPassCount;
+	uint32_t mCulledPassCount;
+	uint32_t mTransientCount;
+	uint32_t mHeapCount;
+	uint32_t mBarrierCount;
+	/// Aliasing barriers handing memory over from another transient, in the same frame or wrapping around from the previous one
+	uint32_t mAliasingBarrierCount;
+	/// Memory used by transient render targets (lazily allocated ones excluded)
+	uint64_t mTransientMemory;
+	/// Memory the same transient render targets would use without aliasing
+	uint64_t mTransientMemoryUnaliased;
+} RenderGraphStats;
+
+void addRenderGraph(Renderer* pRenderer, const RenderGraphDesc* pDesc, RenderGraph** ppGraph);
+/// The GPU must be done with every Cmd the graph was executed on
+void removeRenderGraph(RenderGraph* pGraph);
+/// Clears passes and resources so the graph can be declared again.
+/// Transient render targets and heaps are kept and reused by the next compileRenderGraph if the transient layout did not change.
+void resetRenderGraph(RenderGraph* pGraph);
+
+/// Names are not copied and must outlive the graph.
+/// Declares a render target owned by the graph. It only exists between its first and last use and its contents start undefined.
+RenderGraphResource renderGraphAddRenderTarget(RenderGraph* pGraph, const char* pName, const RenderTargetDesc* pDesc);
+/// Declares a render target owned by the application. It is in currentState when the graph starts and left in finalState.
+RenderGraphResource renderGraphImportRenderTarget(
+	RenderGraph* pGraph, const char* pName, RenderTarget* pRenderTarget, ResourceState currentState, ResourceState finalState);
+/// Swaps the render target behind an imported resource (swapchain image) without recompiling
+void renderGraphSetImportedRenderTarget(RenderGraph* pGraph, RenderGraphResource resource, RenderTarget* pRenderTarget);
+
+RenderGraphPass* renderGraphAddPass(
+	RenderGraph* pGraph, const char* pName, RenderGraphPassType type, RenderGraphExecuteFn pfnExecute, void* pUserData);
+/// Binds the resource as the next color attachment. LOAD_ACTION_LOAD on undefined contents is turned into LOAD_ACTION_DONTCARE.
+void renderGraphPassWriteColor(RenderGraphPass* pPass, RenderGraphResource resource, LoadActionType loadAction);
+void renderGraphPassWriteDepth(RenderGraphPass* pPass, RenderGraphResource resource, LoadActionType loadAction);
+/// Shader / copy / indirect access outside of the bound render targets
+void renderGraphPassRead(RenderGraphPass* pPass, RenderGraphResource resource, ResourceState state);
+void renderGraphPassWrite(RenderGraphPass* pPass, RenderGraphResource resource, ResourceState state);
+/// Keeps the pass even if none of its writes are used (readbacks, queries)
+void renderGraphPassSetSideEffects(RenderGraphPass* pPass);
+
+/// Returns false if a pass reads a transient that no earlier pass writes
+bool compileRenderGraph(RenderGraph* pGraph);
+void executeRenderGraph(RenderGraph* pGraph, Cmd* pCmd);
+
+/// Valid after compileRenderGraph. NULL for transients that were culled.
+RenderTarget* renderGraphGetRenderTarget(const RenderGraph* pGraph, RenderGraphResource resource);
+void          getRenderGraphStats(const RenderGraph* pGraph, RenderGraphStats* pStats);
@@ -226,6 +226,7 @@ typedef struct RenderTarget       RenderTarget;
 typedef struct Shader             Shader;
 typedef struct DescriptorSet      DescriptorSet;
 typedef struct DescriptorIndexMap DescriptorIndexMap;
+typedef struct DescriptorUpdatePlan DescriptorUpdatePlan;
 typedef struct PipelineCache      PipelineCache;
 
 // Raytracing
@@ -722,6 +723,17 @@ typedef struct RenderTargetBarrier
 	uint16_t mArrayLayer;
 } RenderTargetBarrier;
 
+/// Hands aliased memory over from one render target to another, see ResourcePlacement
+typedef struct AliasingBarrier
+{
+	/// Render target that used the memory last, NULL if the memory was not used yet
+	RenderTarget* pBefore;
+	/// Render target that starts using the memory, its contents are undefined after the barrier
+	RenderTarget* pAfter;
+	ResourceState mBeforeState;
+	ResourceState mAfterState;
+} AliasingBarrier;
+
 typedef struct ReadRange
 {
 	uint64_t mOffset;
@@ -945,10 +957,51 @@ typedef struct DEFINE_ALIGNED(Buffer, 64)
 	uint64_t mDescriptors : 20;
 	uint64_t mMemoryUsage : 3;
 	uint64_t mNodeIndex : 4;
+	/// Stable index of the buffer in the bindless heap, BINDLESS_INVALID_INDEX if it is not in the heap
+	uint32_t mBindlessIndex;
 } Buffer;
 // One cache line
 COMPILE_ASSERT(sizeof(Buffer) == 8 * sizeof(uint64_t));
 
+typedef struct ResourceHeapDesc
+{
+	/// Size in bytes
+	uint64_t mSize;
+	/// Largest alignment of the resources placed in the heap
+	uint64_t mAlignment;
+	/// Intersection of ResourceSizeAlign::mMemoryTypeBits of the resources placed in the heap
+	uint32_t mMemoryTypeBits;
+	/// GPU which will own this heap
+	uint32_t mNodeIndex;
+} ResourceHeapDesc;
+
+/// Block of GPU memory shared by resources whose lifetimes do not overlap
+typedef struct ResourceHeap
+{
+#if defined(VULKAN)
+	struct
+	{
+		struct VmaAllocation_T* pAllocation;
+	} mVulkan;
+#endif
+	uint64_t mSize;
+} ResourceHeap;
+
+/// Memory requirements of a resource which is placed in a ResourceHeap
+typedef struct ResourceSizeAlign
+{
+	uint64_t mSize;
+	uint64_t mAlignment;
+	uint32_t mMemoryTypeBits;
+} ResourceSizeAlign;
+
+/// Location of a resource inside a ResourceHeap. Resources sharing memory need an AliasingBarrier when the memory changes hands
+typedef struct ResourcePlacement
+{
+	ResourceHeap* pHeap;
+	uint64_t      mOffset;
+} ResourcePlacement;
+
 /// Data structure holding necessary info to create a Texture
 typedef struct TextureDesc
 {
@@ -960,6 +1013,8 @@ typedef struct TextureDesc
 	const char* pName;
 	/// GPU indices to share this texture
 	uint32_t* pSharedNodeIndices;
+	/// Memory the texture aliases instead of owning an allocation
+	const ResourcePlacement* pPlacement;
 #if defined(VULKAN)
 	VkSamplerYcbcrConversionInfo* pVkSamplerYcbcrConversionInfo;
 #endif
@@ -1194,6 +1249,8 @@ typedef struct DEFINE_ALIGNED(Texture, 64)
 	uint32_t mOwnsImage : 1;
 	// Only applies to Vulkan but kept here as adding it inside mVulkan block increases the size of the struct and triggers assert below
 	uint32_t mLazilyAllocated : 1;
+	/// Stable index of the shader resource view in the bindless heap, BINDLESS_INVALID_INDEX if it is not in the heap
+	uint32_t mBindlessIndex;
 } Texture;
 // One cache line
 COMPILE_ASSERT(sizeof(Texture) == 8 * sizeof(uint64_t));
@@ -1229,6 +1286,8 @@ typedef struct RenderTargetDesc
 	const char* pName;
 	/// GPU indices to share this texture
 	uint32_t* pSharedNodeIndices;
+	/// Memory the render target aliases instead of owning an allocation (see vk_getRenderTargetSizeAlign)
+	const ResourcePlacement* pPlacement;
 	/// Number of GPUs to share this texture
 	uint32_t mSharedNodeIndexCount;
 	/// GPU which will own this texture
@@ -1330,6 +1389,9 @@ typedef struct LoadActionsDesc
 	StoreActionType mStoreActionsColor[MAX_RENDER_TARGET_ATTACHMENTS];
 	StoreActionType mStoreActionDepth;
 	StoreActionType mStoreActionStencil;
+	/// The contents of the render pass are recorded into secondary Cmds (vk_beginSecondaryCmd) and submitted with vk_cmdExecuteCmds.
+	/// No other commands can be recorded into the primary Cmd until the next vk_cmdBindRenderTargets.
+	bool            mExecuteSecondaryCmds;
 } LoadActionsDesc;
 
 typedef struct SamplerDesc
@@ -1435,6 +1497,9 @@ typedef enum DescriptorUpdateFrequency
 	DESCRIPTOR_UPDATE_FREQ_COUNT,
 } DescriptorUpdateFrequency;
 
+/// Texture::mBindlessIndex / Buffer::mBindlessIndex of resources that are not in the bindless heap
+static const uint32_t BINDLESS_INVALID_INDEX = 0xFFFFFFFF;
+
 /// Data structure holding the layout for a descriptor
 typedef struct DEFINE_ALIGNED(DescriptorInfo, 16)
 {
@@ -1566,6 +1631,10 @@ typedef struct DEFINE_ALIGNED(RootSignature, 64)
 			uint8_t                     mPoolSizeCount[DESCRIPTOR_UPDATE_FREQ_COUNT];
 			VkDescriptorPool            pEmptyDescriptorPool[DESCRIPTOR_UPDATE_FREQ_COUNT];
 			VkDescriptorSet             pEmptyDescriptorSet[DESCRIPTOR_UPDATE_FREQ_COUNT];
+			/// Shaders index the global bindless heap (UPDATE_FREQ_BINDLESS)
+			bool                        mBindless;
+			/// Never reused, unlike the address of a removed root signature
+			uint32_t                    mId;
 		} mVulkan;
 #endif
 #if defined(METAL)
@@ -1840,12 +1909,18 @@ typedef struct DEFINE_ALIGNED(Cmd, 64)
 		{
 			VkCommandBuffer  pVkCmdBuf;
 			VkRenderPass     pVkActiveRenderPass;
+			VkFramebuffer    pVkActiveFramebuffer;
 			VkPipelineLayout pBoundPipelineLayout;
 			uint32_t         mNodeIndex : 4;
 			uint32_t         mType : 3;
+			uint32_t         mSecondary : 1;
+			// Active render pass was begun for secondary command buffers (LoadActionsDesc::mExecuteSecondaryCmds)
+			uint32_t         mSecondaryContents : 1;
 			uint32_t         mPadA;
 			CmdPool* pCmdPool;
-			uint64_t         mPadB[9];
+			// Transitions recorded by vk_cmdResourceBarrier, flushed before the next draw / dispatch / copy
+			struct PendingBarriers* pPendingBarriers;
+			uint64_t         mPadB[7];
 		} mVulkan;
 #endif
 #if defined(METAL)
@@ -1929,7 +2004,8 @@ typedef struct Fence
 		{
 			VkFence  pVkFence;
 			uint32_t mSubmitted : 1;
-			uint32_t mPadA;
+			/// Submissions that signaled the fence so far, see vk_isFenceSubmitComplete
+			uint32_t mSubmitCount;
 			uint64_t mPadB;
 			uint64_t mPadC;
 		} mVulkan;
@@ -2190,6 +2266,8 @@ typedef struct Shader
 			VkShaderModule* pShaderModules;
 			char** pEntryNames;
 			VkSpecializationInfo* pSpecializationInfo;
+			/// Never reused, unlike the address of a removed shader
+			uint32_t mId;
 		} mVulkan;
 #endif
 #if defined(METAL)
@@ -2711,6 +2789,12 @@ typedef struct RendererDesc
 			/// Flag to specify whether to request all queues from the gpu or just one of each type
 			/// This will affect memory usage - Around 200 MB more used if all queues are requested
 			bool mRequestAllAvailableQueues;
+			/// Opt-in global update-after-bind texture / buffer heap (requires VK_EXT_descriptor_indexing)
+			/// Textures and buffers get a stable mBindlessIndex which shaders use to index the UPDATE_FREQ_BINDLESS set
+			bool     mEnableBindless;
+			/// Heap capacities, 0 selects the default. Clamped to the device limits
+			uint32_t mBindlessTextureCount;
+			uint32_t mBindlessBufferCount;
 		} mVulkan;
 #endif
 #if defined(DIRECT3D11)
@@ -2892,6 +2976,7 @@ typedef struct DEFINE_ALIGNED(Renderer, 64)
 			uint32_t               mDeferredHostOperationsExtension : 1;
 			uint32_t               mDrawIndirectCountExtension : 1;
 			uint32_t               mDedicatedAllocationExtension : 1;
+			uint32_t               mMemoryBudgetExtension : 1;
 			uint32_t               mExternalMemoryExtension : 1;
 			uint32_t               mDebugMarkerSupport : 1;
 			uint32_t               mOwnInstance : 1;
@@ -3142,6 +3227,16 @@ typedef struct DescriptorSetDesc
 	uint32_t                  mNodeIndex;
 } DescriptorSetDesc;
 
+/// Precompiled layout for updating descriptor sets without name lookups
+typedef struct DescriptorUpdatePlanDesc
+{
+	const RootSignature*      pRootSignature;
+	DescriptorUpdateFrequency mUpdateFrequency;
+	/// Descriptors updated by the plan. Only pName / mIndex / mBindByIndex, mArrayOffset and mCount are read
+	const DescriptorData*     pLayout;
+	uint32_t                  mLayoutCount;
+} DescriptorUpdatePlanDesc;
+
 typedef struct QueueSubmitDesc
 {
 	Cmd** ppCmds;
@@ -3193,6 +3288,44 @@ API_INTERFACE void FORGE_CALLCONV exitRenderer(Renderer* pRenderer);
 uint32_t getDescriptorIndexFromName(const RootSignature* pRootSignature, const char* pName);
 // clang-format on
 
+typedef struct RenderPassCacheStats
+{
+	uint64_t mRenderPassHits;
+	uint64_t mRenderPassMisses;
+	uint64_t mFrameBufferHits;
+	uint64_t mFrameBufferMisses;
+	/// Frame buffers evicted because they were not used for a while
+	uint64_t mFrameBufferEvictions;
+	/// Frame buffers released because one of their render targets was removed
+	uint64_t mFrameBufferReleases;
+	uint32_t mRenderPassCount;
+	uint32_t mFrameBufferCount;
+} RenderPassCacheStats;
+
+typedef struct BarrierStats
+{
+	/// Transitions passed to cmdResourceBarrier
+	uint64_t mBarriersRequested;
+	/// Transitions recorded to the command buffer after batching
+	uint64_t mBarriersEmitted;
+	/// No-op and duplicate transitions that were skipped
+	uint64_t mBarriersDropped;
+	/// Transitions folded into a pending transition of the same subresource
+	uint64_t mBarriersMerged;
+	uint64_t mPipelineBarrierCalls;
+} BarrierStats;
+
+typedef struct MemoryBudget
+{
+	/// Memory the process can use before the OS starts paging, summed over the device local heaps
+	uint64_t mBudget;
+	/// Memory the process uses in these heaps, including allocations made outside of the renderer
+	uint64_t mUsage;
+	/// Memory the renderer allocated in these heaps and how much of it is used by resources
+	uint64_t mBlockBytes;
+	uint64_t mAllocationBytes;
+} MemoryBudget;
+
 typedef struct SubresourceDataDesc
 {
 	uint64_t mSrcOffset;
@@ -3200,6 +3333,12 @@ typedef struct SubresourceDataDesc
 	uint32_t mArrayLayer;
 	uint32_t mRowPitch;
 	uint32_t mSlicePitch;
+	/// Optional region of the subresource for partial updates of single plane formats
+	/// Rows are counted in blocks. A count of 0 covers the rest of the subresource
+	uint32_t mDepthOffset;
+	uint32_t mDepthCount;
+	uint32_t mRowOffset;
+	uint32_t mRowCount;
 } SubresourceDataDesc;
 
 
@@ -3209,8 +3348,15 @@ void vk_removeQueue(Renderer* pRenderer, Queue* pQueue);
 void vk_addBuffer(Renderer* pRenderer, const BufferDesc* pDesc, Buffer** ppBuffer);
 void vk_getFenceStatus(Renderer* pRenderer, Fence* pFence, FenceStatus* pFenceStatus);
 void vk_waitForFences(Renderer* pRenderer, uint32_t fenceCount, Fence** ppFences);
+/// Number of submissions that signal pFence so far. The next submission will be number vk_getFenceSubmitCount() + 1
+uint32_t vk_getFenceSubmitCount(const Fence* pFence);
+/// Whether the GPU finished submission number submitCount of pFence. Unlike vk_getFenceStatus it doesn't reset the fence,
+/// so any number of observers can track the same fence and agree on its state
+bool vk_isFenceSubmitComplete(Renderer* pRenderer, const Fence* pFence, uint32_t submitCount);
 void vk_removeBuffer(Renderer* pRenderer, Buffer* pBuffer);
 void vk_addTexture(Renderer* pRenderer, const TextureDesc* pDesc, Texture** ppTexture);
+void vk_addResourceHeap(Renderer* pRenderer, const ResourceHeapDesc* pDesc, ResourceHeap** ppHeap);
+void vk_removeResourceHeap(Renderer* pRenderer, ResourceHeap* pHeap);
 void vk_addVirtualTexture(Cmd* pCmd, const TextureDesc* pDesc, Texture** ppTexture, void* pImageData);
 void vk_fillVirtualTextureLevel(Cmd* pCmd, Texture* pTexture, uint32_t mipLevel, uint32_t currentImage);
 void vk_updateVirtualTextureMemory(Cmd* pCmd, Texture* pTexture, uint32_t imageMemoryCount);
@@ -3220,10 +3366,19 @@ void vk_uploadVirtualTexturePage(Cmd* pCmd, Texture* pTexture, VirtualTexturePag
 // command buffer functions
 void vk_resetCmdPool(Renderer* pRenderer, CmdPool* pCmdPool);
 void vk_beginCmd(Cmd* pCmd);
+// Begins a secondary Cmd that continues the render pass currently bound on pPrimaryCmd (if any).
+// Secondary Cmds can be recorded on any thread as long as their CmdPool is not used by another thread at the same time.
+// Dynamic state (viewport, scissor, stencil reference) and bindings are not inherited and must be set in every secondary Cmd.
+void vk_beginSecondaryCmd(Cmd* pCmd, const Cmd* pPrimaryCmd);
+void vk_cmdExecuteCmds(Cmd* pCmd, uint32_t cmdCount, Cmd** ppCmds);
 void vk_cmdUpdateBuffer(Cmd* pCmd, Buffer* pBuffer, uint64_t dstOffset, Buffer* pSrcBuffer, uint64_t srcOffset, uint64_t size);
 void vk_cmdResourceBarrier(
 	Cmd* pCmd, uint32_t numBufferBarriers, BufferBarrier* pBufferBarriers, uint32_t numTextureBarriers, TextureBarrier* pTextureBarriers,
 	uint32_t numRtBarriers, RenderTargetBarrier* pRtBarriers);
+void vk_cmdAliasingBarrier(Cmd* pCmd, uint32_t barrierCount, const AliasingBarrier* pBarriers);
+// Records the transitions queued by vk_cmdResourceBarrier / vk_cmdAliasingBarrier.
+// Call it before recording vkCmd* directly into pCmd->mVulkan.pVkCmdBuf, the renderer's own commands flush by themselves.
+void vk_cmdFlushBarriers(Cmd* pCmd);
 void vk_cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pSrcBuffer, const SubresourceDataDesc* pSubresourceDesc);
 void vk_cmdCopySubresource(Cmd* pCmd, Buffer* pDstBuffer, Texture* pTexture, const SubresourceDataDesc* pSubresourceDesc);
 void vk_cmdBindPipeline(Cmd* pCmd, Pipeline* pPipeline);
@@ -3263,6 +3418,14 @@ void vk_removeFence(Renderer* pRenderer, Fence* pFence);
 
 void vk_updateDescriptorSet(Renderer* pRenderer, uint32_t index, DescriptorSet* pDescriptorSet, uint32_t count, const DescriptorData* pParams);
 
+void vk_addDescriptorUpdatePlan(Renderer* pRenderer, const DescriptorUpdatePlanDesc* pDesc, DescriptorUpdatePlan** ppPlan);
+void vk_removeDescriptorUpdatePlan(Renderer* pRenderer, DescriptorUpdatePlan* pPlan);
+// Updates setCount sets of pDescriptorSet (indices in pIndices) in one call
+// pParams holds mLayoutCount entries per set in plan layout order, names and array ranges are ignored
+void vk_updateDescriptorSetsWithPlan(
+	Renderer* pRenderer, const DescriptorUpdatePlan* pPlan, DescriptorSet* pDescriptorSet, uint32_t setCount, const uint32_t* pIndices,
+	const DescriptorData* pParams);
+
 void vk_initRenderer(const char* appName, const RendererDesc* pDesc, Renderer** ppRenderer);
 
 void vk_addQueue(Renderer* pRenderer, QueueDesc* pDesc, Queue** ppQueue);
@@ -3317,12 +3480,25 @@ void vk_cmdResolveQuery(Cmd* pCmd, QueryPool* pQueryPool, Buffer* pReadbackBuffe
 void vk_getPipelineCacheData(Renderer* pRenderer, PipelineCache* pPipelineCache, size_t* pSize, void* pData);
 void vk_addPipelineCache(Renderer* pRenderer, const PipelineCacheDesc* pDesc, PipelineCache** ppPipelineCache);
 void vk_addRenderTarget(Renderer* pRenderer, const RenderTargetDesc* pDesc, RenderTarget** ppRenderTarget);
+// Memory a render target created from pDesc needs when it is placed in a ResourceHeap
+void vk_getRenderTargetSizeAlign(Renderer* pRenderer, const RenderTargetDesc* pDesc, ResourceSizeAlign* pSizeAlign);
 void vk_addSwapChain(Renderer* pRenderer, const SwapChainDesc* pDesc, SwapChain** ppSwapChain);
 void vk_removeRenderTarget(Renderer* pRenderer, RenderTarget* pRenderTarget);
 void vk_removeSwapChain(Renderer* pRenderer, SwapChain* pSwapChain);
 
 void vk_toggleVSync(Renderer* pRenderer, SwapChain** ppSwapChain);
 
+// Frame boundary of the render pass / frame buffer cache used by vk_cmdBindRenderTargets, vk_acquireNextImage already calls it.
+// Renderers without a swap chain call it once per frame, frame buffers unused for a few seconds of frames are evicted
+// and replaced objects are destroyed a few frames later, so the GPU must not be more than a couple of frames behind.
+void vk_updateRenderPassCache(Renderer* pRenderer);
+// Counters of the render pass / frame buffer cache used by vk_cmdBindRenderTargets
+void vk_getRenderPassCacheStats(Renderer* pRenderer, RenderPassCacheStats* pStats);
+// Counters of the barrier batching done by vk_cmdResourceBarrier
+void vk_getBarrierStats(Renderer* pRenderer, BarrierStats* pStats);
+// Device local memory budget. Comes from VK_EXT_memory_budget when supported, otherwise it is an estimate based on the heap sizes
+void vk_getMemoryBudget(Renderer* pRenderer, MemoryBudget* pBudget);
+
 void vk_acquireNextImage(Renderer* pRenderer, SwapChain* pSwapChain, Semaphore* pSignalSemaphore, Fence* pFence, uint32_t* pImageIndex);
 
 TinyImageFormat vk_getRecommendedSwapchainFormat(bool hintHDR, bool hintSRGB);
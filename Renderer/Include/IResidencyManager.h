@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2017-2022 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "RendererConfig.h"
+
+#include "IRenderer.h"
+#include "IResourceLoader.h"
+
+// Keeps device local memory usage under the budget reported by vk_getMemoryBudget.
+// Textures loaded through the manager record the last frame they were used in. When usage goes over the target,
+// updateResidencyManager reloads the least important ones without their top mips (TextureLoadDesc::mSkipMipLevels)
+// and swaps them in once the load completed. Once there is room again they are reloaded at full resolution.
+// Budget, usage and managed texture memory are published as profiler counters under "Residency/".
+
+typedef struct ResidencyManager ResidencyManager;
+typedef struct ResidentTexture  ResidentTexture;
+
+typedef struct ResidencyManagerDesc
+{
+	/// Fraction of the budget usage is kept under
+	float mTargetBudgetFraction;
+	/// Demoted textures are restored while usage is under this fraction of the budget
+	float mRestoreBudgetFraction;
+	/// Number of frames in flight. Replaced textures are removed after this many frames
+	uint32_t mFrameCount;
+	/// Textures used in the last mMinUnusedFrames frames are only demoted if usage is over the whole budget
+	uint32_t mMinUnusedFrames;
+	/// Top mips dropped by one demotion. Over the whole budget textures go straight to mMinResidentDimension
+	uint32_t mMipsPerStep;
+	/// Textures are never reduced below this width / height
+	uint32_t mMinResidentDimension;
+	/// Maximum number of reloads queued by one updateResidencyManager
+	uint32_t mMaxRequestsPerUpdate;
+} ResidencyManagerDesc;
+
+typedef struct ResidencyStats
+{
+	MemoryBudget mBudget;
+	/// Estimated memory of the managed textures as they are now, and what they would need at full resolution
+	uint64_t mTextureBytes;
+	uint64_t mFullResolutionBytes;
+	uint32_t mTextureCount;
+	uint32_t mDemotedTextureCount;
+	/// Reloads that were queued but did not complete yet
+	uint32_t mPendingCount;
+	/// Totals since addResidencyManager
+	uint64_t mDemotionCount;
+	uint64_t mEvictionCount;
+	uint64_t mRestoreCount;
+} ResidencyStats;
+
+void addResidencyManager(Renderer* pRenderer, const ResidencyManagerDesc* pDesc, ResidencyManager** ppManager);
+/// The GPU must be done with every managed texture
+void removeResidencyManager(ResidencyManager* pManager);
+
+/// Loads a texture from file like addResource. The file name and password are copied.
+/// Higher priorities are demoted last and restored first.
+void addResidentTexture(
+	ResidencyManager* pManager, const TextureLoadDesc* pDesc, uint32_t priority, ResidentTexture** ppResidentTexture, SyncToken* token);
+/// The GPU must be done with the texture
+void removeResidentTexture(ResidencyManager* pManager, ResidentTexture* pResidentTexture);
+
+/// Records that the texture is used by the current frame. Can be called from any thread
+void markResidentTextureUsed(ResidencyManager* pManager, ResidentTexture* pResidentTexture);
+/// Valid once the token passed to addResidentTexture completed. Only changes in updateResidencyManager
+Texture* getResidentTexture(const ResidentTexture* pResidentTexture);
+
+/// Call once per frame after waiting for the frame's fence.
+/// Returns true if any getResidentTexture changed, descriptor sets referencing them have to be updated before use.
+bool updateResidencyManager(ResidencyManager* pManager);
+void getResidencyStats(const ResidencyManager* pManager, ResidencyStats* pStats);
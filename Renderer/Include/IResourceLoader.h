@@ -60,6 +60,19 @@ typedef enum TextureContainerType
 
 // MARK: - Resource Loading
 
+/// Order in which the streamer processes requests. Requests of a higher class queued while a lower class is being
+/// processed are picked up with the next copy engine set. Requests are only guaranteed to be processed in order within a class.
+typedef enum ResourcePriority
+{
+	/// Streaming loads - default for every request
+	RESOURCE_PRIORITY_NORMAL = 0,
+	/// Per-frame updates, processed before any other class
+	RESOURCE_PRIORITY_HIGH,
+	/// Background loads, processed when no other class is waiting
+	RESOURCE_PRIORITY_LOW,
+	RESOURCE_PRIORITY_COUNT,
+} ResourcePriority;
+
 typedef struct BufferLoadDesc
 {
 	Buffer** ppBuffer;
@@ -67,6 +80,7 @@ typedef struct BufferLoadDesc
 	BufferDesc  mDesc;
 	/// Force Reset buffer to NULL
 	bool mForceReset;
+	ResourcePriority mPriority;
 } BufferLoadDesc;
 
 typedef struct TextureLoadDesc
@@ -84,6 +98,9 @@ typedef struct TextureLoadDesc
 	TextureCreationFlags mCreationFlag;
 	/// The texture file format (dds/ktx/...)
 	TextureContainerType mContainer;
+	ResourcePriority mPriority;
+	/// Number of top mips left out, the texture starts at the next one (dds / ktx / basis only)
+	uint32_t mSkipMipLevels;
 } TextureLoadDesc;
 
 typedef struct Geometry
@@ -174,6 +191,7 @@ typedef struct GeometryLoadDesc
 	uint32_t mNodeIndex;
 	/// Specifies how to arrange the vertex data loaded from the file into GPU memory
 	VertexLayout* pVertexLayout;
+	ResourcePriority mPriority;
 } GeometryLoadDesc;
 
 typedef struct VirtualTexturePageInfo
@@ -200,6 +218,8 @@ typedef struct BufferUpdateDesc
 	/// endUpdateResource(&update, &token);
 	void* pMappedData;
 
+	ResourcePriority mPriority;
+
 	/// Internal
 	struct
 	{
@@ -243,6 +263,8 @@ typedef struct TextureUpdateDesc
 	/// Size of each slice in src - Use for offsetting src data when updating 3D textures
 	uint32_t mSrcSliceStride;
 
+	ResourcePriority mPriority;
+
 	/// Internal
 	struct
 	{
@@ -263,6 +285,7 @@ typedef struct TextureCopyDesc
 	/// Queue the texture is copied from.
 	QueueType mQueueType;
 	uint64_t mBufferOffset;
+	ResourcePriority mPriority;
 } TextureCopyDesc;
 
 typedef enum ShaderStageLoadFlags
@@ -309,11 +332,69 @@ typedef uint64_t SyncToken;
 
 typedef struct ResourceLoaderDesc
 {
+	/// Staging memory the streamer records into a copy engine set before lower priority requests yield
 	uint64_t mBufferSize;
+	/// Number of copy engine sets in flight
 	uint32_t mBufferCount;
 	bool     mSingleThreaded;
+	/// Number of worker threads reading and decoding texture / geometry files ahead of the streamer thread.
+	/// 0 does all the work on the streamer thread. Ignored if mSingleThreaded is set.
+	uint32_t mDecodeThreadCount;
+	/// Size of the upload pages staging memory is sub-allocated from. 0 uses mBufferSize
+	uint64_t mStagingPageSize;
+	/// Pages allocated up front and never released. 0 keeps one page per copy engine set
+	uint32_t mStagingMinPageCount;
+	/// Number of streamer cycles a page above mStagingMinPageCount stays unused before it is released. 0 never releases pages
+	uint32_t mStagingShrinkDelay;
+	/// Number of worker threads compiling pipelines requested with addPipeline.
+	/// 0 compiles on the calling thread. Ignored if mSingleThreaded is set.
+	uint32_t mPipelineThreadCount;
+	/// Decoded texture / geometry bytes waiting for the streamer before decode workers stop picking up new files.
+	/// The files the workers are decoding come on top. 0 doesn't limit decode memory
+	uint64_t mDecodeMemoryBudget;
+	/// Parse and pack geometry files on the decode workers as well. Without unified memory the workers pack into system memory the streamer
+	/// copies to staging memory once more, so by default the streamer packs straight from the mapped file into staging memory
+	bool mDecodeGeometryOnWorkers;
 } ResourceLoaderDesc;
 
+/// Staging memory statistics, summed over all GPUs. Values are approximate while the streamer is running
+typedef struct ResourceLoaderStats
+{
+	/// Staging memory handed out to copy engine sets that did not complete yet
+	uint64_t mStagingBytesInUse;
+	uint64_t mStagingPeakBytesInUse;
+	/// Size of all staging pages, in use or not
+	uint64_t mStagingBytesAllocated;
+	uint64_t mStagingPeakBytesAllocated;
+	/// Pages created at runtime because the pool had no free page large enough
+	uint32_t mStagingPageAllocations;
+	/// Pages released after staying unused for mStagingShrinkDelay cycles
+	uint32_t mStagingPageReleases;
+	/// Allocations larger than a page, served by a multi-page block
+	uint32_t mStagingOversizedAllocations;
+	/// Number of times the streamer waited for the GPU to release a copy engine set
+	uint32_t mStagingWaits;
+	/// Decoded bytes waiting for the streamer, see ResourceLoaderDesc::mDecodeMemoryBudget
+	uint64_t mDecodeBytesInFlight;
+	uint64_t mDecodePeakBytesInFlight;
+} ResourceLoaderStats;
+
+/// Pipeline compile statistics of addPipeline. Compiles also show up as "Pipelines" / "Compile" cpu profiler scopes
+typedef struct PipelineCompileStats
+{
+	/// addPipeline calls, including the ones served by the cache
+	uint32_t mRequests;
+	/// Requests that shared a pipeline already compiled or being compiled
+	uint32_t mCacheHits;
+	uint32_t mCompiles;
+	uint32_t mPendingCompiles;
+	/// Distinct pipelines currently held by the cache
+	uint32_t mPipelineCount;
+	/// Milliseconds spent compiling, summed over all worker threads
+	float    mTotalCompileTime;
+	float    mMaxCompileTime;
+} PipelineCompileStats;
+
 extern ResourceLoaderDesc gDefaultResourceLoaderDesc;
 
 // MARK: - Resource Loader Functions
@@ -348,6 +429,14 @@ void endUpdateResource(TextureUpdateDesc* pTexture, SyncToken* token);
 /// provide additional graphics/compute work that the GPU can execute alongside the copy.
 void copyResource(TextureCopyDesc* pTextureDesc, SyncToken* token);
 
+/// Cancels the texture / geometry load that returned token if the streamer has not picked it up yet.
+/// The output resource is left untouched and the token completes as usual.
+/// Returns false if the cancel had no effect: the streamer already took the request into the batch it is recording
+/// (even if that batch has not reached the GPU yet), or a decode worker already started reading the file.
+/// token must come from a single load. A token combined with combineSyncTokens or passed to several loads only identifies
+/// the latest of them, which is the only one that gets cancelled.
+bool cancelResourceLoad(const SyncToken* token);
+
 // MARK: removeResource
 
 void removeResource(Buffer* pBuffer);
@@ -368,9 +457,15 @@ void waitForAllResourceLoads();
 /// Returns wheter the resourceloader is single threaded or not
 bool isResourceLoaderSingleThreaded();
 
-/// A SyncToken is an array of monotonically increasing integers.
-/// getLastTokenCompleted() returns the last value for which
-/// isTokenCompleted(token) is guaranteed to return true.
+void getResourceLoaderStats(ResourceLoaderStats* pOutStats);
+
+/// A SyncToken packs counter << 4 | classMask: counter is the position of the latest request it covers in the loader-wide
+/// request order, classMask has one bit per ResourcePriority of the requests it covers. 0 is a token that is always complete.
+/// getLastTokenCompleted() returns a token of all classes for which isTokenCompleted(token) is guaranteed to return true.
+/// A token only waits for the priority classes of the requests it was returned for, so a RESOURCE_PRIORITY_HIGH token
+/// completes as soon as the HIGH requests up to it are done, even while older NORMAL / LOW loads are still queued.
+/// Tokens are not ordered by value, merge them with combineSyncTokens instead of max.
+SyncToken combineSyncTokens(SyncToken a, SyncToken b);
 SyncToken getLastTokenCompleted();
 bool      isTokenCompleted(const SyncToken* token);
 void      waitForToken(const SyncToken* token);
@@ -389,6 +484,16 @@ Semaphore* getLastSemaphoreCompleted(uint32_t nodeIndex);
 /// Either loads the cached shader bytecode or compiles the shader to create new bytecode depending on whether source is newer than binary
 void addShader(Renderer* pRenderer, const ShaderLoadDesc* pDesc, Shader** pShader);
 
+/// Compiles the pipeline on a worker thread (see ResourceLoaderDesc::mPipelineThreadCount).
+/// Identical descriptions share one Pipeline, every addPipeline needs its own removePipeline.
+/// If token is non NULL, *ppPipeline is written when isTokenCompleted(token) returns true and must not be read before.
+/// The state descriptions pDesc points to are copied. pCache must not be externally synchronized.
+/// Descriptions with pipeline extensions are compiled on the calling thread.
+void addPipeline(Renderer* pRenderer, const PipelineDesc* pDesc, Pipeline** ppPipeline, SyncToken* token);
+/// Must not be called before the token of the matching addPipeline completed
+void removePipeline(Renderer* pRenderer, Pipeline* pPipeline);
+void getPipelineCompileStats(PipelineCompileStats* pOutStats);
+
 /// Save/Load pipeline cache from disk
 void loadPipelineCache(Renderer* pRenderer, const PipelineCacheLoadDesc* pDesc, PipelineCache** ppPipelineCache);
 void savePipelineCache(Renderer* pRenderer, PipelineCache* pPipelineCache, PipelineCacheSaveDesc* pDesc);
@@ -0,0 +1,1716 @@
+/*
+ * Copyright (c) 2017-2022 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Null Vulkan driver, see NullDriver.h.
+// Objects are plain allocations behind the Vulkan handles. Host visible memory gets real storage the first time it is mapped,
+// command buffers only count what is recorded and all submitted work completes immediately.
+// Per frame totals are published as profiler counters under "NullDriver/" on every present.
+
+#include "../Include/RendererConfig.h"
+
+#if defined(NULL_RENDERER)
+
+#include "../../ThirdParty/OpenSource/tinyimageformat/tinyimageformat_base.h"
+#include "../../ThirdParty/OpenSource/tinyimageformat/tinyimageformat_query.h"
+#include "../../ThirdParty/OpenSource/tinyimageformat/tinyimageformat_apis.h"
+
+#include "../Include/IRenderer.h"
+#include "../../OS/Core/Atomics.h"
+#include "../../OS/Interfaces/ILog.h"
+#include "../../OS/Profiler/ProfilerBase.h"
+
+#include "NullDriver.h"
+
+#include "../../OS/Interfaces/IMemory.h"
+
+#define NULL_TO_HANDLE(type, p) ((type)(uintptr_t)(p))
+#define NULL_FROM_HANDLE(type, h) ((type*)(uintptr_t)(h))
+
+#define NULL_VENDOR_ID 0x10000
+#define NULL_DEVICE_ID 0x1
+#define NULL_QUEUE_FAMILY_COUNT 3
+#define NULL_MEMORY_TYPE_COUNT 4
+#define NULL_BUFFER_ALIGNMENT 256
+#define NULL_IMAGE_ALIGNMENT 4096
+#define NULL_PIPELINE_CACHE_HEADER_SIZE 32
+
+/************************************************************************/
+// Objects
+/************************************************************************/
+typedef struct NullPhysicalDevice
+{
+	uint32_t mIndex;
+} NullPhysicalDevice;
+
+typedef struct NullInstance
+{
+	NullPhysicalDevice mGpu;
+} NullInstance;
+
+typedef struct NullQueue
+{
+	uint32_t mFamilyIndex;
+} NullQueue;
+
+typedef struct NullDevice
+{
+	NullQueue mQueues[NULL_QUEUE_FAMILY_COUNT];
+} NullDevice;
+
+/// Objects the driver never looks into (views, layouts, render passes, ...)
+typedef struct NullObject
+{
+	uint32_t mUnused;
+} NullObject;
+
+typedef struct NullMemory
+{
+	VkDeviceSize mSize;
+	uint32_t     mHeapIndex;
+	/// Backing storage, allocated on first map
+	void*        pData;
+} NullMemory;
+
+typedef struct NullBuffer
+{
+	VkDeviceSize mSize;
+} NullBuffer;
+
+typedef struct NullImage
+{
+	VkDeviceSize mSize;
+} NullImage;
+
+typedef struct NullFence
+{
+	tfrg_atomic32_t mSignaled;
+} NullFence;
+
+typedef struct NullSwapchain
+{
+	VkImage* pImages;
+	uint32_t mImageCount;
+	uint32_t mNextImage;
+} NullSwapchain;
+
+typedef struct NullDescriptorSet
+{
+	uint32_t mIndex;
+} NullDescriptorSet;
+
+typedef struct NullDescriptorPool
+{
+	NullDescriptorSet* pSets;
+	/// Stack of unused set indices
+	uint32_t*          pFreeIndices;
+	uint32_t           mFreeCount;
+	uint32_t           mMaxSets;
+} NullDescriptorPool;
+
+typedef struct NullDescriptorUpdateTemplate
+{
+	uint32_t mDescriptorCount;
+} NullDescriptorUpdateTemplate;
+
+typedef struct NullCommandStats
+{
+	uint32_t mCommands;
+	uint32_t mDraws;
+	uint32_t mDispatches;
+	uint32_t mBarriers;
+	uint32_t mCopies;
+	uint32_t mRenderPasses;
+} NullCommandStats;
+
+typedef struct NullCommandBuffer
+{
+	struct NullCommandPool*   pPool;
+	struct NullCommandBuffer* pNext;
+	NullCommandStats          mStats;
+} NullCommandBuffer;
+
+typedef struct NullCommandPool
+{
+	NullCommandBuffer* pFirst;
+} NullCommandPool;
+
+typedef struct NullStats
+{
+	tfrg_atomic64_t mSubmits;
+	tfrg_atomic64_t mCommandBuffers;
+	tfrg_atomic64_t mCommands;
+	tfrg_atomic64_t mDraws;
+	tfrg_atomic64_t mDispatches;
+	tfrg_atomic64_t mBarriers;
+	tfrg_atomic64_t mCopies;
+	tfrg_atomic64_t mRenderPasses;
+	tfrg_atomic64_t mDescriptorWrites;
+} NullStats;
+
+static NullStats       gNullStats = {};
+/// Bytes allocated per memory heap
+static tfrg_atomic64_t gNullHeapUsage[2] = {};
+/// Budget reported for the device local heap instead of its size, 0 if not overridden
+static tfrg_atomic64_t gNullDeviceLocalBudget = 0;
+
+static const VkMemoryHeap gNullMemoryHeaps[] = {
+	{ 8ull * 1024 * 1024 * 1024, VK_MEMORY_HEAP_DEVICE_LOCAL_BIT },
+	{ 16ull * 1024 * 1024 * 1024, 0 },
+};
+
+static const VkMemoryType gNullMemoryTypes[NULL_MEMORY_TYPE_COUNT] = {
+	{ VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0 },
+	{ VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 1 },
+	{ VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT, 1 },
+	{ VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0 },
+};
+
+static const VkQueueFamilyProperties gNullQueueFamilies[NULL_QUEUE_FAMILY_COUNT] = {
+	{ VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT, 1, 64, { 1, 1, 1 } },
+	{ VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT, 1, 64, { 1, 1, 1 } },
+	{ VK_QUEUE_TRANSFER_BIT, 1, 64, { 1, 1, 1 } },
+};
+
+static const VkExtensionProperties gNullInstanceExtensions[] = {
+	{ VK_KHR_SURFACE_EXTENSION_NAME, 1 },
+#if defined(_WINDOWS)
+	{ "VK_KHR_win32_surface", 1 },
+#elif defined(__ANDROID__)
+	{ "VK_KHR_android_surface", 1 },
+#elif defined(__linux__)
+	{ "VK_KHR_xlib_surface", 1 },
+	{ "VK_KHR_xcb_surface", 1 },
+#endif
+	{ VK_EXT_DEBUG_UTILS_EXTENSION_NAME, 1 },
+	{ VK_EXT_DEBUG_REPORT_EXTENSION_NAME, 1 },
+	{ VK_EXT_SWAPCHAIN_COLOR_SPACE_EXTENSION_NAME, 1 },
+	{ VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME, 1 },
+};
+
+// Only what the front end has a path for, raytracing, YCbCr and vendor extensions stay off
+static const VkExtensionProperties gNullDeviceExtensions[] = {
+	{ VK_KHR_SWAPCHAIN_EXTENSION_NAME, 1 },
+	{ VK_KHR_MAINTENANCE1_EXTENSION_NAME, 1 },
+	{ VK_KHR_SHADER_DRAW_PARAMETERS_EXTENSION_NAME, 1 },
+	{ VK_EXT_SHADER_SUBGROUP_BALLOT_EXTENSION_NAME, 1 },
+	{ VK_EXT_SHADER_SUBGROUP_VOTE_EXTENSION_NAME, 1 },
+	{ VK_KHR_DEDICATED_ALLOCATION_EXTENSION_NAME, 1 },
+	{ VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME, 1 },
+#if VK_EXT_memory_budget
+	{ VK_EXT_MEMORY_BUDGET_EXTENSION_NAME, 1 },
+#endif
+#if VK_KHR_draw_indirect_count
+	{ VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME, 1 },
+#endif
+	{ VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME, 1 },
+#if VK_KHR_maintenance3
+	{ VK_KHR_MAINTENANCE3_EXTENSION_NAME, 1 },
+#endif
+#if VK_KHR_bind_memory2
+	{ VK_KHR_BIND_MEMORY_2_EXTENSION_NAME, 1 },
+#endif
+#ifndef ENABLE_DEBUG_UTILS_EXTENSION
+	{ VK_EXT_DEBUG_MARKER_EXTENSION_NAME, 1 },
+#endif
+};
+
+static const VkSurfaceFormatKHR gNullSurfaceFormats[] = {
+	{ VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR },
+	{ VK_FORMAT_B8G8R8A8_SRGB, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR },
+	{ VK_FORMAT_R8G8B8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR },
+	{ VK_FORMAT_R8G8B8A8_SRGB, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR },
+	{ VK_FORMAT_A2B10G10R10_UNORM_PACK32, VK_COLOR_SPACE_HDR10_ST2084_EXT },
+};
+
+static const VkPresentModeKHR gNullPresentModes[] = {
+	VK_PRESENT_MODE_FIFO_KHR,
+	VK_PRESENT_MODE_FIFO_RELAXED_KHR,
+	VK_PRESENT_MODE_MAILBOX_KHR,
+	VK_PRESENT_MODE_IMMEDIATE_KHR,
+};
+
+/************************************************************************/
+// Helpers
+/************************************************************************/
+static inline VkDeviceSize util_align(VkDeviceSize size, VkDeviceSize alignment) { return (size + alignment - 1) & ~(alignment - 1); }
+
+/// Standard two call enumeration: count only when pDst is NULL, VK_INCOMPLETE when the caller array is too small
+static VkResult util_enumerate(uint32_t* pCount, void* pDst, const void* pSrc, uint32_t srcCount, size_t stride)
+{
+	if (!pDst)
+	{
+		*pCount = srcCount;
+		return VK_SUCCESS;
+	}
+
+	const uint32_t count = *pCount < srcCount ? *pCount : srcCount;
+	memcpy(pDst, pSrc, count * stride);
+	*pCount = count;
+	return count < srcCount ? VK_INCOMPLETE : VK_SUCCESS;
+}
+
+static inline NullCommandStats* util_record_command(VkCommandBuffer commandBuffer)
+{
+	NullCommandStats* pStats = &NULL_FROM_HANDLE(NullCommandBuffer, commandBuffer)->mStats;
+	++pStats->mCommands;
+	return pStats;
+}
+
+static inline void util_signal_fence(VkFence fence)
+{
+	if (fence != VK_NULL_HANDLE)
+		tfrg_atomic32_store_release(&NULL_FROM_HANDLE(NullFence, fence)->mSignaled, 1);
+}
+
+static inline uint64_t util_take_stat(tfrg_atomic64_t* pStat)
+{
+	const uint64_t value = tfrg_atomic64_load_relaxed(pStat);
+	tfrg_atomic64_add_relaxed(pStat, (uint64_t)(-(int64_t)value));
+	return value;
+}
+
+static VkDeviceSize util_get_image_size(const VkImageCreateInfo* pCreateInfo)
+{
+	const TinyImageFormat format = TinyImageFormat_FromVkFormat((TinyImageFormat_VkFormat)pCreateInfo->format);
+	const VkDeviceSize    blockWidth = TinyImageFormat_WidthOfBlock(format) ? TinyImageFormat_WidthOfBlock(format) : 1;
+	const VkDeviceSize    blockHeight = TinyImageFormat_HeightOfBlock(format) ? TinyImageFormat_HeightOfBlock(format) : 1;
+	// Planar and unknown formats are sized like RGBA8
+	const VkDeviceSize    blockBytes = TinyImageFormat_BitSizeOfBlock(format) ? TinyImageFormat_BitSizeOfBlock(format) / 8 : 4;
+
+	VkDeviceSize size = 0;
+	for (uint32_t mip = 0; mip < pCreateInfo->mipLevels; ++mip)
+	{
+		const VkDeviceSize width = (pCreateInfo->extent.width >> mip) ? (pCreateInfo->extent.width >> mip) : 1;
+		const VkDeviceSize height = (pCreateInfo->extent.height >> mip) ? (pCreateInfo->extent.height >> mip) : 1;
+		const VkDeviceSize depth = (pCreateInfo->extent.depth >> mip) ? (pCreateInfo->extent.depth >> mip) : 1;
+		size += ((width + blockWidth - 1) / blockWidth) * ((height + blockHeight - 1) / blockHeight) * depth * blockBytes;
+	}
+
+	return size * pCreateInfo->arrayLayers * (VkDeviceSize)pCreateInfo->samples;
+}
+
+static void util_fill_memory_requirements(VkDeviceSize size, VkDeviceSize alignment, VkMemoryRequirements* pRequirements)
+{
+	pRequirements->size = util_align(size ? size : 1, alignment);
+	pRequirements->alignment = alignment;
+	pRequirements->memoryTypeBits = (1u << NULL_MEMORY_TYPE_COUNT) - 1;
+}
+
+static void util_fill_dedicated_requirements(VkMemoryRequirements2* pRequirements)
+{
+	for (VkBaseOutStructure* pNext = (VkBaseOutStructure*)pRequirements->pNext; pNext; pNext = pNext->pNext)
+	{
+		if (VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS == pNext->sType)
+		{
+			VkMemoryDedicatedRequirements* pDedicated = (VkMemoryDedicatedRequirements*)pNext;
+			pDedicated->prefersDedicatedAllocation = VK_FALSE;
+			pDedicated->requiresDedicatedAllocation = VK_FALSE;
+		}
+	}
+}
+
+/************************************************************************/
+// Instance
+/************************************************************************/
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkEnumerateInstanceVersion(uint32_t* pApiVersion)
+{
+	*pApiVersion = VK_API_VERSION_1_1;
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkEnumerateInstanceLayerProperties(uint32_t* pPropertyCount, VkLayerProperties*)
+{
+	*pPropertyCount = 0;
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL
+	null_vkEnumerateInstanceExtensionProperties(const char* pLayerName, uint32_t* pPropertyCount, VkExtensionProperties* pProperties)
+{
+	// No layers, so nothing is provided by one
+	if (pLayerName)
+	{
+		*pPropertyCount = 0;
+		return VK_ERROR_LAYER_NOT_PRESENT;
+	}
+
+	return util_enumerate(
+		pPropertyCount, pProperties, gNullInstanceExtensions, sizeof(gNullInstanceExtensions) / sizeof(gNullInstanceExtensions[0]),
+		sizeof(VkExtensionProperties));
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkCreateInstance(const VkInstanceCreateInfo*, const VkAllocationCallbacks*, VkInstance* pInstance)
+{
+	NullInstance* pNullInstance = (NullInstance*)tf_calloc(1, sizeof(NullInstance));
+	*pInstance = NULL_TO_HANDLE(VkInstance, pNullInstance);
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkDestroyInstance(VkInstance instance, const VkAllocationCallbacks*)
+{
+	tf_free(NULL_FROM_HANDLE(NullInstance, instance));
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL
+	null_vkEnumeratePhysicalDevices(VkInstance instance, uint32_t* pPhysicalDeviceCount, VkPhysicalDevice* pPhysicalDevices)
+{
+	const VkPhysicalDevice gpu = NULL_TO_HANDLE(VkPhysicalDevice, &NULL_FROM_HANDLE(NullInstance, instance)->mGpu);
+	return util_enumerate(pPhysicalDeviceCount, pPhysicalDevices, &gpu, 1, sizeof(VkPhysicalDevice));
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkCreateDebugUtilsMessengerEXT(
+	VkInstance, const VkDebugUtilsMessengerCreateInfoEXT*, const VkAllocationCallbacks*, VkDebugUtilsMessengerEXT* pMessenger)
+{
+	*pMessenger = NULL_TO_HANDLE(VkDebugUtilsMessengerEXT, tf_calloc(1, sizeof(NullObject)));
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkDestroyDebugUtilsMessengerEXT(VkInstance, VkDebugUtilsMessengerEXT messenger, const VkAllocationCallbacks*)
+{
+	tf_free(NULL_FROM_HANDLE(NullObject, messenger));
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkCreateDebugReportCallbackEXT(
+	VkInstance, const VkDebugReportCallbackCreateInfoEXT*, const VkAllocationCallbacks*, VkDebugReportCallbackEXT* pCallback)
+{
+	*pCallback = NULL_TO_HANDLE(VkDebugReportCallbackEXT, tf_calloc(1, sizeof(NullObject)));
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkDestroyDebugReportCallbackEXT(VkInstance, VkDebugReportCallbackEXT callback, const VkAllocationCallbacks*)
+{
+	tf_free(NULL_FROM_HANDLE(NullObject, callback));
+}
+
+/************************************************************************/
+// Surface
+/************************************************************************/
+// Shared by every platform vkCreate*SurfaceKHR entry point, the create info is never read
+// so the platform specific structure types are not needed here
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkCreateSurfaceKHR(VkInstance, const void*, const VkAllocationCallbacks*, VkSurfaceKHR* pSurface)
+{
+	*pSurface = NULL_TO_HANDLE(VkSurfaceKHR, tf_calloc(1, sizeof(NullObject)));
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkDestroySurfaceKHR(VkInstance, VkSurfaceKHR surface, const VkAllocationCallbacks*)
+{
+	tf_free(NULL_FROM_HANDLE(NullObject, surface));
+}
+
+static VKAPI_ATTR VkBool32 VKAPI_CALL null_vkGetPhysicalDeviceWin32PresentationSupportKHR(VkPhysicalDevice, uint32_t queueFamilyIndex)
+{
+	return 0 == queueFamilyIndex;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL
+	null_vkGetPhysicalDeviceSurfaceSupportKHR(VkPhysicalDevice, uint32_t queueFamilyIndex, VkSurfaceKHR, VkBool32* pSupported)
+{
+	// Presenting only from the graphics family keeps the front end on its single queue path
+	*pSupported = 0 == queueFamilyIndex;
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL
+	null_vkGetPhysicalDeviceSurfaceCapabilitiesKHR(VkPhysicalDevice, VkSurfaceKHR, VkSurfaceCapabilitiesKHR* pCapabilities)
+{
+	*pCapabilities = {};
+	pCapabilities->minImageCount = 2;
+	pCapabilities->maxImageCount = 8;
+	pCapabilities->currentExtent = { 0xFFFFFFFF, 0xFFFFFFFF };
+	pCapabilities->minImageExtent = { 1, 1 };
+	pCapabilities->maxImageExtent = { 16384, 16384 };
+	pCapabilities->maxImageArrayLayers = 1;
+	pCapabilities->supportedTransforms = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+	pCapabilities->currentTransform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+	pCapabilities->supportedCompositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+	pCapabilities->supportedUsageFlags = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+		VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL
+	null_vkGetPhysicalDeviceSurfaceFormatsKHR(VkPhysicalDevice, VkSurfaceKHR, uint32_t* pSurfaceFormatCount, VkSurfaceFormatKHR* pSurfaceFormats)
+{
+	return util_enumerate(
+		pSurfaceFormatCount, pSurfaceFormats, gNullSurfaceFormats, sizeof(gNullSurfaceFormats) / sizeof(gNullSurfaceFormats[0]),
+		sizeof(VkSurfaceFormatKHR));
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL
+	null_vkGetPhysicalDeviceSurfacePresentModesKHR(VkPhysicalDevice, VkSurfaceKHR, uint32_t* pPresentModeCount, VkPresentModeKHR* pPresentModes)
+{
+	return util_enumerate(
+		pPresentModeCount, pPresentModes, gNullPresentModes, sizeof(gNullPresentModes) / sizeof(gNullPresentModes[0]),
+		sizeof(VkPresentModeKHR));
+}
+
+/************************************************************************/
+// Physical device
+/************************************************************************/
+static VKAPI_ATTR void VKAPI_CALL null_vkGetPhysicalDeviceFeatures(VkPhysicalDevice, VkPhysicalDeviceFeatures* pFeatures)
+{
+	for (VkBool32* pFeature = &pFeatures->robustBufferAccess; pFeature <= &pFeatures->inheritedQueries; ++pFeature)
+		*pFeature = VK_TRUE;
+
+	// Sparse residency needs real page tables
+	pFeatures->sparseBinding = VK_FALSE;
+	pFeatures->sparseResidencyBuffer = VK_FALSE;
+	pFeatures->sparseResidencyImage2D = VK_FALSE;
+	pFeatures->sparseResidencyImage3D = VK_FALSE;
+	pFeatures->sparseResidency2Samples = VK_FALSE;
+	pFeatures->sparseResidency4Samples = VK_FALSE;
+	pFeatures->sparseResidency8Samples = VK_FALSE;
+	pFeatures->sparseResidency16Samples = VK_FALSE;
+	pFeatures->sparseResidencyAliased = VK_FALSE;
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkGetPhysicalDeviceFeatures2(VkPhysicalDevice physicalDevice, VkPhysicalDeviceFeatures2* pFeatures)
+{
+	null_vkGetPhysicalDeviceFeatures(physicalDevice, &pFeatures->features);
+
+	// Structures the driver does not know keep what the caller put in them
+	for (VkBaseOutStructure* pNext = (VkBaseOutStructure*)pFeatures->pNext; pNext; pNext = pNext->pNext)
+	{
+		if (VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT == pNext->sType)
+		{
+			VkPhysicalDeviceDescriptorIndexingFeaturesEXT* pIndexing = (VkPhysicalDeviceDescriptorIndexingFeaturesEXT*)pNext;
+			for (VkBool32* pFeature = &pIndexing->shaderInputAttachmentArrayDynamicIndexing; pFeature <= &pIndexing->runtimeDescriptorArray;
+				 ++pFeature)
+				*pFeature = VK_TRUE;
+		}
+	}
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkGetPhysicalDeviceProperties(VkPhysicalDevice, VkPhysicalDeviceProperties* pProperties)
+{
+	*pProperties = {};
+	pProperties->apiVersion = VK_API_VERSION_1_1;
+	pProperties->driverVersion = VK_MAKE_VERSION(1, 0, 0);
+	pProperties->vendorID = NULL_VENDOR_ID;
+	pProperties->deviceID = NULL_DEVICE_ID;
+	// Reported as discrete so device selection and presets treat it like real hardware
+	pProperties->deviceType = VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU;
+	strncpy(pProperties->deviceName, "The Forge Null Device", VK_MAX_PHYSICAL_DEVICE_NAME_SIZE - 1);
+	memset(pProperties->pipelineCacheUUID, 0x4E, VK_UUID_SIZE);
+
+	VkPhysicalDeviceLimits* pLimits = &pProperties->limits;
+	pLimits->maxImageDimension1D = 16384;
+	pLimits->maxImageDimension2D = 16384;
+	pLimits->maxImageDimension3D = 2048;
+	pLimits->maxImageDimensionCube = 16384;
+	pLimits->maxImageArrayLayers = 2048;
+	pLimits->maxTexelBufferElements = 1u << 27;
+	pLimits->maxUniformBufferRange = 65536;
+	pLimits->maxStorageBufferRange = UINT32_MAX;
+	pLimits->maxPushConstantsSize = 256;
+	pLimits->maxMemoryAllocationCount = UINT32_MAX;
+	pLimits->maxSamplerAllocationCount = 4000;
+	pLimits->bufferImageGranularity = 1;
+	pLimits->sparseAddressSpaceSize = 0;
+	pLimits->maxBoundDescriptorSets = 32;
+	pLimits->maxPerStageDescriptorSamplers = 1u << 20;
+	pLimits->maxPerStageDescriptorUniformBuffers = 1u << 20;
+	pLimits->maxPerStageDescriptorStorageBuffers = 1u << 20;
+	pLimits->maxPerStageDescriptorSampledImages = 1u << 20;
+	pLimits->maxPerStageDescriptorStorageImages = 1u << 20;
+	pLimits->maxPerStageDescriptorInputAttachments = 1u << 20;
+	pLimits->maxPerStageResources = 1u << 20;
+	pLimits->maxDescriptorSetSamplers = 1u << 20;
+	pLimits->maxDescriptorSetUniformBuffers = 1u << 20;
+	pLimits->maxDescriptorSetUniformBuffersDynamic = 16;
+	pLimits->maxDescriptorSetStorageBuffers = 1u << 20;
+	pLimits->maxDescriptorSetStorageBuffersDynamic = 16;
+	pLimits->maxDescriptorSetSampledImages = 1u << 20;
+	pLimits->maxDescriptorSetStorageImages = 1u << 20;
+	pLimits->maxDescriptorSetInputAttachments = 1u << 20;
+	pLimits->maxVertexInputAttributes = 32;
+	pLimits->maxVertexInputBindings = 32;
+	pLimits->maxVertexInputAttributeOffset = 2047;
+	pLimits->maxVertexInputBindingStride = 2048;
+	pLimits->maxVertexOutputComponents = 128;
+	pLimits->maxFragmentInputComponents = 128;
+	pLimits->maxFragmentOutputAttachments = 8;
+	pLimits->maxComputeSharedMemorySize = 49152;
+	pLimits->maxComputeWorkGroupCount[0] = 65535;
+	pLimits->maxComputeWorkGroupCount[1] = 65535;
+	pLimits->maxComputeWorkGroupCount[2] = 65535;
+	pLimits->maxComputeWorkGroupInvocations = 1024;
+	pLimits->maxComputeWorkGroupSize[0] = 1024;
+	pLimits->maxComputeWorkGroupSize[1] = 1024;
+	pLimits->maxComputeWorkGroupSize[2] = 64;
+	pLimits->maxDrawIndexedIndexValue = UINT32_MAX;
+	pLimits->maxDrawIndirectCount = UINT32_MAX;
+	pLimits->maxSamplerLodBias = 16.0f;
+	pLimits->maxSamplerAnisotropy = 16.0f;
+	pLimits->maxViewports = 16;
+	pLimits->maxViewportDimensions[0] = 16384;
+	pLimits->maxViewportDimensions[1] = 16384;
+	pLimits->viewportBoundsRange[0] = -32768.0f;
+	pLimits->viewportBoundsRange[1] = 32767.0f;
+	pLimits->minMemoryMapAlignment = 64;
+	pLimits->minTexelBufferOffsetAlignment = 16;
+	pLimits->minUniformBufferOffsetAlignment = NULL_BUFFER_ALIGNMENT;
+	pLimits->minStorageBufferOffsetAlignment = 16;
+	pLimits->maxFramebufferWidth = 16384;
+	pLimits->maxFramebufferHeight = 16384;
+	pLimits->maxFramebufferLayers = 2048;
+	pLimits->framebufferColorSampleCounts = VK_SAMPLE_COUNT_1_BIT | VK_SAMPLE_COUNT_2_BIT | VK_SAMPLE_COUNT_4_BIT | VK_SAMPLE_COUNT_8_BIT;
+	pLimits->framebufferDepthSampleCounts = pLimits->framebufferColorSampleCounts;
+	pLimits->framebufferStencilSampleCounts = pLimits->framebufferColorSampleCounts;
+	pLimits->framebufferNoAttachmentsSampleCounts = pLimits->framebufferColorSampleCounts;
+	pLimits->maxColorAttachments = 8;
+	pLimits->sampledImageColorSampleCounts = pLimits->framebufferColorSampleCounts;
+	pLimits->sampledImageIntegerSampleCounts = pLimits->framebufferColorSampleCounts;
+	pLimits->sampledImageDepthSampleCounts = pLimits->framebufferColorSampleCounts;
+	pLimits->sampledImageStencilSampleCounts = pLimits->framebufferColorSampleCounts;
+	pLimits->storageImageSampleCounts = VK_SAMPLE_COUNT_1_BIT;
+	pLimits->maxSampleMaskWords = 1;
+	pLimits->timestampComputeAndGraphics = VK_TRUE;
+	pLimits->timestampPeriod = 1.0f;
+	pLimits->maxClipDistances = 8;
+	pLimits->maxCullDistances = 8;
+	pLimits->maxCombinedClipAndCullDistances = 8;
+	pLimits->optimalBufferCopyOffsetAlignment = 512;
+	pLimits->optimalBufferCopyRowPitchAlignment = 256;
+	pLimits->nonCoherentAtomSize = 64;
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkGetPhysicalDeviceProperties2(VkPhysicalDevice physicalDevice, VkPhysicalDeviceProperties2* pProperties)
+{
+	null_vkGetPhysicalDeviceProperties(physicalDevice, &pProperties->properties);
+
+	for (VkBaseOutStructure* pNext = (VkBaseOutStructure*)pProperties->pNext; pNext; pNext = pNext->pNext)
+	{
+		if (VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES == pNext->sType)
+		{
+			VkPhysicalDeviceSubgroupProperties* pSubgroup = (VkPhysicalDeviceSubgroupProperties*)pNext;
+			pSubgroup->subgroupSize = 32;
+			pSubgroup->supportedStages = VK_SHADER_STAGE_ALL;
+			pSubgroup->supportedOperations = VK_SUBGROUP_FEATURE_BASIC_BIT | VK_SUBGROUP_FEATURE_VOTE_BIT | VK_SUBGROUP_FEATURE_ARITHMETIC_BIT |
+				VK_SUBGROUP_FEATURE_BALLOT_BIT | VK_SUBGROUP_FEATURE_SHUFFLE_BIT | VK_SUBGROUP_FEATURE_SHUFFLE_RELATIVE_BIT |
+				VK_SUBGROUP_FEATURE_CLUSTERED_BIT | VK_SUBGROUP_FEATURE_QUAD_BIT;
+			pSubgroup->quadOperationsInAllStages = VK_TRUE;
+		}
+		else if (VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT == pNext->sType)
+		{
+			VkPhysicalDeviceDescriptorIndexingPropertiesEXT* pIndexing = (VkPhysicalDeviceDescriptorIndexingPropertiesEXT*)pNext;
+			const uint32_t                                   limit = 1u << 20;
+			pIndexing->maxUpdateAfterBindDescriptorsInAllPools = limit;
+			pIndexing->maxPerStageDescriptorUpdateAfterBindSamplers = limit;
+			pIndexing->maxPerStageDescriptorUpdateAfterBindUniformBuffers = limit;
+			pIndexing->maxPerStageDescriptorUpdateAfterBindStorageBuffers = limit;
+			pIndexing->maxPerStageDescriptorUpdateAfterBindSampledImages = limit;
+			pIndexing->maxPerStageDescriptorUpdateAfterBindStorageImages = limit;
+			pIndexing->maxPerStageDescriptorUpdateAfterBindInputAttachments = limit;
+			pIndexing->maxPerStageUpdateAfterBindResources = limit;
+			pIndexing->maxDescriptorSetUpdateAfterBindSamplers = limit;
+			pIndexing->maxDescriptorSetUpdateAfterBindUniformBuffers = limit;
+			pIndexing->maxDescriptorSetUpdateAfterBindUniformBuffersDynamic = 16;
+			pIndexing->maxDescriptorSetUpdateAfterBindStorageBuffers = limit;
+			pIndexing->maxDescriptorSetUpdateAfterBindStorageBuffersDynamic = 16;
+			pIndexing->maxDescriptorSetUpdateAfterBindSampledImages = limit;
+			pIndexing->maxDescriptorSetUpdateAfterBindStorageImages = limit;
+			pIndexing->maxDescriptorSetUpdateAfterBindInputAttachments = limit;
+		}
+	}
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkGetPhysicalDeviceMemoryProperties(VkPhysicalDevice, VkPhysicalDeviceMemoryProperties* pProperties)
+{
+	*pProperties = {};
+	pProperties->memoryTypeCount = NULL_MEMORY_TYPE_COUNT;
+	memcpy(pProperties->memoryTypes, gNullMemoryTypes, sizeof(gNullMemoryTypes));
+	pProperties->memoryHeapCount = sizeof(gNullMemoryHeaps) / sizeof(gNullMemoryHeaps[0]);
+	memcpy(pProperties->memoryHeaps, gNullMemoryHeaps, sizeof(gNullMemoryHeaps));
+}
+
+static VKAPI_ATTR void VKAPI_CALL
+	null_vkGetPhysicalDeviceMemoryProperties2(VkPhysicalDevice physicalDevice, VkPhysicalDeviceMemoryProperties2* pProperties)
+{
+	null_vkGetPhysicalDeviceMemoryProperties(physicalDevice, &pProperties->memoryProperties);
+
+#if VK_EXT_memory_budget
+	for (VkBaseOutStructure* pNext = (VkBaseOutStructure*)pProperties->pNext; pNext; pNext = pNext->pNext)
+	{
+		if (VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT == pNext->sType)
+		{
+			VkPhysicalDeviceMemoryBudgetPropertiesEXT* pBudget = (VkPhysicalDeviceMemoryBudgetPropertiesEXT*)pNext;
+			const uint64_t                             deviceLocalBudget = tfrg_atomic64_load_relaxed(&gNullDeviceLocalBudget);
+			for (uint32_t i = 0; i < pProperties->memoryProperties.memoryHeapCount; ++i)
+			{
+				const bool deviceLocal = (gNullMemoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+				pBudget->heapBudget[i] = deviceLocal && deviceLocalBudget ? deviceLocalBudget : gNullMemoryHeaps[i].size;
+				pBudget->heapUsage[i] = tfrg_atomic64_load_relaxed(&gNullHeapUsage[i]);
+			}
+		}
+	}
+#endif
+}
+
+static VKAPI_ATTR void VKAPI_CALL
+	null_vkGetPhysicalDeviceQueueFamilyProperties(VkPhysicalDevice, uint32_t* pQueueFamilyPropertyCount, VkQueueFamilyProperties* pProperties)
+{
+	util_enumerate(pQueueFamilyPropertyCount, pProperties, gNullQueueFamilies, NULL_QUEUE_FAMILY_COUNT, sizeof(VkQueueFamilyProperties));
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkGetPhysicalDeviceFormatProperties(VkPhysicalDevice, VkFormat vkFormat, VkFormatProperties* pProperties)
+{
+	*pProperties = {};
+	const TinyImageFormat format = TinyImageFormat_FromVkFormat((TinyImageFormat_VkFormat)vkFormat);
+	if (TinyImageFormat_UNDEFINED == format)
+		return;
+
+	const VkFormatFeatureFlags transfer = VK_FORMAT_FEATURE_TRANSFER_SRC_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT |
+		VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+	if (TinyImageFormat_IsDepthOnly(format) || TinyImageFormat_IsDepthAndStencil(format) || TinyImageFormat_IsStencilOnly(format))
+	{
+		pProperties->optimalTilingFeatures = transfer | VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT;
+	}
+	else if (TinyImageFormat_IsCompressed(format))
+	{
+		pProperties->optimalTilingFeatures = transfer | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+	}
+	else
+	{
+		pProperties->optimalTilingFeatures = transfer | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT | VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT |
+			VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BLEND_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT;
+		pProperties->linearTilingFeatures = pProperties->optimalTilingFeatures;
+		pProperties->bufferFeatures = VK_FORMAT_FEATURE_VERTEX_BUFFER_BIT | VK_FORMAT_FEATURE_UNIFORM_TEXEL_BUFFER_BIT |
+			VK_FORMAT_FEATURE_STORAGE_TEXEL_BUFFER_BIT;
+	}
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkGetPhysicalDeviceImageFormatProperties(
+	VkPhysicalDevice physicalDevice, VkFormat format, VkImageType, VkImageTiling, VkImageUsageFlags, VkImageCreateFlags,
+	VkImageFormatProperties* pProperties)
+{
+	VkFormatProperties formatProperties = {};
+	null_vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &formatProperties);
+	if (!formatProperties.optimalTilingFeatures)
+	{
+		*pProperties = {};
+		return VK_ERROR_FORMAT_NOT_SUPPORTED;
+	}
+
+	pProperties->maxExtent = { 16384, 16384, 2048 };
+	pProperties->maxMipLevels = 15;
+	pProperties->maxArrayLayers = 2048;
+	pProperties->sampleCounts = VK_SAMPLE_COUNT_1_BIT | VK_SAMPLE_COUNT_2_BIT | VK_SAMPLE_COUNT_4_BIT | VK_SAMPLE_COUNT_8_BIT;
+	pProperties->maxResourceSize = gNullMemoryHeaps[0].size;
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkEnumerateDeviceLayerProperties(VkPhysicalDevice, uint32_t* pPropertyCount, VkLayerProperties*)
+{
+	*pPropertyCount = 0;
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL
+	null_vkEnumerateDeviceExtensionProperties(VkPhysicalDevice, const char* pLayerName, uint32_t* pPropertyCount, VkExtensionProperties* pProperties)
+{
+	if (pLayerName)
+	{
+		*pPropertyCount = 0;
+		return VK_ERROR_LAYER_NOT_PRESENT;
+	}
+
+	return util_enumerate(
+		pPropertyCount, pProperties, gNullDeviceExtensions, sizeof(gNullDeviceExtensions) / sizeof(gNullDeviceExtensions[0]),
+		sizeof(VkExtensionProperties));
+}
+
+/************************************************************************/
+// Device
+/************************************************************************/
+static VKAPI_ATTR VkResult VKAPI_CALL
+	null_vkCreateDevice(VkPhysicalDevice, const VkDeviceCreateInfo*, const VkAllocationCallbacks*, VkDevice* pDevice)
+{
+	NullDevice* pNullDevice = (NullDevice*)tf_calloc(1, sizeof(NullDevice));
+	for (uint32_t i = 0; i < NULL_QUEUE_FAMILY_COUNT; ++i)
+		pNullDevice->mQueues[i].mFamilyIndex = i;
+
+	PROFILE_COUNTER_CONFIG("NullDriver/Submits", PROFILE_COUNTER_FORMAT_DEFAULT, 0, PROFILE_COUNTER_FLAG_DETAILED);
+	PROFILE_COUNTER_CONFIG("NullDriver/CommandBuffers", PROFILE_COUNTER_FORMAT_DEFAULT, 0, PROFILE_COUNTER_FLAG_DETAILED);
+	PROFILE_COUNTER_CONFIG("NullDriver/Commands", PROFILE_COUNTER_FORMAT_DEFAULT, 0, PROFILE_COUNTER_FLAG_DETAILED);
+	PROFILE_COUNTER_CONFIG("NullDriver/Draws", PROFILE_COUNTER_FORMAT_DEFAULT, 0, PROFILE_COUNTER_FLAG_DETAILED);
+	PROFILE_COUNTER_CONFIG("NullDriver/Dispatches", PROFILE_COUNTER_FORMAT_DEFAULT, 0, PROFILE_COUNTER_FLAG_DETAILED);
+	PROFILE_COUNTER_CONFIG("NullDriver/Barriers", PROFILE_COUNTER_FORMAT_DEFAULT, 0, PROFILE_COUNTER_FLAG_DETAILED);
+	PROFILE_COUNTER_CONFIG("NullDriver/Copies", PROFILE_COUNTER_FORMAT_DEFAULT, 0, PROFILE_COUNTER_FLAG_DETAILED);
+	PROFILE_COUNTER_CONFIG("NullDriver/RenderPasses", PROFILE_COUNTER_FORMAT_DEFAULT, 0, PROFILE_COUNTER_FLAG_DETAILED);
+	PROFILE_COUNTER_CONFIG("NullDriver/DescriptorWrites", PROFILE_COUNTER_FORMAT_DEFAULT, 0, PROFILE_COUNTER_FLAG_DETAILED);
+	PROFILE_COUNTER_CONFIG("NullDriver/Host memory", PROFILE_COUNTER_FORMAT_BYTES, 0, PROFILE_COUNTER_FLAG_DETAILED);
+
+	*pDevice = NULL_TO_HANDLE(VkDevice, pNullDevice);
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkDestroyDevice(VkDevice device, const VkAllocationCallbacks*)
+{
+	tf_free(NULL_FROM_HANDLE(NullDevice, device));
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkGetDeviceQueue(VkDevice device, uint32_t queueFamilyIndex, uint32_t, VkQueue* pQueue)
+{
+	ASSERT(queueFamilyIndex < NULL_QUEUE_FAMILY_COUNT);
+	*pQueue = NULL_TO_HANDLE(VkQueue, &NULL_FROM_HANDLE(NullDevice, device)->mQueues[queueFamilyIndex]);
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkDeviceWaitIdle(VkDevice) { return VK_SUCCESS; }
+
+/************************************************************************/
+// Queue
+/************************************************************************/
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkQueueSubmit(VkQueue, uint32_t submitCount, const VkSubmitInfo* pSubmits, VkFence fence)
+{
+	for (uint32_t i = 0; i < submitCount; ++i)
+	{
+		for (uint32_t c = 0; c < pSubmits[i].commandBufferCount; ++c)
+		{
+			const NullCommandStats* pStats = &NULL_FROM_HANDLE(NullCommandBuffer, pSubmits[i].pCommandBuffers[c])->mStats;
+			tfrg_atomic64_add_relaxed(&gNullStats.mCommands, pStats->mCommands);
+			tfrg_atomic64_add_relaxed(&gNullStats.mDraws, pStats->mDraws);
+			tfrg_atomic64_add_relaxed(&gNullStats.mDispatches, pStats->mDispatches);
+			tfrg_atomic64_add_relaxed(&gNullStats.mBarriers, pStats->mBarriers);
+			tfrg_atomic64_add_relaxed(&gNullStats.mCopies, pStats->mCopies);
+			tfrg_atomic64_add_relaxed(&gNullStats.mRenderPasses, pStats->mRenderPasses);
+		}
+		tfrg_atomic64_add_relaxed(&gNullStats.mCommandBuffers, pSubmits[i].commandBufferCount);
+	}
+	tfrg_atomic64_add_relaxed(&gNullStats.mSubmits, 1);
+
+	// Work completes on submit
+	util_signal_fence(fence);
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkQueueWaitIdle(VkQueue) { return VK_SUCCESS; }
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkQueueBindSparse(VkQueue, uint32_t, const VkBindSparseInfo*, VkFence fence)
+{
+	util_signal_fence(fence);
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkQueuePresentKHR(VkQueue, const VkPresentInfoKHR*)
+{
+	NullDriverStats stats = {};
+	nullDriverTakeStats(&stats);
+
+	PROFILE_COUNTER_SET("NullDriver/Submits", (int64_t)stats.mSubmits);
+	PROFILE_COUNTER_SET("NullDriver/CommandBuffers", (int64_t)stats.mCommandBuffers);
+	PROFILE_COUNTER_SET("NullDriver/Commands", (int64_t)stats.mCommands);
+	PROFILE_COUNTER_SET("NullDriver/Draws", (int64_t)stats.mDraws);
+	PROFILE_COUNTER_SET("NullDriver/Dispatches", (int64_t)stats.mDispatches);
+	PROFILE_COUNTER_SET("NullDriver/Barriers", (int64_t)stats.mBarriers);
+	PROFILE_COUNTER_SET("NullDriver/Copies", (int64_t)stats.mCopies);
+	PROFILE_COUNTER_SET("NullDriver/RenderPasses", (int64_t)stats.mRenderPasses);
+	PROFILE_COUNTER_SET("NullDriver/DescriptorWrites", (int64_t)stats.mDescriptorWrites);
+	return VK_SUCCESS;
+}
+
+/************************************************************************/
+// Memory
+/************************************************************************/
+static VKAPI_ATTR VkResult VKAPI_CALL
+	null_vkAllocateMemory(VkDevice, const VkMemoryAllocateInfo* pAllocateInfo, const VkAllocationCallbacks*, VkDeviceMemory* pMemory)
+{
+	ASSERT(pAllocateInfo->memoryTypeIndex < NULL_MEMORY_TYPE_COUNT);
+	NullMemory* pNullMemory = (NullMemory*)tf_calloc(1, sizeof(NullMemory));
+	pNullMemory->mSize = pAllocateInfo->allocationSize;
+	pNullMemory->mHeapIndex = gNullMemoryTypes[pAllocateInfo->memoryTypeIndex].heapIndex;
+	tfrg_atomic64_add_relaxed(&gNullHeapUsage[pNullMemory->mHeapIndex], pNullMemory->mSize);
+
+	*pMemory = NULL_TO_HANDLE(VkDeviceMemory, pNullMemory);
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkFreeMemory(VkDevice, VkDeviceMemory memory, const VkAllocationCallbacks*)
+{
+	NullMemory* pNullMemory = NULL_FROM_HANDLE(NullMemory, memory);
+	if (!pNullMemory)
+		return;
+
+	tfrg_atomic64_add_relaxed(&gNullHeapUsage[pNullMemory->mHeapIndex], (uint64_t)(-(int64_t)pNullMemory->mSize));
+	if (pNullMemory->pData)
+	{
+		PROFILE_COUNTER_SUB("NullDriver/Host memory", pNullMemory->mSize);
+		tf_free(pNullMemory->pData);
+	}
+	tf_free(pNullMemory);
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL
+	null_vkMapMemory(VkDevice, VkDeviceMemory memory, VkDeviceSize offset, VkDeviceSize, VkMemoryMapFlags, void** ppData)
+{
+	NullMemory* pNullMemory = NULL_FROM_HANDLE(NullMemory, memory);
+	// Device local memory never needs storage, host visible blocks only pay for it once the CPU touches them
+	if (!pNullMemory->pData)
+	{
+		pNullMemory->pData = tf_calloc_memalign(1, NULL_IMAGE_ALIGNMENT, (size_t)pNullMemory->mSize);
+		if (!pNullMemory->pData)
+			return VK_ERROR_MEMORY_MAP_FAILED;
+		PROFILE_COUNTER_ADD("NullDriver/Host memory", pNullMemory->mSize);
+	}
+
+	*ppData = (uint8_t*)pNullMemory->pData + offset;
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkUnmapMemory(VkDevice, VkDeviceMemory) {}
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkFlushMappedMemoryRanges(VkDevice, uint32_t, const VkMappedMemoryRange*) { return VK_SUCCESS; }
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkInvalidateMappedMemoryRanges(VkDevice, uint32_t, const VkMappedMemoryRange*) { return VK_SUCCESS; }
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkBindBufferMemory(VkDevice, VkBuffer, VkDeviceMemory, VkDeviceSize) { return VK_SUCCESS; }
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkBindImageMemory(VkDevice, VkImage, VkDeviceMemory, VkDeviceSize) { return VK_SUCCESS; }
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkBindBufferMemory2(VkDevice, uint32_t, const VkBindBufferMemoryInfo*) { return VK_SUCCESS; }
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkBindImageMemory2(VkDevice, uint32_t, const VkBindImageMemoryInfo*) { return VK_SUCCESS; }
+
+/************************************************************************/
+// Buffers and images
+/************************************************************************/
+static VKAPI_ATTR VkResult VKAPI_CALL
+	null_vkCreateBuffer(VkDevice, const VkBufferCreateInfo* pCreateInfo, const VkAllocationCallbacks*, VkBuffer* pBuffer)
+{
+	NullBuffer* pNullBuffer = (NullBuffer*)tf_calloc(1, sizeof(NullBuffer));
+	pNullBuffer->mSize = pCreateInfo->size;
+	*pBuffer = NULL_TO_HANDLE(VkBuffer, pNullBuffer);
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkDestroyBuffer(VkDevice, VkBuffer buffer, const VkAllocationCallbacks*)
+{
+	tf_free(NULL_FROM_HANDLE(NullBuffer, buffer));
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkCreateImage(VkDevice, const VkImageCreateInfo* pCreateInfo, const VkAllocationCallbacks*, VkImage* pImage)
+{
+	NullImage* pNullImage = (NullImage*)tf_calloc(1, sizeof(NullImage));
+	pNullImage->mSize = util_get_image_size(pCreateInfo);
+	*pImage = NULL_TO_HANDLE(VkImage, pNullImage);
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkDestroyImage(VkDevice, VkImage image, const VkAllocationCallbacks*)
+{
+	tf_free(NULL_FROM_HANDLE(NullImage, image));
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkGetBufferMemoryRequirements(VkDevice, VkBuffer buffer, VkMemoryRequirements* pRequirements)
+{
+	util_fill_memory_requirements(NULL_FROM_HANDLE(NullBuffer, buffer)->mSize, NULL_BUFFER_ALIGNMENT, pRequirements);
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkGetImageMemoryRequirements(VkDevice, VkImage image, VkMemoryRequirements* pRequirements)
+{
+	util_fill_memory_requirements(NULL_FROM_HANDLE(NullImage, image)->mSize, NULL_IMAGE_ALIGNMENT, pRequirements);
+}
+
+static VKAPI_ATTR void VKAPI_CALL
+	null_vkGetBufferMemoryRequirements2(VkDevice device, const VkBufferMemoryRequirementsInfo2* pInfo, VkMemoryRequirements2* pRequirements)
+{
+	null_vkGetBufferMemoryRequirements(device, pInfo->buffer, &pRequirements->memoryRequirements);
+	util_fill_dedicated_requirements(pRequirements);
+}
+
+static VKAPI_ATTR void VKAPI_CALL
+	null_vkGetImageMemoryRequirements2(VkDevice device, const VkImageMemoryRequirementsInfo2* pInfo, VkMemoryRequirements2* pRequirements)
+{
+	null_vkGetImageMemoryRequirements(device, pInfo->image, &pRequirements->memoryRequirements);
+	util_fill_dedicated_requirements(pRequirements);
+}
+
+static VKAPI_ATTR void VKAPI_CALL
+	null_vkGetImageSparseMemoryRequirements(VkDevice, VkImage, uint32_t* pSparseMemoryRequirementCount, VkSparseImageMemoryRequirements*)
+{
+	*pSparseMemoryRequirementCount = 0;
+}
+
+/************************************************************************/
+// Objects without driver state
+/************************************************************************/
+#define NULL_DEFINE_OBJECT(Type)                                                                                                 \
+	static VKAPI_ATTR VkResult VKAPI_CALL null_vkCreate##Type(                                                                   \
+		VkDevice, const Vk##Type##CreateInfo*, const VkAllocationCallbacks*, Vk##Type* pObject)                                  \
+	{                                                                                                                            \
+		*pObject = NULL_TO_HANDLE(Vk##Type, tf_calloc(1, sizeof(NullObject)));                                                   \
+		return VK_SUCCESS;                                                                                                       \
+	}                                                                                                                            \
+	static VKAPI_ATTR void VKAPI_CALL null_vkDestroy##Type(VkDevice, Vk##Type object, const VkAllocationCallbacks*) \
+	{                                                                                                                            \
+		tf_free(NULL_FROM_HANDLE(NullObject, object));                                                                           \
+	}
+
+NULL_DEFINE_OBJECT(BufferView)
+NULL_DEFINE_OBJECT(ImageView)
+NULL_DEFINE_OBJECT(Sampler)
+NULL_DEFINE_OBJECT(SamplerYcbcrConversion)
+NULL_DEFINE_OBJECT(ShaderModule)
+NULL_DEFINE_OBJECT(PipelineLayout)
+NULL_DEFINE_OBJECT(DescriptorSetLayout)
+NULL_DEFINE_OBJECT(RenderPass)
+NULL_DEFINE_OBJECT(Framebuffer)
+NULL_DEFINE_OBJECT(Semaphore)
+NULL_DEFINE_OBJECT(QueryPool)
+NULL_DEFINE_OBJECT(PipelineCache)
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkGetPipelineCacheData(VkDevice, VkPipelineCache, size_t* pDataSize, void* pData)
+{
+	if (!pData)
+	{
+		*pDataSize = NULL_PIPELINE_CACHE_HEADER_SIZE;
+		return VK_SUCCESS;
+	}
+
+	if (*pDataSize < NULL_PIPELINE_CACHE_HEADER_SIZE)
+	{
+		*pDataSize = 0;
+		return VK_INCOMPLETE;
+	}
+
+	// Header only cache (VK_PIPELINE_CACHE_HEADER_VERSION_ONE layout) so a saved cache loads back into the null device
+	uint32_t header[4] = { NULL_PIPELINE_CACHE_HEADER_SIZE, VK_PIPELINE_CACHE_HEADER_VERSION_ONE, NULL_VENDOR_ID, NULL_DEVICE_ID };
+	memcpy(pData, header, sizeof(header));
+	memset((uint8_t*)pData + sizeof(header), 0x4E, VK_UUID_SIZE);
+	*pDataSize = NULL_PIPELINE_CACHE_HEADER_SIZE;
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkCreateGraphicsPipelines(
+	VkDevice, VkPipelineCache, uint32_t createInfoCount, const VkGraphicsPipelineCreateInfo*, const VkAllocationCallbacks*, VkPipeline* pPipelines)
+{
+	for (uint32_t i = 0; i < createInfoCount; ++i)
+		pPipelines[i] = NULL_TO_HANDLE(VkPipeline, tf_calloc(1, sizeof(NullObject)));
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkCreateComputePipelines(
+	VkDevice, VkPipelineCache, uint32_t createInfoCount, const VkComputePipelineCreateInfo*, const VkAllocationCallbacks*, VkPipeline* pPipelines)
+{
+	for (uint32_t i = 0; i < createInfoCount; ++i)
+		pPipelines[i] = NULL_TO_HANDLE(VkPipeline, tf_calloc(1, sizeof(NullObject)));
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkDestroyPipeline(VkDevice, VkPipeline pipeline, const VkAllocationCallbacks*)
+{
+	tf_free(NULL_FROM_HANDLE(NullObject, pipeline));
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkGetQueryPoolResults(
+	VkDevice, VkQueryPool, uint32_t, uint32_t, size_t dataSize, void* pData, VkDeviceSize, VkQueryResultFlags)
+{
+	memset(pData, 0, dataSize);
+	return VK_SUCCESS;
+}
+
+/************************************************************************/
+// Synchronization
+/************************************************************************/
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkCreateFence(VkDevice, const VkFenceCreateInfo* pCreateInfo, const VkAllocationCallbacks*, VkFence* pFence)
+{
+	NullFence* pNullFence = (NullFence*)tf_calloc(1, sizeof(NullFence));
+	pNullFence->mSignaled = (pCreateInfo->flags & VK_FENCE_CREATE_SIGNALED_BIT) ? 1 : 0;
+	*pFence = NULL_TO_HANDLE(VkFence, pNullFence);
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkDestroyFence(VkDevice, VkFence fence, const VkAllocationCallbacks*)
+{
+	tf_free(NULL_FROM_HANDLE(NullFence, fence));
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkResetFences(VkDevice, uint32_t fenceCount, const VkFence* pFences)
+{
+	for (uint32_t i = 0; i < fenceCount; ++i)
+		tfrg_atomic32_store_release(&NULL_FROM_HANDLE(NullFence, pFences[i])->mSignaled, 0);
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkGetFenceStatus(VkDevice, VkFence fence)
+{
+	return tfrg_atomic32_load_acquire(&NULL_FROM_HANDLE(NullFence, fence)->mSignaled) ? VK_SUCCESS : VK_NOT_READY;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkWaitForFences(VkDevice, uint32_t fenceCount, const VkFence* pFences, VkBool32 waitAll, uint64_t)
+{
+	// Fences are signaled at submit time, one that is still unsignaled here was never submitted and would wait forever
+	uint32_t signaledCount = 0;
+	for (uint32_t i = 0; i < fenceCount; ++i)
+		signaledCount += tfrg_atomic32_load_acquire(&NULL_FROM_HANDLE(NullFence, pFences[i])->mSignaled) ? 1 : 0;
+
+	const bool signaled = waitAll ? signaledCount == fenceCount : signaledCount > 0;
+	return signaled ? VK_SUCCESS : VK_TIMEOUT;
+}
+
+/************************************************************************/
+// Swapchain
+/************************************************************************/
+static VKAPI_ATTR VkResult VKAPI_CALL
+	null_vkCreateSwapchainKHR(VkDevice, const VkSwapchainCreateInfoKHR* pCreateInfo, const VkAllocationCallbacks*, VkSwapchainKHR* pSwapchain)
+{
+	const uint32_t imageCount = pCreateInfo->minImageCount;
+	NullSwapchain* pNullSwapchain = (NullSwapchain*)tf_calloc(1, sizeof(NullSwapchain) + imageCount * sizeof(VkImage));
+	pNullSwapchain->pImages = (VkImage*)(pNullSwapchain + 1);
+	pNullSwapchain->mImageCount = imageCount;
+	for (uint32_t i = 0; i < imageCount; ++i)
+		pNullSwapchain->pImages[i] = NULL_TO_HANDLE(VkImage, tf_calloc(1, sizeof(NullImage)));
+
+	*pSwapchain = NULL_TO_HANDLE(VkSwapchainKHR, pNullSwapchain);
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkDestroySwapchainKHR(VkDevice, VkSwapchainKHR swapchain, const VkAllocationCallbacks*)
+{
+	NullSwapchain* pNullSwapchain = NULL_FROM_HANDLE(NullSwapchain, swapchain);
+	if (!pNullSwapchain)
+		return;
+
+	for (uint32_t i = 0; i < pNullSwapchain->mImageCount; ++i)
+		tf_free(NULL_FROM_HANDLE(NullImage, pNullSwapchain->pImages[i]));
+	tf_free(pNullSwapchain);
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL
+	null_vkGetSwapchainImagesKHR(VkDevice, VkSwapchainKHR swapchain, uint32_t* pSwapchainImageCount, VkImage* pSwapchainImages)
+{
+	const NullSwapchain* pNullSwapchain = NULL_FROM_HANDLE(NullSwapchain, swapchain);
+	return util_enumerate(pSwapchainImageCount, pSwapchainImages, pNullSwapchain->pImages, pNullSwapchain->mImageCount, sizeof(VkImage));
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL
+	null_vkAcquireNextImageKHR(VkDevice, VkSwapchainKHR swapchain, uint64_t, VkSemaphore, VkFence fence, uint32_t* pImageIndex)
+{
+	NullSwapchain* pNullSwapchain = NULL_FROM_HANDLE(NullSwapchain, swapchain);
+	*pImageIndex = pNullSwapchain->mNextImage;
+	pNullSwapchain->mNextImage = (pNullSwapchain->mNextImage + 1) % pNullSwapchain->mImageCount;
+	util_signal_fence(fence);
+	return VK_SUCCESS;
+}
+
+/************************************************************************/
+// Descriptors
+/************************************************************************/
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkCreateDescriptorPool(
+	VkDevice, const VkDescriptorPoolCreateInfo* pCreateInfo, const VkAllocationCallbacks*, VkDescriptorPool* pDescriptorPool)
+{
+	const uint32_t      maxSets = pCreateInfo->maxSets;
+	NullDescriptorPool* pPool = (NullDescriptorPool*)tf_calloc(
+		1, sizeof(NullDescriptorPool) + maxSets * (sizeof(NullDescriptorSet) + sizeof(uint32_t)));
+	pPool->pSets = (NullDescriptorSet*)(pPool + 1);
+	pPool->pFreeIndices = (uint32_t*)(pPool->pSets + maxSets);
+	pPool->mMaxSets = maxSets;
+	pPool->mFreeCount = maxSets;
+	for (uint32_t i = 0; i < maxSets; ++i)
+	{
+		pPool->pSets[i].mIndex = i;
+		pPool->pFreeIndices[i] = maxSets - 1 - i;
+	}
+
+	*pDescriptorPool = NULL_TO_HANDLE(VkDescriptorPool, pPool);
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkDestroyDescriptorPool(VkDevice, VkDescriptorPool descriptorPool, const VkAllocationCallbacks*)
+{
+	tf_free(NULL_FROM_HANDLE(NullDescriptorPool, descriptorPool));
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkResetDescriptorPool(VkDevice, VkDescriptorPool descriptorPool, VkDescriptorPoolResetFlags)
+{
+	NullDescriptorPool* pPool = NULL_FROM_HANDLE(NullDescriptorPool, descriptorPool);
+	pPool->mFreeCount = pPool->mMaxSets;
+	for (uint32_t i = 0; i < pPool->mMaxSets; ++i)
+		pPool->pFreeIndices[i] = pPool->mMaxSets - 1 - i;
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL
+	null_vkAllocateDescriptorSets(VkDevice, const VkDescriptorSetAllocateInfo* pAllocateInfo, VkDescriptorSet* pDescriptorSets)
+{
+	NullDescriptorPool* pPool = NULL_FROM_HANDLE(NullDescriptorPool, pAllocateInfo->descriptorPool);
+	if (pPool->mFreeCount < pAllocateInfo->descriptorSetCount)
+		return VK_ERROR_OUT_OF_POOL_MEMORY;
+
+	for (uint32_t i = 0; i < pAllocateInfo->descriptorSetCount; ++i)
+		pDescriptorSets[i] = NULL_TO_HANDLE(VkDescriptorSet, &pPool->pSets[pPool->pFreeIndices[--pPool->mFreeCount]]);
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL
+	null_vkFreeDescriptorSets(VkDevice, VkDescriptorPool descriptorPool, uint32_t descriptorSetCount, const VkDescriptorSet* pDescriptorSets)
+{
+	NullDescriptorPool* pPool = NULL_FROM_HANDLE(NullDescriptorPool, descriptorPool);
+	for (uint32_t i = 0; i < descriptorSetCount; ++i)
+	{
+		if (pDescriptorSets[i] != VK_NULL_HANDLE)
+			pPool->pFreeIndices[pPool->mFreeCount++] = NULL_FROM_HANDLE(NullDescriptorSet, pDescriptorSets[i])->mIndex;
+	}
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkUpdateDescriptorSets(
+	VkDevice, uint32_t descriptorWriteCount, const VkWriteDescriptorSet* pDescriptorWrites, uint32_t descriptorCopyCount,
+	const VkCopyDescriptorSet* pDescriptorCopies)
+{
+	uint64_t descriptorCount = 0;
+	for (uint32_t i = 0; i < descriptorWriteCount; ++i)
+		descriptorCount += pDescriptorWrites[i].descriptorCount;
+	for (uint32_t i = 0; i < descriptorCopyCount; ++i)
+		descriptorCount += pDescriptorCopies[i].descriptorCount;
+	tfrg_atomic64_add_relaxed(&gNullStats.mDescriptorWrites, descriptorCount);
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkCreateDescriptorUpdateTemplate(
+	VkDevice, const VkDescriptorUpdateTemplateCreateInfo* pCreateInfo, const VkAllocationCallbacks*,
+	VkDescriptorUpdateTemplate* pDescriptorUpdateTemplate)
+{
+	NullDescriptorUpdateTemplate* pTemplate = (NullDescriptorUpdateTemplate*)tf_calloc(1, sizeof(NullDescriptorUpdateTemplate));
+	for (uint32_t i = 0; i < pCreateInfo->descriptorUpdateEntryCount; ++i)
+		pTemplate->mDescriptorCount += pCreateInfo->pDescriptorUpdateEntries[i].descriptorCount;
+
+	*pDescriptorUpdateTemplate = NULL_TO_HANDLE(VkDescriptorUpdateTemplate, pTemplate);
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL
+	null_vkDestroyDescriptorUpdateTemplate(VkDevice, VkDescriptorUpdateTemplate descriptorUpdateTemplate, const VkAllocationCallbacks*)
+{
+	tf_free(NULL_FROM_HANDLE(NullDescriptorUpdateTemplate, descriptorUpdateTemplate));
+}
+
+static VKAPI_ATTR void VKAPI_CALL
+	null_vkUpdateDescriptorSetWithTemplate(VkDevice, VkDescriptorSet, VkDescriptorUpdateTemplate descriptorUpdateTemplate, const void*)
+{
+	tfrg_atomic64_add_relaxed(
+		&gNullStats.mDescriptorWrites, NULL_FROM_HANDLE(NullDescriptorUpdateTemplate, descriptorUpdateTemplate)->mDescriptorCount);
+}
+
+/************************************************************************/
+// Command pools and buffers
+/************************************************************************/
+static VKAPI_ATTR VkResult VKAPI_CALL
+	null_vkCreateCommandPool(VkDevice, const VkCommandPoolCreateInfo*, const VkAllocationCallbacks*, VkCommandPool* pCommandPool)
+{
+	*pCommandPool = NULL_TO_HANDLE(VkCommandPool, tf_calloc(1, sizeof(NullCommandPool)));
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkDestroyCommandPool(VkDevice, VkCommandPool commandPool, const VkAllocationCallbacks*)
+{
+	NullCommandPool* pPool = NULL_FROM_HANDLE(NullCommandPool, commandPool);
+	if (!pPool)
+		return;
+
+	// Destroying the pool frees every command buffer allocated from it
+	NullCommandBuffer* pCmd = pPool->pFirst;
+	while (pCmd)
+	{
+		NullCommandBuffer* pNext = pCmd->pNext;
+		tf_free(pCmd);
+		pCmd = pNext;
+	}
+	tf_free(pPool);
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkResetCommandPool(VkDevice, VkCommandPool commandPool, VkCommandPoolResetFlags)
+{
+	for (NullCommandBuffer* pCmd = NULL_FROM_HANDLE(NullCommandPool, commandPool)->pFirst; pCmd; pCmd = pCmd->pNext)
+		pCmd->mStats = {};
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL
+	null_vkAllocateCommandBuffers(VkDevice, const VkCommandBufferAllocateInfo* pAllocateInfo, VkCommandBuffer* pCommandBuffers)
+{
+	NullCommandPool* pPool = NULL_FROM_HANDLE(NullCommandPool, pAllocateInfo->commandPool);
+	for (uint32_t i = 0; i < pAllocateInfo->commandBufferCount; ++i)
+	{
+		NullCommandBuffer* pCmd = (NullCommandBuffer*)tf_calloc(1, sizeof(NullCommandBuffer));
+		pCmd->pPool = pPool;
+		pCmd->pNext = pPool->pFirst;
+		pPool->pFirst = pCmd;
+		pCommandBuffers[i] = NULL_TO_HANDLE(VkCommandBuffer, pCmd);
+	}
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR void VKAPI_CALL
+	null_vkFreeCommandBuffers(VkDevice, VkCommandPool commandPool, uint32_t commandBufferCount, const VkCommandBuffer* pCommandBuffers)
+{
+	NullCommandPool* pPool = NULL_FROM_HANDLE(NullCommandPool, commandPool);
+	for (uint32_t i = 0; i < commandBufferCount; ++i)
+	{
+		NullCommandBuffer* pCmd = NULL_FROM_HANDLE(NullCommandBuffer, pCommandBuffers[i]);
+		if (!pCmd)
+			continue;
+
+		NullCommandBuffer** ppLink = &pPool->pFirst;
+		while (*ppLink != pCmd)
+			ppLink = &(*ppLink)->pNext;
+		*ppLink = pCmd->pNext;
+		tf_free(pCmd);
+	}
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkBeginCommandBuffer(VkCommandBuffer commandBuffer, const VkCommandBufferBeginInfo*)
+{
+	// Begin implicitly resets
+	NULL_FROM_HANDLE(NullCommandBuffer, commandBuffer)->mStats = {};
+	return VK_SUCCESS;
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkEndCommandBuffer(VkCommandBuffer) { return VK_SUCCESS; }
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkResetCommandBuffer(VkCommandBuffer commandBuffer, VkCommandBufferResetFlags)
+{
+	NULL_FROM_HANDLE(NullCommandBuffer, commandBuffer)->mStats = {};
+	return VK_SUCCESS;
+}
+
+/************************************************************************/
+// Commands
+/************************************************************************/
+static VKAPI_ATTR void VKAPI_CALL null_vkCmdBeginRenderPass(VkCommandBuffer commandBuffer, const VkRenderPassBeginInfo*, VkSubpassContents)
+{
+	++util_record_command(commandBuffer)->mRenderPasses;
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkCmdEndRenderPass(VkCommandBuffer commandBuffer) { util_record_command(commandBuffer); }
+
+static VKAPI_ATTR void VKAPI_CALL null_vkCmdBindPipeline(VkCommandBuffer commandBuffer, VkPipelineBindPoint, VkPipeline)
+{
+	util_record_command(commandBuffer);
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkCmdBindDescriptorSets(
+	VkCommandBuffer commandBuffer, VkPipelineBindPoint, VkPipelineLayout, uint32_t, uint32_t, const VkDescriptorSet*, uint32_t, const uint32_t*)
+{
+	util_record_command(commandBuffer);
+}
+
+static VKAPI_ATTR void VKAPI_CALL
+	null_vkCmdPushConstants(VkCommandBuffer commandBuffer, VkPipelineLayout, VkShaderStageFlags, uint32_t, uint32_t, const void*)
+{
+	util_record_command(commandBuffer);
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkCmdBindIndexBuffer(VkCommandBuffer commandBuffer, VkBuffer, VkDeviceSize, VkIndexType)
+{
+	util_record_command(commandBuffer);
+}
+
+static VKAPI_ATTR void VKAPI_CALL
+	null_vkCmdBindVertexBuffers(VkCommandBuffer commandBuffer, uint32_t, uint32_t, const VkBuffer*, const VkDeviceSize*)
+{
+	util_record_command(commandBuffer);
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkCmdSetViewport(VkCommandBuffer commandBuffer, uint32_t, uint32_t, const VkViewport*)
+{
+	util_record_command(commandBuffer);
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkCmdSetScissor(VkCommandBuffer commandBuffer, uint32_t, uint32_t, const VkRect2D*)
+{
+	util_record_command(commandBuffer);
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkCmdSetStencilReference(VkCommandBuffer commandBuffer, VkStencilFaceFlags, uint32_t)
+{
+	util_record_command(commandBuffer);
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkCmdDraw(VkCommandBuffer commandBuffer, uint32_t, uint32_t, uint32_t, uint32_t)
+{
+	++util_record_command(commandBuffer)->mDraws;
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkCmdDrawIndexed(VkCommandBuffer commandBuffer, uint32_t, uint32_t, uint32_t, int32_t, uint32_t)
+{
+	++util_record_command(commandBuffer)->mDraws;
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkCmdDrawIndirect(VkCommandBuffer commandBuffer, VkBuffer, VkDeviceSize, uint32_t, uint32_t)
+{
+	++util_record_command(commandBuffer)->mDraws;
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkCmdDrawIndexedIndirect(VkCommandBuffer commandBuffer, VkBuffer, VkDeviceSize, uint32_t, uint32_t)
+{
+	++util_record_command(commandBuffer)->mDraws;
+}
+
+static VKAPI_ATTR void VKAPI_CALL
+	null_vkCmdDrawIndirectCount(VkCommandBuffer commandBuffer, VkBuffer, VkDeviceSize, VkBuffer, VkDeviceSize, uint32_t, uint32_t)
+{
+	++util_record_command(commandBuffer)->mDraws;
+}
+
+static VKAPI_ATTR void VKAPI_CALL
+	null_vkCmdDrawIndexedIndirectCount(VkCommandBuffer commandBuffer, VkBuffer, VkDeviceSize, VkBuffer, VkDeviceSize, uint32_t, uint32_t)
+{
+	++util_record_command(commandBuffer)->mDraws;
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkCmdDispatch(VkCommandBuffer commandBuffer, uint32_t, uint32_t, uint32_t)
+{
+	++util_record_command(commandBuffer)->mDispatches;
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkCmdDispatchIndirect(VkCommandBuffer commandBuffer, VkBuffer, VkDeviceSize)
+{
+	++util_record_command(commandBuffer)->mDispatches;
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkCmdPipelineBarrier(
+	VkCommandBuffer commandBuffer, VkPipelineStageFlags, VkPipelineStageFlags, VkDependencyFlags, uint32_t, const VkMemoryBarrier*, uint32_t,
+	const VkBufferMemoryBarrier*, uint32_t, const VkImageMemoryBarrier*)
+{
+	++util_record_command(commandBuffer)->mBarriers;
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkCmdCopyBuffer(VkCommandBuffer commandBuffer, VkBuffer, VkBuffer, uint32_t, const VkBufferCopy*)
+{
+	++util_record_command(commandBuffer)->mCopies;
+}
+
+static VKAPI_ATTR void VKAPI_CALL
+	null_vkCmdCopyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer, VkImage, VkImageLayout, uint32_t, const VkBufferImageCopy*)
+{
+	++util_record_command(commandBuffer)->mCopies;
+}
+
+static VKAPI_ATTR void VKAPI_CALL
+	null_vkCmdCopyImageToBuffer(VkCommandBuffer commandBuffer, VkImage, VkImageLayout, VkBuffer, uint32_t, const VkBufferImageCopy*)
+{
+	++util_record_command(commandBuffer)->mCopies;
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkCmdResetQueryPool(VkCommandBuffer commandBuffer, VkQueryPool, uint32_t, uint32_t)
+{
+	util_record_command(commandBuffer);
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkCmdBeginQuery(VkCommandBuffer commandBuffer, VkQueryPool, uint32_t, VkQueryControlFlags)
+{
+	util_record_command(commandBuffer);
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkCmdEndQuery(VkCommandBuffer commandBuffer, VkQueryPool, uint32_t) { util_record_command(commandBuffer); }
+
+static VKAPI_ATTR void VKAPI_CALL null_vkCmdWriteTimestamp(VkCommandBuffer commandBuffer, VkPipelineStageFlagBits, VkQueryPool, uint32_t)
+{
+	util_record_command(commandBuffer);
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkCmdCopyQueryPoolResults(
+	VkCommandBuffer commandBuffer, VkQueryPool, uint32_t, uint32_t, VkBuffer, VkDeviceSize, VkDeviceSize, VkQueryResultFlags)
+{
+	++util_record_command(commandBuffer)->mCopies;
+}
+
+static VKAPI_ATTR void VKAPI_CALL
+	null_vkCmdExecuteCommands(VkCommandBuffer commandBuffer, uint32_t commandBufferCount, const VkCommandBuffer* pCommandBuffers)
+{
+	// Secondaries are only submitted through their primary, fold their work in here
+	NullCommandStats* pStats = util_record_command(commandBuffer);
+	for (uint32_t i = 0; i < commandBufferCount; ++i)
+	{
+		const NullCommandStats* pSecondary = &NULL_FROM_HANDLE(NullCommandBuffer, pCommandBuffers[i])->mStats;
+		pStats->mCommands += pSecondary->mCommands;
+		pStats->mDraws += pSecondary->mDraws;
+		pStats->mDispatches += pSecondary->mDispatches;
+		pStats->mBarriers += pSecondary->mBarriers;
+		pStats->mCopies += pSecondary->mCopies;
+		pStats->mRenderPasses += pSecondary->mRenderPasses;
+	}
+}
+
+/************************************************************************/
+// Debug markers
+/************************************************************************/
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkSetDebugUtilsObjectNameEXT(VkDevice, const VkDebugUtilsObjectNameInfoEXT*) { return VK_SUCCESS; }
+
+static VKAPI_ATTR void VKAPI_CALL null_vkCmdBeginDebugUtilsLabelEXT(VkCommandBuffer commandBuffer, const VkDebugUtilsLabelEXT*)
+{
+	util_record_command(commandBuffer);
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkCmdEndDebugUtilsLabelEXT(VkCommandBuffer commandBuffer) { util_record_command(commandBuffer); }
+
+static VKAPI_ATTR void VKAPI_CALL null_vkCmdInsertDebugUtilsLabelEXT(VkCommandBuffer commandBuffer, const VkDebugUtilsLabelEXT*)
+{
+	util_record_command(commandBuffer);
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL null_vkDebugMarkerSetObjectNameEXT(VkDevice, const VkDebugMarkerObjectNameInfoEXT*) { return VK_SUCCESS; }
+
+static VKAPI_ATTR void VKAPI_CALL null_vkCmdDebugMarkerBeginEXT(VkCommandBuffer commandBuffer, const VkDebugMarkerMarkerInfoEXT*)
+{
+	util_record_command(commandBuffer);
+}
+
+static VKAPI_ATTR void VKAPI_CALL null_vkCmdDebugMarkerEndEXT(VkCommandBuffer commandBuffer) { util_record_command(commandBuffer); }
+
+static VKAPI_ATTR void VKAPI_CALL null_vkCmdDebugMarkerInsertEXT(VkCommandBuffer commandBuffer, const VkDebugMarkerMarkerInfoEXT*)
+{
+	util_record_command(commandBuffer);
+}
+
+/************************************************************************/
+// Entry points
+/************************************************************************/
+typedef struct NullEntryPoint
+{
+	const char*        pName;
+	PFN_vkVoidFunction pFunction;
+} NullEntryPoint;
+
+#define NULL_ENTRY(name) { "vk" #name, (PFN_vkVoidFunction)null_vk##name }
+#define NULL_ENTRY_ALIAS(alias, name) { "vk" #alias, (PFN_vkVoidFunction)null_vk##name }
+
+static VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL null_vkGetDeviceProcAddr(VkDevice device, const char* pName);
+
+// Core and extension names resolve to the same function, the front end and VMA ask for either
+static const NullEntryPoint gNullEntryPoints[] = {
+	// Loader
+	NULL_ENTRY(EnumerateInstanceVersion),
+	NULL_ENTRY(EnumerateInstanceLayerProperties),
+	NULL_ENTRY(EnumerateInstanceExtensionProperties),
+	NULL_ENTRY(CreateInstance),
+	NULL_ENTRY(GetDeviceProcAddr),
+	// Instance
+	NULL_ENTRY(DestroyInstance),
+	NULL_ENTRY(EnumeratePhysicalDevices),
+	NULL_ENTRY(CreateDebugUtilsMessengerEXT),
+	NULL_ENTRY(DestroyDebugUtilsMessengerEXT),
+	NULL_ENTRY(CreateDebugReportCallbackEXT),
+	NULL_ENTRY(DestroyDebugReportCallbackEXT),
+	NULL_ENTRY_ALIAS(CreateWin32SurfaceKHR, CreateSurfaceKHR),
+	NULL_ENTRY_ALIAS(CreateXlibSurfaceKHR, CreateSurfaceKHR),
+	NULL_ENTRY_ALIAS(CreateXcbSurfaceKHR, CreateSurfaceKHR),
+	NULL_ENTRY_ALIAS(CreateAndroidSurfaceKHR, CreateSurfaceKHR),
+	NULL_ENTRY(DestroySurfaceKHR),
+	NULL_ENTRY(GetPhysicalDeviceWin32PresentationSupportKHR),
+	NULL_ENTRY(GetPhysicalDeviceSurfaceSupportKHR),
+	NULL_ENTRY(GetPhysicalDeviceSurfaceCapabilitiesKHR),
+	NULL_ENTRY(GetPhysicalDeviceSurfaceFormatsKHR),
+	NULL_ENTRY(GetPhysicalDeviceSurfacePresentModesKHR),
+	// Physical device
+	NULL_ENTRY(GetPhysicalDeviceFeatures),
+	NULL_ENTRY(GetPhysicalDeviceFeatures2),
+	NULL_ENTRY_ALIAS(GetPhysicalDeviceFeatures2KHR, GetPhysicalDeviceFeatures2),
+	NULL_ENTRY(GetPhysicalDeviceProperties),
+	NULL_ENTRY(GetPhysicalDeviceProperties2),
+	NULL_ENTRY_ALIAS(GetPhysicalDeviceProperties2KHR, GetPhysicalDeviceProperties2),
+	NULL_ENTRY(GetPhysicalDeviceMemoryProperties),
+	NULL_ENTRY(GetPhysicalDeviceMemoryProperties2),
+	NULL_ENTRY_ALIAS(GetPhysicalDeviceMemoryProperties2KHR, GetPhysicalDeviceMemoryProperties2),
+	NULL_ENTRY(GetPhysicalDeviceQueueFamilyProperties),
+	NULL_ENTRY(GetPhysicalDeviceFormatProperties),
+	NULL_ENTRY(GetPhysicalDeviceImageFormatProperties),
+	NULL_ENTRY(EnumerateDeviceLayerProperties),
+	NULL_ENTRY(EnumerateDeviceExtensionProperties),
+	NULL_ENTRY(CreateDevice),
+	// Device
+	NULL_ENTRY(DestroyDevice),
+	NULL_ENTRY(GetDeviceQueue),
+	NULL_ENTRY(DeviceWaitIdle),
+	NULL_ENTRY(QueueSubmit),
+	NULL_ENTRY(QueueWaitIdle),
+	NULL_ENTRY(QueueBindSparse),
+	NULL_ENTRY(QueuePresentKHR),
+	NULL_ENTRY(AllocateMemory),
+	NULL_ENTRY(FreeMemory),
+	NULL_ENTRY(MapMemory),
+	NULL_ENTRY(UnmapMemory),
+	NULL_ENTRY(FlushMappedMemoryRanges),
+	NULL_ENTRY(InvalidateMappedMemoryRanges),
+	NULL_ENTRY(BindBufferMemory),
+	NULL_ENTRY(BindImageMemory),
+	NULL_ENTRY(BindBufferMemory2),
+	NULL_ENTRY_ALIAS(BindBufferMemory2KHR, BindBufferMemory2),
+	NULL_ENTRY(BindImageMemory2),
+	NULL_ENTRY_ALIAS(BindImageMemory2KHR, BindImageMemory2),
+	NULL_ENTRY(CreateBuffer),
+	NULL_ENTRY(DestroyBuffer),
+	NULL_ENTRY(CreateImage),
+	NULL_ENTRY(DestroyImage),
+	NULL_ENTRY(GetBufferMemoryRequirements),
+	NULL_ENTRY(GetImageMemoryRequirements),
+	NULL_ENTRY(GetBufferMemoryRequirements2),
+	NULL_ENTRY_ALIAS(GetBufferMemoryRequirements2KHR, GetBufferMemoryRequirements2),
+	NULL_ENTRY(GetImageMemoryRequirements2),
+	NULL_ENTRY_ALIAS(GetImageMemoryRequirements2KHR, GetImageMemoryRequirements2),
+	NULL_ENTRY(GetImageSparseMemoryRequirements),
+	NULL_ENTRY(CreateBufferView),
+	NULL_ENTRY(DestroyBufferView),
+	NULL_ENTRY(CreateImageView),
+	NULL_ENTRY(DestroyImageView),
+	NULL_ENTRY(CreateSampler),
+	NULL_ENTRY(DestroySampler),
+	NULL_ENTRY(CreateSamplerYcbcrConversion),
+	NULL_ENTRY_ALIAS(CreateSamplerYcbcrConversionKHR, CreateSamplerYcbcrConversion),
+	NULL_ENTRY(DestroySamplerYcbcrConversion),
+	NULL_ENTRY_ALIAS(DestroySamplerYcbcrConversionKHR, DestroySamplerYcbcrConversion),
+	NULL_ENTRY(CreateShaderModule),
+	NULL_ENTRY(DestroyShaderModule),
+	NULL_ENTRY(CreatePipelineLayout),
+	NULL_ENTRY(DestroyPipelineLayout),
+	NULL_ENTRY(CreateDescriptorSetLayout),
+	NULL_ENTRY(DestroyDescriptorSetLayout),
+	NULL_ENTRY(CreateRenderPass),
+	NULL_ENTRY(DestroyRenderPass),
+	NULL_ENTRY(CreateFramebuffer),
+	NULL_ENTRY(DestroyFramebuffer),
+	NULL_ENTRY(CreateSemaphore),
+	NULL_ENTRY(DestroySemaphore),
+	NULL_ENTRY(CreateQueryPool),
+	NULL_ENTRY(DestroyQueryPool),
+	NULL_ENTRY(GetQueryPoolResults),
+	NULL_ENTRY(CreatePipelineCache),
+	NULL_ENTRY(DestroyPipelineCache),
+	NULL_ENTRY(GetPipelineCacheData),
+	NULL_ENTRY(CreateGraphicsPipelines),
+	NULL_ENTRY(CreateComputePipelines),
+	NULL_ENTRY(DestroyPipeline),
+	NULL_ENTRY(CreateFence),
+	NULL_ENTRY(DestroyFence),
+	NULL_ENTRY(ResetFences),
+	NULL_ENTRY(GetFenceStatus),
+	NULL_ENTRY(WaitForFences),
+	NULL_ENTRY(CreateSwapchainKHR),
+	NULL_ENTRY(DestroySwapchainKHR),
+	NULL_ENTRY(GetSwapchainImagesKHR),
+	NULL_ENTRY(AcquireNextImageKHR),
+	NULL_ENTRY(CreateDescriptorPool),
+	NULL_ENTRY(DestroyDescriptorPool),
+	NULL_ENTRY(ResetDescriptorPool),
+	NULL_ENTRY(AllocateDescriptorSets),
+	NULL_ENTRY(FreeDescriptorSets),
+	NULL_ENTRY(UpdateDescriptorSets),
+	NULL_ENTRY(CreateDescriptorUpdateTemplate),
+	NULL_ENTRY_ALIAS(CreateDescriptorUpdateTemplateKHR, CreateDescriptorUpdateTemplate),
+	NULL_ENTRY(DestroyDescriptorUpdateTemplate),
+	NULL_ENTRY_ALIAS(DestroyDescriptorUpdateTemplateKHR, DestroyDescriptorUpdateTemplate),
+	NULL_ENTRY(UpdateDescriptorSetWithTemplate),
+	NULL_ENTRY_ALIAS(UpdateDescriptorSetWithTemplateKHR, UpdateDescriptorSetWithTemplate),
+	NULL_ENTRY(CreateCommandPool),
+	NULL_ENTRY(DestroyCommandPool),
+	NULL_ENTRY(ResetCommandPool),
+	NULL_ENTRY(AllocateCommandBuffers),
+	NULL_ENTRY(FreeCommandBuffers),
+	NULL_ENTRY(BeginCommandBuffer),
+	NULL_ENTRY(EndCommandBuffer),
+	NULL_ENTRY(ResetCommandBuffer),
+	// Commands
+	NULL_ENTRY(CmdBeginRenderPass),
+	NULL_ENTRY(CmdEndRenderPass),
+	NULL_ENTRY(CmdBindPipeline),
+	NULL_ENTRY(CmdBindDescriptorSets),
+	NULL_ENTRY(CmdPushConstants),
+	NULL_ENTRY(CmdBindIndexBuffer),
+	NULL_ENTRY(CmdBindVertexBuffers),
+	NULL_ENTRY(CmdSetViewport),
+	NULL_ENTRY(CmdSetScissor),
+	NULL_ENTRY(CmdSetStencilReference),
+	NULL_ENTRY(CmdDraw),
+	NULL_ENTRY(CmdDrawIndexed),
+	NULL_ENTRY(CmdDrawIndirect),
+	NULL_ENTRY(CmdDrawIndexedIndirect),
+	NULL_ENTRY(CmdDrawIndirectCount),
+	NULL_ENTRY_ALIAS(CmdDrawIndirectCountKHR, CmdDrawIndirectCount),
+	NULL_ENTRY_ALIAS(CmdDrawIndirectCountAMD, CmdDrawIndirectCount),
+	NULL_ENTRY(CmdDrawIndexedIndirectCount),
+	NULL_ENTRY_ALIAS(CmdDrawIndexedIndirectCountKHR, CmdDrawIndexedIndirectCount),
+	NULL_ENTRY_ALIAS(CmdDrawIndexedIndirectCountAMD, CmdDrawIndexedIndirectCount),
+	NULL_ENTRY(CmdDispatch),
+	NULL_ENTRY(CmdDispatchIndirect),
+	NULL_ENTRY(CmdPipelineBarrier),
+	NULL_ENTRY(CmdCopyBuffer),
+	NULL_ENTRY(CmdCopyBufferToImage),
+	NULL_ENTRY(CmdCopyImageToBuffer),
+	NULL_ENTRY(CmdResetQueryPool),
+	NULL_ENTRY(CmdBeginQuery),
+	NULL_ENTRY(CmdEndQuery),
+	NULL_ENTRY(CmdWriteTimestamp),
+	NULL_ENTRY(CmdCopyQueryPoolResults),
+	NULL_ENTRY(CmdExecuteCommands),
+	// Debug markers
+	NULL_ENTRY(SetDebugUtilsObjectNameEXT),
+	NULL_ENTRY(CmdBeginDebugUtilsLabelEXT),
+	NULL_ENTRY(CmdEndDebugUtilsLabelEXT),
+	NULL_ENTRY(CmdInsertDebugUtilsLabelEXT),
+	NULL_ENTRY(DebugMarkerSetObjectNameEXT),
+	NULL_ENTRY(CmdDebugMarkerBeginEXT),
+	NULL_ENTRY(CmdDebugMarkerEndEXT),
+	NULL_ENTRY(CmdDebugMarkerInsertEXT),
+};
+
+static PFN_vkVoidFunction util_find_entry_point(const char* pName)
+{
+	for (uint32_t i = 0; i < sizeof(gNullEntryPoints) / sizeof(gNullEntryPoints[0]); ++i)
+	{
+		if (!strcmp(gNullEntryPoints[i].pName, pName))
+			return gNullEntryPoints[i].pFunction;
+	}
+
+	// Extensions the driver does not advertise stay NULL, the same as on a real driver
+	return NULL;
+}
+
+static VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL null_vkGetDeviceProcAddr(VkDevice, const char* pName) { return util_find_entry_point(pName); }
+
+VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL nullVkGetInstanceProcAddr(VkInstance, const char* pName)
+{
+	if (!strcmp(pName, "vkGetInstanceProcAddr"))
+		return (PFN_vkVoidFunction)nullVkGetInstanceProcAddr;
+
+	return util_find_entry_point(pName);
+}
+
+void nullDriverTakeStats(NullDriverStats* pStats)
+{
+	ASSERT(pStats);
+	pStats->mSubmits = util_take_stat(&gNullStats.mSubmits);
+	pStats->mCommandBuffers = util_take_stat(&gNullStats.mCommandBuffers);
+	pStats->mCommands = util_take_stat(&gNullStats.mCommands);
+	pStats->mDraws = util_take_stat(&gNullStats.mDraws);
+	pStats->mDispatches = util_take_stat(&gNullStats.mDispatches);
+	pStats->mBarriers = util_take_stat(&gNullStats.mBarriers);
+	pStats->mCopies = util_take_stat(&gNullStats.mCopies);
+	pStats->mRenderPasses = util_take_stat(&gNullStats.mRenderPasses);
+	pStats->mDescriptorWrites = util_take_stat(&gNullStats.mDescriptorWrites);
+}
+
+void nullDriverSetMemoryBudget(uint64_t budget) { tfrg_atomic64_store_relaxed(&gNullDeviceLocalBudget, budget); }
+
+#endif
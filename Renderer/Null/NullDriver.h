@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2017-2022 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "../Include/RendererConfig.h"
+
+#if defined(NULL_RENDERER)
+
+// Null Vulkan driver used by the Null build configuration.
+// Vulkan.cpp loads every entry point through nullVkGetInstanceProcAddr instead of the system loader,
+// so the whole renderer front end runs while no GPU work is recorded or executed.
+
+/// Work seen by the driver since the last present (or the last nullDriverTakeStats call)
+typedef struct NullDriverStats
+{
+	uint64_t mSubmits;
+	uint64_t mCommandBuffers;
+	uint64_t mCommands;
+	uint64_t mDraws;
+	uint64_t mDispatches;
+	/// vkCmdPipelineBarrier calls, not individual barriers
+	uint64_t mBarriers;
+	uint64_t mCopies;
+	uint64_t mRenderPasses;
+	uint64_t mDescriptorWrites;
+} NullDriverStats;
+
+VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL nullVkGetInstanceProcAddr(VkInstance instance, const char* pName);
+
+/// Returns the work submitted since the previous call or present and starts a new interval
+void nullDriverTakeStats(NullDriverStats* pStats);
+
+/// Budget VK_EXT_memory_budget reports for the device local heap, 0 reports the heap size again.
+/// Lets tests put the renderer under memory pressure
+void nullDriverSetMemoryBudget(uint64_t budget);
+
+#endif
@@ -0,0 +1,956 @@
+/*
+ * Copyright (c) 2017-2022 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "../Include/RendererConfig.h"
+
+#include "../../ThirdParty/OpenSource/EASTL/vector.h"
+
+#include "../../ThirdParty/OpenSource/tinyimageformat/tinyimageformat_base.h"
+#include "../../ThirdParty/OpenSource/tinyimageformat/tinyimageformat_query.h"
+
+#include "../Include/IRenderer.h"
+#include "../Include/IRenderGraph.h"
+#include "../../OS/Interfaces/ILog.h"
+#include "../../OS/Math/MathTypes.h"
+
+#include "../../OS/Interfaces/IMemory.h"
+
+#define RENDER_GRAPH_INVALID_INDEX 0xFFFFFFFF
+
+typedef enum RenderGraphAccessType
+{
+	RENDER_GRAPH_ACCESS_COLOR = 0,
+	RENDER_GRAPH_ACCESS_DEPTH,
+	RENDER_GRAPH_ACCESS_READ,
+	RENDER_GRAPH_ACCESS_WRITE,
+} RenderGraphAccessType;
+
+typedef struct RenderGraphAccess
+{
+	RenderGraphResource   mResource;
+	RenderGraphAccessType mType;
+	ResourceState         mState;
+	/// Requested load action, resolved against the contents of the resource by compileRenderGraph
+	LoadActionType        mLoadAction;
+	StoreActionType       mStoreAction;
+} RenderGraphAccess;
+
+struct RenderGraphPass
+{
+	RenderGraph*         pGraph;
+	const char*          pName;
+	RenderGraphExecuteFn pfnExecute;
+	void*                pUserData;
+	RenderGraphPassType  mType;
+	RenderGraphAccess    mAccesses[RENDER_GRAPH_MAX_PASS_ACCESSES];
+	uint32_t             mAccessCount;
+	uint32_t             mBarrierOffset;
+	uint32_t             mBarrierCount;
+	bool                 mSideEffects;
+	bool                 mLive;
+};
+
+typedef struct RenderGraphTexture
+{
+	const char*       pName;
+	RenderTargetDesc  mDesc;
+	RenderTarget*     pRenderTarget;
+	ResourceState     mInitialState;
+	ResourceState     mFinalState;
+	ResourceSizeAlign mSizeAlign;
+	/// Heap group the transient is placed in, RENDER_GRAPH_INVALID_INDEX if it owns its memory
+	uint32_t          mHeapIndex;
+	uint64_t          mOffset;
+	/// Position of the first / last live pass using the resource in the execution order
+	uint32_t          mFirstUse;
+	uint32_t          mLastUse;
+	bool              mImported;
+} RenderGraphTexture;
+
+typedef struct RenderGraphEdge
+{
+	uint32_t mFrom;
+	uint32_t mTo;
+	/// mTo reads what mFrom wrote (as opposed to a pure ordering constraint)
+	bool     mData;
+} RenderGraphEdge;
+
+typedef struct RenderGraphBarrier
+{
+	RenderGraphResource mResource;
+	/// Last user of the memory for aliasing barriers
+	RenderGraphResource mAliased;
+	ResourceState       mBeforeState;
+	ResourceState       mAfterState;
+	bool                mAliasing;
+} RenderGraphBarrier;
+
+typedef struct RenderGraphHeap
+{
+	uint64_t mSize;
+	uint64_t mAlignment;
+	uint32_t mMemoryTypeBits;
+} RenderGraphHeap;
+
+typedef struct RenderGraphSizeAlign
+{
+	uint32_t          mDescHash;
+	ResourceSizeAlign mSizeAlign;
+} RenderGraphSizeAlign;
+
+struct RenderGraph
+{
+	Renderer*                           pRenderer;
+	eastl::vector<RenderGraphPass*>     mPasses;
+	uint32_t                            mPassCount;
+	eastl::vector<RenderGraphTexture>   mTextures;
+	eastl::vector<RenderGraphEdge>      mEdges;
+	eastl::vector<uint32_t>             mOrder;
+	eastl::vector<RenderGraphBarrier>   mBarriers;
+	eastl::vector<RenderGraphHeap>      mHeapDescs;
+	uint32_t                            mFinalBarrierOffset;
+	uint32_t                            mFinalBarrierCount;
+	// Survive resetRenderGraph so an unchanged graph does not recreate its transients
+	eastl::vector<RenderTarget*>        mTransientTargets;
+	eastl::vector<ResourceHeap*>        mHeaps;
+	eastl::vector<RenderGraphSizeAlign> mSizeAligns;
+	uint32_t                            mLayoutHash;
+	RenderGraphStats                    mStats;
+	bool                                mDisableAliasing;
+	bool                                mCompiled;
+};
+
+static inline bool access_reads(const RenderGraphAccess* pAccess)
+{
+	// Unordered access writes are treated as read-modify-write
+	return pAccess->mType == RENDER_GRAPH_ACCESS_READ || pAccess->mType == RENDER_GRAPH_ACCESS_WRITE ||
+		   pAccess->mLoadAction == LOAD_ACTION_LOAD;
+}
+
+static inline bool access_writes(const RenderGraphAccess* pAccess) { return pAccess->mType != RENDER_GRAPH_ACCESS_READ; }
+
+static inline bool pass_uses(const RenderGraphPass* pPass, RenderGraphResource resource)
+{
+	for (uint32_t i = 0; i < pPass->mAccessCount; ++i)
+	{
+		if (pPass->mAccesses[i].mResource == resource)
+			return true;
+	}
+	return false;
+}
+
+static inline bool is_lazily_allocated(const RenderGraphTexture* pTexture)
+{
+	return (pTexture->mDesc.mFlags & TEXTURE_CREATION_FLAG_ON_TILE) != 0;
+}
+
+static uint32_t hash_render_target_desc(const RenderTargetDesc* pDesc)
+{
+	const uint32_t values[] = {
+		(uint32_t)pDesc->mFlags, pDesc->mWidth,          pDesc->mHeight,          pDesc->mDepth,
+		pDesc->mArraySize,       pDesc->mMipLevels,      (uint32_t)pDesc->mSampleCount, (uint32_t)pDesc->mFormat,
+		(uint32_t)pDesc->mStartState, pDesc->mSampleQuality, (uint32_t)pDesc->mDescriptors, pDesc->mNodeIndex,
+	};
+	size_t hash = tf_mem_hash<uint32_t>(values, sizeof(values) / sizeof(values[0]));
+	return (uint32_t)tf_mem_hash<uint32_t>((const uint32_t*)&pDesc->mClearValue, sizeof(ClearValue) / sizeof(uint32_t), hash);
+}
+
+static void get_size_align(RenderGraph* pGraph, const RenderTargetDesc* pDesc, ResourceSizeAlign* pSizeAlign)
+{
+	// Querying creates a temporary image, so cache the result per description
+	const uint32_t descHash = hash_render_target_desc(pDesc);
+	for (uint32_t i = 0; i < (uint32_t)pGraph->mSizeAligns.size(); ++i)
+	{
+		if (pGraph->mSizeAligns[i].mDescHash == descHash)
+		{
+			*pSizeAlign = pGraph->mSizeAligns[i].mSizeAlign;
+			return;
+		}
+	}
+
+	RenderGraphSizeAlign entry = {};
+	entry.mDescHash = descHash;
+	vk_getRenderTargetSizeAlign(pGraph->pRenderer, pDesc, &entry.mSizeAlign);
+	pGraph->mSizeAligns.push_back(entry);
+	*pSizeAlign = entry.mSizeAlign;
+}
+
+static void remove_transients(RenderGraph* pGraph)
+{
+	for (uint32_t i = 0; i < (uint32_t)pGraph->mTransientTargets.size(); ++i)
+		vk_removeRenderTarget(pGraph->pRenderer, pGraph->mTransientTargets[i]);
+	for (uint32_t i = 0; i < (uint32_t)pGraph->mHeaps.size(); ++i)
+		vk_removeResourceHeap(pGraph->pRenderer, pGraph->mHeaps[i]);
+	pGraph->mTransientTargets.set_capacity(0);
+	pGraph->mHeaps.set_capacity(0);
+	pGraph->mLayoutHash = 0;
+}
+
+void addRenderGraph(Renderer* pRenderer, const RenderGraphDesc* pDesc, RenderGraph** ppGraph)
+{
+	ASSERT(pRenderer);
+	ASSERT(ppGraph);
+
+	RenderGraph* pGraph = tf_new(RenderGraph);
+	ASSERT(pGraph);
+
+	pGraph->pRenderer = pRenderer;
+	pGraph->mPassCount = 0;
+	pGraph->mFinalBarrierOffset = 0;
+	pGraph->mFinalBarrierCount = 0;
+	pGraph->mLayoutHash = 0;
+	pGraph->mStats = {};
+	pGraph->mDisableAliasing = pDesc ? pDesc->mDisableAliasing : false;
+	pGraph->mCompiled = false;
+
+	*ppGraph = pGraph;
+}
+
+void removeRenderGraph(RenderGraph* pGraph)
+{
+	ASSERT(pGraph);
+
+	remove_transients(pGraph);
+	for (uint32_t i = 0; i < (uint32_t)pGraph->mPasses.size(); ++i)
+		tf_free(pGraph->mPasses[i]);
+
+	tf_delete(pGraph);
+}
+
+void resetRenderGraph(RenderGraph* pGraph)
+{
+	ASSERT(pGraph);
+
+	pGraph->mPassCount = 0;
+	pGraph->mTextures.clear();
+	pGraph->mEdges.clear();
+	pGraph->mOrder.clear();
+	pGraph->mBarriers.clear();
+	pGraph->mHeapDescs.clear();
+	pGraph->mFinalBarrierOffset = 0;
+	pGraph->mFinalBarrierCount = 0;
+	pGraph->mStats = {};
+	pGraph->mCompiled = false;
+}
+
+RenderGraphResource renderGraphAddRenderTarget(RenderGraph* pGraph, const char* pName, const RenderTargetDesc* pDesc)
+{
+	ASSERT(pGraph);
+	ASSERT(pDesc);
+	ASSERT(!pDesc->pPlacement && !pDesc->pNativeHandle);
+
+	RenderGraphTexture texture = {};
+	texture.pName = pName;
+	texture.mDesc = *pDesc;
+	texture.mDesc.pName = pName;
+	texture.mInitialState = RESOURCE_STATE_UNDEFINED;
+	texture.mFinalState = RESOURCE_STATE_UNDEFINED;
+	texture.mHeapIndex = RENDER_GRAPH_INVALID_INDEX;
+	texture.mFirstUse = RENDER_GRAPH_INVALID_INDEX;
+	texture.mLastUse = RENDER_GRAPH_INVALID_INDEX;
+	pGraph->mTextures.push_back(texture);
+	pGraph->mCompiled = false;
+	return (RenderGraphResource)pGraph->mTextures.size() - 1;
+}
+
+RenderGraphResource renderGraphImportRenderTarget(
+	RenderGraph* pGraph, const char* pName, RenderTarget* pRenderTarget, ResourceState currentState, ResourceState finalState)
+{
+	ASSERT(pGraph);
+	ASSERT(pRenderTarget);
+
+	RenderGraphTexture texture = {};
+	texture.pName = pName;
+	texture.pRenderTarget = pRenderTarget;
+	texture.mInitialState = currentState;
+	texture.mFinalState = finalState;
+	texture.mHeapIndex = RENDER_GRAPH_INVALID_INDEX;
+	texture.mFirstUse = RENDER_GRAPH_INVALID_INDEX;
+	texture.mLastUse = RENDER_GRAPH_INVALID_INDEX;
+	texture.mImported = true;
+	pGraph->mTextures.push_back(texture);
+	pGraph->mCompiled = false;
+	return (RenderGraphResource)pGraph->mTextures.size() - 1;
+}
+
+void renderGraphSetImportedRenderTarget(RenderGraph* pGraph, RenderGraphResource resource, RenderTarget* pRenderTarget)
+{
+	ASSERT(pGraph);
+	ASSERT(resource < (uint32_t)pGraph->mTextures.size());
+	ASSERT(pGraph->mTextures[resource].mImported);
+	ASSERT(pRenderTarget);
+
+	pGraph->mTextures[resource].pRenderTarget = pRenderTarget;
+}
+
+RenderGraphPass* renderGraphAddPass(
+	RenderGraph* pGraph, const char* pName, RenderGraphPassType type, RenderGraphExecuteFn pfnExecute, void* pUserData)
+{
+	ASSERT(pGraph);
+	ASSERT(pfnExecute);
+
+	// Pass objects are pooled across resetRenderGraph
+	if (pGraph->mPassCount == (uint32_t)pGraph->mPasses.size())
+		pGraph->mPasses.push_back((RenderGraphPass*)tf_calloc(1, sizeof(RenderGraphPass)));
+
+	RenderGraphPass* pPass = pGraph->mPasses[pGraph->mPassCount++];
+	memset(pPass, 0, sizeof(RenderGraphPass));
+	pPass->pGraph = pGraph;
+	pPass->pName = pName;
+	pPass->pfnExecute = pfnExecute;
+	pPass->pUserData = pUserData;
+	pPass->mType = type;
+	pGraph->mCompiled = false;
+	return pPass;
+}
+
+static void add_pass_access(
+	RenderGraphPass* pPass, RenderGraphResource resource, RenderGraphAccessType type, ResourceState state, LoadActionType loadAction)
+{
+	ASSERT(pPass);
+	ASSERT(resource < (uint32_t)pPass->pGraph->mTextures.size());
+	ASSERT(pPass->mAccessCount < RENDER_GRAPH_MAX_PASS_ACCESSES);
+
+	RenderGraphAccess* pAccess = &pPass->mAccesses[pPass->mAccessCount++];
+	pAccess->mResource = resource;
+	pAccess->mType = type;
+	pAccess->mState = state;
+	pAccess->mLoadAction = loadAction;
+	pAccess->mStoreAction = STORE_ACTION_STORE;
+	pPass->pGraph->mCompiled = false;
+}
+
+void renderGraphPassWriteColor(RenderGraphPass* pPass, RenderGraphResource resource, LoadActionType loadAction)
+{
+	ASSERT(pPass->mType == RENDER_GRAPH_PASS_GRAPHICS);
+	uint32_t colorCount = 0;
+	for (uint32_t i = 0; i < pPass->mAccessCount; ++i)
+		colorCount += pPass->mAccesses[i].mType == RENDER_GRAPH_ACCESS_COLOR;
+	ASSERT(colorCount < MAX_RENDER_TARGET_ATTACHMENTS);
+	UNREF_PARAM(colorCount);
+	add_pass_access(pPass, resource, RENDER_GRAPH_ACCESS_COLOR, RESOURCE_STATE_RENDER_TARGET, loadAction);
+}
+
+void renderGraphPassWriteDepth(RenderGraphPass* pPass, RenderGraphResource resource, LoadActionType loadAction)
+{
+	ASSERT(pPass->mType == RENDER_GRAPH_PASS_GRAPHICS);
+	add_pass_access(pPass, resource, RENDER_GRAPH_ACCESS_DEPTH, RESOURCE_STATE_DEPTH_WRITE, loadAction);
+}
+
+void renderGraphPassRead(RenderGraphPass* pPass, RenderGraphResource resource, ResourceState state)
+{
+	add_pass_access(pPass, resource, RENDER_GRAPH_ACCESS_READ, state, LOAD_ACTION_LOAD);
+}
+
+void renderGraphPassWrite(RenderGraphPass* pPass, RenderGraphResource resource, ResourceState state)
+{
+	add_pass_access(pPass, resource, RENDER_GRAPH_ACCESS_WRITE, state, LOAD_ACTION_LOAD);
+}
+
+void renderGraphPassSetSideEffects(RenderGraphPass* pPass)
+{
+	ASSERT(pPass);
+	pPass->mSideEffects = true;
+}
+
+/************************************************************************/
+// Compilation
+/************************************************************************/
+static bool build_dependencies(RenderGraph* pGraph)
+{
+	eastl::vector<uint32_t> lastWriters(pGraph->mTextures.size(), RENDER_GRAPH_INVALID_INDEX);
+
+	for (uint32_t p = 0; p < pGraph->mPassCount; ++p)
+	{
+		RenderGraphPass* pPass = pGraph->mPasses[p];
+		for (uint32_t a = 0; a < pPass->mAccessCount; ++a)
+		{
+			const RenderGraphAccess* pAccess = &pPass->mAccesses[a];
+			const RenderGraphResource resource = pAccess->mResource;
+			const uint32_t            lastWriter = lastWriters[resource];
+
+			if (access_reads(pAccess))
+			{
+				if (lastWriter != RENDER_GRAPH_INVALID_INDEX)
+				{
+					pGraph->mEdges.push_back({ lastWriter, p, true });
+				}
+				else if (pAccess->mType == RENDER_GRAPH_ACCESS_READ && !pGraph->mTextures[resource].mImported)
+				{
+					LOGF(
+						LogLevel::eERROR, "Render graph pass '%s' reads transient '%s' which is never written before", pPass->pName,
+						pGraph->mTextures[resource].pName);
+					return false;
+				}
+			}
+
+			if (access_writes(pAccess))
+			{
+				// Write after write and write after read only constrain the order
+				if (lastWriter != RENDER_GRAPH_INVALID_INDEX)
+					pGraph->mEdges.push_back({ lastWriter, p, false });
+				for (uint32_t q = (lastWriter == RENDER_GRAPH_INVALID_INDEX ? 0 : lastWriter + 1); q < p; ++q)
+				{
+					if (pass_uses(pGraph->mPasses[q], resource))
+						pGraph->mEdges.push_back({ q, p, false });
+				}
+			}
+		}
+
+		for (uint32_t a = 0; a < pPass->mAccessCount; ++a)
+		{
+			if (access_writes(&pPass->mAccesses[a]))
+				lastWriters[pPass->mAccesses[a].mResource] = p;
+		}
+	}
+
+	return true;
+}
+
+static void cull_passes(RenderGraph* pGraph)
+{
+	for (uint32_t p = 0; p < pGraph->mPassCount; ++p)
+	{
+		RenderGraphPass* pPass = pGraph->mPasses[p];
+		pPass->mLive = pPass->mSideEffects;
+		for (uint32_t a = 0; a < pPass->mAccessCount && !pPass->mLive; ++a)
+			pPass->mLive = access_writes(&pPass->mAccesses[a]) && pGraph->mTextures[pPass->mAccesses[a].mResource].mImported;
+	}
+
+	// Edges always point to a later pass, so one backwards sweep reaches every producer of a live pass
+	for (uint32_t p = pGraph->mPassCount; p-- > 0;)
+	{
+		if (!pGraph->mPasses[p]->mLive)
+			continue;
+		for (uint32_t e = 0; e < (uint32_t)pGraph->mEdges.size(); ++e)
+		{
+			const RenderGraphEdge* pEdge = &pGraph->mEdges[e];
+			if (pEdge->mTo == p && pEdge->mData)
+				pGraph->mPasses[pEdge->mFrom]->mLive = true;
+		}
+	}
+}
+
+static void order_passes(RenderGraph* pGraph)
+{
+	eastl::vector<uint32_t> dependencyCounts(pGraph->mPassCount, 0);
+	for (uint32_t e = 0; e < (uint32_t)pGraph->mEdges.size(); ++e)
+	{
+		const RenderGraphEdge* pEdge = &pGraph->mEdges[e];
+		if (pGraph->mPasses[pEdge->mFrom]->mLive && pGraph->mPasses[pEdge->mTo]->mLive)
+			++dependencyCounts[pEdge->mTo];
+	}
+
+	eastl::vector<bool> scheduled(pGraph->mPassCount, false);
+	uint32_t            liveCount = 0;
+	for (uint32_t p = 0; p < pGraph->mPassCount; ++p)
+		liveCount += pGraph->mPasses[p]->mLive;
+
+	uint32_t previous = RENDER_GRAPH_INVALID_INDEX;
+	while ((uint32_t)pGraph->mOrder.size() < liveCount)
+	{
+		// Among the ready passes prefer declaration order, but avoid one that consumes the pass scheduled just before it
+		// so the GPU can overlap the two
+		uint32_t next = RENDER_GRAPH_INVALID_INDEX;
+		uint32_t fallback = RENDER_GRAPH_INVALID_INDEX;
+		for (uint32_t p = 0; p < pGraph->mPassCount && next == RENDER_GRAPH_INVALID_INDEX; ++p)
+		{
+			if (!pGraph->mPasses[p]->mLive || scheduled[p] || dependencyCounts[p])
+				continue;
+
+			bool consumesPrevious = false;
+			for (uint32_t e = 0; e < (uint32_t)pGraph->mEdges.size() && previous != RENDER_GRAPH_INVALID_INDEX; ++e)
+				consumesPrevious |= pGraph->mEdges[e].mFrom == previous && pGraph->mEdges[e].mTo == p;
+
+			if (!consumesPrevious)
+				next = p;
+			else if (fallback == RENDER_GRAPH_INVALID_INDEX)
+				fallback = p;
+		}
+		if (next == RENDER_GRAPH_INVALID_INDEX)
+			next = fallback;
+		ASSERT(next != RENDER_GRAPH_INVALID_INDEX);
+
+		scheduled[next] = true;
+		pGraph->mOrder.push_back(next);
+		for (uint32_t e = 0; e < (uint32_t)pGraph->mEdges.size(); ++e)
+		{
+			if (pGraph->mEdges[e].mFrom == next && pGraph->mPasses[pGraph->mEdges[e].mTo]->mLive)
+				--dependencyCounts[pGraph->mEdges[e].mTo];
+		}
+		previous = next;
+	}
+}
+
+static void compute_lifetimes(RenderGraph* pGraph)
+{
+	for (uint32_t k = 0; k < (uint32_t)pGraph->mOrder.size(); ++k)
+	{
+		const RenderGraphPass* pPass = pGraph->mPasses[pGraph->mOrder[k]];
+		for (uint32_t a = 0; a < pPass->mAccessCount; ++a)
+		{
+			RenderGraphTexture* pTexture = &pGraph->mTextures[pPass->mAccesses[a].mResource];
+			if (pTexture->mFirstUse == RENDER_GRAPH_INVALID_INDEX)
+				pTexture->mFirstUse = k;
+			pTexture->mLastUse = k;
+		}
+	}
+}
+
+static inline bool lifetimes_overlap(const RenderGraphTexture* pA, const RenderGraphTexture* pB)
+{
+	return pA->mFirstUse <= pB->mLastUse && pB->mFirstUse <= pA->mLastUse;
+}
+
+static inline bool memory_overlaps(const RenderGraphTexture* pA, const RenderGraphTexture* pB)
+{
+	return pA->mHeapIndex == pB->mHeapIndex && pA->mOffset < pB->mOffset + pB->mSizeAlign.mSize &&
+		   pB->mOffset < pA->mOffset + pA->mSizeAlign.mSize;
+}
+
+static void place_transients(RenderGraph* pGraph)
+{
+	eastl::vector<uint32_t> placeables;
+	for (uint32_t t = 0; t < (uint32_t)pGraph->mTextures.size(); ++t)
+	{
+		RenderGraphTexture* pTexture = &pGraph->mTextures[t];
+		if (pTexture->mImported || pTexture->mFirstUse == RENDER_GRAPH_INVALID_INDEX)
+			continue;
+
+		++pGraph->mStats.mTransientCount;
+		if (is_lazily_allocated(pTexture))
+			continue;
+
+		get_size_align(pGraph, &pTexture->mDesc, &pTexture->mSizeAlign);
+		pGraph->mStats.mTransientMemoryUnaliased += pTexture->mSizeAlign.mSize;
+		if (pGraph->mDisableAliasing)
+			pGraph->mStats.mTransientMemory += pTexture->mSizeAlign.mSize;
+		else
+			placeables.push_back(t);
+	}
+
+	// Biggest first so small targets fill the gaps left between them
+	for (uint32_t i = 1; i < (uint32_t)placeables.size(); ++i)
+	{
+		const uint32_t t = placeables[i];
+		uint32_t       j = i;
+		for (; j > 0 && pGraph->mTextures[placeables[j - 1]].mSizeAlign.mSize < pGraph->mTextures[t].mSizeAlign.mSize; --j)
+			placeables[j] = placeables[j - 1];
+		placeables[j] = t;
+	}
+
+	for (uint32_t i = 0; i < (uint32_t)placeables.size(); ++i)
+	{
+		RenderGraphTexture* pTexture = &pGraph->mTextures[placeables[i]];
+
+		uint32_t heapIndex = 0;
+		for (; heapIndex < (uint32_t)pGraph->mHeapDescs.size(); ++heapIndex)
+		{
+			if (pGraph->mHeapDescs[heapIndex].mMemoryTypeBits == pTexture->mSizeAlign.mMemoryTypeBits)
+				break;
+		}
+		if (heapIndex == (uint32_t)pGraph->mHeapDescs.size())
+			pGraph->mHeapDescs.push_back({ 0, 1, pTexture->mSizeAlign.mMemoryTypeBits });
+
+		// First fit: move past every already placed target that is alive at the same time and overlaps the candidate range
+		pTexture->mHeapIndex = heapIndex;
+		pTexture->mOffset = 0;
+		for (bool moved = true; moved;)
+		{
+			moved = false;
+			for (uint32_t j = 0; j < i; ++j)
+			{
+				const RenderGraphTexture* pPlaced = &pGraph->mTextures[placeables[j]];
+				if (lifetimes_overlap(pTexture, pPlaced) && memory_overlaps(pTexture, pPlaced))
+				{
+					pTexture->mOffset = round_up_64(pPlaced->mOffset + pPlaced->mSizeAlign.mSize, pTexture->mSizeAlign.mAlignment);
+					moved = true;
+				}
+			}
+		}
+
+		RenderGraphHeap* pHeap = &pGraph->mHeapDescs[heapIndex];
+		pHeap->mSize = max(pHeap->mSize, pTexture->mOffset + pTexture->mSizeAlign.mSize);
+		pHeap->mAlignment = max(pHeap->mAlignment, pTexture->mSizeAlign.mAlignment);
+	}
+
+	for (uint32_t h = 0; h < (uint32_t)pGraph->mHeapDescs.size(); ++h)
+		pGraph->mStats.mTransientMemory += pGraph->mHeapDescs[h].mSize;
+	pGraph->mStats.mHeapCount = (uint32_t)pGraph->mHeapDescs.size();
+}
+
+static void create_transients(RenderGraph* pGraph)
+{
+	uint32_t layoutHash = (uint32_t)tf_mem_hash<uint32_t>(&pGraph->mStats.mTransientCount, 1);
+	for (uint32_t h = 0; h < (uint32_t)pGraph->mHeapDescs.size(); ++h)
+	{
+		const RenderGraphHeap* pHeap = &pGraph->mHeapDescs[h];
+		const uint32_t         values[] = { (uint32_t)pHeap->mSize, (uint32_t)(pHeap->mSize >> 32), (uint32_t)pHeap->mAlignment,
+										pHeap->mMemoryTypeBits };
+		layoutHash = (uint32_t)tf_mem_hash<uint32_t>(values, 4, layoutHash);
+	}
+	for (uint32_t t = 0; t < (uint32_t)pGraph->mTextures.size(); ++t)
+	{
+		const RenderGraphTexture* pTexture = &pGraph->mTextures[t];
+		if (pTexture->mImported || pTexture->mFirstUse == RENDER_GRAPH_INVALID_INDEX)
+			continue;
+		const uint32_t values[] = { hash_render_target_desc(&pTexture->mDesc), pTexture->mHeapIndex, (uint32_t)pTexture->mOffset,
+									(uint32_t)(pTexture->mOffset >> 32) };
+		layoutHash = (uint32_t)tf_mem_hash<uint32_t>(values, 4, layoutHash);
+	}
+
+	const bool reuse = layoutHash == pGraph->mLayoutHash && pGraph->mTransientTargets.size() == pGraph->mStats.mTransientCount;
+	if (!reuse)
+	{
+		// Caller guarantees the GPU is done with the previous frames, same as for any other vk_removeRenderTarget
+		remove_transients(pGraph);
+		for (uint32_t h = 0; h < (uint32_t)pGraph->mHeapDescs.size(); ++h)
+		{
+			ResourceHeapDesc heapDesc = {};
+			heapDesc.mSize = pGraph->mHeapDescs[h].mSize;
+			heapDesc.mAlignment = pGraph->mHeapDescs[h].mAlignment;
+			heapDesc.mMemoryTypeBits = pGraph->mHeapDescs[h].mMemoryTypeBits;
+			ResourceHeap* pHeap = NULL;
+			vk_addResourceHeap(pGraph->pRenderer, &heapDesc, &pHeap);
+			pGraph->mHeaps.push_back(pHeap);
+		}
+		pGraph->mLayoutHash = layoutHash;
+	}
+
+	uint32_t transientIndex = 0;
+	for (uint32_t t = 0; t < (uint32_t)pGraph->mTextures.size(); ++t)
+	{
+		RenderGraphTexture* pTexture = &pGraph->mTextures[t];
+		if (pTexture->mImported || pTexture->mFirstUse == RENDER_GRAPH_INVALID_INDEX)
+			continue;
+
+		if (reuse)
+		{
+			pTexture->pRenderTarget = pGraph->mTransientTargets[transientIndex++];
+			continue;
+		}
+
+		ResourcePlacement placement = {};
+		RenderTargetDesc  desc = pTexture->mDesc;
+		if (pTexture->mHeapIndex != RENDER_GRAPH_INVALID_INDEX)
+		{
+			placement.pHeap = pGraph->mHeaps[pTexture->mHeapIndex];
+			placement.mOffset = pTexture->mOffset;
+			desc.pPlacement = &placement;
+		}
+		vk_addRenderTarget(pGraph->pRenderer, &desc, &pTexture->pRenderTarget);
+		pGraph->mTransientTargets.push_back(pTexture->pRenderTarget);
+	}
+}
+
+static void build_barriers(RenderGraph* pGraph)
+{
+	eastl::vector<ResourceState> states(pGraph->mTextures.size(), RESOURCE_STATE_UNDEFINED);
+	for (uint32_t t = 0; t < (uint32_t)pGraph->mTextures.size(); ++t)
+		states[t] = pGraph->mTextures[t].mInitialState;
+
+	// State every resource is left in at the end of the frame
+	eastl::vector<ResourceState> endStates(states);
+	for (uint32_t k = 0; k < (uint32_t)pGraph->mOrder.size(); ++k)
+	{
+		const RenderGraphPass* pPass = pGraph->mPasses[pGraph->mOrder[k]];
+		for (uint32_t a = 0; a < pPass->mAccessCount; ++a)
+			endStates[pPass->mAccesses[a].mResource] = pPass->mAccesses[a].mState;
+	}
+
+	for (uint32_t k = 0; k < (uint32_t)pGraph->mOrder.size(); ++k)
+	{
+		RenderGraphPass* pPass = pGraph->mPasses[pGraph->mOrder[k]];
+		pPass->mBarrierOffset = (uint32_t)pGraph->mBarriers.size();
+
+		for (uint32_t a = 0; a < pPass->mAccessCount; ++a)
+		{
+			const RenderGraphAccess*  pAccess = &pPass->mAccesses[a];
+			const RenderGraphResource resource = pAccess->mResource;
+			const RenderGraphTexture* pTexture = &pGraph->mTextures[resource];
+
+			RenderGraphBarrier barrier = {};
+			barrier.mResource = resource;
+			barrier.mAliased = RENDER_GRAPH_INVALID_RESOURCE;
+			barrier.mBeforeState = states[resource];
+			barrier.mAfterState = pAccess->mState;
+
+			if (!pTexture->mImported && pTexture->mFirstUse == k && states[resource] == RESOURCE_STATE_UNDEFINED)
+			{
+				// First use of a transient: its memory is handed over from every target that used it before
+				barrier.mAliasing = true;
+				barrier.mBeforeState = RESOURCE_STATE_UNDEFINED;
+				for (uint32_t t = 0; t < (uint32_t)pGraph->mTextures.size() && pTexture->mHeapIndex != RENDER_GRAPH_INVALID_INDEX; ++t)
+				{
+					const RenderGraphTexture* pPrevious = &pGraph->mTextures[t];
+					if (t == resource || pPrevious->mHeapIndex == RENDER_GRAPH_INVALID_INDEX || pPrevious->mLastUse >= k ||
+						!memory_overlaps(pTexture, pPrevious))
+						continue;
+
+					barrier.mBeforeState |= states[t];
+					if (barrier.mAliased == RENDER_GRAPH_INVALID_RESOURCE || pGraph->mTextures[barrier.mAliased].mLastUse < pPrevious->mLastUse)
+						barrier.mAliased = t;
+				}
+
+				// Nobody used the range earlier in the frame: wrap around, the targets using it later held it in the previous frame
+				const bool wrapAround = barrier.mAliased == RENDER_GRAPH_INVALID_RESOURCE;
+				for (uint32_t t = 0; t < (uint32_t)pGraph->mTextures.size() && wrapAround && pTexture->mHeapIndex != RENDER_GRAPH_INVALID_INDEX; ++t)
+				{
+					const RenderGraphTexture* pNext = &pGraph->mTextures[t];
+					if (t == resource || pNext->mHeapIndex == RENDER_GRAPH_INVALID_INDEX || pNext->mFirstUse <= pTexture->mLastUse ||
+						!memory_overlaps(pTexture, pNext))
+						continue;
+
+					barrier.mBeforeState |= endStates[t];
+					if (barrier.mAliased == RENDER_GRAPH_INVALID_RESOURCE || pGraph->mTextures[barrier.mAliased].mLastUse < pNext->mLastUse)
+						barrier.mAliased = t;
+				}
+			}
+			else if (states[resource] == pAccess->mState && pAccess->mState != RESOURCE_STATE_UNORDERED_ACCESS)
+			{
+				continue;
+			}
+
+			pGraph->mBarriers.push_back(barrier);
+			pGraph->mStats.mAliasingBarrierCount += barrier.mAliased != RENDER_GRAPH_INVALID_RESOURCE;
+			states[resource] = pAccess->mState;
+		}
+
+		pPass->mBarrierCount = (uint32_t)pGraph->mBarriers.size() - pPass->mBarrierOffset;
+	}
+
+	pGraph->mFinalBarrierOffset = (uint32_t)pGraph->mBarriers.size();
+	for (uint32_t t = 0; t < (uint32_t)pGraph->mTextures.size(); ++t)
+	{
+		const RenderGraphTexture* pTexture = &pGraph->mTextures[t];
+		if (!pTexture->mImported || states[t] == pTexture->mFinalState)
+			continue;
+
+		RenderGraphBarrier barrier = {};
+		barrier.mResource = t;
+		barrier.mAliased = RENDER_GRAPH_INVALID_RESOURCE;
+		barrier.mBeforeState = states[t];
+		barrier.mAfterState = pTexture->mFinalState;
+		pGraph->mBarriers.push_back(barrier);
+	}
+	pGraph->mFinalBarrierCount = (uint32_t)pGraph->mBarriers.size() - pGraph->mFinalBarrierOffset;
+	pGraph->mStats.mBarrierCount = (uint32_t)pGraph->mBarriers.size();
+}
+
+static void resolve_load_store_actions(RenderGraph* pGraph)
+{
+	// Forward: loading contents nobody wrote is a waste of bandwidth
+	eastl::vector<bool> defined(pGraph->mTextures.size(), false);
+	for (uint32_t t = 0; t < (uint32_t)pGraph->mTextures.size(); ++t)
+		defined[t] = pGraph->mTextures[t].mImported && pGraph->mTextures[t].mInitialState != RESOURCE_STATE_UNDEFINED;
+
+	for (uint32_t k = 0; k < (uint32_t)pGraph->mOrder.size(); ++k)
+	{
+		RenderGraphPass* pPass = pGraph->mPasses[pGraph->mOrder[k]];
+		for (uint32_t a = 0; a < pPass->mAccessCount; ++a)
+		{
+			RenderGraphAccess* pAccess = &pPass->mAccesses[a];
+			if (pAccess->mLoadAction == LOAD_ACTION_LOAD && !defined[pAccess->mResource] &&
+				(pAccess->mType == RENDER_GRAPH_ACCESS_COLOR || pAccess->mType == RENDER_GRAPH_ACCESS_DEPTH))
+				pAccess->mLoadAction = LOAD_ACTION_DONTCARE;
+		}
+		for (uint32_t a = 0; a < pPass->mAccessCount; ++a)
+		{
+			if (access_writes(&pPass->mAccesses[a]))
+				defined[pPass->mAccesses[a].mResource] = true;
+		}
+	}
+
+	// Backward: storing contents no later pass reads is a waste of bandwidth, imported targets are always stored
+	eastl::vector<bool> needed(pGraph->mTextures.size(), false);
+	for (uint32_t t = 0; t < (uint32_t)pGraph->mTextures.size(); ++t)
+		needed[t] = pGraph->mTextures[t].mImported;
+
+	for (uint32_t k = (uint32_t)pGraph->mOrder.size(); k-- > 0;)
+	{
+		RenderGraphPass* pPass = pGraph->mPasses[pGraph->mOrder[k]];
+		for (uint32_t a = 0; a < pPass->mAccessCount; ++a)
+		{
+			RenderGraphAccess* pAccess = &pPass->mAccesses[a];
+			if (pAccess->mType == RENDER_GRAPH_ACCESS_COLOR || pAccess->mType == RENDER_GRAPH_ACCESS_DEPTH)
+				pAccess->mStoreAction = needed[pAccess->mResource] ? STORE_ACTION_STORE : STORE_ACTION_DONTCARE;
+		}
+		for (uint32_t a = 0; a < pPass->mAccessCount; ++a)
+		{
+			const RenderGraphAccess* pAccess = &pPass->mAccesses[a];
+			needed[pAccess->mResource] = access_reads(pAccess);
+		}
+	}
+}
+
+bool compileRenderGraph(RenderGraph* pGraph)
+{
+	ASSERT(pGraph);
+
+	pGraph->mEdges.clear();
+	pGraph->mOrder.clear();
+	pGraph->mBarriers.clear();
+	pGraph->mHeapDescs.clear();
+	pGraph->mStats = {};
+	pGraph->mCompiled = false;
+	for (uint32_t t = 0; t < (uint32_t)pGraph->mTextures.size(); ++t)
+	{
+		RenderGraphTexture* pTexture = &pGraph->mTextures[t];
+		pTexture->mHeapIndex = RENDER_GRAPH_INVALID_INDEX;
+		pTexture->mOffset = 0;
+		pTexture->mFirstUse = RENDER_GRAPH_INVALID_INDEX;
+		pTexture->mLastUse = RENDER_GRAPH_INVALID_INDEX;
+		if (!pTexture->mImported)
+			pTexture->pRenderTarget = NULL;
+	}
+
+	if (!build_dependencies(pGraph))
+		return false;
+
+	cull_passes(pGraph);
+	order_passes(pGraph);
+	compute_lifetimes(pGraph);
+	place_transients(pGraph);
+	create_transients(pGraph);
+	build_barriers(pGraph);
+	resolve_load_store_actions(pGraph);
+
+	pGraph->mStats.mPassCount = pGraph->mPassCount;
+	pGraph->mStats.mCulledPassCount = pGraph->mPassCount - (uint32_t)pGraph->mOrder.size();
+	pGraph->mCompiled = true;
+	return true;
+}
+
+/************************************************************************/
+// Execution
+/************************************************************************/
+static void cmd_render_graph_barriers(RenderGraph* pGraph, Cmd* pCmd, uint32_t offset, uint32_t count)
+{
+	// Barriers are queued one by one, vk_cmdResourceBarrier batches them until the next draw / dispatch
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const RenderGraphBarrier* pBarrier = &pGraph->mBarriers[offset + i];
+		RenderTarget*             pRenderTarget = pGraph->mTextures[pBarrier->mResource].pRenderTarget;
+
+		if (pBarrier->mAliasing)
+		{
+			AliasingBarrier barrier = {};
+			barrier.pBefore =
+				pBarrier->mAliased == RENDER_GRAPH_INVALID_RESOURCE ? NULL : pGraph->mTextures[pBarrier->mAliased].pRenderTarget;
+			barrier.pAfter = pRenderTarget;
+			barrier.mBeforeState = pBarrier->mBeforeState;
+			barrier.mAfterState = pBarrier->mAfterState;
+			vk_cmdAliasingBarrier(pCmd, 1, &barrier);
+		}
+		else
+		{
+			RenderTargetBarrier barrier = {};
+			barrier.pRenderTarget = pRenderTarget;
+			barrier.mCurrentState = pBarrier->mBeforeState;
+			barrier.mNewState = pBarrier->mAfterState;
+			vk_cmdResourceBarrier(pCmd, 0, NULL, 0, NULL, 1, &barrier);
+		}
+	}
+}
+
+void executeRenderGraph(RenderGraph* pGraph, Cmd* pCmd)
+{
+	ASSERT(pGraph);
+	ASSERT(pCmd);
+	ASSERT(pGraph->mCompiled);
+
+	for (uint32_t k = 0; k < (uint32_t)pGraph->mOrder.size(); ++k)
+	{
+		RenderGraphPass* pPass = pGraph->mPasses[pGraph->mOrder[k]];
+		cmd_render_graph_barriers(pGraph, pCmd, pPass->mBarrierOffset, pPass->mBarrierCount);
+		vk_cmdBeginDebugMarker(pCmd, 1.0f, 1.0f, 0.0f, pPass->pName);
+
+		if (pPass->mType == RENDER_GRAPH_PASS_GRAPHICS)
+		{
+			RenderTarget*   pColors[MAX_RENDER_TARGET_ATTACHMENTS] = {};
+			RenderTarget*   pDepth = NULL;
+			uint32_t        colorCount = 0;
+			LoadActionsDesc loadActions = {};
+			loadActions.mLoadActionDepth = LOAD_ACTION_DONTCARE;
+			loadActions.mLoadActionStencil = LOAD_ACTION_DONTCARE;
+			loadActions.mStoreActionDepth = STORE_ACTION_DONTCARE;
+			loadActions.mStoreActionStencil = STORE_ACTION_DONTCARE;
+
+			for (uint32_t a = 0; a < pPass->mAccessCount; ++a)
+			{
+				const RenderGraphAccess* pAccess = &pPass->mAccesses[a];
+				RenderTarget*            pRenderTarget = pGraph->mTextures[pAccess->mResource].pRenderTarget;
+				if (pAccess->mType == RENDER_GRAPH_ACCESS_COLOR)
+				{
+					loadActions.mLoadActionsColor[colorCount] = pAccess->mLoadAction;
+					loadActions.mStoreActionsColor[colorCount] = pAccess->mStoreAction;
+					loadActions.mClearColorValues[colorCount] = pRenderTarget->mClearValue;
+					pColors[colorCount++] = pRenderTarget;
+				}
+				else if (pAccess->mType == RENDER_GRAPH_ACCESS_DEPTH)
+				{
+					pDepth = pRenderTarget;
+					loadActions.mLoadActionDepth = pAccess->mLoadAction;
+					loadActions.mStoreActionDepth = pAccess->mStoreAction;
+					loadActions.mClearDepth = pRenderTarget->mClearValue;
+					if (TinyImageFormat_HasStencil(pRenderTarget->mFormat))
+					{
+						loadActions.mLoadActionStencil = pAccess->mLoadAction;
+						loadActions.mStoreActionStencil = pAccess->mStoreAction;
+					}
+				}
+			}
+
+			vk_cmdBindRenderTargets(pCmd, colorCount, pColors, pDepth, &loadActions, NULL, NULL, -1, -1);
+			const RenderTarget* pExtent = colorCount ? pColors[0] : pDepth;
+			if (pExtent)
+			{
+				vk_cmdSetViewport(pCmd, 0.0f, 0.0f, (float)pExtent->mWidth, (float)pExtent->mHeight, 0.0f, 1.0f);
+				vk_cmdSetScissor(pCmd, 0, 0, pExtent->mWidth, pExtent->mHeight);
+			}
+		}
+
+		pPass->pfnExecute(pCmd, pGraph, pPass->pUserData);
+
+		if (pPass->mType == RENDER_GRAPH_PASS_GRAPHICS)
+			vk_cmdBindRenderTargets(pCmd, 0, NULL, NULL, NULL, NULL, NULL, -1, -1);
+		vk_cmdEndDebugMarker(pCmd);
+	}
+
+	cmd_render_graph_barriers(pGraph, pCmd, pGraph->mFinalBarrierOffset, pGraph->mFinalBarrierCount);
+}
+
+RenderTarget* renderGraphGetRenderTarget(const RenderGraph* pGraph, RenderGraphResource resource)
+{
+	ASSERT(pGraph);
+	ASSERT(resource < (uint32_t)pGraph->mTextures.size());
+	return pGraph->mTextures[resource].pRenderTarget;
+}
+
+void getRenderGraphStats(const RenderGraph* pGraph, RenderGraphStats* pStats)
+{
+	ASSERT(pGraph);
+	ASSERT(pStats);
+	*pStats = pGraph->mStats;
+}
@@ -0,0 +1,468 @@
+/*
+ * Copyright (c) 2017-2022 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "../Include/RendererConfig.h"
+
+#include "../../ThirdParty/OpenSource/EASTL/sort.h"
+#include "../../ThirdParty/OpenSource/EASTL/vector.h"
+
+#include "../../ThirdParty/OpenSource/tinyimageformat/tinyimageformat_base.h"
+#include "../../ThirdParty/OpenSource/tinyimageformat/tinyimageformat_query.h"
+
+#include "../Include/IRenderer.h"
+#include "../Include/IResourceLoader.h"
+#include "../Include/IResidencyManager.h"
+#include "../../OS/Core/Atomics.h"
+#include "../../OS/Interfaces/ILog.h"
+#include "../../OS/Math/MathTypes.h"
+#include "../../OS/Profiler/ProfilerBase.h"
+
+#include "../../OS/Interfaces/IMemory.h"
+
+struct ResidentTexture
+{
+	/// File name and password point to copies owned by the resident texture
+	TextureLoadDesc mLoadDesc;
+	Texture*        pTexture;
+	/// Reload in flight, swapped with pTexture once mToken completed
+	Texture*        pPendingTexture;
+	SyncToken       mToken;
+	tfrg_atomic64_t mLastUsedFrame;
+	uint32_t        mPriority;
+	uint32_t        mIndex;
+	/// Top mips left out of pTexture and pPendingTexture
+	uint32_t        mSkipMipLevels;
+	uint32_t        mPendingSkipMipLevels;
+	/// Full resolution description, known once the first load completed
+	uint32_t        mMaxSkipMipLevels;
+	uint32_t        mWidth;
+	uint32_t        mHeight;
+	uint32_t        mDepth;
+	uint32_t        mArraySize;
+	uint32_t        mMipLevels;
+	TinyImageFormat mFormat;
+	bool            mLoaded;
+	bool            mPending;
+};
+
+typedef struct RetiredTexture
+{
+	Texture* pTexture;
+	uint64_t mSize;
+	uint64_t mFrame;
+} RetiredTexture;
+
+struct ResidencyManager
+{
+	Renderer*                        pRenderer;
+	ResidencyManagerDesc             mDesc;
+	eastl::vector<ResidentTexture*>  mTextures;
+	eastl::vector<RetiredTexture>    mRetiredTextures;
+	eastl::vector<ResidentTexture*>  mCandidates;
+	tfrg_atomic64_t                  mFrameIndex;
+	ResidencyStats                   mStats;
+};
+
+static char* util_copy_string(const char* pString)
+{
+	if (!pString)
+	{
+		return NULL;
+	}
+	const size_t size = strlen(pString) + 1;
+	char*        pCopy = (char*)tf_malloc(size);
+	memcpy(pCopy, pString, size);
+	return pCopy;
+}
+
+/// Estimated memory of the texture without its top skipMipLevels mips
+static uint64_t util_get_resident_texture_size(const ResidentTexture* pResidentTexture, uint32_t skipMipLevels)
+{
+	const TinyImageFormat fmt = pResidentTexture->mFormat;
+	const uint32_t        blockWidth = TinyImageFormat_WidthOfBlock(fmt);
+	const uint32_t        blockHeight = TinyImageFormat_HeightOfBlock(fmt);
+	const uint64_t        blockBits = TinyImageFormat_BitSizeOfBlock(fmt);
+
+	uint64_t size = 0;
+	for (uint32_t mip = skipMipLevels; mip < pResidentTexture->mMipLevels; ++mip)
+	{
+		const uint64_t w = max(1u, pResidentTexture->mWidth >> mip);
+		const uint64_t h = max(1u, pResidentTexture->mHeight >> mip);
+		const uint64_t d = max(1u, pResidentTexture->mDepth >> mip);
+		size += ((w + blockWidth - 1) / blockWidth) * ((h + blockHeight - 1) / blockHeight) * d * blockBits / 8;
+	}
+	return size * pResidentTexture->mArraySize;
+}
+
+static void util_init_resident_texture(ResidencyManager* pManager, ResidentTexture* pResidentTexture)
+{
+	pResidentTexture->mLoaded = true;
+
+	const Texture* pTexture = pResidentTexture->pTexture;
+	if (!pTexture)
+	{
+		// Failed loads are kept so that removeResidentTexture still works, but never reloaded
+		return;
+	}
+
+	pResidentTexture->mWidth = pTexture->mWidth;
+	pResidentTexture->mHeight = pTexture->mHeight;
+	pResidentTexture->mDepth = pTexture->mDepth;
+	pResidentTexture->mArraySize = pTexture->mArraySizeMinusOne + 1;
+	pResidentTexture->mMipLevels = pTexture->mMipLevels;
+	pResidentTexture->mFormat = (TinyImageFormat)pTexture->mFormat;
+
+	const uint32_t minDimension = pManager->mDesc.mMinResidentDimension;
+	uint32_t       maxSkipMipLevels = 0;
+	while (maxSkipMipLevels + 1 < pResidentTexture->mMipLevels &&
+		   max(pResidentTexture->mWidth, pResidentTexture->mHeight) >> (maxSkipMipLevels + 1) >= minDimension)
+	{
+		++maxSkipMipLevels;
+	}
+	pResidentTexture->mMaxSkipMipLevels = maxSkipMipLevels;
+}
+
+static void util_queue_resident_texture_reload(ResidentTexture* pResidentTexture, uint32_t skipMipLevels)
+{
+	TextureLoadDesc loadDesc = pResidentTexture->mLoadDesc;
+	loadDesc.ppTexture = &pResidentTexture->pPendingTexture;
+	loadDesc.mSkipMipLevels = skipMipLevels;
+	// Processed after every other class. LOW tokens complete separately, so the reloads queued ahead of an application load
+	// don't hold back its token either
+	loadDesc.mPriority = RESOURCE_PRIORITY_LOW;
+
+	pResidentTexture->pPendingTexture = NULL;
+	pResidentTexture->mPendingSkipMipLevels = skipMipLevels;
+	pResidentTexture->mPending = true;
+	pResidentTexture->mToken = 0;
+	addResource(&loadDesc, &pResidentTexture->mToken);
+}
+
+void addResidencyManager(Renderer* pRenderer, const ResidencyManagerDesc* pDesc, ResidencyManager** ppManager)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc && ppManager);
+	ASSERT(pDesc->mFrameCount && pDesc->mMipsPerStep && pDesc->mMaxRequestsPerUpdate);
+	ASSERT(pDesc->mRestoreBudgetFraction <= pDesc->mTargetBudgetFraction);
+
+	ResidencyManager* pManager = tf_new(ResidencyManager);
+	pManager->pRenderer = pRenderer;
+	pManager->mDesc = *pDesc;
+
+	PROFILE_COUNTER_CONFIG("Residency/Budget", PROFILE_COUNTER_FORMAT_BYTES, 0, PROFILE_COUNTER_FLAG_DETAILED);
+	PROFILE_COUNTER_CONFIG("Residency/Usage", PROFILE_COUNTER_FORMAT_BYTES, 0, PROFILE_COUNTER_FLAG_DETAILED_GRAPH);
+	PROFILE_COUNTER_CONFIG("Residency/Textures", PROFILE_COUNTER_FORMAT_BYTES, 0, PROFILE_COUNTER_FLAG_DETAILED);
+	PROFILE_COUNTER_CONFIG("Residency/Saved", PROFILE_COUNTER_FORMAT_BYTES, 0, PROFILE_COUNTER_FLAG_DETAILED);
+
+	*ppManager = pManager;
+}
+
+void removeResidencyManager(ResidencyManager* pManager)
+{
+	if (!pManager)
+	{
+		return;
+	}
+
+	if (!pManager->mTextures.empty())
+	{
+		LOGF(eWARNING, "removeResidencyManager: %u resident textures were not removed", (uint32_t)pManager->mTextures.size());
+		while (!pManager->mTextures.empty())
+		{
+			removeResidentTexture(pManager, pManager->mTextures.back());
+		}
+	}
+
+	for (RetiredTexture& retired : pManager->mRetiredTextures)
+	{
+		removeResource(retired.pTexture);
+	}
+
+	tf_delete(pManager);
+}
+
+void addResidentTexture(
+	ResidencyManager* pManager, const TextureLoadDesc* pDesc, uint32_t priority, ResidentTexture** ppResidentTexture, SyncToken* token)
+{
+	ASSERT(pManager);
+	ASSERT(pDesc && ppResidentTexture);
+	// Empty textures have nothing to reload from
+	ASSERT(pDesc->pFileName && !pDesc->pDesc);
+
+	ResidentTexture* pResidentTexture = tf_new(ResidentTexture);
+	pResidentTexture->mLoadDesc = *pDesc;
+	pResidentTexture->mLoadDesc.ppTexture = NULL;
+	pResidentTexture->mLoadDesc.pFileName = util_copy_string(pDesc->pFileName);
+	pResidentTexture->mLoadDesc.pFilePassword = util_copy_string(pDesc->pFilePassword);
+	pResidentTexture->mLoadDesc.mSkipMipLevels = 0;
+	pResidentTexture->mPriority = priority;
+	pResidentTexture->mIndex = (uint32_t)pManager->mTextures.size();
+	tfrg_atomic64_store_relaxed(&pResidentTexture->mLastUsedFrame, tfrg_atomic64_load_relaxed(&pManager->mFrameIndex));
+	pManager->mTextures.push_back(pResidentTexture);
+
+	TextureLoadDesc loadDesc = pResidentTexture->mLoadDesc;
+	loadDesc.ppTexture = &pResidentTexture->pTexture;
+	addResource(&loadDesc, &pResidentTexture->mToken);
+	if (token)
+		*token = combineSyncTokens(*token, pResidentTexture->mToken);
+
+	*ppResidentTexture = pResidentTexture;
+}
+
+void removeResidentTexture(ResidencyManager* pManager, ResidentTexture* pResidentTexture)
+{
+	ASSERT(pManager);
+	ASSERT(pResidentTexture && pManager->mTextures[pResidentTexture->mIndex] == pResidentTexture);
+
+	if (!pResidentTexture->mLoaded || pResidentTexture->mPending)
+	{
+		waitForToken(&pResidentTexture->mToken);
+	}
+	if (pResidentTexture->pPendingTexture)
+	{
+		removeResource(pResidentTexture->pPendingTexture);
+	}
+	if (pResidentTexture->pTexture)
+	{
+		removeResource(pResidentTexture->pTexture);
+	}
+
+	ResidentTexture* pLast = pManager->mTextures.back();
+	pLast->mIndex = pResidentTexture->mIndex;
+	pManager->mTextures[pResidentTexture->mIndex] = pLast;
+	pManager->mTextures.pop_back();
+
+	tf_free((void*)pResidentTexture->mLoadDesc.pFileName);
+	tf_free((void*)pResidentTexture->mLoadDesc.pFilePassword);
+	tf_delete(pResidentTexture);
+}
+
+void markResidentTextureUsed(ResidencyManager* pManager, ResidentTexture* pResidentTexture)
+{
+	tfrg_atomic64_store_relaxed(&pResidentTexture->mLastUsedFrame, tfrg_atomic64_load_relaxed(&pManager->mFrameIndex));
+}
+
+Texture* getResidentTexture(const ResidentTexture* pResidentTexture) { return pResidentTexture->pTexture; }
+
+bool updateResidencyManager(ResidencyManager* pManager)
+{
+	PROFILER_SET_CPU_SCOPE("Residency", "Update", 0xff40a0d0);
+
+	const ResidencyManagerDesc& desc = pManager->mDesc;
+	ResidencyStats&             stats = pManager->mStats;
+	const uint64_t              frame = tfrg_atomic64_add_relaxed(&pManager->mFrameIndex, 1) + 1;
+	bool                        changed = false;
+
+	// Replaced textures are removed once no frame in flight can reference them
+	uint64_t retiredBytes = 0;
+	for (uint32_t i = 0; i < (uint32_t)pManager->mRetiredTextures.size();)
+	{
+		RetiredTexture& retired = pManager->mRetiredTextures[i];
+		if (frame - retired.mFrame >= desc.mFrameCount)
+		{
+			removeResource(retired.pTexture);
+			retired = pManager->mRetiredTextures.back();
+			pManager->mRetiredTextures.pop_back();
+			continue;
+		}
+		retiredBytes += retired.mSize;
+		++i;
+	}
+
+	// Swap in completed reloads
+	uint64_t textureBytes = 0;
+	uint64_t fullResolutionBytes = 0;
+	// Memory the pending reloads will release once they completed and the replaced textures are removed
+	int64_t  pendingBytes = 0;
+	uint32_t demotedCount = 0;
+	uint32_t pendingCount = 0;
+	for (ResidentTexture* pResidentTexture : pManager->mTextures)
+	{
+		if (!pResidentTexture->mLoaded)
+		{
+			if (!isTokenCompleted(&pResidentTexture->mToken))
+			{
+				++pendingCount;
+				continue;
+			}
+			util_init_resident_texture(pManager, pResidentTexture);
+		}
+		else if (pResidentTexture->mPending && isTokenCompleted(&pResidentTexture->mToken))
+		{
+			Texture* pTexture = pResidentTexture->pPendingTexture;
+			if (pTexture)
+			{
+				if (pResidentTexture->mPendingSkipMipLevels && pTexture->mWidth == pResidentTexture->mWidth &&
+					pTexture->mHeight == pResidentTexture->mHeight)
+				{
+					// The container does not support loading without the top mips
+					LOGF(eWARNING, "Residency: '%s' cannot be reduced, its file format is always loaded at full resolution",
+						pResidentTexture->mLoadDesc.pFileName);
+					pResidentTexture->mMaxSkipMipLevels = 0;
+					pResidentTexture->mPendingSkipMipLevels = 0;
+				}
+
+				RetiredTexture retired = { pResidentTexture->pTexture,
+										   util_get_resident_texture_size(pResidentTexture, pResidentTexture->mSkipMipLevels), frame };
+				pManager->mRetiredTextures.push_back(retired);
+				retiredBytes += retired.mSize;
+
+				pResidentTexture->pTexture = pTexture;
+				pResidentTexture->mSkipMipLevels = pResidentTexture->mPendingSkipMipLevels;
+				changed = true;
+			}
+			pResidentTexture->pPendingTexture = NULL;
+			pResidentTexture->mPending = false;
+		}
+
+		const uint64_t size = util_get_resident_texture_size(pResidentTexture, pResidentTexture->mSkipMipLevels);
+		if (pResidentTexture->mPending)
+		{
+			pendingBytes += (int64_t)size - (int64_t)util_get_resident_texture_size(pResidentTexture, pResidentTexture->mPendingSkipMipLevels);
+			++pendingCount;
+		}
+		textureBytes += size;
+		fullResolutionBytes += util_get_resident_texture_size(pResidentTexture, 0);
+		demotedCount += pResidentTexture->mSkipMipLevels ? 1 : 0;
+	}
+
+	vk_getMemoryBudget(pManager->pRenderer, &stats.mBudget);
+	stats.mTextureBytes = textureBytes;
+	stats.mFullResolutionBytes = fullResolutionBytes;
+	stats.mTextureCount = (uint32_t)pManager->mTextures.size();
+	stats.mDemotedTextureCount = demotedCount;
+	stats.mPendingCount = pendingCount;
+
+	PROFILE_COUNTER_SET("Residency/Budget", (int64_t)stats.mBudget.mBudget);
+	PROFILE_COUNTER_SET("Residency/Usage", (int64_t)stats.mBudget.mUsage);
+	PROFILE_COUNTER_SET_LIMIT("Residency/Usage", (int64_t)stats.mBudget.mBudget);
+	PROFILE_COUNTER_SET("Residency/Textures", (int64_t)textureBytes);
+	PROFILE_COUNTER_SET("Residency/Saved", (int64_t)(fullResolutionBytes - textureBytes));
+
+	if (!stats.mBudget.mBudget)
+	{
+		return changed;
+	}
+
+	// Usage once everything in flight settled, so that the same pressure is not answered twice
+	const double budget = (double)stats.mBudget.mBudget;
+	const double usage = max(0.0, (double)stats.mBudget.mUsage - (double)retiredBytes - (double)pendingBytes);
+	const double target = budget * desc.mTargetBudgetFraction;
+	const double restore = budget * desc.mRestoreBudgetFraction;
+
+	eastl::vector<ResidentTexture*>& candidates = pManager->mCandidates;
+	candidates.clear();
+	uint32_t requestCount = 0;
+
+	if (usage > target)
+	{
+		// Over the whole budget the driver is about to page, recently used textures are fair game too
+		const bool overBudget = usage > budget;
+		for (ResidentTexture* pResidentTexture : pManager->mTextures)
+		{
+			if (pResidentTexture->mLoaded && !pResidentTexture->mPending &&
+				pResidentTexture->mSkipMipLevels < pResidentTexture->mMaxSkipMipLevels &&
+				(overBudget || frame - tfrg_atomic64_load_relaxed(&pResidentTexture->mLastUsedFrame) >= desc.mMinUnusedFrames))
+			{
+				candidates.push_back(pResidentTexture);
+			}
+		}
+
+		// Lowest priority first, least recently used first within a priority
+		eastl::sort(candidates.begin(), candidates.end(), [](const ResidentTexture* pA, const ResidentTexture* pB) {
+			if (pA->mPriority != pB->mPriority)
+				return pA->mPriority < pB->mPriority;
+			return tfrg_atomic64_load_relaxed((tfrg_atomic64_t*)&pA->mLastUsedFrame) <
+				   tfrg_atomic64_load_relaxed((tfrg_atomic64_t*)&pB->mLastUsedFrame);
+		});
+
+		double excess = usage - target;
+		for (ResidentTexture* pResidentTexture : candidates)
+		{
+			if (excess <= 0.0 || requestCount >= desc.mMaxRequestsPerUpdate)
+			{
+				break;
+			}
+
+			const uint32_t skipMipLevels =
+				overBudget ? pResidentTexture->mMaxSkipMipLevels
+						   : min(pResidentTexture->mSkipMipLevels + desc.mMipsPerStep, pResidentTexture->mMaxSkipMipLevels);
+			excess -= (double)(util_get_resident_texture_size(pResidentTexture, pResidentTexture->mSkipMipLevels) -
+							   util_get_resident_texture_size(pResidentTexture, skipMipLevels));
+			util_queue_resident_texture_reload(pResidentTexture, skipMipLevels);
+			++requestCount;
+			if (overBudget)
+				++stats.mEvictionCount;
+			else
+				++stats.mDemotionCount;
+		}
+	}
+	else if (usage < restore)
+	{
+		// Only textures that are still used are worth their memory
+		for (ResidentTexture* pResidentTexture : pManager->mTextures)
+		{
+			if (pResidentTexture->mLoaded && !pResidentTexture->mPending && pResidentTexture->mSkipMipLevels &&
+				frame - tfrg_atomic64_load_relaxed(&pResidentTexture->mLastUsedFrame) < desc.mMinUnusedFrames)
+			{
+				candidates.push_back(pResidentTexture);
+			}
+		}
+
+		// Highest priority first, most recently used first within a priority
+		eastl::sort(candidates.begin(), candidates.end(), [](const ResidentTexture* pA, const ResidentTexture* pB) {
+			if (pA->mPriority != pB->mPriority)
+				return pA->mPriority > pB->mPriority;
+			return tfrg_atomic64_load_relaxed((tfrg_atomic64_t*)&pA->mLastUsedFrame) >
+				   tfrg_atomic64_load_relaxed((tfrg_atomic64_t*)&pB->mLastUsedFrame);
+		});
+
+		double headroom = restore - usage;
+		for (ResidentTexture* pResidentTexture : candidates)
+		{
+			if (requestCount >= desc.mMaxRequestsPerUpdate)
+			{
+				break;
+			}
+
+			const uint32_t skipMipLevels =
+				pResidentTexture->mSkipMipLevels > desc.mMipsPerStep ? pResidentTexture->mSkipMipLevels - desc.mMipsPerStep : 0;
+			// Both versions are allocated until the old one is removed
+			const double cost = (double)util_get_resident_texture_size(pResidentTexture, skipMipLevels);
+			if (cost > headroom)
+			{
+				continue;
+			}
+			headroom -= cost;
+			util_queue_resident_texture_reload(pResidentTexture, skipMipLevels);
+			++requestCount;
+			++stats.mRestoreCount;
+		}
+	}
+
+	stats.mPendingCount += requestCount;
+	return changed;
+}
+
+void getResidencyStats(const ResidencyManager* pManager, ResidencyStats* pStats) { *pStats = pManager->mStats; }
@@ -26,6 +26,7 @@
 
 #include "../ThirdParty/OpenSource/EASTL/string.h"
 #include "../ThirdParty/OpenSource/EASTL/vector.h"
+#include "../ThirdParty/OpenSource/EASTL/hash_map.h"
 
 #include "../ThirdParty/OpenSource/tinyimageformat/tinyimageformat_base.h"
 #include "../ThirdParty/OpenSource/tinyimageformat/tinyimageformat_query.h"
@@ -48,6 +49,9 @@
 #include "../Include/IResourceLoader.h"
 #include "../OS/Interfaces/ILog.h"
 #include "../OS/Interfaces/IThread.h"
+#include "../OS/Interfaces/ITime.h"
+#include "../OS/Interfaces/IProfiler.h"
+#include "../OS/Core/CPUConfig.h"
 
 #if defined(__ANDROID__) && defined(VULKAN)
 #include <shaderc/shaderc.h>
@@ -58,6 +62,9 @@
 #endif
 
 #include "../OS/Core/TextureContainers.h"
+#include "../OS/Core/ThreadSystem.h"
+
+#include "VertexPacking.h"
 
 #include "../OS/Interfaces/IMemory.h"
 
@@ -71,6 +78,8 @@ enum
 {
 	MAPPED_RANGE_FLAG_UNMAP_BUFFER = (1 << 0),
 	MAPPED_RANGE_FLAG_TEMP_BUFFER = (1 << 1),
+	// Range lives in system memory and still has to be copied to staging memory
+	MAPPED_RANGE_FLAG_CPU_MEMORY = (1 << 2),
 };
 
 extern RendererApi gSelectedRendererApi;
@@ -98,7 +107,14 @@ static FORGE_CONSTEXPR const bool gUma = false;
 
 #define MAX_FRAMES 3U
 
-ResourceLoaderDesc gDefaultResourceLoaderDesc = { 8ull << 20, 2 };
+/// Completion is tracked per priority class, pipelines compiling in the background are one more class
+#define SYNC_TOKEN_CLASS_PIPELINE RESOURCE_PRIORITY_COUNT
+#define SYNC_TOKEN_CLASS_COUNT (RESOURCE_PRIORITY_COUNT + 1)
+#define SYNC_TOKEN_CLASS_BITS 4
+#define SYNC_TOKEN_ALL_CLASSES ((1u << SYNC_TOKEN_CLASS_COUNT) - 1)
+COMPILE_ASSERT(SYNC_TOKEN_CLASS_COUNT <= SYNC_TOKEN_CLASS_BITS);
+
+ResourceLoaderDesc gDefaultResourceLoaderDesc = { 8ull << 20, 2, false, 4, 0, 0, 256, 2, 256ull << 20, false };
 /************************************************************************/
 // Surface Utils
 /************************************************************************/
@@ -214,103 +230,23 @@ static inline constexpr TinyImageFormat util_cgltf_type_to_image_format(cgltf_ty
 	}
 }
 
-#define F16_EXPONENT_BITS 0x1F
-#define F16_EXPONENT_SHIFT 10
-#define F16_EXPONENT_BIAS 15
-#define F16_MANTISSA_BITS 0x3ff
-#define F16_MANTISSA_SHIFT (23 - F16_EXPONENT_SHIFT)
-#define F16_MAX_EXPONENT (F16_EXPONENT_BITS << F16_EXPONENT_SHIFT)
+static VertexPackingPath gVertexPackingPath = VERTEX_PACKING_PATH_SCALAR;
 
-static inline uint16_t util_float_to_half(float val)
+static void util_init_vertex_packing()
 {
-	uint32_t f32 = (*(uint32_t*)&val);
-	uint16_t f16 = 0;
-	/* Decode IEEE 754 little-endian 32-bit floating-point value */
-	int sign = (f32 >> 16) & 0x8000;
-	/* Map exponent to the range [-127,128] */
-	int exponent = ((f32 >> 23) & 0xff) - 127;
-	int mantissa = f32 & 0x007fffff;
-	if (exponent == 128)
-	{ /* Infinity or NaN */
-		f16 = (uint16_t)(sign | F16_MAX_EXPONENT);
-		if (mantissa)
-			f16 |= (mantissa & F16_MANTISSA_BITS);
-	}
-	else if (exponent > 15)
-	{ /* Overflow - flush to Infinity */
-		f16 = (unsigned short)(sign | F16_MAX_EXPONENT);
-	}
-	else if (exponent > -15)
-	{ /* Representable value */
-		exponent += F16_EXPONENT_BIAS;
-		mantissa >>= F16_MANTISSA_SHIFT;
-		f16 = (unsigned short)(sign | exponent << F16_EXPONENT_SHIFT | mantissa);
-	}
-	else
+	gVertexPackingPath = VERTEX_PACKING_PATH_SCALAR;
+#if defined(ARCH_X86_FAMILY)
+	CpuInfo cpuInfo = {};
+	if (initCpuInfo(&cpuInfo))
 	{
-		f16 = (unsigned short)sign;
+		if (cpuInfo.features.avx2 && cpuInfo.features.f16c)
+			gVertexPackingPath = VERTEX_PACKING_PATH_AVX2;
+		else if (cpuInfo.features.sse4_1)
+			gVertexPackingPath = VERTEX_PACKING_PATH_SSE41;
 	}
-	return f16;
-}
-
-static inline void util_pack_float2_to_half2(uint32_t count, uint32_t stride, uint32_t offset, const uint8_t* src, uint8_t* dst)
-{
-	struct f2
-	{
-		float x;
-		float y;
-	};
-	f2* f = (f2*)src;
-	for (uint32_t e = 0; e < count; ++e)
-	{
-		*(uint32_t*)(dst + e * sizeof(uint32_t) + offset) =
-			((util_float_to_half(f[e].x) & 0x0000FFFF) | ((util_float_to_half(f[e].y) << 16) & 0xFFFF0000));
-	}
-}
-
-static inline uint32_t util_float2_to_unorm2x16(const float* v)
-{
-	uint32_t x = (uint32_t)round(clamp(v[0], 0, 1) * 65535.0f);
-	uint32_t y = (uint32_t)round(clamp(v[1], 0, 1) * 65535.0f);
-	return ((uint32_t)0x0000FFFF & x) | ((y << 16) & (uint32_t)0xFFFF0000);
+#endif
 }
 
-#define OCT_WRAP(v, w) ((1.0f - abs((w))) * ((v) >= 0.0f ? 1.0f : -1.0f))
-
-static inline void util_pack_float3_direction_to_half2(uint32_t count, uint32_t stride, uint32_t offset, const uint8_t* src, uint8_t* dst)
-{
-	struct f3
-	{
-		float x;
-		float y;
-		float z;
-	};
-	for (uint32_t e = 0; e < count; ++e)
-	{
-		f3    f = *(f3*)(src + e * stride);
-		float absLength = (abs(f.x) + abs(f.y) + abs(f.z));
-		f3    enc = {};
-		if (absLength)
-		{
-			enc.x = f.x / absLength;
-			enc.y = f.y / absLength;
-			enc.z = f.z / absLength;
-			if (enc.z < 0)
-			{
-				float oldX = enc.x;
-				enc.x = OCT_WRAP(enc.x, enc.y);
-				enc.y = OCT_WRAP(enc.y, oldX);
-			}
-			enc.x = enc.x * 0.5f + 0.5f;
-			enc.y = enc.y * 0.5f + 0.5f;
-			*(uint32_t*)(dst + e * sizeof(uint32_t) + offset) = util_float2_to_unorm2x16(&enc.x);
-		}
-		else
-		{
-			*(uint32_t*)(dst + e * sizeof(uint32_t) + offset) = 0;
-		}
-	}
-}
 /************************************************************************/
 // Internal Structures
 /************************************************************************/
@@ -327,6 +263,14 @@ typedef struct TextureUpdateDescInternal
 	uint32_t          mLayerCount;
 	PreMipStepFn      pPreMipFunc;
 	bool              mMipsAfterSlice;
+	/// Bytes of skipped top mips in mStream before every layer (before all the data if mMipsAfterSlice)
+	uint64_t          mSkipMipBytes;
+	/// Progress of an upload from mStream split across copy engine sets, relative to the base mip / layer
+	bool              mInProgress;
+	uint32_t          mProgressFirst;
+	uint32_t          mProgressSecond;
+	uint32_t          mProgressSlice;
+	uint32_t          mProgressRow;
 } TextureUpdateDescInternal;
 
 typedef struct CopyResourceSet
@@ -334,23 +278,57 @@ typedef struct CopyResourceSet
 	Fence* pFence;
 	Cmd* pCmd;
 	CmdPool* pCmdPool;
-	Buffer* mBuffer;
+	/// Staging pages taken from the copy engine pool, sub-allocations come from the last one
+	/// Returned to the pool after the fence for this set is complete
+	eastl::vector<Buffer*> mPages;
+	/// Offset of the next sub-allocation in the last page
+	uint64_t mPageOffset;
+	/// Staging memory handed out for this set
 	uint64_t mAllocatedSpace;
 
-	/// Buffers created in case we ran out of space in the original staging buffer
+	/// Upload buffers filled by beginUpdateResource on the client side
 	/// Will be cleaned up after the fence for this set is complete
 	eastl::vector<Buffer*> mTempBuffers;
 
 	Semaphore* pCopyCompletedSemaphore;
 } CopyResourceSet;
 
+typedef struct StagingPage
+{
+	Buffer*  pBuffer;
+	/// Streamer cycle in which the page was last used by a copy engine set
+	uint64_t mLastUsedCycle;
+} StagingPage;
+
+/// Staging counters of a copy engine, atomic since getResourceLoaderStats reads them while the streamer updates them
+typedef struct CopyEngineStats
+{
+	tfrg_atomic64_t mStagingBytesInUse;
+	tfrg_atomic64_t mStagingPeakBytesInUse;
+	tfrg_atomic64_t mStagingBytesAllocated;
+	tfrg_atomic64_t mStagingPeakBytesAllocated;
+	tfrg_atomic32_t mStagingPageAllocations;
+	tfrg_atomic32_t mStagingPageReleases;
+	tfrg_atomic32_t mStagingOversizedAllocations;
+	tfrg_atomic32_t mStagingWaits;
+} CopyEngineStats;
+
 //Synchronization?
 typedef struct CopyEngine
 {
 	Queue* pQueue;
 	CopyResourceSet* resourceSets;
+	/// Staging memory budget of a set
 	uint64_t         bufferSize;
 	uint32_t         bufferCount;
+	/// Pages not used by any set. Sizes are multiples of pageSize, larger pages back oversized allocations
+	eastl::vector<StagingPage> mFreePages;
+	uint64_t                   pageSize;
+	uint32_t                   pageCount;
+	uint32_t                   minPageCount;
+	uint32_t                   shrinkDelay;
+	uint64_t                   cycle;
+	CopyEngineStats            mStats;
 	/// Node index in linked GPU mode, Renderer index in unlinked mode
 	uint32_t         nodeIndex;
 	bool             isRecording;
@@ -377,9 +355,60 @@ typedef enum UploadFunctionResult
 {
 	UPLOAD_FUNCTION_RESULT_COMPLETED,
 	UPLOAD_FUNCTION_RESULT_STAGING_BUFFER_FULL,
+	/// Staging budget of the set is used up, the request continues with the next set
+	UPLOAD_FUNCTION_RESULT_STAGING_NOT_READY,
 	UPLOAD_FUNCTION_RESULT_INVALID_REQUEST
 } UploadFunctionResult;
 
+typedef struct TextureDecodeDesc
+{
+	TextureDesc  mDesc;
+	FileStream   mStream;
+	PreMipStepFn pPreMipFunc;
+	bool         mMipsAfterSlice;
+} TextureDecodeDesc;
+
+typedef struct GeometryDecodeDesc
+{
+	BufferUpdateDesc mIndexUpdateDesc;
+	BufferUpdateDesc mVertexUpdateDesc[MAX_VERTEX_BINDINGS];
+} GeometryDecodeDesc;
+
+typedef enum ResourceDecodeTaskState
+{
+	DECODE_TASK_STATE_PENDING = 0,
+	DECODE_TASK_STATE_RUNNING,
+	DECODE_TASK_STATE_CANCELLED,
+} ResourceDecodeTaskState;
+
+/// CPU side of a load request (file reads, header parsing, transcoding, vertex packing)
+/// Runs on the decode thread system while the streamer keeps recording copies for earlier requests
+struct ResourceLoader;
+
+typedef struct ResourceDecodeTask
+{
+	UpdateRequestType mType;
+	Renderer*         pRenderer;
+	ResourceLoader*   pLoader;
+	/// Decoded data held in system memory until the streamer consumes the task
+	uint64_t          mDecodedBytes;
+	/// Reaches zero once the decode finished
+	ThreadCounter     mCounter;
+	/// ResourceDecodeTaskState, lets cancelResourceLoad skip decodes that did not start yet
+	tfrg_atomic32_t   mState;
+	bool              mSuccess;
+	union
+	{
+		TextureLoadDesc  mTextureLoadDesc;
+		GeometryLoadDesc mGeometryLoadDesc;
+	};
+	union
+	{
+		TextureDecodeDesc  mTexture;
+		GeometryDecodeDesc mGeometry;
+	};
+} ResourceDecodeTask;
+
 struct UpdateRequest
 {
 	UpdateRequest(const BufferUpdateDesc& buffer) : mType(UPDATE_REQUEST_UPDATE_BUFFER), bufUpdateDesc(buffer) {}
@@ -393,6 +422,7 @@ struct UpdateRequest
 	UpdateRequestType mType = UPDATE_REQUEST_INVALID;
 	uint64_t          mWaitIndex = 0;
 	Buffer* pUploadBuffer = NULL;
+	ResourceDecodeTask* pDecodeTask = NULL;
 	union
 	{
 		BufferUpdateDesc          bufUpdateDesc;
@@ -405,6 +435,33 @@ struct UpdateRequest
 	};
 };
 
+/// Pipeline shared by every addPipeline with the same description
+struct PipelineCacheEntry
+{
+	Renderer*            pRenderer;
+	ResourceLoader*      pLoader;
+	Pipeline*            pPipeline;
+	/// Entries with the same hash
+	PipelineCacheEntry*  pNext;
+	uint32_t             mHash;
+	uint32_t             mRefCount;
+	/// Request counter of the compile, 0 if the pipeline was compiled on the calling thread
+	uint64_t             mToken;
+	/// Flattened description, compared on hash hits
+	eastl::vector<uint32_t>   mKey;
+	/// Handles of the requests waiting for the compile
+	eastl::vector<Pipeline**> mOutputs;
+
+	// Copy of the description and everything it points to, the compile can outlive the caller's stack
+	PipelineDesc         mDesc;
+	VertexLayout         mVertexLayout;
+	BlendStateDesc       mBlendState;
+	DepthStateDesc       mDepthState;
+	RasterizerStateDesc  mRasterizerState;
+	TinyImageFormat      mColorFormats[MAX_RENDER_TARGET_ATTACHMENTS];
+	char                 mName[MAX_DEBUG_NAME_LENGTH];
+};
+
 struct ResourceLoader
 {
 	Renderer* ppRenderers[MAX_MULTIPLE_GPUS];
@@ -419,23 +476,93 @@ struct ResourceLoader
 	ConditionVariable            mQueueCond;
 	Mutex                        mTokenMutex;
 	ConditionVariable            mTokenCond;
-	eastl::vector<UpdateRequest> mRequestQueue[MAX_MULTIPLE_GPUS];
+	eastl::vector<UpdateRequest> mRequestQueue[MAX_MULTIPLE_GPUS][RESOURCE_PRIORITY_COUNT];
 
-	tfrg_atomic64_t mTokenCompleted;
-	tfrg_atomic64_t mTokenSubmitted;
+	/// Request counter reached by every token class, see util_is_token_reached
+	tfrg_atomic64_t mTokenCompleted[SYNC_TOKEN_CLASS_COUNT];
+	tfrg_atomic64_t mTokenSubmitted[SYNC_TOKEN_CLASS_COUNT];
 	tfrg_atomic64_t mTokenCounter;
 
 	Mutex mSemaphoreMutex;
 
-	SyncToken mCurrentTokenState[MAX_FRAMES];
+	uint64_t mCurrentTokenState[MAX_FRAMES][SYNC_TOKEN_CLASS_COUNT];
 
 	CopyEngine pCopyEngines[MAX_MULTIPLE_GPUS];
 	uint32_t   mNextSet;
 	uint32_t   mSubmittedSets;
+
+	/// Workers decoding texture and geometry loads, NULL if everything runs on the streamer thread
+	ThreadSystem* pDecodeThreadSystem;
+	/// Guards the decode budget state below
+	Mutex                              mDecodeMutex;
+	/// Decode tasks held back by mDesc.mDecodeMemoryBudget, in queue order
+	eastl::vector<ResourceDecodeTask*> mPendingDecodeTasks;
+	/// Decode tasks handed to pDecodeThreadSystem which did not finish yet
+	uint32_t                           mDecodeTasksRunning;
+	/// Bytes of finished decodes the streamer did not consume yet
+	uint64_t                           mDecodeBytesInFlight;
+	uint64_t                           mDecodePeakBytesInFlight;
+
+	/// Workers compiling pipelines, NULL if addPipeline compiles on the calling thread
+	ThreadSystem*                                 pPipelineThreadSystem;
+	Mutex                                         mPipelineMutex;
+	/// Signaled when a pipeline compiled on a calling thread is published
+	ConditionVariable                             mPipelineCond;
+	eastl::hash_map<uint32_t, PipelineCacheEntry*> mPipelineCache;
+	eastl::hash_map<Pipeline*, PipelineCacheEntry*> mPipelineEntries;
+	PipelineCompileStats                          mPipelineStats;
+	/// Request counters of the pipelines still compiling, in increasing order. Guarded by mQueueMutex
+	eastl::vector<uint64_t>                       mPipelineTokens;
 };
 
 static ResourceLoader* pResourceLoader = NULL;
 
+/// Order in which the streamer drains the request queues of a node
+static const ResourcePriority gResourcePriorityOrder[RESOURCE_PRIORITY_COUNT] = {
+	RESOURCE_PRIORITY_HIGH,
+	RESOURCE_PRIORITY_NORMAL,
+	RESOURCE_PRIORITY_LOW,
+};
+
+/// Every request draws a counter from mTokenCounter. A SyncToken stores the largest counter it covers above one bit per class of
+/// requests it covers, and completes once each of these classes processed all its requests up to that counter.
+/// Requests queued earlier in other classes don't hold a token back.
+static inline uint64_t util_get_token_counter(SyncToken token) { return token >> SYNC_TOKEN_CLASS_BITS; }
+
+static inline SyncToken util_make_token(uint64_t counter, uint32_t classMask) { return (counter << SYNC_TOKEN_CLASS_BITS) | classMask; }
+
+static inline void util_merge_token(SyncToken* pToken, uint64_t counter, uint32_t tokenClass)
+{
+	if (pToken)
+	{
+		*pToken = combineSyncTokens(*pToken, util_make_token(counter, 1u << tokenClass));
+	}
+}
+
+static bool util_is_token_reached(tfrg_atomic64_t* pClassCounters, SyncToken token)
+{
+	const uint64_t counter = util_get_token_counter(token);
+	for (uint32_t tokenClass = 0; tokenClass < SYNC_TOKEN_CLASS_COUNT; ++tokenClass)
+	{
+		if ((token & (1u << tokenClass)) && counter > tfrg_atomic64_load_acquire(&pClassCounters[tokenClass]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/// Token of every class up to the counter all classes reached
+static SyncToken util_get_last_token(tfrg_atomic64_t* pClassCounters)
+{
+	uint64_t counter = UINT64_MAX;
+	for (uint32_t tokenClass = 0; tokenClass < SYNC_TOKEN_CLASS_COUNT; ++tokenClass)
+	{
+		counter = min(counter, tfrg_atomic64_load_acquire(&pClassCounters[tokenClass]));
+	}
+	return util_make_token(counter, SYNC_TOKEN_ALL_CLASSES);
+}
+
 static uint32_t util_get_texture_row_alignment(Renderer* pRenderer)
 {
 	return max(1u, pRenderer->pActiveGpuSettings->mUploadBufferTextureRowAlignment);
@@ -492,13 +619,73 @@ static MappedMemoryRange allocateUploadMemory(Renderer* pRenderer, uint64_t memo
 	return { (uint8_t*)buffer->pCpuMappedAddress, buffer, 0, memoryRequirement };
 }
 
-static void setupCopyEngine(Renderer* pRenderer, CopyEngine* pCopyEngine, uint32_t nodeIndex, uint64_t size, uint32_t bufferCount)
+/// Returns a free staging page of at least size bytes, creates one if the pool has none
+static Buffer* acquireStagingPage(Renderer* pRenderer, CopyEngine* pCopyEngine, uint64_t size)
+{
+	// Best fit, so oversized pages are kept for oversized allocations
+	size_t bestIndex = SIZE_MAX;
+	for (size_t i = 0; i < pCopyEngine->mFreePages.size(); ++i)
+	{
+		const Buffer* pPage = pCopyEngine->mFreePages[i].pBuffer;
+		if (pPage->mSize >= size && (SIZE_MAX == bestIndex || pPage->mSize < pCopyEngine->mFreePages[bestIndex].pBuffer->mSize))
+		{
+			bestIndex = i;
+		}
+	}
+
+	if (SIZE_MAX != bestIndex)
+	{
+		Buffer* pPage = pCopyEngine->mFreePages[bestIndex].pBuffer;
+		pCopyEngine->mFreePages.erase_unsorted(pCopyEngine->mFreePages.begin() + bestIndex);
+		return pPage;
+	}
+
+	const uint64_t pageSize = round_up_64(size, pCopyEngine->pageSize);
+	Buffer* pPage = allocateUploadMemory(pRenderer, pageSize, util_get_texture_subresource_alignment(pRenderer)).pBuffer;
+	++pCopyEngine->pageCount;
+
+	CopyEngineStats& stats = pCopyEngine->mStats;
+	tfrg_atomic32_add_relaxed(&stats.mStagingPageAllocations, 1);
+	const uint64_t bytesAllocated = tfrg_atomic64_add_relaxed(&stats.mStagingBytesAllocated, pageSize) + pageSize;
+	tfrg_atomic64_max_relaxed(&stats.mStagingPeakBytesAllocated, bytesAllocated);
+	return pPage;
+}
+
+/// Releases pages above the resident minimum that stayed unused for longer than the shrink delay
+static void trimStagingPages(Renderer* pRenderer, CopyEngine* pCopyEngine)
+{
+	if (!pCopyEngine->shrinkDelay)
+	{
+		return;
+	}
+
+	for (size_t i = 0; i < pCopyEngine->mFreePages.size() && pCopyEngine->pageCount > pCopyEngine->minPageCount;)
+	{
+		StagingPage& page = pCopyEngine->mFreePages[i];
+		if (pCopyEngine->cycle - page.mLastUsedCycle <= pCopyEngine->shrinkDelay)
+		{
+			++i;
+			continue;
+		}
+
+		CopyEngineStats& stats = pCopyEngine->mStats;
+		tfrg_atomic32_add_relaxed(&stats.mStagingPageReleases, 1);
+		tfrg_atomic64_add_relaxed(&stats.mStagingBytesAllocated, -(int64_t)page.pBuffer->mSize);
+
+		vk_removeBuffer(pRenderer, page.pBuffer);
+		--pCopyEngine->pageCount;
+		pCopyEngine->mFreePages.erase_unsorted(pCopyEngine->mFreePages.begin() + i);
+	}
+}
+
+static void setupCopyEngine(Renderer* pRenderer, CopyEngine* pCopyEngine, uint32_t nodeIndex, const ResourceLoaderDesc* pDesc)
 {
 	QueueDesc desc = { QUEUE_TYPE_TRANSFER, QUEUE_FLAG_NONE, QUEUE_PRIORITY_NORMAL, nodeIndex };
 	vk_addQueue(pRenderer, &desc, &pCopyEngine->pQueue);
 
 	const uint64_t maxBlockSize = 32;
-	size = max(size, maxBlockSize);
+	const uint64_t size = max(pDesc->mBufferSize, maxBlockSize);
+	const uint32_t bufferCount = pDesc->mBufferCount;
 
 	pCopyEngine->resourceSets = (CopyResourceSet*)tf_malloc(sizeof(CopyResourceSet) * bufferCount);
 	for (uint32_t i = 0; i < bufferCount; ++i)
@@ -520,8 +707,6 @@ static void setupCopyEngine(Renderer* pRenderer, CopyEngine* pCopyEngine, uint32
 		vk_addCmd(pRenderer, &cmdDesc, &resourceSet.pCmd);
 
 		vk_addSemaphore(pRenderer, &resourceSet.pCopyCompletedSemaphore);
-
-		resourceSet.mBuffer = allocateUploadMemory(pRenderer, size, util_get_texture_subresource_alignment(pRenderer)).pBuffer;
 	}
 
 	pCopyEngine->bufferSize = size;
@@ -529,6 +714,21 @@ static void setupCopyEngine(Renderer* pRenderer, CopyEngine* pCopyEngine, uint32
 	pCopyEngine->nodeIndex = nodeIndex;
 	pCopyEngine->isRecording = false;
 	pCopyEngine->pLastCompletedSemaphore = NULL;
+
+	pCopyEngine->pageSize = pDesc->mStagingPageSize ? max(pDesc->mStagingPageSize, maxBlockSize) : size;
+	pCopyEngine->pageCount = 0;
+	pCopyEngine->minPageCount = pDesc->mStagingMinPageCount ? pDesc->mStagingMinPageCount : bufferCount;
+	pCopyEngine->shrinkDelay = pDesc->mStagingShrinkDelay;
+	pCopyEngine->cycle = 0;
+	pCopyEngine->mStats = {};
+
+	// Resident pages, allocated up front so the first loads do not hit the driver
+	for (uint32_t i = 0; i < pCopyEngine->minPageCount; ++i)
+	{
+		StagingPage page = { acquireStagingPage(pRenderer, pCopyEngine, pCopyEngine->pageSize), 0 };
+		pCopyEngine->mFreePages.push_back(page);
+	}
+	tfrg_atomic32_store_relaxed(&pCopyEngine->mStats.mStagingPageAllocations, 0);
 }
 
 static void cleanupCopyEngine(Renderer* pRenderer, CopyEngine* pCopyEngine)
@@ -536,7 +736,11 @@ static void cleanupCopyEngine(Renderer* pRenderer, CopyEngine* pCopyEngine)
 	for (uint32_t i = 0; i < pCopyEngine->bufferCount; ++i)
 	{
 		CopyResourceSet& resourceSet = pCopyEngine->resourceSets[i];
-		vk_removeBuffer(pRenderer, resourceSet.mBuffer);
+		for (Buffer* pPage : resourceSet.mPages)
+		{
+			vk_removeBuffer(pRenderer, pPage);
+		}
+		resourceSet.mPages.set_capacity(0);
 
 		vk_removeSemaphore(pRenderer, resourceSet.pCopyCompletedSemaphore);
 
@@ -558,6 +762,12 @@ static void cleanupCopyEngine(Renderer* pRenderer, CopyEngine* pCopyEngine)
 
 	tf_free(pCopyEngine->resourceSets);
 
+	for (StagingPage& page : pCopyEngine->mFreePages)
+	{
+		vk_removeBuffer(pRenderer, page.pBuffer);
+	}
+	pCopyEngine->mFreePages.set_capacity(0);
+
 	vk_removeQueue(pRenderer, pCopyEngine->pQueue);
 }
 
@@ -592,7 +802,21 @@ static bool waitCopyEngineSet(Renderer* pRenderer, CopyEngine* pCopyEngine, size
 static void resetCopyEngineSet(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet)
 {
 	ASSERT(!pCopyEngine->isRecording);
-	pCopyEngine->resourceSets[activeSet].mAllocatedSpace = 0;
+	CopyResourceSet& resourceSet = pCopyEngine->resourceSets[activeSet];
+	++pCopyEngine->cycle;
+
+	// Hand the pages back to the pool
+	for (Buffer* pPage : resourceSet.mPages)
+	{
+		StagingPage page = { pPage, pCopyEngine->cycle };
+		pCopyEngine->mFreePages.push_back(page);
+	}
+	resourceSet.mPages.clear();
+	tfrg_atomic64_add_relaxed(&pCopyEngine->mStats.mStagingBytesInUse, -(int64_t)resourceSet.mAllocatedSpace);
+	trimStagingPages(pRenderer, pCopyEngine);
+
+	resourceSet.mPageOffset = 0;
+	resourceSet.mAllocatedSpace = 0;
 	pCopyEngine->isRecording = false;
 
 	for (Buffer*& buffer : pCopyEngine->resourceSets[activeSet].mTempBuffers)
@@ -639,94 +863,128 @@ static void streamerFlush(CopyEngine* pCopyEngine, size_t activeSet)
 	}
 }
 
-/// Return memory from pre-allocated staging buffer or create a temporary buffer if the streamer ran out of memory
+/// Sub-allocate from the staging pages of the active set, takes a new page from the pool when the last one is full
 static MappedMemoryRange allocateStagingMemory(uint64_t memoryRequirement, uint32_t alignment, uint32_t nodeIndex)
 {
-	CopyEngine* pCopyEngine = &pResourceLoader->pCopyEngines[nodeIndex];
+	CopyEngine*      pCopyEngine = &pResourceLoader->pCopyEngines[nodeIndex];
+	CopyResourceSet* pResourceSet = &pCopyEngine->resourceSets[pResourceLoader->mNextSet];
 
-	uint64_t offset = pCopyEngine->resourceSets[pResourceLoader->mNextSet].mAllocatedSpace;
+	uint64_t offset = pResourceSet->mPageOffset;
 	if (alignment != 0)
 	{
 		offset = round_up_64(offset, alignment);
 	}
 
-	CopyResourceSet* pResourceSet = &pCopyEngine->resourceSets[pResourceLoader->mNextSet];
-	uint64_t         size = (uint64_t)pResourceSet->mBuffer->mSize;
-	bool             memoryAvailable = (offset < size) && (memoryRequirement <= size - offset);
-	if (memoryAvailable && pResourceSet->mBuffer->pCpuMappedAddress)
+	Buffer* pPage = pResourceSet->mPages.empty() ? NULL : pResourceSet->mPages.back();
+	if (!pPage || offset >= pPage->mSize || memoryRequirement > pPage->mSize - offset)
 	{
-		Buffer* buffer = pResourceSet->mBuffer;
-		ASSERT(buffer->pCpuMappedAddress);
-		uint8_t* pDstData = (uint8_t*)buffer->pCpuMappedAddress + offset;
-		pCopyEngine->resourceSets[pResourceLoader->mNextSet].mAllocatedSpace = offset + memoryRequirement;
-		return { pDstData, buffer, offset, memoryRequirement };
-	}
-	else
-	{
-		if (pCopyEngine->bufferSize < memoryRequirement)
+		// Allocations larger than a page get a contiguous multi-page block which goes back to the pool like any other page
+		if (memoryRequirement > pCopyEngine->pageSize)
 		{
-			MappedMemoryRange range = allocateUploadMemory(pResourceLoader->ppRenderers[nodeIndex], memoryRequirement, alignment);
-			//LOGF(LogLevel::eINFO, "Allocating temporary staging buffer. Required allocation size of %llu is larger than the staging buffer capacity of %llu", memoryRequirement, size);
-			pResourceSet->mTempBuffers.emplace_back(range.pBuffer);
-			return range;
+			tfrg_atomic32_add_relaxed(&pCopyEngine->mStats.mStagingOversizedAllocations, 1);
 		}
+
+		pPage = acquireStagingPage(pResourceLoader->ppRenderers[nodeIndex], pCopyEngine, memoryRequirement);
+		pResourceSet->mPages.push_back(pPage);
+		offset = 0;
 	}
 
-	MappedMemoryRange range = allocateUploadMemory(pResourceLoader->ppRenderers[nodeIndex], memoryRequirement, alignment);
-	//LOGF(LogLevel::eINFO, "Allocating temporary staging buffer. Required allocation size of %llu is larger than the staging buffer capacity of %llu", memoryRequirement, size);
-	pResourceSet->mTempBuffers.emplace_back(range.pBuffer);
-	return range;
+	ASSERT(pPage->pCpuMappedAddress);
+	pResourceSet->mPageOffset = offset + memoryRequirement;
+	pResourceSet->mAllocatedSpace += memoryRequirement;
+
+	CopyEngineStats& stats = pCopyEngine->mStats;
+	const uint64_t   bytesInUse = tfrg_atomic64_add_relaxed(&stats.mStagingBytesInUse, memoryRequirement) + memoryRequirement;
+	tfrg_atomic64_max_relaxed(&stats.mStagingPeakBytesInUse, bytesInUse);
+
+	return { (uint8_t*)pPage->pCpuMappedAddress + offset, pPage, offset, memoryRequirement };
+}
+
+/// Whether the staging memory budget of the set is used up
+static bool isCopyEngineSetFull(const CopyEngine* pCopyEngine, size_t activeSet)
+{
+	const CopyResourceSet& resourceSet = pCopyEngine->resourceSets[activeSet];
+	return resourceSet.mAllocatedSpace >= pCopyEngine->bufferSize;
 }
 
 static void freeAllUploadMemory()
 {
+	if (pResourceLoader->pDecodeThreadSystem)
+	{
+		// Held back decodes never start, the ones handed out have to finish before their requests are freed
+		acquireMutex(&pResourceLoader->mDecodeMutex);
+		pResourceLoader->mPendingDecodeTasks.clear();
+		releaseMutex(&pResourceLoader->mDecodeMutex);
+		waitThreadSystemIdle(pResourceLoader->pDecodeThreadSystem);
+	}
+
 	for (size_t i = 0; i < MAX_MULTIPLE_GPUS; ++i)
 	{
-		for (UpdateRequest& request : pResourceLoader->mRequestQueue[i])
+		for (uint32_t priority = 0; priority < RESOURCE_PRIORITY_COUNT; ++priority)
 		{
-			if (request.pUploadBuffer)
+			for (UpdateRequest& request : pResourceLoader->mRequestQueue[i][priority])
 			{
-				vk_removeBuffer(pResourceLoader->ppRenderers[i], request.pUploadBuffer);
+				if (request.pUploadBuffer)
+				{
+					vk_removeBuffer(pResourceLoader->ppRenderers[i], request.pUploadBuffer);
+				}
+
+				if (request.pDecodeTask)
+				{
+					removeDecodeTask(request.pDecodeTask, false);
+				}
+
+				// Texture upload split across sets that did not finish
+				if (UPDATE_REQUEST_UPDATE_TEXTURE == request.mType && request.texUpdateDesc.mStream.pIO)
+				{
+					fsCloseStream(&request.texUpdateDesc.mStream);
+				}
 			}
 		}
 	}
 }
 
 static UploadFunctionResult
-updateTexture(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, const TextureUpdateDescInternal& texUpdateDesc)
+updateTexture(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, TextureUpdateDescInternal& texUpdateDesc)
 {
 	// When this call comes from updateResource, staging buffer data is already filled
 	// All that is left to do is record and execute the Copy commands
 	bool                  dataAlreadyFilled = texUpdateDesc.mRange.pBuffer ? true : false;
 	Texture* texture = texUpdateDesc.pTexture;
 	const TinyImageFormat fmt = (TinyImageFormat)texture->mFormat;
-	FileStream            stream = texUpdateDesc.mStream;
+	FileStream&           stream = texUpdateDesc.mStream;
 	Cmd* cmd = acquireCmd(pCopyEngine, activeSet);
 
 	ASSERT(pCopyEngine->pQueue->mNodeIndex == texUpdateDesc.pTexture->mNodeIndex);
 
 	const uint32_t sliceAlignment = util_get_texture_subresource_alignment(pRenderer, fmt);
 	const uint32_t rowAlignment = util_get_texture_row_alignment(pRenderer);
-	const uint64_t requiredSize = util_get_surface_size(
-		fmt, texture->mWidth, texture->mHeight, texture->mDepth, rowAlignment, sliceAlignment, texUpdateDesc.mBaseMipLevel,
-		texUpdateDesc.mMipLevels, texUpdateDesc.mBaseArrayLayer, texUpdateDesc.mLayerCount);
+
+	// Uploads from file are split in subresources, depth slices and block rows so that a set never records more than its staging budget.
+	// The rest continues with the next set, which bounds peak staging memory whatever the texture size
+	const CopyResourceSet& resourceSet = pCopyEngine->resourceSets[activeSet];
+	const bool             canSplit = !dataAlreadyFilled && !pResourceLoader->mDesc.mSingleThreaded && TinyImageFormat_IsSinglePlane(fmt);
+	uint64_t               budget = UINT64_MAX;
+	if (canSplit)
+	{
+		budget = pCopyEngine->bufferSize > resourceSet.mAllocatedSpace ? pCopyEngine->bufferSize - resourceSet.mAllocatedSpace : 0;
+	}
 
 #if defined(VULKAN)
 	TextureBarrier barrier;
-	if (gSelectedRendererApi == RENDERER_API_VULKAN)
+	if (gSelectedRendererApi == RENDERER_API_VULKAN && !texUpdateDesc.mInProgress)
 	{
 		barrier = { texture, RESOURCE_STATE_UNDEFINED, RESOURCE_STATE_COPY_DEST };
 		vk_cmdResourceBarrier(cmd, 0, NULL, 1, &barrier, 0, NULL);
 	}
 #endif
 
-	MappedMemoryRange upload = dataAlreadyFilled ? texUpdateDesc.mRange : allocateStagingMemory(requiredSize, sliceAlignment, texture->mNodeIndex);
-	uint64_t          offset = 0;
+	uint64_t offset = 0;
 
 	// #TODO: Investigate - fsRead crashes if we pass the upload buffer mapped address. Allocating temporary buffer as a workaround. Does NX support loading from disk to GPU shared memory?
 #ifdef NX64
 	void* nxTempBuffer = NULL;
-	if (!dataAlreadyFilled)
+	if (!dataAlreadyFilled && !texUpdateDesc.mInProgress)
 	{
 		size_t remainingBytes = fsGetStreamFileSize(&stream) - fsGetStreamSeekPosition(&stream);
 		nxTempBuffer = tf_malloc(remainingBytes);
@@ -743,64 +1001,116 @@ updateTexture(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, co
 	}
 #endif
 
-	if (!upload.pData)
-	{
-		return UPLOAD_FUNCTION_RESULT_STAGING_BUFFER_FULL;
-	}
+	texUpdateDesc.mInProgress = true;
 
 	uint32_t firstStart = texUpdateDesc.mMipsAfterSlice ? texUpdateDesc.mBaseMipLevel : texUpdateDesc.mBaseArrayLayer;
-	uint32_t firstEnd = texUpdateDesc.mMipsAfterSlice ? (texUpdateDesc.mBaseMipLevel + texUpdateDesc.mMipLevels)
-		: (texUpdateDesc.mBaseArrayLayer + texUpdateDesc.mLayerCount);
+	uint32_t firstCount = texUpdateDesc.mMipsAfterSlice ? texUpdateDesc.mMipLevels : texUpdateDesc.mLayerCount;
 	uint32_t secondStart = texUpdateDesc.mMipsAfterSlice ? texUpdateDesc.mBaseArrayLayer : texUpdateDesc.mBaseMipLevel;
-	uint32_t secondEnd = texUpdateDesc.mMipsAfterSlice ? (texUpdateDesc.mBaseArrayLayer + texUpdateDesc.mLayerCount)
-		: (texUpdateDesc.mBaseMipLevel + texUpdateDesc.mMipLevels);
+	uint32_t secondCount = texUpdateDesc.mMipsAfterSlice ? texUpdateDesc.mLayerCount : texUpdateDesc.mMipLevels;
 
-	for (uint32_t p = 0; p < 1; ++p)
+	for (; texUpdateDesc.mProgressFirst < firstCount; ++texUpdateDesc.mProgressFirst, texUpdateDesc.mProgressSecond = 0)
 	{
-		for (uint32_t j = firstStart; j < firstEnd; ++j)
+		uint32_t j = firstStart + texUpdateDesc.mProgressFirst;
+
+		for (; texUpdateDesc.mProgressSecond < secondCount; ++texUpdateDesc.mProgressSecond, texUpdateDesc.mProgressSlice = 0)
 		{
-			if (texUpdateDesc.mMipsAfterSlice && texUpdateDesc.pPreMipFunc)
+			uint32_t i = secondStart + texUpdateDesc.mProgressSecond;
+
+			uint32_t mip = texUpdateDesc.mMipsAfterSlice ? j : i;
+			uint32_t layer = texUpdateDesc.mMipsAfterSlice ? i : j;
+
+			uint32_t w = MIP_REDUCE(texture->mWidth, mip);
+			uint32_t h = MIP_REDUCE(texture->mHeight, mip);
+			uint32_t d = MIP_REDUCE(texture->mDepth, mip);
+
+			uint32_t numBytes = 0;
+			uint32_t rowBytes = 0;
+			uint32_t numRows = 0;
+
+			bool ret = util_get_surface_info(w, h, fmt, &numBytes, &rowBytes, &numRows);
+			if (!ret)
 			{
-				texUpdateDesc.pPreMipFunc(&stream, j);
+				return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
 			}
 
-			for (uint32_t i = secondStart; i < secondEnd; ++i)
+			uint32_t subRowPitch = round_up(rowBytes, rowAlignment);
+			uint32_t subSlicePitch = round_up(subRowPitch * numRows, sliceAlignment);
+			uint32_t subRowSize = rowBytes;
+
+			while (texUpdateDesc.mProgressSlice < d)
 			{
-				if (!texUpdateDesc.mMipsAfterSlice && texUpdateDesc.pPreMipFunc)
+				const uint32_t slice = texUpdateDesc.mProgressSlice;
+				const uint32_t row = texUpdateDesc.mProgressRow;
+
+				// Largest piece of the subresource that fits: remaining slices, some slices or some rows of one slice.
+				// A slice only goes as a whole if its aligned pitch fits, otherwise even all of its rows are copied as a row range
+				const bool fullSlices = !row && subSlicePitch <= budget;
+				uint32_t   sliceCount = 1;
+				uint32_t   rowCount = 0;
+				if (fullSlices)
 				{
-					texUpdateDesc.pPreMipFunc(&stream, i);
+					sliceCount = (uint32_t)min((uint64_t)(d - slice), budget / subSlicePitch);
+					rowCount = numRows;
+				}
+				else
+				{
+					rowCount = (uint32_t)min((uint64_t)(numRows - row), budget / subRowPitch);
 				}
 
-				uint32_t mip = texUpdateDesc.mMipsAfterSlice ? j : i;
-				uint32_t layer = texUpdateDesc.mMipsAfterSlice ? i : j;
-
-				uint32_t w = MIP_REDUCE(texture->mWidth, mip);
-				uint32_t h = MIP_REDUCE(texture->mHeight, mip);
-				uint32_t d = MIP_REDUCE(texture->mDepth, mip);
+				if (!rowCount)
+				{
+					if (resourceSet.mAllocatedSpace)
+					{
+						return UPLOAD_FUNCTION_RESULT_STAGING_NOT_READY;
+					}
+					// Always make progress on an empty set, even if a single row is larger than the budget
+					rowCount = 1;
+				}
 
-				uint32_t numBytes = 0;
-				uint32_t rowBytes = 0;
-				uint32_t numRows = 0;
+				const uint64_t chunkSize = fullSlices ? (uint64_t)sliceCount * subSlicePitch : (uint64_t)rowCount * subRowPitch;
 
-				bool ret = util_get_surface_info(w, h, fmt, &numBytes, &rowBytes, &numRows);
-				if (!ret)
+				MappedMemoryRange upload = {};
+				if (dataAlreadyFilled)
 				{
-					return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+					upload = texUpdateDesc.mRange;
+					upload.pData += offset;
+					upload.mOffset += offset;
+					offset += chunkSize;
 				}
+				else
+				{
+					upload = allocateStagingMemory(chunkSize, sliceAlignment, texture->mNodeIndex);
+					if (!upload.pData)
+					{
+						return UPLOAD_FUNCTION_RESULT_STAGING_BUFFER_FULL;
+					}
 
-				uint32_t subRowPitch = round_up(rowBytes, rowAlignment);
-				uint32_t subSlicePitch = round_up(subRowPitch * numRows, sliceAlignment);
-				uint32_t subNumRows = numRows;
-				uint32_t subDepth = d;
-				uint32_t subRowSize = rowBytes;
-				uint8_t* data = upload.pData + offset;
+					// Only consume the stream once the staging memory is there, a retry would skip the data again
+					if (!slice && !row && texUpdateDesc.mSkipMipBytes &&
+						(texUpdateDesc.mMipsAfterSlice ? !texUpdateDesc.mProgressFirst && !texUpdateDesc.mProgressSecond : !texUpdateDesc.mProgressSecond))
+					{
+						if (!fsSeekStream(&stream, SBO_CURRENT_POSITION, (ssize_t)texUpdateDesc.mSkipMipBytes))
+						{
+							return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+						}
+					}
 
-				if (!dataAlreadyFilled)
-				{
-					for (uint32_t z = 0; z < subDepth; ++z)
+					if (!slice && !row && texUpdateDesc.pPreMipFunc)
+					{
+						if (texUpdateDesc.mMipsAfterSlice && !texUpdateDesc.mProgressSecond)
+						{
+							texUpdateDesc.pPreMipFunc(&stream, j);
+						}
+						else if (!texUpdateDesc.mMipsAfterSlice)
+						{
+							texUpdateDesc.pPreMipFunc(&stream, i);
+						}
+					}
+
+					for (uint32_t z = 0; z < sliceCount; ++z)
 					{
-						uint8_t* dstData = data + subSlicePitch * z;
-						for (uint32_t r = 0; r < subNumRows; ++r)
+						uint8_t* dstData = upload.pData + subSlicePitch * z;
+						for (uint32_t r = 0; r < rowCount; ++r)
 						{
 							ssize_t bytesRead = fsReadFromStream(&stream, dstData + r * subRowPitch, subRowSize);
 							if (bytesRead != subRowSize)
@@ -810,16 +1120,34 @@ updateTexture(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, co
 						}
 					}
 				}
+
 				SubresourceDataDesc subresourceDesc = {};
 				subresourceDesc.mArrayLayer = layer;
 				subresourceDesc.mMipLevel = mip;
-				subresourceDesc.mSrcOffset = upload.mOffset + offset;
+				subresourceDesc.mSrcOffset = upload.mOffset;
 #if defined(DIRECT3D11) || defined(METAL) || defined(VULKAN)
 				subresourceDesc.mRowPitch = subRowPitch;
-				subresourceDesc.mSlicePitch = subSlicePitch;
+				subresourceDesc.mSlicePitch = fullSlices ? subSlicePitch : rowCount * subRowPitch;
 #endif
+				if (sliceCount != d || !fullSlices)
+				{
+					subresourceDesc.mDepthOffset = slice;
+					subresourceDesc.mDepthCount = sliceCount;
+					subresourceDesc.mRowOffset = fullSlices ? 0 : row;
+					subresourceDesc.mRowCount = fullSlices ? 0 : rowCount;
+				}
 				vk_cmdUpdateSubresource(cmd, texture, upload.pBuffer, &subresourceDesc);
-				offset += subDepth * subSlicePitch;
+
+				budget -= min(budget, chunkSize);
+				if (fullSlices)
+				{
+					texUpdateDesc.mProgressSlice += sliceCount;
+				}
+				else if ((texUpdateDesc.mProgressRow += rowCount) == numRows)
+				{
+					texUpdateDesc.mProgressRow = 0;
+					++texUpdateDesc.mProgressSlice;
+				}
 			}
 		}
 	}
@@ -840,7 +1168,220 @@ updateTexture(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, co
 	return UPLOAD_FUNCTION_RESULT_COMPLETED;
 }
 
-static UploadFunctionResult loadTexture(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, const UpdateRequest& pTextureUpdate)
+static TextureContainerType util_get_texture_container(const TextureLoadDesc* pTextureDesc)
+{
+	TextureContainerType container = pTextureDesc->mContainer;
+	if (TEXTURE_CONTAINER_DEFAULT == container)
+	{
+#if defined(TARGET_IOS) || defined(__ANDROID__) || defined(NX64)
+		container = TEXTURE_CONTAINER_KTX;
+#elif defined(_WINDOWS) || defined(XBOX) || defined(__APPLE__) || defined(__linux__)
+		container = TEXTURE_CONTAINER_DDS;
+#elif defined(ORBIS) || defined(PROSPERO)
+		container = TEXTURE_CONTAINER_GNF;
+#endif
+	}
+	return container;
+}
+
+static void util_get_texture_file_name(const TextureLoadDesc* pTextureDesc, TextureContainerType container, char* fileName)
+{
+	static const char* extensions[] = { NULL, "dds", "ktx", "gnf", "basis", "svt" };
+	fsAppendPathExtension(pTextureDesc->pFileName, extensions[container], fileName);
+}
+
+/// Containers whose header parsing and payload read can run away from the streamer thread
+static bool util_is_texture_decodable(const TextureLoadDesc* pTextureDesc)
+{
+	if (!pTextureDesc->pFileName)
+	{
+		return false;
+	}
+
+	switch (util_get_texture_container(pTextureDesc))
+	{
+#if !defined(XBOX)
+	case TEXTURE_CONTAINER_DDS:
+#endif
+	case TEXTURE_CONTAINER_KTX:
+	case TEXTURE_CONTAINER_BASIS: return true;
+	default: return false;
+	}
+}
+
+/// Opens the texture file and parses its header
+/// If readPayload is set, the remaining file contents are read into memory so that the streamer only has to memcpy them into staging memory
+static bool decodeTexture(const TextureLoadDesc* pTextureDesc, bool readPayload, TextureDecodeDesc* pOut)
+{
+	ASSERT(util_is_texture_decodable(pTextureDesc));
+
+	const TextureContainerType container = util_get_texture_container(pTextureDesc);
+	char                       fileName[FS_MAX_PATH] = {};
+	util_get_texture_file_name(pTextureDesc, container, fileName);
+
+	FileStream   stream = {};
+	TextureDesc& textureDesc = pOut->mDesc;
+	textureDesc = {};
+	textureDesc.pName = pTextureDesc->pFileName;
+	textureDesc.mFlags |= pTextureDesc->mCreationFlag;
+
+	bool success = fsOpenStreamFromPath(RD_TEXTURES, fileName, FM_READ_BINARY, pTextureDesc->pFilePassword, &stream);
+	if (!success)
+	{
+		return false;
+	}
+
+	switch (container)
+	{
+	case TEXTURE_CONTAINER_DDS:
+	{
+		success = loadDDSTextureDesc(&stream, &textureDesc);
+		break;
+	}
+	case TEXTURE_CONTAINER_KTX:
+	{
+		success = loadKTXTextureDesc(&stream, &textureDesc);
+		pOut->mMipsAfterSlice = true;
+		// KTX stores mip size before the mip data
+		// This function gets called to skip the mip size so we read the mip data
+		pOut->pPreMipFunc = [](FileStream* pStream, uint32_t) {
+			uint32_t mipSize = 0;
+			fsReadFromStream(pStream, &mipSize, sizeof(mipSize));
+		};
+		break;
+	}
+	case TEXTURE_CONTAINER_BASIS:
+	{
+		void*    data = NULL;
+		uint32_t dataSize = 0;
+		success = loadBASISTextureDesc(&stream, &textureDesc, &data, &dataSize);
+		if (success)
+		{
+			// Transcoded data is already in memory
+			fsCloseStream(&stream);
+			fsOpenStreamFromMemory(data, dataSize, FM_READ_BINARY, true, &stream);
+			readPayload = false;
+		}
+		break;
+	}
+	default: success = false; break;
+	}
+
+	if (success && readPayload)
+	{
+		ssize_t payloadSize = fsGetStreamFileSize(&stream) - fsGetStreamSeekPosition(&stream);
+		void*   payload = tf_malloc(max<ssize_t>(payloadSize, 1));
+		success = fsReadFromStream(&stream, payload, payloadSize) == payloadSize;
+		fsCloseStream(&stream);
+		if (success)
+		{
+			fsOpenStreamFromMemory(payload, payloadSize, FM_READ_BINARY, true, &stream);
+		}
+		else
+		{
+			tf_free(payload);
+			return false;
+		}
+	}
+
+	if (!success)
+	{
+		fsCloseStream(&stream);
+		return false;
+	}
+
+	pOut->mStream = stream;
+	return true;
+}
+
+/// Size of the top skipMipLevels mips as stored in a texture file
+static uint64_t util_get_skipped_mip_bytes(const TextureDecodeDesc* pDecodeDesc, uint32_t skipMipLevels)
+{
+	const TextureDesc& desc = pDecodeDesc->mDesc;
+	uint64_t           bytes = 0;
+	for (uint32_t mip = 0; mip < skipMipLevels; ++mip)
+	{
+		uint32_t numBytes = 0;
+		uint32_t rowBytes = 0;
+		uint32_t numRows = 0;
+		util_get_surface_info(MIP_REDUCE(desc.mWidth, mip), MIP_REDUCE(desc.mHeight, mip), desc.mFormat, &numBytes, &rowBytes, &numRows);
+
+		const uint64_t mipBytes = (uint64_t)numBytes * MIP_REDUCE(desc.mDepth, mip);
+		if (pDecodeDesc->mMipsAfterSlice)
+		{
+			// Every mip of a ktx starts with its size
+			bytes += mipBytes * desc.mArraySize + (pDecodeDesc->pPreMipFunc ? sizeof(uint32_t) : 0);
+		}
+		else
+		{
+			bytes += mipBytes;
+		}
+	}
+	return bytes;
+}
+
+/// Creates the texture described by a decoded header and records the copy of its payload
+static UploadFunctionResult loadDecodedTexture(
+	Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, UpdateRequest& pTextureUpdate, TextureDecodeDesc* pDecodeDesc)
+{
+	const TextureLoadDesc* pTextureDesc = &pTextureUpdate.texLoadDesc;
+	TextureDesc& textureDesc = pDecodeDesc->mDesc;
+	textureDesc.mStartState = RESOURCE_STATE_COMMON;
+	textureDesc.mNodeIndex = pTextureDesc->mNodeIndex;
+
+	if (pTextureDesc->mCreationFlag & TEXTURE_CREATION_FLAG_SRGB)
+	{
+		TinyImageFormat srgbFormat = TinyImageFormat_ToSRGB(textureDesc.mFormat);
+		if (srgbFormat != TinyImageFormat_UNDEFINED)
+			textureDesc.mFormat = srgbFormat;
+		else
+		{
+			LOGF(eWARNING,
+				"Trying to load '%s' image using SRGB profile. "
+				"But image has '%s' format, which doesn't have SRGB counterpart.",
+				pTextureDesc->pFileName, TinyImageFormat_Name(textureDesc.mFormat));
+		}
+	}
+
+#if defined(VULKAN)
+	if (NULL != pTextureDesc->pDesc)
+		textureDesc.pVkSamplerYcbcrConversionInfo = pTextureDesc->pDesc->pVkSamplerYcbcrConversionInfo;
+#endif
+	uint64_t skipMipBytes = 0;
+	if (pTextureDesc->mSkipMipLevels && textureDesc.mMipLevels > 1)
+	{
+		const uint32_t skipMipLevels = min(pTextureDesc->mSkipMipLevels, textureDesc.mMipLevels - 1);
+		skipMipBytes = util_get_skipped_mip_bytes(pDecodeDesc, skipMipLevels);
+		textureDesc.mWidth = MIP_REDUCE(textureDesc.mWidth, skipMipLevels);
+		textureDesc.mHeight = MIP_REDUCE(textureDesc.mHeight, skipMipLevels);
+		textureDesc.mDepth = MIP_REDUCE(textureDesc.mDepth, skipMipLevels);
+		textureDesc.mMipLevels -= skipMipLevels;
+	}
+
+	vk_addTexture(pRenderer, &textureDesc, pTextureDesc->ppTexture);
+
+	TextureUpdateDescInternal updateDesc = {};
+	updateDesc.mStream = pDecodeDesc->mStream;
+	updateDesc.pTexture = *pTextureDesc->ppTexture;
+	updateDesc.mBaseMipLevel = 0;
+	updateDesc.mMipLevels = textureDesc.mMipLevels;
+	updateDesc.mBaseArrayLayer = 0;
+	updateDesc.mLayerCount = textureDesc.mArraySize;
+	updateDesc.pPreMipFunc = pDecodeDesc->pPreMipFunc;
+	updateDesc.mMipsAfterSlice = pDecodeDesc->mMipsAfterSlice;
+	updateDesc.mSkipMipBytes = skipMipBytes;
+
+	UploadFunctionResult result = updateTexture(pRenderer, pCopyEngine, activeSet, updateDesc);
+	if (UPLOAD_FUNCTION_RESULT_STAGING_NOT_READY == result)
+	{
+		// The texture exists now, the rest of the upload continues as a regular texture update
+		pTextureUpdate.mType = UPDATE_REQUEST_UPDATE_TEXTURE;
+		pTextureUpdate.texUpdateDesc = updateDesc;
+	}
+	return result;
+}
+
+static UploadFunctionResult loadTexture(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, UpdateRequest& pTextureUpdate)
 {
 	const TextureLoadDesc* pTextureDesc = &pTextureUpdate.texLoadDesc;
 
@@ -850,26 +1391,34 @@ static UploadFunctionResult loadTexture(Renderer* pRenderer, CopyEngine* pCopyEn
 		"Please change format of the provided texture if you need srgb format."
 	);
 
+	if (pTextureUpdate.pDecodeTask)
+	{
+		// Header and payload were already read by a decode worker
+		ResourceDecodeTask* pDecodeTask = pTextureUpdate.pDecodeTask;
+		if (!pDecodeTask->mSuccess)
+		{
+			return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+		}
+		return loadDecodedTexture(pRenderer, pCopyEngine, activeSet, pTextureUpdate, &pDecodeTask->mTexture);
+	}
+
+	if (util_is_texture_decodable(pTextureDesc))
+	{
+		TextureDecodeDesc decodeDesc = {};
+		if (!decodeTexture(pTextureDesc, false, &decodeDesc))
+		{
+			return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+		}
+		return loadDecodedTexture(pRenderer, pCopyEngine, activeSet, pTextureUpdate, &decodeDesc);
+	}
+
 	if (pTextureDesc->pFileName)
 	{
 		FileStream stream = {};
 		char       fileName[FS_MAX_PATH] = {};
 		bool       success = false;
 
-		TextureUpdateDescInternal updateDesc = {};
-		TextureContainerType      container = pTextureDesc->mContainer;
-		static const char* extensions[] = { NULL, "dds", "ktx", "gnf", "basis", "svt" };
-
-		if (TEXTURE_CONTAINER_DEFAULT == container)
-		{
-#if defined(TARGET_IOS) || defined(__ANDROID__) || defined(NX64)
-			container = TEXTURE_CONTAINER_KTX;
-#elif defined(_WINDOWS) || defined(XBOX) || defined(__APPLE__) || defined(__linux__)
-			container = TEXTURE_CONTAINER_DDS;
-#elif defined(ORBIS) || defined(PROSPERO)
-			container = TEXTURE_CONTAINER_GNF;
-#endif
-		}
+		TextureContainerType container = util_get_texture_container(pTextureDesc);
 
 		TextureDesc textureDesc = {};
 		textureDesc.pName = pTextureDesc->pFileName;
@@ -882,13 +1431,13 @@ static UploadFunctionResult loadTexture(Renderer* pRenderer, CopyEngine* pCopyEn
 			return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
 		}
 
-		fsAppendPathExtension(pTextureDesc->pFileName, extensions[container], fileName);
+		util_get_texture_file_name(pTextureDesc, container, fileName);
 
 		switch (container)
 		{
+#if defined(XBOX)
 		case TEXTURE_CONTAINER_DDS:
 		{
-#if defined(XBOX)
 			success = fsOpenStreamFromPath(RD_TEXTURES, fileName, FM_READ_BINARY, pTextureDesc->pFilePassword, &stream);
 			uint32_t res = 1;
 			if (success)
@@ -900,47 +1449,8 @@ static UploadFunctionResult loadTexture(Renderer* pRenderer, CopyEngine* pCopyEn
 			}
 
 			return res ? UPLOAD_FUNCTION_RESULT_INVALID_REQUEST : UPLOAD_FUNCTION_RESULT_COMPLETED;
-#else
-			success = fsOpenStreamFromPath(RD_TEXTURES, fileName, FM_READ_BINARY, pTextureDesc->pFilePassword, &stream);
-			if (success)
-			{
-				success = loadDDSTextureDesc(&stream, &textureDesc);
-			}
-#endif
-			break;
-		}
-		case TEXTURE_CONTAINER_KTX:
-		{
-			success = fsOpenStreamFromPath(RD_TEXTURES, fileName, FM_READ_BINARY, pTextureDesc->pFilePassword, &stream);
-			if (success)
-			{
-				success = loadKTXTextureDesc(&stream, &textureDesc);
-				updateDesc.mMipsAfterSlice = true;
-				// KTX stores mip size before the mip data
-				// This function gets called to skip the mip size so we read the mip data
-				updateDesc.pPreMipFunc = [](FileStream* pStream, uint32_t) {
-					uint32_t mipSize = 0;
-					fsReadFromStream(pStream, &mipSize, sizeof(mipSize));
-				};
-			}
-			break;
-		}
-		case TEXTURE_CONTAINER_BASIS:
-		{
-			void* data = NULL;
-			uint32_t dataSize = 0;
-			success = fsOpenStreamFromPath(RD_TEXTURES, fileName, FM_READ_BINARY, pTextureDesc->pFilePassword, &stream);
-			if (success)
-			{
-				success = loadBASISTextureDesc(&stream, &textureDesc, &data, &dataSize);
-				if (success)
-				{
-					fsCloseStream(&stream);
-					fsOpenStreamFromMemory(data, dataSize, FM_READ_BINARY, true, &stream);
-				}
-			}
-			break;
 		}
+#endif
 		case TEXTURE_CONTAINER_GNF:
 		{
 #if defined(ORBIS) || defined(PROSPERO)
@@ -959,41 +1469,6 @@ static UploadFunctionResult loadTexture(Renderer* pRenderer, CopyEngine* pCopyEn
 		}
 		default: break;
 		}
-
-		if (success)
-		{
-			textureDesc.mStartState = RESOURCE_STATE_COMMON;
-			textureDesc.mNodeIndex = pTextureDesc->mNodeIndex;
-
-			if (pTextureDesc->mCreationFlag & TEXTURE_CREATION_FLAG_SRGB)
-			{
-				TinyImageFormat srgbFormat = TinyImageFormat_ToSRGB(textureDesc.mFormat);
-				if (srgbFormat != TinyImageFormat_UNDEFINED)
-					textureDesc.mFormat = srgbFormat;
-				else
-				{
-					LOGF(eWARNING,
-						"Trying to load '%s' image using SRGB profile. "
-						"But image has '%s' format, which doesn't have SRGB counterpart.",
-						pTextureDesc->pFileName, TinyImageFormat_Name(textureDesc.mFormat));
-				}
-			}
-
-#if defined(VULKAN)
-			if (NULL != pTextureDesc->pDesc)
-				textureDesc.pVkSamplerYcbcrConversionInfo = pTextureDesc->pDesc->pVkSamplerYcbcrConversionInfo;
-#endif
-			vk_addTexture(pRenderer, &textureDesc, pTextureDesc->ppTexture);
-
-			updateDesc.mStream = stream;
-			updateDesc.pTexture = *pTextureDesc->ppTexture;
-			updateDesc.mBaseMipLevel = 0;
-			updateDesc.mMipLevels = textureDesc.mMipLevels;
-			updateDesc.mBaseArrayLayer = 0;
-			updateDesc.mLayerCount = textureDesc.mArraySize;
-
-			return updateTexture(pRenderer, pCopyEngine, activeSet, updateDesc);
-		}
 		/************************************************************************/
 		// Sparse Textures
 		/************************************************************************/
@@ -1060,13 +1535,128 @@ updateBuffer(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, con
 	return UPLOAD_FUNCTION_RESULT_COMPLETED;
 }
 
-static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, UpdateRequest& pGeometryLoad)
+/// Staging memory belongs to the streamer thread. Decode workers pack into system memory which the streamer copies to staging memory later,
+/// one extra copy of the packed size that is only made if ResourceLoaderDesc::mDecodeGeometryOnWorkers asks for it
+static MappedMemoryRange allocateGeometryMemory(uint64_t memoryRequirement, uint32_t alignment, uint32_t nodeIndex, bool useStagingMemory)
+{
+	if (useStagingMemory)
+	{
+		return allocateStagingMemory(memoryRequirement, alignment, nodeIndex);
+	}
+
+	return { (uint8_t*)tf_malloc((size_t)memoryRequirement), NULL, 0, memoryRequirement, MAPPED_RANGE_FLAG_CPU_MEMORY };
+}
+
+#if defined(ENABLE_MESHOPTIMIZER)
+typedef struct GeometryOptimizeDesc
+{
+	Geometry*      pGeometry;
+	uint32_t       mFlags;
+	void*          pIndices;
+	uint8_t*       pVertices[MAX_VERTEX_BINDINGS];
+	uint32_t       mVertexStrides[MAX_VERTEX_BINDINGS];
+	uint32_t       mVertexBufferCount;
+	const uint8_t* pPositions;
+	uint32_t       mPositionStride;
+} GeometryOptimizeDesc;
+
+template <typename T>
+static void util_optimize_primitive(const GeometryOptimizeDesc* pDesc, const IndirectDrawIndexArguments* pDrawArgs)
+{
+	const uint32_t indexCount = pDrawArgs->mIndexCount;
+	if (indexCount < 3)
+		return;
+
+	T* indices = (T*)pDesc->pIndices + pDrawArgs->mStartIndex;
+
+	// Work on the vertex range referenced by this primitive with zero based indices
+	uint32_t firstVertex = UINT32_MAX;
+	uint32_t lastVertex = 0;
+	for (uint32_t i = 0; i < indexCount; ++i)
+	{
+		firstVertex = min(firstVertex, (uint32_t)indices[i]);
+		lastVertex = max(lastVertex, (uint32_t)indices[i]);
+	}
+	for (uint32_t i = 0; i < indexCount; ++i)
+		indices[i] = (T)(indices[i] - firstVertex);
+
+	const uint32_t vertexCount = lastVertex - firstVertex + 1;
+
+	meshopt_Stream streams[MAX_VERTEX_BINDINGS];
+	uint32_t       maxStride = 0;
+	for (uint32_t i = 0; i < pDesc->mVertexBufferCount; ++i)
+	{
+		streams[i].data = pDesc->pVertices[i] + (size_t)firstVertex * pDesc->mVertexStrides[i];
+		streams[i].size = pDesc->mVertexStrides[i];
+		streams[i].stride = pDesc->mVertexStrides[i];
+		maxStride = max(maxStride, pDesc->mVertexStrides[i]);
+	}
+
+	// Temporary memory the meshoptimizer passes below usually need (index adapters, adjacency, vertex copies), larger requests fall back to the heap
+	const size_t optimizerScratchSize = (size_t)indexCount * 16 + (size_t)vertexCount * (16 + maxStride) + 64 * 1024;
+	const size_t remapSize = (size_t)vertexCount * sizeof(uint32_t);
+
+	//ramap + optimizer scratch
+	uint32_t* scratchMemory = (uint32_t*)tf_malloc(remapSize + optimizerScratchSize);
+	uint32_t* remap = scratchMemory;
+	meshopt_SetScratchMemory(optimizerScratchSize, &scratchMemory[vertexCount]);
+
+	//generating remap & new vertex/index sets
+	const uint32_t uniqueVertexCount =
+		(uint32_t)meshopt_generateVertexRemapMulti(remap, indices, indexCount, vertexCount, streams, pDesc->mVertexBufferCount);
+	meshopt_remapIndexBuffer(indices, indices, indexCount, remap);
+	for (uint32_t i = 0; i < pDesc->mVertexBufferCount; ++i)
+		meshopt_remapVertexBuffer((void*)streams[i].data, streams[i].data, vertexCount, streams[i].stride, remap);
+
+	if (pDesc->mFlags & MESH_OPTIMIZATION_FLAG_VERTEXCACHE)
+	{
+		meshopt_optimizeVertexCache(indices, indices, indexCount, uniqueVertexCount);
+	}
+
+	if ((pDesc->mFlags & MESH_OPTIMIZATION_FLAG_OVERDRAW) && pDesc->pPositions)
+	{
+		const float kThreshold = 1.01f;
+		const float* positions = (const float*)(pDesc->pPositions + (size_t)firstVertex * pDesc->mPositionStride);
+		meshopt_optimizeOverdraw(indices, indices, indexCount, positions, uniqueVertexCount, pDesc->mPositionStride, kThreshold);
+	}
+
+	if (pDesc->mFlags & MESH_OPTIMIZATION_FLAG_VERTEXFETCH)
+	{
+		meshopt_optimizeVertexFetchRemap(remap, indices, indexCount, uniqueVertexCount);
+		meshopt_remapIndexBuffer(indices, indices, indexCount, remap);
+		for (uint32_t i = 0; i < pDesc->mVertexBufferCount; ++i)
+			meshopt_remapVertexBuffer((void*)streams[i].data, streams[i].data, uniqueVertexCount, streams[i].stride, remap);
+	}
+
+	for (uint32_t i = 0; i < indexCount; ++i)
+		indices[i] = (T)(indices[i] + firstVertex);
+
+	meshopt_SetScratchMemory(0, NULL);
+	tf_free(scratchMemory);
+}
+
+static void optimizeGeometryTaskFunc(void* pUser, uintptr_t start, uintptr_t end)
+{
+	const GeometryOptimizeDesc* pDesc = (const GeometryOptimizeDesc*)pUser;
+	const Geometry*             geom = pDesc->pGeometry;
+	for (uintptr_t i = start; i < end; ++i)
+	{
+		if (INDEX_TYPE_UINT16 == geom->mIndexType)
+			util_optimize_primitive<uint16_t>(pDesc, &geom->pDrawArgs[i]);
+		else
+			util_optimize_primitive<uint32_t>(pDesc, &geom->pDrawArgs[i]);
+	}
+}
+#endif
+
+/// Parses the geometry file, creates the GPU buffers and packs the vertex / index data
+/// Only touches staging memory if useStagingMemory is set, so it can run on a decode worker
+static UploadFunctionResult decodeGeometry(Renderer* pRenderer, GeometryLoadDesc* pDesc, bool useStagingMemory, GeometryDecodeDesc* pOut)
 {
 	Geometry* geom = NULL;
-	GeometryLoadDesc* pDesc = &pGeometryLoad.geomLoadDesc;
 
-	BufferUpdateDesc indexUpdateDesc = {};
-	BufferUpdateDesc vertexUpdateDesc[MAX_VERTEX_BINDINGS] = {};
+	BufferUpdateDesc& indexUpdateDesc = pOut->mIndexUpdateDesc;
+	BufferUpdateDesc* vertexUpdateDesc = pOut->mVertexUpdateDesc;
 
 	//data for overdraw optimization
 	uint32_t positionBinding = 0;
@@ -1078,8 +1668,11 @@ static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyE
 	// Geometry in gltf container
 	if (iext[0] != 0 && (stricmp(iext, "gltf") == 0 || stricmp(iext, "glb") == 0))
 	{
+		// The gltf and its .bin buffers are mapped and parsed in place, vertex data is packed straight from the mapping without reading
+		// the file into a heap copy first. The packing target comes from allocateGeometryMemory: staging memory when the streamer decodes
+		// (the default), system memory on a decode worker, which updateGeometryBuffer then copies into staging memory once more
 		FileStream file = {};
-		if (!fsOpenStreamFromPath(RD_MESHES, pDesc->pFileName, FM_READ_BINARY, pDesc->pFilePassword, &file))
+		if (!fsOpenMappedStreamFromPath(RD_MESHES, pDesc->pFileName, pDesc->pFilePassword, &file))
 		{
 			LOGF(eERROR, "Failed to open gltf file %s", pDesc->pFileName);
 			ASSERT(false);
@@ -1087,22 +1680,19 @@ static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyE
 		}
 
 		ssize_t fileSize = fsGetStreamFileSize(&file);
-		void* fileData = tf_malloc(fileSize);
-
-		fsReadFromStream(&file, fileData, fileSize);
+		const void* fileData = fsGetStreamBufferIfPresent(&file);
 
 		cgltf_options options = {};
 		cgltf_data* data = NULL;
 		options.memory_alloc = [](void* user, cgltf_size size) { return tf_malloc(size); };
 		options.memory_free = [](void* user, void* ptr) { tf_free(ptr); };
-		cgltf_result result = cgltf_parse(&options, fileData, fileSize, &data);
-		fsCloseStream(&file);
+		cgltf_result result = fileData ? cgltf_parse(&options, fileData, fileSize, &data) : cgltf_result_io_error;
 
 		if (cgltf_result_success != result)
 		{
 			LOGF(eERROR, "Failed to parse gltf file %s with error %u", pDesc->pFileName, (uint32_t)result);
 			ASSERT(false);
-			tf_free(fileData);
+			fsCloseStream(&file);
 			return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
 		}
 
@@ -1114,7 +1704,8 @@ static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyE
 		}
 #endif
 
-		// Load buffers located in separate files (.bin) using our file system
+		// Map buffers located in separate files (.bin) using our file system
+		FileStream* bufferStreams = (FileStream*)tf_calloc(data->buffers_count, sizeof(FileStream));
 		for (uint32_t i = 0; i < data->buffers_count; ++i)
 		{
 			const char* uri = data->buffers[i].uri;
@@ -1130,28 +1721,41 @@ static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyE
 				fsGetParentPath(pDesc->pFileName, parent);
 				char path[FS_MAX_PATH] = { 0 };
 				fsAppendPathComponent(parent, uri, path);
-				FileStream fs = {};
-				if (fsOpenStreamFromPath(RD_MESHES, path, FM_READ_BINARY, pDesc->pFilePassword, &fs))
+				FileStream* fs = &bufferStreams[i];
+				if (fsOpenMappedStreamFromPath(RD_MESHES, path, pDesc->pFilePassword, fs))
 				{
-					ASSERT(fsGetStreamFileSize(&fs) >= (ssize_t)data->buffers[i].size);
-					data->buffers[i].data = tf_malloc(data->buffers[i].size);
-					fsReadFromStream(&fs, data->buffers[i].data, data->buffers[i].size);
+					ASSERT(fsGetStreamFileSize(fs) >= (ssize_t)data->buffers[i].size);
+					data->buffers[i].data = (void*)fsGetStreamBufferIfPresent(fs);
 				}
-				fsCloseStream(&fs);
 			}
 		}
 
+		// cgltf must not free the mapped file or the mapped buffers, the streams own them
+		auto releaseGltf = [&]()
+		{
+			for (uint32_t i = 0; i < data->buffers_count; ++i)
+			{
+				if (bufferStreams[i].pIO)
+				{
+					data->buffers[i].data = NULL;
+					fsCloseStream(&bufferStreams[i]);
+				}
+			}
+			data->file_data = NULL;
+			cgltf_free(data);
+			tf_free(bufferStreams);
+			fsCloseStream(&file);
+		};
+
 		result = cgltf_load_buffers(&options, data, pDesc->pFileName);
 		if (cgltf_result_success != result)
 		{
 			LOGF(eERROR, "Failed to load buffers from gltf file %s with error %u", pDesc->pFileName, (uint32_t)result);
 			ASSERT(false);
-			tf_free(fileData);
+			releaseGltf();
 			return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
 		}
 
-		typedef void (*PackingFunction)(uint32_t count, uint32_t stride, uint32_t offset, const uint8_t* src, uint8_t* dst);
-
 		uint32_t         vertexStrides[SEMANTIC_TEXCOORD9 + 1] = {};
 		uint32_t         vertexAttribCount[SEMANTIC_TEXCOORD9 + 1] = {};
 		uint32_t         vertexOffsets[SEMANTIC_TEXCOORD9 + 1] = {};
@@ -1237,7 +1841,7 @@ static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyE
 				case cgltf_attribute_type_texcoord:
 				{
 					if (sizeof(uint32_t) == dstFormatSize && sizeof(float[2]) == srcFormatSize)
-						vertexPacking[attr->mSemantic] = util_pack_float2_to_half2;
+						vertexPacking[attr->mSemantic] = util_get_pack_float2_to_half2(gVertexPackingPath);
 					// #TODO: Add more variations if needed
 					break;
 				}
@@ -1245,7 +1849,7 @@ static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyE
 				case cgltf_attribute_type_tangent:
 				{
 					if (sizeof(uint32_t) == dstFormatSize && (sizeof(float[3]) == srcFormatSize || sizeof(float[4]) == srcFormatSize))
-						vertexPacking[attr->mSemantic] = util_pack_float3_direction_to_half2;
+						vertexPacking[attr->mSemantic] = util_get_pack_float3_direction_to_half2(gVertexPackingPath);
 					// #TODO: Add more variations if needed
 					break;
 				}
@@ -1326,7 +1930,8 @@ static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyE
 		}
 		else
 		{
-			indexUpdateDesc.mInternal.mMappedRange = allocateStagingMemory(indexUpdateDesc.mSize, RESOURCE_BUFFER_ALIGNMENT, pDesc->mNodeIndex);
+			indexUpdateDesc.mInternal.mMappedRange =
+				allocateGeometryMemory(indexUpdateDesc.mSize, RESOURCE_BUFFER_ALIGNMENT, pDesc->mNodeIndex, useStagingMemory);
 		}
 		indexUpdateDesc.pMappedData = indexUpdateDesc.mInternal.mMappedRange.pData;
 
@@ -1357,7 +1962,8 @@ static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyE
 			}
 			else
 			{
-				vertexUpdateDesc[i].mInternal.mMappedRange = allocateStagingMemory(vertexUpdateDesc[i].mSize, RESOURCE_BUFFER_ALIGNMENT, pDesc->mNodeIndex);
+				vertexUpdateDesc[i].mInternal.mMappedRange =
+					allocateGeometryMemory(vertexUpdateDesc[i].mSize, RESOURCE_BUFFER_ALIGNMENT, pDesc->mNodeIndex, useStagingMemory);
 			}
 			vertexUpdateDesc[i].pMappedData = vertexUpdateDesc[i].mInternal.mMappedRange.pData;
 			++bufferCounter;
@@ -1409,7 +2015,7 @@ static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyE
 						{
 							uint8_t* dst = (uint8_t*)vertexUpdateDesc[binding].pMappedData + vertexCount * stride;
 							if (vertexPacking[index])
-								vertexPacking[index]((uint32_t)attr->data->count, (uint32_t)attr->data->stride, 0, src, dst);
+								vertexPacking[index]((uint32_t)attr->data->count, (uint32_t)attr->data->stride, stride, 0, src, dst);
 							else
 								memcpy(dst, src, attr->data->count * attr->data->stride);
 						}
@@ -1420,7 +2026,7 @@ static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyE
 							// Example:
 							// [ POSITION | NORMAL | TEXCOORD ] => [ 0 | 12 | 24 ], [ 32 | 44 | 52 ], ... (vertex stride of 32 => 12 + 12 + 8)
 							if (vertexPacking[index])
-								vertexPacking[index]((uint32_t)attr->data->count, (uint32_t)attr->data->stride, offset, src, dst);
+								vertexPacking[index]((uint32_t)attr->data->count, (uint32_t)attr->data->stride, stride, offset, src, dst);
 							else
 								for (uint32_t e = 0; e < attr->data->count; ++e)
 									memcpy(dst + e * stride + offset, src + e * attr->data->stride, attr->data->stride);
@@ -1561,8 +2167,7 @@ static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyE
 			}
 		}
 
-		data->file_data = fileData;
-		cgltf_free(data);
+		releaseGltf();
 
 		tf_free(pDesc->pVertexLayout);
 
@@ -1573,134 +2178,69 @@ static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyE
 #if defined(ENABLE_MESHOPTIMIZER)
 	if (pDesc->mOptimizationFlags && geom)
 	{
-		size_t optimizerScratchSize = 128 * 1024 * 1024;
-		size_t remapSize = (geom->mVertexCount * sizeof(uint32_t));
-		size_t totalScratchSize = remapSize + optimizerScratchSize;
-
-		//ramap + optimizer scratch
-		uint32_t* scratchMemory = (uint32_t*)tf_malloc(totalScratchSize);
-
-		uint32_t* remap = scratchMemory;
-
-		void* optimizerScratch = &scratchMemory[geom->mVertexCount];
-		meshopt_SetScratchMemory(optimizerScratchSize, optimizerScratch);
-
-		meshopt_Stream streams[MAX_VERTEX_BINDINGS];
-		for (size_t i = 0; i < MAX_VERTEX_BINDINGS; i++)
+		GeometryOptimizeDesc optimizeDesc = {};
+		optimizeDesc.pGeometry = geom;
+		optimizeDesc.mFlags = pDesc->mOptimizationFlags;
+		optimizeDesc.pIndices = indexUpdateDesc.pMappedData;
+		for (uint32_t i = 0; i < MAX_VERTEX_BINDINGS; ++i)
 		{
 			if (!geom->mVertexStrides[i])
 				continue;
 
-			streams[i].data = vertexUpdateDesc[i].pMappedData;
-			streams[i].size = geom->mVertexStrides[i];
-			streams[i].stride = geom->mVertexStrides[i];
+			optimizeDesc.pVertices[optimizeDesc.mVertexBufferCount] = (uint8_t*)vertexUpdateDesc[i].pMappedData;
+			optimizeDesc.mVertexStrides[optimizeDesc.mVertexBufferCount] = geom->mVertexStrides[i];
+			++optimizeDesc.mVertexBufferCount;
 		}
+		//we can only run overdraw optimization if position data is not packed
+		optimizeDesc.pPositions = (const uint8_t*)positionPointer;
+		optimizeDesc.mPositionStride = geom->mVertexStrides[positionBinding];
 
-		//generating remap & new vertex/index sets
-		if (geom->mIndexType == INDEX_TYPE_UINT16)
+		// Primitives own disjoint index and vertex ranges so each one is optimized by its own job, draw arguments are left untouched
+		ThreadSystem* pThreadSystem = pResourceLoader ? pResourceLoader->pDecodeThreadSystem : NULL;
+		if (pThreadSystem && geom->mDrawArgCount > 1)
 		{
-			meshopt_generateVertexRemapMulti(remap, (uint16_t*)indexUpdateDesc.pMappedData, geom->mIndexCount, geom->mVertexCount, streams, geom->mVertexBufferCount);
-			meshopt_remapIndexBuffer((uint16_t*)indexUpdateDesc.pMappedData, (uint16_t*)indexUpdateDesc.pMappedData, geom->mIndexCount, remap);
+			ThreadCounter counter = {};
+			addThreadSystemParallelForTask(pThreadSystem, optimizeGeometryTaskFunc, &optimizeDesc, 0, geom->mDrawArgCount, 1, &counter);
+			waitThreadCounter(pThreadSystem, &counter);
 		}
 		else
 		{
-			meshopt_generateVertexRemapMulti(remap, (uint32_t*)indexUpdateDesc.pMappedData, geom->mIndexCount, geom->mVertexCount, streams, geom->mVertexBufferCount);
-			meshopt_remapIndexBuffer((uint32_t*)indexUpdateDesc.pMappedData, (uint32_t*)indexUpdateDesc.pMappedData, geom->mIndexCount, remap);
-		}
-
-		for (size_t i = 0; i < MAX_VERTEX_BINDINGS; i++)
-		{
-			if (!geom->mVertexStrides[i])
-				continue;
-
-			meshopt_remapVertexBuffer(vertexUpdateDesc[i].pMappedData, vertexUpdateDesc[i].pMappedData, geom->mVertexCount, geom->mVertexStrides[i], remap);
-		}
-
-		//optimize
-		//do we need to optmize per primitive ? 
-		///optmizations like overdraw clearly can alter across primitives. but can vertex cache & vertex fetch do it ?
-		if (geom->mIndexType == INDEX_TYPE_UINT16)
-		{
-			if (pDesc->mOptimizationFlags & MESH_OPTIMIZATION_FLAG_VERTEXCACHE)
-			{
-				meshopt_optimizeVertexCache((uint16_t*)indexUpdateDesc.pMappedData, (uint16_t*)indexUpdateDesc.pMappedData, geom->mIndexCount, geom->mVertexCount);
-			}
-
-			//we can only run this if position data is not packed
-			if (pDesc->mOptimizationFlags & MESH_OPTIMIZATION_FLAG_OVERDRAW && positionPointer)
-			{
-				for (size_t i = 0; i < geom->mDrawArgCount; i++)
-				{
-					uint16_t* src = &((uint16_t*)indexUpdateDesc.pMappedData)[geom->pDrawArgs[i].mStartIndex];
-
-					const float kThreshold = 1.01f;
-					meshopt_optimizeOverdraw(src, src, geom->pDrawArgs[i].mIndexCount, (float*)positionPointer, geom->mVertexCount, geom->mVertexStrides[positionBinding], kThreshold);
-				}
-			}
-
-			if (pDesc->mOptimizationFlags & MESH_OPTIMIZATION_FLAG_VERTEXFETCH)
-			{
-				meshopt_optimizeVertexFetchRemap(remap, (uint16_t*)indexUpdateDesc.pMappedData, geom->mIndexCount, geom->mVertexCount);
-				meshopt_remapIndexBuffer((uint16_t*)indexUpdateDesc.pMappedData, (uint16_t*)indexUpdateDesc.pMappedData, geom->mIndexCount, remap);
-
-				for (size_t i = 0; i < MAX_VERTEX_BINDINGS; i++)
-				{
-					if (!geom->mVertexStrides[i])
-						continue;
-
-					meshopt_remapVertexBuffer(vertexUpdateDesc[i].pMappedData, vertexUpdateDesc[i].pMappedData, geom->mVertexCount, geom->mVertexStrides[i], remap);
-				}
-			}
+			optimizeGeometryTaskFunc(&optimizeDesc, 0, geom->mDrawArgCount);
 		}
-		else
-		{
-			if (pDesc->mOptimizationFlags & MESH_OPTIMIZATION_FLAG_VERTEXCACHE)
-			{
-				meshopt_optimizeVertexCache((uint32_t*)indexUpdateDesc.pMappedData, (uint32_t*)indexUpdateDesc.pMappedData, geom->mIndexCount, geom->mVertexCount);
-			}
-
-			//we can only run this if position data is not packed
-			if (pDesc->mOptimizationFlags & MESH_OPTIMIZATION_FLAG_OVERDRAW && positionPointer)
-			{
-				for (size_t i = 0; i < geom->mDrawArgCount; i++)
-				{
-					uint32_t* src = &((uint32_t*)indexUpdateDesc.pMappedData)[geom->pDrawArgs[i].mStartIndex];
-
-					const float kThreshold = 1.01f;
-					meshopt_optimizeOverdraw(src, src, geom->pDrawArgs[i].mIndexCount, (float*)positionPointer, geom->mVertexCount, geom->mVertexStrides[positionBinding], kThreshold);
-				}
-			}
-
-			if (pDesc->mOptimizationFlags & MESH_OPTIMIZATION_FLAG_VERTEXFETCH)
-			{
-				meshopt_optimizeVertexFetchRemap(remap, (uint32_t*)indexUpdateDesc.pMappedData, geom->mIndexCount, geom->mVertexCount);
-				meshopt_remapIndexBuffer((uint32_t*)indexUpdateDesc.pMappedData, (uint32_t*)indexUpdateDesc.pMappedData, geom->mIndexCount, remap);
-
-				for (size_t i = 0; i < MAX_VERTEX_BINDINGS; i++)
-				{
-					if (!geom->mVertexStrides[i])
-						continue;
+	}
+#endif
 
-					meshopt_remapVertexBuffer(vertexUpdateDesc[i].pMappedData, vertexUpdateDesc[i].pMappedData, geom->mVertexCount, geom->mVertexStrides[i], remap);
-				}
-			}
-		}
+	return geom ? UPLOAD_FUNCTION_RESULT_COMPLETED : UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+}
 
-		tf_free(scratchMemory);
+static UploadFunctionResult updateGeometryBuffer(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, BufferUpdateDesc& bufUpdateDesc)
+{
+	MappedMemoryRange& range = bufUpdateDesc.mInternal.mMappedRange;
+	if (range.mFlags & MAPPED_RANGE_FLAG_CPU_MEMORY)
+	{
+		MappedMemoryRange stagingRange = allocateStagingMemory(bufUpdateDesc.mSize, RESOURCE_BUFFER_ALIGNMENT, bufUpdateDesc.pBuffer->mNodeIndex);
+		memcpy(stagingRange.pData, range.pData, (size_t)bufUpdateDesc.mSize);
+		tf_free(range.pData);
+		range = stagingRange;
+		bufUpdateDesc.pMappedData = range.pData;
 	}
-#endif
 
+	return updateBuffer(pRenderer, pCopyEngine, activeSet, bufUpdateDesc);
+}
+
+static UploadFunctionResult loadDecodedGeometry(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, GeometryDecodeDesc* pDecodeDesc)
+{
 	// Upload mesh
 	UploadFunctionResult uploadResult = UPLOAD_FUNCTION_RESULT_COMPLETED;
 	if (!gUma)
 	{
-		uploadResult = updateBuffer(pRenderer, pCopyEngine, activeSet, indexUpdateDesc);
+		uploadResult = updateGeometryBuffer(pRenderer, pCopyEngine, activeSet, pDecodeDesc->mIndexUpdateDesc);
 
 		for (uint32_t i = 0; i < MAX_VERTEX_BINDINGS; ++i)
 		{
-			if (vertexUpdateDesc[i].pMappedData)
+			if (pDecodeDesc->mVertexUpdateDesc[i].pMappedData)
 			{
-				uploadResult = updateBuffer(pRenderer, pCopyEngine, activeSet, vertexUpdateDesc[i]);
+				uploadResult = updateGeometryBuffer(pRenderer, pCopyEngine, activeSet, pDecodeDesc->mVertexUpdateDesc[i]);
 			}
 		}
 	}
@@ -1708,6 +2248,29 @@ static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyE
 	return uploadResult;
 }
 
+static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, UpdateRequest& pGeometryLoad)
+{
+	if (pGeometryLoad.pDecodeTask)
+	{
+		// File was parsed and packed by a decode worker
+		ResourceDecodeTask* pDecodeTask = pGeometryLoad.pDecodeTask;
+		if (!pDecodeTask->mSuccess)
+		{
+			return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+		}
+		return loadDecodedGeometry(pRenderer, pCopyEngine, activeSet, &pDecodeTask->mGeometry);
+	}
+
+	GeometryDecodeDesc   decodeDesc = {};
+	UploadFunctionResult result = decodeGeometry(pRenderer, &pGeometryLoad.geomLoadDesc, true, &decodeDesc);
+	if (UPLOAD_FUNCTION_RESULT_COMPLETED != result)
+	{
+		return result;
+	}
+
+	return loadDecodedGeometry(pRenderer, pCopyEngine, activeSet, &decodeDesc);
+}
+
 static UploadFunctionResult copyTexture(Renderer* pRenderer, CopyEngine* pCopyEngine, size_t activeSet, TextureCopyDesc& pTextureCopy)
 {
 	Texture* texture = pTextureCopy.pTexture;
@@ -1768,27 +2331,232 @@ static UploadFunctionResult copyTexture(Renderer* pRenderer, CopyEngine* pCopyEn
 		barrier.mQueueType = pTextureCopy.mQueueType;
 		cmdResourceBarrier(cmd, 0, NULL, 1, &barrier, 0, NULL);
 	}
-#endif
-
-	return UPLOAD_FUNCTION_RESULT_COMPLETED;
+#endif
+
+	return UPLOAD_FUNCTION_RESULT_COMPLETED;
+
+}
+/************************************************************************/
+// Internal Resource Loader Implementation
+/************************************************************************/
+static void dispatchDecodeTasks(ResourceLoader* pLoader);
+
+/// Decoded data of a finished task counts against the decode budget until the streamer releases the task
+static void finishDecodeTask(ResourceDecodeTask* pDecodeTask)
+{
+	ResourceLoader* pLoader = pDecodeTask->pLoader;
+	acquireMutex(&pLoader->mDecodeMutex);
+	--pLoader->mDecodeTasksRunning;
+	pLoader->mDecodeBytesInFlight += pDecodeTask->mDecodedBytes;
+	pLoader->mDecodePeakBytesInFlight = max(pLoader->mDecodePeakBytesInFlight, pLoader->mDecodeBytesInFlight);
+	releaseMutex(&pLoader->mDecodeMutex);
+
+	// The streamer may free the task as soon as the counter reaches zero
+	decrementThreadCounter(&pDecodeTask->mCounter);
+	dispatchDecodeTasks(pLoader);
+}
+
+static void decodeResourceTaskFunc(void* pUser, uintptr_t)
+{
+	ResourceDecodeTask* pDecodeTask = (ResourceDecodeTask*)pUser;
+	if (DECODE_TASK_STATE_PENDING !=
+		tfrg_atomic32_cas_relaxed(&pDecodeTask->mState, DECODE_TASK_STATE_PENDING, DECODE_TASK_STATE_RUNNING))
+	{
+		// Load was cancelled before we got to it
+		finishDecodeTask(pDecodeTask);
+		return;
+	}
+
+	switch (pDecodeTask->mType)
+	{
+	case UPDATE_REQUEST_LOAD_TEXTURE:
+		pDecodeTask->mSuccess = decodeTexture(&pDecodeTask->mTextureLoadDesc, true, &pDecodeTask->mTexture);
+		if (pDecodeTask->mSuccess)
+			pDecodeTask->mDecodedBytes = (uint64_t)fsGetStreamFileSize(&pDecodeTask->mTexture.mStream);
+		break;
+	case UPDATE_REQUEST_LOAD_GEOMETRY:
+		pDecodeTask->mSuccess = UPLOAD_FUNCTION_RESULT_COMPLETED ==
+			decodeGeometry(pDecodeTask->pRenderer, &pDecodeTask->mGeometryLoadDesc, false, &pDecodeTask->mGeometry);
+		if (pDecodeTask->mSuccess && !gUma)
+		{
+			pDecodeTask->mDecodedBytes = pDecodeTask->mGeometry.mIndexUpdateDesc.mSize;
+			for (uint32_t i = 0; i < MAX_VERTEX_BINDINGS; ++i)
+				pDecodeTask->mDecodedBytes += pDecodeTask->mGeometry.mVertexUpdateDesc[i].mSize;
+		}
+		break;
+	default: ASSERT(false); break;
+	}
+
+	finishDecodeTask(pDecodeTask);
+}
+
+/// Hands held back decode tasks to the workers while one of them is idle and the decoded data fits the budget
+static void dispatchDecodeTasks(ResourceLoader* pLoader)
+{
+	acquireMutex(&pLoader->mDecodeMutex);
+	const uint64_t budget = pLoader->mDesc.mDecodeMemoryBudget;
+	uint32_t       dispatchCount = 0;
+	for (; dispatchCount < (uint32_t)pLoader->mPendingDecodeTasks.size(); ++dispatchCount)
+	{
+		if (budget && (pLoader->mDecodeTasksRunning >= pLoader->mDesc.mDecodeThreadCount || pLoader->mDecodeBytesInFlight >= budget))
+			break;
+
+		++pLoader->mDecodeTasksRunning;
+		addThreadSystemTask(pLoader->pDecodeThreadSystem, decodeResourceTaskFunc, pLoader->mPendingDecodeTasks[dispatchCount]);
+	}
+	pLoader->mPendingDecodeTasks.erase(pLoader->mPendingDecodeTasks.begin(), pLoader->mPendingDecodeTasks.begin() + dispatchCount);
+	releaseMutex(&pLoader->mDecodeMutex);
+}
+
+static void queueDecodeTask(ResourceLoader* pLoader, ResourceDecodeTask* pDecodeTask)
+{
+	acquireMutex(&pLoader->mDecodeMutex);
+	pLoader->mPendingDecodeTasks.push_back(pDecodeTask);
+	releaseMutex(&pLoader->mDecodeMutex);
+	dispatchDecodeTasks(pLoader);
+}
+
+/// Decodes a task held back by the budget on the calling thread, the streamer would wait for it otherwise
+static void runPendingDecodeTask(ResourceLoader* pLoader, ResourceDecodeTask* pDecodeTask)
+{
+	acquireMutex(&pLoader->mDecodeMutex);
+	eastl::vector<ResourceDecodeTask*>::iterator it =
+		eastl::find(pLoader->mPendingDecodeTasks.begin(), pLoader->mPendingDecodeTasks.end(), pDecodeTask);
+	const bool pending = it != pLoader->mPendingDecodeTasks.end();
+	if (pending)
+	{
+		pLoader->mPendingDecodeTasks.erase(it);
+		++pLoader->mDecodeTasksRunning;
+	}
+	releaseMutex(&pLoader->mDecodeMutex);
+
+	if (pending)
+	{
+		decodeResourceTaskFunc(pDecodeTask, 0);
+	}
+}
+
+static ResourceDecodeTask* addDecodeTask(ResourceLoader* pLoader, UpdateRequestType type, uint32_t nodeIndex)
+{
+	ResourceDecodeTask* pDecodeTask = (ResourceDecodeTask*)tf_calloc(1, sizeof(ResourceDecodeTask));
+	pDecodeTask->mType = type;
+	pDecodeTask->pRenderer = pLoader->ppRenderers[nodeIndex];
+	pDecodeTask->pLoader = pLoader;
+	initThreadCounter(&pDecodeTask->mCounter, 1);
+	return pDecodeTask;
+}
+
+/// Frees a finished decode task and gives its decoded bytes back to the budget.
+/// Results the streamer did not consume (cancelled loads) are released as well
+static void removeDecodeTask(ResourceDecodeTask* pDecodeTask, bool consumed)
+{
+	if (!consumed && pDecodeTask->mSuccess)
+	{
+		if (UPDATE_REQUEST_LOAD_TEXTURE == pDecodeTask->mType)
+		{
+			fsCloseStream(&pDecodeTask->mTexture.mStream);
+		}
+		else if (UPDATE_REQUEST_LOAD_GEOMETRY == pDecodeTask->mType)
+		{
+			GeometryDecodeDesc* pGeometry = &pDecodeTask->mGeometry;
+			if (pGeometry->mIndexUpdateDesc.mInternal.mMappedRange.mFlags & MAPPED_RANGE_FLAG_CPU_MEMORY)
+				tf_free(pGeometry->mIndexUpdateDesc.mInternal.mMappedRange.pData);
+			for (uint32_t i = 0; i < MAX_VERTEX_BINDINGS; ++i)
+			{
+				if (pGeometry->mVertexUpdateDesc[i].mInternal.mMappedRange.mFlags & MAPPED_RANGE_FLAG_CPU_MEMORY)
+					tf_free(pGeometry->mVertexUpdateDesc[i].mInternal.mMappedRange.pData);
+			}
+
+			// decodeGeometry already created the buffers and handed the geometry out
+			Geometry** ppGeometry = pDecodeTask->mGeometryLoadDesc.ppGeometry;
+			if (*ppGeometry)
+			{
+				vk_removeBuffer(pDecodeTask->pRenderer, (*ppGeometry)->pIndexBuffer);
+				for (uint32_t i = 0; i < (*ppGeometry)->mVertexBufferCount; ++i)
+					vk_removeBuffer(pDecodeTask->pRenderer, (*ppGeometry)->pVertexBuffers[i]);
+				if ((*ppGeometry)->pShadow)
+					tf_free((*ppGeometry)->pShadow);
+				tf_free(*ppGeometry);
+				*ppGeometry = NULL;
+			}
+		}
+	}
+
+	ResourceLoader* pLoader = pDecodeTask->pLoader;
+	acquireMutex(&pLoader->mDecodeMutex);
+	pLoader->mDecodeBytesInFlight -= pDecodeTask->mDecodedBytes;
+	releaseMutex(&pLoader->mDecodeMutex);
+
+	tf_free(pDecodeTask);
+	dispatchDecodeTasks(pLoader);
+}
+
+static bool areTasksAvailable(ResourceLoader* pLoader)
+{
+	for (size_t i = 0; i < MAX_MULTIPLE_GPUS; ++i)
+	{
+		for (uint32_t priority = 0; priority < RESOURCE_PRIORITY_COUNT; ++priority)
+		{
+			if (!pLoader->mRequestQueue[i][priority].empty())
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+/// Largest request counter up to which every request of the class has been processed. Must be called inside mQueueMutex
+static uint64_t getLastTokenProcessed(ResourceLoader* pLoader, uint32_t tokenClass)
+{
+	// Safe to use mTokenCounter as tokens are handed out inside the critical section
+	uint64_t lastToken = tfrg_atomic64_load_relaxed(&pLoader->mTokenCounter);
+	if (SYNC_TOKEN_CLASS_PIPELINE == tokenClass)
+	{
+		if (!pLoader->mPipelineTokens.empty())
+		{
+			lastToken = min(lastToken, pLoader->mPipelineTokens.front() - 1);
+		}
+		return lastToken;
+	}
+
+	for (uint32_t i = 0; i < pLoader->mGpuCount; ++i)
+	{
+		// Queues are sorted by token within a priority class
+		const eastl::vector<UpdateRequest>& requestQueue = pLoader->mRequestQueue[i][tokenClass];
+		if (!requestQueue.empty())
+		{
+			lastToken = min(lastToken, requestQueue.front().mWaitIndex - 1);
+		}
+	}
 
+	return lastToken;
 }
-/************************************************************************/
-// Internal Resource Loader Implementation
-/************************************************************************/
-static bool areTasksAvailable(ResourceLoader* pLoader)
+
+/// Whether some class processed requests whose tokens were not signaled yet. Must be called inside mQueueMutex
+static bool areTokensPending(ResourceLoader* pLoader)
 {
-	for (size_t i = 0; i < MAX_MULTIPLE_GPUS; ++i)
+	for (uint32_t tokenClass = 0; tokenClass < SYNC_TOKEN_CLASS_COUNT; ++tokenClass)
 	{
-		if (!pLoader->mRequestQueue[i].empty())
+		if (tfrg_atomic64_load_relaxed(&pLoader->mTokenCompleted[tokenClass]) != getLastTokenProcessed(pLoader, tokenClass))
 		{
 			return true;
 		}
 	}
-
 	return false;
 }
 
+/// Puts requests the streamer could not process in this set back in front of the queue
+static void requeueRequests(
+	ResourceLoader* pLoader, uint32_t nodeIndex, ResourcePriority priority, eastl::vector<UpdateRequest>& activeQueue, size_t first)
+{
+	acquireMutex(&pLoader->mQueueMutex);
+	eastl::vector<UpdateRequest>& requestQueue = pLoader->mRequestQueue[nodeIndex][priority];
+	requestQueue.insert(requestQueue.begin(), activeQueue.begin() + first, activeQueue.end());
+	releaseMutex(&pLoader->mQueueMutex);
+}
+
 static void streamerThreadFunc(void* pThreadData)
 {
 	ResourceLoader* pLoader = (ResourceLoader*)pThreadData;
@@ -1803,17 +2571,13 @@ static void streamerThreadFunc(void* pThreadData)
 	}
 #endif
 
-	SyncToken maxToken = {};
-
 	while (pLoader->mRun)
 	{
 		acquireMutex(&pLoader->mQueueMutex);
 
 		// Check for pending tokens
-		// Safe to use mTokenCounter as we are inside critical section
-		bool allTokensSignaled = (pLoader->mTokenCompleted == tfrg_atomic64_load_relaxed(&pLoader->mTokenCounter));
-
-		while (!areTasksAvailable(pLoader) && allTokensSignaled && pLoader->mRun)
+		// Tokens of pipelines still compiling can not be signaled yet, sleep until a compile finishes instead of spinning on them
+		while (!areTasksAvailable(pLoader) && !areTokensPending(pLoader) && pLoader->mRun)
 		{
 			// No waiting if not running dedicated resource loader thread.
 			if (pLoader->mDesc.mSingleThreaded)
@@ -1830,13 +2594,19 @@ static void streamerThreadFunc(void* pThreadData)
 		pLoader->mNextSet = (pLoader->mNextSet + 1) % pLoader->mDesc.mBufferCount;
 		for (uint32_t nodeIndex = 0; nodeIndex < pLoader->mGpuCount; ++nodeIndex)
 		{
-			waitCopyEngineSet(pLoader->ppRenderers[nodeIndex], &pLoader->pCopyEngines[nodeIndex], pLoader->mNextSet, true);
+			if (!waitCopyEngineSet(pLoader->ppRenderers[nodeIndex], &pLoader->pCopyEngines[nodeIndex], pLoader->mNextSet, true))
+			{
+				tfrg_atomic32_add_relaxed(&pLoader->pCopyEngines[nodeIndex].mStats.mStagingWaits, 1);
+			}
 			resetCopyEngineSet(pLoader->ppRenderers[nodeIndex], &pLoader->pCopyEngines[nodeIndex], pLoader->mNextSet);
 		}
 
 		// Signal pending tokens from previous frames
 		acquireMutex(&pLoader->mTokenMutex);
-		tfrg_atomic64_store_release(&pLoader->mTokenCompleted, pLoader->mCurrentTokenState[pLoader->mNextSet]);
+		for (uint32_t tokenClass = 0; tokenClass < SYNC_TOKEN_CLASS_COUNT; ++tokenClass)
+		{
+			tfrg_atomic64_store_release(&pLoader->mTokenCompleted[tokenClass], pLoader->mCurrentTokenState[pLoader->mNextSet][tokenClass]);
+		}
 		releaseMutex(&pLoader->mTokenMutex);
 		wakeAllConditionVariable(&pLoader->mTokenCond);
 
@@ -1844,77 +2614,119 @@ static void streamerThreadFunc(void* pThreadData)
 
 		for (uint32_t nodeIndex = 0; nodeIndex < pLoader->mGpuCount; ++nodeIndex)
 		{
-			acquireMutex(&pLoader->mQueueMutex);
-
-			eastl::vector<UpdateRequest>& requestQueue = pLoader->mRequestQueue[nodeIndex];
 			CopyEngine& copyEngine = pLoader->pCopyEngines[nodeIndex];
+			Renderer* pRenderer = pLoader->ppRenderers[nodeIndex];
+			uint32_t processedCount = 0;
+			bool setFull = false;
 
-			if (!requestQueue.size())
+			for (uint32_t priorityIndex = 0; priorityIndex < RESOURCE_PRIORITY_COUNT && !setFull; ++priorityIndex)
 			{
-				releaseMutex(&pLoader->mQueueMutex);
-				continue;
-			}
+				const ResourcePriority priority = gResourcePriorityOrder[priorityIndex];
 
-			eastl::vector<UpdateRequest> activeQueue;
-			eastl::swap(requestQueue, activeQueue);
-			releaseMutex(&pLoader->mQueueMutex);
-
-			Renderer* pRenderer = pLoader->ppRenderers[nodeIndex];
-			size_t requestCount = activeQueue.size();
-			SyncToken maxNodeToken = {};
+				acquireMutex(&pLoader->mQueueMutex);
 
-			for (size_t j = 0; j < requestCount; ++j)
-			{
-				UpdateRequest updateState = activeQueue[j];
+				eastl::vector<UpdateRequest>& requestQueue = pLoader->mRequestQueue[nodeIndex][priority];
 
-				UploadFunctionResult result = UPLOAD_FUNCTION_RESULT_COMPLETED;
-				switch (updateState.mType)
+				if (!requestQueue.size())
 				{
-				case UPDATE_REQUEST_UPDATE_BUFFER:
-					result = updateBuffer(pRenderer, &copyEngine, pLoader->mNextSet, updateState.bufUpdateDesc);
-					break;
-				case UPDATE_REQUEST_UPDATE_TEXTURE:
-					result = updateTexture(pRenderer, &copyEngine, pLoader->mNextSet, updateState.texUpdateDesc);
-					break;
-				case UPDATE_REQUEST_BUFFER_BARRIER:
-					vk_cmdResourceBarrier(acquireCmd(&copyEngine, pLoader->mNextSet), 1, &updateState.bufferBarrier, 0, NULL, 0, NULL);
-					result = UPLOAD_FUNCTION_RESULT_COMPLETED;
-					break;
-				case UPDATE_REQUEST_TEXTURE_BARRIER:
-					vk_cmdResourceBarrier(acquireCmd(&copyEngine, pLoader->mNextSet), 0, NULL, 1, &updateState.textureBarrier, 0, NULL);
-					result = UPLOAD_FUNCTION_RESULT_COMPLETED;
-					break;
-				case UPDATE_REQUEST_LOAD_TEXTURE:
-					result = loadTexture(pRenderer, &copyEngine, pLoader->mNextSet, updateState);
-					break;
-				case UPDATE_REQUEST_LOAD_GEOMETRY:
-					result = loadGeometry(pRenderer, &copyEngine, pLoader->mNextSet, updateState);
-					break;
-				case UPDATE_REQUEST_COPY_TEXTURE:
-					result = copyTexture(pRenderer, &copyEngine, pLoader->mNextSet, updateState.texCopyDesc);
-					break;
-				case UPDATE_REQUEST_INVALID: break;
+					releaseMutex(&pLoader->mQueueMutex);
+					continue;
 				}
 
-				if (updateState.pUploadBuffer)
+				eastl::vector<UpdateRequest> activeQueue;
+				eastl::swap(requestQueue, activeQueue);
+				releaseMutex(&pLoader->mQueueMutex);
+
+				size_t requestCount = activeQueue.size();
+
+				for (size_t j = 0; j < requestCount; ++j)
 				{
-					CopyResourceSet& resourceSet = copyEngine.resourceSets[pLoader->mNextSet];
-					resourceSet.mTempBuffers.push_back(updateState.pUploadBuffer);
-				}
+					UpdateRequest updateState = activeQueue[j];
 
-				bool completed = result == UPLOAD_FUNCTION_RESULT_COMPLETED || result == UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+					// Lower classes hand the copy engine back once the staging budget of the set is used up
+					// so that higher classes queued in the meantime go out with the next set
+					if (processedCount && priority != RESOURCE_PRIORITY_HIGH && !pLoader->mDesc.mSingleThreaded &&
+						isCopyEngineSetFull(&copyEngine, pLoader->mNextSet))
+					{
+						requeueRequests(pLoader, nodeIndex, priority, activeQueue, j);
+						setFull = true;
+						break;
+					}
 
-				completionMask |= (uint64_t)completed << nodeIndex;
+					if (updateState.pDecodeTask && !isThreadCounterDone(&updateState.pDecodeTask->mCounter))
+					{
+						// Requests of a class have to be processed in order to keep SyncToken semantics
+						// Submit what we have and retry the rest in the next set instead of stalling the copies already recorded
+						if (processedCount)
+						{
+							requeueRequests(pLoader, nodeIndex, priority, activeQueue, j);
+							break;
+						}
 
-				if (updateState.mWaitIndex && completed)
-				{
-					ASSERT(maxNodeToken < updateState.mWaitIndex);
-					maxNodeToken = updateState.mWaitIndex;
-				}
+						runPendingDecodeTask(pLoader, updateState.pDecodeTask);
+						waitThreadCounter(pLoader->pDecodeThreadSystem, &updateState.pDecodeTask->mCounter);
+					}
 
-				ASSERT(result != UPLOAD_FUNCTION_RESULT_STAGING_BUFFER_FULL);
+					UploadFunctionResult result = UPLOAD_FUNCTION_RESULT_COMPLETED;
+					switch (updateState.mType)
+					{
+					case UPDATE_REQUEST_UPDATE_BUFFER:
+						result = updateBuffer(pRenderer, &copyEngine, pLoader->mNextSet, updateState.bufUpdateDesc);
+						break;
+					case UPDATE_REQUEST_UPDATE_TEXTURE:
+						result = updateTexture(pRenderer, &copyEngine, pLoader->mNextSet, updateState.texUpdateDesc);
+						break;
+					case UPDATE_REQUEST_BUFFER_BARRIER:
+						vk_cmdResourceBarrier(acquireCmd(&copyEngine, pLoader->mNextSet), 1, &updateState.bufferBarrier, 0, NULL, 0, NULL);
+						result = UPLOAD_FUNCTION_RESULT_COMPLETED;
+						break;
+					case UPDATE_REQUEST_TEXTURE_BARRIER:
+						vk_cmdResourceBarrier(acquireCmd(&copyEngine, pLoader->mNextSet), 0, NULL, 1, &updateState.textureBarrier, 0, NULL);
+						result = UPLOAD_FUNCTION_RESULT_COMPLETED;
+						break;
+					case UPDATE_REQUEST_LOAD_TEXTURE:
+						result = loadTexture(pRenderer, &copyEngine, pLoader->mNextSet, updateState);
+						break;
+					case UPDATE_REQUEST_LOAD_GEOMETRY:
+						result = loadGeometry(pRenderer, &copyEngine, pLoader->mNextSet, updateState);
+						break;
+					case UPDATE_REQUEST_COPY_TEXTURE:
+						result = copyTexture(pRenderer, &copyEngine, pLoader->mNextSet, updateState.texCopyDesc);
+						break;
+					case UPDATE_REQUEST_INVALID: break;
+					}
+
+					if (updateState.pUploadBuffer)
+					{
+						CopyResourceSet& resourceSet = copyEngine.resourceSets[pLoader->mNextSet];
+						resourceSet.mTempBuffers.push_back(updateState.pUploadBuffer);
+					}
+
+					if (updateState.pDecodeTask)
+					{
+						// Cancelled loads never consumed the decoded data
+						removeDecodeTask(updateState.pDecodeTask, UPDATE_REQUEST_INVALID != updateState.mType);
+						updateState.pDecodeTask = NULL;
+					}
+
+					if (UPLOAD_FUNCTION_RESULT_STAGING_NOT_READY == result)
+					{
+						// Submit the part recorded so far, the request resumes from its saved progress with the next set
+						completionMask |= (uint64_t)1 << nodeIndex;
+						activeQueue[j] = updateState;
+						requeueRequests(pLoader, nodeIndex, priority, activeQueue, j);
+						setFull = true;
+						break;
+					}
+
+					bool completed = result == UPLOAD_FUNCTION_RESULT_COMPLETED || result == UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+
+					completionMask |= (uint64_t)completed << nodeIndex;
+					++processedCount;
+
+					ASSERT(result != UPLOAD_FUNCTION_RESULT_STAGING_BUFFER_FULL);
+				}
 			}
-			maxToken = max(maxToken, maxNodeToken);
 		}
 
 		if (completionMask != 0)
@@ -1933,12 +2745,21 @@ static void streamerThreadFunc(void* pThreadData)
 
 		}
 
-		SyncToken nextToken = max(maxToken, getLastTokenCompleted());
-		pLoader->mCurrentTokenState[pLoader->mNextSet] = nextToken;
+		// Classes are processed out of order, every class signals the tokens older than its own requests still queued
+		acquireMutex(&pLoader->mQueueMutex);
+		for (uint32_t tokenClass = 0; tokenClass < SYNC_TOKEN_CLASS_COUNT; ++tokenClass)
+		{
+			pLoader->mCurrentTokenState[pLoader->mNextSet][tokenClass] =
+				max(getLastTokenProcessed(pLoader, tokenClass), tfrg_atomic64_load_acquire(&pLoader->mTokenCompleted[tokenClass]));
+		}
+		releaseMutex(&pLoader->mQueueMutex);
 
 		// Signal submitted tokens
 		acquireMutex(&pLoader->mTokenMutex);
-		tfrg_atomic64_store_release(&pLoader->mTokenSubmitted, pLoader->mCurrentTokenState[pLoader->mNextSet]);
+		for (uint32_t tokenClass = 0; tokenClass < SYNC_TOKEN_CLASS_COUNT; ++tokenClass)
+		{
+			tfrg_atomic64_store_release(&pLoader->mTokenSubmitted[tokenClass], pLoader->mCurrentTokenState[pLoader->mNextSet][tokenClass]);
+		}
 		releaseMutex(&pLoader->mTokenMutex);
 		wakeAllConditionVariable(&pLoader->mTokenCond);
 
@@ -2004,14 +2825,27 @@ static void addResourceLoader(Renderer** ppRenderers, uint32_t rendererCount, Re
 	initConditionVariable(&pLoader->mQueueCond);
 	initConditionVariable(&pLoader->mTokenCond);
 	initMutex(&pLoader->mSemaphoreMutex);
+	initMutex(&pLoader->mDecodeMutex);
+	initMutex(&pLoader->mPipelineMutex);
+	initConditionVariable(&pLoader->mPipelineCond);
 
 	pLoader->mTokenCounter = 0;
-	pLoader->mTokenCompleted = 0;
-	pLoader->mTokenSubmitted = 0;
+	for (uint32_t tokenClass = 0; tokenClass < SYNC_TOKEN_CLASS_COUNT; ++tokenClass)
+	{
+		pLoader->mTokenCompleted[tokenClass] = 0;
+		pLoader->mTokenSubmitted[tokenClass] = 0;
+	}
+	memset(pLoader->mCurrentTokenState, 0, sizeof(pLoader->mCurrentTokenState));
+
+	util_init_vertex_packing();
+#if defined(ENABLE_MESHOPTIMIZER)
+	// Installed once, decode workers only swap their own thread local scratch memory
+	meshopt_setAllocator();
+#endif
 
 	for (uint32_t i = 0; i < gpuCount; ++i)
 	{
-		setupCopyEngine(pLoader->ppRenderers[i], &pLoader->pCopyEngines[i], i, pLoader->mDesc.mBufferSize, pLoader->mDesc.mBufferCount);
+		setupCopyEngine(pLoader->ppRenderers[i], &pLoader->pCopyEngines[i], i, &pLoader->mDesc);
 	}
 
 	ThreadDesc threadDesc = {};
@@ -2036,6 +2870,15 @@ static void addResourceLoader(Renderer** ppRenderers, uint32_t rendererCount, Re
 	// Create dedicated resource loader thread.
 	if (!pLoader->mDesc.mSingleThreaded)
 	{
+		if (pLoader->mDesc.mDecodeThreadCount)
+		{
+			initThreadSystem(&pLoader->pDecodeThreadSystem, pLoader->mDesc.mDecodeThreadCount, NULL, "ResourceDecode");
+		}
+		if (pLoader->mDesc.mPipelineThreadCount)
+		{
+			initThreadSystem(&pLoader->pPipelineThreadSystem, pLoader->mDesc.mPipelineThreadCount, NULL, "PipelineCompile");
+		}
+
 		initThread(&threadDesc, &pLoader->mThread);
 	}
 
@@ -2044,6 +2887,30 @@ static void addResourceLoader(Renderer** ppRenderers, uint32_t rendererCount, Re
 
 static void removeResourceLoader(ResourceLoader* pLoader)
 {
+	// Decode tasks still reference the requests, let them finish before the streamer frees the queue
+	if (pLoader->pDecodeThreadSystem)
+	{
+		waitThreadSystemIdle(pLoader->pDecodeThreadSystem);
+	}
+	if (pLoader->pPipelineThreadSystem)
+	{
+		waitThreadSystemIdle(pLoader->pPipelineThreadSystem);
+		exitThreadSystem(pLoader->pPipelineThreadSystem);
+	}
+	for (eastl::hash_map<uint32_t, PipelineCacheEntry*>::iterator it = pLoader->mPipelineCache.begin(); it != pLoader->mPipelineCache.end(); ++it)
+	{
+		for (PipelineCacheEntry* pEntry = it->second; pEntry;)
+		{
+			PipelineCacheEntry* pNext = pEntry->pNext;
+			LOGF(LogLevel::eWARNING, "Pipeline '%s' was not removed before exitResourceLoaderInterface", pEntry->mName);
+			vk_removePipeline(pEntry->pRenderer, pEntry->pPipeline);
+			tf_delete(pEntry);
+			pEntry = pNext;
+		}
+	}
+	pLoader->mPipelineCache.clear();
+	pLoader->mPipelineEntries.clear();
+
 	pLoader->mRun = false;    //-V601
 
 	if (pLoader->mDesc.mSingleThreaded)
@@ -2056,11 +2923,19 @@ static void removeResourceLoader(ResourceLoader* pLoader)
 		joinThread(pLoader->mThread);
 	}
 
+	if (pLoader->pDecodeThreadSystem)
+	{
+		exitThreadSystem(pLoader->pDecodeThreadSystem);
+	}
+
 	destroyConditionVariable(&pLoader->mQueueCond);
 	destroyConditionVariable(&pLoader->mTokenCond);
 	destroyMutex(&pLoader->mQueueMutex);
 	destroyMutex(&pLoader->mTokenMutex);
 	destroyMutex(&pLoader->mSemaphoreMutex);
+	destroyMutex(&pLoader->mDecodeMutex);
+	destroyConditionVariable(&pLoader->mPipelineCond);
+	destroyMutex(&pLoader->mPipelineMutex);
 
 	tf_delete(pLoader);
 }
@@ -2068,99 +2943,126 @@ static void removeResourceLoader(ResourceLoader* pLoader)
 static void queueBufferUpdate(ResourceLoader* pLoader, BufferUpdateDesc* pBufferUpdate, SyncToken* token)
 {
 	uint32_t nodeIndex = pBufferUpdate->pBuffer->mNodeIndex;
+	ASSERT(pBufferUpdate->mPriority < RESOURCE_PRIORITY_COUNT);
 	acquireMutex(&pLoader->mQueueMutex);
 
-	SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
+	uint64_t t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
 
-	pLoader->mRequestQueue[nodeIndex].emplace_back(UpdateRequest(*pBufferUpdate));
-	pLoader->mRequestQueue[nodeIndex].back().mWaitIndex = t;
-	pLoader->mRequestQueue[nodeIndex].back().pUploadBuffer = (pBufferUpdate->mInternal.mMappedRange.mFlags & MAPPED_RANGE_FLAG_TEMP_BUFFER)
+	pLoader->mRequestQueue[nodeIndex][pBufferUpdate->mPriority].emplace_back(UpdateRequest(*pBufferUpdate));
+	pLoader->mRequestQueue[nodeIndex][pBufferUpdate->mPriority].back().mWaitIndex = t;
+	pLoader->mRequestQueue[nodeIndex][pBufferUpdate->mPriority].back().pUploadBuffer = (pBufferUpdate->mInternal.mMappedRange.mFlags & MAPPED_RANGE_FLAG_TEMP_BUFFER)
 		? pBufferUpdate->mInternal.mMappedRange.pBuffer
 		: NULL;
 	releaseMutex(&pLoader->mQueueMutex);
 	wakeOneConditionVariable(&pLoader->mQueueCond);
-	if (token)
-		*token = max(t, *token);
+	util_merge_token(token, t, pBufferUpdate->mPriority);
 }
 
 static void queueTextureLoad(ResourceLoader* pLoader, TextureLoadDesc* pTextureUpdate, SyncToken* token)
 {
 	uint32_t nodeIndex = pTextureUpdate->mNodeIndex;
+
+	ResourceDecodeTask* pDecodeTask = NULL;
+	if (pLoader->pDecodeThreadSystem && util_is_texture_decodable(pTextureUpdate))
+	{
+		pDecodeTask = addDecodeTask(pLoader, UPDATE_REQUEST_LOAD_TEXTURE, nodeIndex);
+		pDecodeTask->mTextureLoadDesc = *pTextureUpdate;
+	}
+
+	ASSERT(pTextureUpdate->mPriority < RESOURCE_PRIORITY_COUNT);
 	acquireMutex(&pLoader->mQueueMutex);
 
-	SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
+	uint64_t t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
 
-	pLoader->mRequestQueue[nodeIndex].emplace_back(UpdateRequest(*pTextureUpdate));
-	pLoader->mRequestQueue[nodeIndex].back().mWaitIndex = t;
+	pLoader->mRequestQueue[nodeIndex][pTextureUpdate->mPriority].emplace_back(UpdateRequest(*pTextureUpdate));
+	pLoader->mRequestQueue[nodeIndex][pTextureUpdate->mPriority].back().mWaitIndex = t;
+	pLoader->mRequestQueue[nodeIndex][pTextureUpdate->mPriority].back().pDecodeTask = pDecodeTask;
 	releaseMutex(&pLoader->mQueueMutex);
+	if (pDecodeTask)
+	{
+		queueDecodeTask(pLoader, pDecodeTask);
+	}
 	wakeOneConditionVariable(&pLoader->mQueueCond);
-	if (token)
-		*token = max(t, *token);
+	util_merge_token(token, t, pTextureUpdate->mPriority);
 }
 
 static void queueGeometryLoad(ResourceLoader* pLoader, GeometryLoadDesc* pGeometryLoad, SyncToken* token)
 {
 	uint32_t nodeIndex = pGeometryLoad->mNodeIndex;
+
+	// With unified memory the workers pack straight into the mapped buffers, otherwise only on request, see allocateGeometryMemory
+	ResourceDecodeTask* pDecodeTask = NULL;
+	if (pLoader->pDecodeThreadSystem && (gUma || pLoader->mDesc.mDecodeGeometryOnWorkers))
+	{
+		pDecodeTask = addDecodeTask(pLoader, UPDATE_REQUEST_LOAD_GEOMETRY, nodeIndex);
+		pDecodeTask->mGeometryLoadDesc = *pGeometryLoad;
+	}
+
+	ASSERT(pGeometryLoad->mPriority < RESOURCE_PRIORITY_COUNT);
 	acquireMutex(&pLoader->mQueueMutex);
 
-	SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
+	uint64_t t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
 
-	pLoader->mRequestQueue[nodeIndex].emplace_back(UpdateRequest(*pGeometryLoad));
-	pLoader->mRequestQueue[nodeIndex].back().mWaitIndex = t;
+	pLoader->mRequestQueue[nodeIndex][pGeometryLoad->mPriority].emplace_back(UpdateRequest(*pGeometryLoad));
+	pLoader->mRequestQueue[nodeIndex][pGeometryLoad->mPriority].back().mWaitIndex = t;
+	pLoader->mRequestQueue[nodeIndex][pGeometryLoad->mPriority].back().pDecodeTask = pDecodeTask;
 	releaseMutex(&pLoader->mQueueMutex);
+	if (pDecodeTask)
+	{
+		queueDecodeTask(pLoader, pDecodeTask);
+	}
 	wakeOneConditionVariable(&pLoader->mQueueCond);
-	if (token)
-		*token = max(t, *token);
+	util_merge_token(token, t, pGeometryLoad->mPriority);
 }
 
-static void queueTextureUpdate(ResourceLoader* pLoader, TextureUpdateDescInternal* pTextureUpdate, SyncToken* token)
+static void queueTextureUpdate(ResourceLoader* pLoader, TextureUpdateDescInternal* pTextureUpdate, ResourcePriority priority, SyncToken* token)
 {
 	ASSERT(pTextureUpdate->mRange.pBuffer);
 
 	uint32_t nodeIndex = pTextureUpdate->pTexture->mNodeIndex;
+	ASSERT(priority < RESOURCE_PRIORITY_COUNT);
 	acquireMutex(&pLoader->mQueueMutex);
 
-	SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
+	uint64_t t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
 
-	pLoader->mRequestQueue[nodeIndex].emplace_back(UpdateRequest(*pTextureUpdate));
-	pLoader->mRequestQueue[nodeIndex].back().mWaitIndex = t;
-	pLoader->mRequestQueue[nodeIndex].back().pUploadBuffer =
+	pLoader->mRequestQueue[nodeIndex][priority].emplace_back(UpdateRequest(*pTextureUpdate));
+	pLoader->mRequestQueue[nodeIndex][priority].back().mWaitIndex = t;
+	pLoader->mRequestQueue[nodeIndex][priority].back().pUploadBuffer =
 		(pTextureUpdate->mRange.mFlags & MAPPED_RANGE_FLAG_TEMP_BUFFER) ? pTextureUpdate->mRange.pBuffer : NULL;
 	releaseMutex(&pLoader->mQueueMutex);
 	wakeOneConditionVariable(&pLoader->mQueueCond);
-	if (token)
-		*token = max(t, *token);
+	util_merge_token(token, t, priority);
 }
 
 #if defined(VULKAN)
-static void queueBufferBarrier(ResourceLoader* pLoader, Buffer* pBuffer, ResourceState state, SyncToken* token)
+static void queueBufferBarrier(ResourceLoader* pLoader, Buffer* pBuffer, ResourceState state, ResourcePriority priority, SyncToken* token)
 {
 	uint32_t nodeIndex = pBuffer->mNodeIndex;
+	ASSERT(priority < RESOURCE_PRIORITY_COUNT);
 	acquireMutex(&pLoader->mQueueMutex);
 
-	SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
+	uint64_t t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
 
-	pLoader->mRequestQueue[nodeIndex].emplace_back(UpdateRequest{ BufferBarrier{ pBuffer, RESOURCE_STATE_UNDEFINED, state } });
-	pLoader->mRequestQueue[nodeIndex].back().mWaitIndex = t;
+	pLoader->mRequestQueue[nodeIndex][priority].emplace_back(UpdateRequest{ BufferBarrier{ pBuffer, RESOURCE_STATE_UNDEFINED, state } });
+	pLoader->mRequestQueue[nodeIndex][priority].back().mWaitIndex = t;
 	releaseMutex(&pLoader->mQueueMutex);
 	wakeOneConditionVariable(&pLoader->mQueueCond);
-	if (token)
-		*token = max(t, *token);
+	util_merge_token(token, t, priority);
 }
 
-static void queueTextureBarrier(ResourceLoader* pLoader, Texture* pTexture, ResourceState state, SyncToken* token)
+static void queueTextureBarrier(ResourceLoader* pLoader, Texture* pTexture, ResourceState state, ResourcePriority priority, SyncToken* token)
 {
 	uint32_t nodeIndex = pTexture->mNodeIndex;
+	ASSERT(priority < RESOURCE_PRIORITY_COUNT);
 	acquireMutex(&pLoader->mQueueMutex);
 
-	SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
+	uint64_t t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
 
-	pLoader->mRequestQueue[nodeIndex].emplace_back(UpdateRequest{ TextureBarrier{ pTexture, RESOURCE_STATE_UNDEFINED, state } });
-	pLoader->mRequestQueue[nodeIndex].back().mWaitIndex = t;
+	pLoader->mRequestQueue[nodeIndex][priority].emplace_back(UpdateRequest{ TextureBarrier{ pTexture, RESOURCE_STATE_UNDEFINED, state } });
+	pLoader->mRequestQueue[nodeIndex][priority].back().mWaitIndex = t;
 	releaseMutex(&pLoader->mQueueMutex);
 	wakeOneConditionVariable(&pLoader->mQueueCond);
-	if (token)
-		*token = max(t, *token);
+	util_merge_token(token, t, priority);
 }
 #endif
 
@@ -2168,16 +3070,70 @@ static void queueTextureCopy(ResourceLoader* pLoader, TextureCopyDesc* pTextureC
 {
 	ASSERT(pTextureCopy->pTexture->mNodeIndex == pTextureCopy->pBuffer->mNodeIndex);
 	uint32_t nodeIndex = pTextureCopy->pTexture->mNodeIndex;
+	ASSERT(pTextureCopy->mPriority < RESOURCE_PRIORITY_COUNT);
 	acquireMutex(&pLoader->mQueueMutex);
 
-	SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
+	uint64_t t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
 
-	pLoader->mRequestQueue[nodeIndex].emplace_back(UpdateRequest(*pTextureCopy));
-	pLoader->mRequestQueue[nodeIndex].back().mWaitIndex = t;
+	pLoader->mRequestQueue[nodeIndex][pTextureCopy->mPriority].emplace_back(UpdateRequest(*pTextureCopy));
+	pLoader->mRequestQueue[nodeIndex][pTextureCopy->mPriority].back().mWaitIndex = t;
 	releaseMutex(&pLoader->mQueueMutex);
 	wakeOneConditionVariable(&pLoader->mQueueCond);
-	if (token)
-		*token = max(t, *token);
+	util_merge_token(token, t, pTextureCopy->mPriority);
+}
+
+static bool cancelLoadRequest(UpdateRequest* pRequest)
+{
+	if (UPDATE_REQUEST_LOAD_TEXTURE != pRequest->mType && UPDATE_REQUEST_LOAD_GEOMETRY != pRequest->mType)
+	{
+		// Updates, copies and barriers can be relied upon by later requests
+		return false;
+	}
+
+	// A started decode runs to completion: geometry decodes create the buffers and hand them out through ppGeometry,
+	// texture decodes load the file the streamer then uploads
+	ResourceDecodeTask* pDecodeTask = pRequest->pDecodeTask;
+	if (pDecodeTask &&
+		DECODE_TASK_STATE_PENDING != tfrg_atomic32_cas_relaxed(&pDecodeTask->mState, DECODE_TASK_STATE_PENDING, DECODE_TASK_STATE_CANCELLED))
+	{
+		return false;
+	}
+
+	if (UPDATE_REQUEST_LOAD_GEOMETRY == pRequest->mType)
+	{
+		tf_free(pRequest->geomLoadDesc.pVertexLayout);
+	}
+
+	pRequest->mType = UPDATE_REQUEST_INVALID;
+	return true;
+}
+
+static bool cancelResourceLoad(ResourceLoader* pLoader, const SyncToken* token)
+{
+	// Tokens of one load have a single class, see cancelResourceLoad in IResourceLoader.h for tokens covering several loads
+	const uint32_t classMask = (uint32_t)(*token & SYNC_TOKEN_ALL_CLASSES);
+	ASSERT(!(classMask & (classMask - 1)) && "cancelResourceLoad needs the token of a single load");
+
+	// Requests the streamer already swapped into its active batch are not in the queues anymore and can't be cancelled
+	acquireMutex(&pLoader->mQueueMutex);
+	for (uint32_t i = 0; i < pLoader->mGpuCount; ++i)
+	{
+		for (uint32_t priority = 0; priority < RESOURCE_PRIORITY_COUNT; ++priority)
+		{
+			for (UpdateRequest& request : pLoader->mRequestQueue[i][priority])
+			{
+				if (request.mWaitIndex == util_get_token_counter(*token))
+				{
+					bool cancelled = cancelLoadRequest(&request);
+					releaseMutex(&pLoader->mQueueMutex);
+					return cancelled;
+				}
+			}
+		}
+	}
+	releaseMutex(&pLoader->mQueueMutex);
+
+	return false;
 }
 
 static void waitForToken(ResourceLoader* pLoader, const SyncToken* token)
@@ -2258,6 +3214,7 @@ void addResource(BufferLoadDesc* pBufferDesc, SyncToken* token)
 
 			BufferUpdateDesc updateDesc = {};
 			updateDesc.pBuffer = *pBufferDesc->ppBuffer;
+			updateDesc.mPriority = pBufferDesc->mPriority;
 			for (uint64_t offset = 0; offset < pBufferDesc->mDesc.mSize; offset += stagingBufferSize)
 			{
 				size_t chunkSize = (size_t)min(stagingBufferSize, pBufferDesc->mDesc.mSize - offset);
@@ -2280,6 +3237,7 @@ void addResource(BufferLoadDesc* pBufferDesc, SyncToken* token)
 		{
 			BufferUpdateDesc updateDesc = {};
 			updateDesc.pBuffer = *pBufferDesc->ppBuffer;
+			updateDesc.mPriority = pBufferDesc->mPriority;
 			beginUpdateResource(&updateDesc);
 			if (pBufferDesc->mForceReset)
 			{
@@ -2301,7 +3259,7 @@ void addResource(BufferLoadDesc* pBufferDesc, SyncToken* token)
 		if (gSelectedRendererApi == RENDERER_API_VULKAN && pBufferDesc->mDesc.mMemoryUsage == RESOURCE_MEMORY_USAGE_GPU_ONLY &&
 			// Check whether this is required (user specified a state other than undefined / common)
 			(pBufferDesc->mDesc.mStartState != RESOURCE_STATE_UNDEFINED && pBufferDesc->mDesc.mStartState != RESOURCE_STATE_COMMON))
-			queueBufferBarrier(pResourceLoader, *pBufferDesc->ppBuffer, pBufferDesc->mDesc.mStartState, token);
+			queueBufferBarrier(pResourceLoader, *pBufferDesc->ppBuffer, pBufferDesc->mDesc.mStartState, pBufferDesc->mPriority, token);
 #endif
 	}
 }
@@ -2327,7 +3285,7 @@ void addResource(TextureLoadDesc* pTextureDesc, SyncToken* token)
 			{
 				startState = util_determine_resource_start_state(pTextureDesc->pDesc->mDescriptors & DESCRIPTOR_TYPE_RW_TEXTURE);
 			}
-			queueTextureBarrier(pResourceLoader, *pTextureDesc->ppTexture, startState, token);
+			queueTextureBarrier(pResourceLoader, *pTextureDesc->ppTexture, startState, pTextureDesc->mPriority, token);
 		}
 #endif
 	}
@@ -2465,7 +3423,7 @@ void endUpdateResource(TextureUpdateDesc* pTextureUpdate, SyncToken* token)
 	desc.mMipLevels = 1;
 	desc.mBaseArrayLayer = pTextureUpdate->mArrayLayer;
 	desc.mLayerCount = 1;
-	queueTextureUpdate(pResourceLoader, &desc, token);
+	queueTextureUpdate(pResourceLoader, &desc, pTextureUpdate->mPriority, token);
 
 	// Restore the state to before the beginUpdateResource call.
 	pTextureUpdate->pMappedData = NULL;
@@ -2485,27 +3443,61 @@ void copyResource(TextureCopyDesc* pTextureDesc, SyncToken* token)
 	}
 }
 
-SyncToken getLastTokenCompleted() { return tfrg_atomic64_load_acquire(&pResourceLoader->mTokenCompleted); }
+bool cancelResourceLoad(const SyncToken* token)
+{
+	ASSERT(token);
+	return cancelResourceLoad(pResourceLoader, token);
+}
+
+void getResourceLoaderStats(ResourceLoaderStats* pOutStats)
+{
+	ASSERT(pOutStats);
+	*pOutStats = {};
+	for (uint32_t i = 0; i < pResourceLoader->mGpuCount; ++i)
+	{
+		CopyEngineStats& stats = pResourceLoader->pCopyEngines[i].mStats;
+		pOutStats->mStagingBytesInUse += tfrg_atomic64_load_relaxed(&stats.mStagingBytesInUse);
+		pOutStats->mStagingPeakBytesInUse += tfrg_atomic64_load_relaxed(&stats.mStagingPeakBytesInUse);
+		pOutStats->mStagingBytesAllocated += tfrg_atomic64_load_relaxed(&stats.mStagingBytesAllocated);
+		pOutStats->mStagingPeakBytesAllocated += tfrg_atomic64_load_relaxed(&stats.mStagingPeakBytesAllocated);
+		pOutStats->mStagingPageAllocations += tfrg_atomic32_load_relaxed(&stats.mStagingPageAllocations);
+		pOutStats->mStagingPageReleases += tfrg_atomic32_load_relaxed(&stats.mStagingPageReleases);
+		pOutStats->mStagingOversizedAllocations += tfrg_atomic32_load_relaxed(&stats.mStagingOversizedAllocations);
+		pOutStats->mStagingWaits += tfrg_atomic32_load_relaxed(&stats.mStagingWaits);
+	}
+
+	acquireMutex(&pResourceLoader->mDecodeMutex);
+	pOutStats->mDecodeBytesInFlight = pResourceLoader->mDecodeBytesInFlight;
+	pOutStats->mDecodePeakBytesInFlight = pResourceLoader->mDecodePeakBytesInFlight;
+	releaseMutex(&pResourceLoader->mDecodeMutex);
+}
+
+SyncToken combineSyncTokens(SyncToken a, SyncToken b)
+{
+	return util_make_token(max(util_get_token_counter(a), util_get_token_counter(b)), (uint32_t)((a | b) & SYNC_TOKEN_ALL_CLASSES));
+}
+
+SyncToken getLastTokenCompleted() { return util_get_last_token(pResourceLoader->mTokenCompleted); }
 
-bool isTokenCompleted(const SyncToken* token) { return *token <= tfrg_atomic64_load_acquire(&pResourceLoader->mTokenCompleted); }
+bool isTokenCompleted(const SyncToken* token) { return util_is_token_reached(pResourceLoader->mTokenCompleted, *token); }
 
 void waitForToken(const SyncToken* token) { waitForToken(pResourceLoader, token); }
 
-SyncToken getLastTokenSubmitted() { return tfrg_atomic64_load_acquire(&pResourceLoader->mTokenSubmitted); }
+SyncToken getLastTokenSubmitted() { return util_get_last_token(pResourceLoader->mTokenSubmitted); }
 
-bool isTokenSubmitted(const SyncToken* token) { return *token <= tfrg_atomic64_load_acquire(&pResourceLoader->mTokenSubmitted); }
+bool isTokenSubmitted(const SyncToken* token) { return util_is_token_reached(pResourceLoader->mTokenSubmitted, *token); }
 
 void waitForTokenSubmitted(const SyncToken* token) { waitForTokenSubmitted(pResourceLoader, token); }
 
 bool allResourceLoadsCompleted()
 {
-	SyncToken token = tfrg_atomic64_load_relaxed(&pResourceLoader->mTokenCounter);
-	return token <= tfrg_atomic64_load_acquire(&pResourceLoader->mTokenCompleted);
+	SyncToken token = util_make_token(tfrg_atomic64_load_relaxed(&pResourceLoader->mTokenCounter), SYNC_TOKEN_ALL_CLASSES);
+	return isTokenCompleted(&token);
 }
 
 void waitForAllResourceLoads()
 {
-	SyncToken token = tfrg_atomic64_load_relaxed(&pResourceLoader->mTokenCounter);
+	SyncToken token = util_make_token(tfrg_atomic64_load_relaxed(&pResourceLoader->mTokenCounter), SYNC_TOKEN_ALL_CLASSES);
 	waitForToken(pResourceLoader, &token);
 }
 
@@ -3528,6 +4520,337 @@ void addShader(Renderer* pRenderer, const ShaderLoadDesc* pDesc, Shader** ppShad
 	addIosShader(pRenderer, &desc, ppShader);
 #endif
 }
+/************************************************************************/
+// Asynchronous pipeline compilation
+/************************************************************************/
+static inline void util_key_push_pointer(eastl::vector<uint32_t>& key, const void* ptr)
+{
+	const uint64_t value = (uint64_t)(uintptr_t)ptr;
+	key.push_back((uint32_t)value);
+	key.push_back((uint32_t)(value >> 32));
+}
+
+/// Flattens everything that affects the compiled pipeline. Debug names and the pipeline cache do not.
+/// Shaders and root signatures are identified by their ids since a removed object's address can be reused.
+/// Cached pipelines have to be removed before their renderer, so the renderer address can not go stale.
+static void util_get_pipeline_key(Renderer* pRenderer, const PipelineDesc* pDesc, eastl::vector<uint32_t>& key)
+{
+	util_key_push_pointer(key, pRenderer);
+	key.push_back((uint32_t)pDesc->mType);
+
+	if (pDesc->mType == PIPELINE_TYPE_COMPUTE)
+	{
+		key.push_back(pDesc->mComputeDesc.pShaderProgram->mVulkan.mId);
+		key.push_back(pDesc->mComputeDesc.pRootSignature->mVulkan.mId);
+		return;
+	}
+
+	ASSERT(pDesc->mType == PIPELINE_TYPE_GRAPHICS);
+	const GraphicsPipelineDesc* pGraphics = &pDesc->mGraphicsDesc;
+	key.push_back(pGraphics->pShaderProgram->mVulkan.mId);
+	key.push_back(pGraphics->pRootSignature->mVulkan.mId);
+
+	key.push_back(pGraphics->pVertexLayout != NULL);
+	if (const VertexLayout* pLayout = pGraphics->pVertexLayout)
+	{
+		key.push_back(pLayout->mAttribCount);
+		for (uint32_t i = 0; i < pLayout->mAttribCount; ++i)
+		{
+			const VertexAttrib* pAttrib = &pLayout->mAttribs[i];
+			key.push_back((uint32_t)pAttrib->mSemantic);
+			key.push_back((uint32_t)tf_mem_hash<char>(pAttrib->mSemanticName, pAttrib->mSemanticNameLength));
+			key.push_back((uint32_t)pAttrib->mFormat);
+			key.push_back(pAttrib->mBinding);
+			key.push_back(pAttrib->mLocation);
+			key.push_back(pAttrib->mOffset);
+			key.push_back((uint32_t)pAttrib->mRate);
+		}
+		for (uint32_t i = 0; i < MAX_VERTEX_BINDINGS; ++i)
+			key.push_back(pLayout->mStrides[i]);
+	}
+
+	key.push_back(pGraphics->pBlendState != NULL);
+	if (const BlendStateDesc* pBlend = pGraphics->pBlendState)
+	{
+		for (uint32_t i = 0; i < MAX_RENDER_TARGET_ATTACHMENTS; ++i)
+		{
+			key.push_back((uint32_t)pBlend->mSrcFactors[i]);
+			key.push_back((uint32_t)pBlend->mDstFactors[i]);
+			key.push_back((uint32_t)pBlend->mSrcAlphaFactors[i]);
+			key.push_back((uint32_t)pBlend->mDstAlphaFactors[i]);
+			key.push_back((uint32_t)pBlend->mBlendModes[i]);
+			key.push_back((uint32_t)pBlend->mBlendAlphaModes[i]);
+			key.push_back((uint32_t)pBlend->mMasks[i]);
+		}
+		key.push_back((uint32_t)pBlend->mRenderTargetMask);
+		key.push_back(pBlend->mAlphaToCoverage | (pBlend->mIndependentBlend << 1));
+	}
+
+	key.push_back(pGraphics->pDepthState != NULL);
+	if (const DepthStateDesc* pDepth = pGraphics->pDepthState)
+	{
+		key.push_back(pDepth->mDepthTest | (pDepth->mDepthWrite << 1) | (pDepth->mStencilTest << 2));
+		key.push_back(pDepth->mStencilReadMask | (pDepth->mStencilWriteMask << 8));
+		key.push_back((uint32_t)pDepth->mDepthFunc);
+		key.push_back((uint32_t)pDepth->mStencilFrontFunc);
+		key.push_back((uint32_t)pDepth->mStencilFrontFail);
+		key.push_back((uint32_t)pDepth->mDepthFrontFail);
+		key.push_back((uint32_t)pDepth->mStencilFrontPass);
+		key.push_back((uint32_t)pDepth->mStencilBackFunc);
+		key.push_back((uint32_t)pDepth->mStencilBackFail);
+		key.push_back((uint32_t)pDepth->mDepthBackFail);
+		key.push_back((uint32_t)pDepth->mStencilBackPass);
+	}
+
+	key.push_back(pGraphics->pRasterizerState != NULL);
+	if (const RasterizerStateDesc* pRasterizer = pGraphics->pRasterizerState)
+	{
+		uint32_t slopeScaledDepthBias = 0;
+		memcpy(&slopeScaledDepthBias, &pRasterizer->mSlopeScaledDepthBias, sizeof(float));
+		key.push_back((uint32_t)pRasterizer->mCullMode);
+		key.push_back((uint32_t)pRasterizer->mDepthBias);
+		key.push_back(slopeScaledDepthBias);
+		key.push_back((uint32_t)pRasterizer->mFillMode);
+		key.push_back((uint32_t)pRasterizer->mFrontFace);
+		key.push_back(pRasterizer->mMultiSample | (pRasterizer->mScissor << 1) | (pRasterizer->mDepthClampEnable << 2));
+	}
+
+	key.push_back(pGraphics->mRenderTargetCount);
+	for (uint32_t i = 0; i < pGraphics->mRenderTargetCount; ++i)
+		key.push_back((uint32_t)pGraphics->pColorFormats[i]);
+	key.push_back((uint32_t)pGraphics->mSampleCount);
+	key.push_back(pGraphics->mSampleQuality);
+	key.push_back((uint32_t)pGraphics->mDepthStencilFormat);
+	key.push_back((uint32_t)pGraphics->mPrimitiveTopo);
+	key.push_back(pGraphics->mSupportIndirectCommandBuffer | (pGraphics->mVRFoveatedRendering << 1));
+}
+
+static void util_copy_pipeline_desc(PipelineCacheEntry* pEntry, const PipelineDesc* pDesc)
+{
+	pEntry->mDesc = *pDesc;
+	pEntry->mDesc.pName = NULL;
+	if (pDesc->pName)
+	{
+		strncpy(pEntry->mName, pDesc->pName, MAX_DEBUG_NAME_LENGTH - 1);
+		pEntry->mDesc.pName = pEntry->mName;
+	}
+
+	if (pDesc->mType != PIPELINE_TYPE_GRAPHICS)
+		return;
+
+	const GraphicsPipelineDesc* pSrc = &pDesc->mGraphicsDesc;
+	GraphicsPipelineDesc*       pDst = &pEntry->mDesc.mGraphicsDesc;
+	if (pSrc->pVertexLayout)
+	{
+		pEntry->mVertexLayout = *pSrc->pVertexLayout;
+		pDst->pVertexLayout = &pEntry->mVertexLayout;
+	}
+	if (pSrc->pBlendState)
+	{
+		pEntry->mBlendState = *pSrc->pBlendState;
+		pDst->pBlendState = &pEntry->mBlendState;
+	}
+	if (pSrc->pDepthState)
+	{
+		pEntry->mDepthState = *pSrc->pDepthState;
+		pDst->pDepthState = &pEntry->mDepthState;
+	}
+	if (pSrc->pRasterizerState)
+	{
+		pEntry->mRasterizerState = *pSrc->pRasterizerState;
+		pDst->pRasterizerState = &pEntry->mRasterizerState;
+	}
+	ASSERT(pSrc->mRenderTargetCount <= MAX_RENDER_TARGET_ATTACHMENTS);
+	if (pSrc->mRenderTargetCount)
+	{
+		memcpy(pEntry->mColorFormats, pSrc->pColorFormats, pSrc->mRenderTargetCount * sizeof(TinyImageFormat));
+		pDst->pColorFormats = pEntry->mColorFormats;
+	}
+}
+
+static Pipeline* util_compile_pipeline(PipelineCacheEntry* pEntry, float* pCompileTime)
+{
+	Pipeline*     pPipeline = NULL;
+	const int64_t startTime = getUSec(false);
+	{
+		PROFILER_SET_CPU_SCOPE("Pipelines", "Compile", 0xffd08020);
+		vk_addPipeline(pEntry->pRenderer, &pEntry->mDesc, &pPipeline);
+	}
+	*pCompileTime = (float)(getUSec(false) - startTime) / 1000.0f;
+	ASSERT(pPipeline);
+	return pPipeline;
+}
+
+/// Hands the compiled pipeline to every request waiting for it. Must be called inside mPipelineMutex
+static void util_publish_pipeline(ResourceLoader* pLoader, PipelineCacheEntry* pEntry, Pipeline* pPipeline, float compileTime)
+{
+	pEntry->pPipeline = pPipeline;
+	for (uint32_t i = 0; i < (uint32_t)pEntry->mOutputs.size(); ++i)
+		*pEntry->mOutputs[i] = pPipeline;
+	pEntry->mOutputs.set_capacity(0);
+	pLoader->mPipelineEntries[pPipeline] = pEntry;
+
+	PipelineCompileStats* pStats = &pLoader->mPipelineStats;
+	++pStats->mCompiles;
+	--pStats->mPendingCompiles;
+	pStats->mTotalCompileTime += compileTime;
+	pStats->mMaxCompileTime = max(pStats->mMaxCompileTime, compileTime);
+}
+
+static void compilePipelineTaskFunc(void* pUser, uintptr_t)
+{
+	PipelineCacheEntry* pEntry = (PipelineCacheEntry*)pUser;
+	ResourceLoader*     pLoader = pEntry->pLoader;
+
+	float     compileTime = 0.0f;
+	Pipeline* pPipeline = util_compile_pipeline(pEntry, &compileTime);
+
+	acquireMutex(&pLoader->mPipelineMutex);
+	util_publish_pipeline(pLoader, pEntry, pPipeline, compileTime);
+	releaseMutex(&pLoader->mPipelineMutex);
+
+	// The streamer signals the token once every older request is done as well
+	acquireMutex(&pLoader->mQueueMutex);
+	pLoader->mPipelineTokens.erase(eastl::find(pLoader->mPipelineTokens.begin(), pLoader->mPipelineTokens.end(), pEntry->mToken));
+	releaseMutex(&pLoader->mQueueMutex);
+	wakeOneConditionVariable(&pLoader->mQueueCond);
+}
+
+void addPipeline(Renderer* pRenderer, const PipelineDesc* pDesc, Pipeline** ppPipeline, SyncToken* token)
+{
+	ASSERT(pResourceLoader);
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+	ASSERT(ppPipeline);
+
+	ResourceLoader* pLoader = pResourceLoader;
+
+	// Raytracing pipelines and extensions can not be copied or compared generically, compile them right away without caching
+	if ((pDesc->mType != PIPELINE_TYPE_GRAPHICS && pDesc->mType != PIPELINE_TYPE_COMPUTE) || pDesc->mExtensionCount)
+	{
+		vk_addPipeline(pRenderer, pDesc, ppPipeline);
+		return;
+	}
+
+	eastl::vector<uint32_t> key;
+	key.reserve(128);
+	util_get_pipeline_key(pRenderer, pDesc, key);
+	const uint32_t hash = (uint32_t)tf_mem_hash<uint32_t>(key.data(), key.size());
+
+	acquireMutex(&pLoader->mPipelineMutex);
+	++pLoader->mPipelineStats.mRequests;
+
+	eastl::hash_map<uint32_t, PipelineCacheEntry*>::iterator it = pLoader->mPipelineCache.find(hash);
+	PipelineCacheEntry* pEntry = it != pLoader->mPipelineCache.end() ? it->second : NULL;
+	while (pEntry && pEntry->mKey != key)
+		pEntry = pEntry->pNext;
+
+	if (pEntry)
+	{
+		++pEntry->mRefCount;
+		++pLoader->mPipelineStats.mCacheHits;
+		// Compiles on a calling thread have no token to hand out, wait for that thread to publish instead
+		while (!pEntry->pPipeline && !pEntry->mToken)
+			waitConditionVariable(&pLoader->mPipelineCond, &pLoader->mPipelineMutex, TIMEOUT_INFINITE);
+		if (pEntry->pPipeline)
+			*ppPipeline = pEntry->pPipeline;
+		else
+			pEntry->mOutputs.push_back(ppPipeline);
+		const uint64_t t = pEntry->mToken;
+		releaseMutex(&pLoader->mPipelineMutex);
+		if (t)
+			util_merge_token(token, t, SYNC_TOKEN_CLASS_PIPELINE);
+		return;
+	}
+
+	pEntry = tf_new(PipelineCacheEntry);
+	ASSERT(pEntry);
+	pEntry->pRenderer = pRenderer;
+	pEntry->pLoader = pLoader;
+	pEntry->mHash = hash;
+	pEntry->mRefCount = 1;
+	pEntry->mKey.swap(key);
+	pEntry->mOutputs.push_back(ppPipeline);
+	pEntry->pNext = it != pLoader->mPipelineCache.end() ? it->second : NULL;
+	pLoader->mPipelineCache[hash] = pEntry;
+	++pLoader->mPipelineStats.mPendingCompiles;
+	++pLoader->mPipelineStats.mPipelineCount;
+	util_copy_pipeline_desc(pEntry, pDesc);
+
+	if (!pLoader->pPipelineThreadSystem)
+	{
+		// The pending entry is in the cache already, compile outside the lock so other descriptions are not blocked
+		releaseMutex(&pLoader->mPipelineMutex);
+		float     compileTime = 0.0f;
+		Pipeline* pPipeline = util_compile_pipeline(pEntry, &compileTime);
+
+		acquireMutex(&pLoader->mPipelineMutex);
+		util_publish_pipeline(pLoader, pEntry, pPipeline, compileTime);
+		releaseMutex(&pLoader->mPipelineMutex);
+		wakeAllConditionVariable(&pLoader->mPipelineCond);
+		return;
+	}
+
+	acquireMutex(&pLoader->mQueueMutex);
+	pEntry->mToken = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
+	pLoader->mPipelineTokens.push_back(pEntry->mToken);
+	releaseMutex(&pLoader->mQueueMutex);
+	const uint64_t t = pEntry->mToken;
+	releaseMutex(&pLoader->mPipelineMutex);
+
+	addThreadSystemTask(pLoader->pPipelineThreadSystem, compilePipelineTaskFunc, pEntry);
+	util_merge_token(token, t, SYNC_TOKEN_CLASS_PIPELINE);
+}
+
+void removePipeline(Renderer* pRenderer, Pipeline* pPipeline)
+{
+	ASSERT(pResourceLoader);
+	ASSERT(pPipeline);
+
+	ResourceLoader* pLoader = pResourceLoader;
+	acquireMutex(&pLoader->mPipelineMutex);
+
+	eastl::hash_map<Pipeline*, PipelineCacheEntry*>::iterator it = pLoader->mPipelineEntries.find(pPipeline);
+	if (it == pLoader->mPipelineEntries.end())
+	{
+		// Pipeline that bypassed the cache
+		releaseMutex(&pLoader->mPipelineMutex);
+		vk_removePipeline(pRenderer, pPipeline);
+		return;
+	}
+
+	PipelineCacheEntry* pEntry = it->second;
+	ASSERT(pEntry->pRenderer == pRenderer);
+	if (--pEntry->mRefCount)
+	{
+		releaseMutex(&pLoader->mPipelineMutex);
+		return;
+	}
+
+	pLoader->mPipelineEntries.erase(it);
+	PipelineCacheEntry** ppLink = &pLoader->mPipelineCache[pEntry->mHash];
+	while (*ppLink != pEntry)
+		ppLink = &(*ppLink)->pNext;
+	*ppLink = pEntry->pNext;
+	if (!pLoader->mPipelineCache[pEntry->mHash])
+		pLoader->mPipelineCache.erase(pEntry->mHash);
+	--pLoader->mPipelineStats.mPipelineCount;
+	releaseMutex(&pLoader->mPipelineMutex);
+
+	vk_removePipeline(pRenderer, pPipeline);
+	tf_delete(pEntry);
+}
+
+void getPipelineCompileStats(PipelineCompileStats* pOutStats)
+{
+	ASSERT(pResourceLoader);
+	ASSERT(pOutStats);
+
+	acquireMutex(&pResourceLoader->mPipelineMutex);
+	*pOutStats = pResourceLoader->mPipelineStats;
+	releaseMutex(&pResourceLoader->mPipelineMutex);
+}
+
 /************************************************************************/
 // Pipeline cache save, load
 /************************************************************************/
@@ -0,0 +1,431 @@
+/*
+ * Copyright (c) 2017-2022 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+// Vertex attribute packing used by the geometry loader, in a header of its own so the SIMD paths can be tested against the scalar one
+
+#include "../../OS/Core/Config.h"
+#include "../../OS/Math/MathTypes.h"
+
+#if defined(ARCH_X86_FAMILY)
+#include <immintrin.h>
+#endif
+
+#define F16_EXPONENT_BITS 0x1F
+#define F16_EXPONENT_SHIFT 10
+#define F16_EXPONENT_BIAS 15
+#define F16_MANTISSA_BITS 0x3ff
+#define F16_MANTISSA_SHIFT (23 - F16_EXPONENT_SHIFT)
+#define F16_MAX_EXPONENT (F16_EXPONENT_BITS << F16_EXPONENT_SHIFT)
+
+static inline uint16_t util_float_to_half(float val)
+{
+	uint32_t f32 = (*(uint32_t*)&val);
+	uint16_t f16 = 0;
+	/* Decode IEEE 754 little-endian 32-bit floating-point value */
+	int sign = (f32 >> 16) & 0x8000;
+	/* Map exponent to the range [-127,128] */
+	int exponent = ((f32 >> 23) & 0xff) - 127;
+	int mantissa = f32 & 0x007fffff;
+	if (exponent == 128)
+	{ /* Infinity or NaN */
+		f16 = (uint16_t)(sign | F16_MAX_EXPONENT);
+		if (mantissa)
+			f16 |= (mantissa & F16_MANTISSA_BITS);
+	}
+	else if (exponent > 15)
+	{ /* Overflow - flush to Infinity */
+		f16 = (unsigned short)(sign | F16_MAX_EXPONENT);
+	}
+	else if (exponent > -15)
+	{ /* Representable value */
+		exponent += F16_EXPONENT_BIAS;
+		mantissa >>= F16_MANTISSA_SHIFT;
+		f16 = (unsigned short)(sign | exponent << F16_EXPONENT_SHIFT | mantissa);
+	}
+	else
+	{
+		f16 = (unsigned short)sign;
+	}
+	return f16;
+}
+
+static inline uint32_t util_float2_to_unorm2x16(const float* v)
+{
+	uint32_t x = (uint32_t)round(clamp(v[0], 0, 1) * 65535.0f);
+	uint32_t y = (uint32_t)round(clamp(v[1], 0, 1) * 65535.0f);
+	return ((uint32_t)0x0000FFFF & x) | ((y << 16) & (uint32_t)0xFFFF0000);
+}
+
+#define OCT_WRAP(v, w) ((1.0f - abs((w))) * ((v) >= 0.0f ? 1.0f : -1.0f))
+
+static inline uint32_t util_float3_direction_to_oct_unorm2x16(const float* v)
+{
+	float absLength = (abs(v[0]) + abs(v[1]) + abs(v[2]));
+	if (!absLength)
+	{
+		return 0;
+	}
+
+	float enc[3] = { v[0] / absLength, v[1] / absLength, v[2] / absLength };
+	if (enc[2] < 0)
+	{
+		float oldX = enc[0];
+		enc[0] = OCT_WRAP(enc[0], enc[1]);
+		enc[1] = OCT_WRAP(enc[1], oldX);
+	}
+	enc[0] = enc[0] * 0.5f + 0.5f;
+	enc[1] = enc[1] * 0.5f + 0.5f;
+	return util_float2_to_unorm2x16(enc);
+}
+
+// Vertex packing kernels
+// Each kernel converts `count` vertices reading `srcStride` bytes apart and writing `dstStride` bytes apart starting at `dst + offset`.
+// The SIMD variants produce the exact same bits as the scalar ones so the selected path never changes the vertex data
+static void util_pack_float2_to_half2_scalar(uint32_t count, uint32_t srcStride, uint32_t dstStride, uint32_t offset, const uint8_t* src, uint8_t* dst)
+{
+	dst += offset;
+	for (uint32_t e = 0; e < count; ++e)
+	{
+		const float* f = (const float*)(src + e * srcStride);
+		*(uint32_t*)(dst + e * dstStride) = ((util_float_to_half(f[0]) & 0x0000FFFF) | ((util_float_to_half(f[1]) << 16) & 0xFFFF0000));
+	}
+}
+
+static void util_pack_float3_direction_to_half2_scalar(uint32_t count, uint32_t srcStride, uint32_t dstStride, uint32_t offset, const uint8_t* src, uint8_t* dst)
+{
+	dst += offset;
+	for (uint32_t e = 0; e < count; ++e)
+	{
+		*(uint32_t*)(dst + e * dstStride) = util_float3_direction_to_oct_unorm2x16((const float*)(src + e * srcStride));
+	}
+}
+
+#if defined(ARCH_X86_FAMILY)
+#if defined(_MSC_VER) && !defined(__clang__)
+#define VERTEX_PACKING_TARGET(isa)
+#else
+#define VERTEX_PACKING_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+// Same truncation, denormal flush and NaN handling as util_float_to_half, four values at a time
+VERTEX_PACKING_TARGET("sse4.1")
+static inline __m128i util_float4_to_half4_sse41(__m128 v)
+{
+	const __m128i f = _mm_castps_si128(v);
+	const __m128i sign = _mm_and_si128(_mm_srli_epi32(f, 16), _mm_set1_epi32(0x8000));
+	const __m128i exponent = _mm_and_si128(_mm_srli_epi32(f, 23), _mm_set1_epi32(0xff));
+	const __m128i mantissa = _mm_and_si128(f, _mm_set1_epi32(0x007fffff));
+
+	const __m128i normal = _mm_or_si128(
+		sign, _mm_or_si128(
+				  _mm_slli_epi32(_mm_sub_epi32(exponent, _mm_set1_epi32(127 - F16_EXPONENT_BIAS)), F16_EXPONENT_SHIFT),
+				  _mm_srli_epi32(mantissa, F16_MANTISSA_SHIFT)));
+	const __m128i infinity = _mm_or_si128(sign, _mm_set1_epi32(F16_MAX_EXPONENT));
+	const __m128i nan = _mm_or_si128(infinity, _mm_and_si128(mantissa, _mm_set1_epi32(F16_MANTISSA_BITS)));
+
+	__m128i h = sign;
+	h = _mm_blendv_epi8(h, normal, _mm_cmpgt_epi32(exponent, _mm_set1_epi32(127 - F16_EXPONENT_BIAS)));
+	h = _mm_blendv_epi8(h, infinity, _mm_cmpgt_epi32(exponent, _mm_set1_epi32(127 + F16_EXPONENT_BIAS)));
+	h = _mm_blendv_epi8(h, nan, _mm_cmpeq_epi32(exponent, _mm_set1_epi32(0xff)));
+	return h;
+}
+
+// Matches util_float2_to_unorm2x16 including round half away from zero, returns x | y << 16 per lane
+VERTEX_PACKING_TARGET("sse4.1")
+static inline __m128i util_float4x2_to_unorm2x16_sse41(__m128 x, __m128 y)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 scale = _mm_set1_ps(65535.0f);
+
+	x = _mm_mul_ps(_mm_min_ps(_mm_max_ps(x, zero), one), scale);
+	y = _mm_mul_ps(_mm_min_ps(_mm_max_ps(y, zero), one), scale);
+	__m128 rx = _mm_round_ps(x, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+	__m128 ry = _mm_round_ps(y, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+	rx = _mm_add_ps(rx, _mm_and_ps(_mm_cmpge_ps(_mm_sub_ps(x, rx), half), one));
+	ry = _mm_add_ps(ry, _mm_and_ps(_mm_cmpge_ps(_mm_sub_ps(y, ry), half), one));
+	return _mm_or_si128(_mm_cvttps_epi32(rx), _mm_slli_epi32(_mm_cvttps_epi32(ry), 16));
+}
+
+// Matches util_float3_direction_to_oct_unorm2x16 for four directions
+VERTEX_PACKING_TARGET("sse4.1")
+static inline __m128i util_float4x3_direction_to_oct_unorm2x16_sse41(__m128 x, __m128 y, __m128 z)
+{
+	const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 minusOne = _mm_set1_ps(-1.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+
+	const __m128 absLength = _mm_add_ps(_mm_add_ps(_mm_and_ps(x, absMask), _mm_and_ps(y, absMask)), _mm_and_ps(z, absMask));
+	const __m128 valid = _mm_cmpneq_ps(absLength, zero);
+
+	__m128 encX = _mm_div_ps(x, absLength);
+	__m128 encY = _mm_div_ps(y, absLength);
+	__m128 encZ = _mm_div_ps(z, absLength);
+
+	const __m128 wrapX = _mm_mul_ps(_mm_sub_ps(one, _mm_and_ps(encY, absMask)), _mm_blendv_ps(minusOne, one, _mm_cmpge_ps(encX, zero)));
+	const __m128 wrapY = _mm_mul_ps(_mm_sub_ps(one, _mm_and_ps(encX, absMask)), _mm_blendv_ps(minusOne, one, _mm_cmpge_ps(encY, zero)));
+	const __m128 wrap = _mm_cmplt_ps(encZ, zero);
+	encX = _mm_blendv_ps(encX, wrapX, wrap);
+	encY = _mm_blendv_ps(encY, wrapY, wrap);
+
+	encX = _mm_add_ps(_mm_mul_ps(encX, half), half);
+	encY = _mm_add_ps(_mm_mul_ps(encY, half), half);
+	return _mm_and_si128(util_float4x2_to_unorm2x16_sse41(encX, encY), _mm_castps_si128(valid));
+}
+
+VERTEX_PACKING_TARGET("sse4.1")
+static inline void util_store_strided4_sse41(__m128i v, uint32_t dstStride, uint8_t* dst)
+{
+	if (sizeof(uint32_t) == dstStride)
+	{
+		_mm_storeu_si128((__m128i*)dst, v);
+		return;
+	}
+	*(uint32_t*)(dst + 0 * dstStride) = (uint32_t)_mm_extract_epi32(v, 0);
+	*(uint32_t*)(dst + 1 * dstStride) = (uint32_t)_mm_extract_epi32(v, 1);
+	*(uint32_t*)(dst + 2 * dstStride) = (uint32_t)_mm_extract_epi32(v, 2);
+	*(uint32_t*)(dst + 3 * dstStride) = (uint32_t)_mm_extract_epi32(v, 3);
+}
+
+VERTEX_PACKING_TARGET("sse4.1")
+static void util_pack_float2_to_half2_sse41(uint32_t count, uint32_t srcStride, uint32_t dstStride, uint32_t offset, const uint8_t* src, uint8_t* dst)
+{
+	uint32_t e = 0;
+	for (; e + 4 <= count; e += 4)
+	{
+		const uint8_t* s = src + e * srcStride;
+		__m128 xy01;
+		__m128 xy23;
+		if (sizeof(float[2]) == srcStride)
+		{
+			xy01 = _mm_loadu_ps((const float*)s);
+			xy23 = _mm_loadu_ps((const float*)s + 4);
+		}
+		else
+		{
+			xy01 = _mm_castsi128_ps(_mm_unpacklo_epi64(
+				_mm_loadl_epi64((const __m128i*)(s + 0 * srcStride)), _mm_loadl_epi64((const __m128i*)(s + 1 * srcStride))));
+			xy23 = _mm_castsi128_ps(_mm_unpacklo_epi64(
+				_mm_loadl_epi64((const __m128i*)(s + 2 * srcStride)), _mm_loadl_epi64((const __m128i*)(s + 3 * srcStride))));
+		}
+		// Halves stay in the low 16 bits so packing keeps them in x0 y0 x1 y1 ... order which is x | y << 16 per vertex
+		const __m128i h = _mm_packus_epi32(util_float4_to_half4_sse41(xy01), util_float4_to_half4_sse41(xy23));
+		util_store_strided4_sse41(h, dstStride, dst + offset + e * dstStride);
+	}
+
+	util_pack_float2_to_half2_scalar(count - e, srcStride, dstStride, offset, src + e * srcStride, dst + e * dstStride);
+}
+
+VERTEX_PACKING_TARGET("sse4.1")
+static void util_pack_float3_direction_to_half2_sse41(uint32_t count, uint32_t srcStride, uint32_t dstStride, uint32_t offset, const uint8_t* src, uint8_t* dst)
+{
+	uint32_t e = 0;
+	for (; e + 4 <= count; e += 4)
+	{
+		const float* f0 = (const float*)(src + (e + 0) * srcStride);
+		const float* f1 = (const float*)(src + (e + 1) * srcStride);
+		const float* f2 = (const float*)(src + (e + 2) * srcStride);
+		const float* f3 = (const float*)(src + (e + 3) * srcStride);
+		const __m128 x = _mm_setr_ps(f0[0], f1[0], f2[0], f3[0]);
+		const __m128 y = _mm_setr_ps(f0[1], f1[1], f2[1], f3[1]);
+		const __m128 z = _mm_setr_ps(f0[2], f1[2], f2[2], f3[2]);
+		util_store_strided4_sse41(util_float4x3_direction_to_oct_unorm2x16_sse41(x, y, z), dstStride, dst + offset + e * dstStride);
+	}
+
+	util_pack_float3_direction_to_half2_scalar(count - e, srcStride, dstStride, offset, src + e * srcStride, dst + e * dstStride);
+}
+
+// Same as util_float4_to_half4_sse41 for eight values, uses F16C when its round to zero result already matches
+VERTEX_PACKING_TARGET("avx2,f16c")
+static inline __m128i util_float8_to_half8_avx2(__m256 v)
+{
+	const __m256i f = _mm256_castps_si256(v);
+	const __m256i exponent = _mm256_and_si256(_mm256_srli_epi32(f, 23), _mm256_set1_epi32(0xff));
+
+	// F16C differs from the scalar conversion for half denormals (flushed by the scalar path), overflow (clamped to max instead of infinity) and NaN payloads
+	const __m256i mismatch = _mm256_or_si256(
+		_mm256_cmpgt_epi32(exponent, _mm256_set1_epi32(127 + F16_EXPONENT_BIAS)),
+		_mm256_and_si256(
+			_mm256_cmpgt_epi32(exponent, _mm256_set1_epi32(127 - F16_EXPONENT_BIAS - 10)),
+			_mm256_cmpgt_epi32(_mm256_set1_epi32(127 - F16_EXPONENT_BIAS + 1), exponent)));
+	if (_mm256_testz_si256(mismatch, mismatch))
+	{
+		return _mm256_cvtps_ph(v, _MM_FROUND_TO_ZERO);
+	}
+
+	const __m256i sign = _mm256_and_si256(_mm256_srli_epi32(f, 16), _mm256_set1_epi32(0x8000));
+	const __m256i mantissa = _mm256_and_si256(f, _mm256_set1_epi32(0x007fffff));
+
+	const __m256i normal = _mm256_or_si256(
+		sign, _mm256_or_si256(
+				  _mm256_slli_epi32(_mm256_sub_epi32(exponent, _mm256_set1_epi32(127 - F16_EXPONENT_BIAS)), F16_EXPONENT_SHIFT),
+				  _mm256_srli_epi32(mantissa, F16_MANTISSA_SHIFT)));
+	const __m256i infinity = _mm256_or_si256(sign, _mm256_set1_epi32(F16_MAX_EXPONENT));
+	const __m256i nan = _mm256_or_si256(infinity, _mm256_and_si256(mantissa, _mm256_set1_epi32(F16_MANTISSA_BITS)));
+
+	__m256i h = sign;
+	h = _mm256_blendv_epi8(h, normal, _mm256_cmpgt_epi32(exponent, _mm256_set1_epi32(127 - F16_EXPONENT_BIAS)));
+	h = _mm256_blendv_epi8(h, infinity, _mm256_cmpgt_epi32(exponent, _mm256_set1_epi32(127 + F16_EXPONENT_BIAS)));
+	h = _mm256_blendv_epi8(h, nan, _mm256_cmpeq_epi32(exponent, _mm256_set1_epi32(0xff)));
+
+	// Pack works per 128 bit lane, reorder the 64 bit halves to get all eight values in order
+	const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(h, h), _MM_SHUFFLE(3, 1, 2, 0));
+	return _mm256_castsi256_si128(packed);
+}
+
+VERTEX_PACKING_TARGET("avx2,f16c")
+static inline __m256i util_float8x2_to_unorm2x16_avx2(__m256 x, __m256 y)
+{
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256 scale = _mm256_set1_ps(65535.0f);
+
+	x = _mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(x, zero), one), scale);
+	y = _mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(y, zero), one), scale);
+	__m256 rx = _mm256_round_ps(x, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+	__m256 ry = _mm256_round_ps(y, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+	rx = _mm256_add_ps(rx, _mm256_and_ps(_mm256_cmp_ps(_mm256_sub_ps(x, rx), half, _CMP_GE_OQ), one));
+	ry = _mm256_add_ps(ry, _mm256_and_ps(_mm256_cmp_ps(_mm256_sub_ps(y, ry), half, _CMP_GE_OQ), one));
+	return _mm256_or_si256(_mm256_cvttps_epi32(rx), _mm256_slli_epi32(_mm256_cvttps_epi32(ry), 16));
+}
+
+VERTEX_PACKING_TARGET("avx2,f16c")
+static inline __m256i util_float8x3_direction_to_oct_unorm2x16_avx2(__m256 x, __m256 y, __m256 z)
+{
+	const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 minusOne = _mm256_set1_ps(-1.0f);
+	const __m256 half = _mm256_set1_ps(0.5f);
+
+	const __m256 absLength =
+		_mm256_add_ps(_mm256_add_ps(_mm256_and_ps(x, absMask), _mm256_and_ps(y, absMask)), _mm256_and_ps(z, absMask));
+	const __m256 valid = _mm256_cmp_ps(absLength, zero, _CMP_NEQ_UQ);
+
+	__m256 encX = _mm256_div_ps(x, absLength);
+	__m256 encY = _mm256_div_ps(y, absLength);
+	__m256 encZ = _mm256_div_ps(z, absLength);
+
+	const __m256 wrapX = _mm256_mul_ps(
+		_mm256_sub_ps(one, _mm256_and_ps(encY, absMask)), _mm256_blendv_ps(minusOne, one, _mm256_cmp_ps(encX, zero, _CMP_GE_OQ)));
+	const __m256 wrapY = _mm256_mul_ps(
+		_mm256_sub_ps(one, _mm256_and_ps(encX, absMask)), _mm256_blendv_ps(minusOne, one, _mm256_cmp_ps(encY, zero, _CMP_GE_OQ)));
+	const __m256 wrap = _mm256_cmp_ps(encZ, zero, _CMP_LT_OQ);
+	encX = _mm256_blendv_ps(encX, wrapX, wrap);
+	encY = _mm256_blendv_ps(encY, wrapY, wrap);
+
+	encX = _mm256_add_ps(_mm256_mul_ps(encX, half), half);
+	encY = _mm256_add_ps(_mm256_mul_ps(encY, half), half);
+	return _mm256_and_si256(util_float8x2_to_unorm2x16_avx2(encX, encY), _mm256_castps_si256(valid));
+}
+
+VERTEX_PACKING_TARGET("avx2,f16c")
+static void util_pack_float2_to_half2_avx2(uint32_t count, uint32_t srcStride, uint32_t dstStride, uint32_t offset, const uint8_t* src, uint8_t* dst)
+{
+	uint32_t e = 0;
+	for (; e + 4 <= count; e += 4)
+	{
+		const uint8_t* s = src + e * srcStride;
+		__m256 xy;
+		if (sizeof(float[2]) == srcStride)
+		{
+			xy = _mm256_loadu_ps((const float*)s);
+		}
+		else
+		{
+			const __m128i xy01 = _mm_unpacklo_epi64(
+				_mm_loadl_epi64((const __m128i*)(s + 0 * srcStride)), _mm_loadl_epi64((const __m128i*)(s + 1 * srcStride)));
+			const __m128i xy23 = _mm_unpacklo_epi64(
+				_mm_loadl_epi64((const __m128i*)(s + 2 * srcStride)), _mm_loadl_epi64((const __m128i*)(s + 3 * srcStride)));
+			xy = _mm256_castsi256_ps(_mm256_inserti128_si256(_mm256_castsi128_si256(xy01), xy23, 1));
+		}
+		util_store_strided4_sse41(util_float8_to_half8_avx2(xy), dstStride, dst + offset + e * dstStride);
+	}
+
+	util_pack_float2_to_half2_scalar(count - e, srcStride, dstStride, offset, src + e * srcStride, dst + e * dstStride);
+}
+
+VERTEX_PACKING_TARGET("avx2,f16c")
+static void util_pack_float3_direction_to_half2_avx2(uint32_t count, uint32_t srcStride, uint32_t dstStride, uint32_t offset, const uint8_t* src, uint8_t* dst)
+{
+	uint32_t e = 0;
+	for (; e + 8 <= count; e += 8)
+	{
+		// Strided scalar loads beat hardware gathers for 12 and 16 byte directions
+		const float* f[8];
+		for (uint32_t v = 0; v < 8; ++v)
+			f[v] = (const float*)(src + (e + v) * srcStride);
+		const __m256 x = _mm256_setr_ps(f[0][0], f[1][0], f[2][0], f[3][0], f[4][0], f[5][0], f[6][0], f[7][0]);
+		const __m256 y = _mm256_setr_ps(f[0][1], f[1][1], f[2][1], f[3][1], f[4][1], f[5][1], f[6][1], f[7][1]);
+		const __m256 z = _mm256_setr_ps(f[0][2], f[1][2], f[2][2], f[3][2], f[4][2], f[5][2], f[6][2], f[7][2]);
+		const __m256i packed = util_float8x3_direction_to_oct_unorm2x16_avx2(x, y, z);
+		uint8_t* d = dst + offset + e * dstStride;
+		util_store_strided4_sse41(_mm256_castsi256_si128(packed), dstStride, d);
+		util_store_strided4_sse41(_mm256_extracti128_si256(packed, 1), dstStride, d + 4 * dstStride);
+	}
+
+	util_pack_float3_direction_to_half2_sse41(count - e, srcStride, dstStride, offset, src + e * srcStride, dst + e * dstStride);
+}
+#endif
+
+typedef void (*PackingFunction)(uint32_t count, uint32_t srcStride, uint32_t dstStride, uint32_t offset, const uint8_t* src, uint8_t* dst);
+
+typedef enum VertexPackingPath
+{
+	VERTEX_PACKING_PATH_SCALAR = 0,
+	VERTEX_PACKING_PATH_SSE41,
+	VERTEX_PACKING_PATH_AVX2,
+} VertexPackingPath;
+
+static inline PackingFunction util_get_pack_float2_to_half2(VertexPackingPath path)
+{
+#if defined(ARCH_X86_FAMILY)
+	switch (path)
+	{
+	case VERTEX_PACKING_PATH_AVX2: return util_pack_float2_to_half2_avx2;
+	case VERTEX_PACKING_PATH_SSE41: return util_pack_float2_to_half2_sse41;
+	default: break;
+	}
+#endif
+	return util_pack_float2_to_half2_scalar;
+}
+
+static inline PackingFunction util_get_pack_float3_direction_to_half2(VertexPackingPath path)
+{
+#if defined(ARCH_X86_FAMILY)
+	switch (path)
+	{
+	case VERTEX_PACKING_PATH_AVX2: return util_pack_float3_direction_to_half2_avx2;
+	case VERTEX_PACKING_PATH_SSE41: return util_pack_float3_direction_to_half2_sse41;
+	default: break;
+	}
+#endif
+	return util_pack_float3_direction_to_half2_scalar;
+}
@@ -47,6 +47,10 @@
 
 #include "../Include/IRenderer.h"
 
+#if defined(NULL_RENDERER)
+#include "../Null/NullDriver.h"
+#endif
+
 #include "../../ThirdParty/OpenSource/EASTL/vector.h"
 #include "../../ThirdParty/OpenSource/EASTL/functional.h"
 #include "../../ThirdParty/OpenSource/EASTL/sort.h"
@@ -295,6 +299,9 @@ const char* gVkWantedDeviceExtensions[] =
 	VK_EXT_SHADER_SUBGROUP_VOTE_EXTENSION_NAME,
 	VK_KHR_DEDICATED_ALLOCATION_EXTENSION_NAME,
 	VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME,
+#if VK_EXT_memory_budget
+	VK_EXT_MEMORY_BUDGET_EXTENSION_NAME,
+#endif
 #ifdef USE_EXTERNAL_MEMORY_EXTENSIONS
 	VK_KHR_EXTERNAL_MEMORY_EXTENSION_NAME,
 	VK_KHR_EXTERNAL_SEMAPHORE_EXTENSION_NAME,
@@ -500,6 +507,185 @@ static void consume_descriptor_sets(VkDevice pDevice, VkDescriptorPool pPool, co
 	CHECK_VKRESULT(vkAllocateDescriptorSets(pDevice, &alloc_info, *pSets));
 }
 
+/************************************************************************/
+// Bindless Heap Functions
+/************************************************************************/
+// The heap is bound right after the update frequency sets (UPDATE_FREQ_BINDLESS in shaders)
+static const uint32_t VK_BINDLESS_SET_INDEX = DESCRIPTOR_UPDATE_FREQ_COUNT;
+static const uint32_t VK_BINDLESS_TEXTURE_BINDING = 0;
+static const uint32_t VK_BINDLESS_BUFFER_BINDING = 1;
+static const uint32_t VK_BINDLESS_DEFAULT_TEXTURE_COUNT = 16384;
+static const uint32_t VK_BINDLESS_DEFAULT_BUFFER_COUNT = 4096;
+
+typedef struct BindlessIndexAllocator
+{
+	eastl::vector<uint32_t> mFreeIndices;
+	uint32_t                mNextIndex;
+	uint32_t                mCapacity;
+} BindlessIndexAllocator;
+
+typedef struct BindlessHeap
+{
+	VkDescriptorSetLayout  pLayout;
+	VkDescriptorPool       pPool;
+	VkDescriptorSet        pSet;
+	/// Guards the index allocators and the host side writes to pSet
+	Mutex                  mMutex;
+	BindlessIndexAllocator mTextures;
+	BindlessIndexAllocator mBuffers;
+} BindlessHeap;
+
+static BindlessHeap* gBindlessHeap[MAX_UNLINKED_GPUS];
+
+static uint32_t alloc_bindless_index(BindlessIndexAllocator* pAllocator)
+{
+	if (!pAllocator->mFreeIndices.empty())
+	{
+		const uint32_t index = pAllocator->mFreeIndices.back();
+		pAllocator->mFreeIndices.pop_back();
+		return index;
+	}
+	if (pAllocator->mNextIndex < pAllocator->mCapacity)
+		return pAllocator->mNextIndex++;
+
+	return BINDLESS_INVALID_INDEX;
+}
+
+static void add_bindless_heap(Renderer* pRenderer, const RendererDesc* pDesc)
+{
+	if (!pDesc->mVulkan.mEnableBindless)
+		return;
+
+	if (!pRenderer->mVulkan.mDescriptorIndexingExtension)
+	{
+		LOGF(LogLevel::eWARNING, "Bindless heap requested but VK_EXT_descriptor_indexing is not supported. Bindless mode is disabled");
+		return;
+	}
+
+	VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT };
+	VkPhysicalDeviceFeatures2KHR                  gpuFeatures = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR };
+	gpuFeatures.pNext = &indexingFeatures;
+	VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexingProperties = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT };
+	VkPhysicalDeviceProperties2KHR                  gpuProperties = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR };
+	gpuProperties.pNext = &indexingProperties;
+#ifdef NX64
+	vkGetPhysicalDeviceFeatures2(pRenderer->mVulkan.pVkActiveGPU, &gpuFeatures);
+	vkGetPhysicalDeviceProperties2(pRenderer->mVulkan.pVkActiveGPU, &gpuProperties);
+#else
+	vkGetPhysicalDeviceFeatures2KHR(pRenderer->mVulkan.pVkActiveGPU, &gpuFeatures);
+	vkGetPhysicalDeviceProperties2KHR(pRenderer->mVulkan.pVkActiveGPU, &gpuProperties);
+#endif
+
+	if (!indexingFeatures.runtimeDescriptorArray || !indexingFeatures.descriptorBindingPartiallyBound ||
+		!indexingFeatures.descriptorBindingSampledImageUpdateAfterBind || !indexingFeatures.descriptorBindingStorageBufferUpdateAfterBind ||
+		!indexingFeatures.shaderSampledImageArrayNonUniformIndexing ||
+		gpuProperties.properties.limits.maxBoundDescriptorSets <= VK_BINDLESS_SET_INDEX)
+	{
+		LOGF(LogLevel::eWARNING, "Bindless heap requested but the required descriptor indexing features are missing. Bindless mode is disabled");
+		return;
+	}
+
+	uint32_t textureCount = pDesc->mVulkan.mBindlessTextureCount ? pDesc->mVulkan.mBindlessTextureCount : VK_BINDLESS_DEFAULT_TEXTURE_COUNT;
+	uint32_t bufferCount = pDesc->mVulkan.mBindlessBufferCount ? pDesc->mVulkan.mBindlessBufferCount : VK_BINDLESS_DEFAULT_BUFFER_COUNT;
+	textureCount = min(textureCount, min(indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages, indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages));
+	bufferCount = min(bufferCount, min(indexingProperties.maxDescriptorSetUpdateAfterBindStorageBuffers, indexingProperties.maxPerStageDescriptorUpdateAfterBindStorageBuffers));
+
+	BindlessHeap* pHeap = tf_placement_new<BindlessHeap>(tf_calloc(1, sizeof(BindlessHeap)));
+	initMutex(&pHeap->mMutex);
+	pHeap->mTextures.mCapacity = textureCount;
+	pHeap->mBuffers.mCapacity = bufferCount;
+
+	VkDescriptorSetLayoutBinding bindings[2] = {};
+	bindings[0].binding = VK_BINDLESS_TEXTURE_BINDING;
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+	bindings[0].descriptorCount = textureCount;
+	bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+	bindings[1].binding = VK_BINDLESS_BUFFER_BINDING;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	bindings[1].descriptorCount = bufferCount;
+	bindings[1].stageFlags = VK_SHADER_STAGE_ALL;
+
+	// Slots are written while the heap is bound and most of them are never written at all
+	VkDescriptorBindingFlagsEXT bindingFlags[2] = {
+		VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT,
+		VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT,
+	};
+	VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT };
+	bindingFlagsInfo.bindingCount = 2;
+	bindingFlagsInfo.pBindingFlags = bindingFlags;
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.pNext = &bindingFlagsInfo;
+	layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+	layoutInfo.bindingCount = 2;
+	layoutInfo.pBindings = bindings;
+	CHECK_VKRESULT(vkCreateDescriptorSetLayout(pRenderer->mVulkan.pVkDevice, &layoutInfo, &gVkAllocationCallbacks, &pHeap->pLayout));
+
+	VkDescriptorPoolSize poolSizes[2] = { { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, textureCount }, { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, bufferCount } };
+	add_descriptor_pool(pRenderer, 1, VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT, poolSizes, 2, &pHeap->pPool);
+	VkDescriptorSet* pSets[] = { &pHeap->pSet };
+	consume_descriptor_sets(pRenderer->mVulkan.pVkDevice, pHeap->pPool, &pHeap->pLayout, 1, pSets);
+
+	gBindlessHeap[pRenderer->mUnlinkedRendererIndex] = pHeap;
+	LOGF(LogLevel::eINFO, "Bindless heap created with %u textures and %u buffers", textureCount, bufferCount);
+}
+
+static void remove_bindless_heap(Renderer* pRenderer)
+{
+	BindlessHeap* pHeap = gBindlessHeap[pRenderer->mUnlinkedRendererIndex];
+	if (!pHeap)
+		return;
+
+	vkDestroyDescriptorPool(pRenderer->mVulkan.pVkDevice, pHeap->pPool, &gVkAllocationCallbacks);
+	vkDestroyDescriptorSetLayout(pRenderer->mVulkan.pVkDevice, pHeap->pLayout, &gVkAllocationCallbacks);
+	destroyMutex(&pHeap->mMutex);
+	pHeap->~BindlessHeap();
+	SAFE_FREE(gBindlessHeap[pRenderer->mUnlinkedRendererIndex]);
+}
+
+// Allocates a heap slot and writes the descriptor. Returns BINDLESS_INVALID_INDEX if there is no heap or the heap is full
+static uint32_t add_bindless_descriptor(
+	Renderer* pRenderer, const VkDescriptorImageInfo* pImageInfo, const VkDescriptorBufferInfo* pBufferInfo)
+{
+	BindlessHeap* pHeap = gBindlessHeap[pRenderer->mUnlinkedRendererIndex];
+	if (!pHeap)
+		return BINDLESS_INVALID_INDEX;
+
+	MutexLock lock(pHeap->mMutex);
+
+	const uint32_t index = alloc_bindless_index(pImageInfo ? &pHeap->mTextures : &pHeap->mBuffers);
+	if (BINDLESS_INVALID_INDEX == index)
+	{
+		LOGF(LogLevel::eWARNING, "Bindless heap is full (%u %s)", pImageInfo ? pHeap->mTextures.mCapacity : pHeap->mBuffers.mCapacity,
+			pImageInfo ? "textures" : "buffers");
+		return BINDLESS_INVALID_INDEX;
+	}
+
+	VkWriteDescriptorSet writeSet = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+	writeSet.dstSet = pHeap->pSet;
+	writeSet.dstBinding = pImageInfo ? VK_BINDLESS_TEXTURE_BINDING : VK_BINDLESS_BUFFER_BINDING;
+	writeSet.dstArrayElement = index;
+	writeSet.descriptorCount = 1;
+	writeSet.descriptorType = pImageInfo ? VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	writeSet.pImageInfo = pImageInfo;
+	writeSet.pBufferInfo = pBufferInfo;
+	vkUpdateDescriptorSets(pRenderer->mVulkan.pVkDevice, 1, &writeSet, 0, NULL);
+
+	return index;
+}
+
+// The resource is not used by the GPU anymore when it is removed, so the slot can be handed out again right away
+static void remove_bindless_descriptor(Renderer* pRenderer, uint32_t index, bool texture)
+{
+	BindlessHeap* pHeap = gBindlessHeap[pRenderer->mUnlinkedRendererIndex];
+	if (!pHeap || BINDLESS_INVALID_INDEX == index)
+		return;
+
+	MutexLock lock(pHeap->mMutex);
+	(texture ? pHeap->mTextures : pHeap->mBuffers).mFreeIndices.push_back(index);
+}
+
 /************************************************************************/
 /************************************************************************/
 VkPipelineBindPoint gPipelineBindPoint[PIPELINE_TYPE_COUNT] = { VK_PIPELINE_BIND_POINT_MAX_ENUM, VK_PIPELINE_BIND_POINT_COMPUTE,
@@ -586,6 +772,11 @@ typedef struct FrameBuffer
 	uint32_t      mWidth;
 	uint32_t      mHeight;
 	uint32_t      mArraySize;
+	// Ids of the attached render targets, the frame buffer is released when any of them is removed
+	uint32_t        mRenderTargetIds[MAX_RENDER_TARGET_ATTACHMENTS + 1];
+	uint32_t        mRenderTargetIdCount;
+	// Frame index of the last vk_cmdBindRenderTargets using this frame buffer, used for LRU eviction
+	tfrg_atomic64_t mLastUsedFrame;
 } FrameBuffer;
 
 static void add_render_pass(Renderer* pRenderer, const RenderPassDesc* pDesc, RenderPass** ppRenderPass)
@@ -756,6 +947,11 @@ static void add_framebuffer(Renderer* pRenderer, const FrameBufferDesc* pDesc, F
 	uint32_t colorAttachmentCount = pDesc->mRenderTargetCount;
 	uint32_t depthAttachmentCount = (pDesc->pDepthStencil) ? 1 : 0;
 
+	for (uint32_t i = 0; i < colorAttachmentCount; ++i)
+		pFrameBuffer->mRenderTargetIds[pFrameBuffer->mRenderTargetIdCount++] = pDesc->ppRenderTargets[i]->mVulkan.mId;
+	if (depthAttachmentCount)
+		pFrameBuffer->mRenderTargetIds[pFrameBuffer->mRenderTargetIdCount++] = pDesc->pDepthStencil->mVulkan.mId;
+
 	if (colorAttachmentCount)
 	{
 		pFrameBuffer->mWidth = pDesc->ppRenderTargets[0]->mWidth;
@@ -887,52 +1083,306 @@ static void remove_framebuffer(Renderer* pRenderer, FrameBuffer* pFrameBuffer)
 	SAFE_FREE(pFrameBuffer);
 }
 /************************************************************************/
-// Per Thread Render Pass synchronization logic
+// Shared Render Pass / Frame Buffer cache
 /************************************************************************/
 /// Render-passes are not exposed to the app code since they are not available on all apis
-/// This map takes care of hashing a render pass based on the render targets passed to cmdBeginRender
-using RenderPassMap = eastl::hash_map<uint64_t, struct RenderPass*>;
-using RenderPassMapNode = RenderPassMap::value_type;
-using RenderPassMapIt = RenderPassMap::iterator;
-using FrameBufferMap = eastl::hash_map<uint64_t, struct FrameBuffer*>;
-using FrameBufferMapNode = FrameBufferMap::value_type;
-using FrameBufferMapIt = FrameBufferMap::iterator;
+/// This cache takes care of hashing render passes and frame buffers based on the render targets passed to cmdBindRenderTargets
+/// It is shared by all threads:
+/// - Lookups are lock free. Tables are open addressing arrays of { key, object } which the single writer (holding mMutex) only
+///   modifies by filling empty slots or turning live slots into tombstones. Growing or compacting publishes a new table.
+/// - Objects removed from a table and replaced tables are retired and destroyed VK_CACHE_RETIRE_FRAMES frames later,
+///   so a lookup racing with an eviction never touches freed memory or a destroyed handle still used by the GPU.
+/// - Frame buffers are released when one of their render targets is removed and evicted when unused for VK_FRAMEBUFFER_STALE_FRAMES.
+static const uint64_t VK_CACHE_EMPTY_KEY = 0;
+static const uint64_t VK_CACHE_TOMBSTONE_KEY = 1;
+static const uint32_t VK_CACHE_INITIAL_CAPACITY = 128;
+// Frames are counted in vk_acquireNextImage
+static const uint64_t VK_CACHE_RETIRE_FRAMES = 8;
+static const uint64_t VK_FRAMEBUFFER_STALE_FRAMES = 240;
+static const uint64_t VK_CACHE_EVICTION_INTERVAL = 60;
+
+typedef struct CacheSlot
+{
+	tfrg_atomic64_t  mKey;
+	tfrg_atomicptr_t pObject;
+} CacheSlot;
+
+typedef struct CacheTable
+{
+	uint32_t   mCapacity;
+	uint32_t   mCount;
+	uint32_t   mTombstoneCount;
+	uint32_t   mPadA;
+	CacheSlot* pSlots;
+} CacheTable;
+
+typedef enum CacheObjectType
+{
+	CACHE_OBJECT_RENDER_PASS = 0,
+	CACHE_OBJECT_FRAME_BUFFER,
+	CACHE_OBJECT_TABLE,
+} CacheObjectType;
+
+typedef struct RetiredCacheObject
+{
+	void*           pObject;
+	uint64_t        mFrame;
+	CacheObjectType mType;
+} RetiredCacheObject;
+
+typedef struct RenderPassCache
+{
+	tfrg_atomicptr_t                  pRenderPassTable;
+	tfrg_atomicptr_t                  pFrameBufferTable;
+	tfrg_atomic64_t                   mFrameIndex;
+	Mutex                             mMutex;
+	eastl::vector<RetiredCacheObject> mRetiredObjects;
+	// Stats
+	tfrg_atomic64_t mRenderPassHits;
+	tfrg_atomic64_t mRenderPassMisses;
+	tfrg_atomic64_t mFrameBufferHits;
+	tfrg_atomic64_t mFrameBufferMisses;
+	tfrg_atomic64_t mFrameBufferEvictions;
+	tfrg_atomic64_t mFrameBufferReleases;
+} RenderPassCache;
+
+static RenderPassCache* gRenderPassCache[MAX_UNLINKED_GPUS];
+
+static inline uint64_t cache_key(uint64_t hash)
+{
+	// Keep the empty and tombstone keys reserved
+	return hash > VK_CACHE_TOMBSTONE_KEY ? hash : hash + 2;
+}
+
+static CacheTable* add_cache_table(uint32_t capacity)
+{
+	ASSERT(capacity && !(capacity & (capacity - 1)));
+	CacheTable* pTable = (CacheTable*)tf_calloc(1, sizeof(CacheTable) + capacity * sizeof(CacheSlot));
+	ASSERT(pTable);
+	pTable->mCapacity = capacity;
+	pTable->pSlots = (CacheSlot*)(pTable + 1);
+	return pTable;
+}
+
+static void* cache_find(tfrg_atomicptr_t* pTablePtr, uint64_t key)
+{
+	const CacheTable* pTable = (const CacheTable*)tfrg_atomicptr_load_acquire(pTablePtr);
+	if (!pTable)
+		return NULL;
+
+	const uint32_t mask = pTable->mCapacity - 1;
+	for (uint32_t probe = 0, slot = (uint32_t)key & mask; probe < pTable->mCapacity; ++probe, slot = (slot + 1) & mask)
+	{
+		CacheSlot*     pSlot = &pTable->pSlots[slot];
+		const uint64_t slotKey = tfrg_atomic64_load_acquire(&pSlot->mKey);
+		if (slotKey == key)
+			return (void*)tfrg_atomicptr_load_relaxed(&pSlot->pObject);
+		if (slotKey == VK_CACHE_EMPTY_KEY)
+			return NULL;
+	}
 
-// RenderPass map per thread (this will make lookups lock free and we only need a lock when inserting a RenderPass Map for the first time)
-eastl::hash_map<ThreadID, RenderPassMap>* gRenderPassMap[MAX_UNLINKED_GPUS];
-// FrameBuffer map per thread (this will make lookups lock free and we only need a lock when inserting a FrameBuffer map for the first time)
-eastl::hash_map<ThreadID, FrameBufferMap>* gFrameBufferMap[MAX_UNLINKED_GPUS];
-Mutex* pRenderPassMutex[MAX_UNLINKED_GPUS];
+	return NULL;
+}
+
+static void cache_retire(RenderPassCache* pCache, void* pObject, CacheObjectType type)
+{
+	RetiredCacheObject retired = { pObject, tfrg_atomic64_load_relaxed(&pCache->mFrameIndex), type };
+	pCache->mRetiredObjects.push_back(retired);
+}
 
-static RenderPassMap& get_render_pass_map(uint32_t rendererID)
+static void cache_insert_slot(CacheTable* pTable, uint64_t key, void* pObject)
 {
-	// Only need a lock when creating a new renderpass map for this thread
-	MutexLock                                          lock(*pRenderPassMutex[rendererID]);
-	eastl::hash_map<ThreadID, RenderPassMap>::iterator it = gRenderPassMap[rendererID]->find(getCurrentThreadID());
-	if (it == gRenderPassMap[rendererID]->end())
+	const uint32_t mask = pTable->mCapacity - 1;
+	for (uint32_t slot = (uint32_t)key & mask;; slot = (slot + 1) & mask)
 	{
-		return gRenderPassMap[rendererID]->insert(getCurrentThreadID()).first->second;
+		CacheSlot* pSlot = &pTable->pSlots[slot];
+		// Tombstones are never reused in place, a reader might still be matching the old key of the slot
+		if (tfrg_atomic64_load_relaxed(&pSlot->mKey) == VK_CACHE_EMPTY_KEY)
+		{
+			tfrg_atomicptr_store_relaxed(&pSlot->pObject, (uintptr_t)pObject);
+			tfrg_atomic64_store_release(&pSlot->mKey, key);
+			++pTable->mCount;
+			return;
+		}
 	}
-	else
+}
+
+// Must be called with the cache mutex held
+static void cache_insert(RenderPassCache* pCache, tfrg_atomicptr_t* pTablePtr, uint64_t key, void* pObject)
+{
+	CacheTable* pTable = (CacheTable*)tfrg_atomicptr_load_relaxed(pTablePtr);
+	if (!pTable || (pTable->mCount + pTable->mTombstoneCount + 1) * 2 > pTable->mCapacity)
 	{
-		return it->second;
+		// Grow (or compact away tombstones) into a new table and publish it, readers still using the old one find valid entries
+		uint32_t capacity = VK_CACHE_INITIAL_CAPACITY;
+		while (pTable && (pTable->mCount + 1) * 4 > capacity)
+			capacity *= 2;
+
+		CacheTable* pNewTable = add_cache_table(capacity);
+		if (pTable)
+		{
+			for (uint32_t i = 0; i < pTable->mCapacity; ++i)
+			{
+				const uint64_t slotKey = tfrg_atomic64_load_relaxed(&pTable->pSlots[i].mKey);
+				if (slotKey > VK_CACHE_TOMBSTONE_KEY)
+					cache_insert_slot(pNewTable, slotKey, (void*)tfrg_atomicptr_load_relaxed(&pTable->pSlots[i].pObject));
+			}
+			cache_retire(pCache, pTable, CACHE_OBJECT_TABLE);
+		}
+
+		tfrg_atomicptr_store_release(pTablePtr, (uintptr_t)pNewTable);
+		pTable = pNewTable;
 	}
+
+	cache_insert_slot(pTable, key, pObject);
 }
 
-static FrameBufferMap& get_frame_buffer_map(uint32_t rendererID)
+static void remove_cache_object(Renderer* pRenderer, void* pObject, CacheObjectType type)
 {
-	// Only need a lock when creating a new framebuffer map for this thread
-	MutexLock                                           lock(*pRenderPassMutex[rendererID]);
-	eastl::hash_map<ThreadID, FrameBufferMap>::iterator it = gFrameBufferMap[rendererID]->find(getCurrentThreadID());
-	if (it == gFrameBufferMap[rendererID]->end())
+	switch (type)
 	{
-		return gFrameBufferMap[rendererID]->insert(getCurrentThreadID()).first->second;
+	case CACHE_OBJECT_RENDER_PASS: remove_render_pass(pRenderer, (RenderPass*)pObject); break;
+	case CACHE_OBJECT_FRAME_BUFFER: remove_framebuffer(pRenderer, (FrameBuffer*)pObject); break;
+	case CACHE_OBJECT_TABLE: tf_free(pObject); break;
+	default: ASSERT(false); break;
 	}
-	else
+}
+
+static void add_render_pass_cache(Renderer* pRenderer)
+{
+	RenderPassCache* pCache = tf_placement_new<RenderPassCache>(tf_calloc(1, sizeof(RenderPassCache)));
+	initMutex(&pCache->mMutex);
+	gRenderPassCache[pRenderer->mUnlinkedRendererIndex] = pCache;
+}
+
+static void remove_render_pass_cache(Renderer* pRenderer)
+{
+	RenderPassCache* pCache = gRenderPassCache[pRenderer->mUnlinkedRendererIndex];
+
+	for (RetiredCacheObject& retired : pCache->mRetiredObjects)
+		remove_cache_object(pRenderer, retired.pObject, retired.mType);
+
+	CacheTable* pTables[] = { (CacheTable*)pCache->pRenderPassTable, (CacheTable*)pCache->pFrameBufferTable };
+	CacheObjectType types[] = { CACHE_OBJECT_RENDER_PASS, CACHE_OBJECT_FRAME_BUFFER };
+	for (uint32_t t = 0; t < 2; ++t)
+	{
+		if (!pTables[t])
+			continue;
+		for (uint32_t i = 0; i < pTables[t]->mCapacity; ++i)
+		{
+			if (pTables[t]->pSlots[i].mKey > VK_CACHE_TOMBSTONE_KEY)
+				remove_cache_object(pRenderer, (void*)pTables[t]->pSlots[i].pObject, types[t]);
+		}
+		tf_free(pTables[t]);
+	}
+
+	destroyMutex(&pCache->mMutex);
+	pCache->~RenderPassCache();
+	SAFE_FREE(gRenderPassCache[pRenderer->mUnlinkedRendererIndex]);
+}
+
+// Called once per frame (vk_acquireNextImage or vk_updateRenderPassCache).
+// Evicts stale frame buffers and destroys the retired objects that are no longer in flight
+static void update_render_pass_cache(Renderer* pRenderer)
+{
+	RenderPassCache* pCache = gRenderPassCache[pRenderer->mUnlinkedRendererIndex];
+	const uint64_t   frame = tfrg_atomic64_add_relaxed(&pCache->mFrameIndex, 1) + 1;
+	if (frame % VK_CACHE_EVICTION_INTERVAL)
+		return;
+
+	MutexLock lock(pCache->mMutex);
+
+	CacheTable* pTable = (CacheTable*)tfrg_atomicptr_load_relaxed(&pCache->pFrameBufferTable);
+	if (pTable)
+	{
+		for (uint32_t i = 0; i < pTable->mCapacity; ++i)
+		{
+			CacheSlot* pSlot = &pTable->pSlots[i];
+			if (tfrg_atomic64_load_relaxed(&pSlot->mKey) <= VK_CACHE_TOMBSTONE_KEY)
+				continue;
+
+			FrameBuffer* pFrameBuffer = (FrameBuffer*)tfrg_atomicptr_load_relaxed(&pSlot->pObject);
+			if (frame - tfrg_atomic64_load_relaxed(&pFrameBuffer->mLastUsedFrame) > VK_FRAMEBUFFER_STALE_FRAMES)
+			{
+				tfrg_atomic64_store_release(&pSlot->mKey, VK_CACHE_TOMBSTONE_KEY);
+				--pTable->mCount;
+				++pTable->mTombstoneCount;
+				cache_retire(pCache, pFrameBuffer, CACHE_OBJECT_FRAME_BUFFER);
+				tfrg_atomic64_add_relaxed(&pCache->mFrameBufferEvictions, 1);
+			}
+		}
+	}
+
+	uint32_t retiredCount = 0;
+	for (uint32_t i = 0; i < (uint32_t)pCache->mRetiredObjects.size(); ++i)
+	{
+		RetiredCacheObject& retired = pCache->mRetiredObjects[i];
+		if (frame - retired.mFrame >= VK_CACHE_RETIRE_FRAMES)
+			remove_cache_object(pRenderer, retired.pObject, retired.mType);
+		else
+			pCache->mRetiredObjects[retiredCount++] = retired;
+	}
+	pCache->mRetiredObjects.resize(retiredCount);
+}
+
+// Releases all frame buffers using the render target. The caller guarantees that the render target is not used by the GPU anymore
+static void release_render_target_framebuffers(Renderer* pRenderer, const RenderTarget* pRenderTarget)
+{
+	RenderPassCache* pCache = gRenderPassCache[pRenderer->mUnlinkedRendererIndex];
+	MutexLock        lock(pCache->mMutex);
+
+	CacheTable* pTable = (CacheTable*)tfrg_atomicptr_load_relaxed(&pCache->pFrameBufferTable);
+	if (!pTable)
+		return;
+
+	for (uint32_t i = 0; i < pTable->mCapacity; ++i)
 	{
-		return it->second;
+		CacheSlot* pSlot = &pTable->pSlots[i];
+		if (tfrg_atomic64_load_relaxed(&pSlot->mKey) <= VK_CACHE_TOMBSTONE_KEY)
+			continue;
+
+		FrameBuffer* pFrameBuffer = (FrameBuffer*)tfrg_atomicptr_load_relaxed(&pSlot->pObject);
+		for (uint32_t rt = 0; rt < pFrameBuffer->mRenderTargetIdCount; ++rt)
+		{
+			if (pFrameBuffer->mRenderTargetIds[rt] == pRenderTarget->mVulkan.mId)
+			{
+				tfrg_atomic64_store_release(&pSlot->mKey, VK_CACHE_TOMBSTONE_KEY);
+				--pTable->mCount;
+				++pTable->mTombstoneCount;
+				remove_framebuffer(pRenderer, pFrameBuffer);
+				tfrg_atomic64_add_relaxed(&pCache->mFrameBufferReleases, 1);
+				break;
+			}
+		}
 	}
 }
+
+void vk_updateRenderPassCache(Renderer* pRenderer)
+{
+	ASSERT(pRenderer);
+	update_render_pass_cache(pRenderer);
+}
+
+void vk_getRenderPassCacheStats(Renderer* pRenderer, RenderPassCacheStats* pStats)
+{
+	ASSERT(pRenderer);
+	ASSERT(pStats);
+
+	RenderPassCache* pCache = gRenderPassCache[pRenderer->mUnlinkedRendererIndex];
+	MutexLock        lock(pCache->mMutex);
+
+	const CacheTable* pRenderPassTable = (const CacheTable*)tfrg_atomicptr_load_relaxed(&pCache->pRenderPassTable);
+	const CacheTable* pFrameBufferTable = (const CacheTable*)tfrg_atomicptr_load_relaxed(&pCache->pFrameBufferTable);
+
+	pStats->mRenderPassHits = tfrg_atomic64_load_relaxed(&pCache->mRenderPassHits);
+	pStats->mRenderPassMisses = tfrg_atomic64_load_relaxed(&pCache->mRenderPassMisses);
+	pStats->mFrameBufferHits = tfrg_atomic64_load_relaxed(&pCache->mFrameBufferHits);
+	pStats->mFrameBufferMisses = tfrg_atomic64_load_relaxed(&pCache->mFrameBufferMisses);
+	pStats->mFrameBufferEvictions = tfrg_atomic64_load_relaxed(&pCache->mFrameBufferEvictions);
+	pStats->mFrameBufferReleases = tfrg_atomic64_load_relaxed(&pCache->mFrameBufferReleases);
+	pStats->mRenderPassCount = pRenderPassTable ? pRenderPassTable->mCount : 0;
+	pStats->mFrameBufferCount = pFrameBufferTable ? pFrameBufferTable->mCount : 0;
+}
 /************************************************************************/
 // Logging, Validation layer implementation
 /************************************************************************/
@@ -1362,6 +1812,8 @@ static void remove_default_resources(Renderer* pRenderer)
 // Globals
 /************************************************************************/
 static tfrg_atomic32_t gRenderTargetIds = 1;
+static tfrg_atomic32_t gShaderIds = 1;
+static tfrg_atomic32_t gRootSignatureIds = 1;
 /************************************************************************/
 // Internal utility functions
 /************************************************************************/
@@ -2375,7 +2827,10 @@ static bool initCommon(const char* appName, const RendererDesc* pDesc, Renderer*
 	for (uint32_t i = 0; i < (uint32_t)pDesc->mVulkan.mInstanceLayerCount; ++i)
 		instanceLayers[instanceLayerCount++] = pDesc->mVulkan.ppInstanceLayers[i];
 
-#if !defined(NX64)
+#if defined(NULL_RENDERER)
+	// Null configuration, every Vulkan entry point resolves to the driver stub in Renderer/Null
+	volkInitializeCustom(nullVkGetInstanceProcAddr);
+#elif !defined(NX64)
 	VkResult vkRes = volkInitialize();
 	if (vkRes != VK_SUCCESS)
 	{
@@ -2697,6 +3152,10 @@ static bool AddDevice(const RendererDesc* pDesc, Renderer* pRenderer)
 							dedicatedAllocationExtension = true;
 						if (strcmp(wantedDeviceExtensions[k], VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME) == 0)
 							memoryReq2Extension = true;
+#if VK_EXT_memory_budget
+						if (strcmp(wantedDeviceExtensions[k], VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0)
+							pRenderer->mVulkan.mMemoryBudgetExtension = true;
+#endif
 #if defined(VK_USE_PLATFORM_WIN32_KHR)
 						if (strcmp(wantedDeviceExtensions[k], VK_KHR_EXTERNAL_MEMORY_EXTENSION_NAME) == 0)
 							externalMemoryExtension = true;
@@ -3248,6 +3707,13 @@ void vk_initRenderer(const char* appName, const RendererDesc* pDesc, Renderer**
 			createInfo.flags |= VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
 		}
 
+#if VMA_MEMORY_BUDGET
+		if (pRenderer->mVulkan.mMemoryBudgetExtension)
+		{
+			createInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+		}
+#endif
+
 		VmaVulkanFunctions vulkanFunctions = {};
 		vulkanFunctions.vkGetInstanceProcAddr = vkGetInstanceProcAddr;
 		vulkanFunctions.vkGetDeviceProcAddr = vkGetDeviceProcAddr;
@@ -3305,10 +3771,9 @@ void vk_initRenderer(const char* appName, const RendererDesc* pDesc, Renderer**
 	CHECK_VKRESULT(vkCreateDescriptorSetLayout(pRenderer->mVulkan.pVkDevice, &layoutCreateInfo, &gVkAllocationCallbacks, &pRenderer->mVulkan.pEmptyDescriptorSetLayout));
 	consume_descriptor_sets(pRenderer->mVulkan.pVkDevice, pRenderer->mVulkan.pEmptyDescriptorPool, &pRenderer->mVulkan.pEmptyDescriptorSetLayout, 1, emptySets);
 
-	pRenderPassMutex[pRenderer->mUnlinkedRendererIndex] = (Mutex*)tf_calloc(1, sizeof(Mutex));
-	initMutex(pRenderPassMutex[pRenderer->mUnlinkedRendererIndex]);
-	gRenderPassMap[pRenderer->mUnlinkedRendererIndex] = tf_placement_new<eastl::hash_map<ThreadID, RenderPassMap> >(tf_malloc(sizeof(*gRenderPassMap[0])));
-	gFrameBufferMap[pRenderer->mUnlinkedRendererIndex] = tf_placement_new<eastl::hash_map<ThreadID, FrameBufferMap> >(tf_malloc(sizeof(*gFrameBufferMap[0])));
+	add_render_pass_cache(pRenderer);
+	add_bindless_heap(pRenderer, pDesc);
+	reset_barrier_counters(pRenderer);
 
 	VkPhysicalDeviceFeatures2KHR gpuFeatures = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR };
 #ifdef NX64
@@ -3330,6 +3795,7 @@ void vk_initRenderer(const char* appName, const RendererDesc* pDesc, Renderer**
 		{ "UPDATE_FREQ_PER_FRAME", "set = 1" },
 		{ "UPDATE_FREQ_PER_BATCH", "set = 2" },
 		{ "UPDATE_FREQ_PER_DRAW", "set = 3" },
+		{ "UPDATE_FREQ_BINDLESS", "set = 4" },
 	};
 	pRenderer->mBuiltinShaderDefinesCount = sizeof(rendererShaderDefines) / sizeof(rendererShaderDefines[0]);
 	pRenderer->pBuiltinShaderDefines = rendererShaderDefines;
@@ -3372,15 +3838,10 @@ void vk_exitRenderer(Renderer* pRenderer)
 	--gRendererCount;
 
 	remove_default_resources(pRenderer);
+	remove_bindless_heap(pRenderer);
 
-	// Remove the renderpasses
-	for (eastl::hash_map<ThreadID, RenderPassMap>::value_type& t : *gRenderPassMap[pRenderer->mUnlinkedRendererIndex])
-		for (RenderPassMapNode& it : t.second)
-			remove_render_pass(pRenderer, it.second);
-
-	for (eastl::hash_map<ThreadID, FrameBufferMap>::value_type& t : *gFrameBufferMap[pRenderer->mUnlinkedRendererIndex])
-		for (FrameBufferMapNode& it : t.second)
-			remove_framebuffer(pRenderer, it.second);
+	// Remove the renderpasses and framebuffers
+	remove_render_pass_cache(pRenderer);
 
 #if defined(QUEST_VR)
 	hook_pre_remove_renderer();
@@ -3396,14 +3857,6 @@ void vk_exitRenderer(Renderer* pRenderer)
 	if (pRenderer->mVulkan.mOwnInstance)
 		exitCommon(pRenderer);
 
-	destroyMutex(pRenderPassMutex[pRenderer->mUnlinkedRendererIndex]);
-	gRenderPassMap[pRenderer->mUnlinkedRendererIndex]->clear(true);
-	gFrameBufferMap[pRenderer->mUnlinkedRendererIndex]->clear(true);
-
-	SAFE_FREE(pRenderPassMutex[pRenderer->mUnlinkedRendererIndex]);
-	SAFE_FREE(gRenderPassMap[pRenderer->mUnlinkedRendererIndex]);
-	SAFE_FREE(gFrameBufferMap[pRenderer->mUnlinkedRendererIndex]);
-
 	for (uint32_t i = 0; i < pRenderer->mLinkedNodeCount; ++i)
 	{
 		SAFE_FREE(pRenderer->mVulkan.pAvailableQueueCount[i]);
@@ -3418,6 +3871,253 @@ void vk_exitRenderer(Renderer* pRenderer)
 	SAFE_FREE(pRenderer);
 }
 /************************************************************************/
+// Barrier Batching Functions
+/************************************************************************/
+// Transitions are accumulated per Cmd and recorded with a single vkCmdPipelineBarrier before the next command that needs them
+#define VK_MAX_PENDING_BARRIERS 64
+
+// Same state transitions to these states still need a barrier to order the writes
+static const uint32_t VK_BARRIER_WRITE_STATES = RESOURCE_STATE_UNORDERED_ACCESS | RESOURCE_STATE_RENDER_TARGET |
+	RESOURCE_STATE_DEPTH_WRITE | RESOURCE_STATE_STREAM_OUT | RESOURCE_STATE_COPY_DEST | RESOURCE_STATE_COMMON |
+	RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE;
+
+typedef struct PendingBarrier
+{
+	// Buffer* or Texture*
+	void*         pResource;
+	ResourceState mCurrentState;
+	ResourceState mNewState;
+	// State of the previous user of aliased memory (vk_cmdAliasingBarrier)
+	ResourceState mAliasedState;
+	uint16_t      mArrayLayer;
+	uint8_t       mMipLevel;
+	uint8_t       mQueueType;
+	uint32_t      mTexture : 1;
+	uint32_t      mSubresourceBarrier : 1;
+	uint32_t      mAcquire : 1;
+	uint32_t      mRelease : 1;
+} PendingBarrier;
+
+typedef struct PendingBarriers
+{
+	uint32_t       mCount;
+	// Local counters, folded into the renderer counters on flush
+	uint32_t       mRequested;
+	uint32_t       mDropped;
+	uint32_t       mMerged;
+	PendingBarrier mBarriers[VK_MAX_PENDING_BARRIERS];
+} PendingBarriers;
+
+typedef struct BarrierCounters
+{
+	tfrg_atomic64_t mRequested;
+	tfrg_atomic64_t mEmitted;
+	tfrg_atomic64_t mDropped;
+	tfrg_atomic64_t mMerged;
+	tfrg_atomic64_t mPipelineBarrierCalls;
+} BarrierCounters;
+
+static BarrierCounters gBarrierCounters[MAX_UNLINKED_GPUS];
+
+static inline bool is_redundant_transition(const PendingBarrier* pBarrier)
+{
+	return pBarrier->mCurrentState == pBarrier->mNewState && !(pBarrier->mCurrentState & VK_BARRIER_WRITE_STATES) &&
+		   !pBarrier->mAcquire && !pBarrier->mRelease;
+}
+
+static inline bool barriers_overlap(const PendingBarrier* pA, const PendingBarrier* pB)
+{
+	if (pA->pResource != pB->pResource)
+		return false;
+	if (!pA->mSubresourceBarrier || !pB->mSubresourceBarrier)
+		return true;
+	return pA->mMipLevel == pB->mMipLevel && pA->mArrayLayer == pB->mArrayLayer;
+}
+
+static void fill_queue_family_indices(Cmd* pCmd, const PendingBarrier* pTrans, uint32_t* pSrcQueueFamily, uint32_t* pDstQueueFamily)
+{
+	// Images coming from an undefined state have no contents to hand over
+	const bool transfer = pTrans->mTexture ? pTrans->mCurrentState != RESOURCE_STATE_UNDEFINED : true;
+	if (pTrans->mAcquire && transfer)
+	{
+		*pSrcQueueFamily = pCmd->pRenderer->mVulkan.mQueueFamilyIndices[pTrans->mQueueType];
+		*pDstQueueFamily = pCmd->pQueue->mVulkan.mVkQueueFamilyIndex;
+	}
+	else if (pTrans->mRelease && transfer)
+	{
+		*pSrcQueueFamily = pCmd->pQueue->mVulkan.mVkQueueFamilyIndex;
+		*pDstQueueFamily = pCmd->pRenderer->mVulkan.mQueueFamilyIndices[pTrans->mQueueType];
+	}
+	else
+	{
+		*pSrcQueueFamily = VK_QUEUE_FAMILY_IGNORED;
+		*pDstQueueFamily = VK_QUEUE_FAMILY_IGNORED;
+	}
+}
+
+static void flush_barriers(Cmd* pCmd)
+{
+	PendingBarriers* pPending = pCmd->mVulkan.pPendingBarriers;
+	if (!pPending || (!pPending->mCount && !pPending->mRequested))
+		return;
+
+	BarrierCounters* pCounters = &gBarrierCounters[pCmd->pRenderer->mUnlinkedRendererIndex];
+	tfrg_atomic64_add_relaxed(&pCounters->mRequested, pPending->mRequested);
+	tfrg_atomic64_add_relaxed(&pCounters->mDropped, pPending->mDropped);
+	tfrg_atomic64_add_relaxed(&pCounters->mMerged, pPending->mMerged);
+	pPending->mRequested = 0;
+	pPending->mDropped = 0;
+	pPending->mMerged = 0;
+
+	if (!pPending->mCount)
+		return;
+
+	VkImageMemoryBarrier  imageBarriers[VK_MAX_PENDING_BARRIERS];
+	VkBufferMemoryBarrier bufferBarriers[VK_MAX_PENDING_BARRIERS];
+	uint32_t              imageBarrierCount = 0;
+	uint32_t              bufferBarrierCount = 0;
+
+	// Stage masks are derived from the transitions left after merging, so skipped transitions no longer widen them
+	VkAccessFlags srcAccessFlags = 0;
+	VkAccessFlags dstAccessFlags = 0;
+	// Accesses of previous users of aliased memory are covered by a global memory barrier
+	VkMemoryBarrier memoryBarrier = { VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+	uint32_t        memoryBarrierCount = 0;
+
+	for (uint32_t i = 0; i < pPending->mCount; ++i)
+	{
+		const PendingBarrier* pTrans = &pPending->mBarriers[i];
+		const bool            uav =
+			RESOURCE_STATE_UNORDERED_ACCESS == pTrans->mCurrentState && RESOURCE_STATE_UNORDERED_ACCESS == pTrans->mNewState;
+		const VkAccessFlags srcAccessMask = uav ? VK_ACCESS_SHADER_WRITE_BIT : util_to_vk_access_flags(pTrans->mCurrentState);
+		const VkAccessFlags dstAccessMask =
+			uav ? VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT : util_to_vk_access_flags(pTrans->mNewState);
+
+		if (pTrans->mTexture)
+		{
+			Texture*              pTexture = (Texture*)pTrans->pResource;
+			VkImageMemoryBarrier* pImageBarrier = &imageBarriers[imageBarrierCount++];
+			pImageBarrier->sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			pImageBarrier->pNext = NULL;
+			pImageBarrier->srcAccessMask = srcAccessMask;
+			pImageBarrier->dstAccessMask = dstAccessMask;
+			pImageBarrier->oldLayout = uav ? VK_IMAGE_LAYOUT_GENERAL : util_to_vk_image_layout(pTrans->mCurrentState);
+			pImageBarrier->newLayout = uav ? VK_IMAGE_LAYOUT_GENERAL : util_to_vk_image_layout(pTrans->mNewState);
+			pImageBarrier->image = pTexture->mVulkan.pVkImage;
+			pImageBarrier->subresourceRange.aspectMask = (VkImageAspectFlags)pTexture->mAspectMask;
+			pImageBarrier->subresourceRange.baseMipLevel = pTrans->mSubresourceBarrier ? pTrans->mMipLevel : 0;
+			pImageBarrier->subresourceRange.levelCount = pTrans->mSubresourceBarrier ? 1 : VK_REMAINING_MIP_LEVELS;
+			pImageBarrier->subresourceRange.baseArrayLayer = pTrans->mSubresourceBarrier ? pTrans->mArrayLayer : 0;
+			pImageBarrier->subresourceRange.layerCount = pTrans->mSubresourceBarrier ? 1 : VK_REMAINING_ARRAY_LAYERS;
+			fill_queue_family_indices(pCmd, pTrans, &pImageBarrier->srcQueueFamilyIndex, &pImageBarrier->dstQueueFamilyIndex);
+		}
+		else
+		{
+			Buffer*                pBuffer = (Buffer*)pTrans->pResource;
+			VkBufferMemoryBarrier* pBufferBarrier = &bufferBarriers[bufferBarrierCount++];
+			pBufferBarrier->sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			pBufferBarrier->pNext = NULL;
+			pBufferBarrier->srcAccessMask = srcAccessMask;
+			pBufferBarrier->dstAccessMask = dstAccessMask;
+			pBufferBarrier->buffer = pBuffer->mVulkan.pVkBuffer;
+			pBufferBarrier->size = VK_WHOLE_SIZE;
+			pBufferBarrier->offset = 0;
+			fill_queue_family_indices(pCmd, pTrans, &pBufferBarrier->srcQueueFamilyIndex, &pBufferBarrier->dstQueueFamilyIndex);
+		}
+
+		srcAccessFlags |= srcAccessMask;
+		dstAccessFlags |= dstAccessMask;
+
+		if (pTrans->mAliasedState)
+		{
+			memoryBarrier.srcAccessMask |= util_to_vk_access_flags(pTrans->mAliasedState);
+			memoryBarrier.dstAccessMask |= dstAccessMask;
+			memoryBarrierCount = 1;
+		}
+	}
+
+	pPending->mCount = 0;
+	srcAccessFlags |= memoryBarrier.srcAccessMask;
+
+	VkPipelineStageFlags srcStageMask =
+		util_determine_pipeline_stage_flags(pCmd->pRenderer, srcAccessFlags, (QueueType)pCmd->mVulkan.mType);
+	VkPipelineStageFlags dstStageMask =
+		util_determine_pipeline_stage_flags(pCmd->pRenderer, dstAccessFlags, (QueueType)pCmd->mVulkan.mType);
+
+	vkCmdPipelineBarrier(
+		pCmd->mVulkan.pVkCmdBuf, srcStageMask, dstStageMask, 0, memoryBarrierCount, &memoryBarrier, bufferBarrierCount, bufferBarriers,
+		imageBarrierCount, imageBarriers);
+
+	tfrg_atomic64_add_relaxed(&pCounters->mEmitted, bufferBarrierCount + imageBarrierCount);
+	tfrg_atomic64_add_relaxed(&pCounters->mPipelineBarrierCalls, 1);
+}
+
+static void queue_barrier(Cmd* pCmd, const PendingBarrier* pBarrier)
+{
+	PendingBarriers* pPending = pCmd->mVulkan.pPendingBarriers;
+	++pPending->mRequested;
+
+	if (is_redundant_transition(pBarrier))
+	{
+		++pPending->mDropped;
+		return;
+	}
+
+	for (uint32_t i = 0; i < pPending->mCount; ++i)
+	{
+		PendingBarrier* pOther = &pPending->mBarriers[i];
+		if (!barriers_overlap(pOther, pBarrier))
+			continue;
+
+		// Queue ownership transfers and partially overlapping ranges have to stay ordered
+		const bool mergeable = pOther->mSubresourceBarrier == pBarrier->mSubresourceBarrier && !pOther->mAcquire &&
+							   !pOther->mRelease && !pBarrier->mAcquire && !pBarrier->mRelease && !pBarrier->mAliasedState;
+		if (mergeable && pOther->mCurrentState == pBarrier->mCurrentState && pOther->mNewState == pBarrier->mNewState)
+		{
+			++pPending->mDropped;
+			return;
+		}
+		if (mergeable && pOther->mNewState == pBarrier->mCurrentState)
+		{
+			// Nothing was recorded in between, A -> B -> C becomes A -> C
+			pOther->mNewState = pBarrier->mNewState;
+			++pPending->mMerged;
+			if (is_redundant_transition(pOther))
+			{
+				pPending->mBarriers[i] = pPending->mBarriers[--pPending->mCount];
+				++pPending->mDropped;
+			}
+			return;
+		}
+
+		flush_barriers(pCmd);
+		break;
+	}
+
+	if (VK_MAX_PENDING_BARRIERS == pPending->mCount)
+		flush_barriers(pCmd);
+
+	pPending->mBarriers[pPending->mCount++] = *pBarrier;
+}
+
+static void reset_barrier_counters(Renderer* pRenderer)
+{
+	memset(&gBarrierCounters[pRenderer->mUnlinkedRendererIndex], 0, sizeof(BarrierCounters));
+}
+
+void vk_getBarrierStats(Renderer* pRenderer, BarrierStats* pStats)
+{
+	ASSERT(pRenderer);
+	ASSERT(pStats);
+
+	BarrierCounters* pCounters = &gBarrierCounters[pRenderer->mUnlinkedRendererIndex];
+	pStats->mBarriersRequested = tfrg_atomic64_load_relaxed(&pCounters->mRequested);
+	pStats->mBarriersEmitted = tfrg_atomic64_load_relaxed(&pCounters->mEmitted);
+	pStats->mBarriersDropped = tfrg_atomic64_load_relaxed(&pCounters->mDropped);
+	pStats->mBarriersMerged = tfrg_atomic64_load_relaxed(&pCounters->mMerged);
+	pStats->mPipelineBarrierCalls = tfrg_atomic64_load_relaxed(&pCounters->mPipelineBarrierCalls);
+}
+/************************************************************************/
 // Resource Creation Functions
 /************************************************************************/
 void vk_addFence(Renderer* pRenderer, Fence** ppFence)
@@ -3597,6 +4297,9 @@ void vk_addCmd(Renderer* pRenderer, const CmdDesc* pDesc, Cmd** ppCmd)
 	pCmd->mVulkan.pCmdPool = pDesc->pPool;
 	pCmd->mVulkan.mType = pDesc->pPool->pQueue->mType;
 	pCmd->mVulkan.mNodeIndex = pDesc->pPool->pQueue->mNodeIndex;
+	pCmd->mVulkan.mSecondary = pDesc->mSecondary;
+	pCmd->mVulkan.pPendingBarriers = (PendingBarriers*)tf_calloc(1, sizeof(PendingBarriers));
+	ASSERT(pCmd->mVulkan.pPendingBarriers);
 
 	DECLARE_ZERO(VkCommandBufferAllocateInfo, alloc_info);
 	alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -3618,6 +4321,7 @@ void vk_removeCmd(Renderer* pRenderer, Cmd* pCmd)
 
 	vkFreeCommandBuffers(pRenderer->mVulkan.pVkDevice, pCmd->mVulkan.pCmdPool->pVkCmdPool, 1, &(pCmd->mVulkan.pVkCmdBuf));
 
+	SAFE_FREE(pCmd->mVulkan.pPendingBarriers);
 	SAFE_FREE(pCmd);
 }
 
@@ -4194,6 +4898,13 @@ void vk_addBuffer(Renderer* pRenderer, const BufferDesc* pDesc, Buffer** ppBuffe
 	pBuffer->mNodeIndex = pDesc->mNodeIndex;
 	pBuffer->mDescriptors = pDesc->mDescriptors;
 
+	pBuffer->mBindlessIndex = BINDLESS_INVALID_INDEX;
+	if (pDesc->mDescriptors & (DESCRIPTOR_TYPE_BUFFER | DESCRIPTOR_TYPE_BUFFER_RAW | DESCRIPTOR_TYPE_RW_BUFFER | DESCRIPTOR_TYPE_RW_BUFFER_RAW))
+	{
+		VkDescriptorBufferInfo bufferInfo = { pBuffer->mVulkan.pVkBuffer, pBuffer->mVulkan.mOffset, pDesc->mSize };
+		pBuffer->mBindlessIndex = add_bindless_descriptor(pRenderer, NULL, &bufferInfo);
+	}
+
 	*ppBuffer = pBuffer;
 }
 
@@ -4215,6 +4926,8 @@ void vk_removeBuffer(Renderer* pRenderer, Buffer* pBuffer)
 		pBuffer->mVulkan.pVkStorageTexelView = VK_NULL_HANDLE;
 	}
 
+	remove_bindless_descriptor(pRenderer, pBuffer->mBindlessIndex, false);
+
 	vmaDestroyBuffer(pRenderer->mVulkan.pVmaAllocator, pBuffer->mVulkan.pVkBuffer, pBuffer->mVulkan.pVkAllocation);
 
 	SAFE_FREE(pBuffer);
@@ -4400,7 +5113,8 @@ void vk_addTexture(Renderer* pRenderer, const TextureDesc* pDesc, Texture** ppTe
 
 
 		// If lazy allocation is requested, check that the hardware supports it
-		bool lazyAllocation = pDesc->mFlags & TEXTURE_CREATION_FLAG_ON_TILE;
+		// Placed textures use the memory type of their heap
+		bool lazyAllocation = (pDesc->mFlags & TEXTURE_CREATION_FLAG_ON_TILE) && !pDesc->pPlacement;
 		if (lazyAllocation)
 		{
 			uint32_t memoryTypeIndex = 0;
@@ -4420,7 +5134,22 @@ void vk_addTexture(Renderer* pRenderer, const TextureDesc* pDesc, Texture** ppTe
 		}
 
 		VmaAllocationInfo alloc_info = {};
-		if (isSinglePlane)
+		if (pDesc->pPlacement)
+		{
+			ASSERT(isSinglePlane && !linkedMultiGpu && "Placed textures only support single plane formats on a single GPU");
+			const ResourcePlacement* pPlacement = pDesc->pPlacement;
+			CHECK_VKRESULT(vkCreateImage(pRenderer->mVulkan.pVkDevice, &add_info, &gVkAllocationCallbacks, &pTexture->mVulkan.pVkImage));
+
+			VkMemoryRequirements memReqs = {};
+			vkGetImageMemoryRequirements(pRenderer->mVulkan.pVkDevice, pTexture->mVulkan.pVkImage, &memReqs);
+			ASSERT(!(pPlacement->mOffset % memReqs.alignment) && pPlacement->mOffset + memReqs.size <= pPlacement->pHeap->mSize);
+
+			// The heap keeps the allocation, vmaDestroyImage only destroys the image when pVkAllocation is NULL
+			CHECK_VKRESULT(vmaBindImageMemory2(
+				pRenderer->mVulkan.pVmaAllocator, pPlacement->pHeap->mVulkan.pAllocation, pPlacement->mOffset, pTexture->mVulkan.pVkImage,
+				NULL));
+		}
+		else if (isSinglePlane)
 		{
 			CHECK_VKRESULT(vmaCreateImage(
 				pRenderer->mVulkan.pVmaAllocator, &add_info, &mem_reqs, &pTexture->mVulkan.pVkImage, &pTexture->mVulkan.pVkAllocation,
@@ -4599,6 +5328,13 @@ void vk_addTexture(Renderer* pRenderer, const TextureDesc* pDesc, Texture** ppTe
 	pTexture->mArraySizeMinusOne = arraySize - 1;
 	pTexture->mFormat = pDesc->mFormat;
 
+	pTexture->mBindlessIndex = BINDLESS_INVALID_INDEX;
+	if (VK_NULL_HANDLE != pTexture->mVulkan.pVkSRVDescriptor && !pDesc->pVkSamplerYcbcrConversionInfo)
+	{
+		VkDescriptorImageInfo imageInfo = { VK_NULL_HANDLE, pTexture->mVulkan.pVkSRVDescriptor, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+		pTexture->mBindlessIndex = add_bindless_descriptor(pRenderer, &imageInfo, NULL);
+	}
+
 #if defined(ENABLE_GRAPHICS_DEBUG)
 	if (pDesc->pName)
 	{
@@ -4631,6 +5367,8 @@ void vk_removeTexture(Renderer* pRenderer, Texture* pTexture)
 		}
 	}
 
+	remove_bindless_descriptor(pRenderer, pTexture->mBindlessIndex, true);
+
 	if (VK_NULL_HANDLE != pTexture->mVulkan.pVkSRVDescriptor)
 		vkDestroyImageView(pRenderer->mVulkan.pVkDevice, pTexture->mVulkan.pVkSRVDescriptor, &gVkAllocationCallbacks);
 
@@ -4705,6 +5443,7 @@ void vk_addRenderTarget(Renderer* pRenderer, const RenderTargetDesc* pDesc, Rend
 	textureDesc.mNodeIndex = pDesc->mNodeIndex;
 	textureDesc.pSharedNodeIndices = pDesc->pSharedNodeIndices;
 	textureDesc.mSharedNodeIndexCount = pDesc->mSharedNodeIndexCount;
+	textureDesc.pPlacement = pDesc->pPlacement;
 
 	if (!isDepth)
 		textureDesc.mStartState |= RESOURCE_STATE_RENDER_TARGET;
@@ -4820,6 +5559,8 @@ void vk_addRenderTarget(Renderer* pRenderer, const RenderTargetDesc* pDesc, Rend
 
 void vk_removeRenderTarget(Renderer* pRenderer, RenderTarget* pRenderTarget)
 {
+	release_render_target_framebuffers(pRenderer, pRenderTarget);
+
 	::vk_removeTexture(pRenderer, pRenderTarget->pTexture);
 
 	vkDestroyImageView(pRenderer->mVulkan.pVkDevice, pRenderTarget->mVulkan.pVkDescriptor, &gVkAllocationCallbacks);
@@ -4843,6 +5584,103 @@ void vk_removeRenderTarget(Renderer* pRenderer, RenderTarget* pRenderTarget)
 	SAFE_FREE(pRenderTarget);
 }
 
+void vk_addResourceHeap(Renderer* pRenderer, const ResourceHeapDesc* pDesc, ResourceHeap** ppHeap)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc && pDesc->mSize);
+	ASSERT(ppHeap);
+	ASSERT(pRenderer->mGpuMode != GPU_MODE_UNLINKED || pDesc->mNodeIndex == pRenderer->mUnlinkedRendererIndex);
+
+	ResourceHeap* pHeap = (ResourceHeap*)tf_calloc(1, sizeof(ResourceHeap));
+	ASSERT(pHeap);
+
+	VkMemoryRequirements memReqs = {};
+	memReqs.size = pDesc->mSize;
+	memReqs.alignment = pDesc->mAlignment;
+	memReqs.memoryTypeBits = pDesc->mMemoryTypeBits;
+
+	VmaAllocationCreateInfo allocInfo = {};
+	allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+	CHECK_VKRESULT(vmaAllocateMemory(pRenderer->mVulkan.pVmaAllocator, &memReqs, &allocInfo, &pHeap->mVulkan.pAllocation, NULL));
+
+	pHeap->mSize = pDesc->mSize;
+
+	*ppHeap = pHeap;
+}
+
+void vk_removeResourceHeap(Renderer* pRenderer, ResourceHeap* pHeap)
+{
+	ASSERT(pRenderer);
+	ASSERT(pHeap);
+
+	vmaFreeMemory(pRenderer->mVulkan.pVmaAllocator, pHeap->mVulkan.pAllocation);
+
+	SAFE_FREE(pHeap);
+}
+
+void vk_getRenderTargetSizeAlign(Renderer* pRenderer, const RenderTargetDesc* pDesc, ResourceSizeAlign* pSizeAlign)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+	ASSERT(pSizeAlign);
+
+	// Same image vk_addRenderTarget creates through vk_addTexture
+	const bool     isDepth = TinyImageFormat_IsDepthOnly(pDesc->mFormat) || TinyImageFormat_IsDepthAndStencil(pDesc->mFormat);
+	DescriptorType descriptors = pDesc->mDescriptors;
+	if (!(pDesc->mFlags & TEXTURE_CREATION_FLAG_ON_TILE))
+		descriptors |= DESCRIPTOR_TYPE_TEXTURE;
+	else
+		descriptors &= (DescriptorType)(~(DESCRIPTOR_TYPE_TEXTURE | DESCRIPTOR_TYPE_RW_TEXTURE));
+
+	uint32_t arraySize = pDesc->mArraySize;
+#if defined(QUEST_VR)
+	if (pDesc->mFlags & TEXTURE_CREATION_FLAG_VR_MULTIVIEW)
+		arraySize = 2;
+#endif
+
+	VkImageType imageType = VK_IMAGE_TYPE_1D;
+	if (pDesc->mFlags & TEXTURE_CREATION_FLAG_FORCE_2D)
+		imageType = VK_IMAGE_TYPE_2D;
+	else if ((pDesc->mFlags & TEXTURE_CREATION_FLAG_FORCE_3D) || pDesc->mDepth > 1)
+		imageType = VK_IMAGE_TYPE_3D;
+	else if (pDesc->mHeight > 1)
+		imageType = VK_IMAGE_TYPE_2D;
+
+	DECLARE_ZERO(VkImageCreateInfo, add_info);
+	add_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	add_info.pNext = NULL;
+	add_info.flags = 0;
+	if (DESCRIPTOR_TYPE_TEXTURE_CUBE == (descriptors & DESCRIPTOR_TYPE_TEXTURE_CUBE))
+		add_info.flags |= VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+	if (VK_IMAGE_TYPE_3D == imageType)
+		add_info.flags |= VK_IMAGE_CREATE_2D_ARRAY_COMPATIBLE_BIT_KHR;
+	add_info.imageType = imageType;
+	add_info.format = (VkFormat)TinyImageFormat_ToVkFormat(pDesc->mFormat);
+	add_info.extent.width = pDesc->mWidth;
+	add_info.extent.height = pDesc->mHeight;
+	add_info.extent.depth = pDesc->mDepth;
+	add_info.mipLevels = max(1U, pDesc->mMipLevels);
+	add_info.arrayLayers = arraySize;
+	add_info.samples = util_to_vk_sample_count(pDesc->mSampleCount);
+	add_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+	add_info.usage = util_to_vk_image_usage(descriptors);
+	add_info.usage |= isDepth ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT : VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	if ((VK_IMAGE_USAGE_SAMPLED_BIT & add_info.usage) || (VK_IMAGE_USAGE_STORAGE_BIT & add_info.usage))
+		add_info.usage |= (VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+	add_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	add_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	VkImage image = VK_NULL_HANDLE;
+	CHECK_VKRESULT(vkCreateImage(pRenderer->mVulkan.pVkDevice, &add_info, &gVkAllocationCallbacks, &image));
+	VkMemoryRequirements memReqs = {};
+	vkGetImageMemoryRequirements(pRenderer->mVulkan.pVkDevice, image, &memReqs);
+	vkDestroyImage(pRenderer->mVulkan.pVkDevice, image, &gVkAllocationCallbacks);
+
+	pSizeAlign->mSize = memReqs.size;
+	pSizeAlign->mAlignment = memReqs.alignment;
+	pSizeAlign->mMemoryTypeBits = memReqs.memoryTypeBits;
+}
+
 void vk_addSampler(Renderer* pRenderer, const SamplerDesc* pDesc, Sampler** ppSampler)
 {
 	ASSERT(pRenderer);
@@ -5472,17 +6310,309 @@ void vk_updateDescriptorSet(
 	vkUpdateDescriptorSets(pRenderer->mVulkan.pVkDevice, writeSetCount, writeSetArray, 0, NULL);
 }
 
-static const uint32_t VK_MAX_ROOT_DESCRIPTORS = 32;
+/************************************************************************/
+// Descriptor Update Plans
+/************************************************************************/
+typedef struct DescriptorUpdatePlanEntry
+{
+	const DescriptorInfo* pDesc;
+	uint32_t              mDataOffset;
+	uint32_t              mArrayCount;
+} DescriptorUpdatePlanEntry;
 
-void vk_cmdBindDescriptorSet(Cmd* pCmd, uint32_t index, DescriptorSet* pDescriptorSet)
+typedef struct DescriptorUpdatePlan
 {
-	ASSERT(pCmd);
+	VkDescriptorUpdateTemplate pTemplate;
+	const RootSignature*       pRootSignature;
+	DescriptorUpdatePlanEntry* pEntries;
+	uint32_t                   mEntryCount;
+	/// Size of the packed descriptor data consumed by the template
+	uint32_t                   mDataSize;
+	uint32_t                   mUpdateFrequency;
+} DescriptorUpdatePlan;
+
+static uint32_t get_descriptor_update_data_stride(DescriptorType type)
+{
+	switch (type)
+	{
+	case DESCRIPTOR_TYPE_SAMPLER:
+	case DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+	case DESCRIPTOR_TYPE_TEXTURE:
+	case DESCRIPTOR_TYPE_RW_TEXTURE: return sizeof(VkDescriptorImageInfo);
+	case DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+	case DESCRIPTOR_TYPE_BUFFER:
+	case DESCRIPTOR_TYPE_BUFFER_RAW:
+	case DESCRIPTOR_TYPE_RW_BUFFER:
+	case DESCRIPTOR_TYPE_RW_BUFFER_RAW: return sizeof(VkDescriptorBufferInfo);
+	case DESCRIPTOR_TYPE_TEXEL_BUFFER:
+	case DESCRIPTOR_TYPE_RW_TEXEL_BUFFER: return sizeof(VkBufferView);
+#ifdef VK_RAYTRACING_AVAILABLE
+	case DESCRIPTOR_TYPE_RAY_TRACING: return sizeof(VkAccelerationStructureKHR);
+#endif
+	default: return 0;
+	}
+}
+
+void vk_addDescriptorUpdatePlan(Renderer* pRenderer, const DescriptorUpdatePlanDesc* pDesc, DescriptorUpdatePlan** ppPlan)
+{
+	ASSERT(pRenderer);
+	ASSERT(pDesc);
+	ASSERT(pDesc->pRootSignature);
+	ASSERT(pDesc->pLayout && pDesc->mLayoutCount);
+	ASSERT(ppPlan);
+
+	const RootSignature*            pRootSignature = pDesc->pRootSignature;
+	const DescriptorUpdateFrequency updateFreq = pDesc->mUpdateFrequency;
+	ASSERT(VK_NULL_HANDLE != pRootSignature->mVulkan.mVkDescriptorSetLayouts[updateFreq]);
+
+	size_t totalSize = sizeof(DescriptorUpdatePlan);
+	totalSize += pDesc->mLayoutCount * sizeof(DescriptorUpdatePlanEntry);
+
+	DescriptorUpdatePlan* pPlan = (DescriptorUpdatePlan*)tf_calloc_memalign(1, alignof(DescriptorUpdatePlan), totalSize);
+	ASSERT(pPlan);
+
+	pPlan->pRootSignature = pRootSignature;
+	pPlan->pEntries = (DescriptorUpdatePlanEntry*)(pPlan + 1);
+	pPlan->mEntryCount = pDesc->mLayoutCount;
+	pPlan->mUpdateFrequency = updateFreq;
+
+	VkDescriptorUpdateTemplateEntry* pTemplateEntries =
+		(VkDescriptorUpdateTemplateEntry*)alloca(pDesc->mLayoutCount * sizeof(VkDescriptorUpdateTemplateEntry));
+	uint32_t templateEntryCount = 0;
+	uint32_t dataSize = 0;
+
+	// Resolve names once here so applying the plan never touches the name map
+	for (uint32_t i = 0; i < pDesc->mLayoutCount; ++i)
+	{
+		const DescriptorData* pLayout = pDesc->pLayout + i;
+		const DescriptorInfo* pInfo =
+			pLayout->mBindByIndex ? (pRootSignature->pDescriptors + pLayout->mIndex) : get_descriptor(pRootSignature, pLayout->pName);
+		if (!pInfo)
+		{
+			LOGF(LogLevel::eERROR, "Descriptor update plan : Invalid descriptor (%s)", pLayout->pName ? pLayout->pName : "NULL");
+			ASSERT(false);
+			continue;
+		}
+
+		const DescriptorType type = (DescriptorType)pInfo->mType;
+		const uint32_t       stride = get_descriptor_update_data_stride(type);
+		const uint32_t       arrayCount = max(1U, pLayout->mCount);
+		if (pInfo->mUpdateFrequency != updateFreq || pInfo->mStaticSampler || pInfo->mRootDescriptor || !stride)
+		{
+			LOGF(
+				LogLevel::eERROR,
+				"Descriptor update plan : Descriptor (%s) cannot be updated through a plan. It must match the update frequency and cannot "
+				"be a static sampler or root descriptor",
+				pInfo->pName);
+			ASSERT(false);
+			continue;
+		}
+		ASSERT(pLayout->mArrayOffset + arrayCount <= pInfo->mSize);
+
+		DescriptorUpdatePlanEntry* pEntry = &pPlan->pEntries[i];
+		pEntry->pDesc = pInfo;
+		pEntry->mDataOffset = dataSize;
+		pEntry->mArrayCount = arrayCount;
+
+		VkDescriptorUpdateTemplateEntry* pTemplateEntry = &pTemplateEntries[templateEntryCount++];
+		pTemplateEntry->dstBinding = pInfo->mVulkan.mReg;
+		pTemplateEntry->dstArrayElement = pLayout->mArrayOffset;
+		pTemplateEntry->descriptorCount = arrayCount;
+		pTemplateEntry->descriptorType = (VkDescriptorType)pInfo->mVulkan.mVkType;
+		pTemplateEntry->offset = dataSize;
+		pTemplateEntry->stride = stride;
+
+		dataSize += arrayCount * stride;
+	}
+
+	pPlan->mDataSize = dataSize;
+	// Packed data is written to the scratch memory of the descriptor set, which is sized for every descriptor of this frequency
+	ASSERT(dataSize <= pRootSignature->mVulkan.mCumulativeDescriptorSizes[updateFreq]);
+
+	if (templateEntryCount)
+	{
+		VkDescriptorUpdateTemplateCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+		createInfo.pNext = NULL;
+		createInfo.flags = 0;
+		createInfo.descriptorUpdateEntryCount = templateEntryCount;
+		createInfo.pDescriptorUpdateEntries = pTemplateEntries;
+		createInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+		createInfo.descriptorSetLayout = pRootSignature->mVulkan.mVkDescriptorSetLayouts[updateFreq];
+		createInfo.pipelineBindPoint = gPipelineBindPoint[pRootSignature->mPipelineType];
+		createInfo.pipelineLayout = pRootSignature->mVulkan.pPipelineLayout;
+		createInfo.set = updateFreq;
+		CHECK_VKRESULT(vkCreateDescriptorUpdateTemplate(pRenderer->mVulkan.pVkDevice, &createInfo, &gVkAllocationCallbacks, &pPlan->pTemplate));
+	}
+
+	*ppPlan = pPlan;
+}
+
+void vk_removeDescriptorUpdatePlan(Renderer* pRenderer, DescriptorUpdatePlan* pPlan)
+{
+	ASSERT(pRenderer);
+	ASSERT(pPlan);
+
+	if (pPlan->pTemplate != VK_NULL_HANDLE)
+	{
+		vkDestroyDescriptorUpdateTemplate(pRenderer->mVulkan.pVkDevice, pPlan->pTemplate, &gVkAllocationCallbacks);
+	}
+	SAFE_FREE(pPlan);
+}
+
+static void fill_descriptor_update_plan_data(const DescriptorUpdatePlan* pPlan, const DescriptorData* pParams, uint8_t* pData)
+{
+	for (uint32_t i = 0; i < pPlan->mEntryCount; ++i)
+	{
+		const DescriptorUpdatePlanEntry* pEntry = &pPlan->pEntries[i];
+		const DescriptorInfo*            pDesc = pEntry->pDesc;
+		if (!pDesc)
+		{
+			continue;
+		}
+
+		const DescriptorData* pParam = pParams + i;
+		const uint32_t        arrayCount = pEntry->mArrayCount;
+		uint8_t*              descriptorUpdateData = pData + pEntry->mDataOffset;
+
+		VALIDATE_DESCRIPTOR(pParam->ppBuffers, "NULL resource array (%s)", pDesc->pName);
+
+		switch ((DescriptorType)pDesc->mType)
+		{
+		case DESCRIPTOR_TYPE_SAMPLER:
+		{
+			VkDescriptorImageInfo* updateData = (VkDescriptorImageInfo*)descriptorUpdateData;
+			for (uint32_t arr = 0; arr < arrayCount; ++arr)
+			{
+				VALIDATE_DESCRIPTOR(pParam->ppSamplers[arr], "NULL Sampler (%s [%u] )", pDesc->pName, arr);
+				updateData[arr] = { pParam->ppSamplers[arr]->mVulkan.pVkSampler, VK_NULL_HANDLE };
+			}
+			break;
+		}
+		case DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+		case DESCRIPTOR_TYPE_TEXTURE:
+		{
+			VkDescriptorImageInfo* updateData = (VkDescriptorImageInfo*)descriptorUpdateData;
+			const bool             bindStencil = DESCRIPTOR_TYPE_TEXTURE == pDesc->mType && pParam->mBindStencilResource;
+			for (uint32_t arr = 0; arr < arrayCount; ++arr)
+			{
+				VALIDATE_DESCRIPTOR(pParam->ppTextures[arr], "NULL Texture (%s [%u] )", pDesc->pName, arr);
+				VkImageView view =
+					bindStencil ? pParam->ppTextures[arr]->mVulkan.pVkSRVStencilDescriptor : pParam->ppTextures[arr]->mVulkan.pVkSRVDescriptor;
+				updateData[arr] = { VK_NULL_HANDLE, view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+			}
+			break;
+		}
+		case DESCRIPTOR_TYPE_RW_TEXTURE:
+		{
+			VkDescriptorImageInfo* updateData = (VkDescriptorImageInfo*)descriptorUpdateData;
+			if (pParam->mBindMipChain)
+			{
+				VALIDATE_DESCRIPTOR(pParam->ppTextures[0], "NULL RW Texture (%s)", pDesc->pName);
+				VALIDATE_DESCRIPTOR(
+					pParam->ppTextures[0]->mMipLevels == arrayCount, "Descriptor (%s) - Plan array count (%u) does not match mip levels (%u)",
+					pDesc->pName, arrayCount, pParam->ppTextures[0]->mMipLevels);
+
+				for (uint32_t arr = 0; arr < arrayCount; ++arr)
+				{
+					updateData[arr] = { VK_NULL_HANDLE, pParam->ppTextures[0]->mVulkan.pVkUAVDescriptors[arr], VK_IMAGE_LAYOUT_GENERAL };
+				}
+			}
+			else
+			{
+				const uint32_t mipSlice = pParam->mUAVMipSlice;
+				for (uint32_t arr = 0; arr < arrayCount; ++arr)
+				{
+					VALIDATE_DESCRIPTOR(pParam->ppTextures[arr], "NULL RW Texture (%s [%u] )", pDesc->pName, arr);
+					VALIDATE_DESCRIPTOR(
+						mipSlice < pParam->ppTextures[arr]->mMipLevels, "Descriptor : (%s [%u] ) Mip Slice (%u) exceeds mip levels (%u)",
+						pDesc->pName, arr, mipSlice, pParam->ppTextures[arr]->mMipLevels);
+					updateData[arr] = { VK_NULL_HANDLE, pParam->ppTextures[arr]->mVulkan.pVkUAVDescriptors[mipSlice], VK_IMAGE_LAYOUT_GENERAL };
+				}
+			}
+			break;
+		}
+		case DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+		case DESCRIPTOR_TYPE_BUFFER:
+		case DESCRIPTOR_TYPE_BUFFER_RAW:
+		case DESCRIPTOR_TYPE_RW_BUFFER:
+		case DESCRIPTOR_TYPE_RW_BUFFER_RAW:
+		{
+			VkDescriptorBufferInfo* updateData = (VkDescriptorBufferInfo*)descriptorUpdateData;
+			for (uint32_t arr = 0; arr < arrayCount; ++arr)
+			{
+				VALIDATE_DESCRIPTOR(pParam->ppBuffers[arr], "NULL Buffer (%s [%u] )", pDesc->pName, arr);
+				updateData[arr] = { pParam->ppBuffers[arr]->mVulkan.pVkBuffer, pParam->ppBuffers[arr]->mVulkan.mOffset, VK_WHOLE_SIZE };
+
+				if (pParam->pRanges)
+				{
+					VALIDATE_DESCRIPTOR(pParam->pRanges[arr].mSize, "Descriptor (%s) - pRanges[%u].mSize is zero", pDesc->pName, arr);
+					updateData[arr].offset = pParam->pRanges[arr].mOffset;
+					updateData[arr].range = pParam->pRanges[arr].mSize;
+				}
+			}
+			break;
+		}
+		case DESCRIPTOR_TYPE_TEXEL_BUFFER:
+		case DESCRIPTOR_TYPE_RW_TEXEL_BUFFER:
+		{
+			VkBufferView* updateData = (VkBufferView*)descriptorUpdateData;
+			const bool    storage = DESCRIPTOR_TYPE_RW_TEXEL_BUFFER == pDesc->mType;
+			for (uint32_t arr = 0; arr < arrayCount; ++arr)
+			{
+				VALIDATE_DESCRIPTOR(pParam->ppBuffers[arr], "NULL Texel Buffer (%s [%u] )", pDesc->pName, arr);
+				updateData[arr] =
+					storage ? pParam->ppBuffers[arr]->mVulkan.pVkStorageTexelView : pParam->ppBuffers[arr]->mVulkan.pVkUniformTexelView;
+			}
+			break;
+		}
+#ifdef VK_RAYTRACING_AVAILABLE
+		case DESCRIPTOR_TYPE_RAY_TRACING:
+		{
+			vk_FillRaytracingDescriptorData(arrayCount, pParam->ppAccelerationStructures, (VkAccelerationStructureKHR*)descriptorUpdateData);
+			break;
+		}
+#endif
+		default: break;
+		}
+	}
+}
+
+void vk_updateDescriptorSetsWithPlan(
+	Renderer* pRenderer, const DescriptorUpdatePlan* pPlan, DescriptorSet* pDescriptorSet, uint32_t setCount, const uint32_t* pIndices,
+	const DescriptorData* pParams)
+{
+	ASSERT(pRenderer);
+	ASSERT(pPlan);
 	ASSERT(pDescriptorSet);
 	ASSERT(pDescriptorSet->mVulkan.pHandles);
-	ASSERT(index < pDescriptorSet->mVulkan.mMaxSets);
+	ASSERT(pIndices);
+	ASSERT(pParams);
+	ASSERT(pPlan->pRootSignature == pDescriptorSet->mVulkan.pRootSignature);
+	ASSERT(pPlan->mUpdateFrequency == pDescriptorSet->mVulkan.mUpdateFrequency);
 
-	const RootSignature* pRootSignature = pDescriptorSet->mVulkan.pRootSignature;
+	if (VK_NULL_HANDLE == pPlan->pTemplate)
+	{
+		return;
+	}
+
+	// The template consumes the packed data during the call, so the set scratch memory is reused for every set in the batch
+	uint8_t* pData = pDescriptorSet->mVulkan.pDescriptorData;
+	for (uint32_t s = 0; s < setCount; ++s)
+	{
+		const uint32_t index = pIndices[s];
+		ASSERT(index < pDescriptorSet->mVulkan.mMaxSets);
+
+		fill_descriptor_update_plan_data(pPlan, pParams + s * pPlan->mEntryCount, pData);
+		vkUpdateDescriptorSetWithTemplate(pRenderer->mVulkan.pVkDevice, pDescriptorSet->mVulkan.pHandles[index], pPlan->pTemplate, pData);
+	}
+}
 
+static const uint32_t VK_MAX_ROOT_DESCRIPTORS = 32;
+
+// Binds the empty and bindless sets of the root signature when its pipeline layout is not bound yet
+static void bind_root_signature_sets(Cmd* pCmd, const RootSignature* pRootSignature)
+{
 	if (pCmd->mVulkan.pBoundPipelineLayout != pRootSignature->mVulkan.pPipelineLayout)
 	{
 		pCmd->mVulkan.pBoundPipelineLayout = pRootSignature->mVulkan.pPipelineLayout;
@@ -5498,7 +6628,28 @@ void vk_cmdBindDescriptorSet(Cmd* pCmd, uint32_t index, DescriptorSet* pDescript
 					setIndex, 1, &pRootSignature->mVulkan.pEmptyDescriptorSet[setIndex], 0, NULL);
 			}
 		}
+
+		// The bindless heap stays bound until the pipeline layout changes
+		const BindlessHeap* pHeap = gBindlessHeap[pCmd->pRenderer->mUnlinkedRendererIndex];
+		if (pRootSignature->mVulkan.mBindless && pHeap)
+		{
+			vkCmdBindDescriptorSets(
+				pCmd->mVulkan.pVkCmdBuf, gPipelineBindPoint[pRootSignature->mPipelineType], pRootSignature->mVulkan.pPipelineLayout,
+				VK_BINDLESS_SET_INDEX, 1, &pHeap->pSet, 0, NULL);
+		}
 	}
+}
+
+void vk_cmdBindDescriptorSet(Cmd* pCmd, uint32_t index, DescriptorSet* pDescriptorSet)
+{
+	ASSERT(pCmd);
+	ASSERT(pDescriptorSet);
+	ASSERT(pDescriptorSet->mVulkan.pHandles);
+	ASSERT(index < pDescriptorSet->mVulkan.mMaxSets);
+
+	const RootSignature* pRootSignature = pDescriptorSet->mVulkan.pRootSignature;
+
+	bind_root_signature_sets(pCmd, pRootSignature);
 
 	static uint32_t offsets[VK_MAX_ROOT_DESCRIPTORS] = {};
 
@@ -5519,6 +6670,9 @@ void vk_cmdBindPushConstants(Cmd* pCmd, RootSignature* pRootSignature, uint32_t
 	ASSERT(pDesc);
 	ASSERT(DESCRIPTOR_TYPE_ROOT_CONSTANT == pDesc->mType);
 
+	// Shaders that only use push constants and the bindless heap never bind a descriptor set
+	bind_root_signature_sets(pCmd, pRootSignature);
+
 	vkCmdPushConstants(
 		pCmd->mVulkan.pVkCmdBuf, pRootSignature->mVulkan.pPipelineLayout, pDesc->mVulkan.mVkStages, 0, pDesc->mSize, pConstants);
 }
@@ -5585,6 +6739,8 @@ void vk_cmdBindDescriptorSetWithRootCbvs(Cmd* pCmd, uint32_t index, DescriptorSe
 		}
 	}
 
+	bind_root_signature_sets(pCmd, pRootSignature);
+
 	vkCmdBindDescriptorSets(
 		pCmd->mVulkan.pVkCmdBuf, gPipelineBindPoint[pRootSignature->mPipelineType], pRootSignature->mVulkan.pPipelineLayout,
 		pDescriptorSet->mVulkan.mUpdateFrequency, 1, &pDescriptorSet->mVulkan.pHandles[index],
@@ -5644,6 +6800,7 @@ void vk_addShaderBinary(Renderer* pRenderer, const BinaryShaderDesc* pDesc, Shad
 	pShaderProgram->mVulkan.pShaderModules = (VkShaderModule*)(pShaderProgram->pReflection + 1);
 	pShaderProgram->mVulkan.pEntryNames = (char**)(pShaderProgram->mVulkan.pShaderModules + counter);
 	pShaderProgram->mVulkan.pSpecializationInfo = NULL;
+	pShaderProgram->mVulkan.mId = tfrg_atomic32_add_relaxed(&gShaderIds, 1);
 
 	uint8_t* mem = (uint8_t*)(pShaderProgram->mVulkan.pEntryNames + counter);
 	counter = 0;
@@ -6004,6 +7161,7 @@ void vk_addRootSignature(Renderer* pRenderer, const RootSignatureDesc* pRootSign
 	}
 
 	pRootSignature->mPipelineType = pipelineType;
+	pRootSignature->mVulkan.mId = tfrg_atomic32_add_relaxed(&gRootSignatureIds, 1);
 	pRootSignature->pDescriptorNameToIndexMap->mMap = indexMap.mMap;
 
 	// Fill the descriptor array to be stored in the root signature
@@ -6021,6 +7179,20 @@ void vk_addRootSignature(Renderer* pRenderer, const RootSignatureDesc* pRootSign
 		pDesc->pName = pRes->name;
 		pDesc->mDim = pRes->dim;
 
+		// Resources of the bindless set live in the global heap, they are not part of the update frequency layouts
+		if (VK_BINDLESS_SET_INDEX == setIndex)
+		{
+			if (!gBindlessHeap[pRenderer->mUnlinkedRendererIndex])
+			{
+				LOGF(LogLevel::eERROR, "Descriptor (%s) : Shader uses UPDATE_FREQ_BINDLESS but the bindless heap is not enabled", pDesc->pName);
+				ASSERT(false);
+			}
+			pDesc->mUpdateFrequency = setIndex;
+			pDesc->mVulkan.mVkStages = util_to_vk_shader_stage_flags(pRes->used_stages);
+			pRootSignature->mVulkan.mBindless = true;
+			continue;
+		}
+
 		// If descriptor is not a root constant create a new layout binding for this descriptor and add it to the binding array
 		if (pDesc->mType != DESCRIPTOR_TYPE_ROOT_CONSTANT)
 		{
@@ -6145,6 +7317,8 @@ void vk_addRootSignature(Renderer* pRenderer, const RootSignatureDesc* pRootSign
 		{
 			createLayout = pRootSignature->mVulkan.mVkDescriptorSetLayouts[layoutIndex + 1] != VK_NULL_HANDLE;
 		}
+		// The bindless set comes after all update frequency sets so all of them need to exist
+		createLayout |= pRootSignature->mVulkan.mBindless && gBindlessHeap[pRenderer->mUnlinkedRendererIndex];
 
 		if (createLayout)
 		{
@@ -6239,7 +7413,7 @@ void vk_addRootSignature(Renderer* pRenderer, const RootSignatureDesc* pRootSign
 	/************************************************************************/
 	// Pipeline layout
 	/************************************************************************/
-	VkDescriptorSetLayout descriptorSetLayouts[kMaxLayoutCount] = {};
+	VkDescriptorSetLayout descriptorSetLayouts[kMaxLayoutCount + 1] = {};
 	uint32_t              descriptorSetLayoutCount = 0;
 	for (uint32_t i = 0; i < DESCRIPTOR_UPDATE_FREQ_COUNT; ++i)
 	{
@@ -6248,6 +7422,11 @@ void vk_addRootSignature(Renderer* pRenderer, const RootSignatureDesc* pRootSign
 			descriptorSetLayouts[descriptorSetLayoutCount++] = pRootSignature->mVulkan.mVkDescriptorSetLayouts[i];
 		}
 	}
+	if (pRootSignature->mVulkan.mBindless && gBindlessHeap[pRenderer->mUnlinkedRendererIndex])
+	{
+		ASSERT(VK_BINDLESS_SET_INDEX == descriptorSetLayoutCount);
+		descriptorSetLayouts[descriptorSetLayoutCount++] = gBindlessHeap[pRenderer->mUnlinkedRendererIndex]->pLayout;
+	}
 
 	DECLARE_ZERO(VkPipelineLayoutCreateInfo, add_info);
 	add_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
@@ -6729,16 +7908,28 @@ void vk_resetCmdPool(Renderer* pRenderer, CmdPool* pCmdPool)
 	CHECK_VKRESULT(vkResetCommandPool(pRenderer->mVulkan.pVkDevice, pCmdPool->pVkCmdPool, 0));
 }
 
-void vk_beginCmd(Cmd* pCmd)
+static void begin_cmd(Cmd* pCmd, VkRenderPass renderPass, VkFramebuffer framebuffer)
 {
 	ASSERT(pCmd);
 	ASSERT(VK_NULL_HANDLE != pCmd->mVulkan.pVkCmdBuf);
 
+	// Secondary command buffers always need inheritance info, render pass continuation only when recorded inside a render pass
+	DECLARE_ZERO(VkCommandBufferInheritanceInfo, inheritance_info);
+	inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritance_info.pNext = NULL;
+	inheritance_info.renderPass = renderPass;
+	inheritance_info.subpass = 0;
+	inheritance_info.framebuffer = framebuffer;
+
 	DECLARE_ZERO(VkCommandBufferBeginInfo, begin_info);
 	begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 	begin_info.pNext = NULL;
 	begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-	begin_info.pInheritanceInfo = NULL;
+	if (VK_NULL_HANDLE != renderPass)
+	{
+		begin_info.flags |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+	}
+	begin_info.pInheritanceInfo = pCmd->mVulkan.mSecondary ? &inheritance_info : NULL;
 
 	VkDeviceGroupCommandBufferBeginInfoKHR deviceGroupBeginInfo = { VK_STRUCTURE_TYPE_DEVICE_GROUP_COMMAND_BUFFER_BEGIN_INFO_KHR };
 	deviceGroupBeginInfo.pNext = NULL;
@@ -6752,6 +7943,26 @@ void vk_beginCmd(Cmd* pCmd)
 
 	// Reset CPU side data
 	pCmd->mVulkan.pBoundPipelineLayout = NULL;
+	pCmd->mVulkan.pPendingBarriers->mCount = 0;
+	// Secondary command buffers continue the inherited render pass, they never begin or end one
+	pCmd->mVulkan.pVkActiveRenderPass = renderPass;
+	pCmd->mVulkan.pVkActiveFramebuffer = framebuffer;
+	pCmd->mVulkan.mSecondaryContents = false;
+}
+
+void vk_beginCmd(Cmd* pCmd) { begin_cmd(pCmd, VK_NULL_HANDLE, VK_NULL_HANDLE); }
+
+void vk_beginSecondaryCmd(Cmd* pCmd, const Cmd* pPrimaryCmd)
+{
+	ASSERT(pCmd);
+	ASSERT(pPrimaryCmd);
+	ASSERT(pCmd->mVulkan.mSecondary && "vk_beginSecondaryCmd requires a Cmd allocated with CmdDesc::mSecondary");
+	ASSERT(!pPrimaryCmd->mVulkan.mSecondary);
+	ASSERT(
+		(VK_NULL_HANDLE == pPrimaryCmd->mVulkan.pVkActiveRenderPass || pPrimaryCmd->mVulkan.mSecondaryContents) &&
+		"Render targets of the primary Cmd must be bound with LoadActionsDesc::mExecuteSecondaryCmds");
+
+	begin_cmd(pCmd, pPrimaryCmd->mVulkan.pVkActiveRenderPass, pPrimaryCmd->mVulkan.pVkActiveFramebuffer);
 }
 
 void vk_endCmd(Cmd* pCmd)
@@ -6759,16 +7970,45 @@ void vk_endCmd(Cmd* pCmd)
 	ASSERT(pCmd);
 	ASSERT(VK_NULL_HANDLE != pCmd->mVulkan.pVkCmdBuf);
 
-	if (pCmd->mVulkan.pVkActiveRenderPass)
+	if (pCmd->mVulkan.pVkActiveRenderPass && !pCmd->mVulkan.mSecondary)
 	{
 		vkCmdEndRenderPass(pCmd->mVulkan.pVkCmdBuf);
 	}
 
 	pCmd->mVulkan.pVkActiveRenderPass = VK_NULL_HANDLE;
+	pCmd->mVulkan.pVkActiveFramebuffer = VK_NULL_HANDLE;
+	pCmd->mVulkan.mSecondaryContents = false;
+
+	flush_barriers(pCmd);
 
 	CHECK_VKRESULT(vkEndCommandBuffer(pCmd->mVulkan.pVkCmdBuf));
 }
 
+void vk_cmdExecuteCmds(Cmd* pCmd, uint32_t cmdCount, Cmd** ppCmds)
+{
+	ASSERT(pCmd);
+	ASSERT(VK_NULL_HANDLE != pCmd->mVulkan.pVkCmdBuf);
+	ASSERT(!pCmd->mVulkan.mSecondary);
+	ASSERT(
+		(VK_NULL_HANDLE == pCmd->mVulkan.pVkActiveRenderPass || pCmd->mVulkan.mSecondaryContents) &&
+		"Render targets must be bound with LoadActionsDesc::mExecuteSecondaryCmds to execute secondary Cmds inside a render pass");
+
+	if (!cmdCount)
+		return;
+
+	ASSERT(ppCmds);
+
+	VkCommandBuffer* cmds = (VkCommandBuffer*)alloca(cmdCount * sizeof(VkCommandBuffer));
+	for (uint32_t i = 0; i < cmdCount; ++i)
+	{
+		ASSERT(ppCmds[i]->mVulkan.mSecondary);
+		cmds[i] = ppCmds[i]->mVulkan.pVkCmdBuf;
+	}
+
+	flush_barriers(pCmd);
+	vkCmdExecuteCommands(pCmd->mVulkan.pVkCmdBuf, cmdCount, cmds);
+}
+
 void vk_cmdBindRenderTargets(
 	Cmd* pCmd, uint32_t renderTargetCount, RenderTarget** ppRenderTargets, RenderTarget* pDepthStencil,
 	const LoadActionsDesc* pLoadActions /* = NULL*/, uint32_t* pColorArraySlices, uint32_t* pColorMipSlices, uint32_t depthArraySlice,
@@ -6776,11 +8016,14 @@ void vk_cmdBindRenderTargets(
 {
 	ASSERT(pCmd);
 	ASSERT(VK_NULL_HANDLE != pCmd->mVulkan.pVkCmdBuf);
+	ASSERT(!pCmd->mVulkan.mSecondary && "Secondary Cmds inherit the render targets of their primary Cmd");
 
 	if (pCmd->mVulkan.pVkActiveRenderPass)
 	{
 		vkCmdEndRenderPass(pCmd->mVulkan.pVkCmdBuf);
 		pCmd->mVulkan.pVkActiveRenderPass = VK_NULL_HANDLE;
+		pCmd->mVulkan.pVkActiveFramebuffer = VK_NULL_HANDLE;
+		pCmd->mVulkan.mSecondaryContents = false;
 	}
 
 	if (!renderTargetCount && !pDepthStencil)
@@ -6845,19 +8088,17 @@ void vk_cmdBindRenderTargets(
 
 	SampleCount sampleCount = SAMPLE_COUNT_1;
 
-	RenderPassMap& renderPassMap = get_render_pass_map(pCmd->pRenderer->mUnlinkedRendererIndex);
-	FrameBufferMap& frameBufferMap = get_frame_buffer_map(pCmd->pRenderer->mUnlinkedRendererIndex);
-
-	const RenderPassMapIt  pNode = renderPassMap.find(renderPassHash);
-	const FrameBufferMapIt pFrameBufferNode = frameBufferMap.find(frameBufferHash);
+	RenderPassCache* pCache = gRenderPassCache[pCmd->pRenderer->mUnlinkedRendererIndex];
+	const uint64_t   renderPassKey = cache_key(renderPassHash);
+	const uint64_t   frameBufferKey = cache_key(frameBufferHash);
 
-	RenderPass* pRenderPass = NULL;
-	FrameBuffer* pFrameBuffer = NULL;
+	RenderPass*  pRenderPass = (RenderPass*)cache_find(&pCache->pRenderPassTable, renderPassKey);
+	FrameBuffer* pFrameBuffer = (FrameBuffer*)cache_find(&pCache->pFrameBufferTable, frameBufferKey);
 
 	// If a render pass of this combination already exists just use it or create a new one
-	if (pNode != renderPassMap.end())
+	if (pRenderPass)
 	{
-		pRenderPass = pNode->second;
+		tfrg_atomic64_add_relaxed(&pCache->mRenderPassHits, 1);
 	}
 	else
 	{
@@ -6894,35 +8135,59 @@ void vk_cmdBindRenderTargets(
 		renderPassDesc.mStoreActionStencil = stencilStoreAction;
 		renderPassDesc.mVRMultiview = vrMultiview;
 		renderPassDesc.mVRFoveatedRendering = vrFoveatedRendering;
-		add_render_pass(pCmd->pRenderer, &renderPassDesc, &pRenderPass);
 
-		// No need of a lock here since this map is per thread
-		renderPassMap.insert({ { renderPassHash, pRenderPass } });
+		MutexLock lock(pCache->mMutex);
+		// Another thread might have created it while we were waiting for the lock, only the thread which creates it counts a miss
+		pRenderPass = (RenderPass*)cache_find(&pCache->pRenderPassTable, renderPassKey);
+		if (!pRenderPass)
+		{
+			add_render_pass(pCmd->pRenderer, &renderPassDesc, &pRenderPass);
+			cache_insert(pCache, &pCache->pRenderPassTable, renderPassKey, pRenderPass);
+			tfrg_atomic64_add_relaxed(&pCache->mRenderPassMisses, 1);
+		}
+		else
+		{
+			tfrg_atomic64_add_relaxed(&pCache->mRenderPassHits, 1);
+		}
 	}
 
 	// If a frame buffer of this combination already exists just use it or create a new one
-	if (pFrameBufferNode != frameBufferMap.end())
+	if (pFrameBuffer)
 	{
-		pFrameBuffer = pFrameBufferNode->second;
+		tfrg_atomic64_add_relaxed(&pCache->mFrameBufferHits, 1);
 	}
 	else
 	{
-		FrameBufferDesc desc = { 0 };
-		desc.mRenderTargetCount = renderTargetCount;
-		desc.pDepthStencil = pDepthStencil;
-		desc.ppRenderTargets = ppRenderTargets;
-		desc.pRenderPass = pRenderPass;
-		desc.pColorArraySlices = pColorArraySlices;
-		desc.pColorMipSlices = pColorMipSlices;
-		desc.mDepthArraySlice = depthArraySlice;
-		desc.mDepthMipSlice = depthMipSlice;
-		desc.mVRFoveatedRendering = vrFoveatedRendering;
-		add_framebuffer(pCmd->pRenderer, &desc, &pFrameBuffer);
-
-		// No need of a lock here since this map is per thread
-		frameBufferMap.insert({ { frameBufferHash, pFrameBuffer } });
+		MutexLock lock(pCache->mMutex);
+		// Another thread might have created it while we were waiting for the lock, only the thread which creates it counts a miss
+		pFrameBuffer = (FrameBuffer*)cache_find(&pCache->pFrameBufferTable, frameBufferKey);
+		if (!pFrameBuffer)
+		{
+			FrameBufferDesc desc = { 0 };
+			desc.mRenderTargetCount = renderTargetCount;
+			desc.pDepthStencil = pDepthStencil;
+			desc.ppRenderTargets = ppRenderTargets;
+			desc.pRenderPass = pRenderPass;
+			desc.pColorArraySlices = pColorArraySlices;
+			desc.pColorMipSlices = pColorMipSlices;
+			desc.mDepthArraySlice = depthArraySlice;
+			desc.mDepthMipSlice = depthMipSlice;
+			desc.mVRFoveatedRendering = vrFoveatedRendering;
+			add_framebuffer(pCmd->pRenderer, &desc, &pFrameBuffer);
+			cache_insert(pCache, &pCache->pFrameBufferTable, frameBufferKey, pFrameBuffer);
+			tfrg_atomic64_add_relaxed(&pCache->mFrameBufferMisses, 1);
+		}
+		else
+		{
+			tfrg_atomic64_add_relaxed(&pCache->mFrameBufferHits, 1);
+		}
 	}
 
+	// Only write the shared cache line when the frame changed
+	const uint64_t frameIndex = tfrg_atomic64_load_relaxed(&pCache->mFrameIndex);
+	if (tfrg_atomic64_load_relaxed(&pFrameBuffer->mLastUsedFrame) != frameIndex)
+		tfrg_atomic64_store_relaxed(&pFrameBuffer->mLastUsedFrame, frameIndex);
+
 	DECLARE_ZERO(VkRect2D, render_area);
 	render_area.offset.x = 0;
 	render_area.offset.y = 0;
@@ -6954,8 +8219,14 @@ void vk_cmdBindRenderTargets(
 	begin_info.clearValueCount = clearValueCount;
 	begin_info.pClearValues = clearValues;
 
-	vkCmdBeginRenderPass(pCmd->mVulkan.pVkCmdBuf, &begin_info, VK_SUBPASS_CONTENTS_INLINE);
+	const bool secondaryContents = pLoadActions && pLoadActions->mExecuteSecondaryCmds;
+
+	flush_barriers(pCmd);
+	vkCmdBeginRenderPass(
+		pCmd->mVulkan.pVkCmdBuf, &begin_info, secondaryContents ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
 	pCmd->mVulkan.pVkActiveRenderPass = pRenderPass->pRenderPass;
+	pCmd->mVulkan.pVkActiveFramebuffer = pFrameBuffer->pFramebuffer;
+	pCmd->mVulkan.mSecondaryContents = secondaryContents;
 }
 
 void vk_cmdSetShadingRate(
@@ -7050,6 +8321,7 @@ void vk_cmdDraw(Cmd* pCmd, uint32_t vertex_count, uint32_t first_vertex)
 	ASSERT(pCmd);
 	ASSERT(VK_NULL_HANDLE != pCmd->mVulkan.pVkCmdBuf);
 
+	flush_barriers(pCmd);
 	vkCmdDraw(pCmd->mVulkan.pVkCmdBuf, vertex_count, 1, first_vertex, 0);
 }
 
@@ -7058,6 +8330,7 @@ void vk_cmdDrawInstanced(Cmd* pCmd, uint32_t vertexCount, uint32_t firstVertex,
 	ASSERT(pCmd);
 	ASSERT(VK_NULL_HANDLE != pCmd->mVulkan.pVkCmdBuf);
 
+	flush_barriers(pCmd);
 	vkCmdDraw(pCmd->mVulkan.pVkCmdBuf, vertexCount, instanceCount, firstVertex, firstInstance);
 }
 
@@ -7066,6 +8339,7 @@ void vk_cmdDrawIndexed(Cmd* pCmd, uint32_t index_count, uint32_t first_index, ui
 	ASSERT(pCmd);
 	ASSERT(VK_NULL_HANDLE != pCmd->mVulkan.pVkCmdBuf);
 
+	flush_barriers(pCmd);
 	vkCmdDrawIndexed(pCmd->mVulkan.pVkCmdBuf, index_count, 1, first_index, first_vertex, 0);
 }
 
@@ -7075,6 +8349,7 @@ void vk_cmdDrawIndexedInstanced(
 	ASSERT(pCmd);
 	ASSERT(VK_NULL_HANDLE != pCmd->mVulkan.pVkCmdBuf);
 
+	flush_barriers(pCmd);
 	vkCmdDrawIndexed(pCmd->mVulkan.pVkCmdBuf, indexCount, instanceCount, firstIndex, firstVertex, firstInstance);
 }
 
@@ -7083,6 +8358,7 @@ void vk_cmdDispatch(Cmd* pCmd, uint32_t groupCountX, uint32_t groupCountY, uint3
 	ASSERT(pCmd);
 	ASSERT(pCmd->mVulkan.pVkCmdBuf != VK_NULL_HANDLE);
 
+	flush_barriers(pCmd);
 	vkCmdDispatch(pCmd->mVulkan.pVkCmdBuf, groupCountX, groupCountY, groupCountZ);
 }
 
@@ -7090,202 +8366,84 @@ void vk_cmdResourceBarrier(
 	Cmd* pCmd, uint32_t numBufferBarriers, BufferBarrier* pBufferBarriers, uint32_t numTextureBarriers, TextureBarrier* pTextureBarriers,
 	uint32_t numRtBarriers, RenderTargetBarrier* pRtBarriers)
 {
-	VkImageMemoryBarrier* imageBarriers =
-		(numTextureBarriers + numRtBarriers)
-		? (VkImageMemoryBarrier*)alloca((numTextureBarriers + numRtBarriers) * sizeof(VkImageMemoryBarrier))
-		: NULL;
-	uint32_t imageBarrierCount = 0;
-
-	VkBufferMemoryBarrier* bufferBarriers =
-		numBufferBarriers ? (VkBufferMemoryBarrier*)alloca(numBufferBarriers * sizeof(VkBufferMemoryBarrier)) : NULL;
-	uint32_t bufferBarrierCount = 0;
-
-	VkAccessFlags srcAccessFlags = 0;
-	VkAccessFlags dstAccessFlags = 0;
+	ASSERT(pCmd);
+	ASSERT(pCmd->mVulkan.pPendingBarriers);
 
+	// Transitions are only queued here, flush_barriers records them before the next command which depends on them
 	for (uint32_t i = 0; i < numBufferBarriers; ++i)
 	{
-		BufferBarrier* pTrans = &pBufferBarriers[i];
-		Buffer* pBuffer = pTrans->pBuffer;
-		VkBufferMemoryBarrier* pBufferBarrier = NULL;
-
-		if (RESOURCE_STATE_UNORDERED_ACCESS == pTrans->mCurrentState && RESOURCE_STATE_UNORDERED_ACCESS == pTrans->mNewState)
-		{
-			pBufferBarrier = &bufferBarriers[bufferBarrierCount++];             //-V522
-			pBufferBarrier->sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;    //-V522
-			pBufferBarrier->pNext = NULL;
-
-			pBufferBarrier->srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-			pBufferBarrier->dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
-		}
-		else
-		{
-			pBufferBarrier = &bufferBarriers[bufferBarrierCount++];
-			pBufferBarrier->sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-			pBufferBarrier->pNext = NULL;
-
-			pBufferBarrier->srcAccessMask = util_to_vk_access_flags(pTrans->mCurrentState);
-			pBufferBarrier->dstAccessMask = util_to_vk_access_flags(pTrans->mNewState);
-		}
-
-		if (pBufferBarrier)
-		{
-			pBufferBarrier->buffer = pBuffer->mVulkan.pVkBuffer;
-			pBufferBarrier->size = VK_WHOLE_SIZE;
-			pBufferBarrier->offset = 0;
-
-			if (pTrans->mAcquire)
-			{
-				pBufferBarrier->srcQueueFamilyIndex = pCmd->pRenderer->mVulkan.mQueueFamilyIndices[pTrans->mQueueType];
-				pBufferBarrier->dstQueueFamilyIndex = pCmd->pQueue->mVulkan.mVkQueueFamilyIndex;
-			}
-			else if (pTrans->mRelease)
-			{
-				pBufferBarrier->srcQueueFamilyIndex = pCmd->pQueue->mVulkan.mVkQueueFamilyIndex;
-				pBufferBarrier->dstQueueFamilyIndex = pCmd->pRenderer->mVulkan.mQueueFamilyIndices[pTrans->mQueueType];
-			}
-			else
-			{
-				pBufferBarrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-				pBufferBarrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			}
-
-			srcAccessFlags |= pBufferBarrier->srcAccessMask;
-			dstAccessFlags |= pBufferBarrier->dstAccessMask;
-		}
+		const BufferBarrier* pTrans = &pBufferBarriers[i];
+		PendingBarrier       barrier = {};
+		barrier.pResource = pTrans->pBuffer;
+		barrier.mCurrentState = pTrans->mCurrentState;
+		barrier.mNewState = pTrans->mNewState;
+		barrier.mQueueType = pTrans->mQueueType;
+		barrier.mAcquire = pTrans->mAcquire;
+		barrier.mRelease = pTrans->mRelease;
+		queue_barrier(pCmd, &barrier);
 	}
 
 	for (uint32_t i = 0; i < numTextureBarriers; ++i)
 	{
-		TextureBarrier* pTrans = &pTextureBarriers[i];
-		Texture* pTexture = pTrans->pTexture;
-		VkImageMemoryBarrier* pImageBarrier = NULL;
-
-		if (RESOURCE_STATE_UNORDERED_ACCESS == pTrans->mCurrentState && RESOURCE_STATE_UNORDERED_ACCESS == pTrans->mNewState)
-		{
-			pImageBarrier = &imageBarriers[imageBarrierCount++];              //-V522
-			pImageBarrier->sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;    //-V522
-			pImageBarrier->pNext = NULL;
-
-			pImageBarrier->srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-			pImageBarrier->dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
-			pImageBarrier->oldLayout = VK_IMAGE_LAYOUT_GENERAL;
-			pImageBarrier->newLayout = VK_IMAGE_LAYOUT_GENERAL;
-		}
-		else
-		{
-			pImageBarrier = &imageBarriers[imageBarrierCount++];
-			pImageBarrier->sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-			pImageBarrier->pNext = NULL;
-
-			pImageBarrier->srcAccessMask = util_to_vk_access_flags(pTrans->mCurrentState);
-			pImageBarrier->dstAccessMask = util_to_vk_access_flags(pTrans->mNewState);
-			pImageBarrier->oldLayout = util_to_vk_image_layout(pTrans->mCurrentState);
-			pImageBarrier->newLayout = util_to_vk_image_layout(pTrans->mNewState);
-		}
-
-		if (pImageBarrier)
-		{
-			pImageBarrier->image = pTexture->mVulkan.pVkImage;
-			pImageBarrier->subresourceRange.aspectMask = (VkImageAspectFlags)pTexture->mAspectMask;
-			pImageBarrier->subresourceRange.baseMipLevel = pTrans->mSubresourceBarrier ? pTrans->mMipLevel : 0;
-			pImageBarrier->subresourceRange.levelCount = pTrans->mSubresourceBarrier ? 1 : VK_REMAINING_MIP_LEVELS;
-			pImageBarrier->subresourceRange.baseArrayLayer = pTrans->mSubresourceBarrier ? pTrans->mArrayLayer : 0;
-			pImageBarrier->subresourceRange.layerCount = pTrans->mSubresourceBarrier ? 1 : VK_REMAINING_ARRAY_LAYERS;
-
-			if (pTrans->mAcquire && pTrans->mCurrentState != RESOURCE_STATE_UNDEFINED)
-			{
-				pImageBarrier->srcQueueFamilyIndex = pCmd->pRenderer->mVulkan.mQueueFamilyIndices[pTrans->mQueueType];
-				pImageBarrier->dstQueueFamilyIndex = pCmd->pQueue->mVulkan.mVkQueueFamilyIndex;
-			}
-			else if (pTrans->mRelease && pTrans->mCurrentState != RESOURCE_STATE_UNDEFINED)
-			{
-				pImageBarrier->srcQueueFamilyIndex = pCmd->pQueue->mVulkan.mVkQueueFamilyIndex;
-				pImageBarrier->dstQueueFamilyIndex = pCmd->pRenderer->mVulkan.mQueueFamilyIndices[pTrans->mQueueType];
-			}
-			else
-			{
-				pImageBarrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-				pImageBarrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			}
-
-			srcAccessFlags |= pImageBarrier->srcAccessMask;
-			dstAccessFlags |= pImageBarrier->dstAccessMask;
-		}
+		const TextureBarrier* pTrans = &pTextureBarriers[i];
+		PendingBarrier        barrier = {};
+		barrier.pResource = pTrans->pTexture;
+		barrier.mCurrentState = pTrans->mCurrentState;
+		barrier.mNewState = pTrans->mNewState;
+		barrier.mArrayLayer = pTrans->mArrayLayer;
+		barrier.mMipLevel = pTrans->mMipLevel;
+		barrier.mQueueType = pTrans->mQueueType;
+		barrier.mTexture = true;
+		barrier.mSubresourceBarrier = pTrans->mSubresourceBarrier;
+		barrier.mAcquire = pTrans->mAcquire;
+		barrier.mRelease = pTrans->mRelease;
+		queue_barrier(pCmd, &barrier);
 	}
 
 	for (uint32_t i = 0; i < numRtBarriers; ++i)
 	{
-		RenderTargetBarrier* pTrans = &pRtBarriers[i];
-		Texture* pTexture = pTrans->pRenderTarget->pTexture;
-		VkImageMemoryBarrier* pImageBarrier = NULL;
-
-		if (RESOURCE_STATE_UNORDERED_ACCESS == pTrans->mCurrentState && RESOURCE_STATE_UNORDERED_ACCESS == pTrans->mNewState)
-		{
-			pImageBarrier = &imageBarriers[imageBarrierCount++];
-			pImageBarrier->sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-			pImageBarrier->pNext = NULL;
-
-			pImageBarrier->srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-			pImageBarrier->dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
-			pImageBarrier->oldLayout = VK_IMAGE_LAYOUT_GENERAL;
-			pImageBarrier->newLayout = VK_IMAGE_LAYOUT_GENERAL;
-		}
-		else
-		{
-			pImageBarrier = &imageBarriers[imageBarrierCount++];
-			pImageBarrier->sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-			pImageBarrier->pNext = NULL;
-
-			pImageBarrier->srcAccessMask = util_to_vk_access_flags(pTrans->mCurrentState);
-			pImageBarrier->dstAccessMask = util_to_vk_access_flags(pTrans->mNewState);
-			pImageBarrier->oldLayout = util_to_vk_image_layout(pTrans->mCurrentState);
-			pImageBarrier->newLayout = util_to_vk_image_layout(pTrans->mNewState);
-		}
-
-		if (pImageBarrier)
-		{
-			pImageBarrier->image = pTexture->mVulkan.pVkImage;
-			pImageBarrier->subresourceRange.aspectMask = (VkImageAspectFlags)pTexture->mAspectMask;
-			pImageBarrier->subresourceRange.baseMipLevel = pTrans->mSubresourceBarrier ? pTrans->mMipLevel : 0;
-			pImageBarrier->subresourceRange.levelCount = pTrans->mSubresourceBarrier ? 1 : VK_REMAINING_MIP_LEVELS;
-			pImageBarrier->subresourceRange.baseArrayLayer = pTrans->mSubresourceBarrier ? pTrans->mArrayLayer : 0;
-			pImageBarrier->subresourceRange.layerCount = pTrans->mSubresourceBarrier ? 1 : VK_REMAINING_ARRAY_LAYERS;
-
-			if (pTrans->mAcquire && pTrans->mCurrentState != RESOURCE_STATE_UNDEFINED)
-			{
-				pImageBarrier->srcQueueFamilyIndex = pCmd->pRenderer->mVulkan.mQueueFamilyIndices[pTrans->mQueueType];
-				pImageBarrier->dstQueueFamilyIndex = pCmd->pQueue->mVulkan.mVkQueueFamilyIndex;
-			}
-			else if (pTrans->mRelease && pTrans->mCurrentState != RESOURCE_STATE_UNDEFINED)
-			{
-				pImageBarrier->srcQueueFamilyIndex = pCmd->pQueue->mVulkan.mVkQueueFamilyIndex;
-				pImageBarrier->dstQueueFamilyIndex = pCmd->pRenderer->mVulkan.mQueueFamilyIndices[pTrans->mQueueType];
-			}
-			else
-			{
-				pImageBarrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-				pImageBarrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			}
-
-			srcAccessFlags |= pImageBarrier->srcAccessMask;
-			dstAccessFlags |= pImageBarrier->dstAccessMask;
-		}
+		const RenderTargetBarrier* pTrans = &pRtBarriers[i];
+		PendingBarrier             barrier = {};
+		barrier.pResource = pTrans->pRenderTarget->pTexture;
+		barrier.mCurrentState = pTrans->mCurrentState;
+		barrier.mNewState = pTrans->mNewState;
+		barrier.mArrayLayer = pTrans->mArrayLayer;
+		barrier.mMipLevel = pTrans->mMipLevel;
+		barrier.mQueueType = pTrans->mQueueType;
+		barrier.mTexture = true;
+		barrier.mSubresourceBarrier = pTrans->mSubresourceBarrier;
+		barrier.mAcquire = pTrans->mAcquire;
+		barrier.mRelease = pTrans->mRelease;
+		queue_barrier(pCmd, &barrier);
 	}
+}
 
-	VkPipelineStageFlags srcStageMask =
-		util_determine_pipeline_stage_flags(pCmd->pRenderer, srcAccessFlags, (QueueType)pCmd->mVulkan.mType);
-	VkPipelineStageFlags dstStageMask =
-		util_determine_pipeline_stage_flags(pCmd->pRenderer, dstAccessFlags, (QueueType)pCmd->mVulkan.mType);
+void vk_cmdAliasingBarrier(Cmd* pCmd, uint32_t barrierCount, const AliasingBarrier* pBarriers)
+{
+	ASSERT(pCmd);
+	ASSERT(pCmd->mVulkan.pPendingBarriers);
 
-	if (bufferBarrierCount || imageBarrierCount)
+	for (uint32_t i = 0; i < barrierCount; ++i)
 	{
-		vkCmdPipelineBarrier(
-			pCmd->mVulkan.pVkCmdBuf, srcStageMask, dstStageMask, 0, 0, NULL, bufferBarrierCount, bufferBarriers, imageBarrierCount,
-			imageBarriers);
+		const AliasingBarrier* pAlias = &pBarriers[i];
+		ASSERT(pAlias->pAfter);
+		// The new user starts from undefined contents, the previous user only contributes its accesses to the dependency
+		PendingBarrier barrier = {};
+		barrier.pResource = pAlias->pAfter->pTexture;
+		barrier.mCurrentState = RESOURCE_STATE_UNDEFINED;
+		barrier.mNewState = pAlias->mAfterState;
+		barrier.mAliasedState = pAlias->pBefore ? pAlias->mBeforeState : RESOURCE_STATE_UNDEFINED;
+		barrier.mTexture = true;
+		queue_barrier(pCmd, &barrier);
 	}
 }
 
+void vk_cmdFlushBarriers(Cmd* pCmd)
+{
+	ASSERT(pCmd);
+	flush_barriers(pCmd);
+}
+
 void vk_cmdUpdateBuffer(Cmd* pCmd, Buffer* pBuffer, uint64_t dstOffset, Buffer* pSrcBuffer, uint64_t srcOffset, uint64_t size)
 {
 	ASSERT(pCmd);
@@ -7300,11 +8458,14 @@ void vk_cmdUpdateBuffer(Cmd* pCmd, Buffer* pBuffer, uint64_t dstOffset, Buffer*
 	region.srcOffset = srcOffset;
 	region.dstOffset = dstOffset;
 	region.size = (VkDeviceSize)size;
+	flush_barriers(pCmd);
 	vkCmdCopyBuffer(pCmd->mVulkan.pVkCmdBuf, pSrcBuffer->mVulkan.pVkBuffer, pBuffer->mVulkan.pVkBuffer, 1, &region);
 }
 
 void vk_cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pSrcBuffer, const SubresourceDataDesc* pSubresourceDesc)
 {
+	flush_barriers(pCmd);
+
 	const TinyImageFormat fmt = (TinyImageFormat)pTexture->mFormat;
 	const bool            isSinglePlane = TinyImageFormat_IsSinglePlane(fmt);
 
@@ -7316,6 +8477,10 @@ void vk_cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pSrcBuffer, c
 		const uint32_t numBlocksWide = pSubresourceDesc->mRowPitch / (TinyImageFormat_BitSizeOfBlock(fmt) >> 3);
 		const uint32_t numBlocksHigh = (pSubresourceDesc->mSlicePitch / pSubresourceDesc->mRowPitch);
 
+		const uint32_t rowOffset = pSubresourceDesc->mRowOffset * TinyImageFormat_HeightOfBlock(fmt);
+		const uint32_t depthOffset = pSubresourceDesc->mDepthOffset;
+		ASSERT(rowOffset < height && depthOffset < depth);
+
 		VkBufferImageCopy copy = {};
 		copy.bufferOffset = pSubresourceDesc->mSrcOffset;
 		copy.bufferRowLength = numBlocksWide * TinyImageFormat_WidthOfBlock(fmt);
@@ -7325,11 +8490,13 @@ void vk_cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pSrcBuffer, c
 		copy.imageSubresource.baseArrayLayer = pSubresourceDesc->mArrayLayer;
 		copy.imageSubresource.layerCount = 1;
 		copy.imageOffset.x = 0;
-		copy.imageOffset.y = 0;
-		copy.imageOffset.z = 0;
+		copy.imageOffset.y = (int32_t)rowOffset;
+		copy.imageOffset.z = (int32_t)depthOffset;
 		copy.imageExtent.width = width;
-		copy.imageExtent.height = height;
-		copy.imageExtent.depth = depth;
+		copy.imageExtent.height = pSubresourceDesc->mRowCount
+			? min(height - rowOffset, pSubresourceDesc->mRowCount * TinyImageFormat_HeightOfBlock(fmt))
+			: height - rowOffset;
+		copy.imageExtent.depth = pSubresourceDesc->mDepthCount ? pSubresourceDesc->mDepthCount : depth - depthOffset;
 
 		vkCmdCopyBufferToImage(
 			pCmd->mVulkan.pVkCmdBuf, pSrcBuffer->mVulkan.pVkBuffer, pTexture->mVulkan.pVkImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
@@ -7372,6 +8539,8 @@ void vk_cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pSrcBuffer, c
 
 void vk_cmdCopySubresource(Cmd* pCmd, Buffer* pDstBuffer, Texture* pTexture, const SubresourceDataDesc* pSubresourceDesc)
 {
+	flush_barriers(pCmd);
+
 	const TinyImageFormat fmt = (TinyImageFormat)pTexture->mFormat;
 	const bool            isSinglePlane = TinyImageFormat_IsSinglePlane(fmt);
 
@@ -7445,6 +8614,9 @@ void vk_acquireNextImage(Renderer* pRenderer, SwapChain* pSwapChain, Semaphore*
 	ASSERT(VK_NULL_HANDLE != pRenderer->mVulkan.pVkDevice);
 	ASSERT(pSignalSemaphore || pFence);
 
+	// Frame boundary of the render pass / frame buffer cache
+	update_render_pass_cache(pRenderer);
+
 #if defined(QUEST_VR)
 	ASSERT(VK_NULL_HANDLE != pSwapChain->mVR.pSwapChain);
 	hook_acquire_next_image(pSwapChain, pImageIndex);
@@ -7471,6 +8643,7 @@ void vk_acquireNextImage(Renderer* pRenderer, SwapChain* pSwapChain, Semaphore*
 		}
 
 		pFence->mVulkan.mSubmitted = true;
+		++pFence->mVulkan.mSubmitCount;
 	}
 	else
 	{
@@ -7613,7 +8786,10 @@ void vk_queueSubmit(Queue* pQueue, const QueueSubmitDesc* pDesc)
 	CHECK_VKRESULT(vkQueueSubmit(pQueue->mVulkan.pVkQueue, 1, &submit_info, pFence ? pFence->mVulkan.pVkFence : VK_NULL_HANDLE));
 
 	if (pFence)
+	{
 		pFence->mVulkan.mSubmitted = true;
+		++pFence->mVulkan.mSubmitCount;
+	}
 }
 
 void vk_queuePresent(Queue* pQueue, const QueuePresentDesc* pDesc)
@@ -7748,6 +8924,21 @@ void vk_getFenceStatus(Renderer* pRenderer, Fence* pFence, FenceStatus* pFenceSt
 		*pFenceStatus = FENCE_STATUS_NOTSUBMITTED;
 	}
 }
+
+uint32_t vk_getFenceSubmitCount(const Fence* pFence) { return pFence->mVulkan.mSubmitCount; }
+
+bool vk_isFenceSubmitComplete(Renderer* pRenderer, const Fence* pFence, uint32_t submitCount)
+{
+	// Not submitted yet
+	if ((int32_t)(pFence->mVulkan.mSubmitCount - submitCount) < 0)
+		return false;
+
+	// A fence is only reset after it signaled, and it has to be reset before it can be submitted again
+	if (pFence->mVulkan.mSubmitCount != submitCount || !pFence->mVulkan.mSubmitted)
+		return true;
+
+	return VK_SUCCESS == vkGetFenceStatus(pRenderer->mVulkan.pVkDevice, pFence->mVulkan.pVkFence);
+}
 /************************************************************************/
 // Utility functions
 /************************************************************************/
@@ -7829,6 +9020,8 @@ void vk_cmdExecuteIndirect(
 	Cmd* pCmd, CommandSignature* pCommandSignature, uint maxCommandCount, Buffer* pIndirectBuffer, uint64_t bufferOffset,
 	Buffer* pCounterBuffer, uint64_t counterBufferOffset)
 {
+	flush_barriers(pCmd);
+
 	for (uint32_t i = 0; i < pCommandSignature->mIndirectArgumentCount; ++i)    // execute for all types;
 	{
 		IndirectArgument* pIndirectArgument = &pCommandSignature->pIndirectArguments[i];
@@ -7941,11 +9134,15 @@ void vk_removeQueryPool(Renderer* pRenderer, QueryPool* pQueryPool)
 
 void vk_cmdResetQueryPool(Cmd* pCmd, QueryPool* pQueryPool, uint32_t startQuery, uint32_t queryCount)
 {
+	// Keeps the reset ordered after the work of the previous frame which still reads the queries
+	flush_barriers(pCmd);
 	vkCmdResetQueryPool(pCmd->mVulkan.pVkCmdBuf, pQueryPool->mVulkan.pVkQueryPool, startQuery, queryCount);
 }
 
 void vk_cmdBeginQuery(Cmd* pCmd, QueryPool* pQueryPool, QueryDesc* pQuery)
 {
+	flush_barriers(pCmd);
+
 	VkQueryType type = pQueryPool->mVulkan.mType;
 	switch (type)
 	{
@@ -7961,6 +9158,9 @@ void vk_cmdBeginQuery(Cmd* pCmd, QueryPool* pQueryPool, QueryDesc* pQuery)
 
 void vk_cmdEndQuery(Cmd* pCmd, QueryPool* pQueryPool, QueryDesc* pQuery)
 {
+	// Transitions queued inside the measured range are recorded before the end timestamp
+	flush_barriers(pCmd);
+
 	VkQueryType type = pQueryPool->mVulkan.mType;
 	switch (type)
 	{
@@ -7977,6 +9177,7 @@ void vk_cmdEndQuery(Cmd* pCmd, QueryPool* pQueryPool, QueryDesc* pQuery)
 void vk_cmdResolveQuery(Cmd* pCmd, QueryPool* pQueryPool, Buffer* pReadbackBuffer, uint32_t startQuery, uint32_t queryCount)
 {
 	VkQueryResultFlags flags = VK_QUERY_RESULT_64_BIT;
+	flush_barriers(pCmd);
 	vkCmdCopyQueryPoolResults(
 		pCmd->mVulkan.pVkCmdBuf, pQueryPool->mVulkan.pVkQueryPool, startQuery, queryCount, pReadbackBuffer->mVulkan.pVkBuffer, 0,
 		sizeof(uint64_t), flags);
@@ -8001,6 +9202,32 @@ void vk_calculateMemoryUse(Renderer* pRenderer, uint64_t* usedBytes, uint64_t* t
 	*usedBytes = stats.total.statistics.allocationBytes;
 	*totalAllocatedBytes = stats.total.statistics.blockBytes;
 }
+
+void vk_getMemoryBudget(Renderer* pRenderer, MemoryBudget* pBudget)
+{
+	// VMA only queries VK_EXT_memory_budget again when the frame index changes
+	static tfrg_atomic32_t gBudgetFetchIndex = 0;
+	vmaSetCurrentFrameIndex(pRenderer->mVulkan.pVmaAllocator, tfrg_atomic32_add_relaxed(&gBudgetFetchIndex, 1) + 1);
+
+	VmaBudget budgets[VK_MAX_MEMORY_HEAPS] = {};
+	vmaGetHeapBudgets(pRenderer->mVulkan.pVmaAllocator, budgets);
+
+	const VkPhysicalDeviceMemoryProperties* pMemoryProperties = NULL;
+	vmaGetMemoryProperties(pRenderer->mVulkan.pVmaAllocator, &pMemoryProperties);
+
+	*pBudget = {};
+	for (uint32_t heap = 0; heap < pMemoryProperties->memoryHeapCount; ++heap)
+	{
+		if (!(pMemoryProperties->memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT))
+		{
+			continue;
+		}
+		pBudget->mBudget += budgets[heap].budget;
+		pBudget->mUsage += budgets[heap].usage;
+		pBudget->mBlockBytes += budgets[heap].statistics.blockBytes;
+		pBudget->mAllocationBytes += budgets[heap].statistics.allocationBytes;
+	}
+}
 /************************************************************************/
 // Debug Marker Implementation
 /************************************************************************/
@@ -8431,6 +9658,7 @@ void vk_uploadVirtualTexturePage(Cmd* pCmd, Texture* pTexture, VirtualTexturePag
 		region.imageOffset.z = 0;
 		region.imageExtent = { (uint32_t)pTexture->pSvt->mSparseVirtualTexturePageWidth, (uint32_t)pTexture->pSvt->mSparseVirtualTexturePageHeight, 1 };
 
+		flush_barriers(pCmd);
 		vkCmdCopyBufferToImage(
 			pCmd->mVulkan.pVkCmdBuf,
 			pIntermediateBuffer->mVulkan.pVkBuffer,
@@ -8505,6 +9733,7 @@ void vk_addVirtualTexture(Cmd* pCmd, const TextureDesc* pDesc, Texture** ppTextu
 	Renderer* pRenderer = pCmd->pRenderer;
 
 	pTexture->pSvt = (VirtualTexture*)(pTexture + 1);
+	pTexture->mBindlessIndex = BINDLESS_INVALID_INDEX;
 
 	uint32_t imageSize = 0;
 	uint32_t mipSize = pDesc->mWidth * pDesc->mHeight * pDesc->mDepth;
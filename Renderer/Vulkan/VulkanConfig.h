@@ -42,6 +42,9 @@
 // Uncomment this to enable render doc capture support
 //#define ENABLE_RENDER_DOC
 
+// NULL_RENDERER is defined by the Null build configuration. The Vulkan front end then runs on the driver stub in Renderer/Null
+// and no GPU work is executed, used to measure the CPU overhead of the renderer and the app in isolation.
+
 // Debug Utils Extension not present on many Android devices
 #if !defined(__ANDROID__)
 #define ENABLE_DEBUG_UTILS_EXTENSION
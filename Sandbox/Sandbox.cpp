@@ -15,6 +15,7 @@
 
 #include "../Renderer/Include/IRenderer.h"
 #include "../Renderer/Include/IResourceLoader.h"
+#include "../Renderer/Include/IRenderGraph.h"
 
 #include "../OS/Math/MathTypes.h"
 
@@ -61,6 +62,8 @@ Cmd* pCmds[gImageCount] = { NULL };
 
 SwapChain* pSwapChain = NULL;
 RenderTarget* pDepthBuffer = NULL;
+RenderGraph* pRenderGraph = NULL;
+RenderGraphResource gSwapChainResource = RENDER_GRAPH_INVALID_RESOURCE;
 Fence* pRenderCompleteFences[gImageCount] = { NULL };
 Semaphore* pImageAcquiredSemaphore = NULL;
 Semaphore* pRenderCompleteSemaphores[gImageCount] = { NULL };
@@ -167,6 +170,73 @@ const char* gWindowTestScripts[] =
 	"TestHideWindow.lua"
 };
 
+void drawScenePass(Cmd* cmd, const RenderGraph* pGraph, void* pUserData)
+{
+	const uint32_t sphereVbStride = sizeof(float) * 6;
+	const uint32_t skyboxVbStride = sizeof(float) * 4;
+
+	// draw skybox
+	cmdBeginGpuTimestampQuery(cmd, gGpuProfileToken, "Draw Skybox");
+	vk_cmdSetViewport(cmd, 0.0f, 0.0f, (float)pDepthBuffer->mWidth, (float)pDepthBuffer->mHeight, 1.0f, 1.0f);
+	vk_cmdBindPipeline(cmd, pSkyBoxDrawPipeline);
+	vk_cmdBindDescriptorSet(cmd, 0, pDescriptorSetTexture);
+	vk_cmdBindDescriptorSet(cmd, gFrameIndex * 2 + 0, pDescriptorSetUniforms);
+	vk_cmdBindVertexBuffer(cmd, 1, &pSkyBoxVertexBuffer, &skyboxVbStride, NULL);
+	vk_cmdDraw(cmd, 36, 0);
+	vk_cmdSetViewport(cmd, 0.0f, 0.0f, (float)pDepthBuffer->mWidth, (float)pDepthBuffer->mHeight, 0.0f, 1.0f);
+	cmdEndGpuTimestampQuery(cmd, gGpuProfileToken);
+
+	////// draw planets
+	cmdBeginGpuTimestampQuery(cmd, gGpuProfileToken, "Draw Planets");
+
+	Pipeline* pipeline = pSpherePipeline;
+
+	// Using the malfunctioned pipeline
+	if (pRenderer->pActiveGpuSettings->mGpuBreadcrumbs && bSimulateCrash)
+	{
+		gCrashedFrame = gFrameIndex;
+		bSimulateCrash = false;
+		bHasCrashed = true;
+		pipeline = pCrashPipeline;
+		LOGF(LogLevel::eERROR, "[Breadcrumb] Simulating a GPU crash situation...");
+	}
+
+	vk_cmdBindPipeline(cmd, pipeline);
+	vk_cmdBindDescriptorSet(cmd, gFrameIndex * 2 + 1, pDescriptorSetUniforms);
+	vk_cmdBindVertexBuffer(cmd, 1, &pSphereVertexBuffer, &sphereVbStride, NULL);
+
+	if (pRenderer->pActiveGpuSettings->mGpuBreadcrumbs)
+	{
+		// Marker on top of the pip, won't wait for the following draw commands.
+		vk_cmdWriteMarker(cmd, MARKER_TYPE_IN, gValidMarkerValue, pMarkerBuffer[gFrameIndex], 0, false);
+	}
+
+	vk_cmdDrawInstanced(cmd, gNumberOfSpherePoints / 6, 0, gNumPlanets, 0);
+
+	if (pRenderer->pActiveGpuSettings->mGpuBreadcrumbs)
+	{
+		// Marker on bottom of the pip, will wait for draw command to be executed.
+		vk_cmdWriteMarker(cmd, MARKER_TYPE_OUT, gValidMarkerValue, pMarkerBuffer[gFrameIndex], 1, false);
+	}
+
+	cmdEndGpuTimestampQuery(cmd, gGpuProfileToken);
+}
+
+void drawUserInterfacePass(Cmd* cmd, const RenderGraph* pGraph, void* pUserData)
+{
+	cmdBeginGpuTimestampQuery(cmd, gGpuProfileToken, "Draw UI");
+
+	gFrameTimeDraw.mFontColor = 0xff00ffff;
+	gFrameTimeDraw.mFontSize = 18.0f;
+	gFrameTimeDraw.mFontID = gFontID;
+	float2 txtSizePx = cmdDrawCpuProfile(cmd, float2(8.f, 15.f), &gFrameTimeDraw);
+	cmdDrawGpuProfile(cmd, float2(8.f, txtSizePx.y + 75.f), gGpuProfileToken, &gFrameTimeDraw);
+
+	cmdDrawUserInterface(cmd);
+
+	cmdEndGpuTimestampQuery(cmd, gGpuProfileToken);
+}
+
 class App :public IApp
 {
 public:
@@ -601,7 +671,7 @@ public:
 		if (!addSwapChain())
 			return false;
 
-		if (!addDepthBuffer())
+		if (!addRenderGraph())
 			return false;
 
 		RenderTarget* ppPipelineRenderTargets[] =
@@ -641,6 +711,8 @@ public:
 		depthStateDesc.mDepthWrite = true;
 		depthStateDesc.mDepthFunc = CMP_GEQUAL;
 
+		SyncToken pipelineToken = {};
+
 		PipelineDesc desc = {};
 		desc.mType = PIPELINE_TYPE_GRAPHICS;
 		GraphicsPipelineDesc& pipelineSettings = desc.mGraphicsDesc;
@@ -656,12 +728,12 @@ public:
 		pipelineSettings.pVertexLayout = &vertexLayout;
 		pipelineSettings.pRasterizerState = &sphereRasterizerStateDesc;
 		pipelineSettings.mVRFoveatedRendering = true;
-		vk_addPipeline(pRenderer, &desc, &pSpherePipeline);
+		addPipeline(pRenderer, &desc, &pSpherePipeline, &pipelineToken);
 
 		if (pRenderer->pActiveGpuSettings->mGpuBreadcrumbs)
 		{
 			pipelineSettings.pShaderProgram = pCrashShader;
-			vk_addPipeline(pRenderer, &desc, &pCrashPipeline);
+			addPipeline(pRenderer, &desc, &pCrashPipeline, &pipelineToken);
 		}
 
 		//layout and pipeline for skybox draw
@@ -676,7 +748,10 @@ public:
 		pipelineSettings.pDepthState = NULL;
 		pipelineSettings.pRasterizerState = &rasterizerStateDesc;
 		pipelineSettings.pShaderProgram = pSkyBoxDrawShader; //-V519
-		vk_addPipeline(pRenderer, &desc, &pSkyBoxDrawPipeline);
+		addPipeline(pRenderer, &desc, &pSkyBoxDrawPipeline, &pipelineToken);
+
+		// Pipelines compile on the loader threads
+		waitForToken(&pipelineToken);
 
 		return true;
 	}
@@ -689,15 +764,17 @@ public:
 
 		removeFontSystemPipelines();
 
-		vk_removePipeline(pRenderer, pSkyBoxDrawPipeline);
-		vk_removePipeline(pRenderer, pSpherePipeline);
+		removePipeline(pRenderer, pSkyBoxDrawPipeline);
+		removePipeline(pRenderer, pSpherePipeline);
 
 		if (pRenderer->pActiveGpuSettings->mGpuBreadcrumbs)
 		{
-			vk_removePipeline(pRenderer, pCrashPipeline);
+			removePipeline(pRenderer, pCrashPipeline);
 		}
 		vk_removeSwapChain(pRenderer, pSwapChain);
-		vk_removeRenderTarget(pRenderer, pDepthBuffer);
+		removeRenderGraph(pRenderGraph);
+		pRenderGraph = NULL;
+		pDepthBuffer = NULL;
 	}
 
 	void Update(float deltaTime)
@@ -804,88 +881,9 @@ public:
 
 		cmdBeginGpuFrameProfile(cmd, gGpuProfileToken);
 
-		RenderTargetBarrier barriers[] = {
-			{ pRenderTarget, RESOURCE_STATE_PRESENT, RESOURCE_STATE_RENDER_TARGET },
-		};
-		vk_cmdResourceBarrier(cmd, 0, NULL, 0, NULL, 1, barriers);
-
-		// simply record the screen cleaning command
-		LoadActionsDesc loadActions = {};
-		loadActions.mLoadActionsColor[0] = LOAD_ACTION_CLEAR;
-		loadActions.mLoadActionDepth = LOAD_ACTION_CLEAR;
-		loadActions.mClearDepth.depth = 0.0f;
-		loadActions.mClearDepth.stencil = 0;
-		vk_cmdBindRenderTargets(cmd, 1, &pRenderTarget, pDepthBuffer, &loadActions, NULL, NULL, -1, -1);
-		vk_cmdSetViewport(cmd, 0.0f, 0.0f, (float)pRenderTarget->mWidth, (float)pRenderTarget->mHeight, 0.0f, 1.0f);
-		vk_cmdSetScissor(cmd, 0, 0, pRenderTarget->mWidth, pRenderTarget->mHeight);
-
-		const uint32_t sphereVbStride = sizeof(float) * 6;
-		const uint32_t skyboxVbStride = sizeof(float) * 4;
-
-		// draw skybox
-		cmdBeginGpuTimestampQuery(cmd, gGpuProfileToken, "Draw Skybox");
-		vk_cmdSetViewport(cmd, 0.0f, 0.0f, (float)pRenderTarget->mWidth, (float)pRenderTarget->mHeight, 1.0f, 1.0f);
-		vk_cmdBindPipeline(cmd, pSkyBoxDrawPipeline);
-		vk_cmdBindDescriptorSet(cmd, 0, pDescriptorSetTexture);
-		vk_cmdBindDescriptorSet(cmd, gFrameIndex * 2 + 0, pDescriptorSetUniforms);
-		vk_cmdBindVertexBuffer(cmd, 1, &pSkyBoxVertexBuffer, &skyboxVbStride, NULL);
-		vk_cmdDraw(cmd, 36, 0);
-		vk_cmdSetViewport(cmd, 0.0f, 0.0f, (float)pRenderTarget->mWidth, (float)pRenderTarget->mHeight, 0.0f, 1.0f);
-		cmdEndGpuTimestampQuery(cmd, gGpuProfileToken);
-
-		////// draw planets
-		cmdBeginGpuTimestampQuery(cmd, gGpuProfileToken, "Draw Planets");
-
-		Pipeline* pipeline = pSpherePipeline;
-
-		// Using the malfunctioned pipeline
-		if (pRenderer->pActiveGpuSettings->mGpuBreadcrumbs && bSimulateCrash)
-		{
-			gCrashedFrame = gFrameIndex;
-			bSimulateCrash = false;
-			bHasCrashed = true;
-			pipeline = pCrashPipeline;
-			LOGF(LogLevel::eERROR, "[Breadcrumb] Simulating a GPU crash situation...");
-		}
-
-		vk_cmdBindPipeline(cmd, pipeline);
-		vk_cmdBindDescriptorSet(cmd, gFrameIndex * 2 + 1, pDescriptorSetUniforms);
-		vk_cmdBindVertexBuffer(cmd, 1, &pSphereVertexBuffer, &sphereVbStride, NULL);
-
-		if (pRenderer->pActiveGpuSettings->mGpuBreadcrumbs)
-		{
-			// Marker on top of the pip, won't wait for the following draw commands.
-			vk_cmdWriteMarker(cmd, MARKER_TYPE_IN, gValidMarkerValue, pMarkerBuffer[gFrameIndex], 0, false);
-		}
-
-		vk_cmdDrawInstanced(cmd, gNumberOfSpherePoints / 6, 0, gNumPlanets, 0);
-
-		if (pRenderer->pActiveGpuSettings->mGpuBreadcrumbs)
-		{
-			// Marker on bottom of the pip, will wait for draw command to be executed.
-			vk_cmdWriteMarker(cmd, MARKER_TYPE_OUT, gValidMarkerValue, pMarkerBuffer[gFrameIndex], 1, false);
-		}
-
-		cmdEndGpuTimestampQuery(cmd, gGpuProfileToken);
-
-		loadActions = {};
-		loadActions.mLoadActionsColor[0] = LOAD_ACTION_LOAD;
-		vk_cmdBindRenderTargets(cmd, 1, &pRenderTarget, NULL, &loadActions, NULL, NULL, -1, -1);
-		cmdBeginGpuTimestampQuery(cmd, gGpuProfileToken, "Draw UI");
-
-		gFrameTimeDraw.mFontColor = 0xff00ffff;
-		gFrameTimeDraw.mFontSize = 18.0f;
-		gFrameTimeDraw.mFontID = gFontID;
-		float2 txtSizePx = cmdDrawCpuProfile(cmd, float2(8.f, 15.f), &gFrameTimeDraw);
-		cmdDrawGpuProfile(cmd, float2(8.f, txtSizePx.y + 75.f), gGpuProfileToken, &gFrameTimeDraw);
-
-		cmdDrawUserInterface(cmd);
-
-		vk_cmdBindRenderTargets(cmd, 0, NULL, NULL, NULL, NULL, NULL, -1, -1);
-		cmdEndGpuTimestampQuery(cmd, gGpuProfileToken);
-
-		barriers[0] = { pRenderTarget, RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_PRESENT };
-		vk_cmdResourceBarrier(cmd, 0, NULL, 0, NULL, 1, barriers);
+		// Swapchain transitions, load / store actions and the depth buffer are handled by the render graph
+		renderGraphSetImportedRenderTarget(pRenderGraph, gSwapChainResource, pRenderTarget);
+		executeRenderGraph(pRenderGraph, cmd);
 
 		cmdEndGpuFrameProfile(cmd, gGpuProfileToken);
 		vk_endCmd(cmd);
@@ -942,9 +940,9 @@ public:
 		return pSwapChain != NULL;
 	}
 
-	bool addDepthBuffer()
+	bool addRenderGraph()
 	{
-		// Add depth buffer
+		// Depth buffer is a transient of the render graph, the swapchain image is imported every frame
 		RenderTargetDesc depthRT = {};
 		depthRT.mArraySize = 1;
 		depthRT.mClearValue.depth = 0.0f;
@@ -957,7 +955,25 @@ public:
 		depthRT.mSampleQuality = 0;
 		depthRT.mWidth = mSettings.mWidth;
 		depthRT.mFlags = TEXTURE_CREATION_FLAG_ON_TILE | TEXTURE_CREATION_FLAG_VR_MULTIVIEW;
-		vk_addRenderTarget(pRenderer, &depthRT, &pDepthBuffer);
+
+		::addRenderGraph(pRenderer, NULL, &pRenderGraph);
+
+		gSwapChainResource = renderGraphImportRenderTarget(
+			pRenderGraph, "SwapChain", pSwapChain->ppRenderTargets[0], RESOURCE_STATE_PRESENT, RESOURCE_STATE_PRESENT);
+		RenderGraphResource depthResource = renderGraphAddRenderTarget(pRenderGraph, "DepthBuffer", &depthRT);
+
+		RenderGraphPass* pScenePass = renderGraphAddPass(pRenderGraph, "Scene", RENDER_GRAPH_PASS_GRAPHICS, drawScenePass, NULL);
+		renderGraphPassWriteColor(pScenePass, gSwapChainResource, LOAD_ACTION_CLEAR);
+		renderGraphPassWriteDepth(pScenePass, depthResource, LOAD_ACTION_CLEAR);
+
+		RenderGraphPass* pUIPass =
+			renderGraphAddPass(pRenderGraph, "UI", RENDER_GRAPH_PASS_GRAPHICS, drawUserInterfacePass, NULL);
+		renderGraphPassWriteColor(pUIPass, gSwapChainResource, LOAD_ACTION_LOAD);
+
+		if (!compileRenderGraph(pRenderGraph))
+			return false;
+
+		pDepthBuffer = renderGraphGetRenderTarget(pRenderGraph, depthResource);
 
 		return pDepthBuffer != NULL;
 	}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2017-2022 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Maps files written by the test through the system file IO.
+
+#include "../OS/Interfaces/IFileSystem.h"
+
+#include "TestFramework.h"
+
+#include "../OS/Interfaces/IMemory.h"
+
+static bool writeTestFile(const char* pFileName, const uint8_t* pData, size_t size)
+{
+	FileStream stream = {};
+	if (!fsOpenStreamFromPath(RD_LOG, pFileName, FM_WRITE_BINARY, NULL, &stream))
+		return false;
+	const bool success = fsWriteToStream(&stream, pData, size) == size;
+	fsCloseStream(&stream);
+	return success;
+}
+
+TEST_CASE(FileSystemMapsFileInPlace)
+{
+	const char*  pFileName = "FileSystemTestMapped.bin";
+	const size_t size = 64 * 1024 + 17;
+
+	uint8_t* pData = (uint8_t*)tf_malloc(size);
+	for (size_t i = 0; i < size; ++i)
+		pData[i] = (uint8_t)(i * 7 + (i >> 8));
+	TEST_CHECK(writeTestFile(pFileName, pData, size));
+
+	FileStream stream = {};
+	TEST_CHECK(fsOpenMappedStreamFromPath(RD_LOG, pFileName, NULL, &stream));
+
+	// Contents are reachable without a read, mapped or read into memory when the platform can't map
+	const uint8_t* pMapped = (const uint8_t*)fsGetStreamBufferIfPresent(&stream);
+	TEST_CHECK(pMapped);
+	TEST_CHECK(fsGetStreamFileSize(&stream) == (ssize_t)size);
+	TEST_CHECK(pMapped && !memcmp(pMapped, pData, size));
+
+	// Reads and seeks go through the same memory
+	uint8_t head[16] = {};
+	TEST_CHECK(fsReadFromStream(&stream, head, sizeof(head)) == sizeof(head));
+	TEST_CHECK(!memcmp(head, pData, sizeof(head)));
+	TEST_CHECK(fsGetStreamSeekPosition(&stream) == (ssize_t)sizeof(head));
+
+	TEST_CHECK(fsSeekStream(&stream, SBO_END_OF_FILE, -(ssize_t)sizeof(head)));
+	uint8_t tail[32] = {};
+	TEST_CHECK(fsReadFromStream(&stream, tail, sizeof(tail)) == sizeof(head));
+	TEST_CHECK(!memcmp(tail, pData + size - sizeof(head), sizeof(head)));
+	TEST_CHECK(fsStreamAtEnd(&stream));
+
+	// Mapped streams are read only
+	TEST_CHECK(fsWriteToStream(&stream, pData, 1) == 0);
+
+	fsCloseStream(&stream);
+	tf_free(pData);
+}
+
+TEST_CASE(FileSystemMapsEmptyAndMissingFiles)
+{
+	const char* pFileName = "FileSystemTestEmpty.bin";
+	TEST_CHECK(writeTestFile(pFileName, NULL, 0));
+
+	FileStream stream = {};
+	TEST_CHECK(fsOpenMappedStreamFromPath(RD_LOG, pFileName, NULL, &stream));
+	TEST_CHECK(fsGetStreamFileSize(&stream) == 0);
+	TEST_CHECK(fsStreamAtEnd(&stream));
+	fsCloseStream(&stream);
+
+	FileStream missing = {};
+	TEST_CHECK(!fsOpenMappedStreamFromPath(RD_LOG, "FileSystemTestMissing.bin", NULL, &missing));
+}
@@ -0,0 +1,1152 @@
+/*
+ * Copyright (c) 2017-2022 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Runs the Vulkan front end on the null driver, only built in the Null configuration.
+
+#include "../Renderer/Include/IRenderer.h"
+
+#if defined(NULL_RENDERER)
+
+#include "../Renderer/Include/IResidencyManager.h"
+#include "../Renderer/Include/IResourceLoader.h"
+#include "../Renderer/Null/NullDriver.h"
+#include "../OS/Core/RingBuffer.h"
+#include "../OS/Core/ThreadSystem.h"
+#include "../OS/Interfaces/IFileSystem.h"
+
+#include "TestFramework.h"
+
+#include "../OS/Interfaces/IMemory.h"
+
+typedef struct NullTestContext
+{
+	Renderer*     pRenderer;
+	Queue*        pQueue;
+	CmdPool*      pCmdPool;
+	Cmd*          pCmd;
+	Fence*        pFence;
+	RenderTarget* pRenderTarget;
+} NullTestContext;
+
+static bool initNullTestContext(NullTestContext* pContext)
+{
+	*pContext = {};
+
+	RendererDesc settings = {};
+	initRenderer("NullDriverTests", &settings, &pContext->pRenderer);
+	if (!pContext->pRenderer)
+		return false;
+
+	QueueDesc queueDesc = {};
+	queueDesc.mType = QUEUE_TYPE_GRAPHICS;
+	vk_addQueue(pContext->pRenderer, &queueDesc, &pContext->pQueue);
+
+	CmdPoolDesc cmdPoolDesc = {};
+	cmdPoolDesc.pQueue = pContext->pQueue;
+	vk_addCmdPool(pContext->pRenderer, &cmdPoolDesc, &pContext->pCmdPool);
+	CmdDesc cmdDesc = {};
+	cmdDesc.pPool = pContext->pCmdPool;
+	vk_addCmd(pContext->pRenderer, &cmdDesc, &pContext->pCmd);
+	vk_addFence(pContext->pRenderer, &pContext->pFence);
+
+	RenderTargetDesc rtDesc = {};
+	rtDesc.mArraySize = 1;
+	rtDesc.mDepth = 1;
+	rtDesc.mFormat = TinyImageFormat_R8G8B8A8_UNORM;
+	rtDesc.mStartState = RESOURCE_STATE_RENDER_TARGET;
+	rtDesc.mWidth = 1920;
+	rtDesc.mHeight = 1080;
+	rtDesc.mSampleCount = SAMPLE_COUNT_1;
+	vk_addRenderTarget(pContext->pRenderer, &rtDesc, &pContext->pRenderTarget);
+
+	// Drop the work submitted while creating the objects
+	NullDriverStats stats = {};
+	nullDriverTakeStats(&stats);
+	return true;
+}
+
+static void exitNullTestContext(NullTestContext* pContext)
+{
+	vk_removeRenderTarget(pContext->pRenderer, pContext->pRenderTarget);
+	vk_removeFence(pContext->pRenderer, pContext->pFence);
+	vk_removeCmd(pContext->pRenderer, pContext->pCmd);
+	vk_removeCmdPool(pContext->pRenderer, pContext->pCmdPool);
+	vk_removeQueue(pContext->pRenderer, pContext->pQueue);
+	exitRenderer(pContext->pRenderer);
+}
+
+/// One pass into the render target followed by a transition to shader resource and back
+static void recordNullTestPass(NullTestContext* pContext)
+{
+	Cmd* pCmd = pContext->pCmd;
+	vk_cmdBindRenderTargets(pCmd, 1, &pContext->pRenderTarget, NULL, NULL, NULL, NULL, -1, -1);
+	vk_cmdBindRenderTargets(pCmd, 0, NULL, NULL, NULL, NULL, NULL, -1, -1);
+
+	RenderTargetBarrier barrier = { pContext->pRenderTarget, RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_SHADER_RESOURCE };
+	vk_cmdResourceBarrier(pCmd, 0, NULL, 0, NULL, 1, &barrier);
+	barrier = { pContext->pRenderTarget, RESOURCE_STATE_SHADER_RESOURCE, RESOURCE_STATE_RENDER_TARGET };
+	vk_cmdResourceBarrier(pCmd, 0, NULL, 0, NULL, 1, &barrier);
+}
+
+static void submitNullTestCmd(NullTestContext* pContext)
+{
+	QueueSubmitDesc submitDesc = {};
+	submitDesc.mCmdCount = 1;
+	submitDesc.ppCmds = &pContext->pCmd;
+	submitDesc.pSignalFence = pContext->pFence;
+	vk_queueSubmit(pContext->pQueue, &submitDesc);
+}
+
+TEST_CASE(NullDriverCountsSubmittedWork)
+{
+	NullTestContext context;
+	TEST_CHECK(initNullTestContext(&context));
+	if (!context.pRenderer)
+		return;
+
+	vk_beginCmd(context.pCmd);
+	recordNullTestPass(&context);
+	vk_endCmd(context.pCmd);
+	submitNullTestCmd(&context);
+
+	FenceStatus fenceStatus = FENCE_STATUS_INCOMPLETE;
+	vk_getFenceStatus(context.pRenderer, context.pFence, &fenceStatus);
+	TEST_CHECK(FENCE_STATUS_COMPLETE == fenceStatus);
+
+	NullDriverStats stats = {};
+	nullDriverTakeStats(&stats);
+	TEST_CHECK(1 == stats.mSubmits);
+	TEST_CHECK(1 == stats.mCommandBuffers);
+	TEST_CHECK(1 == stats.mRenderPasses);
+	// The round trip transition of the same render target never reaches the command buffer
+	TEST_CHECK(0 == stats.mBarriers);
+
+	// Taking the stats starts a new interval
+	nullDriverTakeStats(&stats);
+	TEST_CHECK(0 == stats.mSubmits && 0 == stats.mCommands);
+
+	exitNullTestContext(&context);
+}
+
+static void addNullTestRenderTarget(NullTestContext* pContext, RenderTarget** ppRenderTarget)
+{
+	RenderTargetDesc rtDesc = {};
+	rtDesc.mArraySize = 1;
+	rtDesc.mDepth = 1;
+	rtDesc.mFormat = TinyImageFormat_R8G8B8A8_UNORM;
+	rtDesc.mStartState = RESOURCE_STATE_RENDER_TARGET;
+	rtDesc.mWidth = 256;
+	rtDesc.mHeight = 256;
+	rtDesc.mSampleCount = SAMPLE_COUNT_1;
+	vk_addRenderTarget(pContext->pRenderer, &rtDesc, ppRenderTarget);
+
+	NullDriverStats stats = {};
+	nullDriverTakeStats(&stats);
+}
+
+TEST_CASE(NullDriverBatchesQueuedBarriers)
+{
+	NullTestContext context;
+	TEST_CHECK(initNullTestContext(&context));
+	if (!context.pRenderer)
+		return;
+
+	RenderTarget* pOtherTarget = NULL;
+	addNullTestRenderTarget(&context, &pOtherTarget);
+
+	BarrierStats before = {};
+	vk_getBarrierStats(context.pRenderer, &before);
+
+	vk_beginCmd(context.pCmd);
+	RenderTargetBarrier barriers[] = {
+		{ context.pRenderTarget, RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_SHADER_RESOURCE },
+		{ pOtherTarget, RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_SHADER_RESOURCE },
+	};
+	vk_cmdResourceBarrier(context.pCmd, 0, NULL, 0, NULL, 1, &barriers[0]);
+	vk_cmdResourceBarrier(context.pCmd, 0, NULL, 0, NULL, 1, &barriers[1]);
+	// Continuing the transition of the first target folds into the queued one
+	RenderTargetBarrier next = { context.pRenderTarget, RESOURCE_STATE_SHADER_RESOURCE, RESOURCE_STATE_COPY_SOURCE };
+	vk_cmdResourceBarrier(context.pCmd, 0, NULL, 0, NULL, 1, &next);
+	vk_cmdFlushBarriers(context.pCmd);
+	vk_endCmd(context.pCmd);
+	submitNullTestCmd(&context);
+
+	BarrierStats after = {};
+	vk_getBarrierStats(context.pRenderer, &after);
+	TEST_CHECK(3 == after.mBarriersRequested - before.mBarriersRequested);
+	TEST_CHECK(1 == after.mBarriersMerged - before.mBarriersMerged);
+	TEST_CHECK(2 == after.mBarriersEmitted - before.mBarriersEmitted);
+	TEST_CHECK(1 == after.mPipelineBarrierCalls - before.mPipelineBarrierCalls);
+
+	NullDriverStats stats = {};
+	nullDriverTakeStats(&stats);
+	TEST_CHECK(1 == stats.mBarriers);
+
+	vk_removeRenderTarget(context.pRenderer, pOtherTarget);
+	exitNullTestContext(&context);
+}
+
+TEST_CASE(NullDriverFlushesBeforeDirectRecording)
+{
+	NullTestContext context;
+	TEST_CHECK(initNullTestContext(&context));
+	if (!context.pRenderer)
+		return;
+
+	// Same pattern as a screenshot readback, the copy in between is recorded outside the renderer
+	vk_beginCmd(context.pCmd);
+	RenderTargetBarrier barrier = { context.pRenderTarget, RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_COPY_SOURCE };
+	vk_cmdResourceBarrier(context.pCmd, 0, NULL, 0, NULL, 1, &barrier);
+	vk_cmdFlushBarriers(context.pCmd);
+	barrier = { context.pRenderTarget, RESOURCE_STATE_COPY_SOURCE, RESOURCE_STATE_RENDER_TARGET };
+	vk_cmdResourceBarrier(context.pCmd, 0, NULL, 0, NULL, 1, &barrier);
+	vk_endCmd(context.pCmd);
+	submitNullTestCmd(&context);
+
+	NullDriverStats stats = {};
+	nullDriverTakeStats(&stats);
+	TEST_CHECK(2 == stats.mBarriers);
+
+	exitNullTestContext(&context);
+}
+
+TEST_CASE(NullDriverCachesRenderPasses)
+{
+	NullTestContext context;
+	TEST_CHECK(initNullTestContext(&context));
+	if (!context.pRenderer)
+		return;
+
+	RenderPassCacheStats before = {};
+	vk_getRenderPassCacheStats(context.pRenderer, &before);
+
+	vk_beginCmd(context.pCmd);
+	for (uint32_t i = 0; i < 4; ++i)
+	{
+		vk_cmdBindRenderTargets(context.pCmd, 1, &context.pRenderTarget, NULL, NULL, NULL, NULL, -1, -1);
+		vk_cmdBindRenderTargets(context.pCmd, 0, NULL, NULL, NULL, NULL, NULL, -1, -1);
+	}
+	vk_endCmd(context.pCmd);
+	submitNullTestCmd(&context);
+	vk_waitForFences(context.pRenderer, 1, &context.pFence);
+
+	RenderPassCacheStats after = {};
+	vk_getRenderPassCacheStats(context.pRenderer, &after);
+	TEST_CHECK(1 == after.mRenderPassMisses - before.mRenderPassMisses);
+	TEST_CHECK(3 == after.mRenderPassHits - before.mRenderPassHits);
+	TEST_CHECK(1 == after.mFrameBufferMisses - before.mFrameBufferMisses);
+	TEST_CHECK(3 == after.mFrameBufferHits - before.mFrameBufferHits);
+
+	// No swap chain, the frames are ticked explicitly. A few seconds of frames without the target evicts its frame buffer
+	for (uint32_t f = 0; f < 360; ++f)
+		vk_updateRenderPassCache(context.pRenderer);
+
+	vk_getRenderPassCacheStats(context.pRenderer, &after);
+	TEST_CHECK(1 == after.mFrameBufferEvictions - before.mFrameBufferEvictions);
+
+	vk_resetCmdPool(context.pRenderer, context.pCmdPool);
+	vk_beginCmd(context.pCmd);
+	vk_cmdBindRenderTargets(context.pCmd, 1, &context.pRenderTarget, NULL, NULL, NULL, NULL, -1, -1);
+	vk_cmdBindRenderTargets(context.pCmd, 0, NULL, NULL, NULL, NULL, NULL, -1, -1);
+	vk_endCmd(context.pCmd);
+	submitNullTestCmd(&context);
+	vk_waitForFences(context.pRenderer, 1, &context.pFence);
+
+	vk_getRenderPassCacheStats(context.pRenderer, &after);
+	TEST_CHECK(1 == after.mRenderPassMisses - before.mRenderPassMisses);
+	TEST_CHECK(2 == after.mFrameBufferMisses - before.mFrameBufferMisses);
+
+	exitNullTestContext(&context);
+}
+
+// Compute shader sampling nothing but declaring and loading "uTex" (set 0, binding 0), assembled by hand
+static const uint32_t gTextureShaderSpirv[] = {
+	0x07230203, 0x00010000, 0x00000000, 0x0000000a, 0x00000000, 0x00020011, 0x00000001, 0x0003000e,
+	0x00000000, 0x00000001, 0x0005000f, 0x00000005, 0x00000001, 0x6e69616d, 0x00000000, 0x00060010,
+	0x00000001, 0x00000011, 0x00000001, 0x00000001, 0x00000001, 0x00040005, 0x00000007, 0x78655475,
+	0x00000000, 0x00040047, 0x00000007, 0x00000022, 0x00000000, 0x00040047, 0x00000007, 0x00000021,
+	0x00000000, 0x00020013, 0x00000002, 0x00030021, 0x00000003, 0x00000002, 0x00030016, 0x00000004,
+	0x00000020, 0x00090019, 0x00000005, 0x00000004, 0x00000001, 0x00000000, 0x00000000, 0x00000000,
+	0x00000001, 0x00000000, 0x00040020, 0x00000006, 0x00000000, 0x00000005, 0x0004003b, 0x00000006,
+	0x00000007, 0x00000000, 0x00050036, 0x00000002, 0x00000001, 0x00000000, 0x00000003, 0x000200f8,
+	0x00000008, 0x0004003d, 0x00000005, 0x00000009, 0x00000007, 0x000100fd, 0x00010038,
+};
+
+typedef struct DescriptorTestContext
+{
+	Shader*               pShader;
+	RootSignature*        pRootSignature;
+	DescriptorSet*        pDescriptorSet;
+	DescriptorUpdatePlan* pPlan;
+	uint32_t*             pIndices;
+	DescriptorData*       pParams;
+	uint32_t              mSetCount;
+} DescriptorTestContext;
+
+static void initDescriptorTestContext(NullTestContext* pContext, uint32_t setCount, DescriptorTestContext* pDescriptors)
+{
+	*pDescriptors = {};
+	pDescriptors->mSetCount = setCount;
+
+	BinaryShaderDesc shaderDesc = {};
+	shaderDesc.mStages = SHADER_STAGE_COMP;
+	shaderDesc.mComp.pByteCode = (void*)gTextureShaderSpirv;
+	shaderDesc.mComp.mByteCodeSize = sizeof(gTextureShaderSpirv);
+	shaderDesc.mComp.pEntryPoint = "main";
+	vk_addShaderBinary(pContext->pRenderer, &shaderDesc, &pDescriptors->pShader);
+
+	RootSignatureDesc rootDesc = {};
+	rootDesc.ppShaders = &pDescriptors->pShader;
+	rootDesc.mShaderCount = 1;
+	vk_addRootSignature(pContext->pRenderer, &rootDesc, &pDescriptors->pRootSignature);
+
+	DescriptorSetDesc setDesc = { pDescriptors->pRootSignature, DESCRIPTOR_UPDATE_FREQ_NONE, setCount };
+	vk_addDescriptorSet(pContext->pRenderer, &setDesc, &pDescriptors->pDescriptorSet);
+
+	DescriptorData layout[1] = {};
+	layout[0].pName = "uTex";
+	DescriptorUpdatePlanDesc planDesc = { pDescriptors->pRootSignature, DESCRIPTOR_UPDATE_FREQ_NONE, layout, 1 };
+	vk_addDescriptorUpdatePlan(pContext->pRenderer, &planDesc, &pDescriptors->pPlan);
+
+	// Every set points at the render target, params are in plan layout order so names are not needed
+	pDescriptors->pIndices = (uint32_t*)tf_calloc(setCount, sizeof(uint32_t));
+	pDescriptors->pParams = (DescriptorData*)tf_calloc(setCount, sizeof(DescriptorData));
+	for (uint32_t i = 0; i < setCount; ++i)
+	{
+		pDescriptors->pIndices[i] = i;
+		pDescriptors->pParams[i].ppTextures = &pContext->pRenderTarget->pTexture;
+	}
+}
+
+static void exitDescriptorTestContext(NullTestContext* pContext, DescriptorTestContext* pDescriptors)
+{
+	tf_free(pDescriptors->pIndices);
+	tf_free(pDescriptors->pParams);
+	vk_removeDescriptorUpdatePlan(pContext->pRenderer, pDescriptors->pPlan);
+	vk_removeDescriptorSet(pContext->pRenderer, pDescriptors->pDescriptorSet);
+	vk_removeRootSignature(pContext->pRenderer, pDescriptors->pRootSignature);
+	vk_removeShader(pContext->pRenderer, pDescriptors->pShader);
+}
+
+/// The same updates one set at a time through the name lookup path
+static void updateDescriptorSetsByName(NullTestContext* pContext, DescriptorTestContext* pDescriptors)
+{
+	for (uint32_t i = 0; i < pDescriptors->mSetCount; ++i)
+	{
+		DescriptorData params[1] = {};
+		params[0].pName = "uTex";
+		params[0].ppTextures = pDescriptors->pParams[i].ppTextures;
+		vk_updateDescriptorSet(pContext->pRenderer, pDescriptors->pIndices[i], pDescriptors->pDescriptorSet, 1, params);
+	}
+}
+
+TEST_CASE(NullDriverUpdatesDescriptorSetsWithPlan)
+{
+	NullTestContext context;
+	TEST_CHECK(initNullTestContext(&context));
+	if (!context.pRenderer)
+		return;
+
+	DescriptorTestContext descriptors;
+	initDescriptorTestContext(&context, 64, &descriptors);
+	TEST_CHECK(descriptors.pPlan);
+
+	NullDriverStats stats = {};
+	nullDriverTakeStats(&stats);
+
+	// One template update per set, the same descriptors the name lookup path writes
+	vk_updateDescriptorSetsWithPlan(
+		context.pRenderer, descriptors.pPlan, descriptors.pDescriptorSet, descriptors.mSetCount, descriptors.pIndices, descriptors.pParams);
+	nullDriverTakeStats(&stats);
+	TEST_CHECK(descriptors.mSetCount == stats.mDescriptorWrites);
+
+	updateDescriptorSetsByName(&context, &descriptors);
+	nullDriverTakeStats(&stats);
+	TEST_CHECK(descriptors.mSetCount == stats.mDescriptorWrites);
+
+	// A subset of the sets in any order
+	const uint32_t indices[] = { 63, 0, 17 };
+	vk_updateDescriptorSetsWithPlan(context.pRenderer, descriptors.pPlan, descriptors.pDescriptorSet, 3, indices, descriptors.pParams);
+	nullDriverTakeStats(&stats);
+	TEST_CHECK(3 == stats.mDescriptorWrites);
+
+	exitDescriptorTestContext(&context, &descriptors);
+	exitNullTestContext(&context);
+}
+
+BENCHMARK_CASE(NullDriverDescriptorUpdates)
+{
+	NullTestContext context;
+	if (!initNullTestContext(&context))
+		return;
+
+	DescriptorTestContext descriptors;
+	initDescriptorTestContext(&context, 1024, &descriptors);
+
+	const uint32_t iterations = 100;
+	HiresTimer     timer;
+	initHiresTimer(&timer);
+	for (uint32_t i = 0; i < iterations; ++i)
+		updateDescriptorSetsByName(&context, &descriptors);
+	const double byNameSeconds = getTestSeconds(&timer, true);
+	for (uint32_t i = 0; i < iterations; ++i)
+	{
+		vk_updateDescriptorSetsWithPlan(
+			context.pRenderer, descriptors.pPlan, descriptors.pDescriptorSet, descriptors.mSetCount, descriptors.pIndices,
+			descriptors.pParams);
+	}
+	const double planSeconds = getTestSeconds(&timer, true);
+
+	reportBenchmarkResult("vk_updateDescriptorSet", iterations * descriptors.mSetCount / byNameSeconds, "sets/s");
+	reportBenchmarkResult("vk_updateDescriptorSetsWithPlan", iterations * descriptors.mSetCount / planSeconds, "sets/s");
+
+	exitDescriptorTestContext(&context, &descriptors);
+	exitNullTestContext(&context);
+}
+
+/************************************************************************/
+// Bindless heap
+/************************************************************************/
+static void addBindlessTestTexture(Renderer* pRenderer, Texture** ppTexture)
+{
+	TextureDesc desc = {};
+	desc.mWidth = 16;
+	desc.mHeight = 16;
+	desc.mDepth = 1;
+	desc.mArraySize = 1;
+	desc.mMipLevels = 1;
+	desc.mSampleCount = SAMPLE_COUNT_1;
+	desc.mFormat = TinyImageFormat_R8G8B8A8_UNORM;
+	desc.mStartState = RESOURCE_STATE_SHADER_RESOURCE;
+	desc.mDescriptors = DESCRIPTOR_TYPE_TEXTURE;
+	vk_addTexture(pRenderer, &desc, ppTexture);
+}
+
+static void addBindlessTestBuffer(Renderer* pRenderer, DescriptorType descriptors, Buffer** ppBuffer)
+{
+	BufferDesc desc = {};
+	desc.mSize = 256;
+	desc.mElementCount = 16;
+	desc.mStructStride = 16;
+	desc.mDescriptors = descriptors;
+	desc.mMemoryUsage = (descriptors & DESCRIPTOR_TYPE_UNIFORM_BUFFER) ? RESOURCE_MEMORY_USAGE_CPU_TO_GPU : RESOURCE_MEMORY_USAGE_GPU_ONLY;
+	vk_addBuffer(pRenderer, &desc, ppBuffer);
+}
+
+static uint64_t takeNullTestDescriptorWrites()
+{
+	NullDriverStats stats = {};
+	nullDriverTakeStats(&stats);
+	return stats.mDescriptorWrites;
+}
+
+TEST_CASE(NullDriverBindlessHeapRecyclesIndices)
+{
+	RendererDesc settings = {};
+	settings.mVulkan.mEnableBindless = true;
+	settings.mVulkan.mBindlessTextureCount = 4;
+	settings.mVulkan.mBindlessBufferCount = 2;
+	Renderer* pRenderer = NULL;
+	initRenderer("NullDriverTests", &settings, &pRenderer);
+	TEST_CHECK(pRenderer);
+	if (!pRenderer)
+		return;
+	takeNullTestDescriptorWrites();
+
+	// Every texture gets its own slot and one descriptor write
+	Texture* pTextures[4] = {};
+	for (uint32_t i = 0; i < 4; ++i)
+	{
+		addBindlessTestTexture(pRenderer, &pTextures[i]);
+		TEST_CHECK(pTextures[i]->mBindlessIndex < 4);
+		for (uint32_t j = 0; j < i; ++j)
+			TEST_CHECK(pTextures[i]->mBindlessIndex != pTextures[j]->mBindlessIndex);
+	}
+	TEST_CHECK(4 == takeNullTestDescriptorWrites());
+
+	// A full heap still creates the texture, it just has no slot
+	Texture* pOverflow = NULL;
+	addBindlessTestTexture(pRenderer, &pOverflow);
+	TEST_CHECK(pOverflow && BINDLESS_INVALID_INDEX == pOverflow->mBindlessIndex);
+	TEST_CHECK(0 == takeNullTestDescriptorWrites());
+
+	// Removing frees the slot for the next texture, which overwrites it
+	const uint32_t freedIndex = pTextures[1]->mBindlessIndex;
+	vk_removeTexture(pRenderer, pTextures[1]);
+	addBindlessTestTexture(pRenderer, &pTextures[1]);
+	TEST_CHECK(freedIndex == pTextures[1]->mBindlessIndex);
+	TEST_CHECK(1 == takeNullTestDescriptorWrites());
+
+	// Buffers have their own slots, uniform buffers stay out of the heap
+	Buffer* pBuffers[2] = {};
+	addBindlessTestBuffer(pRenderer, DESCRIPTOR_TYPE_BUFFER, &pBuffers[0]);
+	addBindlessTestBuffer(pRenderer, DESCRIPTOR_TYPE_RW_BUFFER, &pBuffers[1]);
+	TEST_CHECK(pBuffers[0]->mBindlessIndex < 2 && pBuffers[1]->mBindlessIndex < 2);
+	TEST_CHECK(pBuffers[0]->mBindlessIndex != pBuffers[1]->mBindlessIndex);
+	Buffer* pUniformBuffer = NULL;
+	addBindlessTestBuffer(pRenderer, DESCRIPTOR_TYPE_UNIFORM_BUFFER, &pUniformBuffer);
+	TEST_CHECK(BINDLESS_INVALID_INDEX == pUniformBuffer->mBindlessIndex);
+	TEST_CHECK(2 == takeNullTestDescriptorWrites());
+
+	vk_removeBuffer(pRenderer, pUniformBuffer);
+	for (uint32_t i = 0; i < 2; ++i)
+		vk_removeBuffer(pRenderer, pBuffers[i]);
+	vk_removeTexture(pRenderer, pOverflow);
+	for (uint32_t i = 0; i < 4; ++i)
+		vk_removeTexture(pRenderer, pTextures[i]);
+	exitRenderer(pRenderer);
+
+	// Without the heap nothing gets a slot
+	NullTestContext context;
+	TEST_CHECK(initNullTestContext(&context));
+	if (!context.pRenderer)
+		return;
+	TEST_CHECK(BINDLESS_INVALID_INDEX == context.pRenderTarget->pTexture->mBindlessIndex);
+	exitNullTestContext(&context);
+}
+
+/************************************************************************/
+// Pipeline cache
+/************************************************************************/
+static void addTestComputePipeline(
+	NullTestContext* pContext, DescriptorTestContext* pDescriptors, Pipeline** ppPipeline, SyncToken* pToken)
+{
+	PipelineDesc desc = {};
+	desc.mType = PIPELINE_TYPE_COMPUTE;
+	desc.mComputeDesc.pShaderProgram = pDescriptors->pShader;
+	desc.mComputeDesc.pRootSignature = pDescriptors->pRootSignature;
+	addPipeline(pContext->pRenderer, &desc, ppPipeline, pToken);
+}
+
+static void checkPipelineCache(uint32_t pipelineThreadCount)
+{
+	NullTestContext context;
+	TEST_CHECK(initNullTestContext(&context));
+	if (!context.pRenderer)
+		return;
+
+	ResourceLoaderDesc loaderDesc = gDefaultResourceLoaderDesc;
+	loaderDesc.mPipelineThreadCount = pipelineThreadCount;
+	initResourceLoaderInterface(context.pRenderer, &loaderDesc);
+
+	DescriptorTestContext descriptors;
+	initDescriptorTestContext(&context, 1, &descriptors);
+
+	// Identical descriptions share one compile, asynchronous requests hand out a token until it is done
+	Pipeline* pPipelines[2] = {};
+	SyncToken token = {};
+	addTestComputePipeline(&context, &descriptors, &pPipelines[0], &token);
+	addTestComputePipeline(&context, &descriptors, &pPipelines[1], &token);
+	TEST_CHECK(pipelineThreadCount ? token != 0 : token == 0);
+	waitForToken(&token);
+	TEST_CHECK(isTokenCompleted(&token));
+	TEST_CHECK(pPipelines[0] && pPipelines[0] == pPipelines[1]);
+
+	PipelineCompileStats stats = {};
+	getPipelineCompileStats(&stats);
+	TEST_CHECK(2 == stats.mRequests);
+	TEST_CHECK(1 == stats.mCacheHits);
+	TEST_CHECK(1 == stats.mCompiles);
+	TEST_CHECK(0 == stats.mPendingCompiles);
+	TEST_CHECK(1 == stats.mPipelineCount);
+
+	// A new shader in place of a removed one must not hit the cached pipeline, even if it got the same address
+	vk_removeShader(context.pRenderer, descriptors.pShader);
+	BinaryShaderDesc shaderDesc = {};
+	shaderDesc.mStages = SHADER_STAGE_COMP;
+	shaderDesc.mComp.pByteCode = (void*)gTextureShaderSpirv;
+	shaderDesc.mComp.mByteCodeSize = sizeof(gTextureShaderSpirv);
+	shaderDesc.mComp.pEntryPoint = "main";
+	vk_addShaderBinary(context.pRenderer, &shaderDesc, &descriptors.pShader);
+
+	Pipeline* pNewPipeline = NULL;
+	token = 0;
+	addTestComputePipeline(&context, &descriptors, &pNewPipeline, &token);
+	waitForToken(&token);
+	TEST_CHECK(pNewPipeline && pNewPipeline != pPipelines[0]);
+
+	getPipelineCompileStats(&stats);
+	TEST_CHECK(3 == stats.mRequests);
+	TEST_CHECK(1 == stats.mCacheHits);
+	TEST_CHECK(2 == stats.mCompiles);
+	TEST_CHECK(2 == stats.mPipelineCount);
+
+	// Every request holds a reference
+	removePipeline(context.pRenderer, pPipelines[0]);
+	getPipelineCompileStats(&stats);
+	TEST_CHECK(2 == stats.mPipelineCount);
+	removePipeline(context.pRenderer, pPipelines[1]);
+	removePipeline(context.pRenderer, pNewPipeline);
+	getPipelineCompileStats(&stats);
+	TEST_CHECK(0 == stats.mPipelineCount);
+
+	exitDescriptorTestContext(&context, &descriptors);
+	exitResourceLoaderInterface(context.pRenderer);
+	exitNullTestContext(&context);
+}
+
+TEST_CASE(NullDriverPipelineCacheDeduplicates)
+{
+	checkPipelineCache(0);
+	checkPipelineCache(2);
+}
+
+typedef struct SecondaryRecordData
+{
+	CmdRing*   pCmdRing;
+	const Cmd* pPrimaryCmd;
+	uint32_t   mFrameIndex;
+	uint32_t   mDrawCount;
+} SecondaryRecordData;
+
+/// One slot per piece, the way a parallel for over a render pass splits its draws
+static void recordSecondarySlots(void* pUser, uintptr_t start, uintptr_t end)
+{
+	SecondaryRecordData* pData = (SecondaryRecordData*)pUser;
+	for (uintptr_t slot = start; slot < end; ++slot)
+	{
+		Cmd* pCmd = getCmdRingElement(pData->pCmdRing, pData->mFrameIndex, (uint32_t)slot).pCmds[0];
+		vk_beginSecondaryCmd(pCmd, pData->pPrimaryCmd);
+		for (uint32_t d = 0; d < pData->mDrawCount; ++d)
+			vk_cmdDraw(pCmd, 3, 0);
+		vk_endCmd(pCmd);
+	}
+}
+
+/// Records one render pass split over slotCount secondary Cmds and submits it
+static void recordSecondaryFrame(NullTestContext* pContext, ThreadSystem* pThreadSystem, CmdRing* pCmdRing, uint32_t frameIndex, uint32_t drawCount)
+{
+	resetCmdRing(pContext->pRenderer, pCmdRing, frameIndex);
+	vk_resetCmdPool(pContext->pRenderer, pContext->pCmdPool);
+	vk_beginCmd(pContext->pCmd);
+
+	LoadActionsDesc loadActions = {};
+	loadActions.mLoadActionsColor[0] = LOAD_ACTION_CLEAR;
+	loadActions.mExecuteSecondaryCmds = true;
+	vk_cmdBindRenderTargets(pContext->pCmd, 1, &pContext->pRenderTarget, NULL, &loadActions, NULL, NULL, -1, -1);
+
+	SecondaryRecordData data = { pCmdRing, pContext->pCmd, frameIndex, drawCount };
+	ThreadCounter       counter;
+	initThreadCounter(&counter, 0);
+	addThreadSystemParallelForTask(pThreadSystem, recordSecondarySlots, &data, 0, pCmdRing->mSlotCount, 1, &counter);
+	waitThreadCounter(pThreadSystem, &counter);
+
+	Cmd* ppSecondaryCmds[16] = {};
+	ASSERT(pCmdRing->mSlotCount <= sizeof(ppSecondaryCmds) / sizeof(ppSecondaryCmds[0]));
+	for (uint32_t slot = 0; slot < pCmdRing->mSlotCount; ++slot)
+		ppSecondaryCmds[slot] = getCmdRingElement(pCmdRing, frameIndex, slot).pCmds[0];
+	vk_cmdExecuteCmds(pContext->pCmd, pCmdRing->mSlotCount, ppSecondaryCmds);
+
+	vk_cmdBindRenderTargets(pContext->pCmd, 0, NULL, NULL, NULL, NULL, NULL, -1, -1);
+	vk_endCmd(pContext->pCmd);
+	submitNullTestCmd(pContext);
+	vk_waitForFences(pContext->pRenderer, 1, &pContext->pFence);
+}
+
+TEST_CASE(NullDriverExecutesSecondaryCmds)
+{
+	NullTestContext context;
+	TEST_CHECK(initNullTestContext(&context));
+	if (!context.pRenderer)
+		return;
+
+	ThreadSystem* pThreadSystem = NULL;
+	initThreadSystem(&pThreadSystem, MAX_SYSTEM_THREADS);
+
+	CmdRingDesc ringDesc = {};
+	ringDesc.pQueue = context.pQueue;
+	ringDesc.mPoolCount = 2;
+	ringDesc.mSlotCount = 8;
+	ringDesc.mCmdPerPoolCount = 1;
+	ringDesc.mSecondary = true;
+	CmdRing* pCmdRing = NULL;
+	addCmdRing(context.pRenderer, &ringDesc, &pCmdRing);
+
+	// Every frame in flight uses pools of its own, recording the second one must not disturb the first
+	for (uint32_t frame = 0; frame < 4; ++frame)
+	{
+		recordSecondaryFrame(&context, pThreadSystem, pCmdRing, frame % ringDesc.mPoolCount, 32);
+
+		NullDriverStats stats = {};
+		nullDriverTakeStats(&stats);
+		TEST_CHECK(1 == stats.mSubmits);
+		TEST_CHECK(1 == stats.mCommandBuffers);
+		TEST_CHECK(1 == stats.mRenderPasses);
+		TEST_CHECK(ringDesc.mSlotCount * 32 == stats.mDraws);
+	}
+
+	removeCmdRing(context.pRenderer, pCmdRing);
+	exitThreadSystem(pThreadSystem);
+	exitNullTestContext(&context);
+}
+
+BENCHMARK_CASE(NullDriverSecondaryCmdRecording)
+{
+	NullTestContext context;
+	if (!initNullTestContext(&context))
+		return;
+
+	ThreadSystem* pThreadSystem = NULL;
+	initThreadSystem(&pThreadSystem, MAX_SYSTEM_THREADS);
+
+	const uint32_t frames = 100;
+	const uint32_t draws = 20000;
+	const uint32_t slotCounts[] = { 1, 4, 16 };
+	for (uint32_t s = 0; s < sizeof(slotCounts) / sizeof(slotCounts[0]); ++s)
+	{
+		CmdRingDesc ringDesc = {};
+		ringDesc.pQueue = context.pQueue;
+		ringDesc.mPoolCount = 2;
+		ringDesc.mSlotCount = slotCounts[s];
+		ringDesc.mCmdPerPoolCount = 1;
+		ringDesc.mSecondary = true;
+		CmdRing* pCmdRing = NULL;
+		addCmdRing(context.pRenderer, &ringDesc, &pCmdRing);
+
+		HiresTimer timer;
+		initHiresTimer(&timer);
+		for (uint32_t f = 0; f < frames; ++f)
+			recordSecondaryFrame(&context, pThreadSystem, pCmdRing, f % ringDesc.mPoolCount, draws / slotCounts[s]);
+		const double seconds = getTestSeconds(&timer, true);
+
+		char name[64];
+		snprintf(name, sizeof(name), "Frame (%u draws, %u slots)", draws, slotCounts[s]);
+		reportBenchmarkResult(name, seconds * 1000000.0 / frames, "us");
+		removeCmdRing(context.pRenderer, pCmdRing);
+	}
+
+	exitThreadSystem(pThreadSystem);
+	exitNullTestContext(&context);
+}
+
+/************************************************************************/
+// Transient buffers
+/************************************************************************/
+typedef struct TransientAllocData
+{
+	TransientBuffer*     pTransientBuffer;
+	TransientAllocation* pAllocations;
+	uint32_t             mAllocCount;
+	uint32_t             mAllocSize;
+} TransientAllocData;
+
+/// Every slot fills its allocations with its own pattern
+static void allocTransientSlots(void* pUser, uintptr_t start, uintptr_t end)
+{
+	TransientAllocData* pData = (TransientAllocData*)pUser;
+	for (uintptr_t slot = start; slot < end; ++slot)
+	{
+		for (uint32_t i = 0; i < pData->mAllocCount; ++i)
+		{
+			TransientAllocation alloc = allocTransientBuffer(pData->pTransientBuffer, (uint32_t)slot, pData->mAllocSize);
+			memset(alloc.pData, (int)(slot * pData->mAllocCount + i), pData->mAllocSize);
+			pData->pAllocations[slot * pData->mAllocCount + i] = alloc;
+		}
+	}
+}
+
+static bool transientAllocationHolds(const TransientAllocation* pAlloc, uint32_t size, uint8_t value)
+{
+	const uint8_t* pBytes = (const uint8_t*)pAlloc->pData;
+	for (uint32_t i = 0; i < size; ++i)
+	{
+		if (pBytes[i] != value)
+			return false;
+	}
+	return true;
+}
+
+/// Empty submission that signals pFence
+static void submitNullTestFence(NullTestContext* pContext, Fence* pFence)
+{
+	vk_resetCmdPool(pContext->pRenderer, pContext->pCmdPool);
+	vk_beginCmd(pContext->pCmd);
+	vk_endCmd(pContext->pCmd);
+
+	QueueSubmitDesc submitDesc = {};
+	submitDesc.mCmdCount = 1;
+	submitDesc.ppCmds = &pContext->pCmd;
+	submitDesc.pSignalFence = pFence;
+	vk_queueSubmit(pContext->pQueue, &submitDesc);
+}
+
+TEST_CASE(NullDriverTransientBufferAllocatesConcurrently)
+{
+	NullTestContext context;
+	TEST_CHECK(initNullTestContext(&context));
+	if (!context.pRenderer)
+		return;
+
+	ThreadSystem* pThreadSystem = NULL;
+	initThreadSystem(&pThreadSystem, MAX_SYSTEM_THREADS);
+
+	TransientBufferDesc desc = {};
+	desc.mDescriptors = DESCRIPTOR_TYPE_VERTEX_BUFFER;
+	desc.mPageSize = 4096;
+	desc.mChunkSize = 256;
+	desc.mFrameCount = 2;
+	desc.mSlotCount = 8;
+	desc.mInitialPageCount = 2;
+	TransientBuffer* pTransientBuffer = NULL;
+	addTransientBuffer(context.pRenderer, &desc, &pTransientBuffer);
+
+	// Many more bytes than the initial pages hold, the slots race each other for new pages
+	const uint32_t     allocCount = 1000;
+	const uint32_t     allocSize = 40;
+	TransientAllocData data = { pTransientBuffer, (TransientAllocation*)tf_calloc(desc.mSlotCount * allocCount, sizeof(TransientAllocation)),
+								allocCount, allocSize };
+
+	for (uint32_t frame = 0; frame < 4; ++frame)
+	{
+		beginTransientBufferFrame(pTransientBuffer, NULL);
+
+		ThreadCounter counter;
+		initThreadCounter(&counter, 0);
+		addThreadSystemParallelForTask(pThreadSystem, allocTransientSlots, &data, 0, desc.mSlotCount, 1, &counter);
+		waitThreadCounter(pThreadSystem, &counter);
+
+		// No two allocations overlap
+		bool intact = true;
+		bool aligned = true;
+		for (uint32_t i = 0; i < desc.mSlotCount * allocCount; ++i)
+		{
+			intact = intact && transientAllocationHolds(&data.pAllocations[i], allocSize, (uint8_t)i);
+			aligned = aligned && !(data.pAllocations[i].mOffset % sizeof(float[4]));
+		}
+		TEST_CHECK(intact);
+		TEST_CHECK(aligned);
+	}
+
+	beginTransientBufferFrame(pTransientBuffer, NULL);
+	TransientBufferStats stats = {};
+	getTransientBufferStats(pTransientBuffer, &stats);
+	TEST_CHECK(stats.mFrameBytes == (uint64_t)desc.mSlotCount * allocCount * allocSize);
+	TEST_CHECK(stats.mPeakFrameBytes == stats.mFrameBytes);
+	TEST_CHECK(stats.mFramePageBytes >= stats.mFrameBytes);
+	TEST_CHECK(stats.mOverflowPageCount > 0);
+	TEST_CHECK(stats.mPageCount == desc.mInitialPageCount + stats.mOverflowPageCount);
+	TEST_CHECK(stats.mPageBytes == stats.mPageCount * desc.mPageSize);
+	// Frames recycle the pages of the frame before last, only the first two frames had to create pages
+	TEST_CHECK(stats.mPageBytes <= 2 * stats.mPeakFramePageBytes);
+
+	tf_free(data.pAllocations);
+	removeTransientBuffer(pTransientBuffer);
+	exitThreadSystem(pThreadSystem);
+	exitNullTestContext(&context);
+}
+
+TEST_CASE(NullDriverTransientBufferOverflowsPages)
+{
+	NullTestContext context;
+	TEST_CHECK(initNullTestContext(&context));
+	if (!context.pRenderer)
+		return;
+
+	TransientBufferDesc desc = {};
+	desc.mDescriptors = DESCRIPTOR_TYPE_VERTEX_BUFFER;
+	desc.mPageSize = 4096;
+	desc.mChunkSize = 1024;
+	desc.mFrameCount = 2;
+	desc.mSlotCount = 1;
+	desc.mInitialPageCount = 1;
+	TransientBuffer* pTransientBuffer = NULL;
+	addTransientBuffer(context.pRenderer, &desc, &pTransientBuffer);
+
+	beginTransientBufferFrame(pTransientBuffer, NULL);
+	TransientAllocation small = allocTransientBuffer(pTransientBuffer, 0, 64);
+	// Larger than a page, gets a page of its own
+	TransientAllocation large = allocTransientBuffer(pTransientBuffer, 0, 3 * desc.mPageSize);
+	TEST_CHECK(large.pBuffer != small.pBuffer);
+	TEST_CHECK(large.pBuffer->mSize >= 3 * desc.mPageSize);
+	memset(large.pData, 0xAB, 3 * desc.mPageSize);
+	// Stricter alignment than the pages use
+	TransientAllocation aligned = allocTransientBuffer(pTransientBuffer, 0, 16, 256);
+	TEST_CHECK(!(aligned.mOffset % 256));
+
+	beginTransientBufferFrame(pTransientBuffer, NULL);
+	TransientBufferStats stats = {};
+	getTransientBufferStats(pTransientBuffer, &stats);
+	TEST_CHECK(stats.mFrameBytes == 64 + 3 * desc.mPageSize + 16);
+	TEST_CHECK(stats.mOverflowPageCount >= 1);
+	TEST_CHECK(stats.mPageBytes >= 4 * desc.mPageSize);
+
+	removeTransientBuffer(pTransientBuffer);
+	exitNullTestContext(&context);
+}
+
+TEST_CASE(NullDriverTransientBufferReusesPagesAfterFence)
+{
+	NullTestContext context;
+	TEST_CHECK(initNullTestContext(&context));
+	if (!context.pRenderer)
+		return;
+
+	TransientBufferDesc desc = {};
+	desc.mDescriptors = DESCRIPTOR_TYPE_VERTEX_BUFFER;
+	desc.mPageSize = 4096;
+	desc.mChunkSize = 4096;
+	desc.mFrameCount = 3;
+	desc.mSlotCount = 1;
+	desc.mInitialPageCount = 1;
+	TransientBuffer* pTransientBuffer = NULL;
+	addTransientBuffer(context.pRenderer, &desc, &pTransientBuffer);
+
+	Fence* pFences[3] = {};
+	for (uint32_t i = 0; i < 3; ++i)
+		vk_addFence(context.pRenderer, &pFences[i]);
+
+	// Frame 0 takes the only page
+	beginTransientBufferFrame(pTransientBuffer, pFences[0]);
+	TransientAllocation frame0 = allocTransientBuffer(pTransientBuffer, 0, desc.mPageSize);
+
+	// Frame 0 wasn't submitted yet, frame 1 needs a new page
+	beginTransientBufferFrame(pTransientBuffer, pFences[1]);
+	TEST_CHECK(!vk_isFenceSubmitComplete(context.pRenderer, pFences[0], 1));
+	TransientAllocation frame1 = allocTransientBuffer(pTransientBuffer, 0, desc.mPageSize);
+	TEST_CHECK(frame1.pBuffer != frame0.pBuffer);
+
+	// The application observing the fence resets it, the transient buffer still sees frame 0 as complete
+	submitNullTestFence(&context, pFences[0]);
+	FenceStatus fenceStatus = FENCE_STATUS_INCOMPLETE;
+	vk_getFenceStatus(context.pRenderer, pFences[0], &fenceStatus);
+	TEST_CHECK(FENCE_STATUS_COMPLETE == fenceStatus);
+	TEST_CHECK(vk_isFenceSubmitComplete(context.pRenderer, pFences[0], 1));
+	TEST_CHECK(!vk_isFenceSubmitComplete(context.pRenderer, pFences[0], 2));
+
+	// Frame 2 reuses the page of frame 0 before frame 0's slot comes around again
+	beginTransientBufferFrame(pTransientBuffer, pFences[2]);
+	TransientAllocation frame2 = allocTransientBuffer(pTransientBuffer, 0, desc.mPageSize);
+	TEST_CHECK(frame2.pBuffer == frame0.pBuffer);
+
+	TransientBufferStats stats = {};
+	getTransientBufferStats(pTransientBuffer, &stats);
+	TEST_CHECK(2 == stats.mPageCount);
+	TEST_CHECK(1 == stats.mOverflowPageCount);
+
+	submitNullTestFence(&context, pFences[1]);
+	submitNullTestFence(&context, pFences[2]);
+	vk_waitForFences(context.pRenderer, 3, pFences);
+	removeTransientBuffer(pTransientBuffer);
+	for (uint32_t i = 0; i < 3; ++i)
+		vk_removeFence(context.pRenderer, pFences[i]);
+	exitNullTestContext(&context);
+}
+
+BENCHMARK_CASE(NullDriverFrameOverhead)
+{
+	NullTestContext context;
+	if (!initNullTestContext(&context))
+		return;
+
+	const uint32_t frames = 1000;
+	const uint32_t passes = 64;
+
+	HiresTimer timer;
+	initHiresTimer(&timer);
+	for (uint32_t f = 0; f < frames; ++f)
+	{
+		vk_resetCmdPool(context.pRenderer, context.pCmdPool);
+		vk_beginCmd(context.pCmd);
+		for (uint32_t p = 0; p < passes; ++p)
+			recordNullTestPass(&context);
+		vk_endCmd(context.pCmd);
+		submitNullTestCmd(&context);
+		vk_waitForFences(context.pRenderer, 1, &context.pFence);
+		vk_updateRenderPassCache(context.pRenderer);
+	}
+	const double seconds = getTestSeconds(&timer, true);
+
+	NullDriverStats stats = {};
+	nullDriverTakeStats(&stats);
+	reportBenchmarkResult("Frame (64 render passes)", seconds * 1000000.0 / frames, "us");
+	reportBenchmarkResult("Driver commands per frame", (double)stats.mCommands / frames, "");
+
+	exitNullTestContext(&context);
+}
+
+/************************************************************************/
+// Residency
+/************************************************************************/
+static const uint32_t gResidencyTestTextureSize = 256;
+static const char*    gResidencyTestTextureNames[] = { "ResidencyTest0", "ResidencyTest1", "ResidencyTest2", "ResidencyTest3" };
+
+/// Uncompressed RGBA8 dds with the full mip chain
+static bool writeMippedTestTexture(const char* pFileName, uint32_t size)
+{
+	uint32_t mipCount = 1;
+	size_t   pixelBytes = (size_t)size * size * 4;
+	for (uint32_t mipSize = size; mipSize > 1; mipSize >>= 1, ++mipCount)
+		pixelBytes += (size_t)(mipSize >> 1) * (mipSize >> 1) * 4;
+
+	uint32_t header[32] = {};
+	header[0] = 0x20534444;    // "DDS "
+	header[1] = 124;           // sizeof(DDS_HEADER)
+	header[2] = 0x2100F;       // caps | height | width | pitch | pixel format | mip count
+	header[3] = size;
+	header[4] = size;
+	header[5] = size * 4;
+	header[7] = mipCount;
+	header[19] = 32;           // sizeof(DDS_PIXELFORMAT)
+	header[20] = 0x41;         // rgb | alpha
+	header[22] = 32;
+	header[23] = 0x000000ff;
+	header[24] = 0x0000ff00;
+	header[25] = 0x00ff0000;
+	header[26] = 0xff000000;
+	header[27] = 0x401008;     // complex | texture | mipmap
+
+	char fileName[FS_MAX_PATH] = {};
+	fsAppendPathExtension(pFileName, "dds", fileName);
+
+	FileStream stream = {};
+	if (!fsOpenStreamFromPath(RD_TEXTURES, fileName, FM_WRITE_BINARY, NULL, &stream))
+		return false;
+
+	uint8_t* pPixels = (uint8_t*)tf_malloc(pixelBytes);
+	for (size_t i = 0; i < pixelBytes; ++i)
+		pPixels[i] = (uint8_t)i;
+
+	bool success = fsWriteToStream(&stream, header, sizeof(header)) == sizeof(header);
+	success = success && fsWriteToStream(&stream, pPixels, pixelBytes) == pixelBytes;
+	fsCloseStream(&stream);
+	tf_free(pPixels);
+	return success;
+}
+
+/// Budget under which the usage right now is usageFraction of it
+static void setResidencyTestBudget(Renderer* pRenderer, double usageFraction)
+{
+	MemoryBudget budget = {};
+	vk_getMemoryBudget(pRenderer, &budget);
+	nullDriverSetMemoryBudget((uint64_t)((double)budget.mUsage / usageFraction));
+}
+
+/// One frame using the textures in usedMask
+static bool updateResidencyTestFrame(ResidencyManager* pManager, ResidentTexture** ppTextures, uint32_t usedMask)
+{
+	for (uint32_t i = 0; i < 4; ++i)
+	{
+		if (usedMask & (1u << i))
+			markResidentTextureUsed(pManager, ppTextures[i]);
+	}
+	return updateResidencyManager(pManager);
+}
+
+/// Lets the queued reloads complete and swaps them in with usage between the restore and target fractions
+static bool settleResidencyTestFrame(NullTestContext* pContext, ResidencyManager* pManager, ResidentTexture** ppTextures, uint32_t usedMask)
+{
+	waitForAllResourceLoads();
+	setResidencyTestBudget(pContext->pRenderer, 0.7);
+	return updateResidencyTestFrame(pManager, ppTextures, usedMask);
+}
+
+TEST_CASE(NullDriverResidencyDropsAndRestoresMips)
+{
+	NullTestContext context;
+	TEST_CHECK(initNullTestContext(&context));
+	if (!context.pRenderer)
+		return;
+
+	initResourceLoaderInterface(context.pRenderer);
+	for (uint32_t i = 0; i < 4; ++i)
+		TEST_CHECK(writeMippedTestTexture(gResidencyTestTextureNames[i], gResidencyTestTextureSize));
+
+	ResidencyManagerDesc desc = {};
+	desc.mTargetBudgetFraction = 0.9f;
+	desc.mRestoreBudgetFraction = 0.5f;
+	desc.mFrameCount = 2;
+	desc.mMinUnusedFrames = 4;
+	desc.mMipsPerStep = 1;
+	desc.mMinResidentDimension = 32;
+	desc.mMaxRequestsPerUpdate = 16;
+	ResidencyManager* pManager = NULL;
+	addResidencyManager(context.pRenderer, &desc, &pManager);
+
+	// Priority follows the index, 2 and 3 are used every frame
+	ResidentTexture* pTextures[4] = {};
+	SyncToken        token = {};
+	for (uint32_t i = 0; i < 4; ++i)
+	{
+		TextureLoadDesc loadDesc = {};
+		loadDesc.pFileName = gResidencyTestTextureNames[i];
+		addResidentTexture(pManager, &loadDesc, i, &pTextures[i], &token);
+	}
+	waitForToken(&token);
+
+	// Plenty of memory, nothing to do
+	nullDriverSetMemoryBudget(0);
+	for (uint32_t f = 0; f <= desc.mMinUnusedFrames; ++f)
+		TEST_CHECK(!updateResidencyTestFrame(pManager, pTextures, 0xC));
+
+	ResidencyStats stats = {};
+	getResidencyStats(pManager, &stats);
+	TEST_CHECK(4 == stats.mTextureCount);
+	TEST_CHECK(0 == stats.mDemotedTextureCount);
+	TEST_CHECK(stats.mTextureBytes && stats.mTextureBytes == stats.mFullResolutionBytes);
+	for (uint32_t i = 0; i < 4; ++i)
+		TEST_CHECK(getResidentTexture(pTextures[i])->mWidth == gResidencyTestTextureSize);
+
+	// Over the target, under the budget: unused textures lose one mip, lowest priority first
+	setResidencyTestBudget(context.pRenderer, 0.99);
+	TEST_CHECK(!updateResidencyTestFrame(pManager, pTextures, 0xC));
+	getResidencyStats(pManager, &stats);
+	TEST_CHECK(stats.mDemotionCount >= 1 && stats.mDemotionCount <= 2);
+	TEST_CHECK(0 == stats.mEvictionCount);
+	TEST_CHECK(stats.mPendingCount == stats.mDemotionCount);
+
+	TEST_CHECK(settleResidencyTestFrame(&context, pManager, pTextures, 0xC));
+	getResidencyStats(pManager, &stats);
+	TEST_CHECK(0 == stats.mPendingCount);
+	TEST_CHECK(stats.mDemotedTextureCount == stats.mDemotionCount);
+	TEST_CHECK(stats.mTextureBytes < stats.mFullResolutionBytes);
+	TEST_CHECK(getResidentTexture(pTextures[0])->mWidth == gResidencyTestTextureSize / 2);
+	TEST_CHECK(getResidentTexture(pTextures[2])->mWidth == gResidencyTestTextureSize);
+	TEST_CHECK(getResidentTexture(pTextures[3])->mWidth == gResidencyTestTextureSize);
+
+	// Under the restore fraction: only demoted textures that are used again come back
+	setResidencyTestBudget(context.pRenderer, 0.25);
+	TEST_CHECK(!updateResidencyTestFrame(pManager, pTextures, 0xD));
+	getResidencyStats(pManager, &stats);
+	TEST_CHECK(1 == stats.mRestoreCount);
+	TEST_CHECK(settleResidencyTestFrame(&context, pManager, pTextures, 0xD));
+	TEST_CHECK(getResidentTexture(pTextures[0])->mWidth == gResidencyTestTextureSize);
+
+	// Over the whole budget: used textures too, straight to the minimum dimension
+	setResidencyTestBudget(context.pRenderer, 1.25);
+	TEST_CHECK(!updateResidencyTestFrame(pManager, pTextures, 0xF));
+	getResidencyStats(pManager, &stats);
+	TEST_CHECK(stats.mEvictionCount >= 1);
+	TEST_CHECK(settleResidencyTestFrame(&context, pManager, pTextures, 0xF));
+	TEST_CHECK(getResidentTexture(pTextures[0])->mWidth == desc.mMinResidentDimension);
+
+	nullDriverSetMemoryBudget(0);
+	waitForAllResourceLoads();
+	for (uint32_t i = 0; i < 4; ++i)
+		removeResidentTexture(pManager, pTextures[i]);
+	removeResidencyManager(pManager);
+	exitResourceLoaderInterface(context.pRenderer);
+	exitNullTestContext(&context);
+}
+
+#endif
@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2017-2022 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "../OS/Interfaces/IThread.h"
+#include "../OS/Core/ThreadSystem.h"
+
+#include "TestFramework.h"
+
+#include "../OS/Interfaces/IMemory.h"
+
+struct ParallelForData
+{
+	tfrg_atomic32_t* pCounts;
+	uintptr_t        mGrainSize;
+	tfrg_atomic32_t  mOversizedPieces;
+	tfrg_atomic32_t  mPieces;
+};
+
+static void countRangeTask(void* pUser, uintptr_t start, uintptr_t end)
+{
+	ParallelForData* pData = (ParallelForData*)pUser;
+	if (end - start > pData->mGrainSize)
+		tfrg_atomic32_add_relaxed(&pData->mOversizedPieces, 1);
+	tfrg_atomic32_add_relaxed(&pData->mPieces, 1);
+	for (uintptr_t i = start; i < end; ++i)
+		tfrg_atomic32_add_relaxed(&pData->pCounts[i], 1);
+}
+
+static bool everyIndexRanOnce(const ParallelForData* pData, uintptr_t start, uintptr_t end, uintptr_t count)
+{
+	for (uintptr_t i = 0; i < count; ++i)
+	{
+		if (pData->pCounts[i] != (i >= start && i < end ? 1 : 0))
+			return false;
+	}
+	return true;
+}
+
+TEST_CASE(ParallelForCoversRangeWithinGrainSize)
+{
+	ThreadSystem* pThreadSystem = NULL;
+	initThreadSystem(&pThreadSystem);
+
+	const uintptr_t count = 100000;
+	const uintptr_t grainSizes[] = { 1, 7, 64, 1000, count * 2 };
+	for (uint32_t g = 0; g < sizeof(grainSizes) / sizeof(grainSizes[0]); ++g)
+	{
+		ParallelForData data = {};
+		data.pCounts = (tfrg_atomic32_t*)tf_calloc(count, sizeof(tfrg_atomic32_t));
+		data.mGrainSize = grainSizes[g];
+
+		// Offset range so splitting can't rely on starting at zero
+		const uintptr_t start = 13;
+		const uintptr_t end = count - 29;
+		ThreadCounter   counter;
+		initThreadCounter(&counter, 0);
+		addThreadSystemParallelForTask(pThreadSystem, countRangeTask, &data, start, end, data.mGrainSize, &counter);
+		waitThreadCounter(pThreadSystem, &counter);
+
+		TEST_CHECK(isThreadCounterDone(&counter));
+		TEST_CHECK(everyIndexRanOnce(&data, start, end, count));
+		TEST_CHECK(data.mOversizedPieces == 0);
+		// Halving never produces pieces smaller than half a grain, so there can't be more than twice the minimum count
+		TEST_CHECK((uintptr_t)data.mPieces <= 2 * ((end - start + data.mGrainSize - 1) / data.mGrainSize));
+
+		tf_free((void*)data.pCounts);
+	}
+
+	exitThreadSystem(pThreadSystem);
+}
+
+TEST_CASE(ParallelForDefaultGrainAndEmptyRange)
+{
+	ThreadSystem* pThreadSystem = NULL;
+	initThreadSystem(&pThreadSystem);
+
+	const uintptr_t count = 4096;
+	ParallelForData data = {};
+	data.pCounts = (tfrg_atomic32_t*)tf_calloc(count, sizeof(tfrg_atomic32_t));
+	data.mGrainSize = count;
+
+	// Empty range queues nothing and leaves the counter untouched
+	ThreadCounter counter;
+	initThreadCounter(&counter, 0);
+	addThreadSystemParallelForTask(pThreadSystem, countRangeTask, &data, 10, 10, 0, &counter);
+	TEST_CHECK(isThreadCounterDone(&counter));
+	TEST_CHECK(isThreadSystemIdle(pThreadSystem));
+
+	addThreadSystemParallelForTask(pThreadSystem, countRangeTask, &data, 0, count, 0, &counter);
+	waitThreadCounter(pThreadSystem, &counter);
+	TEST_CHECK(everyIndexRanOnce(&data, 0, count, count));
+	// The default grain splits into several pieces whenever there is more than one thread to run them
+	TEST_CHECK(data.mPieces > 1);
+
+	tf_free((void*)data.pCounts);
+	exitThreadSystem(pThreadSystem);
+}
+
+struct NestedData
+{
+	ThreadSystem*   pThreadSystem;
+	ParallelForData mInner;
+	uintptr_t       mInnerCount;
+};
+
+// Every outer piece runs its own parallel for and waits on it from inside the worker
+static void nestedOuterTask(void* pUser, uintptr_t start, uintptr_t end)
+{
+	NestedData* pData = (NestedData*)pUser;
+	for (uintptr_t i = start; i < end; ++i)
+	{
+		ThreadCounter counter;
+		initThreadCounter(&counter, 0);
+		addThreadSystemParallelForTask(
+			pData->pThreadSystem, countRangeTask, &pData->mInner, i * pData->mInnerCount, (i + 1) * pData->mInnerCount,
+			pData->mInner.mGrainSize, &counter);
+		waitThreadCounter(pData->pThreadSystem, &counter);
+	}
+}
+
+TEST_CASE(ParallelForWaitFromInsideTask)
+{
+	ThreadSystem* pThreadSystem = NULL;
+	initThreadSystem(&pThreadSystem);
+
+	const uintptr_t outerCount = 64;
+	NestedData      data = {};
+	data.pThreadSystem = pThreadSystem;
+	data.mInnerCount = 1000;
+	data.mInner.mGrainSize = 32;
+	data.mInner.pCounts = (tfrg_atomic32_t*)tf_calloc(outerCount * data.mInnerCount, sizeof(tfrg_atomic32_t));
+
+	// More blocking waits than workers, only completes if waiting tasks execute queued work
+	ThreadCounter counter;
+	initThreadCounter(&counter, 0);
+	addThreadSystemParallelForTask(pThreadSystem, nestedOuterTask, &data, 0, outerCount, 1, &counter);
+	waitThreadCounter(pThreadSystem, &counter);
+
+	TEST_CHECK(everyIndexRanOnce(&data.mInner, 0, outerCount * data.mInnerCount, outerCount * data.mInnerCount));
+
+	tf_free((void*)data.mInner.pCounts);
+	exitThreadSystem(pThreadSystem);
+}
+
+/************************************************************************/
+// Benchmark
+/************************************************************************/
+struct BenchData
+{
+	float*   pValues;
+	uint32_t mIterations;
+};
+
+static inline void benchElement(BenchData* pData, uintptr_t i)
+{
+	float value = pData->pValues[i];
+	for (uint32_t j = 0; j < pData->mIterations; ++j)
+		value = value * 0.999f + 0.5f;
+	pData->pValues[i] = value;
+}
+
+static void benchRangeTask(void* pUser, uintptr_t start, uintptr_t end)
+{
+	for (uintptr_t i = start; i < end; ++i)
+		benchElement((BenchData*)pUser, i);
+}
+
+static void benchIndexTask(void* pUser, uintptr_t index) { benchElement((BenchData*)pUser, index); }
+
+// Parallel for against queueing one task per index, for cheap and for heavier elements
+BENCHMARK_CASE(ParallelForThroughput)
+{
+	ThreadSystem* pThreadSystem = NULL;
+	initThreadSystem(&pThreadSystem, MAX_SYSTEM_THREADS);
+
+	const uint32_t count = 1 << 20;
+	BenchData      data = { (float*)tf_calloc(count, sizeof(float)), 0 };
+	const uint32_t iterations[] = { 4, 64 };
+
+	for (uint32_t w = 0; w < sizeof(iterations) / sizeof(iterations[0]); ++w)
+	{
+		data.mIterations = iterations[w];
+		HiresTimer timer;
+		initHiresTimer(&timer);
+
+		ThreadCounter counter;
+		initThreadCounter(&counter, 0);
+		addThreadSystemParallelForTask(pThreadSystem, benchRangeTask, &data, 0, count, 0, &counter);
+		waitThreadCounter(pThreadSystem, &counter);
+		const double parallelForSeconds = getTestSeconds(&timer, true);
+
+		for (uint32_t i = 0; i < count; ++i)
+			addThreadSystemTask(pThreadSystem, benchIndexTask, &data, i);
+		waitThreadSystemIdle(pThreadSystem);
+		const double perIndexSeconds = getTestSeconds(&timer, true);
+
+		char name[64];
+		snprintf(name, sizeof(name), "parallel for, %u iterations", data.mIterations);
+		reportBenchmarkResult(name, count / parallelForSeconds, "elements/s");
+		snprintf(name, sizeof(name), "task per index, %u iterations", data.mIterations);
+		reportBenchmarkResult(name, count / perIndexSeconds, "elements/s");
+	}
+
+	tf_free(data.pValues);
+	exitThreadSystem(pThreadSystem);
+}
@@ -0,0 +1,488 @@
+/*
+ * Copyright (c) 2017-2022 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Drives the cpu profiler with synthetic frames and reads back what it wrote to the log directory.
+
+#include "../OS/Interfaces/IProfiler.h"
+
+#if defined(ENABLE_PROFILER)
+
+#include "../OS/Interfaces/IFileSystem.h"
+#include "../OS/Interfaces/ITime.h"
+#include "../OS/Profiler/ProfilerBase.h"
+
+#include "TestFramework.h"
+
+#include "../OS/Interfaces/IMemory.h"
+
+static void spinProfileTest(float ms)
+{
+	HiresTimer timer;
+	initHiresTimer(&timer);
+	while (getTestSeconds(&timer, false) * 1000.0 < ms)
+	{
+	}
+}
+
+/// One frame with a "Steady" scope and, if slowMs is not zero, a "Slow" scope after it
+static void profileTestFrame(float steadyMs, float slowMs)
+{
+	{
+		PROFILER_SET_CPU_SCOPE("ProfilerTests", "Steady", 0xff40a040);
+		spinProfileTest(steadyMs);
+	}
+	if (slowMs > 0.0f)
+	{
+		PROFILER_SET_CPU_SCOPE("ProfilerTests", "Slow", 0xffa04040);
+		spinProfileTest(slowMs);
+	}
+	flipProfiler();
+}
+
+/// Frames are recorded PROFILE_GPU_FRAME_DELAY + 1 flips after they ended
+static void flushProfileTestFrames()
+{
+	for (uint32_t i = 0; i <= PROFILE_GPU_FRAME_DELAY; ++i)
+		profileTestFrame(0.0f, 0.0f);
+}
+
+/// Whole file as a zero terminated string, NULL if it can not be read
+static char* readProfileTestFile(const char* pFileName)
+{
+	FileStream stream = {};
+	if (!fsOpenStreamFromPath(RD_LOG, pFileName, FM_READ, NULL, &stream))
+		return NULL;
+	const ssize_t size = max(fsGetStreamFileSize(&stream), (ssize_t)0);
+	char*         pData = (char*)tf_malloc(size + 1);
+	pData[fsReadFromStream(&stream, pData, size)] = '\0';
+	fsCloseStream(&stream);
+	return pData;
+}
+
+static uint32_t countProfileTestMatches(const char* pData, const char* pPattern)
+{
+	uint32_t count = 0;
+	for (const char* p = strstr(pData, pPattern); p; p = strstr(p + 1, pPattern))
+		++count;
+	return count;
+}
+
+static inline bool isJsonDigit(char c) { return c >= '0' && c <= '9'; }
+static inline bool isJsonHexDigit(char c) { return isJsonDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F'); }
+
+static const char* skipJsonSpace(const char* p)
+{
+	while (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')
+		++p;
+	return p;
+}
+
+/// Returns the end of the json value starting at p, NULL if it is not valid
+static const char* parseJsonValue(const char* p, uint32_t depth)
+{
+	p = skipJsonSpace(p);
+	if (depth > 64)
+		return NULL;
+
+	if (*p == '{' || *p == '[')
+	{
+		const bool object = *p == '{';
+		const char close = object ? '}' : ']';
+		p = skipJsonSpace(p + 1);
+		if (*p == close)
+			return p + 1;
+		for (;;)
+		{
+			if (object)
+			{
+				p = skipJsonSpace(p);
+				if (*p != '"' || !(p = parseJsonValue(p, depth + 1)))
+					return NULL;
+				p = skipJsonSpace(p);
+				if (*p++ != ':')
+					return NULL;
+			}
+			if (!(p = parseJsonValue(p, depth + 1)))
+				return NULL;
+			p = skipJsonSpace(p);
+			if (*p == close)
+				return p + 1;
+			if (*p++ != ',')
+				return NULL;
+		}
+	}
+
+	if (*p == '"')
+	{
+		for (++p; *p != '"'; ++p)
+		{
+			if ((unsigned char)*p < 0x20)
+				return NULL;
+			if (*p != '\\')
+				continue;
+			++p;
+			if (*p == 'u')
+			{
+				for (uint32_t i = 1; i <= 4; ++i)
+				{
+					if (!isJsonHexDigit(p[i]))
+						return NULL;
+				}
+				p += 4;
+			}
+			else if (!*p || !strchr("\"\\/bfnrt", *p))
+			{
+				return NULL;
+			}
+		}
+		return p + 1;
+	}
+
+	if (!strncmp(p, "true", 4) || !strncmp(p, "null", 4))
+		return p + 4;
+	if (!strncmp(p, "false", 5))
+		return p + 5;
+
+	if (*p == '-')
+		++p;
+	if (!isJsonDigit(*p))
+		return NULL;
+	while (isJsonDigit(*p))
+		++p;
+	if (*p == '.')
+	{
+		if (!isJsonDigit(*++p))
+			return NULL;
+		while (isJsonDigit(*p))
+			++p;
+	}
+	if (*p == 'e' || *p == 'E')
+	{
+		if (*++p == '+' || *p == '-')
+			++p;
+		if (!isJsonDigit(*p))
+			return NULL;
+		while (isJsonDigit(*p))
+			++p;
+	}
+	return p;
+}
+
+static bool isValidJson(const char* pData)
+{
+	const char* pEnd = parseJsonValue(pData, 0);
+	return pEnd && !*skipJsonSpace(pEnd);
+}
+
+TEST_CASE(ProfilerCaptureRoundTrip)
+{
+	const char* pFileName = "ProfilerTestCapture.bin";
+	ProfileSetEnableAllGroups(true);
+	flipProfiler();
+
+	// Two slow frames six frames apart among steady ones
+	startProfileCapture(pFileName);
+	for (uint32_t i = 0; i < 16; ++i)
+		profileTestFrame(1.0f, i == 5 ? 30.0f : i == 11 ? 15.0f : 0.0f);
+	flushProfileTestFrames();
+	stopProfileCapture();
+
+	ProfileCaptureFrame frames[4] = {};
+	TEST_CHECK(4 == getProfileCaptureWorstFrames(pFileName, frames, 4));
+
+	// Slowest first, the slow scope is what made them slow
+	for (uint32_t i = 1; i < 4; ++i)
+		TEST_CHECK(frames[i - 1].mCpuMs >= frames[i].mCpuMs);
+	TEST_CHECK(frames[0].mCpuMs >= 30.0f);
+	TEST_CHECK(frames[1].mCpuMs >= 15.0f && frames[1].mCpuMs < frames[0].mCpuMs);
+	TEST_CHECK(6 == frames[1].mFrameIndex - frames[0].mFrameIndex);
+	for (uint32_t i = 0; i < 2; ++i)
+	{
+		TEST_CHECK(!strcmp(frames[i].mLongestScope, "Slow"));
+		TEST_CHECK(frames[i].mLongestScopeMs <= frames[i].mCpuMs);
+	}
+	TEST_CHECK(frames[0].mLongestScopeMs >= 30.0f);
+	TEST_CHECK(frames[1].mLongestScopeMs >= 15.0f && frames[1].mLongestScopeMs < 30.0f);
+	TEST_CHECK(frames[2].mCpuMs < 15.0f);
+
+	// Missing captures read as empty
+	TEST_CHECK(0 == getProfileCaptureWorstFrames("ProfilerTestMissing.bin", frames, 4));
+}
+
+TEST_CASE(ProfilerTraceWritesValidJson)
+{
+	const char* pFileName = "ProfilerTestTrace.json";
+	ProfileSetEnableAllGroups(true);
+	flipProfiler();
+
+	startProfileTrace("ProfilerTests", pFileName);
+	TEST_CHECK(isProfileTraceActive());
+	// Scopes spanning frame boundaries, names that need escaping
+	for (uint32_t i = 0; i < 8; ++i)
+	{
+		PROFILER_SET_CPU_SCOPE("ProfilerTests", "Quote\"Back\\slash", 0xff4040a0);
+		profileTestFrame(0.1f, 0.0f);
+	}
+	flushProfileTestFrames();
+	{
+		// Still open when the trace stops, closed by the trace
+		PROFILER_SET_CPU_SCOPE("ProfilerTests", "Open", 0xff4040a0);
+		flushProfileTestFrames();
+		stopProfileTrace();
+	}
+	TEST_CHECK(!isProfileTraceActive());
+
+	char* pTrace = readProfileTestFile(pFileName);
+	TEST_CHECK(pTrace);
+	if (!pTrace)
+		return;
+
+	TEST_CHECK(isValidJson(pTrace));
+	const uint32_t beginCount = countProfileTestMatches(pTrace, "\"ph\":\"B\"");
+	TEST_CHECK(beginCount > 0);
+	TEST_CHECK(beginCount == countProfileTestMatches(pTrace, "\"ph\":\"E\""));
+	TEST_CHECK(countProfileTestMatches(pTrace, "\"ph\":\"X\"") > 0);
+	TEST_CHECK(countProfileTestMatches(pTrace, "\"name\":\"Quote\\\"Back\\\\slash\"") >= 7);
+	TEST_CHECK(1 == countProfileTestMatches(pTrace, "\"name\":\"Open\""));
+	tf_free(pTrace);
+}
+
+/// First trace end event after p, NULL if there is none
+static const char* findProfileTestEnd(const char* p) { return p ? strstr(p, "\"ph\":\"E\"") : NULL; }
+
+static bool profileTestLineHas(const char* pLine, const char* pPattern)
+{
+	const char* pEndOfLine = strchr(pLine, '\n');
+	const char* pFound = strstr(pLine, pPattern);
+	return pFound && (!pEndOfLine || pFound < pEndOfLine);
+}
+
+TEST_CASE(ProfilerChargesAllocationsToInnermostScope)
+{
+	const char* pFileName = "ProfilerTestAllocations.json";
+	ProfileSetEnableAllGroups(true);
+	ProfileInitAllocationCounters();
+	flipProfiler();
+
+	startProfileTrace("ProfilerTests", pFileName);
+	profileTestFrame(0.0f, 0.0f);
+	{
+		PROFILER_SET_CPU_SCOPE("ProfilerTests", "AllocOuter", 0xff4040a0);
+		void* pOuter[4] = {};
+		for (uint32_t i = 0; i < 3; ++i)
+			pOuter[i] = tf_malloc(80);
+		{
+			PROFILER_SET_CPU_SCOPE("ProfilerTests", "AllocInner", 0xff4040a0);
+			void* pInner = tf_malloc(1000);
+			tf_free(pInner);
+		}
+		pOuter[3] = tf_malloc(48);
+		// Frees are not counted
+		for (uint32_t i = 0; i < 4; ++i)
+			tf_free(pOuter[i]);
+	}
+	flushProfileTestFrames();
+	stopProfileTrace();
+
+	char* pTrace = readProfileTestFile(pFileName);
+	TEST_CHECK(pTrace);
+	if (!pTrace)
+		return;
+
+	// The outer scope only has what was allocated outside of the inner one
+	const char* pInnerEnd = findProfileTestEnd(strstr(pTrace, "\"name\":\"AllocInner\""));
+	const char* pOuterEnd = findProfileTestEnd(pInnerEnd ? pInnerEnd + 1 : NULL);
+	TEST_CHECK(pInnerEnd && profileTestLineHas(pInnerEnd, "\"args\":{\"alloc_bytes\":1000,\"alloc_count\":1}"));
+	TEST_CHECK(pOuterEnd && profileTestLineHas(pOuterEnd, "\"args\":{\"alloc_bytes\":288,\"alloc_count\":4}"));
+	tf_free(pTrace);
+}
+
+typedef struct HitchTestState
+{
+	uint32_t     mCount;
+	ProfileHitch mHitch;
+	char         mSummaryFileName[256];
+} HitchTestState;
+
+static void onProfileTestHitch(const ProfileHitch* pHitch, void* pUserData)
+{
+	HitchTestState* pState = (HitchTestState*)pUserData;
+	++pState->mCount;
+	pState->mHitch = *pHitch;
+	pState->mHitch.pTimelineFileName = NULL;
+	pState->mHitch.pSummaryFileName = NULL;
+	strncpy(pState->mSummaryFileName, pHitch->pSummaryFileName ? pHitch->pSummaryFileName : "", sizeof(pState->mSummaryFileName) - 1);
+}
+
+/// A slow frame followed by enough steady ones to dump it and leave the frames suppressed after the dump
+static void profileTestHitchFrames(float slowMs)
+{
+	profileTestFrame(1.0f, slowMs);
+	for (uint32_t i = 0; i < 12; ++i)
+		profileTestFrame(1.0f, 0.0f);
+}
+
+TEST_CASE(ProfilerHitchFiresOnFixedThreshold)
+{
+	ProfileSetEnableAllGroups(true);
+	flipProfiler();
+	// Frames recorded from here on are steady
+	flushProfileTestFrames();
+
+	HitchTestState   state = {};
+	ProfileHitchDesc desc;
+	desc.mCpuThresholdMs = 20.0f;
+	desc.mPercentile = 0.0f;
+	desc.mFramesBefore = 4;
+	desc.mFramesAfter = 2;
+	desc.mMinDumpIntervalSec = 0.5f;
+	desc.pAppName = "ProfilerTest";
+	desc.pCallback = onProfileTestHitch;
+	desc.pUserData = &state;
+	setProfileHitchDetection(&desc);
+
+	for (uint32_t i = 0; i < 4; ++i)
+		profileTestFrame(1.0f, 0.0f);
+	TEST_CHECK(0 == state.mCount);
+
+	profileTestHitchFrames(30.0f);
+	TEST_CHECK(1 == state.mCount);
+	TEST_CHECK(state.mHitch.mCpuMs >= 30.0f);
+	TEST_CHECK(20.0f == state.mHitch.mCpuThresholdMs);
+	TEST_CHECK(0.0f == state.mHitch.mGpuThresholdMs);
+	TEST_CHECK(0 == state.mHitch.mRateLimitedCount);
+
+	char* pSummary = readProfileTestFile(state.mSummaryFileName);
+	TEST_CHECK(pSummary);
+	if (pSummary)
+	{
+		char frame[64];
+		snprintf(frame, sizeof(frame), "\"Frame\": %u,", state.mHitch.mFrameIndex);
+		TEST_CHECK(isValidJson(pSummary));
+		TEST_CHECK(strstr(pSummary, frame) != NULL);
+		tf_free(pSummary);
+	}
+
+	// Within mMinDumpIntervalSec of the dump, only counted
+	const uint32_t firstFrameIndex = state.mHitch.mFrameIndex;
+	profileTestHitchFrames(30.0f);
+	TEST_CHECK(1 == state.mCount);
+
+	// Long enough to be past the interval when it is detected, reports the skipped one
+	profileTestHitchFrames(600.0f);
+	TEST_CHECK(2 == state.mCount);
+	TEST_CHECK(state.mHitch.mCpuMs >= 600.0f);
+	TEST_CHECK(1 == state.mHitch.mRateLimitedCount);
+	TEST_CHECK(26 == state.mHitch.mFrameIndex - firstFrameIndex);
+
+	setProfileHitchDetection(NULL);
+	profileTestHitchFrames(30.0f);
+	TEST_CHECK(2 == state.mCount);
+}
+
+typedef struct BenchmarkTestTimer
+{
+	const char* pGroup;
+	const char* pName;
+	const char* pType;
+	float       mMean;
+	float       mP50;
+	float       mP90;
+	float       mP99;
+} BenchmarkTestTimer;
+
+/// Same layout as the reports startBenchmark writes, one line per timer
+static bool writeBenchmarkTestReport(const char* pFileName, const BenchmarkTestTimer* pTimers, uint32_t timerCount)
+{
+	FileStream stream = {};
+	if (!fsOpenStreamFromPath(RD_LOG, pFileName, FM_WRITE, NULL, &stream))
+		return false;
+
+	char line[512];
+	int  length = snprintf(line, sizeof(line), "{\n\"Application\": \"ProfilerTests\",\n\"WarmupFrames\": 0,\n\"Frames\": 100,\n\"Timers\": [");
+	bool success = fsWriteToStream(&stream, line, length) == (size_t)length;
+	for (uint32_t i = 0; i < timerCount && success; ++i)
+	{
+		const BenchmarkTestTimer* pTimer = &pTimers[i];
+		length = snprintf(
+			line, sizeof(line),
+			"%s{ \"Group\": \"%s\", \"Name\": \"%s\", \"Type\": \"%s\", \"Frames\": 100, \"Mean\": %.4f, \"StdDev\": 0.0000, "
+			"\"Min\": %.4f, \"Max\": %.4f, \"P50\": %.4f, \"P90\": %.4f, \"P99\": %.4f, \"P999\": %.4f, \"HistogramMin\": %.4f, "
+			"\"HistogramBucketWidth\": 0.0000, \"Histogram\": [100] }",
+			i ? ",\n" : "\n", pTimer->pGroup, pTimer->pName, pTimer->pType, pTimer->mMean, pTimer->mP50, pTimer->mP99, pTimer->mP50,
+			pTimer->mP90, pTimer->mP99, pTimer->mP99, pTimer->mP50);
+		success = fsWriteToStream(&stream, line, length) == (size_t)length;
+	}
+	length = snprintf(line, sizeof(line), "\n]\n}\n");
+	success = success && fsWriteToStream(&stream, line, length) == (size_t)length;
+	fsCloseStream(&stream);
+	return success;
+}
+
+TEST_CASE(ProfilerComparesBenchmarkReports)
+{
+	const char* pBaselineFileName = "ProfilerTestBaseline.json";
+	const char* pFileName = "ProfilerTestBenchmark.json";
+
+	const BenchmarkTestTimer baseline[] = {
+		{ "Frame", "Cpu", "Frame", 10.0f, 10.0f, 11.0f, 12.0f },
+		{ "Render", "Shadows", "Cpu", 2.0f, 2.0f, 2.2f, 2.4f },
+		{ "Render", "Shadows", "Gpu", 3.0f, 3.0f, 3.3f, 3.6f },
+		{ "Render", "Post", "Gpu", 1.0f, 1.0f, 1.1f, 1.2f },
+		{ "Render", "Tiny", "Cpu", 0.01f, 0.01f, 0.01f, 0.01f },
+	};
+	const BenchmarkTestTimer current[] = {
+		// Within the tolerance
+		{ "Frame", "Cpu", "Frame", 10.2f, 10.2f, 11.2f, 12.2f },
+		// Only the tail regressed, same name as the gpu timer
+		{ "Render", "Shadows", "Cpu", 2.0f, 2.0f, 2.2f, 3.6f },
+		// Faster
+		{ "Render", "Shadows", "Gpu", 2.0f, 2.0f, 2.2f, 2.4f },
+		// Every statistic regressed
+		{ "Render", "Post", "Gpu", 1.5f, 1.5f, 1.6f, 1.8f },
+		// Below mMinTimeMs in the baseline
+		{ "Render", "Tiny", "Cpu", 1.0f, 1.0f, 1.0f, 1.0f },
+		// Not in the baseline
+		{ "Render", "New", "Cpu", 5.0f, 5.0f, 5.0f, 5.0f },
+	};
+	TEST_CHECK(writeBenchmarkTestReport(pBaselineFileName, baseline, sizeof(baseline) / sizeof(baseline[0])));
+	TEST_CHECK(writeBenchmarkTestReport(pFileName, current, sizeof(current) / sizeof(current[0])));
+
+	BenchmarkCompareDesc desc;
+	TEST_CHECK(2 == compareBenchmarkReports(pBaselineFileName, pFileName, &desc));
+	TEST_CHECK(0 == compareBenchmarkReports(pBaselineFileName, pBaselineFileName, &desc));
+	// The other way around only the faster gpu timer regressed
+	TEST_CHECK(1 == compareBenchmarkReports(pFileName, pBaselineFileName, &desc));
+
+	// Tolerance and minimum time
+	desc.mTolerance = 0.6f;
+	TEST_CHECK(0 == compareBenchmarkReports(pBaselineFileName, pFileName, &desc));
+	desc.mTolerance = 0.05f;
+	desc.mMinTimeMs = 0.001f;
+	TEST_CHECK(3 == compareBenchmarkReports(pBaselineFileName, pFileName, &desc));
+
+	TEST_CHECK(UINT32_MAX == compareBenchmarkReports("ProfilerTestMissing.json", pFileName, &desc));
+}
+
+#endif
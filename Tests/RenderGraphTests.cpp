@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2017-2022 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Compiles render graphs on the null driver and checks what was derived, only built in the Null configuration.
+
+#include "../Renderer/Include/IRenderer.h"
+
+#if defined(NULL_RENDERER)
+
+#include "../Renderer/Include/IRenderGraph.h"
+
+#include "TestFramework.h"
+
+#include "../OS/Interfaces/IMemory.h"
+
+static void executeNothing(Cmd*, const RenderGraph*, void*) {}
+
+static RenderTargetDesc getGraphTestTargetDesc()
+{
+	RenderTargetDesc desc = {};
+	desc.mArraySize = 1;
+	desc.mDepth = 1;
+	desc.mFormat = TinyImageFormat_R8G8B8A8_UNORM;
+	desc.mStartState = RESOURCE_STATE_RENDER_TARGET;
+	desc.mWidth = 1920;
+	desc.mHeight = 1080;
+	desc.mSampleCount = SAMPLE_COUNT_1;
+	return desc;
+}
+
+/// Chain of three transients A -> B -> C -> output. A and C have disjoint lifetimes and share memory
+static void declareGraphTestChain(RenderGraph* pGraph, RenderTarget* pOutput)
+{
+	const RenderTargetDesc    desc = getGraphTestTargetDesc();
+	const RenderGraphResource a = renderGraphAddRenderTarget(pGraph, "A", &desc);
+	const RenderGraphResource b = renderGraphAddRenderTarget(pGraph, "B", &desc);
+	const RenderGraphResource c = renderGraphAddRenderTarget(pGraph, "C", &desc);
+	const RenderGraphResource output =
+		renderGraphImportRenderTarget(pGraph, "Output", pOutput, RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_SHADER_RESOURCE);
+
+	RenderGraphPass* pPass = renderGraphAddPass(pGraph, "WriteA", RENDER_GRAPH_PASS_GRAPHICS, executeNothing, NULL);
+	renderGraphPassWriteColor(pPass, a, LOAD_ACTION_CLEAR);
+	pPass = renderGraphAddPass(pGraph, "AToB", RENDER_GRAPH_PASS_GRAPHICS, executeNothing, NULL);
+	renderGraphPassRead(pPass, a, RESOURCE_STATE_SHADER_RESOURCE);
+	renderGraphPassWriteColor(pPass, b, LOAD_ACTION_DONTCARE);
+	pPass = renderGraphAddPass(pGraph, "BToC", RENDER_GRAPH_PASS_GRAPHICS, executeNothing, NULL);
+	renderGraphPassRead(pPass, b, RESOURCE_STATE_SHADER_RESOURCE);
+	renderGraphPassWriteColor(pPass, c, LOAD_ACTION_DONTCARE);
+	pPass = renderGraphAddPass(pGraph, "CToOutput", RENDER_GRAPH_PASS_GRAPHICS, executeNothing, NULL);
+	renderGraphPassRead(pPass, c, RESOURCE_STATE_SHADER_RESOURCE);
+	renderGraphPassWriteColor(pPass, output, LOAD_ACTION_DONTCARE);
+	// Never read, culled
+	pPass = renderGraphAddPass(pGraph, "Unused", RENDER_GRAPH_PASS_GRAPHICS, executeNothing, NULL);
+	renderGraphPassWriteColor(pPass, b, LOAD_ACTION_LOAD);
+}
+
+TEST_CASE(RenderGraphAliasesTransients)
+{
+	RendererDesc settings = {};
+	Renderer*    pRenderer = NULL;
+	initRenderer("RenderGraphTests", &settings, &pRenderer);
+	TEST_CHECK(pRenderer);
+	if (!pRenderer)
+		return;
+
+	const RenderTargetDesc desc = getGraphTestTargetDesc();
+	RenderTarget*          pOutput = NULL;
+	vk_addRenderTarget(pRenderer, &desc, &pOutput);
+
+	RenderGraph* pGraph = NULL;
+	addRenderGraph(pRenderer, NULL, &pGraph);
+	declareGraphTestChain(pGraph, pOutput);
+	TEST_CHECK(compileRenderGraph(pGraph));
+
+	RenderGraphStats stats = {};
+	getRenderGraphStats(pGraph, &stats);
+	TEST_CHECK(5 == stats.mPassCount);
+	TEST_CHECK(1 == stats.mCulledPassCount);
+	TEST_CHECK(3 == stats.mTransientCount);
+	TEST_CHECK(1 == stats.mHeapCount);
+	TEST_CHECK(stats.mTransientMemory * 3 == stats.mTransientMemoryUnaliased * 2);
+	// C takes the memory over from A, and A from C of the previous frame
+	TEST_CHECK(2 == stats.mAliasingBarrierCount);
+	TEST_CHECK(renderGraphGetRenderTarget(pGraph, 0) != renderGraphGetRenderTarget(pGraph, 2));
+	removeRenderGraph(pGraph);
+
+	RenderGraphDesc graphDesc = {};
+	graphDesc.mDisableAliasing = true;
+	addRenderGraph(pRenderer, &graphDesc, &pGraph);
+	declareGraphTestChain(pGraph, pOutput);
+	TEST_CHECK(compileRenderGraph(pGraph));
+
+	getRenderGraphStats(pGraph, &stats);
+	TEST_CHECK(0 == stats.mHeapCount);
+	TEST_CHECK(stats.mTransientMemory == stats.mTransientMemoryUnaliased);
+	TEST_CHECK(0 == stats.mAliasingBarrierCount);
+	removeRenderGraph(pGraph);
+
+	vk_removeRenderTarget(pRenderer, pOutput);
+	exitRenderer(pRenderer);
+}
+
+TEST_CASE(RenderGraphRejectsUnwrittenTransient)
+{
+	RendererDesc settings = {};
+	Renderer*    pRenderer = NULL;
+	initRenderer("RenderGraphTests", &settings, &pRenderer);
+	TEST_CHECK(pRenderer);
+	if (!pRenderer)
+		return;
+
+	RenderGraph* pGraph = NULL;
+	addRenderGraph(pRenderer, NULL, &pGraph);
+	const RenderTargetDesc    desc = getGraphTestTargetDesc();
+	const RenderGraphResource transient = renderGraphAddRenderTarget(pGraph, "Transient", &desc);
+	RenderGraphPass*          pPass = renderGraphAddPass(pGraph, "Read", RENDER_GRAPH_PASS_COMPUTE, executeNothing, NULL);
+	renderGraphPassRead(pPass, transient, RESOURCE_STATE_SHADER_RESOURCE);
+	renderGraphPassSetSideEffects(pPass);
+	TEST_CHECK(!compileRenderGraph(pGraph));
+
+	removeRenderGraph(pGraph);
+	exitRenderer(pRenderer);
+}
+
+#endif
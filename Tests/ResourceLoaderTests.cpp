@@ -0,0 +1,683 @@
+/*
+ * Copyright (c) 2017-2022 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Streams buffers and textures through the resource loader on the null driver, only built in the Null configuration.
+
+#include "../Renderer/Include/IRenderer.h"
+
+#if defined(NULL_RENDERER)
+
+#include "../Renderer/Include/IResourceLoader.h"
+#include "../Renderer/Null/NullDriver.h"
+
+#include "TestFramework.h"
+
+#include "../OS/Interfaces/IMemory.h"
+
+static const char*    gTestTextureName = "ResourceLoaderTest";
+static const uint32_t gTestTextureSize = 64;
+
+static bool initResourceLoaderTest(ResourceLoaderDesc* pDesc, Renderer** ppRenderer)
+{
+	RendererDesc settings = {};
+	initRenderer("ResourceLoaderTests", &settings, ppRenderer);
+	if (!*ppRenderer)
+		return false;
+
+	initResourceLoaderInterface(*ppRenderer, pDesc);
+
+	// Drop the work submitted while creating the copy engines
+	NullDriverStats stats = {};
+	nullDriverTakeStats(&stats);
+	return true;
+}
+
+static void exitResourceLoaderTest(Renderer* pRenderer)
+{
+	exitResourceLoaderInterface(pRenderer);
+	exitRenderer(pRenderer);
+}
+
+/// Uncompressed RGBA8 dds without mips, the legacy header is all loadDDSTextureDesc needs
+static bool writeTestTexture(const char* pFileName, uint32_t size)
+{
+	uint32_t header[32] = {};
+	header[0] = 0x20534444;    // "DDS "
+	header[1] = 124;           // sizeof(DDS_HEADER)
+	header[2] = 0x100F;        // caps | height | width | pitch | pixel format
+	header[3] = size;
+	header[4] = size;
+	header[5] = size * 4;
+	header[7] = 1;
+	header[19] = 32;           // sizeof(DDS_PIXELFORMAT)
+	header[20] = 0x41;         // rgb | alpha
+	header[22] = 32;
+	header[23] = 0x000000ff;
+	header[24] = 0x0000ff00;
+	header[25] = 0x00ff0000;
+	header[26] = 0xff000000;
+	header[27] = 0x1000;       // texture
+
+	char fileName[FS_MAX_PATH] = {};
+	fsAppendPathExtension(pFileName, "dds", fileName);
+
+	FileStream stream = {};
+	if (!fsOpenStreamFromPath(RD_TEXTURES, fileName, FM_WRITE_BINARY, NULL, &stream))
+		return false;
+
+	const size_t pixelBytes = (size_t)size * size * 4;
+	uint8_t*     pPixels = (uint8_t*)tf_malloc(pixelBytes);
+	for (size_t i = 0; i < pixelBytes; ++i)
+		pPixels[i] = (uint8_t)i;
+
+	bool success = fsWriteToStream(&stream, header, sizeof(header)) == sizeof(header);
+	success = success && fsWriteToStream(&stream, pPixels, pixelBytes) == pixelBytes;
+	fsCloseStream(&stream);
+	tf_free(pPixels);
+	return success;
+}
+
+static void addTestBuffer(Buffer** ppBuffer, const void* pData, uint64_t size, ResourcePriority priority, SyncToken* pToken)
+{
+	BufferLoadDesc loadDesc = {};
+	loadDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_BUFFER;
+	loadDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_GPU_ONLY;
+	loadDesc.mDesc.mStartState = RESOURCE_STATE_SHADER_RESOURCE;
+	loadDesc.mDesc.mSize = size;
+	loadDesc.pData = pData;
+	loadDesc.ppBuffer = ppBuffer;
+	loadDesc.mPriority = priority;
+	addResource(&loadDesc, pToken);
+}
+
+static void addTestTexture(Texture** ppTexture, const char* pFileName, SyncToken* pToken)
+{
+	TextureLoadDesc loadDesc = {};
+	loadDesc.pFileName = pFileName;
+	loadDesc.ppTexture = ppTexture;
+	addResource(&loadDesc, pToken);
+}
+
+static void printTestStream(FileStream* pStream, const char* pFormat, ...)
+{
+	char    line[256] = {};
+	va_list args;
+	va_start(args, pFormat);
+	const int length = vsnprintf(line, sizeof(line), pFormat, args);
+	va_end(args);
+	fsWriteToStream(pStream, line, (size_t)length);
+}
+
+/// Mesh of primitiveCount grids with gridSize x gridSize vertices each, written as a .gltf with its .bin next to it.
+/// Every primitive has its own position, normal, texcoord and 32 bit index accessors
+static bool writeTestMesh(const char* pFileName, uint32_t primitiveCount, uint32_t gridSize)
+{
+	const uint32_t vertexCount = gridSize * gridSize;
+	const uint32_t indexCount = (gridSize - 1) * (gridSize - 1) * 6;
+	const size_t   primitiveBytes = (size_t)vertexCount * sizeof(float[8]) + (size_t)indexCount * sizeof(uint32_t);
+
+	char binName[FS_MAX_PATH] = {};
+	char gltfName[FS_MAX_PATH] = {};
+	fsAppendPathExtension(pFileName, "bin", binName);
+	fsAppendPathExtension(pFileName, "gltf", gltfName);
+
+	FileStream stream = {};
+	if (!fsOpenStreamFromPath(RD_MESHES, binName, FM_WRITE_BINARY, NULL, &stream))
+		return false;
+
+	uint8_t* pPrimitive = (uint8_t*)tf_malloc(primitiveBytes);
+	float*   pPositions = (float*)pPrimitive;
+	float*   pNormals = pPositions + vertexCount * 3;
+	float*   pTexcoords = pNormals + vertexCount * 3;
+	uint32_t* pIndices = (uint32_t*)(pTexcoords + vertexCount * 2);
+	for (uint32_t y = 0; y < gridSize; ++y)
+	{
+		for (uint32_t x = 0; x < gridSize; ++x)
+		{
+			const uint32_t v = y * gridSize + x;
+			pPositions[v * 3 + 0] = (float)x;
+			pPositions[v * 3 + 1] = (float)y;
+			pPositions[v * 3 + 2] = 0.0f;
+			pNormals[v * 3 + 0] = 0.0f;
+			pNormals[v * 3 + 1] = 0.0f;
+			pNormals[v * 3 + 2] = 1.0f;
+			pTexcoords[v * 2 + 0] = (float)x / (gridSize - 1);
+			pTexcoords[v * 2 + 1] = (float)y / (gridSize - 1);
+		}
+	}
+	// Rows of quads, far from vertex cache order so the optimizer has work to do
+	uint32_t* pIndex = pIndices;
+	for (uint32_t y = 0; y < gridSize - 1; ++y)
+	{
+		for (uint32_t x = 0; x < gridSize - 1; ++x)
+		{
+			const uint32_t v = y * gridSize + x;
+			const uint32_t quad[6] = { v, v + 1, v + gridSize, v + 1, v + gridSize + 1, v + gridSize };
+			memcpy(pIndex, quad, sizeof(quad));
+			pIndex += 6;
+		}
+	}
+
+	bool success = true;
+	for (uint32_t p = 0; p < primitiveCount; ++p)
+		success = success && fsWriteToStream(&stream, pPrimitive, primitiveBytes) == primitiveBytes;
+	fsCloseStream(&stream);
+	tf_free(pPrimitive);
+	if (!success || !fsOpenStreamFromPath(RD_MESHES, gltfName, FM_WRITE, NULL, &stream))
+		return false;
+
+	printTestStream(&stream, "{\"asset\":{\"version\":\"2.0\",\"generator\":\"ResourceLoaderTests\"},\n");
+	printTestStream(&stream, "\"buffers\":[{\"uri\":\"%s\",\"byteLength\":%zu}],\n", binName, primitiveBytes * primitiveCount);
+	printTestStream(&stream, "\"bufferViews\":[{\"buffer\":0,\"byteLength\":%zu}],\n\"accessors\":[\n", primitiveBytes * primitiveCount);
+	for (uint32_t p = 0; p < primitiveCount; ++p)
+	{
+		const size_t offset = primitiveBytes * p;
+		printTestStream(
+			&stream,
+			"{\"bufferView\":0,\"byteOffset\":%zu,\"componentType\":5126,\"count\":%u,\"type\":\"VEC3\",\"min\":[0,0,0],\"max\":[%u,%u,0]},\n",
+			offset, vertexCount, gridSize - 1, gridSize - 1);
+		printTestStream(
+			&stream, "{\"bufferView\":0,\"byteOffset\":%zu,\"componentType\":5126,\"count\":%u,\"type\":\"VEC3\"},\n",
+			offset + vertexCount * sizeof(float[3]), vertexCount);
+		printTestStream(
+			&stream, "{\"bufferView\":0,\"byteOffset\":%zu,\"componentType\":5126,\"count\":%u,\"type\":\"VEC2\"},\n",
+			offset + vertexCount * sizeof(float[6]), vertexCount);
+		printTestStream(
+			&stream, "{\"bufferView\":0,\"byteOffset\":%zu,\"componentType\":5125,\"count\":%u,\"type\":\"SCALAR\"}%s\n",
+			offset + vertexCount * sizeof(float[8]), indexCount, p + 1 < primitiveCount ? "," : "");
+	}
+	printTestStream(&stream, "],\n\"meshes\":[{\"primitives\":[\n");
+	for (uint32_t p = 0; p < primitiveCount; ++p)
+	{
+		printTestStream(
+			&stream, "{\"attributes\":{\"POSITION\":%u,\"NORMAL\":%u,\"TEXCOORD_0\":%u},\"indices\":%u}%s\n", p * 4, p * 4 + 1,
+			p * 4 + 2, p * 4 + 3, p + 1 < primitiveCount ? "," : "");
+	}
+	printTestStream(&stream, "]}]}\n");
+	fsCloseStream(&stream);
+	return true;
+}
+
+/// Position, normal and texcoord in their own bindings, all kept as float
+static void addTestGeometry(Geometry** ppGeometry, const char* pFileName, MeshOptimizerFlags optimizationFlags, SyncToken* pToken)
+{
+	VertexLayout layout = {};
+	layout.mAttribCount = 3;
+	layout.mAttribs[0] = { SEMANTIC_POSITION, 0, {}, TinyImageFormat_R32G32B32_SFLOAT, 0, 0, 0 };
+	layout.mAttribs[1] = { SEMANTIC_NORMAL, 0, {}, TinyImageFormat_R32G32B32_SFLOAT, 1, 1, 0 };
+	layout.mAttribs[2] = { SEMANTIC_TEXCOORD0, 0, {}, TinyImageFormat_R32G32_SFLOAT, 2, 2, 0 };
+
+	char fileName[FS_MAX_PATH] = {};
+	fsAppendPathExtension(pFileName, "gltf", fileName);
+
+	GeometryLoadDesc loadDesc = {};
+	loadDesc.pFileName = fileName;
+	loadDesc.ppGeometry = ppGeometry;
+	loadDesc.pVertexLayout = &layout;
+	loadDesc.mOptimizationFlags = optimizationFlags;
+	addResource(&loadDesc, pToken);
+}
+
+TEST_CASE(ResourceLoaderCompletesTokensPerClass)
+{
+	const uint32_t bufferCount = 64;
+
+	ResourceLoaderDesc desc = {};
+	desc.mBufferSize = 1ull << 20;
+	desc.mBufferCount = 2;
+	Renderer* pRenderer = NULL;
+	TEST_CHECK(initResourceLoaderTest(&desc, &pRenderer));
+	if (!pRenderer)
+		return;
+
+	uint32_t data[256] = {};
+	Buffer*  pBuffers[bufferCount] = {};
+	SyncToken normalToken = 0;
+	SyncToken highToken = 0;
+	for (uint32_t i = 0; i < bufferCount - 1; ++i)
+		addTestBuffer(&pBuffers[i], data, sizeof(data), RESOURCE_PRIORITY_NORMAL, &normalToken);
+	// Queued last but doesn't wait for the normal loads queued before it
+	addTestBuffer(&pBuffers[bufferCount - 1], data, sizeof(data), RESOURCE_PRIORITY_HIGH, &highToken);
+
+	// Merging keeps the classes of both tokens
+	const SyncToken combinedToken = combineSyncTokens(normalToken, highToken);
+	TEST_CHECK(combinedToken == combineSyncTokens(highToken, normalToken));
+	TEST_CHECK(combinedToken != normalToken && combinedToken != highToken);
+	TEST_CHECK(combineSyncTokens(combinedToken, highToken) == combinedToken);
+	TEST_CHECK(combineSyncTokens(normalToken, 0) == normalToken);
+
+	waitForToken(&highToken);
+	TEST_CHECK(isTokenCompleted(&highToken));
+	waitForToken(&combinedToken);
+	TEST_CHECK(isTokenCompleted(&normalToken));
+	TEST_CHECK(isTokenSubmitted(&combinedToken));
+	TEST_CHECK(allResourceLoadsCompleted());
+
+	// Buffer updates can be relied upon by later requests and are never cancelled
+	TEST_CHECK(!cancelResourceLoad(&normalToken));
+
+	NullDriverStats stats = {};
+	nullDriverTakeStats(&stats);
+	TEST_CHECK(stats.mCopies == bufferCount);
+
+	for (uint32_t i = 0; i < bufferCount; ++i)
+		removeResource(pBuffers[i]);
+	exitResourceLoaderTest(pRenderer);
+}
+
+/// With decode workers a load can't be cancelled anymore once its file is being read
+static void checkTextureCancel(uint32_t decodeThreadCount)
+{
+	const uint32_t textureCount = 32;
+
+	ResourceLoaderDesc desc = {};
+	desc.mBufferSize = 1ull << 20;
+	desc.mBufferCount = 2;
+	desc.mDecodeThreadCount = decodeThreadCount;
+	Renderer* pRenderer = NULL;
+	TEST_CHECK(initResourceLoaderTest(&desc, &pRenderer));
+	if (!pRenderer)
+		return;
+
+	Texture*  pTextures[textureCount] = {};
+	SyncToken tokens[textureCount] = {};
+	for (uint32_t i = 0; i < textureCount; ++i)
+		addTestTexture(&pTextures[i], gTestTextureName, &tokens[i]);
+
+	// The streamer races the cancellation, a load is either dropped entirely or completes
+	bool cancelled[textureCount] = {};
+	uint32_t cancelledCount = 0;
+	for (uint32_t i = 1; i < textureCount; i += 2)
+	{
+		cancelled[i] = cancelResourceLoad(&tokens[i]);
+		cancelledCount += cancelled[i];
+	}
+
+	waitForAllResourceLoads();
+
+	for (uint32_t i = 0; i < textureCount; ++i)
+	{
+		TEST_CHECK(isTokenCompleted(&tokens[i]));
+		TEST_CHECK(cancelled[i] == !pTextures[i]);
+		if (pTextures[i])
+			TEST_CHECK(pTextures[i]->mWidth == gTestTextureSize && pTextures[i]->mHeight == gTestTextureSize);
+	}
+
+	// Processed loads can't be cancelled anymore
+	TEST_CHECK(!cancelResourceLoad(&tokens[0]));
+
+	NullDriverStats stats = {};
+	nullDriverTakeStats(&stats);
+	TEST_CHECK(stats.mCopies == textureCount - cancelledCount);
+
+	for (uint32_t i = 0; i < textureCount; ++i)
+	{
+		if (pTextures[i])
+			removeResource(pTextures[i]);
+	}
+	exitResourceLoaderTest(pRenderer);
+}
+
+TEST_CASE(ResourceLoaderCancelsQueuedTextureLoads)
+{
+	TEST_CHECK(writeTestTexture(gTestTextureName, gTestTextureSize));
+
+	checkTextureCancel(0);
+	checkTextureCancel(4);
+}
+
+TEST_CASE(ResourceLoaderPoolsStagingPages)
+{
+	const uint32_t textureCount = 64;
+	const uint64_t textureBytes = (uint64_t)gTestTextureSize * gTestTextureSize * 4;
+	const char*    pLargeTextureName = "ResourceLoaderTestLarge";
+
+	TEST_CHECK(writeTestTexture(gTestTextureName, gTestTextureSize));
+	TEST_CHECK(writeTestTexture(pLargeTextureName, 256));
+
+	// Sets smaller than all textures together, each one spans a few pages
+	ResourceLoaderDesc desc = {};
+	desc.mBufferSize = 128ull << 10;
+	desc.mBufferCount = 2;
+	desc.mStagingPageSize = 64ull << 10;
+	desc.mStagingMinPageCount = 1;
+	Renderer* pRenderer = NULL;
+	TEST_CHECK(initResourceLoaderTest(&desc, &pRenderer));
+	if (!pRenderer)
+		return;
+
+	Texture* pTextures[textureCount] = {};
+	for (uint32_t i = 0; i < textureCount; ++i)
+		addTestTexture(&pTextures[i], gTestTextureName, NULL);
+	waitForAllResourceLoads();
+
+	ResourceLoaderStats stats = {};
+	getResourceLoaderStats(&stats);
+	// The pool grew past the resident page but recycled the pages of completed sets instead of growing with every texture
+	TEST_CHECK(stats.mStagingPageAllocations > 0);
+	TEST_CHECK(stats.mStagingBytesAllocated == (desc.mStagingMinPageCount + stats.mStagingPageAllocations) * desc.mStagingPageSize);
+	TEST_CHECK(stats.mStagingPeakBytesAllocated <= desc.mBufferCount * (desc.mBufferSize + desc.mStagingPageSize));
+	TEST_CHECK(stats.mStagingPeakBytesAllocated < textureCount * textureBytes);
+	TEST_CHECK(stats.mStagingPeakBytesInUse >= textureBytes);
+	TEST_CHECK(stats.mStagingPeakBytesInUse <= desc.mBufferCount * desc.mBufferSize);
+	TEST_CHECK(!stats.mStagingOversizedAllocations);
+	TEST_CHECK(!stats.mStagingPageReleases);
+
+	for (uint32_t i = 0; i < textureCount; ++i)
+	{
+		TEST_CHECK(pTextures[i]);
+		if (pTextures[i])
+			removeResource(pTextures[i]);
+	}
+	exitResourceLoaderTest(pRenderer);
+
+	// A set large enough for the whole texture, which is larger than a page
+	desc.mBufferSize = 1ull << 20;
+	TEST_CHECK(initResourceLoaderTest(&desc, &pRenderer));
+	if (!pRenderer)
+		return;
+
+	Texture* pLargeTexture = NULL;
+	addTestTexture(&pLargeTexture, pLargeTextureName, NULL);
+	waitForAllResourceLoads();
+	TEST_CHECK(pLargeTexture && pLargeTexture->mWidth == 256);
+
+	getResourceLoaderStats(&stats);
+	TEST_CHECK(1 == stats.mStagingOversizedAllocations);
+	TEST_CHECK(1 == stats.mStagingPageAllocations);
+	TEST_CHECK(stats.mStagingBytesAllocated == desc.mStagingPageSize + 256 * 256 * 4);
+
+	if (pLargeTexture)
+		removeResource(pLargeTexture);
+	exitResourceLoaderTest(pRenderer);
+}
+
+TEST_CASE(ResourceLoaderSplitsTexturesAcrossCopySets)
+{
+	const char*    pFileName = "ResourceLoaderTestSplit";
+	const uint32_t size = 256;
+	const uint64_t textureBytes = (uint64_t)size * size * 4;
+
+	TEST_CHECK(writeTestTexture(pFileName, size));
+
+	// A quarter of the texture per set, it is copied in row ranges over several cycles
+	ResourceLoaderDesc desc = {};
+	desc.mBufferSize = textureBytes / 4;
+	desc.mBufferCount = 2;
+	Renderer* pRenderer = NULL;
+	TEST_CHECK(initResourceLoaderTest(&desc, &pRenderer));
+	if (!pRenderer)
+		return;
+
+	Texture*  pTexture = NULL;
+	SyncToken token = 0;
+	addTestTexture(&pTexture, pFileName, &token);
+	waitForToken(&token);
+	TEST_CHECK(pTexture && pTexture->mWidth == size && pTexture->mHeight == size);
+
+	ResourceLoaderStats loaderStats = {};
+	getResourceLoaderStats(&loaderStats);
+	TEST_CHECK(loaderStats.mStagingPeakBytesInUse <= desc.mBufferCount * desc.mBufferSize);
+	TEST_CHECK(!loaderStats.mStagingOversizedAllocations);
+
+	NullDriverStats stats = {};
+	nullDriverTakeStats(&stats);
+	TEST_CHECK(stats.mCopies >= 4);
+	TEST_CHECK(stats.mSubmits >= 4);
+
+	if (pTexture)
+		removeResource(pTexture);
+	exitResourceLoaderTest(pRenderer);
+}
+
+/// Loads the same file with the streamer decoding it and with decode workers, plus one missing file
+static void checkTextureDecode(uint32_t decodeThreadCount, uint64_t decodeMemoryBudget)
+{
+	const uint32_t textureCount = 32;
+
+	ResourceLoaderDesc desc = {};
+	desc.mBufferSize = 1ull << 20;
+	desc.mBufferCount = 2;
+	desc.mDecodeThreadCount = decodeThreadCount;
+	desc.mDecodeMemoryBudget = decodeMemoryBudget;
+	Renderer* pRenderer = NULL;
+	TEST_CHECK(initResourceLoaderTest(&desc, &pRenderer));
+	if (!pRenderer)
+		return;
+
+	Texture* pTextures[textureCount] = {};
+	for (uint32_t i = 0; i < textureCount; ++i)
+		addTestTexture(&pTextures[i], gTestTextureName, NULL);
+
+	// A file that fails to open still completes its token
+	Texture*  pMissingTexture = NULL;
+	SyncToken missingToken = 0;
+	addTestTexture(&pMissingTexture, "ResourceLoaderTestMissing", &missingToken);
+
+	waitForAllResourceLoads();
+	TEST_CHECK(isTokenCompleted(&missingToken));
+	TEST_CHECK(!pMissingTexture);
+
+	for (uint32_t i = 0; i < textureCount; ++i)
+	{
+		TEST_CHECK(pTextures[i] && pTextures[i]->mWidth == gTestTextureSize && pTextures[i]->mHeight == gTestTextureSize);
+	}
+
+	// Every worker may finish one more file after the decoded data reached the budget
+	const uint64_t payloadBytes = (uint64_t)gTestTextureSize * gTestTextureSize * 4;
+	ResourceLoaderStats loaderStats = {};
+	getResourceLoaderStats(&loaderStats);
+	TEST_CHECK(!loaderStats.mDecodeBytesInFlight);
+	TEST_CHECK(!decodeThreadCount || loaderStats.mDecodePeakBytesInFlight);
+	if (decodeMemoryBudget)
+		TEST_CHECK(loaderStats.mDecodePeakBytesInFlight < decodeMemoryBudget + decodeThreadCount * payloadBytes);
+
+	NullDriverStats stats = {};
+	nullDriverTakeStats(&stats);
+	TEST_CHECK(stats.mCopies == textureCount);
+
+	for (uint32_t i = 0; i < textureCount; ++i)
+	{
+		if (pTextures[i])
+			removeResource(pTextures[i]);
+	}
+	exitResourceLoaderTest(pRenderer);
+}
+
+TEST_CASE(ResourceLoaderDecodesTexturesOnWorkers)
+{
+	TEST_CHECK(writeTestTexture(gTestTextureName, gTestTextureSize));
+
+	checkTextureDecode(0, 0);
+	checkTextureDecode(4, 0);
+	// Held back files are decoded by the streamer once it reaches them
+	checkTextureDecode(4, 1);
+}
+
+/// Loads the mapped gltf on the streamer, on the streamer with workers around and packed on the decode workers
+static void checkGeometryDecode(uint32_t decodeThreadCount, bool decodeGeometryOnWorkers)
+{
+	const uint32_t meshCount = 8;
+	const uint32_t primitiveCount = 2;
+	const uint32_t gridSize = 16;
+
+	ResourceLoaderDesc desc = {};
+	desc.mBufferSize = 1ull << 20;
+	desc.mBufferCount = 2;
+	desc.mDecodeThreadCount = decodeThreadCount;
+	desc.mDecodeGeometryOnWorkers = decodeGeometryOnWorkers;
+	Renderer* pRenderer = NULL;
+	TEST_CHECK(initResourceLoaderTest(&desc, &pRenderer));
+	if (!pRenderer)
+		return;
+
+	Geometry* pGeometries[meshCount] = {};
+	for (uint32_t i = 0; i < meshCount; ++i)
+		addTestGeometry(&pGeometries[i], "ResourceLoaderTestMesh", MESH_OPTIMIZATION_FLAG_OFF, NULL);
+
+	waitForAllResourceLoads();
+
+	for (uint32_t i = 0; i < meshCount; ++i)
+	{
+		Geometry* pGeometry = pGeometries[i];
+		TEST_CHECK(pGeometry);
+		if (!pGeometry)
+			continue;
+		TEST_CHECK(pGeometry->mDrawArgCount == primitiveCount);
+		TEST_CHECK(pGeometry->mIndexCount == primitiveCount * (gridSize - 1) * (gridSize - 1) * 6);
+		TEST_CHECK(pGeometry->mVertexCount == primitiveCount * gridSize * gridSize);
+		TEST_CHECK(pGeometry->mVertexBufferCount == 3);
+		TEST_CHECK(pGeometry->pIndexBuffer && pGeometry->pVertexBuffers[0] && pGeometry->pVertexBuffers[1] && pGeometry->pVertexBuffers[2]);
+	}
+
+	// One index and three vertex buffer copies per mesh, whichever thread packed it
+	NullDriverStats stats = {};
+	nullDriverTakeStats(&stats);
+	TEST_CHECK(stats.mCopies == meshCount * 4);
+
+	for (uint32_t i = 0; i < meshCount; ++i)
+	{
+		if (pGeometries[i])
+			removeResource(pGeometries[i]);
+	}
+	exitResourceLoaderTest(pRenderer);
+}
+
+TEST_CASE(ResourceLoaderLoadsMappedGltf)
+{
+	TEST_CHECK(writeTestMesh("ResourceLoaderTestMesh", 2, 16));
+
+	checkGeometryDecode(0, false);
+	checkGeometryDecode(4, false);
+	checkGeometryDecode(4, true);
+}
+
+BENCHMARK_CASE(ResourceLoaderDecodeThroughput)
+{
+	const uint32_t textureCount = 256;
+	const uint32_t meshCount = 64;
+	const char*    pTextureName = "ResourceLoaderBenchmark";
+	const char*    pMeshName = "ResourceLoaderDecodeBenchmark";
+
+	if (!writeTestTexture(pTextureName, 512) || !writeTestMesh(pMeshName, 4, 128))
+		return;
+
+	// The last configuration packs the meshes on the workers, the textures decode as in the one before
+	const uint32_t decodeThreadCounts[] = { 0, 4, 4 };
+	const bool     decodeGeometryOnWorkers[] = { false, false, true };
+	for (uint32_t c = 0; c < sizeof(decodeThreadCounts) / sizeof(decodeThreadCounts[0]); ++c)
+	{
+		ResourceLoaderDesc desc = {};
+		desc.mBufferSize = 8ull << 20;
+		desc.mBufferCount = 2;
+		desc.mDecodeThreadCount = decodeThreadCounts[c];
+		desc.mDecodeMemoryBudget = gDefaultResourceLoaderDesc.mDecodeMemoryBudget;
+		desc.mDecodeGeometryOnWorkers = decodeGeometryOnWorkers[c];
+		Renderer* pRenderer = NULL;
+		if (!initResourceLoaderTest(&desc, &pRenderer))
+			return;
+
+		Texture**  ppTextures = (Texture**)tf_calloc(textureCount, sizeof(Texture*));
+		Geometry** ppGeometries = (Geometry**)tf_calloc(meshCount, sizeof(Geometry*));
+		char       name[64] = {};
+
+		HiresTimer timer;
+		initHiresTimer(&timer);
+		for (uint32_t i = 0; i < textureCount; ++i)
+			addTestTexture(&ppTextures[i], pTextureName, NULL);
+		waitForAllResourceLoads();
+		double seconds = getTestSeconds(&timer, true);
+		snprintf(name, sizeof(name), "Textures, %u decode threads", decodeThreadCounts[c]);
+		if (!decodeGeometryOnWorkers[c])
+			reportBenchmarkResult(name, textureCount / seconds, "textures/s");
+
+		for (uint32_t i = 0; i < meshCount; ++i)
+			addTestGeometry(&ppGeometries[i], pMeshName, MESH_OPTIMIZATION_FLAG_OFF, NULL);
+		waitForAllResourceLoads();
+		seconds = getTestSeconds(&timer, false);
+		snprintf(
+			name, sizeof(name), "Meshes, %u decode threads, packed %s", decodeThreadCounts[c],
+			decodeGeometryOnWorkers[c] ? "on workers" : "into staging memory");
+		reportBenchmarkResult(name, meshCount / seconds, "meshes/s");
+
+		for (uint32_t i = 0; i < textureCount; ++i)
+			removeResource(ppTextures[i]);
+		for (uint32_t i = 0; i < meshCount; ++i)
+		{
+			if (ppGeometries[i])
+				removeResource(ppGeometries[i]);
+		}
+		tf_free(ppTextures);
+		tf_free(ppGeometries);
+		exitResourceLoaderTest(pRenderer);
+	}
+}
+
+
+BENCHMARK_CASE(ResourceLoaderMeshOptimizeThroughput)
+{
+	const uint32_t meshCount = 16;
+	const uint32_t primitiveCount = 16;
+	const char*    pFileName = "ResourceLoaderMeshBenchmark";
+
+	if (!writeTestMesh(pFileName, primitiveCount, 128))
+		return;
+
+	// Without decode workers the primitives are optimized one after the other on the streamer thread
+	const uint32_t         decodeThreadCounts[] = { 0, 0, 4 };
+	const MeshOptimizerFlags optimizationFlags[] = { MESH_OPTIMIZATION_FLAG_OFF, MESH_OPTIMIZATION_FLAG_ALL, MESH_OPTIMIZATION_FLAG_ALL };
+	for (uint32_t c = 0; c < sizeof(decodeThreadCounts) / sizeof(decodeThreadCounts[0]); ++c)
+	{
+		ResourceLoaderDesc desc = {};
+		desc.mBufferSize = 8ull << 20;
+		desc.mBufferCount = 2;
+		desc.mDecodeThreadCount = decodeThreadCounts[c];
+		Renderer* pRenderer = NULL;
+		if (!initResourceLoaderTest(&desc, &pRenderer))
+			return;
+
+		Geometry* pGeometries[meshCount] = {};
+
+		HiresTimer timer;
+		initHiresTimer(&timer);
+		for (uint32_t i = 0; i < meshCount; ++i)
+			addTestGeometry(&pGeometries[i], pFileName, optimizationFlags[c], NULL);
+		waitForAllResourceLoads();
+		const double seconds = getTestSeconds(&timer, false);
+
+		char name[64] = {};
+		snprintf(
+			name, sizeof(name), "%s, %u decode threads", optimizationFlags[c] ? "Optimized" : "Not optimized", decodeThreadCounts[c]);
+		reportBenchmarkResult(name, meshCount / seconds, "meshes/s");
+
+		for (uint32_t i = 0; i < meshCount; ++i)
+		{
+			if (pGeometries[i])
+				removeResource(pGeometries[i]);
+		}
+		exitResourceLoaderTest(pRenderer);
+	}
+}
+
+#endif
@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2017-2022 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "../OS/Interfaces/IThread.h"
+#include "../OS/Core/ThreadSystem.h"
+
+#include "TestFramework.h"
+
+#include "../OS/Interfaces/IMemory.h"
+
+/************************************************************************/
+// Ordering
+/************************************************************************/
+struct ChainData
+{
+	tfrg_atomic32_t mNext;
+	uint32_t*       pOrder;
+};
+
+static void chainTask(void* pUser, uintptr_t node)
+{
+	ChainData* pData = (ChainData*)pUser;
+	pData->pOrder[node] = (uint32_t)tfrg_atomic32_add_relaxed(&pData->mNext, 1);
+}
+
+TEST_CASE(TaskGraphChainRunsInOrder)
+{
+	ThreadSystem* pThreadSystem = NULL;
+	initThreadSystem(&pThreadSystem);
+	ThreadTaskGraph* pGraph = NULL;
+	initThreadTaskGraph(pThreadSystem, &pGraph);
+
+	const uint32_t count = 4096;
+	ChainData      data = { 0, (uint32_t*)tf_calloc(count, sizeof(uint32_t)) };
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		ThreadTaskHandle task = addThreadTaskGraphTask(pGraph, chainTask, &data, i);
+		if (i)
+			addThreadTaskGraphDependency(pGraph, task, task - 1);
+	}
+
+	runThreadTaskGraph(pGraph);
+	waitThreadTaskGraph(pGraph);
+
+	bool inOrder = true;
+	for (uint32_t i = 0; i < count; ++i)
+		inOrder = inOrder && data.pOrder[i] == i;
+	TEST_CHECK(inOrder);
+	TEST_CHECK(isThreadTaskGraphDone(pGraph));
+
+	tf_free(data.pOrder);
+	exitThreadTaskGraph(pGraph);
+	exitThreadSystem(pThreadSystem);
+}
+
+// Layers of range tasks, every node depends on two nodes of the layer above (a row of diamonds)
+struct LayerData
+{
+	uint32_t         mWidth;
+	uint32_t         mRange;
+	// Indices of every node that finished, a node is done once all mRange of them ran
+	tfrg_atomic32_t* pFinished;
+	tfrg_atomic32_t* pRuns;
+	tfrg_atomic32_t  mViolations;
+};
+
+struct LayerNode
+{
+	LayerData* pData;
+	uint32_t   mNode;
+};
+
+static void layerTask(void* pUser, uintptr_t)
+{
+	LayerNode* pNode = (LayerNode*)pUser;
+	LayerData* pData = pNode->pData;
+	const uint32_t layer = pNode->mNode / pData->mWidth;
+	if (layer)
+	{
+		const uint32_t column = pNode->mNode % pData->mWidth;
+		const uint32_t above = (layer - 1) * pData->mWidth;
+		if (tfrg_atomic32_load_acquire(&pData->pFinished[above + column]) != pData->mRange ||
+			tfrg_atomic32_load_acquire(&pData->pFinished[above + (column + 1) % pData->mWidth]) != pData->mRange)
+		{
+			tfrg_atomic32_add_relaxed(&pData->mViolations, 1);
+		}
+	}
+	tfrg_atomic32_add_relaxed(&pData->pRuns[pNode->mNode], 1);
+	tfrg_atomic32_add_relaxed(&pData->pFinished[pNode->mNode], 1);
+}
+
+static void addLayerGraph(ThreadTaskGraph* pGraph, LayerData* pData, LayerNode* pNodes, uint32_t layers)
+{
+	for (uint32_t l = 0; l < layers; ++l)
+	{
+		for (uint32_t c = 0; c < pData->mWidth; ++c)
+		{
+			const uint32_t node = l * pData->mWidth + c;
+			pNodes[node] = { pData, node };
+			ThreadTaskHandle task = addThreadTaskGraphTask(pGraph, layerTask, &pNodes[node], 0, pData->mRange);
+			ASSERT(task == node);
+			if (l)
+			{
+				addThreadTaskGraphDependency(pGraph, task, node - pData->mWidth);
+				addThreadTaskGraphDependency(pGraph, task, (l - 1) * pData->mWidth + (c + 1) % pData->mWidth);
+			}
+		}
+	}
+}
+
+TEST_CASE(TaskGraphRespectsDependenciesAndReruns)
+{
+	ThreadSystem* pThreadSystem = NULL;
+	initThreadSystem(&pThreadSystem);
+	ThreadTaskGraph* pGraph = NULL;
+	initThreadTaskGraph(pThreadSystem, &pGraph);
+
+	const uint32_t layers = 64;
+	LayerData      data = {};
+	data.mWidth = 64;
+	data.mRange = 8;
+	const uint32_t count = layers * data.mWidth;
+	data.pFinished = (tfrg_atomic32_t*)tf_calloc(count, sizeof(tfrg_atomic32_t));
+	data.pRuns = (tfrg_atomic32_t*)tf_calloc(count, sizeof(tfrg_atomic32_t));
+	LayerNode* pNodes = (LayerNode*)tf_calloc(count, sizeof(LayerNode));
+	addLayerGraph(pGraph, &data, pNodes, layers);
+
+	// The graph is built once and run several times, like a per frame job graph
+	const uint32_t runs = 3;
+	for (uint32_t r = 0; r < runs; ++r)
+	{
+		memset((void*)data.pFinished, 0, count * sizeof(tfrg_atomic32_t));
+		runThreadTaskGraph(pGraph);
+		// Waiting on the first layer only returns once all its indices ran
+		waitThreadTaskGraphTask(pGraph, 0);
+		TEST_CHECK(data.pFinished[0] == data.mRange);
+		waitThreadTaskGraph(pGraph);
+	}
+
+	bool allRan = true;
+	for (uint32_t i = 0; i < count; ++i)
+		allRan = allRan && data.pRuns[i] == data.mRange * runs;
+	TEST_CHECK(allRan);
+	TEST_CHECK(data.mViolations == 0);
+
+	tf_free(pNodes);
+	tf_free((void*)data.pRuns);
+	tf_free((void*)data.pFinished);
+	exitThreadTaskGraph(pGraph);
+	exitThreadSystem(pThreadSystem);
+}
+
+TEST_CASE(TaskGraphResetStartsEmpty)
+{
+	ThreadSystem* pThreadSystem = NULL;
+	initThreadSystem(&pThreadSystem);
+	ThreadTaskGraph* pGraph = NULL;
+	initThreadTaskGraph(pThreadSystem, &pGraph);
+
+	ChainData data = { 0, (uint32_t*)tf_calloc(2, sizeof(uint32_t)) };
+	addThreadTaskGraphTask(pGraph, chainTask, &data, 0);
+	resetThreadTaskGraph(pGraph);
+	addThreadTaskGraphTask(pGraph, chainTask, &data, 1);
+	runThreadTaskGraph(pGraph);
+	waitThreadTaskGraph(pGraph);
+
+	TEST_CHECK(data.mNext == 1);
+	TEST_CHECK(data.pOrder[1] == 0);
+
+	// Running an empty graph must not block
+	resetThreadTaskGraph(pGraph);
+	runThreadTaskGraph(pGraph);
+	TEST_CHECK(isThreadTaskGraphDone(pGraph));
+
+	tf_free(data.pOrder);
+	exitThreadTaskGraph(pGraph);
+	exitThreadSystem(pThreadSystem);
+}
+
+/************************************************************************/
+// Benchmark
+/************************************************************************/
+// The same layered workload submitted layer by layer with a full wait in between, the way
+// dependent work was scheduled before the task graph existed.
+BENCHMARK_CASE(TaskGraphThroughput)
+{
+	ThreadSystem* pThreadSystem = NULL;
+	initThreadSystem(&pThreadSystem, MAX_SYSTEM_THREADS);
+	ThreadTaskGraph* pGraph = NULL;
+	initThreadTaskGraph(pThreadSystem, &pGraph);
+
+	const uint32_t layers = 256;
+	const uint32_t runs = 16;
+	LayerData      data = {};
+	data.mWidth = 32;
+	data.mRange = 4;
+	const uint32_t count = layers * data.mWidth;
+	data.pFinished = (tfrg_atomic32_t*)tf_calloc(count, sizeof(tfrg_atomic32_t));
+	data.pRuns = (tfrg_atomic32_t*)tf_calloc(count, sizeof(tfrg_atomic32_t));
+	LayerNode* pNodes = (LayerNode*)tf_calloc(count, sizeof(LayerNode));
+	addLayerGraph(pGraph, &data, pNodes, layers);
+
+	HiresTimer timer;
+	initHiresTimer(&timer);
+	for (uint32_t r = 0; r < runs; ++r)
+	{
+		memset((void*)data.pFinished, 0, count * sizeof(tfrg_atomic32_t));
+		runThreadTaskGraph(pGraph);
+		waitThreadTaskGraph(pGraph);
+	}
+	const double graphSeconds = getTestSeconds(&timer, true);
+
+	for (uint32_t r = 0; r < runs; ++r)
+	{
+		memset((void*)data.pFinished, 0, count * sizeof(tfrg_atomic32_t));
+		for (uint32_t l = 0; l < layers; ++l)
+		{
+			for (uint32_t c = 0; c < data.mWidth; ++c)
+				addThreadSystemRangeTask(pThreadSystem, layerTask, &pNodes[l * data.mWidth + c], 0, data.mRange);
+			waitThreadSystemIdle(pThreadSystem);
+		}
+	}
+	const double layerSeconds = getTestSeconds(&timer, true);
+	TEST_CHECK(data.mViolations == 0);
+
+	char name[64];
+	snprintf(name, sizeof(name), "task graph, %u threads", getThreadSystemThreadCount(pThreadSystem));
+	reportBenchmarkResult(name, runs * count / graphSeconds, "nodes/s");
+	snprintf(name, sizeof(name), "wait per layer, %u threads", getThreadSystemThreadCount(pThreadSystem));
+	reportBenchmarkResult(name, runs * count / layerSeconds, "nodes/s");
+
+	tf_free(pNodes);
+	tf_free((void*)data.pRuns);
+	tf_free((void*)data.pFinished);
+	exitThreadTaskGraph(pGraph);
+	exitThreadSystem(pThreadSystem);
+}
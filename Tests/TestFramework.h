@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2017-2022 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#pragma once
+
+#include "../OS/Interfaces/ILog.h"
+#include "../OS/Interfaces/ITime.h"
+
+// Minimal self registering test harness.
+// Test cases always run, benchmark cases only when the executable is started with --bench.
+// A failed TEST_CHECK is reported and the case keeps running, the process exit code is the number of failed cases.
+
+typedef void (*TestFunc)();
+
+typedef struct TestCase
+{
+	const char* pName;
+	TestFunc    pFunc;
+	bool        mBenchmark;
+	TestCase*   pNext;
+} TestCase;
+
+void registerTestCase(TestCase* pTestCase);
+void reportTestFailure(const char* pFile, int line, const char* pExpression);
+/// Prints one benchmark measurement line
+void reportBenchmarkResult(const char* pName, double value, const char* pUnit);
+
+struct TestCaseRegistrar
+{
+	TestCaseRegistrar(TestCase* pTestCase) { registerTestCase(pTestCase); }
+};
+
+#define TEST_CASE_IMPL(name, benchmark)                                          \
+	static void      name();                                                     \
+	static TestCase  gTestCase_##name = { #name, name, benchmark, NULL };        \
+	static TestCaseRegistrar gTestCaseRegistrar_##name(&gTestCase_##name);       \
+	static void      name()
+
+#define TEST_CASE(name) TEST_CASE_IMPL(name, false)
+#define BENCHMARK_CASE(name) TEST_CASE_IMPL(name, true)
+
+#define TEST_CHECK(expression)                                     \
+	do                                                             \
+	{                                                              \
+		if (!(expression))                                         \
+			reportTestFailure(__FILE__, __LINE__, #expression);    \
+	} while (0)
+
+/// Seconds since the last call with reset (or since init)
+static inline double getTestSeconds(HiresTimer* pTimer, bool reset) { return (double)getHiresTimerUSec(pTimer, reset) / 1000000.0; }
@@ -0,0 +1,347 @@
+/*
+ * Copyright (c) 2017-2022 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "../OS/Interfaces/IThread.h"
+#include "../OS/Core/ThreadSystem.h"
+
+#include "TestFramework.h"
+
+#include "../OS/Interfaces/IMemory.h"
+
+/************************************************************************/
+// Work-stealing queues
+/************************************************************************/
+struct IndexCounts
+{
+	tfrg_atomic32_t* pCounts;
+};
+
+static void countIndexTask(void* pUser, uintptr_t index)
+{
+	IndexCounts* pData = (IndexCounts*)pUser;
+	tfrg_atomic32_add_relaxed(&pData->pCounts[index], 1);
+}
+
+static bool everyIndexRanOnce(const IndexCounts* pData, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		if (pData->pCounts[i] != 1)
+			return false;
+	}
+	return true;
+}
+
+TEST_CASE(ThreadSystemRunsEveryIndexOnce)
+{
+	ThreadSystem* pThreadSystem = NULL;
+	initThreadSystem(&pThreadSystem);
+
+	const uint32_t count = 100000;
+	IndexCounts    data = { (tfrg_atomic32_t*)tf_calloc(count, sizeof(tfrg_atomic32_t)) };
+
+	addThreadSystemRangeTask(pThreadSystem, countIndexTask, &data, count);
+	waitThreadSystemIdle(pThreadSystem);
+
+	TEST_CHECK(isThreadSystemIdle(pThreadSystem));
+	TEST_CHECK(everyIndexRanOnce(&data, count));
+
+	tf_free((void*)data.pCounts);
+	exitThreadSystem(pThreadSystem);
+}
+
+TEST_CASE(ThreadSystemQueuesGrowPastInitialCapacity)
+{
+	ThreadSystem* pThreadSystem = NULL;
+	initThreadSystem(&pThreadSystem);
+
+	// Separate entries, many more than the initial capacity of all queues together
+	const uint32_t count = MAX_SYSTEM_TASKS * MAX_SYSTEM_THREADS * 4;
+	IndexCounts    data = { (tfrg_atomic32_t*)tf_calloc(count, sizeof(tfrg_atomic32_t)) };
+
+	for (uint32_t i = 0; i < count; ++i)
+		addThreadSystemTask(pThreadSystem, countIndexTask, &data, i);
+	waitThreadSystemIdle(pThreadSystem);
+
+	TEST_CHECK(everyIndexRanOnce(&data, count));
+
+	tf_free((void*)data.pCounts);
+	exitThreadSystem(pThreadSystem);
+}
+
+struct SpawnTreeData
+{
+	ThreadSystem*   pThreadSystem;
+	tfrg_atomic32_t mNodes;
+};
+
+// Every node below the depth limit spawns two children from inside the worker, so they land on the worker's own queue
+static void spawnTreeTask(void* pUser, uintptr_t depth)
+{
+	SpawnTreeData* pData = (SpawnTreeData*)pUser;
+	tfrg_atomic32_add_relaxed(&pData->mNodes, 1);
+	if (depth < 14)
+	{
+		addThreadSystemTask(pData->pThreadSystem, spawnTreeTask, pData, depth + 1);
+		addThreadSystemTask(pData->pThreadSystem, spawnTreeTask, pData, depth + 1);
+	}
+}
+
+TEST_CASE(ThreadSystemTasksAddedFromWorkers)
+{
+	ThreadSystem* pThreadSystem = NULL;
+	initThreadSystem(&pThreadSystem);
+
+	SpawnTreeData data = { pThreadSystem, 0 };
+	addThreadSystemTask(pThreadSystem, spawnTreeTask, &data, 0);
+	waitThreadSystemIdle(pThreadSystem);
+
+	// Full binary tree of depth 14
+	TEST_CHECK(data.mNodes == (1u << 15) - 1);
+
+	exitThreadSystem(pThreadSystem);
+}
+
+struct AssistData
+{
+	tfrg_atomic32_t mRan[4];
+};
+
+static void assistTask(void* pUser, uintptr_t index)
+{
+	AssistData* pData = (AssistData*)pUser;
+	tfrg_atomic32_add_relaxed(&pData->mRan[index], 1);
+}
+
+static void blockTask(void* pUser, uintptr_t)
+{
+	tfrg_atomic32_t* pRelease = (tfrg_atomic32_t*)pUser;
+	while (!tfrg_atomic32_load_acquire(pRelease))
+		threadSleep(1);
+}
+
+TEST_CASE(ThreadSystemAssistRunsRequestedTask)
+{
+	ThreadSystem* pThreadSystem = NULL;
+	initThreadSystem(&pThreadSystem);
+
+	// Keep every worker busy so the tasks below stay queued until we assist
+	tfrg_atomic32_t release = 0;
+	const uint32_t  numThreads = getThreadSystemThreadCount(pThreadSystem);
+	for (uint32_t i = 0; i < numThreads; ++i)
+		addThreadSystemTask(pThreadSystem, blockTask, (void*)&release);
+
+	AssistData data = {};
+	for (uint32_t i = 0; i < 4; ++i)
+		addThreadSystemTask(pThreadSystem, assistTask, &data, i);
+
+	uint32_t wanted = 2;
+	while (!data.mRan[2])
+	{
+		// A worker that did not pick up its blocker yet can run the task before we find it
+		if (!assistThreadSystemTasks(pThreadSystem, &wanted, 1))
+			threadSleep(0);
+	}
+	TEST_CHECK(data.mRan[2] == 1);
+
+	tfrg_atomic32_store_release(&release, 1);
+	waitThreadSystemIdle(pThreadSystem);
+	for (uint32_t i = 0; i < 4; ++i)
+		TEST_CHECK(data.mRan[i] == 1);
+
+	exitThreadSystem(pThreadSystem);
+}
+
+/************************************************************************/
+// Benchmark against a single locked queue
+/************************************************************************/
+// Reference scheduler with the structure the thread system had before the work-stealing queues:
+// one ring for every worker behind one mutex and a wake-all on every submission.
+struct LockedTaskQueue
+{
+	struct Task
+	{
+		TaskFunc  mTask;
+		void*     pUser;
+		uintptr_t mIndex;
+	};
+
+	Mutex             mMutex;
+	ConditionVariable mQueueCond;
+	ConditionVariable mIdleCond;
+	Task*             pTasks;
+	uint32_t          mCapacity;
+	uint32_t          mHead;
+	uint32_t          mTail;
+	uint32_t          mPending;
+	uint32_t          mNumThreads;
+	volatile bool     mRun;
+	ThreadHandle      mThreads[MAX_SYSTEM_THREADS];
+};
+
+static void lockedQueueThreadFunc(void* pUser)
+{
+	LockedTaskQueue* pQueue = (LockedTaskQueue*)pUser;
+	acquireMutex(&pQueue->mMutex);
+	while (pQueue->mRun)
+	{
+		if (pQueue->mHead == pQueue->mTail)
+		{
+			waitConditionVariable(&pQueue->mQueueCond, &pQueue->mMutex, TIMEOUT_INFINITE);
+			continue;
+		}
+
+		LockedTaskQueue::Task task = pQueue->pTasks[pQueue->mHead++ & (pQueue->mCapacity - 1)];
+		releaseMutex(&pQueue->mMutex);
+		task.mTask(task.pUser, task.mIndex);
+		acquireMutex(&pQueue->mMutex);
+		if (--pQueue->mPending == 0)
+			wakeAllConditionVariable(&pQueue->mIdleCond);
+	}
+	releaseMutex(&pQueue->mMutex);
+}
+
+static void initLockedTaskQueue(LockedTaskQueue* pQueue, uint32_t numThreads)
+{
+	initMutex(&pQueue->mMutex);
+	initConditionVariable(&pQueue->mQueueCond);
+	initConditionVariable(&pQueue->mIdleCond);
+	pQueue->mCapacity = MAX_SYSTEM_TASKS;
+	pQueue->pTasks = (LockedTaskQueue::Task*)tf_malloc(pQueue->mCapacity * sizeof(LockedTaskQueue::Task));
+	pQueue->mHead = pQueue->mTail = pQueue->mPending = 0;
+	pQueue->mNumThreads = numThreads;
+	pQueue->mRun = true;
+
+	ThreadDesc threadDesc = {};
+	threadDesc.pFunc = lockedQueueThreadFunc;
+	threadDesc.pData = pQueue;
+	for (uint32_t i = 0; i < numThreads; ++i)
+	{
+		snprintf(threadDesc.mThreadName, sizeof(threadDesc.mThreadName), "LockedQueue%u", i);
+		initThread(&threadDesc, &pQueue->mThreads[i]);
+	}
+}
+
+static void exitLockedTaskQueue(LockedTaskQueue* pQueue)
+{
+	acquireMutex(&pQueue->mMutex);
+	pQueue->mRun = false;
+	wakeAllConditionVariable(&pQueue->mQueueCond);
+	releaseMutex(&pQueue->mMutex);
+	for (uint32_t i = 0; i < pQueue->mNumThreads; ++i)
+		joinThread(pQueue->mThreads[i]);
+
+	tf_free(pQueue->pTasks);
+	destroyConditionVariable(&pQueue->mQueueCond);
+	destroyConditionVariable(&pQueue->mIdleCond);
+	destroyMutex(&pQueue->mMutex);
+}
+
+static void addLockedTask(LockedTaskQueue* pQueue, TaskFunc task, void* pUser, uintptr_t index)
+{
+	acquireMutex(&pQueue->mMutex);
+	if (pQueue->mTail - pQueue->mHead == pQueue->mCapacity)
+	{
+		// The original ring was fixed size. Growing keeps the comparison about locking rather than about stalls
+		LockedTaskQueue::Task* pTasks = (LockedTaskQueue::Task*)tf_malloc(pQueue->mCapacity * 2 * sizeof(LockedTaskQueue::Task));
+		for (uint32_t i = 0; i < pQueue->mCapacity; ++i)
+			pTasks[i] = pQueue->pTasks[(pQueue->mHead + i) & (pQueue->mCapacity - 1)];
+		tf_free(pQueue->pTasks);
+		pQueue->pTasks = pTasks;
+		pQueue->mHead = 0;
+		pQueue->mTail = pQueue->mCapacity;
+		pQueue->mCapacity *= 2;
+	}
+	pQueue->pTasks[pQueue->mTail++ & (pQueue->mCapacity - 1)] = { task, pUser, index };
+	++pQueue->mPending;
+	wakeAllConditionVariable(&pQueue->mQueueCond);
+	releaseMutex(&pQueue->mMutex);
+}
+
+static void waitLockedTaskQueueIdle(LockedTaskQueue* pQueue)
+{
+	acquireMutex(&pQueue->mMutex);
+	while (pQueue->mPending)
+		waitConditionVariable(&pQueue->mIdleCond, &pQueue->mMutex, TIMEOUT_INFINITE);
+	releaseMutex(&pQueue->mMutex);
+}
+
+struct BenchTaskData
+{
+	tfrg_atomic64_t mSum;
+};
+
+// Roughly the size of a small culling or animation job
+static void benchTask(void* pUser, uintptr_t index)
+{
+	BenchTaskData* pData = (BenchTaskData*)pUser;
+	uint64_t       value = index;
+	for (uint32_t i = 0; i < 64; ++i)
+		value = value * 6364136223846793005ull + 1442695040888963407ull;
+	tfrg_atomic64_add_relaxed(&pData->mSum, value & 1);
+}
+
+BENCHMARK_CASE(ThreadSystemTaskThroughput)
+{
+	const uint32_t taskCount = 200000;
+	const uint32_t threadCounts[] = { 1, 2, 4, 8, 16, 32, 64 };
+
+	for (uint32_t t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); ++t)
+	{
+		ThreadSystem* pThreadSystem = NULL;
+		initThreadSystem(&pThreadSystem, threadCounts[t]);
+		const uint32_t numThreads = getThreadSystemThreadCount(pThreadSystem);
+		// initThreadSystem clamps to the number of cores, don't measure the same configuration twice
+		if (numThreads < threadCounts[t] && t && numThreads <= threadCounts[t - 1])
+		{
+			exitThreadSystem(pThreadSystem);
+			break;
+		}
+
+		BenchTaskData data = {};
+		HiresTimer    timer;
+		initHiresTimer(&timer);
+		for (uint32_t i = 0; i < taskCount; ++i)
+			addThreadSystemTask(pThreadSystem, benchTask, &data, i);
+		waitThreadSystemIdle(pThreadSystem);
+		const double stealingSeconds = getTestSeconds(&timer, true);
+		exitThreadSystem(pThreadSystem);
+
+		LockedTaskQueue* pLocked = tf_new(LockedTaskQueue);
+		initLockedTaskQueue(pLocked, numThreads);
+		resetHiresTimer(&timer);
+		for (uint32_t i = 0; i < taskCount; ++i)
+			addLockedTask(pLocked, benchTask, &data, i);
+		waitLockedTaskQueueIdle(pLocked);
+		const double lockedSeconds = getTestSeconds(&timer, true);
+		exitLockedTaskQueue(pLocked);
+		tf_delete(pLocked);
+
+		char name[64];
+		snprintf(name, sizeof(name), "work stealing, %u threads", numThreads);
+		reportBenchmarkResult(name, taskCount / stealingSeconds, "tasks/s");
+		snprintf(name, sizeof(name), "single locked queue, %u threads", numThreads);
+		reportBenchmarkResult(name, taskCount / lockedSeconds, "tasks/s");
+	}
+}
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2017-2022 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+#include "../OS/Core/CPUConfig.h"
+#include "../Renderer/Source/VertexPacking.h"
+
+#include "TestFramework.h"
+
+#include "../OS/Interfaces/IMemory.h"
+
+// Every SIMD path the CPU supports has to produce the same bits as the scalar path, for any stride and count
+
+static uint32_t gVertexPackingSeed = 0x12345678u;
+
+static uint32_t nextRandomBits()
+{
+	gVertexPackingSeed = gVertexPackingSeed * 1664525u + 1013904223u;
+	return gVertexPackingSeed;
+}
+
+static float bitsToFloat(uint32_t bits)
+{
+	float f;
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+static uint32_t getSupportedPackingPaths(VertexPackingPath* pPaths)
+{
+	uint32_t count = 0;
+#if defined(ARCH_X86_FAMILY)
+	CpuInfo cpuInfo = {};
+	if (initCpuInfo(&cpuInfo))
+	{
+		if (cpuInfo.features.sse4_1)
+			pPaths[count++] = VERTEX_PACKING_PATH_SSE41;
+		if (cpuInfo.features.avx2 && cpuInfo.features.f16c)
+			pPaths[count++] = VERTEX_PACKING_PATH_AVX2;
+	}
+#endif
+	return count;
+}
+
+/// Packs with the scalar path and the given one, returns true if every packed vertex matches
+static bool packedVerticesMatch(
+	PackingFunction pfnScalar, PackingFunction pfnPacking, uint32_t count, uint32_t srcStride, uint32_t dstStride, const uint8_t* src)
+{
+	const uint32_t offset = dstStride > sizeof(uint32_t) ? sizeof(uint32_t) : 0;
+	const size_t   dstSize = (size_t)count * dstStride + offset;
+	uint8_t*       pExpected = (uint8_t*)tf_calloc(1, dstSize);
+	uint8_t*       pPacked = (uint8_t*)tf_calloc(1, dstSize);
+
+	pfnScalar(count, srcStride, dstStride, offset, src, pExpected);
+	pfnPacking(count, srcStride, dstStride, offset, src, pPacked);
+	const bool match = !memcmp(pExpected, pPacked, dstSize);
+
+	tf_free(pExpected);
+	tf_free(pPacked);
+	return match;
+}
+
+TEST_CASE(VertexPackingHalfMatchesScalar)
+{
+	// Zeros, half denormals, overflow, infinities and NaN payloads followed by random bit patterns
+	const float special[] = {
+		0.0f,          -0.0f,          1.0f,          -1.0f,        0.5f,       65504.0f,    65519.0f,    65520.0f,
+		-65536.0f,     1e-5f,          -6.0e-8f,      6.1035156e-5f, 1e-40f,    3.4e38f,     bitsToFloat(0x7f800000u),
+		bitsToFloat(0xff800000u), bitsToFloat(0x7fc00001u), bitsToFloat(0xffbfffffu),
+	};
+	const uint32_t specialCount = sizeof(special) / sizeof(special[0]);
+	const uint32_t count = 1027;
+	const uint32_t srcStrides[] = { sizeof(float[2]), sizeof(float[3]), 32 };
+	const uint32_t dstStrides[] = { sizeof(uint32_t), 20 };
+
+	for (uint32_t s = 0; s < sizeof(srcStrides) / sizeof(srcStrides[0]); ++s)
+	{
+		uint8_t* pSrc = (uint8_t*)tf_calloc(count, srcStrides[s]);
+		for (uint32_t v = 0; v < count; ++v)
+		{
+			float* f = (float*)(pSrc + v * srcStrides[s]);
+			f[0] = v < specialCount ? special[v] : bitsToFloat(nextRandomBits());
+			f[1] = v < specialCount ? special[specialCount - 1 - v] : bitsToFloat(nextRandomBits());
+		}
+
+		VertexPackingPath paths[2];
+		const uint32_t    pathCount = getSupportedPackingPaths(paths);
+		for (uint32_t p = 0; p < pathCount; ++p)
+		{
+			for (uint32_t d = 0; d < sizeof(dstStrides) / sizeof(dstStrides[0]); ++d)
+			{
+				TEST_CHECK(packedVerticesMatch(
+					util_pack_float2_to_half2_scalar, util_get_pack_float2_to_half2(paths[p]), count, srcStrides[s], dstStrides[d], pSrc));
+				// Counts below the vector width only run the tail
+				TEST_CHECK(packedVerticesMatch(
+					util_pack_float2_to_half2_scalar, util_get_pack_float2_to_half2(paths[p]), 3, srcStrides[s], dstStrides[d], pSrc));
+			}
+		}
+		tf_free(pSrc);
+	}
+}
+
+TEST_CASE(VertexPackingDirectionMatchesScalar)
+{
+	const uint32_t count = 1029;
+	const uint32_t srcStrides[] = { sizeof(float[3]), sizeof(float[4]) };
+	const uint32_t dstStrides[] = { sizeof(uint32_t), 24 };
+
+	for (uint32_t s = 0; s < sizeof(srcStrides) / sizeof(srcStrides[0]); ++s)
+	{
+		uint8_t* pSrc = (uint8_t*)tf_calloc(count, srcStrides[s]);
+		for (uint32_t v = 0; v < count; ++v)
+		{
+			float* f = (float*)(pSrc + v * srcStrides[s]);
+			// Every eighth direction is zero, the others cover both hemispheres including exact axes
+			for (uint32_t c = 0; c < 3 && v % 8; ++c)
+				f[c] = v % 8 == 1 ? (c == v % 3 ? -1.0f : 0.0f) : (float)(int32_t)(nextRandomBits() >> 8) / (float)(1 << 23) - 1.0f;
+		}
+
+		VertexPackingPath paths[2];
+		const uint32_t    pathCount = getSupportedPackingPaths(paths);
+		for (uint32_t p = 0; p < pathCount; ++p)
+		{
+			for (uint32_t d = 0; d < sizeof(dstStrides) / sizeof(dstStrides[0]); ++d)
+			{
+				TEST_CHECK(packedVerticesMatch(
+					util_pack_float3_direction_to_half2_scalar, util_get_pack_float3_direction_to_half2(paths[p]), count, srcStrides[s],
+					dstStrides[d], pSrc));
+			}
+		}
+		tf_free(pSrc);
+	}
+}
+
+BENCHMARK_CASE(VertexPackingThroughput)
+{
+	const uint32_t count = 1 << 20;
+	const uint32_t srcStride = sizeof(float[3]);
+	uint8_t*       pSrc = (uint8_t*)tf_calloc(count, srcStride);
+	uint8_t*       pDst = (uint8_t*)tf_calloc(count, sizeof(uint32_t));
+	for (uint32_t i = 0; i < count * 3; ++i)
+		((float*)pSrc)[i] = (float)(int32_t)(nextRandomBits() >> 8) / (float)(1 << 23) - 1.0f;
+
+	VertexPackingPath paths[3] = { VERTEX_PACKING_PATH_SCALAR };
+	const uint32_t    pathCount = 1 + getSupportedPackingPaths(paths + 1);
+	const char*       pathNames[] = { "scalar", "sse4.1", "avx2" };
+	for (uint32_t p = 0; p < pathCount; ++p)
+	{
+		HiresTimer timer;
+		initHiresTimer(&timer);
+		util_get_pack_float2_to_half2(paths[p])(count, srcStride, sizeof(uint32_t), 0, pSrc, pDst);
+		const double halfSeconds = getTestSeconds(&timer, true);
+		util_get_pack_float3_direction_to_half2(paths[p])(count, srcStride, sizeof(uint32_t), 0, pSrc, pDst);
+		const double directionSeconds = getTestSeconds(&timer, true);
+
+		char name[64];
+		snprintf(name, sizeof(name), "float2 to half2, %s", pathNames[paths[p]]);
+		reportBenchmarkResult(name, count / halfSeconds, "vertices/s");
+		snprintf(name, sizeof(name), "direction to oct unorm2x16, %s", pathNames[paths[p]]);
+		reportBenchmarkResult(name, count / directionSeconds, "vertices/s");
+	}
+
+	tf_free(pSrc);
+	tf_free(pDst);
+}
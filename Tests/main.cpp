@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2017-2022 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+*/
+
+// Runs the engine tests and benchmarks without a window.
+// Usage: Tests [--bench] [--filter <substring>]
+
+#include "../OS/Interfaces/IApp.h"
+#include "../OS/Interfaces/ILog.h"
+#include "../OS/Interfaces/IFileSystem.h"
+#include "../OS/Interfaces/IThread.h"
+
+#include "TestFramework.h"
+
+#include "../OS/Interfaces/IMemory.h"
+
+int          IApp::argc;
+const char** IApp::argv;
+
+static TestCase* pTestCases = NULL;
+static uint32_t  gCaseFailures = 0;
+
+void registerTestCase(TestCase* pTestCase)
+{
+	// Keep registration order (per translation unit) so the output is stable
+	TestCase** ppLast = &pTestCases;
+	while (*ppLast)
+		ppLast = &(*ppLast)->pNext;
+	*ppLast = pTestCase;
+}
+
+void reportTestFailure(const char* pFile, int line, const char* pExpression)
+{
+	++gCaseFailures;
+	LOGF(LogLevel::eERROR, "%s(%d): check failed: %s", pFile, line, pExpression);
+}
+
+void reportBenchmarkResult(const char* pName, double value, const char* pUnit)
+{
+	LOGF(LogLevel::eINFO, "  %-48s %14.2f %s", pName, value, pUnit);
+}
+
+int main(int argc, char** argv)
+{
+	IApp::argc = argc;
+	IApp::argv = (const char**)argv;
+
+	bool        runBenchmarks = false;
+	const char* pFilter = NULL;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--bench"))
+			runBenchmarks = true;
+		else if (!strcmp(argv[i], "--filter") && i + 1 < argc)
+			pFilter = argv[++i];
+	}
+
+	if (!initMemAlloc("Tests"))
+		return EXIT_FAILURE;
+
+	FileSystemInitDesc fsDesc = {};
+	fsDesc.pAppName = "Tests";
+	if (!initFileSystem(&fsDesc))
+		return EXIT_FAILURE;
+
+	fsSetPathForResourceDir(pSystemFileIO, RM_DEBUG, RD_LOG, "");
+	// Resource loader tests write the textures and meshes they load
+	fsSetPathForResourceDir(pSystemFileIO, RM_DEBUG, RD_TEXTURES, "TestTextures");
+	fsSetPathForResourceDir(pSystemFileIO, RM_DEBUG, RD_MESHES, "TestMeshes");
+	initLog("Tests", DEFAULT_LOG_LEVEL);
+	setMainThread();
+
+	uint32_t numRun = 0;
+	uint32_t numFailed = 0;
+	for (TestCase* pCase = pTestCases; pCase; pCase = pCase->pNext)
+	{
+		if ((pCase->mBenchmark && !runBenchmarks) || (pFilter && !strstr(pCase->pName, pFilter)))
+			continue;
+
+		LOGF(LogLevel::eINFO, "[ RUN  ] %s", pCase->pName);
+		gCaseFailures = 0;
+		pCase->pFunc();
+		++numRun;
+		if (gCaseFailures)
+		{
+			++numFailed;
+			LOGF(LogLevel::eERROR, "[ FAIL ] %s (%u failed checks)", pCase->pName, gCaseFailures);
+		}
+		else
+		{
+			LOGF(LogLevel::eINFO, "[  OK  ] %s", pCase->pName);
+		}
+	}
+
+	LOGF(numFailed ? LogLevel::eERROR : LogLevel::eINFO, "%u of %u cases passed", numRun - numFailed, numRun);
+
+	exitLog();
+	exitFileSystem();
+	exitMemAlloc();
+
+	return (int)numFailed;
+}
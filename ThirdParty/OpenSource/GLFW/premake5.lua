@@ -87,6 +87,10 @@ project "GLFW"
 		runtime "Release"
 		optimize "on"
 
+	filter "configurations:Null"
+		runtime "Release"
+		optimize "on"
+
 	filter "configurations:Dist"
 		runtime "Release"
 		optimize "on"
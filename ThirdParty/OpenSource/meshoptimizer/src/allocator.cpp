@@ -3,17 +3,24 @@
 #include "../../../../OS/Interfaces/ILog.h"
 
 #include "../../../../ThirdParty/OpenSource/ModifiedSonyMath/vectormath_settings.hpp"
+#include "../../../../OS/Interfaces/IMemory.h"
 #define MEM_MAX(a, b) ((a) > (b) ? (a) : (b))
 #define MIN_ALLOC_ALIGNMENT MEM_MAX(VECTORMATH_MIN_ALIGN, EA_PLATFORM_MIN_MALLOC_ALIGNMENT)
 
-size_t buffer_length = 0;
-size_t current_offset = 0;
-char* buffer; //Scratch-Pad memory
+// Scratch-Pad memory is per thread so geometry can be optimized on several threads at once
+static thread_local size_t buffer_length = 0;
+static thread_local size_t current_offset = 0;
+static thread_local char* buffer = NULL;
+
+static bool IsScratchMemory(const void* b)
+{
+	return buffer && (const char*)b >= buffer && (const char*)b < buffer + buffer_length;
+}
 
 void* Allocate(size_t size)
 {
 	// make the current offset always aligned
-	current_offset += current_offset % MIN_ALLOC_ALIGNMENT;
+	current_offset = (current_offset + MIN_ALLOC_ALIGNMENT - 1) & ~(size_t)(MIN_ALLOC_ALIGNMENT - 1);
 
 	if (current_offset + size <= buffer_length)
 	{
@@ -22,21 +29,28 @@ void* Allocate(size_t size)
 		return ptr;
 	}
 
-	LOGF(LogLevel::eWARNING, "Mesh Optimizer out of memory");
-	return NULL;
+	// meshoptimizer never checks for NULL, blocks past the scratch memory come from the heap
+	LOGF(LogLevel::eDEBUG, "Mesh Optimizer scratch memory exhausted, allocating %zu bytes from the heap", size);
+	return tf_memalign(MIN_ALLOC_ALIGNMENT, size);
 }
 
 void DeAllocate(void* b)
 {
-	current_offset = 0;
+	if (!IsScratchMemory(b))
+	{
+		tf_free(b);
+		return;
+	}
+
+	// Blocks are released in reverse allocation order
+	current_offset = (size_t)((char*)b - buffer);
 }
 
 void meshopt_SetScratchMemory(size_t size, void* memory)
 {
 	buffer_length = size;
+	current_offset = 0;
 	buffer = (char*)memory;
-
-	meshopt_setAllocator();
 }
 
 //void meshopt_setAllocator(void* (*allocate)(size_t), void (*deallocate)(void*))
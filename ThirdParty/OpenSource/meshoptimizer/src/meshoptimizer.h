@@ -517,6 +517,10 @@ MESHOPTIMIZER_EXPERIMENTAL void meshopt_spatialSortTriangles(unsigned int* desti
 //MESHOPTIMIZER_API void meshopt_setAllocator(void* (*allocate)(size_t), void (*deallocate)(void*));
 MESHOPTIMIZER_API void meshopt_setAllocator();
 
+/**
+ * Sets the scratch memory of the calling thread, used by the allocator installed with meshopt_setAllocator
+ * Allocations that don't fit fall back to the heap. Pass NULL before freeing the memory
+ */
 MESHOPTIMIZER_API void meshopt_SetScratchMemory(size_t size, void* memory);
 
 #ifdef __cplusplus
@@ -712,6 +712,8 @@ public:
 		depthStateDesc.mDepthWrite = true;
 		depthStateDesc.mDepthFunc = CMP_GEQUAL;
 
+		SyncToken pipelineToken = {};
+
 		PipelineDesc desc = {};
 		desc.mType = PIPELINE_TYPE_GRAPHICS;
 		GraphicsPipelineDesc& pipelineSettings = desc.mGraphicsDesc;
@@ -727,12 +729,12 @@ public:
 		pipelineSettings.pVertexLayout = &vertexLayout;
 		pipelineSettings.pRasterizerState = &sphereRasterizerStateDesc;
 		pipelineSettings.mVRFoveatedRendering = true;
-		vk_addPipeline(pRenderer, &desc, &pSpherePipeline);
+		addPipeline(pRenderer, &desc, &pSpherePipeline, &pipelineToken);
 
 		if (pRenderer->pActiveGpuSettings->mGpuBreadcrumbs)
 		{
 			pipelineSettings.pShaderProgram = pCrashShader;
-			vk_addPipeline(pRenderer, &desc, &pCrashPipeline);
+			addPipeline(pRenderer, &desc, &pCrashPipeline, &pipelineToken);
 		}
 
 		//layout and pipeline for skybox draw
@@ -747,7 +749,10 @@ public:
 		pipelineSettings.pDepthState = NULL;
 		pipelineSettings.pRasterizerState = &rasterizerStateDesc;
 		pipelineSettings.pShaderProgram = pSkyBoxDrawShader; //-V519
-		vk_addPipeline(pRenderer, &desc, &pSkyBoxDrawPipeline);
+		addPipeline(pRenderer, &desc, &pSkyBoxDrawPipeline, &pipelineToken);
+
+		// Pipelines compile on the loader threads
+		waitForToken(&pipelineToken);
 
 		return true;
 	};
@@ -5,7 +5,8 @@ workspace "TheForge"
 	configurations
 	{
 		"Debug",
-		"Release"
+		"Release",
+		"Null"
 	}
 
 outputdir="%{cfg.buildcfg}-%{cfg.system}-%{cfg.architecture}"
@@ -79,6 +80,11 @@ project "Renderer"
 			runtime "Release"
 			optimize "on"
 
+		filter "configurations:Null"
+			defines { "NULL_RENDERER" }
+			runtime "Release"
+			optimize "on"
+
 project "OS"
 	location "OS"
 	kind "StaticLib"
@@ -187,6 +193,11 @@ project "OS"
 		runtime "Release"
 		optimize "on"
 
+	filter "configurations:Null"
+		defines { "NULL_RENDERER" }
+		runtime "Release"
+		optimize "on"
+
 
 
 group "Tools"
@@ -241,6 +252,11 @@ project "SpirvTools"
 			runtime "Release"
 			optimize "on"
 
+		filter "configurations:Null"
+			defines { "NULL_RENDERER" }
+			runtime "Release"
+			optimize "on"
+
 project "gainputstatic"
 		location "gainputstatic"
 		kind "StaticLib"
@@ -389,6 +405,11 @@ project "gainputstatic"
 			runtime "Release"
 			optimize "on"			
 
+		filter "configurations:Null"
+			defines { "NULL_RENDERER" }
+			runtime "Release"
+			optimize "on"
+
 group	"Examples"
 		project "Sandbox"
 
@@ -450,6 +471,11 @@ group	"Examples"
 			runtime "Release"
 			optimize "on"
 
+		filter "configurations:Null"
+			defines { "NULL_RENDERER" }
+			runtime "Release"
+			optimize "on"
+
 
 project "TriangleDemo"
 
@@ -512,3 +538,74 @@ project "TriangleDemo"
 		defines ""
 		runtime "Release"
 		optimize "on"
+
+	filter "configurations:Null"
+		defines { "NULL_RENDERER" }
+		runtime "Release"
+		optimize "on"
+
+group "Tests"
+project "Tests"
+
+	location "Tests"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+	staticruntime "on"
+	targetdir("bin/" ..outputdir.. "/%{prj.name}")
+	objdir("bin-int/" ..outputdir.. "/%{prj.name}")
+
+	files
+	{
+		"%{prj.name}/**.h",
+		"%{prj.name}/**.cpp",
+		"%{prj.name}/**.c",
+
+	}
+	
+	defines
+	{
+		"_CRT_SECURE_NO_WARNINGS",
+		"_WINDOWS"
+	}
+
+	includedirs
+	{
+		"%{prj.name}",
+		"OS",
+		"Renderer",
+		"SpirvTools",
+		"gainputstatic",
+		"$(VULKAN_SDK)/Include"
+	}
+
+	libdirs 
+	{ 
+		"%VULKAN_SDK%/lib" 
+	}
+
+	links
+	{
+		"OS",
+		"Renderer",
+		"SpirvTools",
+		"gainputstatic"
+	}
+
+	filter "system:windows"
+		systemversion "latest"
+		
+	filter "configurations:Debug"
+		defines ""
+		runtime "Debug"
+		symbols "on"
+
+	filter "configurations:Release"
+		defines ""
+		runtime "Release"
+		optimize "on"
+
+	filter "configurations:Null"
+		defines { "NULL_RENDERER" }
+		runtime "Release"
+		optimize "on"